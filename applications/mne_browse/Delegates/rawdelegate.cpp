@@ -121,6 +121,56 @@ void RawDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, c
             painter->setBrushOrigin(oldBO);
         }
 
+        const RawModel* t_rawModel = (static_cast<const RawModel*>(index.model()));
+
+        //Zoomed out views are drawn from the overview pyramid of the whole file
+        int iOverviewLevel = t_rawModel->overviewLevel();
+        if(iOverviewLevel >= 0) {
+            double channelMean = 0;
+            if(m_bRemoveDC)
+                channelMean = t_rawModel->overview()->channelMean(index.row());
+
+            //Only the part which is visible in the viewport is drawn
+            QRect visibleRect = option.rect.intersected(m_pRawView->viewport()->rect());
+
+            QPainterPath path(QPointF(visibleRect.x(),option.rect.y()));
+
+            //Plot grid
+            painter->setRenderHint(QPainter::Antialiasing, false);
+            createGridPath(path,option,visibleRect.width());
+
+            painter->save();
+            QPen pen;
+            pen.setStyle(Qt::DotLine);
+            pen.setWidthF(0.5);
+            painter->setPen(pen);
+            painter->drawPath(path);
+            painter->restore();
+
+            //Plot envelope path
+            path = QPainterPath(QPointF(visibleRect.x(), option.rect.y()));
+            createOverviewPath(index, option, visibleRect, iOverviewLevel, path, channelMean);
+
+            if(option.state & QStyle::State_Selected) {
+                pen.setStyle(Qt::SolidLine);
+                pen.setWidthF(1);
+                pen.setColor(Qt::red);
+                painter->setPen(pen);
+            }
+
+            painter->translate(0,t_fPlotHeight/2);
+            painter->drawPath(path);
+            painter->restore();
+
+            //Plot events
+            painter->save();
+            if(m_pEventModel->rowCount()!=0 && m_bActivateEvents)
+                plotEvents(index, option, painter);
+            painter->restore();
+
+            break;
+        }
+
         //Get data and mean
         QVariant variant = index.model()->data(index,Qt::DisplayRole);
         QList<RowVectorPair> listPairs = variant.value<QList<RowVectorPair> >();
@@ -132,13 +182,11 @@ void RawDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, c
             channelMean = channelMeanVariant.toDouble();
         }
 
-        const RawModel* t_rawModel = (static_cast<const RawModel*>(index.model()));
-
-        QPainterPath path(QPointF(option.rect.x()+t_rawModel->relFiffCursor()-1,option.rect.y()));
+        QPainterPath path(QPointF(option.rect.x()+t_rawModel->relFiffCursor()*m_dDx-1,option.rect.y()));
 
         //Plot grid
         painter->setRenderHint(QPainter::Antialiasing, false);
-        createGridPath(path,option,listPairs);
+        createGridPath(path,option,listPairs[0].second*listPairs.size()*m_dDx);
 
         painter->save();
         QPen pen;
@@ -149,7 +197,7 @@ void RawDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, c
         painter->restore();
 
         //Plot data path
-        path = QPainterPath(QPointF(option.rect.x()+t_rawModel->relFiffCursor(), option.rect.y()));
+        path = QPainterPath(QPointF(option.rect.x()+t_rawModel->relFiffCursor()*m_dDx, option.rect.y()));
         createPlotPath(index, option, path, listPairs, channelMean);
 
         if(option.state & QStyle::State_Selected) {
@@ -221,6 +269,90 @@ void RawDelegate::setScaleMap(const QMap<QString,double> &scaleMap)
 //*************************************************************************************************************
 
 void RawDelegate::createPlotPath(const QModelIndex &index, const QStyleOptionViewItem &option, QPainterPath& path, QList<RowVectorPair>& listPairs, double channelMean) const
+{
+    double dValue;
+    double dScaleY = option.rect.height()/(2*getMaxValue(index));
+
+    double y_base = -path.currentPosition().y();
+    QPointF qSamplePosition;
+
+    path.moveTo(path.currentPosition().x(), -(y_base + ((*(listPairs[0].first) - channelMean)*dScaleY)));
+
+    //plot all rows from list of pairs
+    for(qint8 i=0; i < listPairs.size(); ++i) {
+        //create lines from one to the next sample
+        for(qint32 j=0; j < listPairs[i].second; ++j)
+        {
+            double val = *(listPairs[i].first+j);
+
+            //subtract mean of the channel here (if wanted by the user)
+            dValue = (val - channelMean)*dScaleY;
+
+            double newY = y_base+dValue;
+
+            qSamplePosition.setY(-newY);
+            qSamplePosition.setX(path.currentPosition().x()+m_dDx);
+
+            path.lineTo(qSamplePosition);
+        }
+    }
+
+//    qDebug("Plot-PainterPath created!");
+}
+
+
+//*************************************************************************************************************
+
+void RawDelegate::createOverviewPath(const QModelIndex &index, const QStyleOptionViewItem &option, const QRect &visibleRect, int iLevel, QPainterPath& path, double channelMean) const
+{
+    RawOverviewPyramid::ConstSPtr pOverview = (static_cast<const RawModel*>(index.model()))->overview();
+    const RawOverviewPyramid::Level& level = pOverview->level(iLevel);
+
+    const qint32 nBins = level.matMin.cols();
+    const float* pMin = level.matMin.data() + index.row()*nBins;
+    const float* pMax = level.matMax.data() + index.row()*nBins;
+
+    double dScaleY = option.rect.height()/(2*getMaxValue(index));
+    double y_base = -path.currentPosition().y();
+    bool bFirst = true;
+
+    //draw one vertical min/max line per pixel, the chosen level has at least one bin per pixel
+    for(int x = visibleRect.left(); x <= visibleRect.right(); ++x) {
+        qint32 firstBin = qint32(floor((x - option.rect.x())/m_dDx/level.iDecimation));
+        qint32 lastBin = qint32(ceil((x + 1 - option.rect.x())/m_dDx/level.iDecimation)) - 1;
+
+        if(firstBin >= nBins)
+            break;
+
+        firstBin = qMax(firstBin, 0);
+        lastBin = qBound(firstBin, lastBin, nBins-1);
+
+        float fMin = pMin[firstBin];
+        float fMax = pMax[firstBin];
+        for(qint32 j = firstBin+1; j <= lastBin; ++j) {
+            fMin = qMin(fMin, pMin[j]);
+            fMax = qMax(fMax, pMax[j]);
+        }
+
+        QPointF qMaxPosition(x, -(y_base + (fMax - channelMean)*dScaleY));
+        QPointF qMinPosition(x, -(y_base + (fMin - channelMean)*dScaleY));
+
+        if(bFirst) {
+            path.moveTo(qMaxPosition);
+            bFirst = false;
+        }
+        else {
+            path.lineTo(qMaxPosition);
+        }
+
+        path.lineTo(qMinPosition);
+    }
+}
+
+
+//*************************************************************************************************************
+
+double RawDelegate::getMaxValue(const QModelIndex &index) const
 {
     //get maximum range of respective channel type (range value in FiffChInfo does not seem to contain a reasonable value)
     qint32 kind = (static_cast<const RawModel*>(index.model()))->m_chInfolist[index.row()].kind;
@@ -258,46 +390,19 @@ void RawDelegate::createPlotPath(const QModelIndex &index, const QStyleOptionVie
     }
     }
 
-    double dValue;
-    double dScaleY = option.rect.height()/(2*dMaxValue);
-
-    double y_base = -path.currentPosition().y();
-    QPointF qSamplePosition;
-
-    path.moveTo(path.currentPosition().x(), -(y_base + ((*(listPairs[0].first) - channelMean)*dScaleY)));
-
-    //plot all rows from list of pairs
-    for(qint8 i=0; i < listPairs.size(); ++i) {
-        //create lines from one to the next sample
-        for(qint32 j=0; j < listPairs[i].second; ++j)
-        {
-            double val = *(listPairs[i].first+j);
-
-            //subtract mean of the channel here (if wanted by the user)
-            dValue = (val - channelMean)*dScaleY;
-
-            double newY = y_base+dValue;
-
-            qSamplePosition.setY(-newY);
-            qSamplePosition.setX(path.currentPosition().x()+m_dDx);
-
-            path.lineTo(qSamplePosition);
-        }
-    }
-
-//    qDebug("Plot-PainterPath created!");
+    return dMaxValue;
 }
 
 
 //*************************************************************************************************************
 
-void RawDelegate::createGridPath(QPainterPath& path, const QStyleOptionViewItem &option, QList<RowVectorPair>& listPairs) const
+void RawDelegate::createGridPath(QPainterPath& path, const QStyleOptionViewItem &option, double width) const
 {
     //horizontal lines
     double distance = double(option.rect.height()) / m_nhlines;
 
     QPointF startpos = path.currentPosition();
-    QPointF endpoint(path.currentPosition().x()+listPairs[0].second*listPairs.size()*m_dDx,path.currentPosition().y());
+    QPointF endpoint(path.currentPosition().x()+width,path.currentPosition().y());
 
     for(qint8 i=0; i < m_nhlines-1; ++i) {
         endpoint.setY(endpoint.y()+distance);
@@ -318,6 +423,12 @@ void RawDelegate::plotEvents(const QModelIndex &index, const QStyleOptionViewIte
     qint32 sampleRangeLow = rawModel->relFiffCursor();
     qint32 sampleRangeHigh = sampleRangeLow + rawModel->sizeOfPreloadedData();
 
+    //Zoomed out views show the whole file
+    if(rawModel->overviewLevel() >= 0) {
+        sampleRangeLow = 0;
+        sampleRangeHigh = rawModel->lastSample() - rawModel->firstSample();
+    }
+
     QPen pen;
     pen.setWidth(EVENT_MARKER_WIDTH);
 
@@ -340,7 +451,7 @@ void RawDelegate::plotEvents(const QModelIndex &index, const QStyleOptionViewIte
                 painter->setPen(pen);
 
                 //Draw line from sample position (x) and highest to lowest y position of the column widget - Add -m_qSettings.value("EventDesignParameters/event_marker_width").toInt() to avoid painting ovre the edge of the column widget
-                painter->drawLine(option.rect.x() + sampleValue, option.rect.y(), option.rect.x() + sampleValue, option.rect.y() + option.rect.height() - EVENT_MARKER_WIDTH);
+                painter->drawLine(option.rect.x() + sampleValue*m_dDx, option.rect.y(), option.rect.x() + sampleValue*m_dDx, option.rect.y() + option.rect.height() - EVENT_MARKER_WIDTH);
             } // END for statement
         } // END if statement event in data range
     } // END if statement plot all
@@ -365,7 +476,7 @@ void RawDelegate::plotEvents(const QModelIndex &index, const QStyleOptionViewIte
                 painter->setPen(pen);
 
                 //Draw line from sample position (x) and highest to lowest y position of the column widget - Add +m_qSettings.value("EventDesignParameters/event_marker_width").toInt() to avoid painting ovre the edge of the column widget
-                painter->drawLine(option.rect.x() + sampleValue, option.rect.y(), option.rect.x() + sampleValue, option.rect.y() - option.rect.height() + EVENT_MARKER_WIDTH);
+                painter->drawLine(option.rect.x() + sampleValue*m_dDx, option.rect.y(), option.rect.x() + sampleValue*m_dDx, option.rect.y() - option.rect.height() + EVENT_MARKER_WIDTH);
             } // END for statement
         } // END if statement
     } // END else statement
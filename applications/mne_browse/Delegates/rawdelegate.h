@@ -175,14 +175,38 @@ private:
     */
     void createPlotPath(const QModelIndex &index, const QStyleOptionViewItem &option, QPainterPath& path, QList<RowVectorPair>& listPairs, double channelMean) const;
 
+    //=========================================================================================================
+    /**
+    * createOverviewPath creates the QPointer path for the min/max envelope of a zoomed out data plot.
+    *
+    * @param[in] index QModelIndex for accessing associated data and model object.
+    * @param[in] option the style options of the current table item.
+    * @param[in] visibleRect the part of the table item which is visible in the viewport.
+    * @param[in] iLevel the overview pyramid level to draw.
+    * @param[in,out] path The QPointerPath to create for the envelope plot.
+    * @param[in] channelMean the mean which is subtracted from the data.
+    */
+    void createOverviewPath(const QModelIndex &index, const QStyleOptionViewItem &option, const QRect &visibleRect, int iLevel, QPainterPath& path, double channelMean) const;
+
+    //=========================================================================================================
+    /**
+    * getMaxValue returns the plot range of the channel type of the given index.
+    *
+    * @param[in] index QModelIndex for accessing associated data and model object.
+    *
+    * @return the maximum value which is plotted within the row height.
+    */
+    double getMaxValue(const QModelIndex &index) const;
+
     //=========================================================================================================
     /**
     * createGridPath Creates the QPointer path for the grid plot.
     *
-    * @param[in,out] path The row vector of the data matrix <1 x nsamples>.
-    * @param[in] data The row vector of the data matrix <1 x nsamples>.
+    * @param[in,out] path The QPointerPath to create for the grid plot.
+    * @param[in] option the style options of the current table item.
+    * @param[in] width the width of the grid in pixels.
     */
-    void createGridPath(QPainterPath& path, const QStyleOptionViewItem &option, QList<RowVectorPair>& listPairs) const;
+    void createGridPath(QPainterPath& path, const QStyleOptionViewItem &option, double width) const;
 
     //=========================================================================================================
     /**
@@ -135,6 +135,14 @@ public:
     */
     bool loadEventData(QFile& qFile);
 
+    //=========================================================================================================
+    /**
+    * setEventData replaces the model's events with an event list
+    *
+    * @param events event list in the MNE format, one row per event: sample, value before, value after
+    */
+    void setEventData(const MatrixXi& events);
+
     //=========================================================================================================
     /**
     * saveEventData saves events to a fiff event data file
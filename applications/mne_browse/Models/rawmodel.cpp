@@ -72,6 +72,7 @@ RawModel::RawModel(QObject *parent)
 , m_bFileloaded(false)
 , m_bStartReached(false)
 , m_bEndReached(false)
+, m_iReloadStart(0)
 , m_bReloading(false)
 , m_bProcessing(false)
 , m_pFiffInfo(new FiffInfo())
@@ -80,6 +81,8 @@ RawModel::RawModel(QObject *parent)
 , m_bReloadBefore(0)
 , m_iAbsFiffCursor(0)
 , m_iCurAbsScrollPos(0)
+, m_iOverviewAbort(0)
+, m_dSamplesPerPixel(1.0)
 {
     m_iWindowSize = MODEL_WINDOW_SIZE;
     m_reloadPos = MODEL_RELOAD_POS;
@@ -89,19 +92,17 @@ RawModel::RawModel(QObject *parent)
     //Set default sampling freq to 1024
     m_pFiffInfo->sfreq = 1024;
 
+    //create the data cache - windows are loaded on its own I/O thread
+    m_pDataCache = RawDataCache::SPtr(new RawDataCache([this](fiff_int_t from, fiff_int_t to, const QMap<int,QSharedPointer<MNEOperator> >& assignedOperators) {
+        return loadWindow(from, to, assignedOperators);
+    }));
+
     // Generate default filter operator - This needs to be done here so that the filter design tool works without loading a file
     genStdFilterOps();
 
-    //connect data reloading - this is done concurrently
-    connect(&m_reloadFutureWatcher,&QFutureWatcher<QPair<MatrixXd,MatrixXd> >::finished,[this](){
-        insertReloadedData(m_reloadFutureWatcher.future().result());
-    });
-
-    //connect filtering reloading - this is done after a new block has been loaded
-    connect(this,&RawModel::dataReloaded,[this](){
-        if(!m_assignedOperators.empty())
-            updateOperatorsConcurrently();
-    });
+    //connect data reloading - windows are loaded and filtered concurrently by the data cache
+    connect(m_pDataCache.data(),&RawDataCache::windowLoaded,
+            this,&RawModel::onWindowLoaded,Qt::QueuedConnection);
 
 //    connect(&m_operatorFutureWatcher,&QFutureWatcher<QPair<int,RowVectorXd> >::resultReadyAt,[this](int index){
 //        insertProcessedData(index);
@@ -109,6 +110,13 @@ RawModel::RawModel(QObject *parent)
     connect(&m_operatorFutureWatcher,&QFutureWatcher<void>::finished,[this](){
         insertProcessedDataAll();
     });
+
+    //connect overview computation - this is done concurrently
+    connect(&m_overviewFutureWatcher,&QFutureWatcher<RawOverviewPyramid::SPtr>::finished,[this](){
+        m_pOverview = m_overviewFutureWatcher.future().result();
+        emit overviewLoaded();
+        emit dataChanged(createIndex(0,1),createIndex(m_chInfolist.size()-1,1));
+    });
 //    connect(&m_operatorFutureWatcher,&QFutureWatcher<QPair<int,RowVectorXd> >::progressValueChanged,[this](int progressValue){
 //        qDebug() << "RawModel: ProgressValue m_operatorFutureWatcher, " << progressValue << " items processed out of" << m_listTmpChData.size();
 //    });
@@ -122,17 +130,25 @@ RawModel::RawModel(QFile &qFile, QObject *parent)
 , m_bFileloaded(false)
 , m_bStartReached(false)
 , m_bEndReached(false)
+, m_iReloadStart(0)
 , m_bReloading(false)
 , m_bProcessing(false)
 , m_pFiffInfo(new FiffInfo())
 , m_pfiffIO(QSharedPointer<FiffIO>(new FiffIO()))
 , m_filterChType("All")
+, m_iOverviewAbort(0)
+, m_dSamplesPerPixel(1.0)
 {
     m_iWindowSize = MODEL_WINDOW_SIZE;
     m_reloadPos = MODEL_RELOAD_POS;
     m_maxWindows = MODEL_MAX_WINDOWS;
     m_iFilterTaps = MODEL_NUM_FILTER_TAPS;
 
+    //create the data cache - windows are loaded on its own I/O thread
+    m_pDataCache = RawDataCache::SPtr(new RawDataCache([this](fiff_int_t from, fiff_int_t to, const QMap<int,QSharedPointer<MNEOperator> >& assignedOperators) {
+        return loadWindow(from, to, assignedOperators);
+    }));
+
     //read fiff data
     loadFiffData(&qFile);
 
@@ -140,14 +156,8 @@ RawModel::RawModel(QFile &qFile, QObject *parent)
     genStdFilterOps();
 
     //connect signal and slots
-    connect(&m_reloadFutureWatcher,&QFutureWatcher<QPair<MatrixXd,MatrixXd> >::finished,[this](){
-        insertReloadedData(m_reloadFutureWatcher.future().result());
-    });
-
-    connect(this,&RawModel::dataReloaded,[this](){
-        if(!m_assignedOperators.empty())
-            updateOperatorsConcurrently();
-    });
+    connect(m_pDataCache.data(),&RawDataCache::windowLoaded,
+            this,&RawModel::onWindowLoaded,Qt::QueuedConnection);
 
 //    connect(&m_operatorFutureWatcher,&QFutureWatcher<QPair<int,RowVectorXd> >::resultReadyAt,[this](int index){
 //        insertProcessedData(index);
@@ -155,12 +165,30 @@ RawModel::RawModel(QFile &qFile, QObject *parent)
     connect(&m_operatorFutureWatcher,&QFutureWatcher<void>::finished,[this](){
         insertProcessedDataAll();
     });
+
+    //connect overview computation - this is done concurrently
+    connect(&m_overviewFutureWatcher,&QFutureWatcher<RawOverviewPyramid::SPtr>::finished,[this](){
+        m_pOverview = m_overviewFutureWatcher.future().result();
+        emit overviewLoaded();
+        emit dataChanged(createIndex(0,1),createIndex(m_chInfolist.size()-1,1));
+    });
 //    connect(&m_operatorFutureWatcher,&QFutureWatcher<QPair<int,RowVectorXd> >::progressValueChanged,[this](int progressValue){
 //        qDebug() << "RawModel: ProgressValue m_operatorFutureWatcher, " << progressValue << " items processed out of" << m_listTmpChData.size();
 //    });
 }
 
 
+//*************************************************************************************************************
+
+RawModel::~RawModel()
+{
+    stopOverviewComputation();
+
+    //wait for the I/O thread before the members used by the loader are destroyed
+    m_pDataCache->clear();
+}
+
+
 //*************************************************************************************************************
 //virtual functions
 int RawModel::rowCount(const QModelIndex & /*parent*/) const
@@ -406,10 +434,14 @@ bool RawModel::loadFiffData(QFile* qFile)
 
     //set loaded fiff data
     m_data.append(newDataPackage);
+    m_pDataCache->insert(m_iAbsFiffCursor, m_assignedOperators, newDataPackage);
 
     loadFiffInfos();
     genStdFilterOps();
 
+    //compute the overview pyramid of the whole file in the background
+    startOverviewComputation(qFile->fileName());
+
     endResetModel();
 
     qFile->close();
@@ -417,6 +449,8 @@ bool RawModel::loadFiffData(QFile* qFile)
     emit fileLoaded(m_pFiffInfo);
     emit assignedOperatorsChanged(m_assignedOperators);
 
+    prefetchWindows();
+
     return true;
 }
 
@@ -478,6 +512,14 @@ bool RawModel::writeFiffData(QIODevice *p_IODevice)
 }
 
 
+//*************************************************************************************************************
+
+void RawModel::setSamplesPerPixel(double dSamplesPerPixel)
+{
+    m_dSamplesPerPixel = qMax(1.0, dSamplesPerPixel);
+}
+
+
 //*************************************************************************************************************
 //non-virtual functions
 //private
@@ -496,6 +538,14 @@ void RawModel::loadFiffInfos()
 
 void RawModel::clearModel()
 {
+    //Overview pyramid
+    stopOverviewComputation();
+
+    //Data cache - this waits for a running load, which still uses m_pfiffIO
+    m_pDataCache->clear();
+    m_pDataCache->resetStatistics();
+    m_bReloading = false;
+
     //FiffIO object
     m_pfiffIO.clear();
     m_chInfolist.clear();
@@ -536,34 +586,43 @@ void RawModel::resetPosition(qint32 position)
 
     m_iAbsFiffCursor = firstSample() + mult*m_iWindowSize;
 
-    MatrixXd t_data,t_times; //type is later on (when append to m_data) casted into MatrixXdR (Row-Major)
+    //pending prefetches belong to the old position
+    m_pDataCache->cancelPending();
 
     int start = m_iAbsFiffCursor;
-    int end = start + m_iWindowSize - 1;
+    int end = windowEnd(start);
 
-    m_Mutex.lock();
-    if(!m_pfiffIO->m_qlistRaw[0]->read_raw_segment(t_data, t_times, start, end))
-        qDebug() << "RawModel: Error resetting position of Fiff file!";
-    m_Mutex.unlock();
+    //take the (filtered) window from the cache or load it directly, since the view needs it immediately
+    QSharedPointer<DataPackage> newDataPackage = m_pDataCache->lookup(start, m_assignedOperators);
+    if(!newDataPackage) {
+        newDataPackage = loadWindow(start, end, m_assignedOperators);
 
-    //build data package
-    QSharedPointer<DataPackage> newDataPackage;
-    newDataPackage = QSharedPointer<DataPackage>(new DataPackage((MatrixXdR)t_data, (MatrixXdR)t_times));
+        if(newDataPackage) {
+            m_pDataCache->insert(start, m_assignedOperators, newDataPackage);
+        }
+        else {
+            qDebug() << "RawModel: Error resetting position of Fiff file!";
+            newDataPackage = QSharedPointer<DataPackage>(new DataPackage());
+        }
+    }
 
     //append loaded block
     m_data.append(newDataPackage);
 
-    if(!m_assignedOperators.empty())
-        updateOperators();
-
     endResetModel();
 
 //    if(!(m_iAbsFiffCursor<=firstSample()))
 //        updateScrollPos(m_iCurAbsScrollPos-firstSample()); //little hack: if the m_iCurAbsScrollPos is now close to the edge -> force reloading w/o scrolling
 
-    qDebug() << "RawModel: Model Position RESET, samples from " << m_iAbsFiffCursor << "to" << m_iAbsFiffCursor+m_iWindowSize-1 << "reloaded. actual loaded t_data cols: " << t_data.cols();
+    qDebug() << "RawModel: Model Position RESET, samples from " << m_iAbsFiffCursor << "to" << m_iAbsFiffCursor+m_iWindowSize-1 << "reloaded. actual loaded t_data cols: " << newDataPackage->dataRaw().cols();
 
     emit dataChanged(createIndex(0,1),createIndex(m_chInfolist.size(),1));
+
+    //prefetch the neighbouring windows in both directions, since the scrolling direction is not known yet
+    if(start - m_iWindowSize >= firstSample())
+        m_pDataCache->prefetch(start - m_iWindowSize, windowEnd(start - m_iWindowSize), m_assignedOperators);
+    if(start + m_iWindowSize <= lastSample())
+        m_pDataCache->prefetch(start + m_iWindowSize, windowEnd(start + m_iWindowSize), m_assignedOperators);
 }
 
 
@@ -608,15 +667,18 @@ void RawModel::reloadFiffData(bool before)
     }
 
     m_bReloading = true;
+    m_iReloadStart = start;
 
-    //read data with respect to start and end point
-    QFuture<QPair<MatrixXd,MatrixXd> > future = QtConcurrent::run(this,&RawModel::readSegment,start,end);
-
-    //Wait for thread reloading is finished, then insert reloaded data
-    //future.waitForFinished();
-    //insertReloadedData(future.result());
+    //take the (filtered) window from the cache if it was visited or prefetched before
+    QSharedPointer<DataPackage> pDataPackage = m_pDataCache->lookup(start, m_assignedOperators);
+    if(pDataPackage) {
+        insertReloadedData(pDataPackage);
+        return;
+    }
 
-    m_reloadFutureWatcher.setFuture(future);
+    //otherwise drop outdated prefetches and load the window before anything else - onWindowLoaded is called when done
+    m_pDataCache->cancelPending();
+    m_pDataCache->request(start, end, m_assignedOperators);
 }
 
 
@@ -626,24 +688,134 @@ QPair<MatrixXd,MatrixXd> RawModel::readSegment(fiff_int_t from, fiff_int_t to)
 {
     QPair<MatrixXd,MatrixXd> datatime;
 
-    m_Mutex.lock();
+    QMutexLocker locker(&m_Mutex);
     if(!m_pfiffIO->m_qlistRaw[0]->read_raw_segment(datatime.first, datatime.second, from, to)) {
         printf("RawModel: Error when reading raw data!");
-        return datatime;
+        return QPair<MatrixXd,MatrixXd>();
     }
-    m_Mutex.unlock();
 
     return datatime;
 }
 
 
+//*************************************************************************************************************
+
+QSharedPointer<DataPackage> RawModel::loadWindow(fiff_int_t from, fiff_int_t to, const QMap<int,QSharedPointer<MNEOperator> >& assignedOperators)
+{
+    QPair<MatrixXd,MatrixXd> datatime = readSegment(from, to);
+    if(datatime.first.cols() == 0)
+        return QSharedPointer<DataPackage>();
+
+    QSharedPointer<DataPackage> pDataPackage(new DataPackage((MatrixXdR)datatime.first, (MatrixXdR)datatime.second));
+
+    if(assignedOperators.empty())
+        return pDataPackage;
+
+    //filter the channels which have operators assigned
+    QList<int> listFilteredChs = assignedOperators.uniqueKeys();
+    QList<QPair<int,RowVectorXd> > listChData;
+
+    for(qint32 i=0; i < listFilteredChs.size(); ++i)
+        listChData.append(QPair<int,RowVectorXd>(listFilteredChs[i],pDataPackage->dataRawOrig().row(listFilteredChs[i])));
+
+    QtConcurrent::blockingMap(listChData,[this,&assignedOperators](QPair<int,RowVectorXd>& chdata) {
+        applyOperators(chdata, assignedOperators);
+    });
+
+    //Set and cut original data to window size and calculate mean for filtered data
+    int dataLength = pDataPackage->dataRaw().cols();
+    int cutFront = m_iCurrentFFTLength/4;
+    int cutBack = m_iCurrentFFTLength/4 + (listChData[0].second.cols()-m_iCurrentFFTLength/2-dataLength);
+
+    for(int i=0; i < listChData.size(); ++i)
+        pDataPackage->setOrigProcData(listChData[i].second, listChData[i].first, cutFront, cutBack);
+
+    return pDataPackage;
+}
+
+
+//*************************************************************************************************************
+
+fiff_int_t RawModel::windowEnd(fiff_int_t start)
+{
+    return qMin(start + m_iWindowSize - 1, lastSample());
+}
+
+
+//*************************************************************************************************************
+
+void RawModel::prefetchWindows()
+{
+    if(!m_bFileloaded || m_data.empty())
+        return;
+
+    for(int i = 0; i < MODEL_CACHE_PREFETCH_WINDOWS; ++i) {
+        fiff_int_t start;
+        if(m_bReloadBefore)
+            start = m_iAbsFiffCursor - (i+1)*m_iWindowSize;
+        else
+            start = m_iAbsFiffCursor + sizeOfPreloadedData() + i*m_iWindowSize;
+
+        if(start < firstSample() || start > lastSample())
+            break;
+
+        m_pDataCache->prefetch(start, windowEnd(start), m_assignedOperators);
+    }
+}
+
+
+//*************************************************************************************************************
+
+void RawModel::updateCachedWindows()
+{
+    for(int i = 0; i < m_data.size(); ++i)
+        m_pDataCache->insert(m_iAbsFiffCursor + i*m_iWindowSize, m_assignedOperators, m_data[i]);
+}
+
+
+//*************************************************************************************************************
+
+void RawModel::startOverviewComputation(const QString& sFileName)
+{
+    stopOverviewComputation();
+
+    if(sFileName.isEmpty())
+        return;
+
+    m_iOverviewAbort.store(0);
+
+    //the pyramid is read from its own file handle, hence it does not need to lock m_Mutex
+    QFuture<RawOverviewPyramid::SPtr> future = QtConcurrent::run(&RawOverviewPyramid::loadOrBuild,
+                                                                 sFileName,
+                                                                 int(MODEL_OVERVIEW_BASE_LEVEL),
+                                                                 static_cast<const QAtomicInt*>(&m_iOverviewAbort));
+
+    m_overviewFutureWatcher.setFuture(future);
+}
+
+
+//*************************************************************************************************************
+
+void RawModel::stopOverviewComputation()
+{
+    m_iOverviewAbort.store(1);
+    m_overviewFutureWatcher.waitForFinished();
+
+    m_pOverview.clear();
+}
+
+
 //*************************************************************************************************************
 //public SLOTS
 void RawModel::updateScrollPos(int value)
 {
-    m_iCurAbsScrollPos = firstSample() + value;
+    m_iCurAbsScrollPos = firstSample() + qRound(value*m_dSamplesPerPixel);
     qDebug() << "RawModel: absolute Fiff Scroll Cursor" << m_iCurAbsScrollPos << "(m_iAbsFiffCursor" << m_iAbsFiffCursor << ", sizeOfPreloadedData" << sizeOfPreloadedData() << ", firstSample()" << firstSample() << ")";
 
+    //zoomed out views are drawn from the overview pyramid - no full resolution data needs to be loaded
+    if(overviewLevel() >= 0)
+        return;
+
     //if a scroll position is selected, which is not within the loaded data range -> reset position of model
     if(m_iCurAbsScrollPos > (m_iAbsFiffCursor+sizeOfPreloadedData()+m_iWindowSize) || m_iCurAbsScrollPos < m_iAbsFiffCursor) {
         qDebug() << "RawModel: Reset position requested, m_iAbsFiffCursor:" << m_iAbsFiffCursor << "m_iCurAbsScrollPos:" << m_iCurAbsScrollPos;
@@ -721,6 +893,7 @@ void RawModel::applyOperator(QModelIndexList chlist, const QSharedPointer<MNEOpe
         updateOperatorsConcurrently(i);
 
     performOverlapAdd();
+    updateCachedWindows();
 
     m_bProcessing = false;
 
@@ -759,6 +932,7 @@ void RawModel::applyOperator(QModelIndexList chlist, const QSharedPointer<MNEOpe
         updateOperatorsConcurrently(i);
 
     performOverlapAdd();
+    updateCachedWindows();
 
     m_bProcessing = false;
 
@@ -772,11 +946,17 @@ void RawModel::applyOperator(QModelIndexList chlist, const QSharedPointer<MNEOpe
 
 void RawModel::applyOperatorsConcurrently(QPair<int,RowVectorXd>& chdata) const
 {
-    QSharedPointer<FilterOperator> filter;
+    applyOperators(chdata, m_assignedOperators);
+}
+
 
-    //QList<int> listFilteredChs = m_assignedOperators.keys();
+//*************************************************************************************************************
+
+void RawModel::applyOperators(QPair<int,RowVectorXd>& chdata, const QMap<int,QSharedPointer<MNEOperator> >& assignedOperators) const
+{
+    QSharedPointer<FilterOperator> filter;
 
-    QList<QSharedPointer<MNEOperator> > ops = m_assignedOperators.values(chdata.first);
+    QList<QSharedPointer<MNEOperator> > ops = assignedOperators.values(chdata.first);
     for(qint32 i=0; i < ops.size(); ++i) {
         switch(ops[i]->m_OperatorType) {
         case MNEOperator::FILTER: {
@@ -810,6 +990,7 @@ void RawModel::updateOperators(QModelIndex chan)
         updateOperatorsConcurrently(i);
 
     performOverlapAdd();
+    updateCachedWindows();
 
     m_bProcessing = false;
 
@@ -838,6 +1019,7 @@ void RawModel::updateOperators(QModelIndexList chlist)
         updateOperatorsConcurrently(i);
 
     performOverlapAdd();
+    updateCachedWindows();
 
     m_bProcessing = false;
 
@@ -969,9 +1151,11 @@ void RawModel::updateProjections()
 //            if(tripletList.size() > 0)
 //                matSparseProj.setFromTriplets(tripletList.begin(), tripletList.end());
 
-            //set projection matrix for upcoming read raw segement calls
+            //set projection matrix for upcoming read raw segement calls - cached windows were read with the old projector
+            m_pDataCache->clear();
             m_pfiffIO->m_qlistRaw[0]->proj = matProj;
         } else {
+            m_pDataCache->clear();
             m_pfiffIO->m_qlistRaw[0]->proj.resize(0,0);
         }
 
@@ -1005,7 +1189,8 @@ void RawModel::updateCompensator(int to)
 
         this->m_pFiffInfo->set_current_comp(to);
 
-        //set compensator for upcoming read raw segement calls
+        //set compensator for upcoming read raw segement calls - cached windows were read with the old compensator
+        m_pDataCache->clear();
         m_pfiffIO->m_qlistRaw[0]->comp = newComp;
 
         if(m_iCurAbsScrollPos == 0)
@@ -1018,10 +1203,33 @@ void RawModel::updateCompensator(int to)
 
 //*************************************************************************************************************
 //private SLOTS
-void RawModel::insertReloadedData(QPair<MatrixXd,MatrixXd> dataTimesPair)
+void RawModel::onWindowLoaded(int from, bool success)
 {
-    QSharedPointer<DataPackage> newDataPackage = QSharedPointer<DataPackage>(new DataPackage((MatrixXdR)dataTimesPair.first, (MatrixXdR)dataTimesPair.second));
+    //prefetched windows and outdated requests only fill the cache
+    if(!m_bReloading || from != m_iReloadStart)
+        return;
+
+    if(!success) {
+        m_bReloading = false;
+        qDebug() << "RawModel: Error when reloading fiff data starting at sample" << from;
+        return;
+    }
+
+    QSharedPointer<DataPackage> pDataPackage = m_pDataCache->find(from, m_assignedOperators);
+    if(!pDataPackage) {
+        //the operators changed while the window was loaded
+        m_pDataCache->request(from, windowEnd(from), m_assignedOperators);
+        return;
+    }
+
+    insertReloadedData(pDataPackage);
+}
+
+
+//*************************************************************************************************************
 
+void RawModel::insertReloadedData(QSharedPointer<DataPackage> newDataPackage)
+{
     //extend m_data with reloaded data
     if(m_bReloadBefore) {
         m_data.prepend(newDataPackage);
@@ -1043,10 +1251,17 @@ void RawModel::insertReloadedData(QPair<MatrixXd,MatrixXd> dataTimesPair)
 
     m_bReloading = false;
 
+    //the new window is already filtered, only the overlap with its neighbours needs to be added
+    if(!m_assignedOperators.empty())
+        performOverlapAdd();
+
     emit dataChanged(createIndex(0,1),createIndex(m_chInfolist.size()-1,1));
     emit dataReloaded();
 
-    qDebug() << "RawModel: Fiff data Reloaded from " << dataTimesPair.second.coeff(0) << "secs to" << dataTimesPair.second.coeff(dataTimesPair.second.cols()-1) << "secs";
+    prefetchWindows();
+
+    RawDataCache::Statistics statistics = m_pDataCache->statistics();
+    qDebug() << "RawModel: Fiff data Reloaded from sample" << m_iReloadStart << "- cache hits" << statistics.iHits << "misses" << statistics.iMisses << "mean load time" << statistics.dMeanLoadTimeMs << "ms";
 }
 
 
@@ -50,9 +50,11 @@
 *
 *           In order to not freeze the GUI when reloading new data or filtering data, the RawModel class makes heavy use
 *           of the QtConcurrent features. [2]
-*           Therefore, the methods updateOperatorsConcurrently() and readSegment() is run in a background-thread. Once the results
-*           are ready the m_operatorFutureWatcher and m_reloadFutureWatcher emits a signal that is connect to the slots
-*           insertProcessedData() and insertReloadedData(), respectively.
+*           Therefore, the method updateOperatorsConcurrently() is run in a background-thread. Once the results
+*           are ready the m_operatorFutureWatcher emits a signal that is connect to the slot insertProcessedData().
+*           Windows are read and filtered by loadWindow() on the I/O thread of m_pDataCache, which keeps an LRU list of
+*           filtered windows and prefetches the next windows in scrolling direction. Once a requested window is loaded
+*           the cache emits a signal that is connected to the slot onWindowLoaded().
 *
 *           MNEOperators such as FilterOperators are stored in m_Operators. The MNEOperators that are applied to any
 *           individual channel are stored in the QMap m_assignedOperators.
@@ -75,6 +77,8 @@
 #include "../Utils/filteroperator.h"
 #include "../Utils/rawsettings.h"
 #include "../Utils/datapackage.h"
+#include "../Utils/rawoverviewpyramid.h"
+#include "../Utils/rawdatacache.h"
 
 
 //*************************************************************************************************************
@@ -152,6 +156,12 @@ public:
     RawModel(QObject *parent);
     RawModel(QFile& qFile, QObject *parent);
 
+    //=========================================================================================================
+    /**
+    * Destroys the RawModel and stops a running overview computation.
+    */
+    ~RawModel();
+
     //=========================================================================================================
     /**
     * Reimplemented virtual functions
@@ -179,6 +189,15 @@ public:
     */
     bool writeFiffData(QIODevice *p_IODevice);
 
+    //=========================================================================================================
+    /**
+    * setSamplesPerPixel sets the current horizontal zoom of the connected view. If the zoom is coarse enough to be
+    * drawn from the overview pyramid, scrolling does not trigger any full resolution reloads.
+    *
+    * @param dSamplesPerPixel the number of samples which are drawn to one pixel
+    */
+    void setSamplesPerPixel(double dSamplesPerPixel);
+
     //VARIABLES
     bool                                        m_bFileloaded;  /**< true when a Fiff file is loaded */
     QList<FiffChInfo>                           m_chInfolist;   /**< List of FiffChInfo objects that holds the corresponding channels information */
@@ -228,10 +247,57 @@ private:
     *
     * @param from the start point to read from the file
     * @param to the end point to read from the file
-    * @return the data and times matrices
+    * @return the data and times matrices, which are empty if the segment could not be read
     */
     QPair<MatrixXd,MatrixXd> readSegment(fiff_int_t from, fiff_int_t to);
 
+    //=========================================================================================================
+    /**
+    * loadWindow reads a window from the raw fiff file and filters it with the given operators. This is the loader
+    * of m_pDataCache and runs on its I/O thread, except when the position of the model is reset.
+    *
+    * @param from the start point to read from the file
+    * @param to the end point to read from the file
+    * @param assignedOperators the operators to apply to the channels of the window
+    * @return the new data package or NULL if the window could not be read
+    */
+    QSharedPointer<DataPackage> loadWindow(fiff_int_t from, fiff_int_t to, const QMap<int,QSharedPointer<MNEOperator> >& assignedOperators);
+
+    //=========================================================================================================
+    /**
+    * windowEnd
+    *
+    * @param start the first sample of a window
+    * @return the last sample of the window which starts at start
+    */
+    fiff_int_t windowEnd(fiff_int_t start);
+
+    //=========================================================================================================
+    /**
+    * prefetchWindows requests the next windows in the current scrolling direction from the data cache
+    */
+    void prefetchWindows();
+
+    //=========================================================================================================
+    /**
+    * updateCachedWindows stores the windows of m_data under the current operator set in the data cache, after they were filtered in place
+    */
+    void updateCachedWindows();
+
+    //=========================================================================================================
+    /**
+    * startOverviewComputation reads or computes the overview pyramid of a raw file in a background-thread
+    *
+    * @param sFileName the raw fiff file
+    */
+    void startOverviewComputation(const QString& sFileName);
+
+    //=========================================================================================================
+    /**
+    * stopOverviewComputation aborts a running overview computation and clears the current overview
+    */
+    void stopOverviewComputation();
+
     //VARIABLES
     //Reload control
     bool                                    m_bStartReached;            /**< signals, whether the start of the fiff data file is reached. */
@@ -239,7 +305,8 @@ private:
     bool                                    m_bReloadBefore;            /**< bool value indicating if data was reloaded before (1) or after (0) the existing data. */
 
     //Concurrent reloading
-    QFutureWatcher<QPair<MatrixXd,MatrixXd> > m_reloadFutureWatcher;    /**< QFutureWatcher for watching process of reloading fiff data. */
+    RawDataCache::SPtr                      m_pDataCache;               /**< LRU cache of filtered windows, which loads and prefetches windows on its own I/O thread. */
+    fiff_int_t                              m_iReloadStart;             /**< first sample of the window the model is currently waiting for. */
     bool                                    m_bReloading;               /**< signals when the reloading is ongoing. */
 
     //Concurrent processing
@@ -251,6 +318,12 @@ private:
 
     QMutex                                  m_Mutex;                    /**< mutex for locking against simultaenous access to shared objects >. */
 
+    //Overview pyramid
+    QFutureWatcher<RawOverviewPyramid::SPtr> m_overviewFutureWatcher;   /**< QFutureWatcher for watching the computation of the overview pyramid. */
+    RawOverviewPyramid::SPtr                m_pOverview;                /**< the min/max overview pyramid of the whole fiff file, empty until computed. */
+    QAtomicInt                              m_iOverviewAbort;           /**< set to abort the running overview computation. */
+    double                                  m_dSamplesPerPixel;         /**< current horizontal zoom of the view [in samples per pixel]. */
+
     //Fiff data structure
     QList<QSharedPointer<DataPackage> >     m_data;                     /**< List that holds the fiff matrix data <n_channels x n_samples>. */
 
@@ -281,6 +354,12 @@ signals:
     */
     void fileLoaded(FiffInfo::SPtr&);
 
+    //=========================================================================================================
+    /**
+    * overviewLoaded is emitted when the overview pyramid of the current file is available
+    */
+    void overviewLoaded();
+
     //=========================================================================================================
     /**
     * fileLoaded is emitted whenever a file was to be loaded
@@ -338,6 +417,15 @@ public slots:
     */
     void applyOperatorsConcurrently(QPair<int, RowVectorXd> &chdata) const;
 
+    //=========================================================================================================
+    /**
+    * applyOperators applies the given MNEOperators to a given RowVectorXd and modifies it in-place
+    *
+    * @param chdata[in,out] represents the channel data as a RowVectorXd
+    * @param assignedOperators the operators which are assigned to the channels
+    */
+    void applyOperators(QPair<int, RowVectorXd> &chdata, const QMap<int,QSharedPointer<MNEOperator> >& assignedOperators) const;
+
     //=========================================================================================================
     /**
     * updateOperators updates all set operator to channels according to m_assignedOperators
@@ -407,11 +495,20 @@ public slots:
 private slots:
     //=========================================================================================================
     /**
-    * insertReloadedData inserts the reloaded data when the background has finished the operation
+    * onWindowLoaded is called when the data cache finished loading a window
     *
-    * @param dataTimesPair contains the reloaded matrices of the data and times so it can be inserted into m_data and m_times
+    * @param from the first sample of the loaded window
+    * @param success whether the window could be loaded
     */
-    void insertReloadedData(QPair<MatrixXd,MatrixXd> dataTimesPair);
+    void onWindowLoaded(int from, bool success);
+
+    //=========================================================================================================
+    /**
+    * insertReloadedData inserts a reloaded (and already filtered) window into m_data
+    *
+    * @param pDataPackage the reloaded window
+    */
+    void insertReloadedData(QSharedPointer<DataPackage> pDataPackage);
 
     //=========================================================================================================
     /**
@@ -511,6 +608,30 @@ public:
     * @return the absolute cursor in the fiff file
     */
     inline qint32 absFiffCursor() const;
+
+    //=========================================================================================================
+    /**
+    * overview
+    *
+    * @return the overview pyramid of the loaded Fiff file, NULL or empty while it is still computed
+    */
+    inline RawOverviewPyramid::ConstSPtr overview() const;
+
+    //=========================================================================================================
+    /**
+    * overviewLevel
+    *
+    * @return the overview level to draw the current zoom with or -1 if full resolution data needs to be drawn
+    */
+    inline int overviewLevel() const;
+
+    //=========================================================================================================
+    /**
+    * dataCacheStatistics
+    *
+    * @return the hit, miss and latency statistics of the data cache
+    */
+    inline RawDataCache::Statistics dataCacheStatistics() const;
 };
 
 //*************************************************************************************************************
@@ -566,6 +687,29 @@ inline qint32 RawModel::absFiffCursor() const {
     return m_iAbsFiffCursor;
 }
 
+
+//*************************************************************************************************************
+
+inline RawOverviewPyramid::ConstSPtr RawModel::overview() const {
+    return m_pOverview;
+}
+
+
+//*************************************************************************************************************
+
+inline int RawModel::overviewLevel() const {
+    if(m_pOverview && !m_pOverview->isEmpty())
+        return m_pOverview->selectLevel(m_dSamplesPerPixel);
+    else return -1;
+}
+
+
+//*************************************************************************************************************
+
+inline RawDataCache::Statistics RawModel::dataCacheStatistics() const {
+    return m_pDataCache->statistics();
+}
+
 } // NAMESPACE
 
 #endif // RAWMODEL_H
@@ -42,6 +42,16 @@
 
 #include "filteroperator.h"
 
+#include <utils/fftservice.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QDebug>
+
 
 //*************************************************************************************************************
 //=============================================================================================================
@@ -51,6 +61,14 @@
 using namespace MNEBROWSE;
 
 
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINES
+//=============================================================================================================
+
+#define FILTEROPERATOR_IIR_ORDER    4       /**< Order of the Butterworth prototype. Doubled by the forward-backward application. */
+
+
 //*************************************************************************************************************
 //=============================================================================================================
 // DEFINE MEMBER METHODS
@@ -65,6 +83,7 @@ FilterOperator::FilterOperator()
 , m_iFFTlength(512)
 , m_dCenterFreq(40)
 , m_dBandwidth(3)
+, m_iIirPadLength(0)
 {
 }
 
@@ -81,6 +100,7 @@ FilterOperator::FilterOperator(QString unique_name, FilterType type, int order,
 , m_sFreq(sFreq)
 , m_designMethod(designMethod)
 , m_sName(unique_name)
+, m_iIirPadLength(0)
 {
     switch(designMethod) {
         case Tschebyscheff: {
@@ -135,6 +155,35 @@ FilterOperator::FilterOperator(QString unique_name, FilterType type, int order,
 
             break;
         }
+
+        case Butterworth: {
+            //Applied forward and backward, hence there is no delay to compensate for
+            m_iFilterOrder = 0;
+
+            m_iirFilter = IirFilter(unique_name,
+                                    (FilterData::FilterType)type,
+                                    FILTEROPERATOR_IIR_ORDER,
+                                    centerfreq,
+                                    bandwidth,
+                                    sFreq,
+                                    IirFilter::Butterworth);
+
+            //Ringing which does not fit into the zero padded quarters of the FFT span can not be overlap-added
+            m_iIirPadLength = m_iirFilter.getSettlingLength();
+
+            if(m_iIirPadLength > fftlength/4) {
+                qWarning() << "FilterOperator - The IIR filter settles in" << m_iIirPadLength << "samples, which exceeds the overlap of" << fftlength/4 << "samples. Use a larger window size to avoid seams.";
+            }
+
+            //Magnitude response of the forward-backward application in the layout of the FFT coefficients for plotting
+            m_dFFTCoeffA = RowVectorXcd::Zero(fftlength/2+1);
+
+            for(int i = 0; i < m_dFFTCoeffA.cols(); ++i) {
+                m_dFFTCoeffA(i) = std::norm(m_iirFilter.getFrequencyResponse(i * sFreq / fftlength));
+            }
+
+            break;
+        }
     }
 }
 
@@ -155,13 +204,8 @@ void FilterOperator::fftTransformCoeffs()
     RowVectorXd t_coeffAzeroPad = RowVectorXd::Zero(m_iFFTlength);
     t_coeffAzeroPad.head(m_dCoeffA.cols()) = m_dCoeffA;
 
-    //generate fft object
-    Eigen::FFT<double> fft;
-    fft.SetFlag(fft.HalfSpectrum);
-
     //fft-transform filter coeffs
-    m_dFFTCoeffA = RowVectorXcd::Zero(m_iFFTlength);
-    fft.fwd(m_dFFTCoeffA,t_coeffAzeroPad);
+    FFTService::fwd(m_dFFTCoeffA, t_coeffAzeroPad);
 }
 
 
@@ -169,24 +213,31 @@ void FilterOperator::fftTransformCoeffs()
 
 RowVectorXd FilterOperator::applyFFTFilter(const RowVectorXd& data) const
 {
+    if(m_designMethod == Butterworth) {
+        //Zero pad in front and back and filter the whole span. Both passes start from rest, hence the filter is
+        //linear and the response ringing into the zero padded quarters is added to the neighbouring windows by the
+        //overlap-add, just like the FFT filtered data. Filtering each window on its own would show the start-up
+        //transient at every window boundary.
+        RowVectorXd t_dataZeroPad = RowVectorXd::Zero(m_iFFTlength);
+        t_dataZeroPad.segment(m_iFFTlength/4, data.cols()) = data;
+
+        return m_iirFilter.applyZeroPhaseFilter(t_dataZeroPad, m_iIirPadLength, IirFilter::ZeroPadding);
+    }
+
     //Zero pad in front and back
     RowVectorXd t_dataZeroPad = RowVectorXd::Zero(m_iFFTlength);
     t_dataZeroPad.segment(m_iFFTlength/4-m_iFilterOrder/2, data.cols()) = data;
 
-    //generate fft object
-    Eigen::FFT<double> fft;
-    fft.SetFlag(fft.HalfSpectrum);
-
-    //fft-transform data sequence
+    //fft-transform data sequence, the plan for m_iFFTlength is cached by the FFT service
     RowVectorXcd t_freqData;
-    fft.fwd(t_freqData,t_dataZeroPad);
+    FFTService::fwd(t_freqData, t_dataZeroPad);
 
     //perform frequency-domain filtering
     RowVectorXcd t_filteredFreq = m_dFFTCoeffA.array()*t_freqData.array();
 
     //inverse-FFT
     RowVectorXd t_filteredTime;
-    fft.inv(t_filteredTime,t_filteredFreq);
+    FFTService::inv(t_filteredTime, t_filteredFreq, m_iFFTlength);
 
     //Return filtered data still with zeros at front and end
     return t_filteredTime;
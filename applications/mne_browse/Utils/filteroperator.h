@@ -66,6 +66,7 @@
 #include <mne/mne.h>
 #include <utils/filterTools/parksmcclellan.h>
 #include <utils/filterTools/cosinefilter.h>
+#include <utils/filterTools/iirfilter.h>
 #include "disp/helpers/mneoperator.h"
 
 
@@ -111,7 +112,8 @@ class FilterOperator : public MNEOperator
 public:
     enum DesignMethod {
        Tschebyscheff,
-       Cosine} m_designMethod;
+       Cosine,
+       Butterworth} m_designMethod;
 
     enum FilterType {
        LPF,
@@ -171,6 +173,9 @@ public:
 
     RowVectorXcd    m_dFFTCoeffA;       /**< the FFT-transformed forward filter coefficient set, required for frequency-domain filtering, zero-padded to m_iFFTlength. */
     RowVectorXcd    m_dFFTCoeffB;       /**< the FFT-transformed backward filter coefficient set, required for frequency-domain filtering, zero-padded to m_iFFTlength. */
+
+    IirFilter       m_iirFilter;        /**< the IIR filter which is applied forward and backward (zero-phase) if the Butterworth design method is used. */
+    int             m_iIirPadLength;    /**< the number of zeros the IIR filter pads at both ends, sized to the settling time of the filter. */
 };
 
 } // NAMESPACE
@@ -0,0 +1,318 @@
+//=============================================================================================================
+/**
+* @file     rawdatacache.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     Contains the implementation of the RawDataCache class.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "rawdatacache.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtConcurrent>
+#include <QElapsedTimer>
+#include <QDebug>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace MNEBROWSE;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+RawDataCache::RawDataCache(const Loader& loader, int iMaxWindows, QObject *parent)
+: QObject(parent)
+, m_loader(loader)
+, m_iMaxWindows(qMax(1, iMaxWindows))
+{
+    m_ioThreadPool.setMaxThreadCount(1);
+    m_ioThreadPool.setExpiryTimeout(-1);
+
+    resetStatistics();
+}
+
+
+//*************************************************************************************************************
+
+RawDataCache::~RawDataCache()
+{
+    cancelPending();
+    m_ioThreadPool.waitForDone();
+}
+
+
+//*************************************************************************************************************
+
+QSharedPointer<DataPackage> RawDataCache::lookup(fiff_int_t from, const QMap<int,QSharedPointer<MNEOperator> >& assignedOperators)
+{
+    QMutexLocker locker(&m_mutex);
+
+    int index = indexOf(m_listCached, from, assignedOperators);
+    if(index < 0) {
+        ++m_statistics.iMisses;
+        return QSharedPointer<DataPackage>();
+    }
+
+    ++m_statistics.iHits;
+    m_listCached.move(index, 0);
+
+    return m_listCached.first().pDataPackage;
+}
+
+
+//*************************************************************************************************************
+
+QSharedPointer<DataPackage> RawDataCache::find(fiff_int_t from, const QMap<int,QSharedPointer<MNEOperator> >& assignedOperators) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    int index = indexOf(m_listCached, from, assignedOperators);
+    if(index < 0)
+        return QSharedPointer<DataPackage>();
+
+    return m_listCached[index].pDataPackage;
+}
+
+
+//*************************************************************************************************************
+
+void RawDataCache::insert(fiff_int_t from, const QMap<int,QSharedPointer<MNEOperator> >& assignedOperators, const QSharedPointer<DataPackage>& pDataPackage)
+{
+    if(!pDataPackage)
+        return;
+
+    Entry entry;
+    entry.from = from;
+    entry.to = from + pDataPackage->dataRaw().cols() - 1;
+    entry.assignedOperators = assignedOperators;
+    entry.pDataPackage = pDataPackage;
+    entry.bPrefetch = false;
+
+    QMutexLocker locker(&m_mutex);
+    insertEntry(entry);
+}
+
+
+//*************************************************************************************************************
+
+void RawDataCache::request(fiff_int_t from, fiff_int_t to, const QMap<int,QSharedPointer<MNEOperator> >& assignedOperators)
+{
+    QMutexLocker locker(&m_mutex);
+
+    //Already being loaded - windowLoaded will be emitted when it is done
+    if(indexOf(m_listRunning, from, assignedOperators) >= 0)
+        return;
+
+    //Move a pending prefetch of the same window to the front or queue a new request there
+    int index = indexOf(m_listPending, from, assignedOperators);
+    if(index >= 0) {
+        m_listPending[index].bPrefetch = false;
+        m_listPending.move(index, 0);
+        return;
+    }
+
+    Entry entry;
+    entry.from = from;
+    entry.to = to;
+    entry.assignedOperators = assignedOperators;
+    entry.bPrefetch = false;
+
+    m_listPending.prepend(entry);
+
+    QtConcurrent::run(&m_ioThreadPool, this, &RawDataCache::processRequest);
+}
+
+
+//*************************************************************************************************************
+
+void RawDataCache::prefetch(fiff_int_t from, fiff_int_t to, const QMap<int,QSharedPointer<MNEOperator> >& assignedOperators)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(indexOf(m_listCached, from, assignedOperators) >= 0
+            || indexOf(m_listRunning, from, assignedOperators) >= 0
+            || indexOf(m_listPending, from, assignedOperators) >= 0)
+        return;
+
+    Entry entry;
+    entry.from = from;
+    entry.to = to;
+    entry.assignedOperators = assignedOperators;
+    entry.bPrefetch = true;
+
+    m_listPending.append(entry);
+
+    QtConcurrent::run(&m_ioThreadPool, this, &RawDataCache::processRequest);
+}
+
+
+//*************************************************************************************************************
+
+void RawDataCache::cancelPending()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_statistics.iCancelled += m_listPending.size();
+    m_listPending.clear();
+}
+
+
+//*************************************************************************************************************
+
+void RawDataCache::clear()
+{
+    cancelPending();
+    m_ioThreadPool.waitForDone();
+
+    QMutexLocker locker(&m_mutex);
+    m_listCached.clear();
+}
+
+
+//*************************************************************************************************************
+
+RawDataCache::Statistics RawDataCache::statistics() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_statistics;
+}
+
+
+//*************************************************************************************************************
+
+void RawDataCache::resetStatistics()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_statistics.iHits = 0;
+    m_statistics.iMisses = 0;
+    m_statistics.iLoads = 0;
+    m_statistics.iPrefetches = 0;
+    m_statistics.iCancelled = 0;
+    m_statistics.dMeanLoadTimeMs = 0.0;
+    m_statistics.dMaxLoadTimeMs = 0.0;
+}
+
+
+//*************************************************************************************************************
+
+void RawDataCache::processRequest()
+{
+    Entry entry;
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        //Every request schedules one call - cancelled requests leave nothing to do
+        if(m_listPending.isEmpty())
+            return;
+
+        entry = m_listPending.takeFirst();
+        m_listRunning.append(entry);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    entry.pDataPackage = m_loader(entry.from, entry.to, entry.assignedOperators);
+
+    double dLoadTimeMs = timer.nsecsElapsed() / 1.0e6;
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        //Insert in the same step, so that no duplicate request can be queued in between
+        m_listRunning.clear();
+        if(entry.bPrefetch)
+            ++m_statistics.iPrefetches;
+
+        if(entry.pDataPackage) {
+            entry.bPrefetch = false;
+            insertEntry(entry);
+        }
+
+        ++m_statistics.iLoads;
+        m_statistics.dMeanLoadTimeMs += (dLoadTimeMs - m_statistics.dMeanLoadTimeMs) / m_statistics.iLoads;
+        m_statistics.dMaxLoadTimeMs = qMax(m_statistics.dMaxLoadTimeMs, dLoadTimeMs);
+    }
+
+    if(!entry.pDataPackage)
+        qDebug() << "RawDataCache: Error loading window starting at sample" << entry.from;
+
+    emit windowLoaded(entry.from, !entry.pDataPackage.isNull());
+}
+
+
+//*************************************************************************************************************
+
+void RawDataCache::insertEntry(const Entry& entry)
+{
+    //Drop the old key of the same package and an old package with the same key
+    for(int i = m_listCached.size()-1; i >= 0; --i) {
+        if(m_listCached[i].pDataPackage == entry.pDataPackage
+                || (m_listCached[i].from == entry.from && m_listCached[i].assignedOperators == entry.assignedOperators))
+            m_listCached.removeAt(i);
+    }
+
+    m_listCached.prepend(entry);
+
+    while(m_listCached.size() > m_iMaxWindows)
+        m_listCached.removeLast();
+}
+
+
+//*************************************************************************************************************
+
+int RawDataCache::indexOf(const QList<Entry>& list, fiff_int_t from, const QMap<int,QSharedPointer<MNEOperator> >& assignedOperators)
+{
+    for(int i = 0; i < list.size(); ++i) {
+        if(list[i].from == from && list[i].assignedOperators == assignedOperators)
+            return i;
+    }
+
+    return -1;
+}
@@ -0,0 +1,265 @@
+//=============================================================================================================
+/**
+* @file     rawdatacache.h
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     Contains the declaration of the RawDataCache class.
+*
+*/
+
+#ifndef RAWDATACACHE_H
+#define RAWDATACACHE_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "datapackage.h"
+#include "filteroperator.h"
+#include "rawsettings.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QMap>
+#include <QList>
+#include <QMutex>
+#include <QThreadPool>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <functional>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE MNEBROWSE
+//=============================================================================================================
+
+namespace MNEBROWSE
+{
+
+
+//=============================================================================================================
+/**
+* RawDataCache keeps the most recently used (and already filtered) data windows of a raw file. A window is
+* identified by its first sample and the set of MNEOperators which were applied to its channels, so that switching
+* back to a previous filter setting or scrolling back to a visited position does not read the file again.
+* Windows which are not cached are loaded on a dedicated I/O thread. Requests for the window the view is waiting
+* for are served before prefetch requests, and pending requests which are no longer needed can be cancelled.
+*
+* @brief The RawDataCache class provides an LRU cache with asynchronous loading and prefetching of data windows.
+*/
+class RawDataCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef QSharedPointer<RawDataCache> SPtr;              /**< Shared pointer type for RawDataCache. */
+    typedef QSharedPointer<const RawDataCache> ConstSPtr;   /**< Const shared pointer type for RawDataCache. */
+
+    /** Loads and filters the window [from,to] with the given operators. Returns NULL on error. This is called on the I/O thread. */
+    typedef std::function<QSharedPointer<DataPackage> (fiff_int_t, fiff_int_t, const QMap<int,QSharedPointer<MNEOperator> >&)> Loader;
+
+    //=========================================================================================================
+    /**
+    * Hit, miss and latency statistics of the cache.
+    */
+    struct Statistics {
+        qint64  iHits;              /**< Number of lookups which were served from the cache. */
+        qint64  iMisses;            /**< Number of lookups which needed to load data. */
+        qint64  iLoads;             /**< Number of windows which were loaded. */
+        qint64  iPrefetches;        /**< Number of loaded windows which were requested as prefetch. */
+        qint64  iCancelled;         /**< Number of pending requests which were cancelled before being loaded. */
+        double  dMeanLoadTimeMs;    /**< Mean time to read and filter a window [ms]. */
+        double  dMaxLoadTimeMs;     /**< Maximum time to read and filter a window [ms]. */
+    };
+
+    //=========================================================================================================
+    /**
+    * Constructs a RawDataCache.
+    *
+    * @param[in] loader         The function which loads and filters a window.
+    * @param[in] iMaxWindows    The maximum number of windows which are kept.
+    * @param[in] parent         The parent QObject.
+    */
+    RawDataCache(const Loader& loader, int iMaxWindows = MODEL_CACHE_MAX_WINDOWS, QObject *parent = 0);
+
+    //=========================================================================================================
+    /**
+    * Destroys the RawDataCache. Pending requests are cancelled and a running load is waited for.
+    */
+    ~RawDataCache();
+
+    //=========================================================================================================
+    /**
+    * Looks up a window and counts the lookup as hit or miss. The window is moved to the front of the LRU list.
+    *
+    * @param[in] from               The first sample of the window.
+    * @param[in] assignedOperators  The operators the window needs to be filtered with.
+    *
+    * @return the window or NULL if it is not cached.
+    */
+    QSharedPointer<DataPackage> lookup(fiff_int_t from, const QMap<int,QSharedPointer<MNEOperator> >& assignedOperators);
+
+    //=========================================================================================================
+    /**
+    * Looks up a window without changing the statistics or the LRU order.
+    *
+    * @param[in] from               The first sample of the window.
+    * @param[in] assignedOperators  The operators the window needs to be filtered with.
+    *
+    * @return the window or NULL if it is not cached.
+    */
+    QSharedPointer<DataPackage> find(fiff_int_t from, const QMap<int,QSharedPointer<MNEOperator> >& assignedOperators) const;
+
+    //=========================================================================================================
+    /**
+    * Inserts a window. Entries which hold the same data package under another key are removed, since the
+    * package was modified in place (e.g. filtered with a new operator set).
+    *
+    * @param[in] from               The first sample of the window.
+    * @param[in] assignedOperators  The operators the window was filtered with.
+    * @param[in] pDataPackage       The window.
+    */
+    void insert(fiff_int_t from, const QMap<int,QSharedPointer<MNEOperator> >& assignedOperators, const QSharedPointer<DataPackage>& pDataPackage);
+
+    //=========================================================================================================
+    /**
+    * Requests a window the view is waiting for. The request is served before all prefetch requests.
+    * windowLoaded is emitted once the window was loaded.
+    *
+    * @param[in] from               The first sample of the window.
+    * @param[in] to                 The last sample of the window.
+    * @param[in] assignedOperators  The operators the window needs to be filtered with.
+    */
+    void request(fiff_int_t from, fiff_int_t to, const QMap<int,QSharedPointer<MNEOperator> >& assignedOperators);
+
+    //=========================================================================================================
+    /**
+    * Requests a window which is likely needed soon. Nothing is done if the window is cached or already requested.
+    *
+    * @param[in] from               The first sample of the window.
+    * @param[in] to                 The last sample of the window.
+    * @param[in] assignedOperators  The operators the window needs to be filtered with.
+    */
+    void prefetch(fiff_int_t from, fiff_int_t to, const QMap<int,QSharedPointer<MNEOperator> >& assignedOperators);
+
+    //=========================================================================================================
+    /**
+    * Cancels all requests which were not started yet.
+    */
+    void cancelPending();
+
+    //=========================================================================================================
+    /**
+    * Cancels all pending requests, waits for a running load and removes all windows.
+    * This needs to be called before the data source of the loader is changed.
+    */
+    void clear();
+
+    //=========================================================================================================
+    /**
+    * Returns the current statistics.
+    *
+    * @return the statistics.
+    */
+    Statistics statistics() const;
+
+    //=========================================================================================================
+    /**
+    * Resets the statistics.
+    */
+    void resetStatistics();
+
+signals:
+    //=========================================================================================================
+    /**
+    * windowLoaded is emitted from the I/O thread whenever a requested window was loaded.
+    *
+    * @param[in] from       The first sample of the window.
+    * @param[in] success    Whether the window could be loaded.
+    */
+    void windowLoaded(int from, bool success);
+
+private:
+    //=========================================================================================================
+    /**
+    * A cached or requested window.
+    */
+    struct Entry {
+        fiff_int_t                                  from;               /**< First sample of the window. */
+        fiff_int_t                                  to;                 /**< Last sample of the window. */
+        QMap<int,QSharedPointer<MNEOperator> >      assignedOperators;  /**< Operators the window is filtered with. Also keeps them alive, so their addresses stay unique. */
+        QSharedPointer<DataPackage>                 pDataPackage;       /**< The window, NULL for requests. */
+        bool                                        bPrefetch;          /**< Whether the request is a prefetch. */
+    };
+
+    //=========================================================================================================
+    /**
+    * Takes the next pending request and loads it. This runs on the I/O thread.
+    */
+    void processRequest();
+
+    //=========================================================================================================
+    /**
+    * Inserts a loaded window as most recently used entry and drops the least recently used ones. m_mutex needs to be locked.
+    */
+    void insertEntry(const Entry& entry);
+
+    //=========================================================================================================
+    /**
+    * Returns the index of an entry with the given key or -1. m_mutex needs to be locked.
+    */
+    static int indexOf(const QList<Entry>& list, fiff_int_t from, const QMap<int,QSharedPointer<MNEOperator> >& assignedOperators);
+
+    Loader                  m_loader;           /**< Loads and filters a window. */
+    int                     m_iMaxWindows;      /**< Maximum number of cached windows. */
+
+    mutable QMutex          m_mutex;            /**< Guards the lists and statistics. */
+    QList<Entry>            m_listCached;       /**< The cached windows, most recently used first. */
+    QList<Entry>            m_listPending;      /**< The requests which were not started yet, next one first. */
+    QList<Entry>            m_listRunning;      /**< The request which is currently loaded. */
+    QThreadPool             m_ioThreadPool;     /**< Dedicated single thread pool, so reads never compete with each other. */
+
+    Statistics              m_statistics;       /**< Hit, miss and latency statistics. */
+};
+
+} // NAMESPACE
+
+#endif // RAWDATACACHE_H
@@ -0,0 +1,444 @@
+//=============================================================================================================
+/**
+* @file     rawoverviewpyramid.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     Contains the implementation of the RawOverviewPyramid class.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "rawoverviewpyramid.h"
+
+#include <fiff/fiff_raw_data.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QDataStream>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace MNEBROWSE;
+using namespace FIFFLIB;
+using namespace Eigen;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE GLOBAL METHODS
+//=============================================================================================================
+
+namespace
+{
+
+const quint32 OVERVIEW_CACHE_MAGIC = 0x4f565059;   // "OVPY"
+const qint32 OVERVIEW_CACHE_VERSION = 1;
+
+
+//*************************************************************************************************************
+
+void writeMatrix(QDataStream& stream, const MatrixXfR& mat)
+{
+    stream << qint32(mat.rows()) << qint32(mat.cols());
+    stream.writeRawData(reinterpret_cast<const char*>(mat.data()), int(mat.size()*sizeof(float)));
+}
+
+
+//*************************************************************************************************************
+
+void readMatrix(QDataStream& stream, MatrixXfR& mat)
+{
+    qint32 rows, cols;
+    stream >> rows >> cols;
+    if(stream.status() != QDataStream::Ok || rows < 0 || cols < 0) {
+        stream.setStatus(QDataStream::ReadCorruptData);
+        return;
+    }
+
+    mat.resize(rows, cols);
+    const int iBytes = int(mat.size()*sizeof(float));
+    if(stream.readRawData(reinterpret_cast<char*>(mat.data()), iBytes) != iBytes) {
+        stream.setStatus(QDataStream::ReadPastEnd);
+    }
+}
+
+} // namespace
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+RawOverviewPyramid::RawOverviewPyramid()
+: m_iNumSamples(0)
+{
+}
+
+
+//*************************************************************************************************************
+
+RawOverviewPyramid::SPtr RawOverviewPyramid::loadOrBuild(const QString& sFileName, int iBaseLevel, const QAtomicInt* pAbort)
+{
+    RawOverviewPyramid::SPtr pPyramid(new RawOverviewPyramid());
+
+    //Use an own file handle, so that the pyramid can be computed without blocking the reads of the RawModel
+    QFile file(sFileName);
+    FiffRawData raw(file);
+    if(raw.info.nchan <= 0) {
+        qWarning() << "RawOverviewPyramid::loadOrBuild - Could not read raw data from" << sFileName;
+        return pPyramid;
+    }
+
+    const QByteArray baKey = cacheKey(sFileName, raw, iBaseLevel);
+    const QStringList lCacheFileNames = cacheFileNames(sFileName, baKey);
+
+    for(int i = 0; i < lCacheFileNames.size(); ++i) {
+        if(pPyramid->read(lCacheFileNames[i], baKey)) {
+            qDebug() << "RawOverviewPyramid::loadOrBuild - Read overview from" << lCacheFileNames[i];
+            return pPyramid;
+        }
+    }
+
+    if(!pPyramid->build(raw, iBaseLevel, pAbort)) {
+        return pPyramid;
+    }
+
+    for(int i = 0; i < lCacheFileNames.size(); ++i) {
+        if(pPyramid->write(lCacheFileNames[i], baKey)) {
+            qDebug() << "RawOverviewPyramid::loadOrBuild - Wrote overview to" << lCacheFileNames[i];
+            break;
+        }
+    }
+
+    return pPyramid;
+}
+
+
+//*************************************************************************************************************
+
+bool RawOverviewPyramid::build(FiffRawData& raw, int iBaseLevel, const QAtomicInt* pAbort)
+{
+    m_vecLevels.clear();
+
+    const qint32 nchan = raw.info.nchan;
+    m_iNumSamples = raw.last_samp - raw.first_samp + 1;
+
+    if(nchan <= 0 || m_iNumSamples <= 0 || iBaseLevel < 0 || iBaseLevel > 24) {
+        m_iNumSamples = 0;
+        return false;
+    }
+
+    Level base;
+    base.iDecimation = 1 << iBaseLevel;
+
+    const qint32 nBins = (m_iNumSamples + base.iDecimation - 1) / base.iDecimation;
+    base.matMin.resize(nchan, nBins);
+    base.matMax.resize(nchan, nBins);
+    base.matMean.resize(nchan, nBins);
+
+    //Read blocks which are a multiple of the bin size, so that only the last bin of the file can be partial
+    const qint32 iBlockSize = base.iDecimation * qMax(1, MODEL_OVERVIEW_BLOCK_SIZE / base.iDecimation);
+
+    MatrixXd data, times;
+    MatrixXd dataT;
+
+    for(qint32 from = 0; from < m_iNumSamples; from += iBlockSize) {
+        if(pAbort && pAbort->load()) {
+            m_iNumSamples = 0;
+            return false;
+        }
+
+        const qint32 to = qMin(from + iBlockSize, m_iNumSamples) - 1;
+
+        if(!raw.read_raw_segment(data, times, raw.first_samp + from, raw.first_samp + to)
+                || data.rows() != nchan || data.cols() != to - from + 1) {
+            qWarning() << "RawOverviewPyramid::build - Error when reading raw data from" << from << "to" << to;
+            m_iNumSamples = 0;
+            return false;
+        }
+
+        //Transpose once, so that every channel is a contiguous column which can be viewed as <decimation x bins>
+        dataT = data.transpose();
+
+        const qint32 iBin = from / base.iDecimation;
+        const qint32 nFull = dataT.rows() / base.iDecimation;
+        const qint32 nRest = dataT.rows() - nFull * base.iDecimation;
+
+        for(qint32 c = 0; c < nchan; ++c) {
+            if(nFull > 0) {
+                Map<const MatrixXd> bins(dataT.col(c).data(), base.iDecimation, nFull);
+                base.matMin.row(c).segment(iBin, nFull) = bins.colwise().minCoeff().cast<float>();
+                base.matMax.row(c).segment(iBin, nFull) = bins.colwise().maxCoeff().cast<float>();
+                base.matMean.row(c).segment(iBin, nFull) = bins.colwise().mean().cast<float>();
+            }
+
+            if(nRest > 0) {
+                Map<const VectorXd> tail(dataT.col(c).data() + nFull * base.iDecimation, nRest);
+                base.matMin(c, iBin + nFull) = float(tail.minCoeff());
+                base.matMax(c, iBin + nFull) = float(tail.maxCoeff());
+                base.matMean(c, iBin + nFull) = float(tail.mean());
+            }
+        }
+    }
+
+    m_vecLevels.append(base);
+
+    while(m_vecLevels.last().matMin.cols() > MODEL_OVERVIEW_MIN_BINS) {
+        appendReducedLevel();
+    }
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+bool RawOverviewPyramid::read(const QString& sCacheFileName, const QByteArray& baKey)
+{
+    QFile file(sCacheFileName);
+    if(!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic;
+    qint32 version;
+    QByteArray key;
+    stream >> magic >> version >> key;
+    if(magic != OVERVIEW_CACHE_MAGIC || version != OVERVIEW_CACHE_VERSION || key != baKey) {
+        return false;
+    }
+
+    qint32 iNumSamples, nLevels;
+    stream >> iNumSamples >> nLevels;
+
+    QVector<Level> vecLevels;
+    for(qint32 i = 0; i < nLevels && stream.status() == QDataStream::Ok; ++i) {
+        Level level;
+        stream >> level.iDecimation;
+        readMatrix(stream, level.matMin);
+        readMatrix(stream, level.matMax);
+        readMatrix(stream, level.matMean);
+        vecLevels.append(level);
+    }
+
+    if(stream.status() != QDataStream::Ok || vecLevels.isEmpty()) {
+        return false;
+    }
+
+    m_iNumSamples = iNumSamples;
+    m_vecLevels = vecLevels;
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+bool RawOverviewPyramid::write(const QString& sCacheFileName, const QByteArray& baKey) const
+{
+    if(isEmpty()) {
+        return false;
+    }
+
+    //Write to a temporary file first, so that a second browser instance never reads a partially written cache
+    QSaveFile file(sCacheFileName);
+    if(!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    stream << OVERVIEW_CACHE_MAGIC << OVERVIEW_CACHE_VERSION << baKey;
+    stream << m_iNumSamples << qint32(m_vecLevels.size());
+    for(int i = 0; i < m_vecLevels.size(); ++i) {
+        stream << m_vecLevels[i].iDecimation;
+        writeMatrix(stream, m_vecLevels[i].matMin);
+        writeMatrix(stream, m_vecLevels[i].matMax);
+        writeMatrix(stream, m_vecLevels[i].matMean);
+    }
+
+    return stream.status() == QDataStream::Ok && file.commit();
+}
+
+
+//*************************************************************************************************************
+
+QByteArray RawOverviewPyramid::cacheKey(const QString& sFileName, const FiffRawData& raw, int iBaseLevel)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    const FiffId& id = raw.info.file_id;
+    if(!id.isEmpty()) {
+        hash.addData(QByteArray::number(id.version));
+        hash.addData(QByteArray::number(id.machid[0]));
+        hash.addData(QByteArray::number(id.machid[1]));
+        hash.addData(QByteArray::number(id.time.secs));
+        hash.addData(QByteArray::number(id.time.usecs));
+    }
+    else {
+        //No file id available - fall back to the file itself
+        QFileInfo fileInfo(sFileName);
+        hash.addData(fileInfo.absoluteFilePath().toUtf8());
+        hash.addData(QByteArray::number(fileInfo.size()));
+        hash.addData(QByteArray::number(fileInfo.lastModified().toMSecsSinceEpoch()));
+    }
+
+    hash.addData(QByteArray::number(raw.first_samp));
+    hash.addData(QByteArray::number(raw.last_samp));
+    hash.addData(QByteArray::number(raw.info.nchan));
+    hash.addData(QByteArray::number(iBaseLevel));
+    hash.addData(QByteArray::number(MODEL_OVERVIEW_MIN_BINS));
+
+    return hash.result();
+}
+
+
+//*************************************************************************************************************
+
+QStringList RawOverviewPyramid::cacheFileNames(const QString& sFileName, const QByteArray& baKey)
+{
+    QStringList lCacheFileNames;
+
+    QFileInfo fileInfo(sFileName);
+    lCacheFileNames << fileInfo.absolutePath() + "/" + fileInfo.completeBaseName() + "-overview.bin";
+
+    QString sCacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if(!sCacheDir.isEmpty() && QDir().mkpath(sCacheDir)) {
+        lCacheFileNames << sCacheDir + "/" + QString(baKey.toHex()) + "-overview.bin";
+    }
+
+    return lCacheFileNames;
+}
+
+
+//*************************************************************************************************************
+
+int RawOverviewPyramid::selectLevel(double dSamplesPerPixel) const
+{
+    int iLevel = -1;
+
+    for(int i = 0; i < m_vecLevels.size(); ++i) {
+        if(m_vecLevels[i].iDecimation > dSamplesPerPixel) {
+            break;
+        }
+
+        iLevel = i;
+    }
+
+    return iLevel;
+}
+
+
+//*************************************************************************************************************
+
+double RawOverviewPyramid::channelMean(int iChannel) const
+{
+    if(isEmpty() || iChannel < 0 || iChannel >= numChannels()) {
+        return 0.0;
+    }
+
+    const int iLevel = m_vecLevels.size() - 1;
+    const MatrixXfR& matMean = m_vecLevels[iLevel].matMean;
+
+    double dSum = 0.0;
+    for(qint32 j = 0; j < matMean.cols(); ++j) {
+        dSum += double(matMean(iChannel, j)) * binSize(iLevel, j);
+    }
+
+    return dSum / m_iNumSamples;
+}
+
+
+//*************************************************************************************************************
+
+void RawOverviewPyramid::appendReducedLevel()
+{
+    const int iFine = m_vecLevels.size() - 1;
+    const Level& fine = m_vecLevels[iFine];
+
+    const qint32 nchan = fine.matMin.rows();
+    const qint32 nFine = fine.matMin.cols();
+    const qint32 nPairs = nFine / 2;
+
+    Level coarse;
+    coarse.iDecimation = 2 * fine.iDecimation;
+    coarse.matMin.resize(nchan, (nFine + 1) / 2);
+    coarse.matMax.resize(nchan, (nFine + 1) / 2);
+    coarse.matMean.resize(nchan, (nFine + 1) / 2);
+
+    for(qint32 c = 0; c < nchan; ++c) {
+        //Rows are contiguous, so every row can be viewed as <2 x pairs>
+        Map<const MatrixXf> pairMin(fine.matMin.row(c).data(), 2, nPairs);
+        Map<const MatrixXf> pairMax(fine.matMax.row(c).data(), 2, nPairs);
+        Map<const MatrixXf> pairMean(fine.matMean.row(c).data(), 2, nPairs);
+
+        coarse.matMin.row(c).head(nPairs) = pairMin.colwise().minCoeff();
+        coarse.matMax.row(c).head(nPairs) = pairMax.colwise().maxCoeff();
+        coarse.matMean.row(c).head(nPairs) = pairMean.colwise().mean();
+    }
+
+    if(nFine % 2) {
+        //Odd number of bins - the last bin is carried over
+        coarse.matMin.col(nPairs) = fine.matMin.col(nFine - 1);
+        coarse.matMax.col(nPairs) = fine.matMax.col(nFine - 1);
+        coarse.matMean.col(nPairs) = fine.matMean.col(nFine - 1);
+    }
+    else if(nPairs > 0) {
+        //The last pair may contain the partial last bin, which needs to be weighted by its size
+        const float fWeight = float(binSize(iFine, nFine - 1)) / fine.iDecimation;
+        coarse.matMean.col(nPairs - 1) = (fine.matMean.col(nFine - 2) + fWeight * fine.matMean.col(nFine - 1)) / (1.0f + fWeight);
+    }
+
+    m_vecLevels.append(coarse);
+}
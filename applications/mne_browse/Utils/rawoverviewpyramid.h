@@ -0,0 +1,300 @@
+//=============================================================================================================
+/**
+* @file     rawoverviewpyramid.h
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     Contains the declaration of the RawOverviewPyramid class.
+*
+*/
+
+#ifndef RAWOVERVIEWPYRAMID_H
+#define RAWOVERVIEWPYRAMID_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "types.h"
+#include "rawsettings.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QSharedPointer>
+#include <QVector>
+#include <QAtomicInt>
+#include <QString>
+#include <QByteArray>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// FORWARD DECLARATIONS
+//=============================================================================================================
+
+namespace FIFFLIB
+{
+    class FiffRawData;
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE MNEBROWSE
+//=============================================================================================================
+
+namespace MNEBROWSE
+{
+
+
+//=============================================================================================================
+/**
+* RawOverviewPyramid holds per channel min/max/mean envelopes of a whole raw file at decimation levels of 2^k.
+* Level 0 summarizes 2^MODEL_OVERVIEW_BASE_LEVEL samples per bin, every following level halves the number of bins.
+* This allows to draw any zoomed out view of a recording by reading a single level instead of the raw samples.
+* The pyramid is computed in one streaming pass over the file and stored in a sidecar cache file, which is keyed
+* by the FIFF file id, so that reopening the same recording only reads the cache.
+*
+* @brief The RawOverviewPyramid class provides multiresolution min/max envelopes of a raw file.
+*/
+class RawOverviewPyramid
+{
+public:
+    typedef QSharedPointer<RawOverviewPyramid> SPtr;              /**< Shared pointer type for RawOverviewPyramid. */
+    typedef QSharedPointer<const RawOverviewPyramid> ConstSPtr;   /**< Const shared pointer type for RawOverviewPyramid. */
+
+    //=========================================================================================================
+    /**
+    * One level of the pyramid. Every matrix is of size <n_channels x n_bins>.
+    */
+    struct Level {
+        qint32      iDecimation;    /**< Number of samples which are summarized by one bin. */
+        MatrixXfR   matMin;         /**< Minimum of every bin. */
+        MatrixXfR   matMax;         /**< Maximum of every bin. */
+        MatrixXfR   matMean;        /**< Mean of every bin. */
+    };
+
+    //=========================================================================================================
+    /**
+    * Constructs an empty RawOverviewPyramid.
+    */
+    RawOverviewPyramid();
+
+    //=========================================================================================================
+    /**
+    * Reads the pyramid of a raw file from its cache or computes it (and writes the cache) if no valid cache exists.
+    * The file is opened with its own stream, so this can run in a background thread next to the RawModel reads.
+    *
+    * @param[in] sFileName      The raw fiff file.
+    * @param[in] iBaseLevel     The finest level is computed for a decimation of 2^iBaseLevel samples.
+    * @param[in] pAbort         Optional flag, which stops the computation when it is set to a non zero value.
+    *
+    * @return the pyramid, which is empty if the file could not be read or the computation was aborted.
+    */
+    static RawOverviewPyramid::SPtr loadOrBuild(const QString& sFileName,
+                                                int iBaseLevel = MODEL_OVERVIEW_BASE_LEVEL,
+                                                const QAtomicInt* pAbort = Q_NULLPTR);
+
+    //=========================================================================================================
+    /**
+    * Computes the pyramid by streaming over the whole raw data.
+    *
+    * @param[in] raw            The raw data to summarize.
+    * @param[in] iBaseLevel     The finest level is computed for a decimation of 2^iBaseLevel samples.
+    * @param[in] pAbort         Optional flag, which stops the computation when it is set to a non zero value.
+    *
+    * @return true if the pyramid was computed successfully.
+    */
+    bool build(FIFFLIB::FiffRawData& raw, int iBaseLevel = MODEL_OVERVIEW_BASE_LEVEL, const QAtomicInt* pAbort = Q_NULLPTR);
+
+    //=========================================================================================================
+    /**
+    * Reads the pyramid from a cache file.
+    *
+    * @param[in] sCacheFileName The cache file.
+    * @param[in] baKey          The key the cache file needs to be written with.
+    *
+    * @return true if the cache exists, matches the key and was read successfully.
+    */
+    bool read(const QString& sCacheFileName, const QByteArray& baKey);
+
+    //=========================================================================================================
+    /**
+    * Writes the pyramid to a cache file.
+    *
+    * @param[in] sCacheFileName The cache file.
+    * @param[in] baKey          The key which identifies the raw file and the pyramid parameters.
+    *
+    * @return true if the cache was written successfully.
+    */
+    bool write(const QString& sCacheFileName, const QByteArray& baKey) const;
+
+    //=========================================================================================================
+    /**
+    * Returns the cache key of a raw file. The key is based on the FIFF file id. For files without a valid id
+    * the file name, size and modification time are used instead.
+    *
+    * @param[in] sFileName      The raw fiff file.
+    * @param[in] raw            The raw data read from the file.
+    * @param[in] iBaseLevel     The base level of the pyramid.
+    *
+    * @return the cache key.
+    */
+    static QByteArray cacheKey(const QString& sFileName, const FIFFLIB::FiffRawData& raw, int iBaseLevel);
+
+    //=========================================================================================================
+    /**
+    * Returns the possible cache file locations of a raw file. The first one is the sidecar file next to the raw
+    * file, the second one is located in the user's cache directory and is used for read-only data directories.
+    *
+    * @param[in] sFileName      The raw fiff file.
+    * @param[in] baKey          The cache key of the raw file.
+    *
+    * @return the cache file names.
+    */
+    static QStringList cacheFileNames(const QString& sFileName, const QByteArray& baKey);
+
+    //=========================================================================================================
+    /**
+    * Selects the coarsest level whose bins are not wider than the requested number of samples per pixel.
+    *
+    * @param[in] dSamplesPerPixel   The number of samples which are drawn to one pixel.
+    *
+    * @return the level index or -1 if the requested resolution is finer than the finest level.
+    */
+    int selectLevel(double dSamplesPerPixel) const;
+
+    //=========================================================================================================
+    /**
+    * Returns the mean of a channel over the whole file.
+    *
+    * @param[in] iChannel   The channel index.
+    *
+    * @return the mean value.
+    */
+    double channelMean(int iChannel) const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of samples which fall into a bin. Only the last bin of every level can be partial.
+    *
+    * @param[in] iLevel     The level index.
+    * @param[in] iBin       The bin index.
+    *
+    * @return the number of samples.
+    */
+    inline qint32 binSize(int iLevel, qint32 iBin) const;
+
+    inline bool isEmpty() const;
+
+    inline int levelCount() const;
+
+    inline const Level& level(int iLevel) const;
+
+    inline qint32 numSamples() const;
+
+    inline qint32 numChannels() const;
+
+private:
+    //=========================================================================================================
+    /**
+    * Appends the next coarser level by merging pairs of bins of the currently coarsest level.
+    */
+    void appendReducedLevel();
+
+    QVector<Level>      m_vecLevels;        /**< The pyramid levels from fine to coarse. */
+    qint32              m_iNumSamples;      /**< Number of samples of the raw file. */
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline qint32 RawOverviewPyramid::binSize(int iLevel, qint32 iBin) const
+{
+    const qint32 iDecimation = m_vecLevels[iLevel].iDecimation;
+    return qMin(iDecimation, m_iNumSamples - iBin*iDecimation);
+}
+
+
+//*************************************************************************************************************
+
+inline bool RawOverviewPyramid::isEmpty() const
+{
+    return m_vecLevels.isEmpty();
+}
+
+
+//*************************************************************************************************************
+
+inline int RawOverviewPyramid::levelCount() const
+{
+    return m_vecLevels.size();
+}
+
+
+//*************************************************************************************************************
+
+inline const RawOverviewPyramid::Level& RawOverviewPyramid::level(int iLevel) const
+{
+    return m_vecLevels[iLevel];
+}
+
+
+//*************************************************************************************************************
+
+inline qint32 RawOverviewPyramid::numSamples() const
+{
+    return m_iNumSamples;
+}
+
+
+//*************************************************************************************************************
+
+inline qint32 RawOverviewPyramid::numChannels() const
+{
+    return m_vecLevels.isEmpty() ? 0 : m_vecLevels.first().matMin.rows();
+}
+
+} // NAMESPACE
+
+#endif // RAWOVERVIEWPYRAMID_H
@@ -82,11 +82,17 @@
 #define MODEL_MAX_WINDOWS 3 //number of windows that are at maximum remained in m_data
 #define MODEL_NUM_FILTER_TAPS 80 //number of filter taps, required to take into account because of FFT convolution (zero padding)
 #define MODEL_MAX_NUM_FILTER_TAPS 0 //number of maximal filter taps
+#define MODEL_CACHE_MAX_WINDOWS 12 //number of loaded (and filtered) windows which are kept in the data cache
+#define MODEL_CACHE_PREFETCH_WINDOWS 2 //number of windows which are prefetched in scrolling direction
+#define MODEL_OVERVIEW_BASE_LEVEL 6 //the finest level of the overview pyramid summarizes 2^x samples per bin
+#define MODEL_OVERVIEW_MIN_BINS 512 //the overview pyramid is reduced until the coarsest level holds less than this number of bins
+#define MODEL_OVERVIEW_BLOCK_SIZE 65536 //number of samples which are read at once while computing the overview pyramid
 
 //RawDelegate
 //Look
 #define DELEGATE_PLOT_HEIGHT 40 //height of a single plot (row)
 #define DELEGATE_DX 1 //each DX pixel a sample is plot -> plot resolution
+#define DELEGATE_MIN_DX (1.0/16384) //smallest DX the view can be zoomed out to
 #define DELEGATE_NHLINES 6 //number of horizontal lines within a single plot (row)
 
 //maximum values for different channels types according to FiffChInfo
@@ -75,6 +75,7 @@ namespace MNEBROWSE
 {
 
 typedef Matrix<double,Dynamic,Dynamic,RowMajor> MatrixXdR;
+typedef Matrix<float,Dynamic,Dynamic,RowMajor> MatrixXfR;
 typedef QPair<const double*,qint32> RowVectorPair;
 typedef QPair<const float*,qint32> RowVectorPairF;
 typedef QPair<int,int> QPairInts;
@@ -391,6 +391,14 @@ void DataWindow::keyPressEvent(QKeyEvent* event)
     if((event->modifiers() == Qt::ControlModifier && event->key() == Qt::Key_D))
         ui->m_tableView_rawTableView->clearSelection();
 
+    //Zoom in and out in time
+    if(event->modifiers() & Qt::ControlModifier) {
+        if(event->key() == Qt::Key_Plus || event->key() == Qt::Key_Equal)
+            zoomTime(2);
+        else if(event->key() == Qt::Key_Minus)
+            zoomTime(0.5);
+    }
+
     return QWidget::keyPressEvent(event);
 }
 
@@ -538,8 +546,8 @@ void DataWindow::setRangeSampleLabels()
 
     //calculate sample range which is currently displayed in the view
     //Note: the viewport holds the width of the area which is changed through scrolling
-    int minSampleRange = ui->m_tableView_rawTableView->horizontalScrollBar()->value()/* + m_pMainWindow->m_pRawModel->firstSample()*/;
-    int maxSampleRange = minSampleRange + ui->m_tableView_rawTableView->viewport()->width();
+    int minSampleRange = ui->m_tableView_rawTableView->horizontalScrollBar()->value()/m_pRawDelegate->m_dDx/* + m_pMainWindow->m_pRawModel->firstSample()*/;
+    int maxSampleRange = minSampleRange + ui->m_tableView_rawTableView->viewport()->width()/m_pRawDelegate->m_dDx;
 
     //Set values as string
     QString stringTemp;
@@ -557,8 +565,8 @@ void DataWindow::setMarkerSampleLabel()
     m_pCurrentDataMarkerLabel->raise();
 
     //Update the text and position in the current sample marker label
-    m_iCurrentMarkerSample = ui->m_tableView_rawTableView->horizontalScrollBar()->value() +
-            (m_pDataMarker->geometry().x() - ui->m_tableView_rawTableView->geometry().x() - ui->m_tableView_rawTableView->verticalHeader()->width());
+    m_iCurrentMarkerSample = (ui->m_tableView_rawTableView->horizontalScrollBar()->value() +
+            (m_pDataMarker->geometry().x() - ui->m_tableView_rawTableView->geometry().x() - ui->m_tableView_rawTableView->verticalHeader()->width()))/m_pRawDelegate->m_dDx;
 
     int currentSeconds = (m_iCurrentMarkerSample/m_pRawModel->m_pFiffInfo->sfreq)*1000;
 
@@ -654,3 +662,30 @@ bool DataWindow::pinchTriggered(QPinchGesture *gesture)
 
     return true;
 }
+
+
+//*************************************************************************************************************
+
+void DataWindow::zoomTime(double factor)
+{
+    double dx = qBound(DELEGATE_MIN_DX, m_pRawDelegate->m_dDx*factor, double(DELEGATE_DX));
+    if(dx == m_pRawDelegate->m_dDx)
+        return;
+
+    QScrollBar* horizontalScrollBar = ui->m_tableView_rawTableView->horizontalScrollBar();
+
+    //Keep the left most visible sample in place
+    double firstSample = horizontalScrollBar->value()/m_pRawDelegate->m_dDx;
+
+    m_pRawDelegate->m_dDx = dx;
+    m_pRawModel->setSamplesPerPixel(1.0/dx);
+
+    ui->m_tableView_rawTableView->resizeColumnToContents(1);
+    horizontalScrollBar->setValue(qRound(firstSample*dx));
+
+    //Make sure full resolution data is loaded for the new position when zooming back in
+    m_pRawModel->updateScrollPos(horizontalScrollBar->value());
+
+    setRangeSampleLabels();
+    ui->m_tableView_rawTableView->viewport()->update();
+}
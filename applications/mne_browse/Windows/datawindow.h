@@ -221,6 +221,15 @@ private:
     */
     bool pinchTriggered(QPinchGesture *gesture);
 
+    //=========================================================================================================
+    /**
+    * zoomTime changes the horizontal zoom of the data view while keeping the left most visible sample in place.
+    * Zoomed out views are drawn from the overview pyramid of the raw model.
+    *
+    * @param[in] factor the factor the pixel distance between two samples is multiplied with.
+    */
+    void zoomTime(double factor);
+
     Ui::DataWindowDockWidget *ui;                   /**< Pointer to the qt designer generated ui class.*/
 
     MainWindow*     m_pMainWindow;                  /**< pointer to the main window (parent). */
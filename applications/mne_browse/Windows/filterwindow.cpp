@@ -281,6 +281,11 @@ void FilterWindow::changeStateSpinBoxes(int currentIndex)
             ui->m_spinBox_filterTaps->setVisible(true);
             ui->m_label_filterTaps->setVisible(true);
             break;
+
+        case 2: //Butterworth
+            ui->m_spinBox_filterTaps->setVisible(false);
+            ui->m_label_filterTaps->setVisible(false);
+            break;
     }
 
     //Change visibility of spin boxes depending on filter type
@@ -365,6 +370,9 @@ void FilterWindow::filterParametersChanged()
     if(ui->m_comboBox_designMethod->currentText() == "Cosine")
         dMethod = FilterOperator::Cosine;
 
+    if(ui->m_comboBox_designMethod->currentText() == "Butterworth")
+        dMethod = FilterOperator::Butterworth;
+
     //Generate filters
     QSharedPointer<MNEOperator> userDefinedFilterOperator;
 
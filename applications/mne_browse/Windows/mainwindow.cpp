@@ -347,6 +347,7 @@ void MainWindow::connectMenus()
     connect(ui->m_openAction, &QAction::triggered, this, &MainWindow::openFile);
     connect(ui->m_writeAction, &QAction::triggered, this, &MainWindow::writeFile);
     connect(ui->m_loadEvents, &QAction::triggered, this, &MainWindow::loadEvents);
+    connect(ui->m_detectEvents, &QAction::triggered, this, &MainWindow::detectEvents);
     connect(ui->m_saveEvents, &QAction::triggered, this, &MainWindow::saveEvents);
     connect(ui->m_loadEvokedAction, &QAction::triggered, this, &MainWindow::loadEvoked);
     connect(ui->m_quitAction, SIGNAL(triggered()), qApp, SLOT(quit()));
@@ -641,6 +642,45 @@ void MainWindow::loadEvents()
 }
 
 
+//*************************************************************************************************************
+
+void MainWindow::detectEvents()
+{
+    if(m_qFileRaw.fileName().isEmpty())
+    {
+        qDebug("No fiff raw data file loaded to detect events in");
+        return;
+    }
+
+    //The index holds all stim channels, the trigger channel is shown if present
+    QString sCacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/events";
+    MNEEventIndex eventIndex;
+
+    if(!MNEEventIndex::build(m_qFileRaw.fileName(), eventIndex, QStringList(), sCacheDir))
+    {
+        qDebug("ERROR detecting events in %s",m_qFileRaw.fileName().toUtf8().data());
+        return;
+    }
+
+    QString sChannel = eventIndex.channelNames().contains("STI 014") ? QString("STI 014") : QString();
+    m_pEventWindow->getEventModel()->setEventData(eventIndex.eventList(sChannel));
+
+    if(m_qEventFile.isOpen())
+        m_qEventFile.close();
+
+    m_qEventFile.setFileName(m_qFileRaw.fileName());
+
+    qDebug() << "Detected" << m_pEventWindow->getEventModel()->rowCount() << "events in" << m_qFileRaw.fileName();
+
+    //Update status bar
+    setWindowStatus();
+
+    //Show event window
+    if(!m_pEventWindow->isVisible())
+        m_pEventWindow->show();
+}
+
+
 //*************************************************************************************************************
 
 void MainWindow::saveEvents()
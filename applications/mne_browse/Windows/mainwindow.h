@@ -100,6 +100,7 @@
 #include <QScroller>
 #include <QTextBrowser>
 #include <QMessageBox>
+#include <QStandardPaths>
 #include <QPixmap>
 #include <QSignalMapper>
 #include <QFutureWatcher>
@@ -114,6 +115,7 @@
 
 #include <fiff/fiff.h>
 #include <mne/mne.h>
+#include <mne/mne_event_index.h>
 
 
 //*************************************************************************************************************
@@ -196,6 +198,12 @@ private:
     */
     void loadEvents();
 
+    //=========================================================================================================
+    /**
+    * detectEvents scans the stim channels of the loaded raw file for events. The event index is cached per raw file.
+    */
+    void detectEvents();
+
     //=========================================================================================================
     /**
     * saveEvents saves the event data to file.
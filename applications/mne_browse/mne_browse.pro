@@ -101,6 +101,8 @@ SOURCES += \
     Windows/scalewindow.cpp \
     Windows/chinfowindow.cpp \
     Utils/datapackage.cpp \    
+    Utils/rawoverviewpyramid.cpp \
+    Utils/rawdatacache.cpp \
     Windows/noisereductionwindow.cpp
 
 HEADERS += \
@@ -129,6 +131,8 @@ HEADERS += \
     Windows/chinfowindow.h \
     Windows/noisereductionwindow.h \
     Utils/datapackage.h \
+    Utils/rawoverviewpyramid.h \
+    Utils/rawdatacache.h \
 
 FORMS += \
     Windows/eventwindowdock.ui \
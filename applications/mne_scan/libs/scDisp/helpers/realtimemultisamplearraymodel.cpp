@@ -35,6 +35,8 @@
 
 #include "realtimemultisamplearraymodel.h"
 
+#include <realtime/rtProcessing/rtpreprocessing.h>
+
 #include <iostream>
 
 #include <QDebug>
@@ -49,6 +51,7 @@
 
 using namespace SCDISPLIB;
 using namespace UTILSLIB;
+using namespace REALTIMELIB;
 
 
 //*************************************************************************************************************
@@ -71,9 +74,11 @@ RealTimeMultiSampleArrayModel::RealTimeMultiSampleArrayModel(QObject *parent)
 , m_iMaxFilterLength(128)
 , m_iCurrentBlockSize(1024)
 , m_iResidual(0)
+, m_iPreprocessingSteps(0)
 , m_bDrawFilterFront(true)
 , m_bTriggerDetectionActive(false)
 , m_dTriggerThreshold(0.01)
+, m_eventDetector(QList<int>(), 0.01, EventDetector::Level, EventDetector::Rising)
 , m_iDistanceTimerSpacer(1000)
 , m_iDetectedTriggers(0)
 , m_iCurrentSampleFreeze(0)
@@ -387,6 +392,9 @@ void RealTimeMultiSampleArrayModel::setSamplingInfo(float sps, int T)
 
     m_iMaxSamples = (qint32)ceil(sps * T);
 
+    //Dead time of the trigger detector follows the sampling rate
+    m_eventDetector.setDeadTimeSec(0.1, sps);
+
     //Resize data matrix without touching the stored values
     m_matDataRaw.conservativeResize(m_pFiffInfo->chs.size(), m_iMaxSamples);
     m_matDataFiltered.conservativeResize(m_pFiffInfo->chs.size(), m_iMaxSamples);
@@ -412,18 +420,38 @@ MatrixXd RealTimeMultiSampleArrayModel::getLastBlock()
 }
 
 
+//*************************************************************************************************************
+
+void RealTimeMultiSampleArrayModel::setPreprocessingSteps(int iSteps)
+{
+    if(iSteps != m_iPreprocessingSteps) {
+        qInfo() << "RealTimeMultiSampleArrayModel::setPreprocessingSteps - Incoming data is already"
+                << (iSteps & RtPreprocessing::Projection ? "projected" : "")
+                << (iSteps & RtPreprocessing::Compensation ? "compensated" : "")
+                << (iSteps & RtPreprocessing::Sphara ? "SPHARA processed" : "")
+                << (iSteps & RtPreprocessing::Filter ? "filtered" : "")
+                << "upstream. The display settings for these steps are not applied a second time.";
+    }
+
+    m_iPreprocessingSteps = iSteps;
+}
+
+
 //*************************************************************************************************************
 
 void RealTimeMultiSampleArrayModel::addData(const QList<MatrixXd> &data)
 {
+    //Steps which were already applied by the producer are skipped, all others follow the display settings
+    bool bFilteredUpstream = m_iPreprocessingSteps & RtPreprocessing::Filter;
+
     //SSP
-    bool doProj = m_bProjActivated && m_matDataRaw.cols() > 0 && m_matDataRaw.rows() == m_matProj.cols() ? true : false;
+    bool doProj = !(m_iPreprocessingSteps & RtPreprocessing::Projection) && m_bProjActivated && m_matDataRaw.cols() > 0 && m_matDataRaw.rows() == m_matProj.cols() ? true : false;
 
     //Compensator
-    bool doComp = m_bCompActivated && m_matDataRaw.cols() > 0 && m_matDataRaw.rows() == m_matComp.cols() ? true : false;
+    bool doComp = !(m_iPreprocessingSteps & RtPreprocessing::Compensation) && m_bCompActivated && m_matDataRaw.cols() > 0 && m_matDataRaw.rows() == m_matComp.cols() ? true : false;
 
     //SPHARA
-    bool doSphara = m_bSpharaActivated && m_matSparseSpharaMult.cols() > 0 && m_matDataRaw.rows() == m_matSparseSpharaMult.cols() ? true : false;
+    bool doSphara = !(m_iPreprocessingSteps & RtPreprocessing::Sphara) && m_bSpharaActivated && m_matSparseSpharaMult.cols() > 0 && m_matDataRaw.rows() == m_matSparseSpharaMult.cols() ? true : false;
 
     //Copy new data into the global data matrix
     for(qint32 b = 0; b < data.size(); ++b) {
@@ -467,6 +495,14 @@ void RealTimeMultiSampleArrayModel::addData(const QList<MatrixXd> &data)
                 }
             }
 
+            if(!m_filterData.isEmpty() && bFilteredUpstream) {
+                m_matDataFiltered.block(0, m_iCurrentSample, nRow, m_iResidual) = m_matDataRaw.block(0, m_iCurrentSample, nRow, m_iResidual);
+
+                if(doSphara) {
+                    m_matDataFiltered.block(0, m_iCurrentSample, nRow, m_iResidual) = m_matSparseSpharaMult * m_matDataFiltered.block(0, m_iCurrentSample, nRow, m_iResidual);
+                }
+            }
+
             m_iCurrentSample = 0;
 
             if(!m_bIsFreezed) {
@@ -510,7 +546,14 @@ void RealTimeMultiSampleArrayModel::addData(const QList<MatrixXd> &data)
         }
 
         //Filter if neccessary else set filtered data matrix to zero
-        if(!m_filterData.isEmpty()) {
+        if(!m_filterData.isEmpty() && bFilteredUpstream) {
+            //The producer already filtered the data, there is no filter delay to account for
+            m_matDataFiltered.block(0, m_iCurrentSample, nRow, nCol) = m_matDataRaw.block(0, m_iCurrentSample, nRow, nCol);
+
+            if(doSphara) {
+                m_matDataFiltered.block(0, m_iCurrentSample, nRow, nCol) = m_matSparseSpharaMult * m_matDataFiltered.block(0, m_iCurrentSample, nRow, nCol);
+            }
+        } else if(!m_filterData.isEmpty()) {
             filterChannelsConcurrently(m_matDataRaw.block(0, m_iCurrentSample, nRow, nCol), m_iCurrentSample);
 
             //Perform SPHARA on filtered data after actual filtering - SPHARA should be applied on the best possible data
@@ -542,8 +585,14 @@ void RealTimeMultiSampleArrayModel::addData(const QList<MatrixXd> &data)
         if(m_bTriggerDetectionActive) {
             int iOldDetectedTriggers = m_qMapDetectedTrigger[m_iCurrentTriggerChIndex].size();
 
-            QList<QPair<int,double> > qMapDetectedTrigger = DetectTrigger::detectTriggerFlanksMax(data.at(b), m_iCurrentTriggerChIndex, m_iCurrentSample-nCol, m_dTriggerThreshold, true);
-            //QList<QPair<int,double> > qMapDetectedTrigger = DetectTrigger::detectTriggerFlanksGrad(data.at(b), m_iCurrentTriggerChIndex, m_iCurrentSample-nCol, m_dTriggerThreshold, false, "Rising");
+            //The detector counts samples continuously, map its events to the position in the display buffer
+            qint64 iBlockStart = m_eventDetector.nextSample();
+            QVector<DetectedEvent> vecEvents = m_eventDetector.detect(data.at(b));
+
+            QList<QPair<int,double> > qMapDetectedTrigger;
+            for(int i = 0; i < vecEvents.size(); ++i) {
+                qMapDetectedTrigger.append(QPair<int,double>(m_iCurrentSample - nCol + static_cast<int>(vecEvents.at(i).iSample - iBlockStart), vecEvents.at(i).dAfter));
+            }
 
             //Append results to already found triggers
             m_qMapDetectedTrigger[m_iCurrentTriggerChIndex].append(qMapDetectedTrigger);
@@ -1053,6 +1102,7 @@ void RealTimeMultiSampleArrayModel::triggerInfoChanged(const QMap<double, QColor
     m_qMapTriggerColor = colorMap;
     m_bTriggerDetectionActive = active;    
     m_dTriggerThreshold = threshold;
+    m_eventDetector.setThreshold(threshold);
 
     //Find channel index and initialise detected trigger map if channel name changed
     if(m_sCurrentTriggerCh != triggerCh) {
@@ -1065,6 +1115,7 @@ void RealTimeMultiSampleArrayModel::triggerInfoChanged(const QMap<double, QColor
             if(m_pFiffInfo->chs[i].ch_name == m_sCurrentTriggerCh) {
                 m_iCurrentTriggerChIndex = i;
                 m_qMapDetectedTrigger.insert(i, temp);
+                m_eventDetector.setChannels(QList<int>() << i);
                 break;
             }
         }
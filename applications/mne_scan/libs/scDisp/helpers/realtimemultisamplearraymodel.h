@@ -48,7 +48,7 @@
 
 #include <utils/filterTools/filterdata.h>
 #include <utils/mnemath.h>
-#include <utils/detecttrigger.h>
+#include <utils/eventdetector.h>
 #include <utils/ioutils.h>
 #include <utils/filterTools/sphara.h>
 
@@ -201,6 +201,16 @@ public:
     */
     void addData(const QList<MatrixXd> &data);
 
+    //=========================================================================================================
+    /**
+    * Sets the processing steps (REALTIMELIB::RtPreprocessing::ProcessingStep flags) the producer already applied
+    * to the incoming data. Only these steps are skipped by this model, all other projection, compensator, SPHARA
+    * and filter settings of the display are still applied.
+    *
+    * @param[in] iSteps     The applied steps, 0 if the incoming data is raw.
+    */
+    void setPreprocessingSteps(int iSteps);
+
     //=========================================================================================================
     /**
     * Returns the kind of a given channel number
@@ -556,6 +566,7 @@ private:
     qint32                              m_iMaxFilterLength;                         /**< Max order of the current filters */
     qint32                              m_iCurrentBlockSize;                        /**< Current block size */
     qint32                              m_iResidual;                                /**< Current amount of samples which were to size */
+    int                                 m_iPreprocessingSteps;                      /**< Processing steps already applied upstream to the incoming data, 0 if raw */
     int                                 m_iCurrentTriggerChIndex;                   /**< The index of the current trigger channel */
     int                                 m_iDistanceTimerSpacer;                     /**< The distance for the horizontal time spacers in the view in ms */
     int                                 m_iDetectedTriggers;                        /**< Detected triggers since the last reset */
@@ -598,6 +609,7 @@ private:
     QMap<double, QColor>                m_qMapTriggerColor;                         /**< Current colors for all trigger channels. */
     QMap<int,QList<QPair<int,double> > >m_qMapDetectedTrigger;                      /**< Detected trigger for each trigger channel. */
     QList<int>                          m_lTriggerChannelIndices;                   /**< List of all trigger channel indices. */
+    UTILSLIB::EventDetector             m_eventDetector;                            /**< Detector of the current trigger channel, keeps its state across the incoming blocks. */
     QMap<int,QList<QPair<int,double> > >m_qMapDetectedTriggerFreeze;                /**< Detected trigger for each trigger channel while display is freezed. */
     QMap<int,QList<QPair<int,double> > >m_qMapDetectedTriggerOld;                   /**< Old detected trigger for each trigger channel. */
     QMap<int,QList<QPair<int,double> > >m_qMapDetectedTriggerOldFreeze;             /**< Old detected trigger for each trigger channel while display is freezed. */
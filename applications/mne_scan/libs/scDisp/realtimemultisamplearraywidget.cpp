@@ -173,6 +173,11 @@ RealTimeMultiSampleArrayWidget::RealTimeMultiSampleArrayWidget(QSharedPointer<Ne
 
     qRegisterMetaType<QMap<int,QList<QPair<int,double> > > >();
 
+    //Receive the frames through an own bounded queue, the display drops the oldest frames if it falls behind
+    m_pFrameQueue = m_pRTMSA->subscribe();
+    connect(this, &RealTimeMultiSampleArrayWidget::wakeUpRequested,
+            this, &RealTimeMultiSampleArrayWidget::update, Qt::QueuedConnection);
+
     init();
 }
 
@@ -257,10 +262,28 @@ void RealTimeMultiSampleArrayWidget::broadcastScaling(QMap<qint32,float> scaleMa
 }
 
 
+//*************************************************************************************************************
+
+void RealTimeMultiSampleArrayWidget::wakeUp(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
+{
+    if(m_pFrameQueue->requestWakeUp()) {
+        emit wakeUpRequested(pMeasurement);
+    }
+}
+
+
 //*************************************************************************************************************
 
 void RealTimeMultiSampleArrayWidget::update(SCMEASLIB::NewMeasurement::SPtr)
 {
+    m_pFrameQueue->acknowledgeWakeUp();
+
+    QList<MeasurementFrame::ConstSPtr> lFrames = m_pFrameQueue->takeAll();
+
+    if(lFrames.isEmpty()) {
+        return;
+    }
+
     if(!m_bInitialized)
     {
         if(m_pRTMSA->isChInit())
@@ -272,7 +295,7 @@ void RealTimeMultiSampleArrayWidget::update(SCMEASLIB::NewMeasurement::SPtr)
 
             m_fSamplingRate = m_pRTMSA->getSamplingRate();
 
-            m_iMaxFilterTapSize = m_pRTMSA->getMultiSampleArray().at(m_pRTMSA->getMultiSampleArray().size()-1).cols();
+            m_iMaxFilterTapSize = lFrames.last()->data().cols();
 
             //Check what modalities are there for 3D sensor interpolation
             if(m_bVisualize3DSensorData) {
@@ -303,7 +326,13 @@ void RealTimeMultiSampleArrayWidget::update(SCMEASLIB::NewMeasurement::SPtr)
         }
     } else {
         //Add data to table view
-        m_pRTMSAModel->addData(m_pRTMSA->getMultiSampleArray());
+        m_pRTMSAModel->setPreprocessingSteps(m_pRTMSA->getPreprocessingSteps());
+        QList<MatrixXd> lData;
+        for(int i = 0; i < lFrames.size(); ++i) {
+            lData.append(lFrames.at(i)->data());
+        }
+
+        m_pRTMSAModel->addData(lData);
 
         //Add data to 3D interpolation
         if(m_bVisualize3DSensorData) {
@@ -338,8 +367,8 @@ void RealTimeMultiSampleArrayWidget::update(SCMEASLIB::NewMeasurement::SPtr)
                     m_pRtEEGSensorDataItem->setSFreq(m_pRTMSA->info()->sfreq);
                 }
 
-                for(int i = 1; i < m_pRTMSA->getMultiSampleArray().size(); ++i) {
-                    m_pRtEEGSensorDataItem->addData(m_pRTMSA->getMultiSampleArray().at(i));
+                for(int i = 1; i < lData.size(); ++i) {
+                    m_pRtEEGSensorDataItem->addData(lData.at(i));
                 }
             } else if (m_pRtEEGSensorDataItem && m_slAvailableModalities.contains("EEG"))  {
                 m_pRtEEGSensorDataItem->addData(data);
@@ -366,8 +395,8 @@ void RealTimeMultiSampleArrayWidget::update(SCMEASLIB::NewMeasurement::SPtr)
                     m_pRtMEGSensorDataItem->setSFreq(m_pRTMSA->info()->sfreq);
                 }
 
-                for(int i = 1; i < m_pRTMSA->getMultiSampleArray().size(); ++i) {
-                    m_pRtMEGSensorDataItem->addData(m_pRTMSA->getMultiSampleArray().at(i));
+                for(int i = 1; i < lData.size(); ++i) {
+                    m_pRtMEGSensorDataItem->addData(lData.at(i));
                 }
             } else if (m_pRtMEGSensorDataItem && m_slAvailableModalities.contains("MEG")) {
                 m_pRtMEGSensorDataItem->addData(data);
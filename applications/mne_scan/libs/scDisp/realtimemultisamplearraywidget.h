@@ -194,6 +194,15 @@ public:
     virtual void init();
 
 public slots:
+    //=========================================================================================================
+    /**
+    * Is called on the producer's thread when new frames were published. Schedules a queued update() unless one is
+    * already pending, so a busy display never blocks the producer.
+    *
+    * @param [in] pMeasurement  pointer to measurement.
+    */
+    void wakeUp(SCMEASLIB::NewMeasurement::SPtr pMeasurement);
+
     //=========================================================================================================
     /**
     * Show channel context menu
@@ -292,6 +301,12 @@ signals:
     */
     void fiffFileUpdated(const FiffInfo&);
 
+    //=========================================================================================================
+    /**
+    * Emitted by wakeUp() on the producer's thread and delivered queued to update().
+    */
+    void wakeUpRequested(SCMEASLIB::NewMeasurement::SPtr pMeasurement);
+
     //=========================================================================================================
     /**
     * samplingRateChanged is emitted whenever the sampling rate is changed
@@ -421,6 +436,7 @@ private:
     QuickControlWidget::SPtr                    m_pQuickControlWidget;          /**< quick control widget. */
     ChInfoModel::SPtr                           m_pChInfoModel;                 /**< channel info model. */
     NewRealTimeMultiSampleArray::SPtr           m_pRTMSA;                       /**< The real-time sample array measurement. */
+    MeasurementFrameQueue::SPtr                 m_pFrameQueue;                  /**< The frames published by the measurement, drained by update(). */
     SelectionManagerWindow::SPtr                m_pSelectionManagerWindow;      /**< SelectionManagerWindow. */
     FilterWindow::SPtr                          m_pFilterWindow;                /**< Filter window. */
 
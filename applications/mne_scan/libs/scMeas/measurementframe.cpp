@@ -0,0 +1,271 @@
+//=============================================================================================================
+/**
+* @file     measurementframe.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     Definition of the MeasurementFrame and MeasurementFrameQueue classes.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "measurementframe.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QAtomicInteger>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace SCMEASLIB;
+using namespace Eigen;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+MeasurementFrame::MeasurementFrame(const MatrixXd& matData, quint64 iSequenceNumber, qint64 iTimestamp, quint64 iFrameId, qint64 iAcquisitionTime)
+: m_matData(matData)
+, m_iSequenceNumber(iSequenceNumber)
+, m_iTimestamp(iTimestamp)
+, m_iFrameId(iFrameId)
+, m_iAcquisitionTime(iAcquisitionTime)
+{
+}
+
+
+//*************************************************************************************************************
+
+qint64 MeasurementFrame::currentTimeUs()
+{
+    struct Clock {
+        Clock() { m_timer.start(); }
+        QElapsedTimer m_timer;
+    };
+
+    static const Clock s_clock;
+    return s_clock.m_timer.nsecsElapsed() / 1000;
+}
+
+
+//*************************************************************************************************************
+
+quint64 MeasurementFrame::nextFrameId()
+{
+    static QAtomicInteger<quint64> s_iNextFrameId(0);
+    return s_iNextFrameId.fetchAndAddRelaxed(1);
+}
+
+
+//*************************************************************************************************************
+
+MeasurementFrameQueue::MeasurementFrameQueue(int iCapacity, OverflowPolicy policy)
+: m_iCapacity(qMax(1, iCapacity))
+, m_overflowPolicy(policy)
+, m_bReleasePop(false)
+, m_iDroppedFrames(0)
+, m_iWakeUpPending(0)
+{
+}
+
+
+//*************************************************************************************************************
+
+bool MeasurementFrameQueue::push(const MeasurementFrame::ConstSPtr& pFrame)
+{
+    QMutexLocker locker(&m_qMutex);
+
+    if(m_qQueueFrames.size() < m_iCapacity) {
+        m_qQueueFrames.enqueue(pFrame);
+        m_qWaitFrames.wakeOne();
+        return true;
+    }
+
+    ++m_iDroppedFrames;
+
+    if(m_overflowPolicy == DropOldest) {
+        m_qQueueFrames.dequeue();
+        m_qQueueFrames.enqueue(pFrame);
+        m_qWaitFrames.wakeOne();
+    }
+
+    return false;
+}
+
+
+//*************************************************************************************************************
+
+QList<MeasurementFrame::ConstSPtr> MeasurementFrameQueue::takeAll()
+{
+    QList<MeasurementFrame::ConstSPtr> lFrames;
+
+    QMutexLocker locker(&m_qMutex);
+    lFrames.swap(m_qQueueFrames);
+
+    return lFrames;
+}
+
+
+//*************************************************************************************************************
+
+MeasurementFrame::ConstSPtr MeasurementFrameQueue::pop()
+{
+    QMutexLocker locker(&m_qMutex);
+
+    while(m_qQueueFrames.isEmpty() && !m_bReleasePop) {
+        m_qWaitFrames.wait(&m_qMutex);
+    }
+
+    if(m_qQueueFrames.isEmpty()) {
+        m_bReleasePop = false;
+        return MeasurementFrame::ConstSPtr();
+    }
+
+    return m_qQueueFrames.dequeue();
+}
+
+
+//*************************************************************************************************************
+
+void MeasurementFrameQueue::releaseFromPop()
+{
+    QMutexLocker locker(&m_qMutex);
+    m_bReleasePop = true;
+    m_qWaitFrames.wakeAll();
+}
+
+
+//*************************************************************************************************************
+
+bool MeasurementFrameQueue::requestWakeUp()
+{
+    return m_iWakeUpPending.testAndSetOrdered(0, 1);
+}
+
+
+//*************************************************************************************************************
+
+void MeasurementFrameQueue::acknowledgeWakeUp()
+{
+    m_iWakeUpPending.storeRelease(0);
+}
+
+
+//*************************************************************************************************************
+
+void MeasurementFrameQueue::clear()
+{
+    QMutexLocker locker(&m_qMutex);
+    m_qQueueFrames.clear();
+}
+
+
+//*************************************************************************************************************
+
+void MeasurementFrameQueue::setCapacity(int iCapacity)
+{
+    QMutexLocker locker(&m_qMutex);
+    m_iCapacity = qMax(1, iCapacity);
+    trim(m_iCapacity);
+}
+
+
+//*************************************************************************************************************
+
+int MeasurementFrameQueue::capacity() const
+{
+    QMutexLocker locker(&m_qMutex);
+    return m_iCapacity;
+}
+
+
+//*************************************************************************************************************
+
+void MeasurementFrameQueue::setOverflowPolicy(OverflowPolicy policy)
+{
+    QMutexLocker locker(&m_qMutex);
+    m_overflowPolicy = policy;
+}
+
+
+//*************************************************************************************************************
+
+MeasurementFrameQueue::OverflowPolicy MeasurementFrameQueue::overflowPolicy() const
+{
+    QMutexLocker locker(&m_qMutex);
+    return m_overflowPolicy;
+}
+
+
+//*************************************************************************************************************
+
+int MeasurementFrameQueue::size() const
+{
+    QMutexLocker locker(&m_qMutex);
+    return m_qQueueFrames.size();
+}
+
+
+//*************************************************************************************************************
+
+qint64 MeasurementFrameQueue::droppedFrames() const
+{
+    QMutexLocker locker(&m_qMutex);
+    return m_iDroppedFrames;
+}
+
+
+//*************************************************************************************************************
+
+void MeasurementFrameQueue::trim(int iCapacity)
+{
+    while(m_qQueueFrames.size() > iCapacity) {
+        if(m_overflowPolicy == DropOldest) {
+            m_qQueueFrames.removeFirst();
+        } else {
+            m_qQueueFrames.removeLast();
+        }
+        ++m_iDroppedFrames;
+    }
+}
@@ -0,0 +1,374 @@
+//=============================================================================================================
+/**
+* @file     measurementframe.h
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     Declaration of the MeasurementFrame and MeasurementFrameQueue classes.
+*
+*/
+
+#ifndef MEASUREMENTFRAME_H
+#define MEASUREMENTFRAME_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "scmeas_global.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QSharedPointer>
+#include <QList>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE SCMEASLIB
+//=============================================================================================================
+
+namespace SCMEASLIB
+{
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINES
+//=============================================================================================================
+
+#define MEASUREMENT_FRAME_QUEUE_DEFAULT_CAPACITY 64
+
+
+//=========================================================================================================
+/**
+* A MeasurementFrame holds one data block published by a measurement. Frames are immutable once created and are
+* handed around as shared pointers to const, so all consumers of a measurement read the same copy of the data.
+* Besides its place in the measurement, a frame carries the id and the acquisition time the sensor plugin stamped
+* on the acquired block. Blocks derived from it by the processing plugins keep both, so a block can be followed
+* through the pipeline. All times are taken from the monotonic clock currentTimeUs().
+*
+* @brief Immutable, reference counted data block with sequence number and time stamps.
+*/
+class SCMEASSHARED_EXPORT MeasurementFrame
+{
+public:
+    typedef QSharedPointer<const MeasurementFrame> ConstSPtr;   /**< Const shared pointer type for MeasurementFrame. */
+
+    //=========================================================================================================
+    /**
+    * Constructs a MeasurementFrame.
+    *
+    * @param[in] matData            the data block (channels x samples), which is copied once into the frame.
+    * @param[in] iSequenceNumber    the running number of the frame within its measurement.
+    * @param[in] iTimestamp         the time the frame was published in us of currentTimeUs().
+    * @param[in] iFrameId           the id the sensor plugin stamped on the acquired block, see nextFrameId().
+    * @param[in] iAcquisitionTime   the time the sensor plugin acquired the block in us of currentTimeUs().
+    */
+    MeasurementFrame(const Eigen::MatrixXd& matData, quint64 iSequenceNumber, qint64 iTimestamp, quint64 iFrameId, qint64 iAcquisitionTime);
+
+    //=========================================================================================================
+    /**
+    * Returns the current time of the monotonic clock all frame and trace times refer to.
+    *
+    * @return the time in us since the clock was first used.
+    */
+    static qint64 currentTimeUs();
+
+    //=========================================================================================================
+    /**
+    * Returns a new application wide unique frame id. Sensor plugins stamp it on every acquired block.
+    *
+    * @return the frame id.
+    */
+    static quint64 nextFrameId();
+
+    //=========================================================================================================
+    /**
+    * Returns the data block.
+    *
+    * @return the data block (channels x samples).
+    */
+    inline const Eigen::MatrixXd& data() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the sequence number. Gaps in the sequence numbers seen by a consumer indicate dropped frames.
+    *
+    * @return the running number of the frame within its measurement.
+    */
+    inline quint64 sequenceNumber() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the time stamp.
+    *
+    * @return the time the frame was published in us of currentTimeUs().
+    */
+    inline qint64 timestamp() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the frame id, which is the same for the acquired block and all blocks derived from it.
+    *
+    * @return the id the sensor plugin stamped on the acquired block.
+    */
+    inline quint64 frameId() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the acquisition time, which is the same for the acquired block and all blocks derived from it.
+    *
+    * @return the time the sensor plugin acquired the block in us of currentTimeUs().
+    */
+    inline qint64 acquisitionTime() const;
+
+private:
+    const Eigen::MatrixXd   m_matData;              /**< The data block. */
+    const quint64           m_iSequenceNumber;      /**< The running number of the frame. */
+    const qint64            m_iTimestamp;           /**< The publishing time in us. */
+    const quint64           m_iFrameId;             /**< The id of the acquired block. */
+    const qint64            m_iAcquisitionTime;     /**< The acquisition time of the block in us. */
+};
+
+
+//=========================================================================================================
+/**
+* A MeasurementFrameQueue is the bounded fan-out queue between a measurement and one consumer. The producer never
+* blocks on a full queue; frames are dropped according to the overflow policy instead. The queue also keeps track of
+* whether the consumer has already been woken up, so that a slow consumer is notified once per batch of pending
+* frames rather than once per frame.
+*
+* @brief Bounded, non-blocking queue of measurement frames.
+*/
+class SCMEASSHARED_EXPORT MeasurementFrameQueue
+{
+public:
+    typedef QSharedPointer<MeasurementFrameQueue> SPtr;               /**< Shared pointer type for MeasurementFrameQueue. */
+    typedef QSharedPointer<const MeasurementFrameQueue> ConstSPtr;    /**< Const shared pointer type for MeasurementFrameQueue. */
+
+    enum OverflowPolicy {
+        DropOldest,     /**< Discard the oldest queued frame to make room, the consumer always sees the most recent data. */
+        DropNewest      /**< Discard the incoming frame, the consumer sees a contiguous run of old data. */
+    };
+
+    //=========================================================================================================
+    /**
+    * Constructs a MeasurementFrameQueue.
+    *
+    * @param[in] iCapacity      the maximum number of queued frames.
+    * @param[in] policy         what to do with frames which arrive while the queue is full.
+    */
+    explicit MeasurementFrameQueue(int iCapacity = MEASUREMENT_FRAME_QUEUE_DEFAULT_CAPACITY, OverflowPolicy policy = DropOldest);
+
+    //=========================================================================================================
+    /**
+    * Queues a frame. Never blocks the caller.
+    *
+    * @param[in] pFrame     the frame to queue.
+    *
+    * @return false if a frame had to be dropped.
+    */
+    bool push(const MeasurementFrame::ConstSPtr& pFrame);
+
+    //=========================================================================================================
+    /**
+    * Removes and returns all queued frames.
+    *
+    * @return the queued frames in the order they were published.
+    */
+    QList<MeasurementFrame::ConstSPtr> takeAll();
+
+    //=========================================================================================================
+    /**
+    * Removes and returns the oldest frame. Blocks until a frame is queued or releaseFromPop() is called. Used by
+    * plugins which buffer the frames of their input for their own processing thread and thus keep the frame
+    * instead of copying its data.
+    *
+    * @return the oldest frame, or an empty pointer if the queue was released.
+    */
+    MeasurementFrame::ConstSPtr pop();
+
+    //=========================================================================================================
+    /**
+    * Releases a pop() which waits on an empty queue, e.g. when the processing thread is stopped. The next pop()
+    * on an empty queue returns an empty pointer right away.
+    */
+    void releaseFromPop();
+
+    //=========================================================================================================
+    /**
+    * Marks a notification of the consumer as pending. Producers call this after publishing and only notify the
+    * consumer if it returns true, i.e. if no notification is pending since the last acknowledgeWakeUp().
+    *
+    * @return true if the consumer needs to be notified.
+    */
+    bool requestWakeUp();
+
+    //=========================================================================================================
+    /**
+    * Clears the pending notification. Consumers call this when they are woken up, before they take the frames, so
+    * that frames published from then on trigger a new notification.
+    */
+    void acknowledgeWakeUp();
+
+    //=========================================================================================================
+    /**
+    * Discards all queued frames.
+    */
+    void clear();
+
+    //=========================================================================================================
+    /**
+    * Sets the capacity. Surplus frames are dropped according to the overflow policy.
+    *
+    * @param[in] iCapacity      the maximum number of queued frames.
+    */
+    void setCapacity(int iCapacity);
+
+    //=========================================================================================================
+    /**
+    * Returns the capacity.
+    *
+    * @return the maximum number of queued frames.
+    */
+    int capacity() const;
+
+    //=========================================================================================================
+    /**
+    * Sets the overflow policy.
+    *
+    * @param[in] policy     what to do with frames which arrive while the queue is full.
+    */
+    void setOverflowPolicy(OverflowPolicy policy);
+
+    //=========================================================================================================
+    /**
+    * Returns the overflow policy.
+    *
+    * @return the overflow policy.
+    */
+    OverflowPolicy overflowPolicy() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of queued frames.
+    *
+    * @return the number of queued frames.
+    */
+    int size() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of frames dropped because the queue was full.
+    *
+    * @return the number of dropped frames.
+    */
+    qint64 droppedFrames() const;
+
+private:
+    //=========================================================================================================
+    /**
+    * Drops frames until the queue holds no more than iCapacity frames. The mutex has to be locked.
+    *
+    * @param[in] iCapacity      the number of frames to keep.
+    */
+    void trim(int iCapacity);
+
+    mutable QMutex                          m_qMutex;           /**< Guards the queue and the settings. */
+    QWaitCondition                          m_qWaitFrames;      /**< Wakes pop() when frames are queued or the queue is released. */
+    QQueue<MeasurementFrame::ConstSPtr>     m_qQueueFrames;     /**< The queued frames. */
+    int                                     m_iCapacity;        /**< The maximum number of queued frames. */
+    OverflowPolicy                          m_overflowPolicy;   /**< What to do with frames which arrive while the queue is full. */
+    bool                                    m_bReleasePop;      /**< Whether the next pop() on an empty queue returns right away. */
+    qint64                                  m_iDroppedFrames;   /**< Number of dropped frames. */
+    QAtomicInt                              m_iWakeUpPending;   /**< 1 if a notification of the consumer is pending. */
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline const Eigen::MatrixXd& MeasurementFrame::data() const
+{
+    return m_matData;
+}
+
+
+//*************************************************************************************************************
+
+inline quint64 MeasurementFrame::sequenceNumber() const
+{
+    return m_iSequenceNumber;
+}
+
+
+//*************************************************************************************************************
+
+inline qint64 MeasurementFrame::timestamp() const
+{
+    return m_iTimestamp;
+}
+
+
+//*************************************************************************************************************
+
+inline quint64 MeasurementFrame::frameId() const
+{
+    return m_iFrameId;
+}
+
+
+//*************************************************************************************************************
+
+inline qint64 MeasurementFrame::acquisitionTime() const
+{
+    return m_iAcquisitionTime;
+}
+
+} // NAMESPACE
+
+#endif // MEASUREMENTFRAME_H
@@ -69,6 +69,9 @@ NewRealTimeMultiSampleArray::NewRealTimeMultiSampleArray(QObject *parent)
 , m_dSamplingRate(0)
 , m_iMultiArraySize(10)
 , m_bChInfoIsInit(false)
+, m_iPreprocessingVersion(-1)
+, m_iPreprocessingSteps(0)
+, m_iSequenceNumber(0)
 {
     m_slDisplayFlag << "compensators" << "projections" << "filter" << "view" << "triggerdetection" << "scaling" << "sphara" << "colors";
 }
@@ -239,6 +242,28 @@ void NewRealTimeMultiSampleArray::initFromFiffInfo(FiffInfo::SPtr &p_pFiffInfo)
 //*************************************************************************************************************
 
 void NewRealTimeMultiSampleArray::setValue(const MatrixXd& mat)
+{
+    //The block is acquired now, stamp it once so that every block derived from it can be traced back to it
+    publishFrame(mat, MeasurementFrame::nextFrameId(), MeasurementFrame::currentTimeUs());
+}
+
+
+//*************************************************************************************************************
+
+void NewRealTimeMultiSampleArray::setValue(const MatrixXd& mat, const MeasurementFrame::ConstSPtr& pSourceFrame)
+{
+    if(!pSourceFrame) {
+        setValue(mat);
+        return;
+    }
+
+    publishFrame(mat, pSourceFrame->frameId(), pSourceFrame->acquisitionTime());
+}
+
+
+//*************************************************************************************************************
+
+void NewRealTimeMultiSampleArray::publishFrame(const MatrixXd& mat, quint64 iFrameId, qint64 iAcquisitionTime)
 {
     if(!m_bChInfoIsInit)
         return;
@@ -256,20 +281,103 @@ void NewRealTimeMultiSampleArray::setValue(const MatrixXd& mat)
 //        else if(v[i] > m_qListChInfo[i].getMaxValue()) v[i] = m_qListChInfo[i].getMaxValue();
 //    }
 
-    //Store
-    m_matSamples.push_back(mat);
+    //Store - the block is copied once into an immutable frame which is shared by all consumers
+    MeasurementFrame::ConstSPtr pFrame(new MeasurementFrame(mat, m_iSequenceNumber++, MeasurementFrame::currentTimeUs(), iFrameId, iAcquisitionTime));
+    m_qListFrames.push_back(pFrame);
+
+    //Fan out to the subscribed queues, drop the ones which are no longer referenced
+    for(int i = m_qListSubscribers.size() - 1; i >= 0; --i) {
+        MeasurementFrameQueue::SPtr pQueue = m_qListSubscribers.at(i).toStrongRef();
+        if(pQueue) {
+            pQueue->push(pFrame);
+        } else {
+            m_qListSubscribers.removeAt(i);
+        }
+    }
 
+    bool bNotify = m_qListFrames.size() >= m_iMultiArraySize;
     m_qMutex.unlock();
-    if(m_matSamples.size() >= m_iMultiArraySize)
+
+    if(bNotify)
     {
         emit notify();
         m_qMutex.lock();
-        m_matSamples.clear();
+        m_qListFrames.clear();
         m_qMutex.unlock();
     }
 }
 
 
+//*************************************************************************************************************
+
+QList< MatrixXd > NewRealTimeMultiSampleArray::getMultiSampleArray() const
+{
+    QMutexLocker locker(&m_qMutex);
+
+    QList< MatrixXd > matSamples;
+    for(int i = 0; i < m_qListFrames.size(); ++i) {
+        matSamples.append(m_qListFrames.at(i)->data());
+    }
+
+    return matSamples;
+}
+
+
+//*************************************************************************************************************
+
+QList<MeasurementFrame::ConstSPtr> NewRealTimeMultiSampleArray::getFrames() const
+{
+    QMutexLocker locker(&m_qMutex);
+    return m_qListFrames;
+}
+
+
+//*************************************************************************************************************
+
+MeasurementFrameQueue::SPtr NewRealTimeMultiSampleArray::subscribe(int iCapacity, MeasurementFrameQueue::OverflowPolicy policy)
+{
+    MeasurementFrameQueue::SPtr pQueue(new MeasurementFrameQueue(iCapacity, policy));
+    subscribe(pQueue);
+
+    return pQueue;
+}
+
+
+//*************************************************************************************************************
+
+void NewRealTimeMultiSampleArray::subscribe(const MeasurementFrameQueue::SPtr& pQueue)
+{
+    if(!pQueue) {
+        return;
+    }
+
+    QMutexLocker locker(&m_qMutex);
+
+    for(int i = 0; i < m_qListSubscribers.size(); ++i) {
+        if(m_qListSubscribers.at(i).toStrongRef() == pQueue) {
+            return;
+        }
+    }
+
+    m_qListSubscribers.append(pQueue.toWeakRef());
+}
+
+
+//*************************************************************************************************************
+
+void NewRealTimeMultiSampleArray::unsubscribe(const MeasurementFrameQueue::SPtr& pQueue)
+{
+    QMutexLocker locker(&m_qMutex);
+
+    for(int i = m_qListSubscribers.size() - 1; i >= 0; --i) {
+        MeasurementFrameQueue::SPtr pSubscriber = m_qListSubscribers.at(i).toStrongRef();
+        if(!pSubscriber || pSubscriber == pQueue) {
+            m_qListSubscribers.removeAt(i);
+        }
+    }
+}
+
+
 //*************************************************************************************************************
 
 //void NewRealTimeMultiSampleArray::setValue(MatrixXd& v)
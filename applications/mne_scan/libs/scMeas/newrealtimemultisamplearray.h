@@ -45,6 +45,7 @@
 #include "scmeas_global.h"
 #include "newmeasurement.h"
 #include "realtimesamplearraychinfo.h"
+#include "measurementframe.h"
 
 #include <fiff/fiff_info.h>
 
@@ -55,6 +56,7 @@
 //=============================================================================================================
 
 #include <QSharedPointer>
+#include <QWeakPointer>
 #include <QVector>
 #include <QList>
 #include <QMutex>
@@ -223,20 +225,105 @@ public:
 
     //=========================================================================================================
     /**
-    * Returns the gathered multi sample array.
+    * Sets the operator version of the preprocessing which was already applied to the data by the producer,
+    * e.g. RtPreprocessing. It changes whenever the producer's operators change.
+    *
+    * @param[in] iVersion   The preprocessing operator version, -1 if the data is raw.
+    */
+    inline void setPreprocessingVersion(qint64 iVersion);
+
+    //=========================================================================================================
+    /**
+    * Returns the operator version of the preprocessing which was already applied to the data.
+    *
+    * @return the preprocessing operator version, -1 if the data is raw.
+    */
+    inline qint64 getPreprocessingVersion() const;
+
+    //=========================================================================================================
+    /**
+    * Sets the processing steps which were already applied to the data by the producer, e.g. the
+    * RtPreprocessing::ProcessingStep flags. Consumers only skip the steps set here and still apply
+    * their own settings for all others.
+    *
+    * @param[in] iSteps     The applied steps, 0 if the data is raw.
+    */
+    inline void setPreprocessingSteps(int iSteps);
+
+    //=========================================================================================================
+    /**
+    * Returns the processing steps which were already applied to the data by the producer.
+    *
+    * @return the applied steps, 0 if the data is raw.
+    */
+    inline int getPreprocessingSteps() const;
+
+    //=========================================================================================================
+    /**
+    * Returns a copy of the gathered multi sample array. Only valid while the notify() signal is processed.
+    * Consumers which run asynchronously should use a frame queue obtained by subscribe() instead.
     *
     * @return the current multi sample array.
     */
-    inline const QList< MatrixXd >& getMultiSampleArray();
+    QList< MatrixXd > getMultiSampleArray() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the frames gathered since the last notify(). Only valid while the notify() signal is processed.
+    *
+    * @return the current frames.
+    */
+    QList<MeasurementFrame::ConstSPtr> getFrames() const;
+
+    //=========================================================================================================
+    /**
+    * Creates a frame queue which receives every frame published by setValue() from now on. The measurement only
+    * holds a weak reference, the subscription ends when the last reference to the queue is released.
+    *
+    * @param[in] iCapacity      the maximum number of queued frames.
+    * @param[in] policy         what to do with frames which arrive while the queue is full.
+    *
+    * @return the new frame queue.
+    */
+    MeasurementFrameQueue::SPtr subscribe(int iCapacity = MEASUREMENT_FRAME_QUEUE_DEFAULT_CAPACITY,
+                                          MeasurementFrameQueue::OverflowPolicy policy = MeasurementFrameQueue::DropOldest);
+
+    //=========================================================================================================
+    /**
+    * Adds an existing frame queue to the subscribers, e.g. the queue a plugin input keeps for this measurement.
+    * The measurement only holds a weak reference.
+    *
+    * @param[in] pQueue     the frame queue which receives the published frames.
+    */
+    void subscribe(const MeasurementFrameQueue::SPtr& pQueue);
+
+    //=========================================================================================================
+    /**
+    * Removes a frame queue from the subscribers.
+    *
+    * @param[in] pQueue     the frame queue to remove.
+    */
+    void unsubscribe(const MeasurementFrameQueue::SPtr& pQueue);
 
     //=========================================================================================================
     /**
-    * Attaches a value to the sample array list.
+    * Attaches a newly acquired value to the sample array list. The block is stamped with a new frame id and the
+    * current time as its acquisition time, this is the overload sensor plugins use.
     *
     * @param [in] mat   the value which is attached to the sample array list.
     */
     virtual void setValue(const MatrixXd& mat);
 
+    //=========================================================================================================
+    /**
+    * Attaches a value derived from an input frame to the sample array list. The block keeps the frame id and the
+    * acquisition time of the input frame, so it can be traced back to the acquired block.
+    *
+    * @param [in] mat           the value which is attached to the sample array list.
+    * @param [in] pSourceFrame  the frame the value was computed from.
+    */
+    void setValue(const MatrixXd& mat, const MeasurementFrame::ConstSPtr& pSourceFrame);
+
     //=========================================================================================================
     /**
     * Attaches a value to the sample array vector.
@@ -246,6 +333,16 @@ public:
 //    virtual void setValue(MatrixXd& v);
 
 private:
+    //=========================================================================================================
+    /**
+    * Publishes a value as a new frame to the subscribers and notifies the listeners once the multi array is full.
+    *
+    * @param [in] mat               the value which is attached to the sample array list.
+    * @param [in] iFrameId          the frame id of the acquired block the value belongs to.
+    * @param [in] iAcquisitionTime  the acquisition time of that block in us of MeasurementFrame::currentTimeUs().
+    */
+    void publishFrame(const MatrixXd& mat, quint64 iFrameId, qint64 iAcquisitionTime);
+
     mutable QMutex              m_qMutex;           /**< Mutex to ensure thread safety */
 
     FiffInfo::SPtr              m_pFiffInfo_orig;   /**< Original Fiff Info if initialized by fiff info. */
@@ -255,9 +352,13 @@ private:
     double                      m_dSamplingRate;    /**< Sampling rate of the RealTimeSampleArray.*/
 //    MatrixXd                    m_vecValue;         /**< The current attached sample vector.*/
     qint32                      m_iMultiArraySize; /**< Sample size of the multi sample array.*/
-    QList< MatrixXd >           m_matSamples;       /**< The multi sample array.*/
+    QList<MeasurementFrame::ConstSPtr> m_qListFrames;   /**< The frames gathered since the last notify.*/
+    QList<QWeakPointer<MeasurementFrameQueue> > m_qListSubscribers;   /**< Frame queues of the consumers.*/
+    quint64                     m_iSequenceNumber;  /**< Sequence number of the next frame.*/
     QList<RealTimeSampleArrayChInfo> m_qListChInfo; /**< Channel info list.*/
     bool                        m_bChInfoIsInit;    /**< If channel info is initialized.*/
+    qint64                      m_iPreprocessingVersion;    /**< Version of the preprocessing applied by the producer, -1 if the data is raw.*/
+    int                         m_iPreprocessingSteps;      /**< Processing steps applied by the producer, 0 if the data is raw.*/
 };
 
 
@@ -269,7 +370,7 @@ private:
 inline void NewRealTimeMultiSampleArray::clear()
 {
     QMutexLocker locker(&m_qMutex);
-    m_matSamples.clear();
+    m_qListFrames.clear();
 }
 
 
@@ -387,11 +488,40 @@ qint32 NewRealTimeMultiSampleArray::getMultiArraySize() const
 
 //*************************************************************************************************************
 
-inline const QList< MatrixXd >& NewRealTimeMultiSampleArray::getMultiSampleArray()
+inline void NewRealTimeMultiSampleArray::setPreprocessingVersion(qint64 iVersion)
 {
-    return m_matSamples;
+    QMutexLocker locker(&m_qMutex);
+    m_iPreprocessingVersion = iVersion;
 }
 
+
+//*************************************************************************************************************
+
+inline qint64 NewRealTimeMultiSampleArray::getPreprocessingVersion() const
+{
+    QMutexLocker locker(&m_qMutex);
+    return m_iPreprocessingVersion;
+}
+
+
+//*************************************************************************************************************
+
+inline void NewRealTimeMultiSampleArray::setPreprocessingSteps(int iSteps)
+{
+    QMutexLocker locker(&m_qMutex);
+    m_iPreprocessingSteps = iSteps;
+}
+
+
+//*************************************************************************************************************
+
+inline int NewRealTimeMultiSampleArray::getPreprocessingSteps() const
+{
+    QMutexLocker locker(&m_qMutex);
+    return m_iPreprocessingSteps;
+}
+
+
 } // NAMESPACE
 
 Q_DECLARE_METATYPE(SCMEASLIB::NewRealTimeMultiSampleArray::SPtr)
@@ -88,7 +88,8 @@ SOURCES += \
     realtimeevoked.cpp \
     realtimeevokedset.cpp \
     realtimecov.cpp \
-    frequencyspectrum.cpp
+    frequencyspectrum.cpp \
+    measurementframe.cpp
 
 
 HEADERS += \
@@ -104,7 +105,8 @@ HEADERS += \
     realtimeevoked.h \
     realtimeevokedset.h \
     realtimecov.h \
-    frequencyspectrum.h
+    frequencyspectrum.h \
+    measurementframe.h
 
 
 INCLUDEPATH += $${EIGEN_INCLUDE_DIR}
@@ -151,7 +151,7 @@ QWidget* DisplayManager::show(IPlugin::OutputConnectorList &outputConnectorList,
             qListWidgets.append(rtmsaWidget->getDisplayWidgets());
 
             connect(pPluginOutputConnector.data(), &PluginOutputConnector::notify,
-                    rtmsaWidget, &RealTimeMultiSampleArrayWidget::update, Qt::BlockingQueuedConnection);
+                    rtmsaWidget, &RealTimeMultiSampleArrayWidget::wakeUp, Qt::DirectConnection);
 
             vboxLayout->addWidget(rtmsaWidget);
             rtmsaWidget->init();
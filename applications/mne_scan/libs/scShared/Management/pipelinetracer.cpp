@@ -0,0 +1,474 @@
+//=============================================================================================================
+/**
+* @file     pipelinetracer.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     Definition of the PipelineTracer and PipelineTraceScope classes.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "pipelinetracer.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QMutexLocker>
+#include <QPair>
+#include <QFile>
+#include <QTextStream>
+#include <QDebug>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace SCSHAREDLIB;
+using namespace SCMEASLIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE STATIC HELPERS
+//=============================================================================================================
+
+namespace
+{
+
+QString escapeJson(const QString& sValue)
+{
+    QString sEscaped = sValue;
+    sEscaped.replace("\\", "\\\\");
+    sEscaped.replace("\"", "\\\"");
+    return sEscaped;
+}
+
+} // NAMESPACE
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+PipelineTracer::PipelineTracer(QObject *parent)
+: QObject(parent)
+, m_iEnabled(0)
+, m_iCapacity(PIPELINE_TRACER_DEFAULT_CAPACITY)
+, m_iEventPos(0)
+{
+}
+
+
+//*************************************************************************************************************
+
+PipelineTracer* PipelineTracer::instance()
+{
+    static PipelineTracer s_tracer;
+    return &s_tracer;
+}
+
+
+//*************************************************************************************************************
+
+qint64 PipelineTracer::currentTimeUs()
+{
+    return MeasurementFrame::currentTimeUs();
+}
+
+
+//*************************************************************************************************************
+
+QVector<double> PipelineTracer::histogramBinEdges()
+{
+    QVector<double> vecEdges;
+    vecEdges << 1.0 << 2.0 << 5.0 << 10.0 << 20.0 << 50.0 << 100.0 << 200.0 << 500.0 << 1000.0;
+    return vecEdges;
+}
+
+
+//*************************************************************************************************************
+
+void PipelineTracer::setEnabled(bool bEnabled)
+{
+    m_iEnabled.storeRelease(bEnabled ? 1 : 0);
+}
+
+
+//*************************************************************************************************************
+
+void PipelineTracer::setCapacity(int iCapacity)
+{
+    QMutexLocker locker(&m_qMutex);
+
+    m_iCapacity = qMax(1, iCapacity);
+    m_vecEvents.clear();
+    m_iEventPos = 0;
+}
+
+
+//*************************************************************************************************************
+
+void PipelineTracer::recordEvent(const QString& sStage, EventType type, quint64 iFrameId, qint64 iTimestampUs)
+{
+    if(!isEnabled()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_qMutex);
+
+    int iStage = stageIndex(sStage);
+    appendEvent(iStage, type, iFrameId, iTimestampUs);
+}
+
+
+//*************************************************************************************************************
+
+void PipelineTracer::recordFrames(const QString& sStage, const QList<MeasurementFrame::ConstSPtr>& lFrames)
+{
+    if(!isEnabled() || lFrames.isEmpty()) {
+        return;
+    }
+
+    qint64 iNowUs = currentTimeUs();
+
+    QMutexLocker locker(&m_qMutex);
+
+    int iStage = stageIndex(sStage);
+    StageState& state = m_vecStageStates[iStage];
+
+    for(int i = 0; i < lFrames.size(); ++i) {
+        const MeasurementFrame::ConstSPtr& pFrame = lFrames.at(i);
+
+        qint64 iEnqueueUs = pFrame->timestamp();
+        double dQueueLatency = qMax(qint64(0), iNowUs - iEnqueueUs) / 1000.0;
+        double dLatency = qMax(qint64(0), iNowUs - pFrame->acquisitionTime()) / 1000.0;
+
+        appendEvent(iStage, Enqueue, pFrame->frameId(), iEnqueueUs);
+        appendEvent(iStage, Dequeue, pFrame->frameId(), iNowUs);
+
+        state.dSumQueueLatency += dQueueLatency;
+        state.dMaxQueueLatency = qMax(state.dMaxQueueLatency, dQueueLatency);
+        addToHistogram(state.vecQueueHistogram, dQueueLatency);
+
+        state.dSumLatency += dLatency;
+        state.dMaxLatency = qMax(state.dMaxLatency, dLatency);
+
+        state.iFirstUs = state.iFirstUs < 0 ? iEnqueueUs : qMin(state.iFirstUs, iEnqueueUs);
+        state.iNumSamples += pFrame->data().cols();
+    }
+
+    state.iNumFrames += lFrames.size();
+    state.iLastUs = qMax(state.iLastUs, iNowUs);
+}
+
+
+//*************************************************************************************************************
+
+void PipelineTracer::recordProcessing(const QString& sStage, quint64 iFrameId, qint64 iStartUs, qint64 iEndUs)
+{
+    if(!isEnabled()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_qMutex);
+
+    int iStage = stageIndex(sStage);
+    StageState& state = m_vecStageStates[iStage];
+
+    appendEvent(iStage, ProcessStart, iFrameId, iStartUs);
+    appendEvent(iStage, ProcessEnd, iFrameId, iEndUs);
+
+    double dTime = qMax(qint64(0), iEndUs - iStartUs) / 1000.0;
+
+    ++state.iNumProcessed;
+    state.dSumProcessingTime += dTime;
+    state.dMaxProcessingTime = qMax(state.dMaxProcessingTime, dTime);
+    addToHistogram(state.vecProcessingHistogram, dTime);
+
+    state.iFirstUs = state.iFirstUs < 0 ? iStartUs : qMin(state.iFirstUs, iStartUs);
+    state.iLastUs = qMax(state.iLastUs, iEndUs);
+}
+
+
+//*************************************************************************************************************
+
+QList<PipelineStageStatistics> PipelineTracer::statistics() const
+{
+    QList<PipelineStageStatistics> lStatistics;
+
+    QMutexLocker locker(&m_qMutex);
+
+    for(int i = 0; i < m_slStages.size(); ++i) {
+        const StageState& state = m_vecStageStates.at(i);
+
+        PipelineStageStatistics stats;
+        stats.sStage = m_slStages.at(i);
+        stats.iNumFrames = state.iNumFrames;
+        stats.iNumSamples = state.iNumSamples;
+        stats.iNumProcessed = state.iNumProcessed;
+
+        double dSeconds = (state.iLastUs - state.iFirstUs) / 1.0e6;
+        qint64 iCount = state.iNumFrames > 0 ? state.iNumFrames : state.iNumProcessed;
+        stats.dThroughput = dSeconds > 0.0 ? iCount / dSeconds : 0.0;
+        stats.dSampleThroughput = dSeconds > 0.0 ? state.iNumSamples / dSeconds : 0.0;
+
+        stats.dMeanQueueLatency = state.iNumFrames > 0 ? state.dSumQueueLatency / state.iNumFrames : 0.0;
+        stats.dMaxQueueLatency = state.dMaxQueueLatency;
+        stats.dMeanLatency = state.iNumFrames > 0 ? state.dSumLatency / state.iNumFrames : 0.0;
+        stats.dMaxLatency = state.dMaxLatency;
+        stats.dMeanProcessingTime = state.iNumProcessed > 0 ? state.dSumProcessingTime / state.iNumProcessed : 0.0;
+        stats.dMaxProcessingTime = state.dMaxProcessingTime;
+        stats.vecQueueHistogram = state.vecQueueHistogram;
+        stats.vecProcessingHistogram = state.vecProcessingHistogram;
+
+        lStatistics.append(stats);
+    }
+
+    return lStatistics;
+}
+
+
+//*************************************************************************************************************
+
+void PipelineTracer::reset()
+{
+    QMutexLocker locker(&m_qMutex);
+
+    m_slStages.clear();
+    m_qHashStageIndex.clear();
+    m_vecStageStates.clear();
+    m_vecEvents.clear();
+    m_iEventPos = 0;
+}
+
+
+//*************************************************************************************************************
+
+bool PipelineTracer::exportChromeTrace(const QString& sFileName) const
+{
+    QFile file(sFileName);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << "PipelineTracer::exportChromeTrace - Could not open" << sFileName;
+        return false;
+    }
+
+    QStringList slStages;
+    QVector<TraceEvent> vecEvents;
+    {
+        QMutexLocker locker(&m_qMutex);
+        slStages = m_slStages;
+
+        //Unroll the ring buffer, oldest event first
+        vecEvents.reserve(m_vecEvents.size());
+        for(int i = m_iEventPos; i < m_vecEvents.size(); ++i) {
+            vecEvents.append(m_vecEvents.at(i));
+        }
+        for(int i = 0; i < m_iEventPos; ++i) {
+            vecEvents.append(m_vecEvents.at(i));
+        }
+    }
+
+    //Once the ring buffer wrapped, the start or the end of a processing run may have been overwritten. Keep only
+    //runs with both halves, the trace viewers can not pair unbalanced duration events.
+    QVector<bool> vecKeep(vecEvents.size(), true);
+    QHash<QPair<int, quint64>, int> qHashOpenRuns;
+
+    for(int i = 0; i < vecEvents.size(); ++i) {
+        const TraceEvent& event = vecEvents.at(i);
+        QPair<int, quint64> run(event.iStage, event.iFrameId);
+
+        if(event.type == ProcessStart) {
+            if(qHashOpenRuns.contains(run)) {
+                vecKeep[qHashOpenRuns.value(run)] = false;
+            }
+            qHashOpenRuns.insert(run, i);
+        } else if(event.type == ProcessEnd) {
+            if(qHashOpenRuns.contains(run)) {
+                qHashOpenRuns.remove(run);
+            } else {
+                vecKeep[i] = false;
+            }
+        }
+    }
+
+    QHash<QPair<int, quint64>, int>::const_iterator itOpen;
+    for(itOpen = qHashOpenRuns.constBegin(); itOpen != qHashOpenRuns.constEnd(); ++itOpen) {
+        vecKeep[itOpen.value()] = false;
+    }
+
+    qint64 iOriginUs = 0;
+    bool bOriginSet = false;
+    for(int i = 0; i < vecEvents.size(); ++i) {
+        if(vecKeep.at(i) && (!bOriginSet || vecEvents.at(i).iTimestampUs < iOriginUs)) {
+            iOriginUs = vecEvents.at(i).iTimestampUs;
+            bOriginSet = true;
+        }
+    }
+
+    QTextStream out(&file);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    for(int i = 0; i < slStages.size(); ++i) {
+        out << (i > 0 ? ",\n" : "")
+            << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i
+            << ",\"args\":{\"name\":\"" << escapeJson(slStages.at(i)) << "\"}}";
+    }
+
+    bool bFirst = slStages.isEmpty();
+    for(int i = 0; i < vecEvents.size(); ++i) {
+        if(!vecKeep.at(i)) {
+            continue;
+        }
+
+        const TraceEvent& event = vecEvents.at(i);
+
+        out << (bFirst ? "" : ",\n") << "{";
+        bFirst = false;
+
+        switch(event.type) {
+            case Enqueue:
+                out << "\"name\":\"enqueue\",\"ph\":\"i\",\"s\":\"t\"";
+                break;
+            case Dequeue:
+                out << "\"name\":\"dequeue\",\"ph\":\"i\",\"s\":\"t\"";
+                break;
+            case ProcessStart:
+                out << "\"name\":\"process\",\"ph\":\"B\"";
+                break;
+            case ProcessEnd:
+                out << "\"name\":\"process\",\"ph\":\"E\"";
+                break;
+        }
+
+        out << ",\"cat\":\"mne_scan\",\"pid\":1,\"tid\":" << event.iStage
+            << ",\"ts\":" << (event.iTimestampUs - iOriginUs)
+            << ",\"args\":{\"frame\":" << event.iFrameId << "}}";
+    }
+
+    out << "\n]}\n";
+
+    return out.status() == QTextStream::Ok;
+}
+
+
+//*************************************************************************************************************
+
+int PipelineTracer::stageIndex(const QString& sStage)
+{
+    QHash<QString, int>::const_iterator it = m_qHashStageIndex.constFind(sStage);
+    if(it != m_qHashStageIndex.constEnd()) {
+        return it.value();
+    }
+
+    StageState state;
+    state.iNumFrames = 0;
+    state.iNumSamples = 0;
+    state.iNumProcessed = 0;
+    state.iFirstUs = -1;
+    state.iLastUs = 0;
+    state.dSumQueueLatency = 0.0;
+    state.dMaxQueueLatency = 0.0;
+    state.dSumLatency = 0.0;
+    state.dMaxLatency = 0.0;
+    state.dSumProcessingTime = 0.0;
+    state.dMaxProcessingTime = 0.0;
+    state.vecQueueHistogram = QVector<qint64>(histogramBinEdges().size() + 1, 0);
+    state.vecProcessingHistogram = QVector<qint64>(histogramBinEdges().size() + 1, 0);
+
+    int iStage = m_slStages.size();
+    m_slStages.append(sStage);
+    m_qHashStageIndex.insert(sStage, iStage);
+    m_vecStageStates.append(state);
+
+    return iStage;
+}
+
+
+//*************************************************************************************************************
+
+void PipelineTracer::appendEvent(int iStage, EventType type, quint64 iFrameId, qint64 iTimestampUs)
+{
+    TraceEvent event;
+    event.iStage = iStage;
+    event.type = type;
+    event.iFrameId = iFrameId;
+    event.iTimestampUs = iTimestampUs;
+
+    if(m_vecEvents.size() < m_iCapacity) {
+        m_vecEvents.append(event);
+    } else {
+        m_vecEvents[m_iEventPos] = event;
+        m_iEventPos = (m_iEventPos + 1) % m_iCapacity;
+    }
+}
+
+
+//*************************************************************************************************************
+
+void PipelineTracer::addToHistogram(QVector<qint64>& vecHistogram, double dValue)
+{
+    static const QVector<double> s_vecEdges = histogramBinEdges();
+
+    int iBin = 0;
+    while(iBin < s_vecEdges.size() && dValue >= s_vecEdges.at(iBin)) {
+        ++iBin;
+    }
+
+    ++vecHistogram[iBin];
+}
+
+
+//*************************************************************************************************************
+
+PipelineTraceScope::PipelineTraceScope(const QString& sStage, quint64 iFrameId)
+: m_sStage(sStage)
+, m_iFrameId(iFrameId)
+, m_iStartUs(PipelineTracer::instance()->isEnabled() ? PipelineTracer::currentTimeUs() : -1)
+{
+}
+
+
+//*************************************************************************************************************
+
+PipelineTraceScope::~PipelineTraceScope()
+{
+    if(m_iStartUs >= 0) {
+        PipelineTracer::instance()->recordProcessing(m_sStage, m_iFrameId, m_iStartUs, PipelineTracer::currentTimeUs());
+    }
+}
@@ -0,0 +1,342 @@
+//=============================================================================================================
+/**
+* @file     pipelinetracer.h
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     Declaration of the PipelineTracer and PipelineTraceScope classes.
+*
+*/
+
+#ifndef PIPELINETRACER_H
+#define PIPELINETRACER_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "../scshared_global.h"
+
+#include <scMeas/measurementframe.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QList>
+#include <QHash>
+#include <QMutex>
+#include <QAtomicInt>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE SCSHAREDLIB
+//=============================================================================================================
+
+namespace SCSHAREDLIB
+{
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINES
+//=============================================================================================================
+
+#define PIPELINE_TRACER_DEFAULT_CAPACITY 200000
+
+
+//=============================================================================================================
+/**
+* Aggregated timing of one pipeline stage, i.e. a plugin input or a processing step inside a plugin.
+*/
+struct PipelineStageStatistics {
+    QString         sStage;                     /**< The stage name. */
+    qint64          iNumFrames;                 /**< Number of frames dequeued by the stage. */
+    qint64          iNumSamples;                /**< Number of samples (matrix columns) in the dequeued frames. */
+    qint64          iNumProcessed;              /**< Number of processing runs of the stage. */
+    double          dThroughput;                /**< Frames, or processing runs if the stage does not dequeue frames, per second. */
+    double          dSampleThroughput;          /**< Dequeued samples per second. */
+    double          dMeanQueueLatency;          /**< Mean time in ms from publishing a frame to its dequeue. */
+    double          dMaxQueueLatency;           /**< Maximum time in ms from publishing a frame to its dequeue. */
+    double          dMeanLatency;               /**< Mean time in ms from the acquisition of the block to the dequeue of a frame. */
+    double          dMaxLatency;                /**< Maximum time in ms from the acquisition of the block to the dequeue of a frame. */
+    double          dMeanProcessingTime;        /**< Mean processing time in ms. */
+    double          dMaxProcessingTime;         /**< Maximum processing time in ms. */
+    QVector<qint64> vecQueueHistogram;          /**< Queue latency counts per bin of PipelineTracer::histogramBinEdges(). */
+    QVector<qint64> vecProcessingHistogram;     /**< Processing time counts per bin of PipelineTracer::histogramBinEdges(). */
+};
+
+
+//=============================================================================================================
+/**
+* The PipelineTracer collects time stamped events of the measurement frames travelling through the plugin graph.
+* Plugin inputs record when frames were enqueued and dequeued, plugins record the start and the end of their
+* processing. All events are keyed by the frame id the sensor plugin stamped on the acquired block and are timed
+* with the monotonic clock of the frames, so one block can be followed across the stages. The events are aggregated into per stage latency histograms and throughput counters and can be
+* exported in the Chrome trace event format (chrome://tracing, Perfetto) for offline analysis. Tracing is disabled
+* by default, a disabled tracer costs one atomic load per call.
+*
+* @brief Latency tracing of the mne_scan plugin pipeline.
+*/
+class SCSHAREDSHARED_EXPORT PipelineTracer : public QObject
+{
+    Q_OBJECT
+public:
+    enum EventType {
+        Enqueue,            /**< A frame was published to the queue of a stage. */
+        Dequeue,            /**< A frame was taken from the queue of a stage. */
+        ProcessStart,       /**< A stage started processing. */
+        ProcessEnd          /**< A stage finished processing. */
+    };
+
+    //=========================================================================================================
+    /**
+    * Returns the application wide tracer.
+    *
+    * @return the tracer instance.
+    */
+    static PipelineTracer* instance();
+
+    //=========================================================================================================
+    /**
+    * Returns the current time of the monotonic clock the measurement frames are stamped with.
+    *
+    * @return the current time in micro seconds, see SCMEASLIB::MeasurementFrame::currentTimeUs().
+    */
+    static qint64 currentTimeUs();
+
+    //=========================================================================================================
+    /**
+    * Returns the upper bin edges in ms of the latency histograms. The last bin is open ended.
+    *
+    * @return the upper bin edges in ms.
+    */
+    static QVector<double> histogramBinEdges();
+
+    //=========================================================================================================
+    /**
+    * Enables or disables the tracing.
+    *
+    * @param[in] bEnabled   whether events are recorded.
+    */
+    void setEnabled(bool bEnabled);
+
+    //=========================================================================================================
+    /**
+    * Returns whether the tracing is enabled.
+    *
+    * @return true if events are recorded.
+    */
+    inline bool isEnabled() const;
+
+    //=========================================================================================================
+    /**
+    * Sets the number of events kept for the trace export. The oldest events are discarded first.
+    *
+    * @param[in] iCapacity  the maximum number of kept events.
+    */
+    void setCapacity(int iCapacity);
+
+    //=========================================================================================================
+    /**
+    * Records a single event.
+    *
+    * @param[in] sStage             the stage name.
+    * @param[in] type               the event type.
+    * @param[in] iFrameId           the id of the frame the event belongs to.
+    * @param[in] iTimestampUs       the time of the event in micro seconds of currentTimeUs().
+    */
+    void recordEvent(const QString& sStage, EventType type, quint64 iFrameId, qint64 iTimestampUs);
+
+    //=========================================================================================================
+    /**
+    * Records that a stage dequeued frames now. The publishing time of each frame is recorded as its enqueue event,
+    * its acquisition time gives the latency since the block was acquired.
+    *
+    * @param[in] sStage     the stage name.
+    * @param[in] lFrames    the dequeued frames.
+    */
+    void recordFrames(const QString& sStage, const QList<SCMEASLIB::MeasurementFrame::ConstSPtr>& lFrames);
+
+    //=========================================================================================================
+    /**
+    * Records one processing run of a stage.
+    *
+    * @param[in] sStage             the stage name.
+    * @param[in] iFrameId           the id of the processed frame.
+    * @param[in] iStartUs           the start time in micro seconds of currentTimeUs().
+    * @param[in] iEndUs             the end time in micro seconds of currentTimeUs().
+    */
+    void recordProcessing(const QString& sStage, quint64 iFrameId, qint64 iStartUs, qint64 iEndUs);
+
+    //=========================================================================================================
+    /**
+    * Returns the aggregated statistics of all stages seen so far.
+    *
+    * @return the statistics ordered by the first appearance of the stage.
+    */
+    QList<PipelineStageStatistics> statistics() const;
+
+    //=========================================================================================================
+    /**
+    * Discards all recorded events and statistics.
+    */
+    void reset();
+
+    //=========================================================================================================
+    /**
+    * Writes the kept events in the Chrome trace event format. Every stage is shown as a thread, processing runs as
+    * duration events and enqueue/dequeue as instant events. Processing runs which lost their start or end to the
+    * ring buffer are left out, so the duration events stay balanced.
+    *
+    * @param[in] sFileName  the JSON file to write.
+    *
+    * @return true if the file was written.
+    */
+    bool exportChromeTrace(const QString& sFileName) const;
+
+private:
+    //=========================================================================================================
+    /**
+    * Constructs the PipelineTracer.
+    */
+    explicit PipelineTracer(QObject *parent = 0);
+
+    struct TraceEvent {
+        int         iStage;                     /**< Index into m_slStages. */
+        EventType   type;                       /**< The event type. */
+        quint64     iFrameId;                   /**< The id of the frame the event belongs to. */
+        qint64      iTimestampUs;               /**< Time of the event in micro seconds of currentTimeUs(). */
+    };
+
+    struct StageState {
+        qint64      iNumFrames;                 /**< Number of dequeued frames. */
+        qint64      iNumSamples;                /**< Number of dequeued samples. */
+        qint64      iNumProcessed;              /**< Number of processing runs. */
+        qint64      iFirstUs;                   /**< Time of the first event. */
+        qint64      iLastUs;                    /**< Time of the last event. */
+        double      dSumQueueLatency;           /**< Sum of the queue latencies in ms. */
+        double      dMaxQueueLatency;           /**< Maximum queue latency in ms. */
+        double      dSumLatency;                /**< Sum of the latencies since acquisition in ms. */
+        double      dMaxLatency;                /**< Maximum latency since acquisition in ms. */
+        double      dSumProcessingTime;         /**< Sum of the processing times in ms. */
+        double      dMaxProcessingTime;         /**< Maximum processing time in ms. */
+        QVector<qint64> vecQueueHistogram;      /**< Queue latency histogram. */
+        QVector<qint64> vecProcessingHistogram; /**< Processing time histogram. */
+    };
+
+    //=========================================================================================================
+    /**
+    * Returns the index of the stage and creates its state if needed. The mutex has to be locked.
+    *
+    * @param[in] sStage     the stage name.
+    *
+    * @return the stage index.
+    */
+    int stageIndex(const QString& sStage);
+
+    //=========================================================================================================
+    /**
+    * Appends an event to the ring buffer. The mutex has to be locked.
+    */
+    void appendEvent(int iStage, EventType type, quint64 iFrameId, qint64 iTimestampUs);
+
+    //=========================================================================================================
+    /**
+    * Adds a sample to a histogram.
+    *
+    * @param[in, out] vecHistogram  the histogram.
+    * @param[in] dValue             the sample in ms.
+    */
+    static void addToHistogram(QVector<qint64>& vecHistogram, double dValue);
+
+    QAtomicInt                  m_iEnabled;         /**< 1 if events are recorded. */
+    mutable QMutex              m_qMutex;           /**< Guards the events and the statistics. */
+    QStringList                 m_slStages;         /**< Stage names in order of appearance. */
+    QHash<QString, int>         m_qHashStageIndex;  /**< Stage name to index. */
+    QVector<StageState>         m_vecStageStates;   /**< Aggregated state per stage. */
+    QVector<TraceEvent>         m_vecEvents;        /**< Ring buffer of the recorded events. */
+    int                         m_iCapacity;        /**< Maximum number of kept events. */
+    int                         m_iEventPos;        /**< Next write position in the ring buffer once it is full. */
+};
+
+
+//=============================================================================================================
+/**
+* Records the enclosing block as one processing run of a stage, e.g.
+*
+*     PipelineTraceScope trace("Averaging", pFrame->frameId());
+*     m_pRtAve->append(pFrame->data());
+*
+* @brief RAII helper to trace the processing of a stage.
+*/
+class SCSHAREDSHARED_EXPORT PipelineTraceScope
+{
+public:
+    //=========================================================================================================
+    /**
+    * Records the start of the processing if tracing is enabled.
+    *
+    * @param[in] sStage             the stage name.
+    * @param[in] iFrameId           the id of the processed frame.
+    */
+    PipelineTraceScope(const QString& sStage, quint64 iFrameId);
+
+    //=========================================================================================================
+    /**
+    * Records the end of the processing.
+    */
+    ~PipelineTraceScope();
+
+private:
+    QString     m_sStage;               /**< The stage name. */
+    quint64     m_iFrameId;             /**< The id of the processed frame. */
+    qint64      m_iStartUs;             /**< Start time, -1 if tracing was disabled. */
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline bool PipelineTracer::isEnabled() const
+{
+    return m_iEnabled.loadAcquire() != 0;
+}
+
+} // NAMESPACE
+
+#endif // PIPELINETRACER_H
@@ -90,6 +90,15 @@ void PluginConnectorConnection::clearConnection()
         disconnect(it.value());
 
     m_qHashConnections.clear();
+
+    for(int i = 0; i < m_qListFrameSubscriptions.size(); ++i) {
+        SCMEASLIB::MeasurementFrameQueue::SPtr pQueue = m_qListFrameSubscriptions[i].second->removeFrameQueue(m_qListFrameSubscriptions[i].first);
+
+        if(pQueue)
+            m_qListFrameSubscriptions[i].first->unsubscribe(pQueue);
+    }
+
+    m_qListFrameSubscriptions.clear();
 }
 
 
@@ -127,8 +136,12 @@ bool PluginConnectorConnection::createConnection()
             QSharedPointer< PluginInputData<NewRealTimeMultiSampleArray> > receiverRTMSA = m_pReceiver->getInputConnectors()[j].dynamicCast< PluginInputData<NewRealTimeMultiSampleArray> >();
             if(senderRTMSA && receiverRTMSA)
             {
+                //Streamed data is fanned out via the receiver's frame queue for this sender, the sender only schedules a wake up and never blocks
+                senderRTMSA->data()->subscribe(receiverRTMSA->frameQueue(senderRTMSA->data()));
+                m_qListFrameSubscriptions.append(qMakePair(senderRTMSA->data(), m_pReceiver->getInputConnectors()[j]));
+
                 m_qHashConnections.insert(QPair<QString,QString>(m_pSender->getOutputConnectors()[i]->getName(), m_pReceiver->getInputConnectors()[j]->getName()), connect(m_pSender->getOutputConnectors()[i].data(), &PluginOutputConnector::notify,
-                        m_pReceiver->getInputConnectors()[j].data(), &PluginInputConnector::update, Qt::BlockingQueuedConnection));
+                        m_pReceiver->getInputConnectors()[j].data(), &PluginInputConnector::wakeUp, Qt::DirectConnection));
                 bConnected = true;
                 break;
             }
@@ -47,6 +47,8 @@
 #include "plugininputconnector.h"
 #include "pluginoutputconnector.h"
 
+#include <scMeas/newrealtimemultisamplearray.h>
+
 
 //*************************************************************************************************************
 //=============================================================================================================
@@ -147,6 +149,7 @@ private:
     IPlugin::SPtr m_pReceiver;
 
     QHash<QPair<QString, QString>, QMetaObject::Connection> m_qHashConnections; /**< QHash which holds the connections between sender and receiver QHash<QPair<Sender,Receiver>, Connection>. */
+    QList<QPair<SCMEASLIB::NewRealTimeMultiSampleArray::SPtr, PluginInputConnector::SPtr> > m_qListFrameSubscriptions;  /**< The sender's measurements and the receiver's inputs whose frame queues are subscribed at them. */
 };
 
 //*************************************************************************************************************
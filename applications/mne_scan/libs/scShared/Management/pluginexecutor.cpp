@@ -0,0 +1,424 @@
+//=============================================================================================================
+/**
+* @file     pluginexecutor.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     Definition of the PluginExecutor and PluginStrand classes.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "pluginexecutor.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <exception>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QThread>
+#include <QMutexLocker>
+#include <QDebug>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace SCSHAREDLIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE STATIC HELPERS
+//=============================================================================================================
+
+namespace
+{
+
+//=========================================================================================================
+/**
+* The executor and worker index of the calling thread, if it is a worker.
+*/
+struct CurrentWorker
+{
+    PluginExecutor* pExecutor;
+    int iIndex;
+};
+
+thread_local CurrentWorker s_currentWorker = { Q_NULLPTR, -1 };
+
+//=========================================================================================================
+/**
+* Runs a task and keeps exceptions from unwinding into the worker loop.
+*/
+void runTask(const std::function<void()>& task, const QString& sContext)
+{
+    try {
+        task();
+    } catch(const std::exception& e) {
+        qWarning() << "PluginExecutor: Task of" << sContext << "threw" << e.what();
+    } catch(...) {
+        qWarning() << "PluginExecutor: Task of" << sContext << "threw an unknown exception";
+    }
+}
+
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE WORKER THREAD
+//=============================================================================================================
+
+namespace SCSHAREDLIB
+{
+
+//=========================================================================================================
+/**
+* Thread which runs the worker loop of a PluginExecutor.
+*/
+class PluginExecutorWorker : public QThread
+{
+public:
+    PluginExecutorWorker(PluginExecutor* pExecutor, int iIndex)
+    : m_pExecutor(pExecutor)
+    , m_iIndex(iIndex)
+    {
+        // The name shows up in debuggers and in the per thread CPU times of the benchmark runner
+        setObjectName(QString("ScanPool %1").arg(iIndex));
+    }
+
+protected:
+    virtual void run()
+    {
+        m_pExecutor->runWorker(m_iIndex);
+    }
+
+private:
+    PluginExecutor*     m_pExecutor;    /**< The executor of this worker. */
+    int                 m_iIndex;       /**< The index of this worker. */
+};
+
+} // NAMESPACE
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS PluginStrand
+//=============================================================================================================
+
+PluginStrand::PluginStrand(PluginExecutor* pExecutor, const QString& sName)
+: m_pExecutor(pExecutor)
+, m_sName(sName)
+, m_bScheduled(false)
+, m_pRunningThread(Q_NULLPTR)
+{
+}
+
+
+//*************************************************************************************************************
+
+PluginStrand::~PluginStrand()
+{
+    clear();
+    waitForDone();
+}
+
+
+//*************************************************************************************************************
+
+void PluginStrand::post(const std::function<void()>& task)
+{
+    bool bSubmit = false;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_dequeTasks.push_back(task);
+
+        if(!m_bScheduled) {
+            m_bScheduled = true;
+            bSubmit = true;
+        }
+    }
+
+    // Only one batch of a strand is submitted at a time, which serializes its tasks
+    if(bSubmit) {
+        m_pExecutor->submit([this]() { runBatch(); });
+    }
+}
+
+
+//*************************************************************************************************************
+
+void PluginStrand::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_dequeTasks.clear();
+}
+
+
+//*************************************************************************************************************
+
+void PluginStrand::waitForDone()
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(m_pRunningThread == QThread::currentThread()) {
+        return;
+    }
+
+    while(m_bScheduled) {
+        m_idle.wait(&m_mutex);
+    }
+}
+
+
+//*************************************************************************************************************
+
+int PluginStrand::pendingTasks() const
+{
+    QMutexLocker locker(&m_mutex);
+    return static_cast<int>(m_dequeTasks.size());
+}
+
+
+//*************************************************************************************************************
+
+void PluginStrand::runBatch()
+{
+    for(int i = 0; i < PLUGIN_STRAND_BATCH_SIZE; ++i) {
+        std::function<void()> task;
+
+        {
+            QMutexLocker locker(&m_mutex);
+
+            if(m_dequeTasks.empty()) {
+                m_bScheduled = false;
+                m_pRunningThread = Q_NULLPTR;
+                m_idle.wakeAll();
+                return;
+            }
+
+            task = m_dequeTasks.front();
+            m_dequeTasks.pop_front();
+            m_pRunningThread = QThread::currentThread();
+        }
+
+        runTask(task, m_sName);
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_pRunningThread = Q_NULLPTR;
+
+        if(m_dequeTasks.empty()) {
+            m_bScheduled = false;
+            m_idle.wakeAll();
+            return;
+        }
+    }
+
+    // Tasks are left, queue the strand behind the other work instead of holding on to the worker
+    m_pExecutor->submit([this]() { runBatch(); });
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS PluginExecutor
+//=============================================================================================================
+
+PluginExecutor::PluginExecutor(int iNumWorkers)
+: m_iPendingTasks(0)
+, m_iSteals(0)
+, m_bShutdown(false)
+{
+    if(iNumWorkers < 1) {
+        iNumWorkers = qMax(1, QThread::idealThreadCount() - 1);
+    }
+
+    for(int i = 0; i < iNumWorkers; ++i) {
+        m_vecQueues.append(new TaskQueue);
+    }
+
+    for(int i = 0; i < iNumWorkers; ++i) {
+        PluginExecutorWorker* pWorker = new PluginExecutorWorker(this, i);
+        m_vecWorkers.append(pWorker);
+        pWorker->start();
+    }
+}
+
+
+//*************************************************************************************************************
+
+PluginExecutor::~PluginExecutor()
+{
+    {
+        QMutexLocker locker(&m_sleepMutex);
+        m_bShutdown = true;
+    }
+
+    m_wakeUp.wakeAll();
+
+    for(int i = 0; i < m_vecWorkers.size(); ++i) {
+        m_vecWorkers[i]->wait();
+        delete m_vecWorkers[i];
+    }
+
+    qDeleteAll(m_vecQueues);
+}
+
+
+//*************************************************************************************************************
+
+PluginExecutor* PluginExecutor::instance()
+{
+    static PluginExecutor s_executor;
+    return &s_executor;
+}
+
+
+//*************************************************************************************************************
+
+void PluginExecutor::submit(const std::function<void()>& task)
+{
+    // Follow-up work of a worker stays on its own queue, everything else goes to the shared queue
+    TaskQueue* pQueue = s_currentWorker.pExecutor == this ? m_vecQueues[s_currentWorker.iIndex] : &m_sharedQueue;
+
+    {
+        QMutexLocker locker(&pQueue->mutex);
+        pQueue->tasks.push_back(task);
+    }
+
+    m_iPendingTasks.ref();
+
+    QMutexLocker locker(&m_sleepMutex);
+    m_wakeUp.wakeOne();
+}
+
+
+//*************************************************************************************************************
+
+PluginStrand::SPtr PluginExecutor::createStrand(const QString& sName)
+{
+    return PluginStrand::SPtr(new PluginStrand(this, sName));
+}
+
+
+//*************************************************************************************************************
+
+bool PluginExecutor::takeTask(int iWorker, std::function<void()>& task)
+{
+    // Own queue, newest first
+    {
+        TaskQueue* pQueue = m_vecQueues[iWorker];
+        QMutexLocker locker(&pQueue->mutex);
+
+        if(!pQueue->tasks.empty()) {
+            task = pQueue->tasks.back();
+            pQueue->tasks.pop_back();
+            m_iPendingTasks.deref();
+            return true;
+        }
+    }
+
+    // Shared queue, oldest first
+    {
+        QMutexLocker locker(&m_sharedQueue.mutex);
+
+        if(!m_sharedQueue.tasks.empty()) {
+            task = m_sharedQueue.tasks.front();
+            m_sharedQueue.tasks.pop_front();
+            m_iPendingTasks.deref();
+            return true;
+        }
+    }
+
+    // Steal the oldest task of another worker
+    for(int i = 1; i < m_vecQueues.size(); ++i) {
+        TaskQueue* pQueue = m_vecQueues[(iWorker + i) % m_vecQueues.size()];
+        QMutexLocker locker(&pQueue->mutex);
+
+        if(!pQueue->tasks.empty()) {
+            task = pQueue->tasks.front();
+            pQueue->tasks.pop_front();
+            m_iPendingTasks.deref();
+            m_iSteals.ref();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+//*************************************************************************************************************
+
+void PluginExecutor::runWorker(int iWorker)
+{
+    s_currentWorker.pExecutor = this;
+    s_currentWorker.iIndex = iWorker;
+
+    while(true) {
+        std::function<void()> task;
+
+        if(takeTask(iWorker, task)) {
+            runTask(task, QThread::currentThread()->objectName());
+            continue;
+        }
+
+        // The pending count is raised before the wake up, so a submit between the failed take and the wait is not missed
+        QMutexLocker locker(&m_sleepMutex);
+
+        while(m_iPendingTasks.load() <= 0 && !m_bShutdown) {
+            m_wakeUp.wait(&m_sleepMutex);
+        }
+
+        if(m_bShutdown && m_iPendingTasks.load() <= 0) {
+            break;
+        }
+    }
+
+    s_currentWorker.pExecutor = Q_NULLPTR;
+    s_currentWorker.iIndex = -1;
+}
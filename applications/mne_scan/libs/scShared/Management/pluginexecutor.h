@@ -0,0 +1,333 @@
+//=============================================================================================================
+/**
+* @file     pluginexecutor.h
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     Declaration of the PluginExecutor and PluginStrand classes.
+*
+*/
+
+#ifndef PLUGINEXECUTOR_H
+#define PLUGINEXECUTOR_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "../scshared_global.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <deque>
+#include <functional>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// FORWARD DECLARATIONS
+//=============================================================================================================
+
+class QThread;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE SCSHAREDLIB
+//=============================================================================================================
+
+namespace SCSHAREDLIB
+{
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINES
+//=============================================================================================================
+
+#define PLUGIN_STRAND_BATCH_SIZE 16     /**< Tasks a strand runs before it yields its worker to other work. */
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// FORWARD DECLARATIONS
+//=============================================================================================================
+
+class PluginExecutor;
+
+
+//=============================================================================================================
+/**
+* Tasks posted to a strand are run one after another in the order they were posted, never concurrently, on any
+* worker of the executor. A plugin uses one strand per ordered stream, e.g. per input, and thus keeps the
+* processing order of its blocks without owning a thread.
+*
+* @brief Serial task queue on the shared plugin executor.
+*/
+class SCSHAREDSHARED_EXPORT PluginStrand
+{
+public:
+    typedef QSharedPointer<PluginStrand> SPtr;               /**< Shared pointer type for PluginStrand. */
+    typedef QSharedPointer<const PluginStrand> ConstSPtr;    /**< Const shared pointer type for PluginStrand. */
+
+    //=========================================================================================================
+    /**
+    * Constructs a strand on the given executor.
+    *
+    * @param[in] pExecutor  The executor to run the tasks on.
+    * @param[in] sName      The name of the strand, e.g. the plugin name.
+    */
+    PluginStrand(PluginExecutor* pExecutor, const QString& sName);
+
+    //=========================================================================================================
+    /**
+    * Drops the pending tasks and waits for the running one.
+    */
+    ~PluginStrand();
+
+    //=========================================================================================================
+    /**
+    * Appends a task. The task runs after all tasks posted before.
+    *
+    * @param[in] task   The task to run.
+    */
+    void post(const std::function<void()>& task);
+
+    //=========================================================================================================
+    /**
+    * Drops the tasks which did not start yet.
+    */
+    void clear();
+
+    //=========================================================================================================
+    /**
+    * Blocks until the strand ran all posted tasks. Returns at once when called from a task of this strand.
+    */
+    void waitForDone();
+
+    //=========================================================================================================
+    /**
+    * Returns the number of tasks which did not start yet.
+    *
+    * @return the number of pending tasks.
+    */
+    int pendingTasks() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the name of the strand.
+    *
+    * @return the name.
+    */
+    inline const QString& name() const;
+
+private:
+    //=========================================================================================================
+    /**
+    * Runs up to PLUGIN_STRAND_BATCH_SIZE pending tasks on the calling worker and resubmits the strand if tasks
+    * are left.
+    */
+    void runBatch();
+
+    PluginExecutor*                         m_pExecutor;        /**< The executor which runs the tasks. */
+    QString                                 m_sName;            /**< The name of the strand. */
+
+    mutable QMutex                          m_mutex;            /**< Guards the members below. */
+    QWaitCondition                          m_idle;             /**< Signaled when the strand runs out of tasks. */
+    std::deque<std::function<void()> >     m_dequeTasks;       /**< The pending tasks. */
+    bool                                    m_bScheduled;       /**< Whether the strand is submitted to or running on the executor. */
+    QThread*                                m_pRunningThread;   /**< The worker running the strand, if any. */
+};
+
+
+//=============================================================================================================
+/**
+* The executor runs one worker per core, minus one left to the acquisition and GUI threads. Every worker owns a
+* task queue. Tasks submitted from a worker go to its own queue and are taken back newest first, which keeps the
+* data of a just finished task in the cache. Tasks submitted from other threads go to a shared queue. An idle
+* worker takes from its own queue, then the shared one, then steals the oldest task of another worker. Workers
+* without work sleep on a wait condition, they are never woken by timers.
+*
+* Plugins opt in by posting their processing to a PluginStrand instead of running their own QThread loop.
+*
+* @brief Shared work stealing thread pool for mne_scan plugins.
+*/
+class SCSHAREDSHARED_EXPORT PluginExecutor
+{
+public:
+    typedef QSharedPointer<PluginExecutor> SPtr;               /**< Shared pointer type for PluginExecutor. */
+    typedef QSharedPointer<const PluginExecutor> ConstSPtr;    /**< Const shared pointer type for PluginExecutor. */
+
+    //=========================================================================================================
+    /**
+    * Starts the workers.
+    *
+    * @param[in] iNumWorkers    Number of workers. One less than the number of cores, but at least one, if -1.
+    */
+    explicit PluginExecutor(int iNumWorkers = -1);
+
+    //=========================================================================================================
+    /**
+    * Runs the pending tasks and stops the workers.
+    */
+    ~PluginExecutor();
+
+    //=========================================================================================================
+    /**
+    * Returns the executor shared by all plugins.
+    *
+    * @return the executor instance.
+    */
+    static PluginExecutor* instance();
+
+    //=========================================================================================================
+    /**
+    * Submits a task. Tasks submitted with this method run in no particular order, use a strand for ordered
+    * processing.
+    *
+    * @param[in] task   The task to run.
+    */
+    void submit(const std::function<void()>& task);
+
+    //=========================================================================================================
+    /**
+    * Creates a strand which runs its tasks in order on this executor.
+    *
+    * @param[in] sName  The name of the strand, e.g. the plugin name.
+    *
+    * @return the strand.
+    */
+    PluginStrand::SPtr createStrand(const QString& sName);
+
+    //=========================================================================================================
+    /**
+    * Returns the number of workers.
+    *
+    * @return the number of workers.
+    */
+    inline int workerCount() const;
+
+    //=========================================================================================================
+    /**
+    * Returns how often a worker took a task out of the queue of another worker.
+    *
+    * @return the number of steals.
+    */
+    inline int stealCount() const;
+
+private:
+    friend class PluginExecutorWorker;
+
+    //=========================================================================================================
+    /**
+    * Takes the next task for a worker: its own newest task, the oldest shared task, or the oldest task of
+    * another worker.
+    *
+    * @param[in] iWorker    The index of the worker.
+    * @param[out] task      The task.
+    *
+    * @return true if a task was taken.
+    */
+    bool takeTask(int iWorker, std::function<void()>& task);
+
+    //=========================================================================================================
+    /**
+    * The loop of a worker. Runs tasks until the executor is destroyed.
+    *
+    * @param[in] iWorker    The index of the worker.
+    */
+    void runWorker(int iWorker);
+
+    //=========================================================================================================
+    /**
+    * Task queue of one worker, or the shared queue.
+    */
+    struct TaskQueue
+    {
+        QMutex                                  mutex;      /**< Guards the tasks. */
+        std::deque<std::function<void()> >     tasks;      /**< The queued tasks. */
+    };
+
+    QVector<QThread*>                       m_vecWorkers;       /**< The worker threads. */
+    QVector<TaskQueue*>                     m_vecQueues;        /**< The queue of every worker. */
+    TaskQueue                               m_sharedQueue;      /**< Tasks submitted from outside the workers. */
+
+    QMutex                                  m_sleepMutex;       /**< Guards sleeping and shutdown. */
+    QWaitCondition                          m_wakeUp;           /**< Signaled when tasks are submitted. */
+    QAtomicInt                              m_iPendingTasks;    /**< Number of queued tasks. */
+    QAtomicInt                              m_iSteals;          /**< Number of stolen tasks. */
+    bool                                    m_bShutdown;        /**< Whether the workers are told to stop. */
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline const QString& PluginStrand::name() const
+{
+    return m_sName;
+}
+
+
+//*************************************************************************************************************
+
+inline int PluginExecutor::workerCount() const
+{
+    return m_vecWorkers.size();
+}
+
+
+//*************************************************************************************************************
+
+inline int PluginExecutor::stealCount() const
+{
+    return m_iSteals.load();
+}
+
+} // NAMESPACE
+
+#endif // PLUGINEXECUTOR_H
@@ -39,9 +39,18 @@
 //=============================================================================================================
 
 #include "plugininputconnector.h"
+#include "pipelinetracer.h"
 #include "../Interfaces/IPlugin.h"
 
 
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QMutexLocker>
+
+
 //*************************************************************************************************************
 //=============================================================================================================
 // USED NAMESPACES
@@ -57,6 +66,9 @@ using namespace SCSHAREDLIB;
 
 PluginInputConnector::PluginInputConnector(IPlugin *parent, const QString &name, const QString &descr)
 : PluginConnector(parent, name, descr)
+, m_iQueueCapacity(MEASUREMENT_FRAME_QUEUE_DEFAULT_CAPACITY)
+, m_overflowPolicy(SCMEASLIB::MeasurementFrameQueue::DropOldest)
+, m_pStrand(PluginExecutor::instance()->createStrand(name))
 {
 }
 
@@ -77,9 +89,154 @@ bool PluginInputConnector::isOutputConnector() const
 }
 
 
+//*************************************************************************************************************
+
+SCMEASLIB::MeasurementFrameQueue::SPtr PluginInputConnector::frameQueue(const SCMEASLIB::NewMeasurement::SPtr& pSender)
+{
+    QMutexLocker locker(&m_qMutex);
+
+    SCMEASLIB::MeasurementFrameQueue::SPtr pQueue = m_qHashFrameQueues.value(pSender.data());
+
+    if(!pQueue) {
+        pQueue = SCMEASLIB::MeasurementFrameQueue::SPtr(new SCMEASLIB::MeasurementFrameQueue(m_iQueueCapacity, m_overflowPolicy));
+        m_qHashFrameQueues.insert(pSender.data(), pQueue);
+    }
+
+    return pQueue;
+}
+
+
+//*************************************************************************************************************
+
+SCMEASLIB::MeasurementFrameQueue::SPtr PluginInputConnector::removeFrameQueue(const SCMEASLIB::NewMeasurement::SPtr& pSender)
+{
+    m_qMutex.lock();
+    SCMEASLIB::MeasurementFrameQueue::SPtr pQueue = m_qHashFrameQueues.take(pSender.data());
+    m_qMutex.unlock();
+
+    //An update which is already posted finds no queue anymore, one which is running has to return first
+    m_pStrand->waitForDone();
+
+    return pQueue;
+}
+
+
+//*************************************************************************************************************
+
+QList<SCMEASLIB::MeasurementFrame::ConstSPtr> PluginInputConnector::takeFrames(const SCMEASLIB::NewMeasurement::SPtr& pSender)
+{
+    SCMEASLIB::MeasurementFrameQueue::SPtr pQueue = findFrameQueue(pSender);
+
+    if(!pQueue) {
+        return QList<SCMEASLIB::MeasurementFrame::ConstSPtr>();
+    }
+
+    QList<SCMEASLIB::MeasurementFrame::ConstSPtr> lFrames = pQueue->takeAll();
+
+    if(PipelineTracer::instance()->isEnabled()) {
+        PipelineTracer::instance()->recordFrames(QString("%1 / %2").arg(m_pPlugin->getName()).arg(getName()), lFrames);
+    }
+
+    return lFrames;
+}
+
+
+//*************************************************************************************************************
+
+void PluginInputConnector::setQueueCapacity(int iCapacity)
+{
+    QMutexLocker locker(&m_qMutex);
+    m_iQueueCapacity = iCapacity;
+
+    QHash<const SCMEASLIB::NewMeasurement*, SCMEASLIB::MeasurementFrameQueue::SPtr>::const_iterator it;
+    for(it = m_qHashFrameQueues.constBegin(); it != m_qHashFrameQueues.constEnd(); ++it) {
+        it.value()->setCapacity(iCapacity);
+    }
+}
+
+
+//*************************************************************************************************************
+
+void PluginInputConnector::setOverflowPolicy(SCMEASLIB::MeasurementFrameQueue::OverflowPolicy policy)
+{
+    QMutexLocker locker(&m_qMutex);
+    m_overflowPolicy = policy;
+
+    QHash<const SCMEASLIB::NewMeasurement*, SCMEASLIB::MeasurementFrameQueue::SPtr>::const_iterator it;
+    for(it = m_qHashFrameQueues.constBegin(); it != m_qHashFrameQueues.constEnd(); ++it) {
+        it.value()->setOverflowPolicy(policy);
+    }
+}
+
+
+//*************************************************************************************************************
+
+int PluginInputConnector::queuedFrames() const
+{
+    QMutexLocker locker(&m_qMutex);
+
+    int iQueued = 0;
+
+    QHash<const SCMEASLIB::NewMeasurement*, SCMEASLIB::MeasurementFrameQueue::SPtr>::const_iterator it;
+    for(it = m_qHashFrameQueues.constBegin(); it != m_qHashFrameQueues.constEnd(); ++it) {
+        iQueued += it.value()->size();
+    }
+
+    return iQueued;
+}
+
+
+//*************************************************************************************************************
+
+qint64 PluginInputConnector::droppedFrames() const
+{
+    QMutexLocker locker(&m_qMutex);
+
+    qint64 iDropped = 0;
+
+    QHash<const SCMEASLIB::NewMeasurement*, SCMEASLIB::MeasurementFrameQueue::SPtr>::const_iterator it;
+    for(it = m_qHashFrameQueues.constBegin(); it != m_qHashFrameQueues.constEnd(); ++it) {
+        iDropped += it.value()->droppedFrames();
+    }
+
+    return iDropped;
+}
+
+
 //*************************************************************************************************************
 
 void PluginInputConnector::update(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
 {
+    //Frames published from now on schedule a new update
+    SCMEASLIB::MeasurementFrameQueue::SPtr pQueue = findFrameQueue(pMeasurement);
+
+    if(pQueue) {
+        pQueue->acknowledgeWakeUp();
+    }
+
     emit notify(pMeasurement);
 }
+
+
+//*************************************************************************************************************
+
+void PluginInputConnector::wakeUp(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
+{
+    SCMEASLIB::MeasurementFrameQueue::SPtr pQueue = findFrameQueue(pMeasurement);
+
+    if(pQueue && pQueue->requestWakeUp()) {
+        //The strand runs the handlers of this input one after another, the measurement is kept alive by the task
+        m_pStrand->post([this, pMeasurement]() {
+            update(pMeasurement);
+        });
+    }
+}
+
+
+//*************************************************************************************************************
+
+SCMEASLIB::MeasurementFrameQueue::SPtr PluginInputConnector::findFrameQueue(const SCMEASLIB::NewMeasurement::SPtr& pSender) const
+{
+    QMutexLocker locker(&m_qMutex);
+    return m_qHashFrameQueues.value(pSender.data());
+}
@@ -43,8 +43,10 @@
 #include "../scshared_global.h"
 
 #include "pluginconnector.h"
+#include "pluginexecutor.h"
 
 #include <scMeas/newmeasurement.h>
+#include <scMeas/measurementframe.h>
 
 
 //*************************************************************************************************************
@@ -53,6 +55,8 @@
 //=============================================================================================================
 
 #include <QSharedPointer>
+#include <QHash>
+#include <QMutex>
 
 
 //*************************************************************************************************************
@@ -108,15 +112,111 @@ public:
      */
     virtual bool isOutputConnector() const;
 
+    //=========================================================================================================
+    /**
+     * Returns the frame queue of this input for the given sender, which is created on first use. Every sender gets
+     * its own queue, so frames of several senders are never interleaved. Connections subscribe this queue at the
+     * sender's measurement, so producers never wait for this input.
+     *
+     * @param[in] pSender        the measurement which feeds the queue.
+     *
+     * @return the frame queue for the sender.
+     */
+    SCMEASLIB::MeasurementFrameQueue::SPtr frameQueue(const SCMEASLIB::NewMeasurement::SPtr& pSender);
+
+    //=========================================================================================================
+    /**
+     * Removes the frame queue of the given sender and waits until a running notify() handler returned.
+     *
+     * @param[in] pSender        the measurement which fed the queue.
+     *
+     * @return the removed frame queue, empty if there was none.
+     */
+    SCMEASLIB::MeasurementFrameQueue::SPtr removeFrameQueue(const SCMEASLIB::NewMeasurement::SPtr& pSender);
+
+    //=========================================================================================================
+    /**
+     * Removes and returns the frames of the given sender received since the last call. To be called from the
+     * notify() handler with the measurement it was called with. The frames are shared with all other consumers and
+     * are immutable, keep the frame instead of copying its data. The dequeue is recorded by the PipelineTracer
+     * under the stage name "<plugin> / <input>".
+     *
+     * @param[in] pSender        the measurement which published the frames.
+     *
+     * @return the received frames in the order they were published.
+     */
+    QList<SCMEASLIB::MeasurementFrame::ConstSPtr> takeFrames(const SCMEASLIB::NewMeasurement::SPtr& pSender);
+
+    //=========================================================================================================
+    /**
+     * Sets the number of frames each queue of this input buffers before the overflow policy applies.
+     *
+     * @param[in] iCapacity      the maximum number of queued frames per sender.
+     */
+    void setQueueCapacity(int iCapacity);
+
+    //=========================================================================================================
+    /**
+     * Sets what happens to frames which arrive while a queue of this input is full.
+     *
+     * @param[in] policy     the overflow policy.
+     */
+    void setOverflowPolicy(SCMEASLIB::MeasurementFrameQueue::OverflowPolicy policy);
+
+    //=========================================================================================================
+    /**
+     * Returns the number of frames queued over all senders.
+     *
+     * @return the number of queued frames.
+     */
+    int queuedFrames() const;
+
+    //=========================================================================================================
+    /**
+     * Returns the number of frames dropped over all senders because a queue was full.
+     *
+     * @return the number of dropped frames.
+     */
+    qint64 droppedFrames() const;
 
 signals:
+    //=========================================================================================================
+    /**
+     * Emitted by update(). For streamed measurements update() runs on the plugin executor, so handlers have to be
+     * connected with Qt::DirectConnection to stay off the GUI thread. Handlers of one input never run concurrently.
+     */
     void notify(SCMEASLIB::NewMeasurement::SPtr pMeasurement);
 
 public slots:
     void update(SCMEASLIB::NewMeasurement::SPtr pMeasurement);
 
+    //=========================================================================================================
+    /**
+     * Called on the producer's thread after frames were published to the frame queue of the sender. Posts an
+     * update() to the strand of this input unless one is already pending for the sender, thus never blocks the
+     * producer. The strand runs the handlers in order on the shared plugin executor, not on the GUI thread.
+     *
+     * @param[in] pMeasurement   the measurement which published the frames.
+     */
+    void wakeUp(SCMEASLIB::NewMeasurement::SPtr pMeasurement);
+
+private:
+    //=========================================================================================================
+    /**
+     * Returns the frame queue of the given sender without creating it.
+     *
+     * @param[in] pSender        the measurement which feeds the queue.
+     *
+     * @return the frame queue, empty if there is none.
+     */
+    SCMEASLIB::MeasurementFrameQueue::SPtr findFrameQueue(const SCMEASLIB::NewMeasurement::SPtr& pSender) const;
 
+    mutable QMutex                                      m_qMutex;               /**< Guards the queues and the settings. */
+    QHash<const SCMEASLIB::NewMeasurement*, SCMEASLIB::MeasurementFrameQueue::SPtr> m_qHashFrameQueues;   /**< One frame queue per connected streaming measurement. */
+    int                                                 m_iQueueCapacity;       /**< The capacity of each queue. */
+    SCMEASLIB::MeasurementFrameQueue::OverflowPolicy    m_overflowPolicy;       /**< The overflow policy of each queue. */
 
+    PluginStrand::SPtr                                  m_pStrand;              /**< Runs update() on the plugin executor. Declared last, so it is drained before the queues are destroyed. */
 };
 
 } // NAMESPACE
@@ -0,0 +1,130 @@
+//=============================================================================================================
+/**
+* @file     readylatch.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     Definition of the ReadyLatch class.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "readylatch.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QMutexLocker>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace SCSHAREDLIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+ReadyLatch::ReadyLatch()
+: m_bOpen(false)
+, m_bCancelled(false)
+{
+}
+
+
+//*************************************************************************************************************
+
+void ReadyLatch::open()
+{
+    QMutexLocker locker(&m_mutex);
+    m_bOpen = true;
+    m_condition.wakeAll();
+}
+
+
+//*************************************************************************************************************
+
+void ReadyLatch::close()
+{
+    QMutexLocker locker(&m_mutex);
+    m_bOpen = false;
+}
+
+
+//*************************************************************************************************************
+
+void ReadyLatch::cancel()
+{
+    QMutexLocker locker(&m_mutex);
+    m_bCancelled = true;
+    m_condition.wakeAll();
+}
+
+
+//*************************************************************************************************************
+
+void ReadyLatch::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    m_bCancelled = false;
+}
+
+
+//*************************************************************************************************************
+
+bool ReadyLatch::isOpen() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_bOpen;
+}
+
+
+//*************************************************************************************************************
+
+bool ReadyLatch::wait()
+{
+    QMutexLocker locker(&m_mutex);
+
+    while(!m_bOpen && !m_bCancelled) {
+        m_condition.wait(&m_mutex);
+    }
+
+    return m_bOpen && !m_bCancelled;
+}
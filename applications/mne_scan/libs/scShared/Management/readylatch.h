@@ -0,0 +1,133 @@
+//=============================================================================================================
+/**
+* @file     readylatch.h
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     Declaration of the ReadyLatch class.
+*
+*/
+
+#ifndef READYLATCH_H
+#define READYLATCH_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "../scshared_global.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QSharedPointer>
+#include <QMutex>
+#include <QWaitCondition>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE SCSHAREDLIB
+//=============================================================================================================
+
+namespace SCSHAREDLIB
+{
+
+//=============================================================================================================
+/**
+* Plugin threads wait on the latch for their first measurement information instead of polling for it. The input
+* handler opens the latch once the information is set; stop() cancels it, so a plugin which is stopped before any
+* data arrived leaves its run() loop.
+*
+* @brief Event driven wait for a plugin to become ready.
+*/
+class SCSHAREDSHARED_EXPORT ReadyLatch
+{
+public:
+    typedef QSharedPointer<ReadyLatch> SPtr;               /**< Shared pointer type for ReadyLatch. */
+    typedef QSharedPointer<const ReadyLatch> ConstSPtr;    /**< Const shared pointer type for ReadyLatch. */
+
+    //=========================================================================================================
+    /**
+    * Constructs a closed latch.
+    */
+    ReadyLatch();
+
+    //=========================================================================================================
+    /**
+    * Opens the latch and wakes all waiting threads. The latch stays open until close() is called.
+    */
+    void open();
+
+    //=========================================================================================================
+    /**
+    * Closes the latch.
+    */
+    void close();
+
+    //=========================================================================================================
+    /**
+    * Wakes all waiting threads without opening the latch. wait() returns false until reset() is called.
+    */
+    void cancel();
+
+    //=========================================================================================================
+    /**
+    * Takes back a cancel(). Whether the latch is open stays unchanged.
+    */
+    void reset();
+
+    //=========================================================================================================
+    /**
+    * Returns whether the latch is open.
+    *
+    * @return true if open.
+    */
+    bool isOpen() const;
+
+    //=========================================================================================================
+    /**
+    * Blocks until the latch is opened or cancelled.
+    *
+    * @return true if the latch is open, false if it was cancelled.
+    */
+    bool wait();
+
+private:
+    mutable QMutex      m_mutex;        /**< Guards the flags. */
+    QWaitCondition      m_condition;    /**< Signaled when the latch is opened or cancelled. */
+    bool                m_bOpen;        /**< Whether the latch is open. */
+    bool                m_bCancelled;   /**< Whether waiting is cancelled. */
+};
+
+} // NAMESPACE
+
+#endif // READYLATCH_H
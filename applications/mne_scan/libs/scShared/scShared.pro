@@ -88,7 +88,10 @@ SOURCES += \
     Management/pluginconnectorconnection.cpp \
     Management/pluginconnectorconnectionwidget.cpp \
     Management/pluginscenemanager.cpp \
-    Management/displaymanager.cpp
+    Management/displaymanager.cpp \
+    Management/pipelinetracer.cpp \
+    Management/pluginexecutor.cpp \
+    Management/readylatch.cpp
 
 HEADERS += \
     scshared_global.h \
@@ -105,7 +108,10 @@ HEADERS += \
     Management/pluginconnectorconnection.h \
     Management/pluginconnectorconnectionwidget.h \
     Management/pluginscenemanager.h \
-    Management/displaymanager.h
+    Management/displaymanager.h \
+    Management/pipelinetracer.h \
+    Management/pluginexecutor.h \
+    Management/readylatch.h
 
 
 INCLUDEPATH += $${EIGEN_INCLUDE_DIR}
@@ -40,6 +40,7 @@ TEMPLATE = subdirs
 SUBDIRS += \
     libs \
     mne_scan \
+    mne_scan_bench \
     plugins
 
 CONFIG += ordered
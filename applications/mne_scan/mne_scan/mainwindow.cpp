@@ -47,6 +47,7 @@
 #include "runwidget.h"
 #include "startupwidget.h"
 #include "plugingui.h"
+#include "pipelinetracewidget.h"
 
 
 //*************************************************************************************************************
@@ -125,6 +126,7 @@ MainWindow::MainWindow(QWidget *parent)
     createToolBars();
     createPluginDockWindow();
     createLogDockWindow();
+    createPipelineTraceDockWindow();
 
 //    //ToDo Debug Startup
 //    writeToLog(tr("Test normal message, Max"), _LogKndMessage, _LogLvMax);
@@ -587,6 +589,25 @@ void MainWindow::createLogDockWindow()
 }
 
 
+//*************************************************************************************************************
+
+void MainWindow::createPipelineTraceDockWindow()
+{
+    m_pDockWidget_PipelineTrace = new QDockWidget(tr("Pipeline Latency"), this);
+
+    m_pPipelineTraceWidget = new PipelineTraceWidget(m_pDockWidget_PipelineTrace);
+
+    m_pDockWidget_PipelineTrace->setWidget(m_pPipelineTraceWidget);
+
+    m_pDockWidget_PipelineTrace->setAllowedAreas(Qt::BottomDockWidgetArea);
+    addDockWidget(Qt::BottomDockWidgetArea, m_pDockWidget_PipelineTrace);
+
+    m_pDockWidget_PipelineTrace->hide();
+
+    m_pMenuView->addAction(m_pDockWidget_PipelineTrace->toggleViewAction());
+}
+
+
 //*************************************************************************************************************
 //Plugin stuff
 void MainWindow::updatePluginWidget(SCSHAREDLIB::IPlugin::SPtr pPlugin)
@@ -106,6 +106,7 @@ class PluginGui;
 
 class RunWidget;
 class PluginDockWidget;
+class PipelineTraceWidget;
 
 
 //=============================================================================================================
@@ -247,6 +248,7 @@ private:
 
     void createPluginDockWindow();                          /**< Creates plugin dock widget.*/
     void createLogDockWindow();                             /**< Creates log dock widget.*/
+    void createPipelineTraceDockWindow();                   /**< Creates pipeline trace dock widget.*/
 
     //Plugin Management
     QDockWidget*                        m_pPluginGuiDockWidget;         /**< Dock widget which holds the plugin gui. */
@@ -257,6 +259,8 @@ private:
     //Log
     QDockWidget*                        m_pDockWidget_Log;              /**< Holds the dock widget containing the log.*/
     QTextBrowser*                       m_pTextBrowser_Log;             /**< Holds the text browser for the log.*/
+    QDockWidget*                        m_pDockWidget_PipelineTrace;    /**< Holds the dock widget containing the pipeline latency statistics.*/
+    PipelineTraceWidget*                m_pPipelineTraceWidget;         /**< Holds the pipeline latency statistics.*/
 
     LogLevel                            m_eLogLevelCurrent;             /**< Holds the current log level.*/
 
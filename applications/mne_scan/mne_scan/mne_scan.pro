@@ -94,7 +94,8 @@ SOURCES += \
     pluginitem.cpp \
     plugingui.cpp \
     arrow.cpp \
-    mainwindow.cpp
+    mainwindow.cpp \
+    pipelinetracewidget.cpp
 
 HEADERS += \
     info.h \
@@ -105,7 +106,8 @@ HEADERS += \
     pluginitem.h \
     plugingui.h \
     arrow.h \
-    mainwindow.h
+    mainwindow.h \
+    pipelinetracewidget.h
 
 FORMS +=
 
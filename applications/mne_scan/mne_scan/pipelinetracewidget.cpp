@@ -0,0 +1,238 @@
+//=============================================================================================================
+/**
+* @file     pipelinetracewidget.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     Definition of the PipelineTraceWidget class.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "pipelinetracewidget.h"
+
+#include <scShared/Management/pipelinetracer.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QCheckBox>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QTimer>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace MNESCAN;
+using namespace SCSHAREDLIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+PipelineTraceWidget::PipelineTraceWidget(QWidget *parent)
+: QWidget(parent)
+{
+    m_pCheckBoxEnable = new QCheckBox(tr("Record"));
+    m_pCheckBoxEnable->setChecked(PipelineTracer::instance()->isEnabled());
+    m_pCheckBoxEnable->setToolTip(tr("Records the enqueue, dequeue and processing times of all pipeline stages"));
+
+    m_pPushButtonReset = new QPushButton(tr("Reset"));
+    m_pPushButtonExport = new QPushButton(tr("Export Chrome trace..."));
+
+    QStringList slHeader;
+    slHeader << tr("Stage")
+             << tr("Frames")
+             << tr("Runs")
+             << tr("Rate [1/s]")
+             << tr("Since acq. mean [ms]")
+             << tr("Since acq. max [ms]")
+             << tr("Queue mean [ms]")
+             << tr("Queue p95 [ms]")
+             << tr("Queue max [ms]")
+             << tr("Proc. mean [ms]")
+             << tr("Proc. p95 [ms]")
+             << tr("Proc. max [ms]");
+
+    m_pTableWidget = new QTableWidget(0, slHeader.size());
+    m_pTableWidget->setHorizontalHeaderLabels(slHeader);
+    m_pTableWidget->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_pTableWidget->verticalHeader()->hide();
+    m_pTableWidget->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+
+    QHBoxLayout* pHBoxLayout = new QHBoxLayout;
+    pHBoxLayout->addWidget(m_pCheckBoxEnable);
+    pHBoxLayout->addStretch();
+    pHBoxLayout->addWidget(m_pPushButtonReset);
+    pHBoxLayout->addWidget(m_pPushButtonExport);
+
+    QVBoxLayout* pVBoxLayout = new QVBoxLayout;
+    pVBoxLayout->addLayout(pHBoxLayout);
+    pVBoxLayout->addWidget(m_pTableWidget);
+    setLayout(pVBoxLayout);
+
+    connect(m_pCheckBoxEnable, &QCheckBox::toggled,
+            this, &PipelineTraceWidget::onTracingToggled);
+    connect(m_pPushButtonReset, &QPushButton::clicked,
+            this, &PipelineTraceWidget::onReset);
+    connect(m_pPushButtonExport, &QPushButton::clicked,
+            this, &PipelineTraceWidget::onExport);
+
+    m_pTimer = new QTimer(this);
+    connect(m_pTimer, &QTimer::timeout,
+            this, &PipelineTraceWidget::updateStatistics);
+    m_pTimer->start(1000);
+}
+
+
+//*************************************************************************************************************
+
+void PipelineTraceWidget::onTracingToggled(bool bEnabled)
+{
+    PipelineTracer::instance()->setEnabled(bEnabled);
+}
+
+
+//*************************************************************************************************************
+
+void PipelineTraceWidget::onReset()
+{
+    PipelineTracer::instance()->reset();
+    m_pTableWidget->setRowCount(0);
+}
+
+
+//*************************************************************************************************************
+
+void PipelineTraceWidget::onExport()
+{
+    QString sFileName = QFileDialog::getSaveFileName(this,
+                                                     tr("Export Chrome trace"),
+                                                     "mne_scan_trace.json",
+                                                     tr("Chrome trace (*.json)"));
+    if(sFileName.isEmpty()) {
+        return;
+    }
+
+    if(!PipelineTracer::instance()->exportChromeTrace(sFileName)) {
+        QMessageBox::warning(this, tr("Export Chrome trace"), tr("Could not write %1.").arg(sFileName));
+    }
+}
+
+
+//*************************************************************************************************************
+
+void PipelineTraceWidget::updateStatistics()
+{
+    if(!isVisible()) {
+        return;
+    }
+
+    QList<PipelineStageStatistics> lStatistics = PipelineTracer::instance()->statistics();
+
+    m_pTableWidget->setRowCount(lStatistics.size());
+
+    for(int i = 0; i < lStatistics.size(); ++i) {
+        const PipelineStageStatistics& stats = lStatistics.at(i);
+
+        //The p95 is the upper edge of the histogram bin which contains it
+        double dQueueP95 = percentile(stats.vecQueueHistogram, 0.95);
+        double dProcP95 = percentile(stats.vecProcessingHistogram, 0.95);
+
+        QString sQueueP95 = stats.iNumFrames == 0 ? QString("-") : dQueueP95 < 0 ? QString("> %1").arg(PipelineTracer::histogramBinEdges().last()) : QString("< %1").arg(dQueueP95);
+        QString sProcP95 = stats.iNumProcessed == 0 ? QString("-") : dProcP95 < 0 ? QString("> %1").arg(PipelineTracer::histogramBinEdges().last()) : QString("< %1").arg(dProcP95);
+
+        QStringList slRow;
+        slRow << stats.sStage
+              << QString::number(stats.iNumFrames)
+              << QString::number(stats.iNumProcessed)
+              << QString::number(stats.dThroughput, 'f', 1)
+              << QString::number(stats.dMeanLatency, 'f', 2)
+              << QString::number(stats.dMaxLatency, 'f', 2)
+              << QString::number(stats.dMeanQueueLatency, 'f', 2)
+              << sQueueP95
+              << QString::number(stats.dMaxQueueLatency, 'f', 2)
+              << QString::number(stats.dMeanProcessingTime, 'f', 2)
+              << sProcP95
+              << QString::number(stats.dMaxProcessingTime, 'f', 2);
+
+        for(int j = 0; j < slRow.size(); ++j) {
+            QTableWidgetItem* pItem = m_pTableWidget->item(i, j);
+            if(!pItem) {
+                pItem = new QTableWidgetItem;
+                m_pTableWidget->setItem(i, j, pItem);
+            }
+            pItem->setText(slRow.at(j));
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+double PipelineTraceWidget::percentile(const QVector<qint64>& vecHistogram, double dPercentile)
+{
+    QVector<double> vecEdges = PipelineTracer::histogramBinEdges();
+
+    qint64 iTotal = 0;
+    for(int i = 0; i < vecHistogram.size(); ++i) {
+        iTotal += vecHistogram.at(i);
+    }
+
+    if(iTotal == 0) {
+        return 0.0;
+    }
+
+    qint64 iCount = 0;
+    for(int i = 0; i < vecHistogram.size() && i < vecEdges.size(); ++i) {
+        iCount += vecHistogram.at(i);
+        if(iCount >= dPercentile * iTotal) {
+            return vecEdges.at(i);
+        }
+    }
+
+    return -1.0;
+}
@@ -0,0 +1,138 @@
+//=============================================================================================================
+/**
+* @file     pipelinetracewidget.h
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     Declaration of the PipelineTraceWidget class.
+*
+*/
+
+#ifndef PIPELINETRACEWIDGET_H
+#define PIPELINETRACEWIDGET_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QWidget>
+#include <QVector>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// FORWARD DECLARATIONS
+//=============================================================================================================
+
+class QCheckBox;
+class QPushButton;
+class QTableWidget;
+class QTimer;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE MNESCAN
+//=============================================================================================================
+
+namespace MNESCAN
+{
+
+//=============================================================================================================
+/**
+* DECLARE CLASS PipelineTraceWidget
+*
+* @brief The PipelineTraceWidget class shows the latency and throughput of the pipeline stages recorded by the
+*        PipelineTracer and exports the trace in the Chrome trace format.
+*/
+class PipelineTraceWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    //=========================================================================================================
+    /**
+    * Constructs a PipelineTraceWidget which is a child of parent.
+    *
+    * @param [in] parent pointer to parent widget.
+    */
+    PipelineTraceWidget(QWidget* parent = 0);
+
+private:
+    //=========================================================================================================
+    /**
+    * Enables or disables the tracing.
+    *
+    * @param [in] bEnabled whether events are recorded.
+    */
+    void onTracingToggled(bool bEnabled);
+
+    //=========================================================================================================
+    /**
+    * Discards the recorded events and clears the table.
+    */
+    void onReset();
+
+    //=========================================================================================================
+    /**
+    * Asks for a file name and exports the recorded events in the Chrome trace format.
+    */
+    void onExport();
+
+    //=========================================================================================================
+    /**
+    * Refreshes the table from the tracer statistics.
+    */
+    void updateStatistics();
+
+    //=========================================================================================================
+    /**
+    * Estimates a percentile from a histogram of the tracer.
+    *
+    * @param [in] vecHistogram  the counts per bin.
+    * @param [in] dPercentile   the percentile in [0,1].
+    *
+    * @return the upper edge in ms of the bin containing the percentile, -1 if it lies in the open ended bin.
+    */
+    static double percentile(const QVector<qint64>& vecHistogram, double dPercentile);
+
+    QCheckBox*      m_pCheckBoxEnable;      /**< Enables the tracing. */
+    QPushButton*    m_pPushButtonReset;     /**< Resets the tracer. */
+    QPushButton*    m_pPushButtonExport;    /**< Exports the Chrome trace. */
+    QTableWidget*   m_pTableWidget;         /**< The per stage statistics. */
+    QTimer*         m_pTimer;               /**< Refresh timer. */
+};
+
+} // NAMESPACE
+
+#endif // PIPELINETRACEWIDGET_H
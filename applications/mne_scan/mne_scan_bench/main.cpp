@@ -0,0 +1,245 @@
+//=============================================================================================================
+/**
+* @file     main.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     Implements the main() of mne_scan_bench, a headless runner which replays a FIFF file through a saved MNE Scan plugin scene and reports per plugin CPU time, throughput and the maximum sustainable real-time factor.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "scenebenchmark.h"
+
+#include <scMeas/measurementtypes.h>
+#include <scShared/Management/pipelinetracer.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <QFileInfo>
+#include <QDebug>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace MNESCANBENCH;
+using namespace SCSHAREDLIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+//=============================================================================================================
+/**
+* Prints the per plugin load of a trial.
+*
+* @param [in] out       the stream to print to.
+* @param [in] trial     the trial to print.
+*/
+void printTrial(QTextStream& out, const BenchmarkTrial& trial)
+{
+    out << QString("  speed %1, %2 s of data replayed in %3 s, drained after %4 s: %5")
+           .arg(trial.dSpeed > 0.0 ? QString("%1x").arg(trial.dSpeed, 0, 'f', 2) : QString("as fast as possible"))
+           .arg(trial.dDataTime, 0, 'f', 1)
+           .arg(trial.dReplayTime, 0, 'f', 2)
+           .arg(trial.dDrainTime, 0, 'f', 2)
+           .arg(trial.bSustainable ? QString("sustained") : QString("not sustained (%1)").arg(trial.sReason)) << endl;
+
+    out << QString("    %1 %2 %3 %4 %5 %6 %7 %8")
+           .arg("Plugin", -24)
+           .arg("CPU [s]", 9)
+           .arg("RTF bound", 10)
+           .arg("Samples", 10)
+           .arg("Samples/s", 11)
+           .arg("Proc mean/max [ms]", 20)
+           .arg("Queue max [ms]", 15)
+           .arg("Dropped", 8) << endl;
+
+    for(int i = 0; i < trial.lPlugins.size(); ++i) {
+        const PluginBenchmark& plugin = trial.lPlugins.at(i);
+
+        // Seconds of data one CPU second of the plugin thread handles
+        QString sBound = plugin.dCpuTime > 0.0 ? QString::number(trial.dDataTime / plugin.dCpuTime, 'f', 1) : QString("-");
+        QString sCpu = plugin.dCpuTime >= 0.0 ? QString::number(plugin.dCpuTime, 'f', 2) : QString("n/a");
+        QString sProcessing = plugin.iNumProcessed > 0 ? QString("%1/%2").arg(plugin.dMeanProcessingTime, 0, 'f', 2).arg(plugin.dMaxProcessingTime, 0, 'f', 2) : QString("-");
+
+        out << QString("    %1 %2 %3 %4 %5 %6 %7 %8")
+               .arg(plugin.sPlugin, -24)
+               .arg(sCpu, 9)
+               .arg(sBound, 10)
+               .arg(plugin.iNumSamples, 10)
+               .arg(plugin.dSampleThroughput, 11, 'f', 0)
+               .arg(sProcessing, 20)
+               .arg(plugin.dMaxQueueLatency, 15, 'f', 1)
+               .arg(plugin.iDroppedFrames, 8) << endl;
+    }
+
+    // Worker threads of the plugins and the event loop running the connector updates
+    QMap<QString, double>::const_iterator it;
+    for(it = trial.qMapThreadCpu.constBegin(); it != trial.qMapThreadCpu.constEnd(); ++it) {
+        bool bPluginThread = false;
+        for(int i = 0; i < trial.lPlugins.size(); ++i) {
+            bPluginThread |= trial.lPlugins.at(i).sPlugin.left(15) == it.key();
+        }
+        if(!bPluginThread && it.value() >= 0.01) {
+            out << QString("      thread %1 %2 s CPU").arg(it.key(), -24).arg(it.value(), 0, 'f', 2) << endl;
+        }
+    }
+}
+
+
+//=============================================================================================================
+/**
+* The function main marks the entry point of the program.
+* By default, main has the storage class extern.
+*
+* @param [in] argc (argument count) is an integer that indicates how many arguments were entered on the command line when the program was started.
+* @param [in] argv (argument vector) is an array of pointers to arrays of character objects. The array objects are null-terminated strings, representing the arguments that were entered on the command line when the program was started.
+* @return the value that was set to exit() (which is 0 if exit() is called via quit()).
+*/
+int main(int argc, char *argv[])
+{
+    // Plugins create their widgets on init, run them without a display
+    if(qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication app(argc, argv);
+
+    QCoreApplication::setOrganizationName("MNE-CPP");
+    QCoreApplication::setOrganizationDomain("www.tu-ilmenau.de/mne-cpp");
+    QCoreApplication::setApplicationName("mne_scan_bench");
+
+    // Command Line Parser
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays a FIFF raw file through MNE Scan plugin scenes without display and reports per plugin CPU time, throughput and the maximum sustainable real-time factor.");
+    parser.addHelpOption();
+
+    QCommandLineOption sceneOption("scene", "The plugin scene <file> saved by MNE Scan, or 'filter' (NoiseReduction, Averaging, Covariance and RTC-MNE) or 'rtsss' (RtSss and RtHpi). Runs both standard scenes if omitted.", "file");
+    QCommandLineOption rawOption("raw", "The replayed FIFF raw <file>.", "file", "./MNE-sample-data/MEG/sample/sample_audvis_raw.fif");
+    QCommandLineOption speedOption("speed", "Run a single trial at the real-time <factor>, 0 for as fast as possible, instead of searching the maximum sustainable factor.", "factor");
+    QCommandLineOption durationOption("duration", "The replayed <seconds> of data per trial, 0 for the whole file.", "seconds", "30");
+    QCommandLineOption blockSizeOption("blockSize", "The number of <samples> per block.", "samples", "200");
+    QCommandLineOption maxLatencyOption("maxLatency", "The queue latency and drain time budget in <ms> of a sustainable trial.", "ms", QString::number(SCENE_BENCHMARK_DEFAULT_MAX_LATENCY));
+    QCommandLineOption maxSpeedOption("maxSpeed", "The highest real-time <factor> tried by the search.", "factor", "64");
+    QCommandLineOption bisectionOption("bisection", "The number of bisection <steps> of the search.", "steps", "4");
+    QCommandLineOption traceOption("trace", "Export the Chrome trace of the last trial to <file>.", "file");
+    QCommandLineOption pluginDirOption("pluginDir", "The <directory> holding the MNE Scan plugins.", "directory", QCoreApplication::applicationDirPath() + "/mne_scan_plugins");
+
+    parser.addOption(sceneOption);
+    parser.addOption(rawOption);
+    parser.addOption(speedOption);
+    parser.addOption(durationOption);
+    parser.addOption(blockSizeOption);
+    parser.addOption(maxLatencyOption);
+    parser.addOption(maxSpeedOption);
+    parser.addOption(bisectionOption);
+    parser.addOption(traceOption);
+    parser.addOption(pluginDirOption);
+
+    parser.process(app);
+
+    SCMEASLIB::MeasurementTypes::registerTypes();
+
+    QMap<QString, QString> qMapStandardScenes;
+    qMapStandardScenes.insert("filter", ":/scenes/filter_averaging_mne.xml");
+    qMapStandardScenes.insert("rtsss", ":/scenes/rtsss_hpi.xml");
+
+    QStringList slScenes;
+    if(parser.isSet(sceneOption)) {
+        QString sScene = parser.value(sceneOption);
+        slScenes << (qMapStandardScenes.contains(sScene) ? qMapStandardScenes[sScene] : sScene);
+    } else {
+        slScenes << qMapStandardScenes["filter"] << qMapStandardScenes["rtsss"];
+    }
+
+    if(!QFileInfo(parser.value(rawOption)).exists()) {
+        qCritical() << "Raw file" << parser.value(rawOption) << "not found.";
+        return 1;
+    }
+
+    SceneBenchmark benchmark(parser.value(pluginDirOption));
+    benchmark.setReplay(parser.value(rawOption), parser.value(blockSizeOption).toInt(), parser.value(durationOption).toDouble());
+    benchmark.setMaxLatency(parser.value(maxLatencyOption).toDouble());
+
+    QTextStream out(stdout);
+    int iReturn = 0;
+
+    for(int i = 0; i < slScenes.size(); ++i) {
+        out << "Scene " << slScenes[i] << endl;
+
+        if(!benchmark.loadScene(slScenes[i])) {
+            out << "  could not be loaded" << endl;
+            iReturn = 1;
+            continue;
+        }
+
+        if(parser.isSet(speedOption)) {
+            printTrial(out, benchmark.runTrial(parser.value(speedOption).toDouble()));
+        } else {
+            // As fast as possible for the raw processing cost, then the search for the sustainable speed
+            printTrial(out, benchmark.runTrial(0.0));
+
+            QList<BenchmarkTrial> lTrials;
+            double dMaxFactor = benchmark.findMaxRealTimeFactor(lTrials, parser.value(maxSpeedOption).toDouble(), parser.value(bisectionOption).toInt());
+
+            for(int j = 0; j < lTrials.size(); ++j) {
+                printTrial(out, lTrials[j]);
+            }
+
+            double dMinSpeed = lTrials.isEmpty() ? 1.0 : lTrials.last().dSpeed;
+            for(int j = 0; j < lTrials.size(); ++j) {
+                dMinSpeed = qMin(dMinSpeed, lTrials[j].dSpeed);
+            }
+
+            out << QString("  maximum sustainable real-time factor: %1").arg(dMaxFactor > 0.0 ? QString::number(dMaxFactor, 'f', 2) : QString("< %1").arg(dMinSpeed, 0, 'f', 2)) << endl;
+        }
+
+        if(parser.isSet(traceOption)) {
+            PipelineTracer::instance()->exportChromeTrace(parser.value(traceOption));
+        }
+    }
+
+    return iReturn;
+}
@@ -0,0 +1,244 @@
+//=============================================================================================================
+/**
+* @file     replaysensor.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     Contains the definition of the ReplaySensor class.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "replaysensor.h"
+
+#include <fiff/fiff_raw_data.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QFile>
+#include <QElapsedTimer>
+#include <QDebug>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace MNESCANBENCH;
+using namespace SCSHAREDLIB;
+using namespace SCMEASLIB;
+using namespace FIFFLIB;
+using namespace Eigen;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+ReplaySensor::ReplaySensor(const QString& sFileName, double dSpeed, int iBlockSize, double dDuration)
+: m_sFileName(sFileName)
+, m_dSpeed(dSpeed)
+, m_iBlockSize(qMax(1, iBlockSize))
+, m_dDuration(dDuration)
+, m_bIsRunning(false)
+, m_iPublishedSamples(0)
+, m_dReplayTime(0.0)
+{
+}
+
+
+//*************************************************************************************************************
+
+ReplaySensor::~ReplaySensor()
+{
+    if(this->isRunning()) {
+        stop();
+    }
+}
+
+
+//*************************************************************************************************************
+
+QSharedPointer<IPlugin> ReplaySensor::clone() const
+{
+    QSharedPointer<ReplaySensor> pReplaySensorClone(new ReplaySensor(m_sFileName, m_dSpeed, m_iBlockSize, m_dDuration));
+    return pReplaySensorClone;
+}
+
+
+//*************************************************************************************************************
+
+void ReplaySensor::init()
+{
+    m_pRTMSA_ReplaySensor = PluginOutputData<NewRealTimeMultiSampleArray>::create(this, "ReplaySensor", "Replay Sensor Output");
+    m_pRTMSA_ReplaySensor->data()->setName(this->getName());
+    m_outputConnectors.append(m_pRTMSA_ReplaySensor);
+
+    QFile t_fileRaw(m_sFileName);
+    FiffRawData raw(t_fileRaw);
+
+    if(raw.isEmpty()) {
+        qWarning() << "[ReplaySensor::init] Could not read raw data from" << m_sFileName;
+        return;
+    }
+
+    qint64 iNumSamples = raw.last_samp - raw.first_samp + 1;
+    if(m_dDuration > 0.0) {
+        iNumSamples = qMin(iNumSamples, static_cast<qint64>(m_dDuration * raw.info.sfreq));
+    }
+
+    MatrixXd times;
+    if(!raw.read_raw_segment(m_matData, times, raw.first_samp, raw.first_samp + static_cast<fiff_int_t>(iNumSamples) - 1)) {
+        qWarning() << "[ReplaySensor::init] Could not read raw segment from" << m_sFileName;
+        m_matData.resize(0, 0);
+        return;
+    }
+
+    m_pFiffInfo = QSharedPointer<FiffInfo>(new FiffInfo(raw.info));
+
+    m_pRTMSA_ReplaySensor->data()->initFromFiffInfo(m_pFiffInfo);
+    m_pRTMSA_ReplaySensor->data()->setMultiArraySize(1);
+    m_pRTMSA_ReplaySensor->data()->setVisibility(false);
+}
+
+
+//*************************************************************************************************************
+
+void ReplaySensor::unload()
+{
+}
+
+
+//*************************************************************************************************************
+
+bool ReplaySensor::start()
+{
+    if(m_matData.cols() == 0) {
+        qWarning() << "[ReplaySensor::start] No data loaded.";
+        return false;
+    }
+
+    m_iPublishedSamples = 0;
+    m_dReplayTime = 0.0;
+    m_bIsRunning = true;
+
+    QThread::start();
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+bool ReplaySensor::stop()
+{
+    m_bIsRunning = false;
+
+    QThread::wait();
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+IPlugin::PluginType ReplaySensor::getType() const
+{
+    return _ISensor;
+}
+
+
+//*************************************************************************************************************
+
+QString ReplaySensor::getName() const
+{
+    return "Replay Sensor";
+}
+
+
+//*************************************************************************************************************
+
+QWidget* ReplaySensor::setupWidget()
+{
+    return Q_NULLPTR;
+}
+
+
+//*************************************************************************************************************
+
+void ReplaySensor::setSpeed(double dSpeed)
+{
+    m_dSpeed = qMax(0.0, dSpeed);
+}
+
+
+//*************************************************************************************************************
+
+double ReplaySensor::samplingFrequency() const
+{
+    return m_pFiffInfo ? m_pFiffInfo->sfreq : 0.0;
+}
+
+
+//*************************************************************************************************************
+
+void ReplaySensor::run()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    qint64 iNumSamples = m_matData.cols();
+    double dSamplesPerUs = m_pFiffInfo->sfreq * m_dSpeed / 1.0e6;
+
+    for(qint64 iFrom = 0; iFrom < iNumSamples && m_bIsRunning; iFrom += m_iBlockSize) {
+        qint64 iCols = qMin(static_cast<qint64>(m_iBlockSize), iNumSamples - iFrom);
+
+        // A block is available once its last sample has been acquired
+        if(dSamplesPerUs > 0.0) {
+            qint64 iWaitUs = static_cast<qint64>((iFrom + iCols) / dSamplesPerUs) - timer.nsecsElapsed() / 1000;
+            if(iWaitUs > 0) {
+                usleep(static_cast<unsigned long>(iWaitUs));
+            }
+        }
+
+        m_pRTMSA_ReplaySensor->data()->setValue(m_matData.middleCols(iFrom, iCols));
+        m_iPublishedSamples += iCols;
+    }
+
+    m_dReplayTime = timer.nsecsElapsed() / 1.0e9;
+}
@@ -0,0 +1,248 @@
+//=============================================================================================================
+/**
+* @file     replaysensor.h
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     Contains the declaration of the ReplaySensor class.
+*
+*/
+
+#ifndef REPLAYSENSOR_H
+#define REPLAYSENSOR_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <scShared/Interfaces/ISensor.h>
+#include <scShared/Management/pluginoutputdata.h>
+#include <scMeas/newrealtimemultisamplearray.h>
+
+#include <fiff/fiff_info.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QSharedPointer>
+#include <QString>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE MNESCANBENCH
+//=============================================================================================================
+
+namespace MNESCANBENCH
+{
+
+//=============================================================================================================
+/**
+* DECLARE CLASS ReplaySensor
+*
+* @brief The ReplaySensor class replays a FIFF raw file as sensor of a plugin scene. The data is loaded when the
+*        sensor is initialized and published block wise, either as fast as possible or paced at a multiple of
+*        the recording rate.
+*/
+class ReplaySensor : public SCSHAREDLIB::ISensor
+{
+    Q_OBJECT
+
+public:
+    typedef QSharedPointer<ReplaySensor> SPtr;             /**< Shared pointer type for ReplaySensor. */
+    typedef QSharedPointer<const ReplaySensor> ConstSPtr;  /**< Const shared pointer type for ReplaySensor. */
+
+    //=========================================================================================================
+    /**
+    * Constructs a ReplaySensor.
+    *
+    * @param [in] sFileName     the FIFF raw file to replay.
+    * @param [in] dSpeed        the replay speed as multiple of real-time, 0 replays as fast as possible.
+    * @param [in] iBlockSize    the number of samples per published block.
+    * @param [in] dDuration     the replayed duration in seconds, a value <= 0 replays the whole file.
+    */
+    ReplaySensor(const QString& sFileName = QString(), double dSpeed = 1.0, int iBlockSize = 200, double dDuration = -1.0);
+
+    //=========================================================================================================
+    /**
+    * Destroys the ReplaySensor.
+    */
+    virtual ~ReplaySensor();
+
+    //=========================================================================================================
+    /**
+    * Clone the sensor together with its replay settings.
+    */
+    virtual QSharedPointer<SCSHAREDLIB::IPlugin> clone() const;
+
+    //=========================================================================================================
+    /**
+    * Loads the raw data and initializes the output connector.
+    */
+    virtual void init();
+
+    //=========================================================================================================
+    /**
+    * Is called when plugin is detached of the stage. Can be used to safe settings.
+    */
+    virtual void unload();
+
+    virtual bool start();
+    virtual bool stop();
+
+    virtual SCSHAREDLIB::IPlugin::PluginType getType() const;
+    virtual QString getName() const;
+
+    //=========================================================================================================
+    /**
+    * The replay sensor has no setup widget.
+    *
+    * @return NULL.
+    */
+    virtual QWidget* setupWidget();
+
+    //=========================================================================================================
+    /**
+    * Sets the replay speed. Has to be called before start().
+    *
+    * @param [in] dSpeed    the replay speed as multiple of real-time, 0 replays as fast as possible.
+    */
+    void setSpeed(double dSpeed);
+
+    //=========================================================================================================
+    /**
+    * Returns the replay speed.
+    *
+    * @return the replay speed as multiple of real-time, 0 if the data is replayed as fast as possible.
+    */
+    inline double speed() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the sampling frequency of the replayed data.
+    *
+    * @return the sampling frequency in Hz, 0 if no data was loaded.
+    */
+    double samplingFrequency() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of loaded samples per channel.
+    *
+    * @return the number of samples which are replayed by a run.
+    */
+    inline qint64 numSamples() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of samples per channel published by the last run.
+    *
+    * @return the number of published samples.
+    */
+    inline qint64 publishedSamples() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the wall clock time the last run took to publish its blocks.
+    *
+    * @return the replay time in seconds.
+    */
+    inline double replayTime() const;
+
+protected:
+    //=========================================================================================================
+    /**
+    * Publishes the loaded data block wise.
+    */
+    virtual void run();
+
+private:
+    SCSHAREDLIB::PluginOutputData<SCMEASLIB::NewRealTimeMultiSampleArray>::SPtr m_pRTMSA_ReplaySensor;   /**< The replayed data. */
+
+    QSharedPointer<FIFFLIB::FiffInfo>   m_pFiffInfo;        /**< The measurement info of the replayed file. */
+    Eigen::MatrixXd                     m_matData;          /**< The loaded data. */
+
+    QString     m_sFileName;            /**< The FIFF raw file. */
+    double      m_dSpeed;               /**< The replay speed, 0 for as fast as possible. */
+    int         m_iBlockSize;           /**< The number of samples per block. */
+    double      m_dDuration;            /**< The replayed duration in seconds, <= 0 for the whole file. */
+
+    bool        m_bIsRunning;           /**< Whether the sensor is running. */
+    qint64      m_iPublishedSamples;    /**< The samples published by the last run. */
+    double      m_dReplayTime;          /**< The wall clock time of the last run in seconds. */
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline double ReplaySensor::speed() const
+{
+    return m_dSpeed;
+}
+
+
+//*************************************************************************************************************
+
+inline qint64 ReplaySensor::numSamples() const
+{
+    return m_matData.cols();
+}
+
+
+//*************************************************************************************************************
+
+inline qint64 ReplaySensor::publishedSamples() const
+{
+    return m_iPublishedSamples;
+}
+
+
+//*************************************************************************************************************
+
+inline double ReplaySensor::replayTime() const
+{
+    return m_dReplayTime;
+}
+
+} // NAMESPACE
+
+#endif // REPLAYSENSOR_H
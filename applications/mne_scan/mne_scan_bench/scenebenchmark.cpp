@@ -0,0 +1,551 @@
+//=============================================================================================================
+/**
+* @file     scenebenchmark.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     Contains the definition of the SceneBenchmark class.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "scenebenchmark.h"
+
+#include <scShared/Management/pluginmanager.h>
+#include <scShared/Management/pluginscenemanager.h>
+#include <scShared/Management/plugininputconnector.h>
+#include <scShared/Management/pipelinetracer.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QCoreApplication>
+#include <QDomDocument>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+#include <QFile>
+#include <QDir>
+#include <QDebug>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace MNESCANBENCH;
+using namespace SCSHAREDLIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+SceneBenchmark::SceneBenchmark(const QString& sPluginDir, QObject *parent)
+: QObject(parent)
+, m_pPluginManager(new PluginManager)
+, m_iBlockSize(200)
+, m_dDuration(-1.0)
+, m_dMaxLatency(SCENE_BENCHMARK_DEFAULT_MAX_LATENCY)
+{
+    m_pPluginManager->loadPlugins(sPluginDir);
+}
+
+
+//*************************************************************************************************************
+
+SceneBenchmark::~SceneBenchmark()
+{
+    clearScene();
+}
+
+
+//*************************************************************************************************************
+
+bool SceneBenchmark::loadScene(const QString& sFileName)
+{
+    QDomDocument doc("PluginConfig");
+    QFile file(sFileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "[SceneBenchmark::loadScene] Could not open" << sFileName;
+        return false;
+    }
+    if (!doc.setContent(&file)) {
+        qWarning() << "[SceneBenchmark::loadScene] Could not parse" << sFileName;
+        file.close();
+        return false;
+    }
+    file.close();
+
+    QDomElement docElem = doc.documentElement();
+    if(docElem.tagName() != "PluginTree") {
+        qWarning() << "[SceneBenchmark::loadScene]" << sFileName << "is not a plugin scene.";
+        return false;
+    }
+
+    m_slScenePlugins.clear();
+    m_lSceneConnections.clear();
+
+    QDomNode nodePluginTree = docElem.firstChild();
+    while(!nodePluginTree.isNull()) {
+        QDomElement elementPluginTree = nodePluginTree.toElement();
+
+        if(elementPluginTree.tagName() == "Plugins") {
+            QDomNode nodePlugins = elementPluginTree.firstChild();
+            while(!nodePlugins.isNull()) {
+                QDomElement e = nodePlugins.toElement();
+                nodePlugins = nodePlugins.nextSibling();
+                if(!e.isNull()) {
+                    m_slScenePlugins.append(e.attribute("name"));
+                }
+            }
+        }
+
+        if(elementPluginTree.tagName() == "Connections") {
+            QDomNode nodeConnections = elementPluginTree.firstChild();
+            while(!nodeConnections.isNull()) {
+                QDomElement e = nodeConnections.toElement();
+                nodeConnections = nodeConnections.nextSibling();
+                if(!e.isNull()) {
+                    m_lSceneConnections.append(qMakePair(e.attribute("sender"), e.attribute("receiver")));
+                }
+            }
+        }
+
+        nodePluginTree = nodePluginTree.nextSibling();
+    }
+
+    bool bSensorFound = false;
+    for(int i = 0; i < m_slScenePlugins.size(); ++i) {
+        int iPlugin = m_pPluginManager->findByName(m_slScenePlugins[i]);
+        if(iPlugin < 0) {
+            qWarning() << "[SceneBenchmark::loadScene] Plugin" << m_slScenePlugins[i] << "is not available.";
+            return false;
+        }
+        if(m_pPluginManager->getPlugins()[iPlugin]->getType() == IPlugin::_ISensor) {
+            bSensorFound = true;
+        }
+    }
+
+    if(!bSensorFound) {
+        qWarning() << "[SceneBenchmark::loadScene]" << sFileName << "contains no sensor which could be replaced.";
+        return false;
+    }
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+void SceneBenchmark::setReplay(const QString& sRawFile, int iBlockSize, double dDuration)
+{
+    m_sRawFile = sRawFile;
+    m_iBlockSize = iBlockSize;
+    m_dDuration = dDuration;
+}
+
+
+//*************************************************************************************************************
+
+void SceneBenchmark::setMaxLatency(double dMaxLatency)
+{
+    m_dMaxLatency = dMaxLatency;
+}
+
+
+//*************************************************************************************************************
+
+BenchmarkTrial SceneBenchmark::runTrial(double dSpeed)
+{
+    BenchmarkTrial trial;
+    trial.dSpeed = dSpeed;
+    trial.dDataTime = 0.0;
+    trial.dReplayTime = 0.0;
+    trial.dDrainTime = 0.0;
+    trial.bSustainable = false;
+
+    if(!buildScene(dSpeed)) {
+        trial.sReason = "scene could not be built";
+        clearScene();
+        return trial;
+    }
+
+    PipelineTracer::instance()->reset();
+    PipelineTracer::instance()->setEnabled(true);
+
+    QMap<qint64, QPair<QString, double> > qMapCpuStart = threadCpuTimes();
+
+    if(!m_pPluginSceneManager->startPlugins()) {
+        trial.sReason = "sensor could not be started";
+        PipelineTracer::instance()->setEnabled(false);
+        clearScene();
+        return trial;
+    }
+
+    bool bDrained = waitForDrain(trial.dDrainTime);
+
+    // Sample the CPU times before the plugin threads are stopped and vanish from the process
+    QMap<qint64, QPair<QString, double> > qMapCpuEnd = threadCpuTimes();
+    PipelineTracer::instance()->setEnabled(false);
+
+    trial.dDataTime = m_pReplaySensor->publishedSamples() / m_pReplaySensor->samplingFrequency();
+    trial.dReplayTime = m_pReplaySensor->replayTime();
+
+    QMap<qint64, QPair<QString, double> >::const_iterator itCpu;
+    for(itCpu = qMapCpuEnd.constBegin(); itCpu != qMapCpuEnd.constEnd(); ++itCpu) {
+        double dCpuTime = itCpu.value().second - (qMapCpuStart.contains(itCpu.key()) ? qMapCpuStart[itCpu.key()].second : 0.0);
+        trial.qMapThreadCpu[itCpu.value().first] += dCpuTime;
+    }
+
+    double dWallTime = trial.dReplayTime + trial.dDrainTime;
+    QList<PipelineStageStatistics> lStatistics = PipelineTracer::instance()->statistics();
+    qint64 iDroppedFrames = 0;
+    double dMaxQueueLatency = 0.0;
+
+    QMap<QString, IPlugin::SPtr>::const_iterator itPlugin;
+    for(itPlugin = m_qMapScenePlugins.constBegin(); itPlugin != m_qMapScenePlugins.constEnd(); ++itPlugin) {
+        const IPlugin::SPtr& pPlugin = itPlugin.value();
+
+        PluginBenchmark benchmark;
+        benchmark.sPlugin = pPlugin->getName();
+        benchmark.iNumSamples = 0;
+        benchmark.iNumProcessed = 0;
+        benchmark.dMeanProcessingTime = 0.0;
+        benchmark.dMaxProcessingTime = 0.0;
+        benchmark.dMaxQueueLatency = 0.0;
+        benchmark.iDroppedFrames = 0;
+
+        // Linux truncates thread names to 15 characters
+        QString sThreadName = pPlugin->objectName().left(15);
+        benchmark.dCpuTime = trial.qMapThreadCpu.contains(sThreadName) ? trial.qMapThreadCpu[sThreadName] : -1.0;
+
+        QString sStagePrefix = pPlugin->getName() + " / ";
+        double dSumProcessingTime = 0.0;
+        for(int i = 0; i < lStatistics.size(); ++i) {
+            const PipelineStageStatistics& stats = lStatistics.at(i);
+            if(!stats.sStage.startsWith(sStagePrefix)) {
+                continue;
+            }
+            benchmark.iNumSamples += stats.iNumSamples;
+            benchmark.iNumProcessed += stats.iNumProcessed;
+            dSumProcessingTime += stats.dMeanProcessingTime * stats.iNumProcessed;
+            benchmark.dMaxProcessingTime = qMax(benchmark.dMaxProcessingTime, stats.dMaxProcessingTime);
+            benchmark.dMaxQueueLatency = qMax(benchmark.dMaxQueueLatency, stats.dMaxQueueLatency);
+        }
+
+        if(pPlugin == m_pReplaySensor) {
+            benchmark.iNumSamples = m_pReplaySensor->publishedSamples();
+        }
+
+        benchmark.dMeanProcessingTime = benchmark.iNumProcessed > 0 ? dSumProcessingTime / benchmark.iNumProcessed : 0.0;
+        benchmark.dSampleThroughput = dWallTime > 0.0 ? benchmark.iNumSamples / dWallTime : 0.0;
+
+        for(int i = 0; i < pPlugin->getInputConnectors().size(); ++i) {
+            benchmark.iDroppedFrames += pPlugin->getInputConnectors()[i]->droppedFrames();
+        }
+
+        iDroppedFrames += benchmark.iDroppedFrames;
+        dMaxQueueLatency = qMax(dMaxQueueLatency, benchmark.dMaxQueueLatency);
+
+        trial.lPlugins.append(benchmark);
+    }
+
+    clearScene();
+
+    // As fast as possible has no deadline to keep
+    if(dSpeed <= 0.0) {
+        trial.bSustainable = bDrained;
+        trial.sReason = bDrained ? QString() : QString("pipeline did not drain");
+        return trial;
+    }
+
+    double dTargetTime = trial.dDataTime / dSpeed;
+
+    if(!bDrained) {
+        trial.sReason = "pipeline did not drain";
+    } else if(iDroppedFrames > 0) {
+        trial.sReason = QString("%1 frames dropped").arg(iDroppedFrames);
+    } else if(dMaxQueueLatency > m_dMaxLatency) {
+        trial.sReason = QString("queue latency %1 ms").arg(dMaxQueueLatency, 0, 'f', 1);
+    } else if(trial.dDrainTime * 1000.0 > m_dMaxLatency) {
+        trial.sReason = QString("drain time %1 ms").arg(trial.dDrainTime * 1000.0, 0, 'f', 1);
+    } else if(trial.dReplayTime > dTargetTime * 1.05 + m_dMaxLatency / 1000.0) {
+        trial.sReason = QString("sensor fell behind (%1 s for %2 s)").arg(trial.dReplayTime, 0, 'f', 2).arg(dTargetTime, 0, 'f', 2);
+    } else {
+        trial.bSustainable = true;
+    }
+
+    return trial;
+}
+
+
+//*************************************************************************************************************
+
+double SceneBenchmark::findMaxRealTimeFactor(QList<BenchmarkTrial>& lTrials, double dMaxSpeed, int iBisectionSteps)
+{
+    double dLower = 0.0;
+    double dUpper = -1.0;
+
+    for(double dSpeed = 1.0; dSpeed <= dMaxSpeed; dSpeed *= 2.0) {
+        BenchmarkTrial trial = runTrial(dSpeed);
+        lTrials.append(trial);
+
+        if(!trial.bSustainable) {
+            dUpper = dSpeed;
+            break;
+        }
+
+        dLower = dSpeed;
+    }
+
+    // Sustained even the highest speed
+    if(dUpper < 0.0) {
+        return dLower;
+    }
+
+    for(int i = 0; i < iBisectionSteps; ++i) {
+        double dSpeed = 0.5 * (dLower + dUpper);
+        BenchmarkTrial trial = runTrial(dSpeed);
+        lTrials.append(trial);
+
+        if(trial.bSustainable) {
+            dLower = dSpeed;
+        } else {
+            dUpper = dSpeed;
+        }
+    }
+
+    return dLower;
+}
+
+
+//*************************************************************************************************************
+
+bool SceneBenchmark::buildScene(double dSpeed)
+{
+    clearScene();
+
+    m_pPluginSceneManager = QSharedPointer<PluginSceneManager>(new PluginSceneManager);
+
+    ReplaySensor replaySensor(m_sRawFile, dSpeed, m_iBlockSize, m_dDuration);
+
+    for(int i = 0; i < m_slScenePlugins.size(); ++i) {
+        const IPlugin* pPlugin = m_pPluginManager->getPlugins()[m_pPluginManager->findByName(m_slScenePlugins[i])];
+
+        // All sensors of the scene are fed by the one replay sensor
+        if(pPlugin->getType() == IPlugin::_ISensor) {
+            if(m_pReplaySensor) {
+                m_qMapScenePlugins.insert(m_slScenePlugins[i], m_pReplaySensor);
+                continue;
+            }
+            pPlugin = &replaySensor;
+        }
+
+        IPlugin::SPtr pAddedPlugin;
+        if(!m_pPluginSceneManager->addPlugin(pPlugin, pAddedPlugin)) {
+            qWarning() << "[SceneBenchmark::buildScene] Could not add plugin" << m_slScenePlugins[i];
+            return false;
+        }
+
+        // Name the thread after the plugin so its CPU time can be attributed
+        pAddedPlugin->setObjectName(pAddedPlugin->getName());
+        m_qMapScenePlugins.insert(m_slScenePlugins[i], pAddedPlugin);
+
+        if(pPlugin == &replaySensor) {
+            m_pReplaySensor = qSharedPointerCast<ReplaySensor>(pAddedPlugin);
+        }
+    }
+
+    if(!m_pReplaySensor || m_pReplaySensor->numSamples() == 0) {
+        return false;
+    }
+
+    for(int i = 0; i < m_lSceneConnections.size(); ++i) {
+        IPlugin::SPtr pSender = m_qMapScenePlugins.value(m_lSceneConnections[i].first);
+        IPlugin::SPtr pReceiver = m_qMapScenePlugins.value(m_lSceneConnections[i].second);
+
+        if(!pSender || !pReceiver) {
+            qWarning() << "[SceneBenchmark::buildScene] Skipping connection" << m_lSceneConnections[i].first << "->" << m_lSceneConnections[i].second;
+            continue;
+        }
+
+        PluginConnectorConnection::SPtr pConnection = PluginConnectorConnection::create(pSender, pReceiver);
+
+        if(pConnection->isConnected()) {
+            m_lConnections.append(pConnection);
+        } else {
+            qWarning() << "[SceneBenchmark::buildScene] Could not connect" << m_lSceneConnections[i].first << "->" << m_lSceneConnections[i].second;
+        }
+    }
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+void SceneBenchmark::clearScene()
+{
+    if(m_pPluginSceneManager) {
+        m_pPluginSceneManager->stopPlugins();
+
+        QMap<QString, IPlugin::SPtr>::iterator it;
+        for(it = m_qMapScenePlugins.begin(); it != m_qMapScenePlugins.end(); ++it) {
+            it.value()->unload();
+        }
+    }
+
+    m_lConnections.clear();
+    m_qMapScenePlugins.clear();
+    m_pReplaySensor.clear();
+    m_pPluginSceneManager.clear();
+
+    // Let pending wake ups of the released connectors run out
+    QCoreApplication::processEvents();
+}
+
+
+//*************************************************************************************************************
+
+bool SceneBenchmark::waitForDrain(double& dDrainTime)
+{
+    QEventLoop eventLoop;
+    QTimer timerPoll;
+    QElapsedTimer timerDrain;
+    QElapsedTimer timerIdle;
+    qint64 iLastActivity = -1;
+    bool bDrained = false;
+
+    dDrainTime = 0.0;
+
+    connect(&timerPoll, &QTimer::timeout, [&]() {
+        if(!timerDrain.isValid()) {
+            if(m_pReplaySensor->isFinished()) {
+                timerDrain.start();
+                timerIdle.start();
+            }
+            return;
+        }
+
+        // Anything left in the input queues or traced since the last poll counts as activity
+        qint64 iActivity = 0;
+        QList<PipelineStageStatistics> lStatistics = PipelineTracer::instance()->statistics();
+        for(int i = 0; i < lStatistics.size(); ++i) {
+            iActivity += lStatistics.at(i).iNumFrames + lStatistics.at(i).iNumProcessed;
+        }
+
+        int iQueued = 0;
+        QMap<QString, IPlugin::SPtr>::const_iterator it;
+        for(it = m_qMapScenePlugins.constBegin(); it != m_qMapScenePlugins.constEnd(); ++it) {
+            for(int i = 0; i < it.value()->getInputConnectors().size(); ++i) {
+                iQueued += it.value()->getInputConnectors()[i]->queuedFrames();
+            }
+        }
+
+        if(iActivity != iLastActivity || iQueued > 0) {
+            iLastActivity = iActivity;
+            dDrainTime = timerDrain.nsecsElapsed() / 1.0e9;
+            timerIdle.restart();
+        } else if(timerIdle.elapsed() >= SCENE_BENCHMARK_IDLE_TIME) {
+            bDrained = true;
+            eventLoop.quit();
+        }
+
+        if(timerDrain.elapsed() > SCENE_BENCHMARK_DEFAULT_DRAIN_TIMEOUT * 1000.0) {
+            dDrainTime = timerDrain.nsecsElapsed() / 1.0e9;
+            eventLoop.quit();
+        }
+    });
+
+    timerPoll.start(5);
+    eventLoop.exec();
+
+    return bDrained;
+}
+
+
+//*************************************************************************************************************
+
+QMap<qint64, QPair<QString, double> > SceneBenchmark::threadCpuTimes()
+{
+    QMap<qint64, QPair<QString, double> > qMapCpuTimes;
+
+#ifdef Q_OS_LINUX
+    double dTicksPerSecond = static_cast<double>(sysconf(_SC_CLK_TCK));
+
+    QDir dirTasks("/proc/self/task");
+    QStringList slTasks = dirTasks.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+
+    for(int i = 0; i < slTasks.size(); ++i) {
+        QFile fileStat(dirTasks.absoluteFilePath(slTasks[i] + "/stat"));
+        if(!fileStat.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        QString sStat = QString::fromLocal8Bit(fileStat.readAll());
+        fileStat.close();
+
+        // The name is enclosed in parentheses and may contain spaces: pid (name) state ppid ... utime stime
+        int iNameStart = sStat.indexOf('(');
+        int iNameEnd = sStat.lastIndexOf(')');
+        if(iNameStart < 0 || iNameEnd < iNameStart) {
+            continue;
+        }
+
+        QStringList slFields = sStat.mid(iNameEnd + 2).split(' ', QString::SkipEmptyParts);
+        if(slFields.size() < 13) {
+            continue;
+        }
+
+        // utime and stime are fields 14 and 15 of the stat line, i.e. 12 and 13 after the name
+        double dCpuTime = (slFields[11].toLongLong() + slFields[12].toLongLong()) / dTicksPerSecond;
+        qMapCpuTimes.insert(slTasks[i].toLongLong(), qMakePair(sStat.mid(iNameStart + 1, iNameEnd - iNameStart - 1), dCpuTime));
+    }
+#endif
+
+    return qMapCpuTimes;
+}
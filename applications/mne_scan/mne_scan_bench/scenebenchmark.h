@@ -0,0 +1,261 @@
+//=============================================================================================================
+/**
+* @file     scenebenchmark.h
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     Contains the declaration of the SceneBenchmark class.
+*
+*/
+
+#ifndef SCENEBENCHMARK_H
+#define SCENEBENCHMARK_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "replaysensor.h"
+
+#include <scShared/Interfaces/IPlugin.h>
+#include <scShared/Management/pluginconnectorconnection.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QMap>
+#include <QPair>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// FORWARD DECLARATIONS
+//=============================================================================================================
+
+namespace SCSHAREDLIB
+{
+class PluginManager;
+class PluginSceneManager;
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE MNESCANBENCH
+//=============================================================================================================
+
+namespace MNESCANBENCH
+{
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINES
+//=============================================================================================================
+
+#define SCENE_BENCHMARK_DEFAULT_MAX_LATENCY     500.0   /**< Default latency budget in ms of a sustainable trial. */
+#define SCENE_BENCHMARK_DEFAULT_DRAIN_TIMEOUT   30.0    /**< Default time in s to wait for the pipeline to drain. */
+#define SCENE_BENCHMARK_IDLE_TIME               300     /**< Time in ms without activity after which the pipeline is considered drained. */
+
+
+//=============================================================================================================
+/**
+* The measured load of one plugin during a trial.
+*/
+struct PluginBenchmark {
+    QString sPlugin;                /**< The plugin name. */
+    double  dCpuTime;               /**< CPU time in s of the plugin thread, -1 if not available on this platform. */
+    qint64  iNumSamples;            /**< Samples per channel dequeued at the plugin inputs. */
+    double  dSampleThroughput;      /**< Dequeued samples per second of wall clock time. */
+    qint64  iNumProcessed;          /**< Number of traced processing runs. */
+    double  dMeanProcessingTime;    /**< Mean traced processing time in ms. */
+    double  dMaxProcessingTime;     /**< Maximum traced processing time in ms. */
+    double  dMaxQueueLatency;       /**< Maximum time in ms a frame waited at the plugin inputs. */
+    qint64  iDroppedFrames;         /**< Frames dropped by the plugin input queues. */
+};
+
+
+//=============================================================================================================
+/**
+* The result of replaying the data once through the scene.
+*/
+struct BenchmarkTrial {
+    double  dSpeed;                         /**< The replay speed, 0 for as fast as possible. */
+    double  dDataTime;                      /**< The replayed data in s. */
+    double  dReplayTime;                    /**< Wall clock time in s the sensor took to publish the data. */
+    double  dDrainTime;                     /**< Wall clock time in s until the pipeline was idle after the last block. */
+    bool    bSustainable;                   /**< Whether the pipeline kept up with the replay speed. */
+    QString sReason;                        /**< Why the trial was not sustainable. */
+    QList<PluginBenchmark> lPlugins;        /**< The load per plugin. */
+    QMap<QString, double> qMapThreadCpu;    /**< CPU time in s of all process threads by thread name. */
+};
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS SceneBenchmark
+*
+* @brief The SceneBenchmark class loads a saved MNE Scan plugin scene without any display, replaces its sensors by
+*        a ReplaySensor and measures the load of every plugin while the data is replayed through the scene.
+*/
+class SceneBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef QSharedPointer<SceneBenchmark> SPtr;             /**< Shared pointer type for SceneBenchmark. */
+    typedef QSharedPointer<const SceneBenchmark> ConstSPtr;  /**< Const shared pointer type for SceneBenchmark. */
+
+    //=========================================================================================================
+    /**
+    * Constructs a SceneBenchmark and loads the plugins.
+    *
+    * @param [in] sPluginDir    the directory holding the MNE Scan plugins.
+    * @param [in] parent        the parent object.
+    */
+    explicit SceneBenchmark(const QString& sPluginDir, QObject *parent = 0);
+
+    //=========================================================================================================
+    /**
+    * Destroys the SceneBenchmark.
+    */
+    ~SceneBenchmark();
+
+    //=========================================================================================================
+    /**
+    * Loads a plugin scene which was saved by MNE Scan.
+    *
+    * @param [in] sFileName     the scene file.
+    *
+    * @return true if the scene was loaded and all its plugins are available.
+    */
+    bool loadScene(const QString& sFileName);
+
+    //=========================================================================================================
+    /**
+    * Sets the replay settings.
+    *
+    * @param [in] sRawFile      the FIFF raw file replayed in place of the sensors of the scene.
+    * @param [in] iBlockSize    the number of samples per published block.
+    * @param [in] dDuration     the replayed duration in s, a value <= 0 replays the whole file.
+    */
+    void setReplay(const QString& sRawFile, int iBlockSize, double dDuration);
+
+    //=========================================================================================================
+    /**
+    * Sets the latency budget of a sustainable trial.
+    *
+    * @param [in] dMaxLatency   the maximum allowed queue latency and drain time in ms.
+    */
+    void setMaxLatency(double dMaxLatency);
+
+    //=========================================================================================================
+    /**
+    * Builds the scene, replays the data once at the given speed and tears the scene down again.
+    *
+    * @param [in] dSpeed    the replay speed as multiple of real-time, 0 replays as fast as possible.
+    *
+    * @return the trial result.
+    */
+    BenchmarkTrial runTrial(double dSpeed);
+
+    //=========================================================================================================
+    /**
+    * Searches the highest replay speed the scene sustains. The speed is doubled starting at real-time until a
+    * trial fails and the interval is then bisected.
+    *
+    * @param [out] lTrials          the trials which were run.
+    * @param [in] dMaxSpeed         the highest speed which is tried.
+    * @param [in] iBisectionSteps   the number of bisection steps.
+    *
+    * @return the maximum sustainable real-time factor, 0 if not even the slowest trial was sustainable.
+    */
+    double findMaxRealTimeFactor(QList<BenchmarkTrial>& lTrials, double dMaxSpeed = 64.0, int iBisectionSteps = 4);
+
+private:
+    //=========================================================================================================
+    /**
+    * Instantiates the plugins of the scene and connects them.
+    *
+    * @param [in] dSpeed    the replay speed.
+    *
+    * @return true if the scene was built.
+    */
+    bool buildScene(double dSpeed);
+
+    //=========================================================================================================
+    /**
+    * Stops and releases the plugins of the scene.
+    */
+    void clearScene();
+
+    //=========================================================================================================
+    /**
+    * Runs the event loop until the sensor is finished and no plugin received or processed data for
+    * SCENE_BENCHMARK_IDLE_TIME ms.
+    *
+    * @param [out] dDrainTime   the time in s from the end of the replay until the pipeline was idle.
+    *
+    * @return true if the pipeline drained within SCENE_BENCHMARK_DEFAULT_DRAIN_TIMEOUT.
+    */
+    bool waitForDrain(double& dDrainTime);
+
+    //=========================================================================================================
+    /**
+    * Returns the accumulated CPU time of all threads of this process. Only available on Linux.
+    *
+    * @return the CPU time in s by thread id, paired with the thread name.
+    */
+    static QMap<qint64, QPair<QString, double> > threadCpuTimes();
+
+    QSharedPointer<SCSHAREDLIB::PluginManager>      m_pPluginManager;           /**< The loaded plugins. */
+    QSharedPointer<SCSHAREDLIB::PluginSceneManager> m_pPluginSceneManager;      /**< The plugins of the current trial. */
+
+    QMap<QString, SCSHAREDLIB::IPlugin::SPtr>       m_qMapScenePlugins;         /**< The plugins of the current trial by scene name. */
+    QList<SCSHAREDLIB::PluginConnectorConnection::SPtr> m_lConnections;         /**< The connections of the current trial. */
+    ReplaySensor::SPtr                              m_pReplaySensor;            /**< The sensor of the current trial. */
+
+    QStringList                         m_slScenePlugins;       /**< The plugin names of the scene. */
+    QList<QPair<QString, QString> >     m_lSceneConnections;    /**< The sender and receiver names of the scene connections. */
+
+    QString     m_sRawFile;         /**< The replayed FIFF raw file. */
+    int         m_iBlockSize;       /**< The number of samples per block. */
+    double      m_dDuration;        /**< The replayed duration in s. */
+    double      m_dMaxLatency;      /**< The latency budget in ms. */
+};
+
+} // NAMESPACE
+
+#endif // SCENEBENCHMARK_H
@@ -48,6 +48,8 @@
 #include <scMeas/realtimeevokedset.h>
 #include <scMeas/newrealtimemultisamplearray.h>
 
+#include <scShared/Management/pipelinetracer.h>
+
 
 //*************************************************************************************************************
 //=============================================================================================================
@@ -78,7 +80,6 @@
 using namespace AveragingPlugin;
 using namespace SCSHAREDLIB;
 using namespace SCMEASLIB;
-using namespace IOBUFFER;
 using namespace FIFFLIB;
 using namespace REALTIMELIB;
 
@@ -91,7 +92,7 @@ using namespace REALTIMELIB;
 Averaging::Averaging()
 : m_pAveragingInput(NULL)
 //, m_pAveragingOutput(NULL)
-, m_pAveragingBuffer(CircularMatrixBuffer<double>::SPtr())
+, m_pAveragingBuffer(MeasurementFrameQueue::SPtr(new MeasurementFrameQueue(64)))
 , m_bIsRunning(false)
 , m_bProcessData(false)
 , m_iPreStimSeconds(100)
@@ -220,9 +221,8 @@ bool Averaging::stop()
 
     if(m_bProcessData)
     {
-        //In case the semaphore blocks the thread -> Release the QSemaphore and let it exit from the pop function (acquire statement)
+        //In case the queue blocks the thread -> Release it and let it exit from the pop function
         m_pAveragingBuffer->releaseFromPop();
-        m_pAveragingBuffer->releaseFromPush();
 
         m_pAveragingBuffer->clear();
 
@@ -266,9 +266,10 @@ void Averaging::update(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
     QSharedPointer<NewRealTimeMultiSampleArray> pRTMSA = pMeasurement.dynamicCast<NewRealTimeMultiSampleArray>();
 
     if(pRTMSA) {
-        //Check if buffer initialized
-        if(!m_pAveragingBuffer) {
-            m_pAveragingBuffer = CircularMatrixBuffer<double>::SPtr(new CircularMatrixBuffer<double>(64, pRTMSA->getNumChannels(), pRTMSA->getMultiSampleArray()[0].cols()));
+        QList<MeasurementFrame::ConstSPtr> lFrames = m_pAveragingInput->takeFrames(pMeasurement);
+
+        if(lFrames.isEmpty()) {
+            return;
         }
 
         //Fiff information
@@ -291,11 +292,11 @@ void Averaging::update(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
 
         if(m_bProcessData)
         {
-            for(qint32 i = 0; i < pRTMSA->getMultiSampleArray().size(); ++i)
+            for(qint32 i = 0; i < lFrames.size(); ++i)
             {
-                MatrixXd t_mat = pRTMSA->getMultiSampleArray()[i];
-
 #ifdef DEBUG_AVERAGING
+                MatrixXd t_mat = lFrames.at(i)->data();
+
                 qsrand(time(NULL)+m_iTestCount);
 
                 t_mat = MatrixXd::Zero(t_mat.rows(), t_mat.cols());
@@ -314,8 +315,11 @@ void Averaging::update(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
                     ++m_iTestCount2;
                 }
                 ++m_iTestCount;
+
+                m_pAveragingBuffer->push(MeasurementFrame::ConstSPtr(new MeasurementFrame(t_mat, lFrames.at(i)->sequenceNumber(), lFrames.at(i)->timestamp(), lFrames.at(i)->frameId(), lFrames.at(i)->acquisitionTime())));
+#else
+                m_pAveragingBuffer->push(lFrames.at(i));
 #endif
-                m_pAveragingBuffer->push(&t_mat);
             }
         }
     }
@@ -365,10 +369,6 @@ void Averaging::init()
 
     //init channels when fiff info is available
     connect(this, &Averaging::fiffInfoAvailable, this, &Averaging::initConnector);
-
-    //Delete Buffer - will be initialized with first incoming data
-    if(!m_pAveragingBuffer.isNull())
-        m_pAveragingBuffer = CircularMatrixBuffer<double>::SPtr();
 }
 
 
@@ -668,9 +668,15 @@ void Averaging::run()
         if(doProcessing)
         {
             /* Dispatch the inputs */
-            MatrixXd rawSegment = m_pAveragingBuffer->pop();
+            MeasurementFrame::ConstSPtr pFrame = m_pAveragingBuffer->pop();
+
+            if(!pFrame)
+                continue;
 
-            m_pRtAve->append(rawSegment);
+            {
+                PipelineTraceScope trace("Averaging / RtAve", pFrame->frameId());
+                m_pRtAve->append(pFrame->data());
+            }
 
             m_qMutex.lock();
             if(m_qVecEvokedData.size() > 0)
@@ -45,7 +45,6 @@
 #include "averaging_global.h"
 
 #include <scShared/Interfaces/IAlgorithm.h>
-#include <utils/generics/circularmatrixbuffer.h>
 #include <realtime/rtProcessing/rtave.h>
 
 
@@ -276,7 +275,7 @@ private:
     SCSHAREDLIB::PluginInputData<SCMEASLIB::NewRealTimeMultiSampleArray>::SPtr  m_pAveragingInput;      /**< The RealTimeSampleArray of the Averaging input.*/
     SCSHAREDLIB::PluginOutputData<SCMEASLIB::RealTimeEvokedSet>::SPtr           m_pAveragingOutput;     /**< The RealTimeEvoked of the Averaging output.*/
 
-    IOBUFFER::CircularMatrixBuffer<double>::SPtr    m_pAveragingBuffer;                 /**< Holds incoming data.*/
+    SCMEASLIB::MeasurementFrameQueue::SPtr          m_pAveragingBuffer;                 /**< Holds the incoming frames without copying their data.*/
 
     QSharedPointer<AveragingSettingsWidget>         m_pAveragingWidget;                 /**< Holds averaging settings widget.*/
 
@@ -50,7 +50,7 @@
 #include <iostream>
 
 #include <utils/ioutils.h>
-#include <utils/detecttrigger.h>
+#include <utils/eventdetector.h>
 #include <fiff/fiff_types.h>
 #include <fiff/fiff_dig_point_set.h>
 #include <realtime/rtClient/rtcmdclient.h>
@@ -88,6 +88,7 @@
 
 using namespace BABYMEGPLUGIN;
 using namespace UTILSLIB;
+using namespace FIFFLIB;
 using namespace SCSHAREDLIB;
 using namespace IOBUFFER;
 using namespace SCMEASLIB;
@@ -111,7 +112,6 @@ BabyMEG::BabyMEG()
 , m_sFiffCompensators(QCoreApplication::applicationDirPath() + "/mne_scan_plugins/resources/babymeg/compensator.fif")
 , m_sBadChannels(QCoreApplication::applicationDirPath() + "/mne_scan_plugins/resources/babymeg/both.bad")
 , m_iRecordingMSeconds(5*60*1000)
-, m_iSplitCount(0)
 , m_bDoContinousHPI(false)
 {
     m_pActionSetupProject = new QAction(QIcon(":/images/database.png"), tr("Setup Project"),this);
@@ -344,7 +344,6 @@ QWidget* BabyMEG::setupWidget()
 void BabyMEG::run()
 {
     MatrixXf matValue;
-    qint32 size = 0;
 
     while(m_bIsRunning) {
         if(m_pRawMatrixBuffer) {
@@ -362,20 +361,13 @@ void BabyMEG::run()
             //Create digital trigger information
             createDigTrig(matValue);
 
-            //Write raw data to fif file
+            //Hand raw data over to the recorder, which writes and splits the fif file on its own thread
             if(m_bWriteToFile) {
-                size += matValue.rows()*matValue.cols() * 4;
-
-                if(size > MAX_DATA_LEN) {
-                    size = 0;
-                    this->splitRecordingFile();
-                }
-
                 m_mutex.lock();
-                m_pOutfid->write_raw_buffer(matValue.cast<double>());
+                if(m_pFiffRawRecorder) {
+                    m_pFiffRawRecorder->append(matValue);
+                }
                 m_mutex.unlock();
-            } else {
-                size = 0;
             }
 
             if(m_pRTMSABabyMEG) {
@@ -418,6 +410,11 @@ void BabyMEG::initConnector()
         m_lTriggerChannelIndices.append(m_pFiffInfo->ch_names.indexOf("TRG006"));
         m_lTriggerChannelIndices.append(m_pFiffInfo->ch_names.indexOf("TRG007"));
         m_lTriggerChannelIndices.append(m_pFiffInfo->ch_names.indexOf("TRG008"));
+
+        m_triggerDetector.setChannels(m_lTriggerChannelIndices);
+        m_triggerDetector.setThreshold(3.0);
+        m_triggerDetector.setEdge(EventDetector::Gradient, EventDetector::Rising);
+        m_triggerDetector.setDeadTime(100);
     }
 }
 
@@ -745,49 +742,23 @@ void BabyMEG::showSqdCtrlDialog()
 }
 
 
-//*************************************************************************************************************
-
-void BabyMEG::splitRecordingFile()
-{
-    //qDebug() << "Split recording file";
-    ++m_iSplitCount;
-    QString nextFileName = m_sRecordFile.remove("_raw.fif");
-    nextFileName += QString("-%1_raw.fif").arg(m_iSplitCount);
-
-    //Write the link to the next file
-    qint32 data;
-    m_pOutfid->start_block(FIFFB_REF);
-    data = FIFFV_ROLE_NEXT_FILE;
-    m_pOutfid->write_int(FIFF_REF_ROLE,&data);
-    m_pOutfid->write_string(FIFF_REF_FILE_NAME, nextFileName);
-    m_pOutfid->write_id(FIFF_REF_FILE_ID);//ToDo meas_id
-    data = m_iSplitCount - 1;
-    m_pOutfid->write_int(FIFF_REF_FILE_NUM, &data);
-    m_pOutfid->end_block(FIFFB_REF);
-
-    //finish file
-    m_pOutfid->finish_writing_raw();
-
-    //start next file
-    m_qFileOut.setFileName(nextFileName);
-    m_pOutfid = FiffStream::start_writing_raw(m_qFileOut, *m_pFiffInfo, m_cals, defaultMatrixXi, false);
-    fiff_int_t first = 0;
-    m_pOutfid->write_int(FIFF_FIRST_SAMPLE, &first);
-}
-
-
 //*************************************************************************************************************
 
 void BabyMEG::toggleRecordingFile()
 {
     //Setup writing to file
     if(m_bWriteToFile) {
+        m_bWriteToFile = false;
+
         m_mutex.lock();
-        m_pOutfid->finish_writing_raw();
+        FiffRawRecorder::SPtr pFiffRawRecorder = m_pFiffRawRecorder;
+        m_pFiffRawRecorder.clear();
         m_mutex.unlock();
 
-        m_bWriteToFile = false;
-        m_iSplitCount = 0;
+        pFiffRawRecorder->stopRecording();
+        if(pFiffRawRecorder->droppedBlocks() > 0) {
+            qWarning() << "BabyMEG::toggleRecordingFile - Recorder dropped" << pFiffRawRecorder->droppedBlocks() << "blocks.";
+        }
 
         //Stop record timer
         m_pRecordTimer->stop();
@@ -796,8 +767,6 @@ void BabyMEG::toggleRecordingFile()
 
         m_pActionRecordFile->setIcon(QIcon(":/images/record.png"));
     } else {
-        m_iSplitCount = 0;
-
         if(!m_pFiffInfo) {
             QMessageBox msgBox;
             msgBox.setText("FiffInfo missing!");
@@ -807,8 +776,7 @@ void BabyMEG::toggleRecordingFile()
 
         //Initiate the stream for writing to the fif file
         m_sRecordFile = getFilePath(true);
-        m_qFileOut.setFileName(m_sRecordFile);
-        if(m_qFileOut.exists()) {
+        if(QFile::exists(m_sRecordFile)) {
             QMessageBox msgBox;
             msgBox.setText("The file you want to write already exists.");
             msgBox.setInformativeText("Do you want to overwrite this file?");
@@ -824,11 +792,20 @@ void BabyMEG::toggleRecordingFile()
             m_pFiffInfo->projs[i].active = false;
         }
 
-        //Start/Prepare writing process. Actual writing is done in run() method.
+        //Start/Prepare writing process. The data is handed over to the recorder in the run() method.
+        //BabyMEG data is written uncalibrated, i.e. in device units.
+        FiffRawRecorder::SPtr pFiffRawRecorder(new FiffRawRecorder(*m_pFiffInfo));
+        pFiffRawRecorder->setInputCalibrated(false);
+        pFiffRawRecorder->setSplitSize(MAX_DATA_LEN);
+        if(!pFiffRawRecorder->startRecording(m_sRecordFile)) {
+            QMessageBox msgBox;
+            msgBox.setText("Could not open the file for writing.");
+            msgBox.exec();
+            return;
+        }
+
         m_mutex.lock();
-        m_pOutfid = FiffStream::start_writing_raw(m_qFileOut, *m_pFiffInfo, m_cals, defaultMatrixXi, false);
-        fiff_int_t first = 0;
-        m_pOutfid->write_int(FIFF_FIRST_SAMPLE, &first);
+        m_pFiffRawRecorder = pFiffRawRecorder;
         m_mutex.unlock();
 
         m_bWriteToFile = true;
@@ -849,27 +826,23 @@ void BabyMEG::toggleRecordingFile()
 
 void BabyMEG::createDigTrig(MatrixXf& data)
 {
-    //Look for triggers in all trigger channels
-    //m_qMapDetectedTrigger = DetectTrigger::detectTriggerFlanksMax(data.at(b), m_lTriggerChannelIndices, m_iCurrentSample-nCol, m_dTriggerThreshold, true);
-    QMap<int,QList<QPair<int,double> > > qMapDetectedTrigger = DetectTrigger::detectTriggerFlanksGrad(data.cast<double>(), m_lTriggerChannelIndices, 0, 3.0, false, "Rising");
+    //Look for triggers in all trigger channels, edges between two blocks are found with the stored last sample
+    qint64 iBlockStart = m_triggerDetector.nextSample();
+    QVector<DetectedEvent> vecEvents = m_triggerDetector.detect(data.cast<double>());
 
-    //Combine and write results into data block's digital trigger channel
-    QMapIterator<int,QList<QPair<int,double> >> i(qMapDetectedTrigger);
-    int counter = 0;
+    //Combine and write results into data block's digital trigger channel, the n-th trigger channel sets bit n
     int idxDigTrig = m_pFiffInfo->ch_names.indexOf("DTRG01");
 
-    while (i.hasNext()) {
-        i.next();
+    if(idxDigTrig < 0) {
+        return;
+    }
 
-        QList<QPair<int,double> > lDetectedTriggers = i.value();
+    for(int k = 0; k < vecEvents.size(); ++k) {
+        int iCol = static_cast<int>(vecEvents.at(k).iSample - iBlockStart);
 
-        for(int k = 0; k < lDetectedTriggers.size(); ++k) {
-            if(lDetectedTriggers.at(k).first < data.cols() && lDetectedTriggers.at(k).first >= 0) {
-                data(idxDigTrig,lDetectedTriggers.at(k).first) = data(idxDigTrig,lDetectedTriggers.at(k).first) + pow(2,counter);
-            }
+        if(iCol < data.cols() && iCol >= 0) {
+            data(idxDigTrig,iCol) = data(idxDigTrig,iCol) + pow(2,vecEvents.at(k).iChannel);
         }
-
-        counter++;
     }
 }
 
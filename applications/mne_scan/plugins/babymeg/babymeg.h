@@ -47,9 +47,11 @@
 
 #include <fiff/fiff_info.h>
 #include <fiff/fiff_stream.h>
+#include <fiff/fiff_raw_recorder.h>
 
 #include <scShared/Interfaces/ISensor.h>
 #include <utils/generics/circularmatrixbuffer.h>
+#include <utils/eventdetector.h>
 
 
 //*************************************************************************************************************
@@ -335,12 +337,6 @@ protected:
     */
     void showSqdCtrlDialog();
 
-    //=========================================================================================================
-    /**
-    * Determines current file. And starts a new one.
-    */
-    void splitRecordingFile();
-
     //=========================================================================================================
     /**
     * Starts or stops a file recording depending on the current recording state.
@@ -415,13 +411,13 @@ protected:
     QSharedPointer<QTimer>                  m_pRecordTimer;                 /**< timer to control recording time. */
 
     QList<int>                              m_lTriggerChannelIndices;       /**< List of all trigger channel indices. */
+    UTILSLIB::EventDetector                 m_triggerDetector;              /**< Rising edge detector of the trigger channels, keeps their state across the received blocks. */
 
     FIFFLIB::FiffInfo::SPtr                 m_pFiffInfo;                    /**< Fiff measurement info.*/
-    FIFFLIB::FiffStream::SPtr               m_pOutfid;                      /**< FiffStream to write to.*/
+    FIFFLIB::FiffRawRecorder::SPtr          m_pFiffRawRecorder;             /**< Writes the recorded data to fif files on its own thread.*/
 
     qint16                                  m_iBlinkStatus;                 /**< The blink status of the recording button.*/
     qint32                                  m_iBufferSize;                  /**< The raw data buffer size.*/
-    qint32                                  m_iSplitCount;                  /**< File split count */
     int                                     m_iRecordingMSeconds;           /**< Recording length in mseconds.*/
 
     bool                                    m_bWriteToFile;                 /**< Flag for for writing the received samples to a file. Defined by the user via the GUI.*/
@@ -437,8 +433,7 @@ protected:
     QString                                 m_sFiffCompensators;            /**< Fiff compensator information */
     QString                                 m_sBadChannels;                 /**< Filename which contains a list of bad channels */
 
-    QFile                                   m_qFileOut;                     /**< QFile for writing to fif file.*/
-    QMutex                                  m_mutex;                        /**< Mutex to guarantee thread safety.*/
+    QMutex                                  m_mutex;                        /**< Mutex to guard the recorder between the acquisition and GUI thread.*/
     QTime                                   m_recordingStartedTime;         /**< The time when the recording started.*/
 
     Eigen::RowVectorXd                      m_cals;                         /**< Calibration vector.*/
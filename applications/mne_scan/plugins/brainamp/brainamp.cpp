@@ -49,6 +49,7 @@
 #include <iostream>
 
 #include <fiff/fiff.h>
+#include <fiff/fiff_raw_recorder.h>
 #include <scMeas/newrealtimemultisamplearray.h>
 
 
@@ -438,9 +439,9 @@ void BrainAMP::run()
                 matValue = m_qListReceivedSamples.first();
                 m_qListReceivedSamples.removeFirst();
 
-                //Write raw data to fif file
-                if(m_bWriteToFile) {
-                    m_pOutfid->write_raw_buffer(matValue, m_cals);
+                //Hand raw data over to the recorder, which writes the fif file on its own thread
+                if(m_bWriteToFile && m_pFiffRawRecorder) {
+                    m_pFiffRawRecorder->append(matValue);
                 }
 
                 //emit values to real time multi sample array
@@ -457,8 +458,15 @@ void BrainAMP::run()
     //Close the fif output stream
     if(m_bWriteToFile)
     {
-        m_pOutfid->finish_writing_raw();
         m_bWriteToFile = false;
+
+        m_mutex.lock();
+        FiffRawRecorder::SPtr pFiffRawRecorder = m_pFiffRawRecorder;
+        m_pFiffRawRecorder.clear();
+        m_mutex.unlock();
+
+        if(pFiffRawRecorder)
+            pFiffRawRecorder->stopRecording();
         m_pTimerRecordingChange->stop();
         m_pActionStartRecording->setIcon(QIcon(":/images/record.png"));
     }
@@ -495,8 +503,15 @@ void BrainAMP::showStartRecording()
     //Setup writing to file
     if(m_bWriteToFile)
     {
-        m_pOutfid->finish_writing_raw();
         m_bWriteToFile = false;
+
+        m_mutex.lock();
+        FiffRawRecorder::SPtr pFiffRawRecorder = m_pFiffRawRecorder;
+        m_pFiffRawRecorder.clear();
+        m_mutex.unlock();
+
+        if(pFiffRawRecorder)
+            pFiffRawRecorder->stopRecording();
         m_pTimerRecordingChange->stop();
         m_pActionStartRecording->setIcon(QIcon(":/images/record.png"));
     }
@@ -519,8 +534,7 @@ void BrainAMP::showStartRecording()
         }
 
         //Initiate the stream for writing to the fif file
-        m_fileOut.setFileName(m_sOutputFilePath);
-        if(m_fileOut.exists())
+        if(QFile::exists(m_sOutputFilePath))
         {
             QMessageBox msgBox;
             msgBox.setText("The file you want to write already exists.");
@@ -542,9 +556,18 @@ void BrainAMP::showStartRecording()
             dir.mkpath(fileDir);
         }
 
-        m_pOutfid = Fiff::start_writing_raw(m_fileOut, *m_pFiffInfo, m_cals);
-        fiff_int_t first = 0;
-        m_pOutfid->write_int(FIFF_FIRST_SAMPLE, &first);
+        FiffRawRecorder::SPtr pFiffRawRecorder(new FiffRawRecorder(*m_pFiffInfo));
+        if(!pFiffRawRecorder->startRecording(m_sOutputFilePath))
+        {
+            QMessageBox msgBox;
+            msgBox.setText("Could not open the file for writing.");
+            msgBox.exec();
+            return;
+        }
+
+        m_mutex.lock();
+        m_pFiffRawRecorder = pFiffRawRecorder;
+        m_mutex.unlock();
 
         m_bWriteToFile = true;
 
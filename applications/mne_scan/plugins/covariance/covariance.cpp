@@ -42,6 +42,8 @@
 #include "FormFiles/covariancesetupwidget.h"
 #include "FormFiles/covariancesettingswidget.h"
 
+#include <scShared/Management/pipelinetracer.h>
+
 
 //*************************************************************************************************************
 //=============================================================================================================
@@ -72,7 +74,7 @@ Covariance::Covariance()
 , m_bProcessData(false)
 , m_pCovarianceInput(NULL)
 , m_pCovarianceOutput(NULL)
-, m_pCovarianceBuffer(CircularMatrixBuffer<double>::SPtr())
+, m_pCovarianceBuffer(MeasurementFrameQueue::SPtr(new MeasurementFrameQueue(64)))
 , m_iEstimationSamples(5000)
 {
     m_pActionShowAdjustment = new QAction(QIcon(":/images/covadjustments.png"), tr("Covariance Adjustments"),this);
@@ -123,10 +125,6 @@ void Covariance::init()
     // Output
     m_pCovarianceOutput = PluginOutputData<RealTimeCov>::create(this, "CovarianceOut", "Covariance output data");
     m_outputConnectors.append(m_pCovarianceOutput);
-
-    //Delete Buffer - will be initailzed with first incoming data
-    if(!m_pCovarianceBuffer.isNull())
-        m_pCovarianceBuffer = CircularMatrixBuffer<double>::SPtr();
 }
 
 
@@ -152,6 +150,8 @@ bool Covariance::start()
 
     m_bIsRunning = true;
 
+    m_fiffInfoReady.reset();
+
     // Start threads
     QThread::start();
 
@@ -165,8 +165,9 @@ bool Covariance::stop()
 {
     //Wait until this thread is stopped
     m_bIsRunning = false;
+    m_fiffInfoReady.cancel();
 
-    //In case the semaphore blocks the thread -> Release the QSemaphore and let it exit from the pop function (acquire statement)
+    //In case the queue blocks the thread -> Release it and let it exit from the pop function
     m_pCovarianceBuffer->releaseFromPop();
 
     m_pCovarianceBuffer->clear();
@@ -217,27 +218,26 @@ void Covariance::update(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
 
     if(pRTMSA)
     {
-        //Check if buffer initialized
-        if(!m_pCovarianceBuffer)
-            m_pCovarianceBuffer = CircularMatrixBuffer<double>::SPtr(new CircularMatrixBuffer<double>(64, pRTMSA->getNumChannels(), pRTMSA->getMultiSampleArray()[0].cols()));
+        QList<MeasurementFrame::ConstSPtr> lFrames = m_pCovarianceInput->takeFrames(pMeasurement);
+
+        if(lFrames.isEmpty())
+            return;
 
         //Fiff information
         if(!m_pFiffInfo)
         {
             m_pFiffInfo = pRTMSA->info();
             emit fiffInfoAvailable();
+
+            //Wake up run(), which waits for the fiff info
+            m_fiffInfoReady.open();
         }
 
 
         if(m_bProcessData)
         {
-            MatrixXd t_mat;
-
-            for(qint32 i = 0; i < pRTMSA->getMultiArraySize(); ++i)
-            {
-                t_mat = pRTMSA->getMultiSampleArray()[i];
-                m_pCovarianceBuffer->push(&t_mat);
-            }
+            for(qint32 i = 0; i < lFrames.size(); ++i)
+                m_pCovarianceBuffer->push(lFrames.at(i));
         }
     }
 }
@@ -270,8 +270,8 @@ void Covariance::run()
     //
     // Read Fiff Info
     //
-    while(!m_pFiffInfo)
-        msleep(10);// Wait for fiff Info
+    if(!m_fiffInfoReady.wait())
+        return;// Stopped before the fiff info arrived
 
     //Set m_iEstimationSamples so that we alwyas wait for 5 secs
     m_iEstimationSamples = m_pFiffInfo->sfreq * 5;
@@ -299,10 +299,16 @@ void Covariance::run()
         if(m_bProcessData)
         {
             /* Dispatch the inputs */
-            MatrixXd t_mat = m_pCovarianceBuffer->pop();
+            MeasurementFrame::ConstSPtr pFrame = m_pCovarianceBuffer->pop();
+
+            if(!pFrame)
+                continue;
 
             //Add to covariance estimation
-            m_pRtCov->append(t_mat);
+            {
+                PipelineTraceScope trace("Covariance / RtCov", pFrame->frameId());
+                m_pRtCov->append(pFrame->data());
+            }
 
             if(m_qVecCovData.size() > 0)
             {
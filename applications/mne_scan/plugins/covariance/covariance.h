@@ -45,7 +45,7 @@
 #include "covariance_global.h"
 
 #include <scShared/Interfaces/IAlgorithm.h>
-#include <utils/generics/circularmatrixbuffer.h>
+#include <scShared/Management/readylatch.h>
 #include <scMeas/newrealtimemultisamplearray.h>
 #include <scMeas/realtimecov.h>
 #include <realtime/rtProcessing/rtcov.h>
@@ -85,7 +85,6 @@ namespace CovariancePlugin
 
 using namespace SCSHAREDLIB;
 using namespace SCMEASLIB;
-using namespace IOBUFFER;
 using namespace REALTIMELIB;
 using namespace FIFFLIB;
 
@@ -177,8 +176,9 @@ private:
     PluginOutputData<RealTimeCov>::SPtr                 m_pCovarianceOutput;    /**< The RealTimeCov of the Covariance output.*/
 
     FiffInfo::SPtr  m_pFiffInfo;                                /**< Fiff measurement info.*/
+    ReadyLatch      m_fiffInfoReady;                            /**< Opened once the fiff info is set by the input.*/
 
-    CircularMatrixBuffer<double>::SPtr   m_pCovarianceBuffer;   /**< Holds incoming data.*/
+    MeasurementFrameQueue::SPtr          m_pCovarianceBuffer;   /**< Holds the incoming frames without copying their data.*/
 
     RtCov::SPtr m_pRtCov;                       /**< Real-time covariance. */
 
@@ -40,6 +40,8 @@
 
 #include "dummytoolbox.h"
 
+#include <scShared/Management/pipelinetracer.h>
+
 
 //*************************************************************************************************************
 //=============================================================================================================
@@ -49,7 +51,6 @@
 using namespace DUMMYTOOLBOXPLUGIN;
 using namespace SCSHAREDLIB;
 using namespace SCMEASLIB;
-using namespace IOBUFFER;
 
 
 //*************************************************************************************************************
@@ -61,7 +62,7 @@ DummyToolbox::DummyToolbox()
 : m_bIsRunning(false)
 , m_pDummyInput(NULL)
 , m_pDummyOutput(NULL)
-, m_pDummyBuffer(CircularMatrixBuffer<double>::SPtr())
+, m_pStrand(PluginExecutor::instance()->createStrand("Dummy Toolbox"))
 {
     //Add action which will be visible in the plugin's toolbar
     m_pActionShowYourWidget = new QAction(QIcon(":/images/options.png"), tr("Your Toolbar Widget"),this);
@@ -77,7 +78,7 @@ DummyToolbox::DummyToolbox()
 
 DummyToolbox::~DummyToolbox()
 {
-    if(this->isRunning())
+    if(m_bIsRunning)
         stop();
 }
 
@@ -104,10 +105,6 @@ void DummyToolbox::init()
     // Also, this output stream will generate an online display in your plugin
     m_pDummyOutput = PluginOutputData<NewRealTimeMultiSampleArray>::create(this, "DummyOut", "Dummy output data");
     m_outputConnectors.append(m_pDummyOutput);
-
-    //Delete Buffer - will be initailzed with first incoming data
-    if(!m_pDummyBuffer.isNull())
-        m_pDummyBuffer = CircularMatrixBuffer<double>::SPtr();
 }
 
 
@@ -123,15 +120,10 @@ void DummyToolbox::unload()
 
 bool DummyToolbox::start()
 {
-    //Check if the thread is already or still running. This can happen if the start button is pressed immediately after the stop button was pressed. In this case the stopping process is not finished yet but the start process is initiated.
-    if(this->isRunning())
-        QThread::wait();
-
+    //The blocks are processed on the shared plugin executor as they arrive in update(), no thread is started here.
+    //Plugins which need their own thread start it here and wait for the fiff info with a ReadyLatch.
     m_bIsRunning = true;
 
-    //Start thread
-    QThread::start();
-
     return true;
 }
 
@@ -142,10 +134,9 @@ bool DummyToolbox::stop()
 {
     m_bIsRunning = false;
 
-    m_pDummyBuffer->releaseFromPop();
-    m_pDummyBuffer->releaseFromPush();
-
-    m_pDummyBuffer->clear();
+    //Drop the blocks which were not processed yet and wait for the one in progress
+    m_pStrand->clear();
+    m_pStrand->waitForDone();
 
     return true;
 }
@@ -183,9 +174,10 @@ void DummyToolbox::update(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
     QSharedPointer<NewRealTimeMultiSampleArray> pRTMSA = pMeasurement.dynamicCast<NewRealTimeMultiSampleArray>();
 
     if(pRTMSA) {
-        //Check if buffer initialized
-        if(!m_pDummyBuffer) {
-            m_pDummyBuffer = CircularMatrixBuffer<double>::SPtr(new CircularMatrixBuffer<double>(64, pRTMSA->getNumChannels(), pRTMSA->getMultiSampleArray()[0].cols()));
+        QList<MeasurementFrame::ConstSPtr> lFrames = m_pDummyInput->takeFrames(pMeasurement);
+
+        if(lFrames.isEmpty()) {
+            return;
         }
 
         //Fiff information
@@ -198,12 +190,28 @@ void DummyToolbox::update(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
             m_pDummyOutput->data()->setVisibility(true);
         }
 
-        MatrixXd t_mat;
-
-        for(unsigned char i = 0; i < pRTMSA->getMultiArraySize(); ++i) {
-            t_mat = pRTMSA->getMultiSampleArray()[i];
-            m_pDummyBuffer->push(&t_mat);
+        if(!m_bIsRunning) {
+            return;
         }
+
+        //Process the blocks in order on the shared plugin executor, the frames are immutable and shared with the task
+        m_pStrand->post([this, lFrames]() {
+            for(qint32 i = 0; i < lFrames.size(); ++i) {
+                const MeasurementFrame::ConstSPtr& pFrame = lFrames.at(i);
+
+                MatrixXd t_mat;
+                {
+                    PipelineTraceScope trace("Dummy Toolbox / Process", pFrame->frameId());
+                    t_mat = pFrame->data();
+
+                    //ToDo: Implement your algorithm here
+                }
+
+                //Send the data to the connected plugins and the online display, the block keeps the frame id of its source
+                //Unocmment this if you also uncommented the m_pDummyOutput in the constructor above
+                m_pDummyOutput->data()->setValue(t_mat, pFrame);
+            }
+        });
     }
 }
 
@@ -213,23 +221,7 @@ void DummyToolbox::update(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
 
 void DummyToolbox::run()
 {
-    //
-    // Wait for Fiff Info
-    //
-    while(!m_pFiffInfo)
-        msleep(10);// Wait for fiff Info
-
-    while(m_bIsRunning)
-    {
-        //Dispatch the inputs
-        MatrixXd t_mat = m_pDummyBuffer->pop();
-
-        //ToDo: Implement your algorithm here
-
-        //Send the data to the connected plugins and the online display
-        //Unocmment this if you also uncommented the m_pDummyOutput in the constructor above
-        m_pDummyOutput->data()->setValue(t_mat);
-    }
+    //The processing runs on the shared plugin executor, see update()
 }
 
 
@@ -45,7 +45,7 @@
 #include "dummytoolbox_global.h"
 
 #include <scShared/Interfaces/IAlgorithm.h>
-#include <utils/generics/circularmatrixbuffer.h>
+#include <scShared/Management/pluginexecutor.h>
 #include <scMeas/newrealtimemultisamplearray.h>
 #include "FormFiles/dummysetupwidget.h"
 #include "FormFiles/dummyyourwidget.h"
@@ -134,7 +134,7 @@ public:
 protected:
     //=========================================================================================================
     /**
-    * IAlgorithm function
+    * IAlgorithm function. Not used, the data is processed on the shared plugin executor.
     */
     virtual void run();
 
@@ -147,7 +147,7 @@ private:
     QSharedPointer<DummyYourWidget>                 m_pYourWidget;          /**< flag whether thread is running.*/
     QAction*                                        m_pActionShowYourWidget;/**< flag whether thread is running.*/
 
-    IOBUFFER::CircularMatrixBuffer<double>::SPtr    m_pDummyBuffer;         /**< Holds incoming data.*/
+    PluginStrand::SPtr                              m_pStrand;              /**< Runs the processing of the incoming blocks in order on the shared plugin executor.*/
 
     PluginInputData<SCMEASLIB::NewRealTimeMultiSampleArray>::SPtr      m_pDummyInput;      /**< The NewRealTimeMultiSampleArray of the DummyToolbox input.*/
     PluginOutputData<SCMEASLIB::NewRealTimeMultiSampleArray>::SPtr     m_pDummyOutput;     /**< The NewRealTimeMultiSampleArray of the DummyToolbox output.*/
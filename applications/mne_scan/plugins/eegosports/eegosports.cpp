@@ -51,6 +51,7 @@
 #include <scMeas/newrealtimemultisamplearray.h>
 
 #include <fiff/fiff.h>
+#include <fiff/fiff_raw_recorder.h>
 
 #include <Windows.h>
 
@@ -645,8 +646,16 @@ void EEGoSports::showStartRecording()
 {
     //Setup writing to file
     if(m_bWriteToFile) {
-        m_pOutfid->finish_writing_raw();
         m_bWriteToFile = false;
+
+        m_mutex.lock();
+        FiffRawRecorder::SPtr pFiffRawRecorder = m_pFiffRawRecorder;
+        m_pFiffRawRecorder.clear();
+        m_mutex.unlock();
+
+        if(pFiffRawRecorder) {
+            pFiffRawRecorder->stopRecording();
+        }
         m_pTimerRecordingChange->stop();
         m_pActionStartRecording->setIcon(QIcon(":/images/record.png"));
     } else {
@@ -665,9 +674,7 @@ void EEGoSports::showStartRecording()
         }
 
         //Initiate the stream for writing to the fif file
-        m_fileOut.setFileName(m_sOutputFilePath);
-
-        if(m_fileOut.exists()) {
+        if(QFile::exists(m_sOutputFilePath)) {
             QMessageBox msgBox;
             msgBox.setText("The file you want to write already exists.");
             msgBox.setInformativeText("Do you want to overwrite this file?");
@@ -687,9 +694,17 @@ void EEGoSports::showStartRecording()
             dir.mkpath(fileDir);
         }
 
-        m_pOutfid = Fiff::start_writing_raw(m_fileOut, *m_pFiffInfo, m_cals);
-        fiff_int_t first = 0;
-        m_pOutfid->write_int(FIFF_FIRST_SAMPLE, &first);
+        FiffRawRecorder::SPtr pFiffRawRecorder(new FiffRawRecorder(*m_pFiffInfo));
+        if(!pFiffRawRecorder->startRecording(m_sOutputFilePath)) {
+            QMessageBox msgBox;
+            msgBox.setText("Could not open the file for writing.");
+            msgBox.exec();
+            return;
+        }
+
+        m_mutex.lock();
+        m_pFiffRawRecorder = pFiffRawRecorder;
+        m_mutex.unlock();
 
         m_bWriteToFile = true;
 
@@ -746,9 +761,9 @@ void EEGoSports::run()
 
                 matValue = m_qListReceivedSamples.takeFirst();
 
-                //Write raw data to fif file
-                if(m_bWriteToFile) {
-                    m_pOutfid->write_raw_buffer(matValue, m_cals);
+                //Hand raw data over to the recorder, which writes the fif file on its own thread
+                if(m_bWriteToFile && m_pFiffRawRecorder) {
+                    m_pFiffRawRecorder->append(matValue);
                 }
 
                 //emit values to real time multi sample array
@@ -762,8 +777,16 @@ void EEGoSports::run()
 
     //Close the fif output stream
     if(m_bWriteToFile) {
-        m_pOutfid->finish_writing_raw();
         m_bWriteToFile = false;
+
+        m_mutex.lock();
+        FiffRawRecorder::SPtr pFiffRawRecorder = m_pFiffRawRecorder;
+        m_pFiffRawRecorder.clear();
+        m_mutex.unlock();
+
+        if(pFiffRawRecorder) {
+            pFiffRawRecorder->stopRecording();
+        }
         m_pTimerRecordingChange->stop();
         m_pActionStartRecording->setIcon(QIcon(":/images/record.png"));
     }
@@ -79,8 +79,8 @@ namespace SCMEASLIB {
 }
 
 namespace FIFFLIB {
-    class FiffStream;
     class FiffInfo;
+    class FiffRawRecorder;
 }
 
 
@@ -259,10 +259,8 @@ private:
     QString                             m_sRPA;                             /**< The electrode to take to function as the RPA.*/
     QString                             m_sNasion;                          /**< The electrode to take to function as the Nasion.*/
 
-    QFile                               m_fileOut;                          /**< QFile for writing to fif file.*/
-    QSharedPointer<FIFFLIB::FiffStream> m_pOutfid;                          /**< QFile for writing to fif file.*/
+    QSharedPointer<FIFFLIB::FiffRawRecorder>    m_pFiffRawRecorder;         /**< Writes the recorded data to fif files on its own thread.*/
     QSharedPointer<FIFFLIB::FiffInfo>   m_pFiffInfo;                        /**< Fiff measurement info.*/
-    Eigen::RowVectorXd                  m_cals;
 
     QSharedPointer<EEGoSportsProducer>  m_pEEGoSportsProducer;              /**< The EEGoSportsProducer.*/
 
@@ -40,7 +40,6 @@
 //=============================================================================================================
 
 #include "calcmetric.h"
-#include <thread>
 
 
 //*************************************************************************************************************
@@ -77,6 +76,11 @@ using namespace QtConcurrent;
 //=============================================================================================================
 
 CalcMetric::CalcMetric()
+: m_iChannelCount(0)
+, m_iWindowLength(0)
+, m_iWritePosition(0)
+, m_iSampleCount(0)
+, m_iSamplesSinceResync(0)
 {
     m_iListLength = 10;
     m_iKurtosisHistoryPosition = 0;
@@ -94,87 +98,46 @@ CalcMetric::CalcMetric()
 
 //*************************************************************************************************************
 
-QPair<RowVectorXd, QPair<QList<double>, int>> createInputList(RowVectorXd input, int dim, double r, double n, double mean, double stdDev)
+double CalcMetric::calcFuzzyEn(const RowVectorXd& data, int dim, double r, double n, double mean, double stdDev)
 {
-    QPair<RowVectorXd, QPair<QList<double>, int>> funcInput;
-    funcInput.first = input;
-    QPair<QList<double>, int> inputValues;
-    QList<double> doubleInputValues;
-    doubleInputValues << mean;
-    doubleInputValues << stdDev;
-    doubleInputValues << r;
-    doubleInputValues << n;
-    inputValues.first = doubleInputValues;
-    inputValues.second = dim;
-    funcInput.second = inputValues;
-    return funcInput;
-
-}
-
-
-//*************************************************************************************************************
-
-double calcFuzzyEn(QPair<RowVectorXd, QPair<QList<double>, int>> input)//RowVectorXd data, double mean, double stdDev, int dim, double r, double n)
-{
-    RowVectorXd data = input.first;
-    QPair<QList<double>, int> inputValues = input.second;
-    QList<double> doubleInputValues= inputValues.first;
-    int dim = inputValues.second;
-    double mean = doubleInputValues[0];
-    double stdDev = doubleInputValues[1];
-    double r = doubleInputValues[2];
-    double n = doubleInputValues[3];
     int length = data.cols();
-    double fuzzyEn;
-    ArrayXd arDataNorm = (data.array()- mean).array()/(stdDev);
-    VectorXd dataNorm = arDataNorm;
+    RowVectorXd dataNorm = (data.array() - mean) / stdDev;
     Vector2d phi;
 
+    //Patterns are stored row major, so every row holds one embedding coordinate of all patterns contiguously
+    Matrix<double, Dynamic, Dynamic, RowMajor> patterns;
+    Array<double, 1, Dynamic> distance(length);
+
     for(int j=0; j<2; j++)
     {
         int m = dim+j;
-        MatrixXd patterns;
-        patterns.resize(m, length-m+1);
+        int iNumPatterns = length-m+1;
 
-        if (m==1)
-            patterns = dataNorm;
-        else
-        {
-            for(int i=0; i<m; i++)
-                patterns.row(i)=dataNorm.segment(i,length-m+1);
+        patterns.resize(m, iNumPatterns);
+        for(int i=0; i<m; i++)
+            patterns.row(i) = dataNorm.segment(i, iNumPatterns);
 
-        }
+        patterns.rowwise() -= patterns.colwise().mean();
 
-        VectorXd patternsMean = patterns.colwise().mean();
-        patterns = patterns.rowwise() - patternsMean.transpose(); //check whether correct
-        VectorXd aux;
-        aux.resize(length-m+1);
+        //The similarity matrix is symmetric with ones on the diagonal, only the upper triangle is evaluated
+        double dUpperSum = 0;
 
-        for (int i = 0; i< length-m+1; i++)
+        for (int i = 0; i < iNumPatterns-1; i++)
         {
-            MatrixXd column;
-            column.resize(patterns.rows(),patterns.cols());
-            for (int l= 0; l < patterns.cols(); l++)
-                column.col(l) = patterns.col(i);
-
-            VectorXd distance = ((patterns.array()-column.array()).abs()).colwise().maxCoeff();
-                //cout <<  "dist " << i << ": " << distance << "\n";
-            VectorXd similarty = (((-1)*(distance.array().pow(n)))/r).exp();
-                //cout << "simi " << i << ": " << similarty << "\n";
+            int iCount = iNumPatterns-1-i;
 
-            aux(i) = ((similarty.sum()-1)/(length-m-1));
+            distance.head(iCount) = (patterns.row(0).segment(i+1, iCount).array() - patterns(0,i)).abs();
+            for (int k = 1; k < m; k++)
+                distance.head(iCount) = distance.head(iCount).max((patterns.row(k).segment(i+1, iCount).array() - patterns(k,i)).abs());
 
+            dUpperSum += ((-1)*(distance.head(iCount).pow(n))/r).exp().sum();
         }
 
-        phi[j] = (aux.sum()/(length-m));
-
+        //Equals the sum over all patterns of (sum of similarities - 1)/(length-m-1), divided by length-m
+        phi[j] = (2*dUpperSum/(length-m-1))/(length-m);
     }
 
-    fuzzyEn = log(phi[0])-log(phi[1]);
-
-
-    return fuzzyEn;
-
+    return log(phi[0])-log(phi[1]);
 }
 
 
@@ -228,13 +191,44 @@ MatrixXd CalcMetric::getP2PHistory()
 
 //*************************************************************************************************************
 
-void CalcMetric::setData(Eigen::MatrixXd input)
+void CalcMetric::setWindowLength(int iWindowLength)
+{
+    if(iWindowLength == m_iWindowLength) {
+        return;
+    }
+
+    m_iWindowLength = iWindowLength;
+    m_dmatWindow.resize(m_iChannelCount, m_iWindowLength);
+    m_iWritePosition = 0;
+    m_iSampleCount = 0;
+    m_iSamplesSinceResync = 0;
+
+    m_darrShift = ArrayXd::Zero(m_iChannelCount);
+    m_darrSum1 = ArrayXd::Zero(m_iChannelCount);
+    m_darrSum2 = ArrayXd::Zero(m_iChannelCount);
+    m_darrSum3 = ArrayXd::Zero(m_iChannelCount);
+    m_darrSum4 = ArrayXd::Zero(m_iChannelCount);
+
+    m_qVecMaxDeque.fill(std::deque<qint64>(), m_iChannelCount);
+    m_qVecMinDeque.fill(std::deque<qint64>(), m_iChannelCount);
+}
+
+
+//*************************************************************************************************************
+
+bool CalcMetric::isWindowFull() const
+{
+    return m_iWindowLength > 1 && m_iSampleCount >= m_iWindowLength;
+}
+
+
+//*************************************************************************************************************
+
+void CalcMetric::appendData(const MatrixXd& matData)
 {
-    m_dmatData = input;
-    m_iDataLength = m_dmatData.cols();
-    if (m_iChannelCount != m_dmatData.rows())
+    if (m_iChannelCount != matData.rows())
     {
-        m_iChannelCount = m_dmatData.rows();
+        m_iChannelCount = matData.rows();
         m_dvecStdDev.resize(m_iChannelCount);
         m_dvecKurtosis.resize(m_iChannelCount);
         m_dvecMean.resize(m_iChannelCount);
@@ -243,126 +237,173 @@ void CalcMetric::setData(Eigen::MatrixXd input)
         m_dmatFuzzyEnHistory.resize(m_iChannelCount, m_iListLength);
         m_dmatKurtosisHistory.resize(m_iChannelCount, m_iListLength);
         m_dmatP2PHistory.resize(m_iChannelCount, m_iListLength);
+
+        //Force a reset of the window
+        int iWindowLength = m_iWindowLength;
+        m_iWindowLength = 0;
+        setWindowLength(iWindowLength);
     }
-}
 
+    if(m_iWindowLength <= 0) {
+        return;
+    }
 
-//*************************************************************************************************************
+    ArrayXd arrOld, arrNew, arrOld2, arrNew2;
 
-VectorXd CalcMetric::onSeizureDetection(int dim, double r, double n, QList<int> checkChs)
-{
-    qSort(m_lFuzzyEnUsedChs);
-    QList<QPair<RowVectorXd, QPair<QList<double>, int>>> inputList;
-
-    for (int i = 0; i < checkChs.length(); i++)
+    for(int j = 0; j < matData.cols(); ++j)
     {
-        if (!m_lFuzzyEnUsedChs.contains(checkChs[i]))
-        {
-            QPair<RowVectorXd, QPair<QList<double>, int>> funcInput = createInputList(m_dmatData.row(checkChs[i]), dim, r, n, m_dvecMean(checkChs[i]), m_dvecStdDev(checkChs[i]));
-            inputList << funcInput;
+        qint64 iExpired = m_iSampleCount - m_iWindowLength;
+        bool bFull = iExpired >= 0;
+
+        //Running moments - remove the leaving sample, add the entering one
+        arrNew = matData.col(j).array() - m_darrShift;
+        arrNew2 = arrNew.square();
+
+        if(bFull) {
+            arrOld = m_dmatWindow.col(m_iWritePosition).array() - m_darrShift;
+            arrOld2 = arrOld.square();
+            m_darrSum1 += arrNew - arrOld;
+            m_darrSum2 += arrNew2 - arrOld2;
+            m_darrSum3 += arrNew2*arrNew - arrOld2*arrOld;
+            m_darrSum4 += arrNew2.square() - arrOld2.square();
+        } else {
+            m_darrSum1 += arrNew;
+            m_darrSum2 += arrNew2;
+            m_darrSum3 += arrNew2*arrNew;
+            m_darrSum4 += arrNew2.square();
         }
-    }
 
-    QList<double> fuzzyEnResults;
-    QFuture<double> fuzzyEnFuture = mapped(inputList, calcFuzzyEn);
-    fuzzyEnFuture.waitForFinished();
-    QFutureIterator<double> futureResult(fuzzyEnFuture);
-    while (futureResult.hasNext())
-        fuzzyEnResults << futureResult.next();
+        //Monotonic deques for the window extrema. Expired indices are dropped before their slot is overwritten.
+        for(int i = 0; i < m_iChannelCount; ++i)
+        {
+            std::deque<qint64>& maxDeque = m_qVecMaxDeque[i];
+            std::deque<qint64>& minDeque = m_qVecMinDeque[i];
 
-    int j = 0;
+            while(!maxDeque.empty() && maxDeque.front() <= iExpired)
+                maxDeque.pop_front();
+            while(!minDeque.empty() && minDeque.front() <= iExpired)
+                minDeque.pop_front();
 
-    for (int i = 0; i < checkChs.length(); i++)
-    {
-        if (!m_lFuzzyEnUsedChs.contains(checkChs[i]))
-        {
-            m_dvecFuzzyEn(checkChs[i]) = fuzzyEnResults[j];
-            j++;
+            double dValue = matData(i,j);
+
+            while(!maxDeque.empty() && m_dmatWindow(i, maxDeque.back() % m_iWindowLength) <= dValue)
+                maxDeque.pop_back();
+            while(!minDeque.empty() && m_dmatWindow(i, minDeque.back() % m_iWindowLength) >= dValue)
+                minDeque.pop_back();
+
+            maxDeque.push_back(m_iSampleCount);
+            minDeque.push_back(m_iSampleCount);
         }
+
+        m_dmatWindow.col(m_iWritePosition) = matData.col(j);
+
+        m_iSampleCount++;
+        m_iWritePosition = (m_iWritePosition + 1) % m_iWindowLength;
+        m_iSamplesSinceResync++;
     }
 
+    if(isWindowFull() && m_iSamplesSinceResync >= m_iWindowLength) {
+        resyncMoments();
+    }
+}
 
-    return m_dvecFuzzyEn;
+
+//*************************************************************************************************************
+
+void CalcMetric::resyncMoments()
+{
+    m_darrShift = m_dmatWindow.rowwise().mean().array();
+
+    ArrayXXd arrCentered = m_dmatWindow.array().colwise() - m_darrShift;
+    ArrayXXd arrCentered2 = arrCentered.square();
+
+    m_darrSum1 = arrCentered.rowwise().sum();
+    m_darrSum2 = arrCentered2.rowwise().sum();
+    m_darrSum3 = (arrCentered2*arrCentered).rowwise().sum();
+    m_darrSum4 = arrCentered2.square().rowwise().sum();
+
+    m_iSamplesSinceResync = 0;
 }
 
 
 //*************************************************************************************************************
 
-VectorXd calcP2P(MatrixXd data)
+void CalcMetric::getWindowRow(int iChannel, RowVectorXd& vecData) const
 {
-    VectorXd max = data.rowwise().maxCoeff();
-    VectorXd min = data.rowwise().minCoeff();
-    VectorXd P2P = max-min;
-    return P2P;
+    int iTail = m_iWindowLength - m_iWritePosition;
+
+    vecData.resize(m_iWindowLength);
+    vecData.head(iTail) = m_dmatWindow.row(iChannel).segment(m_iWritePosition, iTail);
+    vecData.tail(m_iWritePosition) = m_dmatWindow.row(iChannel).head(m_iWritePosition);
 }
 
 
 //*************************************************************************************************************
 
-void CalcMetric::calcP2P()
+void CalcMetric::calcFuzzyEnChannels(const QList<int>& lChannels, int dim, double r, double n)
 {
+    if(lChannels.isEmpty()) {
+        return;
+    }
 
-    if (m_bSetNewP2P)
-    {
-        m_dmatP2PHistory.col(m_iP2PHistoryPosition) = m_dvecP2P;
-        m_bSetNewP2P = false;
-        m_iP2PHistoryPosition++;
-        if (m_iP2PHistoryPosition>(m_iListLength-1))
-        {
-            m_iP2PHistoryPosition = 0;
-        }
+    QList<QPair<int, double> > lResults;
+    for(int i = 0; i < lChannels.size(); ++i) {
+        lResults << QPair<int, double>(lChannels.at(i), 0.0);
     }
 
-    VectorXd max = m_dmatData.rowwise().maxCoeff();
-    VectorXd min = m_dmatData.rowwise().minCoeff();
-    m_dvecP2P = max-min;
-    m_bSetNewP2P = true;
+    QFuture<void> future = QtConcurrent::map(lResults, [this, dim, r, n](QPair<int, double>& result) {
+        RowVectorXd vecData;
+        getWindowRow(result.first, vecData);
+        result.second = calcFuzzyEn(vecData, dim, r, n, m_dvecMean(result.first), m_dvecStdDev(result.first));
+    });
+    future.waitForFinished();
+
+    for(int i = 0; i < lResults.size(); ++i) {
+        m_dvecFuzzyEn(lResults.at(i).first) = lResults.at(i).second;
+    }
 }
 
 
 //*************************************************************************************************************
 
-QPair<VectorXd, VectorXd> calcKurtosis(MatrixXd data, VectorXd mean, int start, int end)
+VectorXd CalcMetric::onSeizureDetection(int dim, double r, double n, QList<int> checkChs)
 {
-    if (end > data.rows())
-        end=data.rows();
-
-    double sum;
-    int length = data.cols();
-    VectorXd stdDev;
-    VectorXd kurtosis;
+    QList<int> lChannels;
 
-    for(int i=start; i < end; i++)
+    for (int i = 0; i < checkChs.length(); i++)
     {
-        for(int j=0; j < length; j++)
-        {
-            if (j==0)
-            {
-                sum = (data(i,j)-mean(i));
-                stdDev(i) = pow(sum, 2);
-                kurtosis(i) = pow(sum, 4);
-            }
-            else
-            {
-                sum = data(i,j) - mean(i);
-                stdDev(i) = stdDev(i) + pow(sum, 2);
-                kurtosis(i) = kurtosis(i) + pow(sum,4);
-            }
-        }
+        if (!m_lFuzzyEnUsedChs.contains(checkChs[i]))
+            lChannels << checkChs[i];
+    }
 
+    calcFuzzyEnChannels(lChannels, dim, r, n);
 
-        stdDev(i) = stdDev(i)/(length-1);
-        stdDev(i) = sqrt(stdDev(i));
-        kurtosis(i)=(kurtosis(i))/((length)*pow((stdDev(i)*sqrt(length-1))/sqrt(length),4));
+    return m_dvecFuzzyEn;
+}
 
-    }
 
-    QPair <VectorXd, VectorXd> outputPair;
-    outputPair.first = kurtosis;
-    outputPair.second = stdDev;
-    return outputPair;
+//*************************************************************************************************************
+
+void CalcMetric::calcP2P()
+{
 
+    if (m_bSetNewP2P)
+    {
+        m_dmatP2PHistory.col(m_iP2PHistoryPosition) = m_dvecP2P;
+        m_bSetNewP2P = false;
+        m_iP2PHistoryPosition++;
+        if (m_iP2PHistoryPosition>(m_iListLength-1))
+        {
+            m_iP2PHistoryPosition = 0;
+        }
+    }
+
+    for(int i = 0; i < m_iChannelCount; ++i)
+    {
+        m_dvecP2P(i) = m_dmatWindow(i, m_qVecMaxDeque[i].front() % m_iWindowLength) - m_dmatWindow(i, m_qVecMinDeque[i].front() % m_iWindowLength);
+    }
 
+    m_bSetNewP2P = true;
 }
 
 
@@ -382,31 +423,18 @@ void CalcMetric::calcKurtosis(int start, int end)
             m_iKurtosisHistoryPosition = 0;
     }
 
-    m_dvecMean = m_dmatData.rowwise().mean();
-    double sum;
+    double length = m_iWindowLength;
 
     for(int i=start; i < end; i++)
-    {        
-        for(int j=0; j < m_iDataLength; j++)
-        {
-            if (j==0)
-            {
-                sum = (m_dmatData(i,j)-m_dvecMean(i));
-                m_dvecStdDev(i) = pow(sum, 2);
-                m_dvecKurtosis(i) = pow(sum, 4);
-            }
-            else
-            {
-                sum = m_dmatData(i,j) - m_dvecMean(i);
-                m_dvecStdDev(i) = m_dvecStdDev(i) + pow(sum, 2);
-                m_dvecKurtosis(i) = m_dvecKurtosis(i) + pow(sum,4);
-            }
-        }
-
-        m_dvecStdDev(i) = m_dvecStdDev(i)/(m_iDataLength-1);
-        m_dvecStdDev(i) = sqrt(m_dvecStdDev(i));
-        m_dvecKurtosis(i)=(m_dvecKurtosis(i))/((m_iDataLength)*pow((m_dvecStdDev(i)*sqrt(m_iDataLength-1))/sqrt(m_iDataLength),4));
-
+    {
+        //Central moments from the running sums of the shifted samples
+        double mean = m_darrSum1(i)/length;
+        double sum2 = m_darrSum2(i) - length*mean*mean;
+        double sum4 = m_darrSum4(i) - 4*mean*m_darrSum3(i) + 6*mean*mean*m_darrSum2(i) - 3*length*pow(mean,4);
+
+        m_dvecMean(i) = m_darrShift(i) + mean;
+        m_dvecStdDev(i) = sqrt(sum2/(length-1));
+        m_dvecKurtosis(i) = length*sum4/(sum2*sum2);
     }
 
     m_bSetNewKurtosis = true;
@@ -416,11 +444,13 @@ void CalcMetric::calcKurtosis(int start, int end)
 
 //*************************************************************************************************************
 
-void CalcMetric::calcAll(Eigen::MatrixXd input, int dim, double r, double n)
+void CalcMetric::calcAll(int dim, double r, double n)
 {
-    this->setData(input);
+    if(!isWindowFull())
+        return;
+
     this->calcP2P();
-    this->calcKurtosis(0,1000);
+    this->calcKurtosis(0,m_iChannelCount);
     m_lFuzzyEnUsedChs.clear();
 
     if (m_iFuzzyEnStart == m_iFuzzyEnStep-1)
@@ -435,29 +465,10 @@ void CalcMetric::calcAll(Eigen::MatrixXd input, int dim, double r, double n)
         }
     }
 
-    QList<QPair<RowVectorXd, QPair<QList<double>, int>>> inputList;
-
     for (int i = m_iFuzzyEnStart; i< m_iChannelCount; i=i+m_iFuzzyEnStep)
-    {
         m_lFuzzyEnUsedChs << i;
-        QPair<RowVectorXd, QPair<QList<double>, int>> funcInput = createInputList(input.row(i), dim, r, n, m_dvecMean(i), m_dvecStdDev(i));
-        inputList << funcInput;
-    }
-
-    QList<double> fuzzyEnResults;
-    QFuture<double> fuzzyEnFuture = mapped(inputList, calcFuzzyEn);
-    fuzzyEnFuture.waitForFinished();
-    QFutureIterator<double> futureResult(fuzzyEnFuture);
-    while (futureResult.hasNext())
-        fuzzyEnResults << futureResult.next();
 
-    int j = 0;
-
-    for (int i = m_iFuzzyEnStart; i<m_iChannelCount; i=i+m_iFuzzyEnStep)
-    {
-        m_dvecFuzzyEn(i) = fuzzyEnResults[j];
-        j++;
-    }
+    calcFuzzyEnChannels(m_lFuzzyEnUsedChs, dim, r, n);
 
     if (m_iFuzzyEnStart < m_iFuzzyEnStep-1)
         m_iFuzzyEnStart++;
@@ -51,6 +51,7 @@
 #include <QSharedPointer>
 #include <QFuture>
 #include <QList>
+#include <QVector>
 
 
 //*************************************************************************************************************
@@ -62,6 +63,14 @@
 #include <Eigen/Dense>
 
 
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <deque>
+
+
 //=============================================================================================================
 /**
 * DECLARE CLASS CalcMetric
@@ -83,22 +92,38 @@ public:
     CalcMetric();
     //=========================================================================================================
     /**
-    * Handles new input data
+    * Sets the length of the sliding window all metrics are calculated on. Changing the length resets the window.
+    *
+    * @param [in] iWindowLength length of the sliding window in samples.
+    */
+    void setWindowLength(int iWindowLength);
+
+    //=========================================================================================================
+    /**
+    * Pushes new samples into the sliding window. The running moments and the peak-to-peak extrema are updated
+    * sample by sample, the oldest samples leave the window.
     *
-    * @param [in] input matrix containing the newest dataset.
+    * @param [in] matData matrix containing the newest samples (channels x samples).
     */
-    void setData(Eigen::MatrixXd input);
+    void appendData(const Eigen::MatrixXd& matData);
 
     //=========================================================================================================
     /**
-    * Handles calculation of measurements and multithreading.
+    * Returns whether the sliding window is completely filled with data.
+    *
+    * @param [out] true if the window holds iWindowLength samples.
+    */
+    bool isWindowFull() const;
+
+    //=========================================================================================================
+    /**
+    * Calculates all measurements for the current window and handles multithreading.
     *
-    * @param [in] input matrix containing the newest dataset.
     * @param [in] dim embedding dimension of fuzzy entropy.
     * @param [in] r width of fuzzy exponential function.
     * @param [in] n step of fuzzy exponential function.
     */
-    void calcAll(Eigen::MatrixXd input, int dim, double r, double n);
+    void calcAll(int dim, double r, double n);
 
     //=========================================================================================================
     /**
@@ -109,7 +134,7 @@ public:
 
     //=========================================================================================================
     /**
-    * Calculates kurtosis
+    * Calculates kurtosis from the running moments of the window
     *
     * @param [in] start index of the channel where calculation starts.
     * @param [in] start index of the channel where calculation ends.
@@ -177,17 +202,71 @@ public:
     */
     Eigen::MatrixXd getFuzzyEnHistory();
 
+    //=========================================================================================================
+    /**
+    * Calculates the Fuzzy Entropy of one channel. Only the upper triangle of the pattern similarity matrix is
+    * evaluated and the Chebyshev distances are computed for a whole row of patterns at once.
+    *
+    * @param [in] data data of one channel.
+    * @param [in] dim embedding dimension of fuzzy entropy.
+    * @param [in] r width of fuzzy exponential function.
+    * @param [in] n step of fuzzy exponential function.
+    * @param [in] mean mean value of the data.
+    * @param [in] stdDev standard deviation of the data.
+    * @param [out] returns the Fuzzy Entropy.
+    */
+    static double calcFuzzyEn(const Eigen::RowVectorXd& data, int dim, double r, double n, double mean, double stdDev);
+
     bool                                    m_bHistoryReady;            /**< True if m_dvecFuzzyEnHistory has no undefined values.*/
     int                                     m_iListLength;              /**< Number of values inside the history matrices for each channel.*/
     int                                     m_iFuzzyEnStep;             /**< Number of channels which are skipped after every calculation of FuzzyEn.*/
 
 private:
+    //=========================================================================================================
+    /**
+    * Recalculates the running moments from scratch, shifted by the current window mean. Called once per window
+    * turnover to keep the rounding error of the running sums bounded.
+    */
+    void resyncMoments();
+
+    //=========================================================================================================
+    /**
+    * Copies the window of one channel in chronological order.
+    *
+    * @param [in] iChannel index of the channel.
+    * @param [out] vecData the window data.
+    */
+    void getWindowRow(int iChannel, Eigen::RowVectorXd& vecData) const;
+
+    //=========================================================================================================
+    /**
+    * Calculates the Fuzzy Entropy for the given channels in parallel and stores it in m_dvecFuzzyEn.
+    *
+    * @param [in] lChannels channels to calculate.
+    * @param [in] dim embedding dimension of fuzzy entropy.
+    * @param [in] r width of fuzzy exponential function.
+    * @param [in] n step of fuzzy exponential function.
+    */
+    void calcFuzzyEnChannels(const QList<int>& lChannels, int dim, double r, double n);
+
+    Eigen::MatrixXd                         m_dmatWindow;               /**< Ring buffer holding the sliding window (channels x window length).*/
+    int                                     m_iWindowLength;            /**< Length of the sliding window.*/
+    int                                     m_iWritePosition;           /**< Column of m_dmatWindow the next sample is written to.*/
+    qint64                                  m_iSampleCount;             /**< Number of samples pushed since the last reset.*/
+    int                                     m_iSamplesSinceResync;      /**< Number of samples pushed since the running moments were recalculated.*/
+
+    Eigen::ArrayXd                          m_darrShift;                /**< Per channel offset subtracted before accumulating the running moments.*/
+    Eigen::ArrayXd                          m_darrSum1;                 /**< Running sum of the shifted samples.*/
+    Eigen::ArrayXd                          m_darrSum2;                 /**< Running sum of the squared shifted samples.*/
+    Eigen::ArrayXd                          m_darrSum3;                 /**< Running sum of the cubed shifted samples.*/
+    Eigen::ArrayXd                          m_darrSum4;                 /**< Running sum of the shifted samples to the power of four.*/
+
+    QVector<std::deque<qint64> >            m_qVecMaxDeque;             /**< Monotonic decreasing deque of sample indices per channel, front is the window maximum.*/
+    QVector<std::deque<qint64> >            m_qVecMinDeque;             /**< Monotonic increasing deque of sample indices per channel, front is the window minimum.*/
 
-    Eigen::MatrixXd                         m_dmatData;                 /**< The currently used data-set.*/
     Eigen::Matrix<bool, Eigen::Dynamic, 1>  m_bFuzzyEnCalc;             /**< Contains information for each channel whether or not FuzzyEn has been calculated.*/
 
     int                                     m_iChannelCount;            /**< Number of channels.*/
-    int                                     m_iDataLength;              /**< Length of data.*/
 
     int                                     m_iKurtosisHistoryPosition; /**< Position inside the history matrix where the next next Kurtosis value is to be stored.*/
     int                                     m_iP2PHistoryPosition;      /**< Position inside the history matrix where the next next peak-to-peak magnitude value is to be stored.*/
@@ -41,6 +41,8 @@
 #include "epidetect.h"
 #include <iostream>
 
+#include <scShared/Management/pipelinetracer.h>
+
 
 //*************************************************************************************************************
 //=============================================================================================================
@@ -50,7 +52,6 @@
 using namespace EPIDETECTPLUGIN;
 using namespace SCSHAREDLIB;
 using namespace SCMEASLIB;
-using namespace IOBUFFER;
 
 
 //*************************************************************************************************************
@@ -60,9 +61,10 @@ using namespace IOBUFFER;
 
 Epidetect::Epidetect()
 : m_bIsRunning(false)
+, m_bTimingLogging(false)
 , m_pEpidetectInput(NULL)
 , m_pEpidetectOutput(NULL)
-, m_pEpidetectBuffer(CircularMatrixBuffer<double>::SPtr())
+, m_pEpidetectBuffer(MeasurementFrameQueue::SPtr(new MeasurementFrameQueue(64)))
 {
     //Add action which will be visible in the plugin's toolbar
     m_pActionShowWidget = new QAction(QIcon(":/images/options.png"), tr(" Toolbar Widget"),this);
@@ -114,12 +116,6 @@ void Epidetect::init()
     // Also, this output stream will generate an online display in  plugin
     m_pEpidetectOutput = PluginOutputData<NewRealTimeMultiSampleArray>::create(this, "EpidetectOut", "Epidetect output data");
     m_outputConnectors.append(m_pEpidetectOutput);
-
-    //Delete Buffer - will be initailzed with first incoming data
-    if(!m_pEpidetectBuffer.isNull())
-    {
-        m_pEpidetectBuffer = CircularMatrixBuffer<double>::SPtr();
-    }
 }
 
 
@@ -143,6 +139,8 @@ bool Epidetect::start()
 
     m_bIsRunning = true;
 
+    m_fiffInfoReady.reset();
+
     //Start thread
     QThread::start();
 
@@ -155,9 +153,9 @@ bool Epidetect::start()
 bool Epidetect::stop()
 {
     m_bIsRunning = false;
+    m_fiffInfoReady.cancel();
 
     m_pEpidetectBuffer->releaseFromPop();
-    m_pEpidetectBuffer->releaseFromPush();
 
     m_pEpidetectBuffer->clear();
 
@@ -197,9 +195,10 @@ void Epidetect::update(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
     QSharedPointer<NewRealTimeMultiSampleArray> pRTMSA = pMeasurement.dynamicCast<NewRealTimeMultiSampleArray>();
 
     if(pRTMSA) {
-        //Check if buffer initialized
-        if(!m_pEpidetectBuffer) {
-            m_pEpidetectBuffer = CircularMatrixBuffer<double>::SPtr(new CircularMatrixBuffer<double>(64, pRTMSA->getNumChannels(), pRTMSA->getMultiSampleArray()[0].cols()));
+        QList<MeasurementFrame::ConstSPtr> lFrames = m_pEpidetectInput->takeFrames(pMeasurement);
+
+        if(lFrames.isEmpty()) {
+            return;
         }
 
         //Fiff information
@@ -210,13 +209,13 @@ void Epidetect::update(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
             m_pEpidetectOutput->data()->initFromFiffInfo(m_pFiffInfo);
             m_pEpidetectOutput->data()->setMultiArraySize(1);
             m_pEpidetectOutput->data()->setVisibility(true);
-        }
 
-        MatrixXd t_mat;
+            //Wake up run(), which waits for the fiff info
+            m_fiffInfoReady.open();
+        }
 
-        for(unsigned char i = 0; i < pRTMSA->getMultiArraySize(); ++i) {
-            t_mat = pRTMSA->getMultiSampleArray()[i];
-            m_pEpidetectBuffer->push(&t_mat);
+        for(qint32 i = 0; i < lFrames.size(); ++i) {
+            m_pEpidetectBuffer->push(lFrames.at(i));
         }
     }
 }
@@ -228,38 +227,39 @@ void Epidetect::update(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
 
 QPair<Eigen::MatrixXd, QList<int>> Epidetect::prepareData(Eigen::MatrixXd mat)
 {
-    MatrixXd trimmedMatrix;
-    QList<int> stimLocations;
     QStringList badChs = m_pFiffInfo->bads;
-    QStringList chNames = m_pFiffInfo->ch_names;
-    trimmedMatrix.resize(mat.rows()- badChs.size(), mat.cols());
-
-    int j = 0;
 
-    for (int i=0 ; i < mat.rows(); i++)
+    //The channel selection only changes with the bad channels, so it is not rebuilt for every block
+    if (m_lSelectedChs.isEmpty() || badChs != m_slSelectionBads)
     {
-        QString type = m_pFiffInfo->channel_type(i);
+        QStringList chNames = m_pFiffInfo->ch_names;
+        m_lSelectedChs.clear();
+        m_lStimChs.clear();
 
-        if (type == "stim")
-            stimLocations << i;
-        if (!(badChs.contains(chNames[i])))
+        for (int i=0 ; i < chNames.size(); i++)
         {
-            if ((type != "stim") && (type != "ecg") && (type != "eeg"))
-            {
-                trimmedMatrix.row(j) = mat.row(i);
-                j++;
+            QString type = m_pFiffInfo->channel_type(i);
 
+            if (type == "stim")
+                m_lStimChs << i;
+            if (!(badChs.contains(chNames[i])))
+            {
+                if ((type != "stim") && (type != "ecg") && (type != "eeg"))
+                    m_lSelectedChs << i;
             }
         }
 
+        qSort(m_lStimChs);
+        m_slSelectionBads = badChs;
     }
 
-    qSort(stimLocations);
-
-    trimmedMatrix.conservativeResize(j,trimmedMatrix.cols());
     QPair<MatrixXd, QList<int>> out;
-    out.first = trimmedMatrix;
-    out.second = stimLocations;
+    out.first.resize(m_lSelectedChs.size(), mat.cols());
+
+    for (int j = 0; j < m_lSelectedChs.size(); j++)
+        out.first.row(j) = mat.row(m_lSelectedChs.at(j));
+
+    out.second = m_lStimChs;
 
     return out;
 
@@ -270,17 +270,14 @@ QPair<Eigen::MatrixXd, QList<int>> Epidetect::prepareData(Eigen::MatrixXd mat)
 
 void Epidetect::run()
 {
-    bool overlap = false;
     CalcMetric calculator;
     FuzzyMembership P2P;
     FuzzyMembership Kurtosis;
     FuzzyMembership FuzzyEn;
 
-    while(!m_pFiffInfo)
-        msleep(10);// Wait for fiff Info
+    if(!m_fiffInfoReady.wait())
+        return;// Stopped before the fiff info arrived
 
-    MatrixXd firstHalfTrimmed;
-    MatrixXd lastHalfTrimmed;
     MatrixXd trimmedData;
     QList<int> stimChs;
     MatrixXd t_mat;
@@ -288,134 +285,158 @@ void Epidetect::run()
     MatrixXd KurtosisHistoryValues;
     MatrixXd P2PHistoryValues;
     int counter = 0;
+    qint64 iTimingSum = 0;
+    qint64 iTimingMax = 0;
+    int iTimingBlocks = 0;
 
     while(m_bIsRunning)
     {
-        QElapsedTimer timer;
         QPair<MatrixXd,QList<int>> data;
 
-        m_dMuGes = 0;
-
         //Dispatch the inputs
-        if (!overlap)
-        {
-            t_mat = m_pEpidetectBuffer->pop();
-            data = prepareData(t_mat);
-            trimmedData = data.first;
-            stimChs = data.second;
-            t_mat.row(stimChs[0]).setZero();
+        MeasurementFrame::ConstSPtr pFrame = m_pEpidetectBuffer->pop();
 
+        if(!pFrame) {
+            continue;
         }
 
-        timer.start();
-        MatrixXd window;
+        //The stim channel is cleared below, so work on a copy of the shared frame
+        t_mat = pFrame->data();
+        data = prepareData(t_mat);
+        trimmedData = data.first;
+        stimChs = data.second;
+        t_mat.row(stimChs[0]).setZero();
 
-        if (!overlap)
-        {
-            firstHalfTrimmed = trimmedData.block(0, 0, trimmedData.rows(), (trimmedData.cols()/2));
-            lastHalfTrimmed = trimmedData.block(0,(trimmedData.cols()/2), trimmedData.rows(), (trimmedData.cols()/2));
-            overlap = true;
-        }
-        else
-        {
-            firstHalfTrimmed = lastHalfTrimmed;
-            lastHalfTrimmed = trimmedData.block(0, 0, trimmedData.rows(), (trimmedData.cols()/2));
-            overlap = false;
-        }
+        qint64 iStartUs = PipelineTracer::currentTimeUs();
 
-        window.resize(firstHalfTrimmed.rows(), (firstHalfTrimmed.cols()+lastHalfTrimmed.cols()));
-        window.block(0,0, firstHalfTrimmed.rows(), firstHalfTrimmed.cols()) = firstHalfTrimmed;
-        window.block(0, firstHalfTrimmed.cols(), lastHalfTrimmed.rows(), lastHalfTrimmed.cols()) = lastHalfTrimmed;
+        //The metrics are evaluated on a sliding window of one block length, moved by half a block
+        int iHalfLength = trimmedData.cols()/2;
+        calculator.setWindowLength(2*iHalfLength);
 
-        if (KurtosisHistoryValues.rows() != window.rows())
+        for(int iHalf = 0; iHalf < 2; ++iHalf)
         {
-            KurtosisHistoryValues.conservativeResize(window.rows(), 3);
-            P2PHistoryValues.conservativeResize(window.rows(), 3);
-            FuzzyEnHistoryValues.conservativeResize(window.rows(), 3);
-        }
-
-        calculator.m_iListLength = m_iListLength;
-        calculator.m_iFuzzyEnStep = m_iFuzzyEnStep;
-        calculator.calcAll(window, m_iDim, m_dR , m_iN);
-        MatrixXd mu;
-        MatrixXd p2pHistory =calculator.getP2PHistory();
-        MatrixXd kurtosisHistory = calculator.getKurtosisHistory();
-        MatrixXd fuzzyEnHistory = calculator.getFuzzyEnHistory();
-        VectorXd newP2PVal = calculator.getP2P();
-        VectorXd newKurtosisVal = calculator.getKurtosis();
-
-        if (counter == m_iFuzzyEnStep*m_iListLength-1)
-        {
-            FuzzyEnHistoryValues.col(0) = fuzzyEnHistory.rowwise().minCoeff();
-            FuzzyEnHistoryValues.col(1) = fuzzyEnHistory.rowwise().mean();
-            FuzzyEnHistoryValues.col(2) = fuzzyEnHistory.rowwise().maxCoeff();
-        }
+            m_dMuGes = 0;
 
-        if (counter % m_iListLength == m_iListLength - 1)
-        {
-            KurtosisHistoryValues.col(0) = kurtosisHistory.rowwise().minCoeff();
-            KurtosisHistoryValues.col(1) = kurtosisHistory.rowwise().mean();
-            KurtosisHistoryValues.col(2) = kurtosisHistory.rowwise().maxCoeff();
-            P2PHistoryValues.col(0) = p2pHistory.rowwise().minCoeff();
-            P2PHistoryValues.col(1) = p2pHistory.rowwise().mean();
-            P2PHistoryValues.col(2) = p2pHistory.rowwise().maxCoeff();
+            calculator.appendData(trimmedData.block(0, iHalf*iHalfLength, trimmedData.rows(), iHalfLength));
 
+            if (!calculator.isWindowFull())
+                continue;
 
-        }
-
-        if (calculator.m_bHistoryReady)
-        {
-            m_dvecMuP2P = P2P.getMembership(p2pHistory, P2PHistoryValues, newP2PVal, m_dvecEpiHistory, m_dMargin, 'r');
-            m_dvecMuKurtosis = Kurtosis.getMembership(kurtosisHistory, KurtosisHistoryValues, newKurtosisVal, m_dvecEpiHistory, m_dMargin, 'm'); //TODO: check whether it really is 'm'
-            mu.resize(0,0);
-            mu.resize(window.rows(),2);
-            mu.col(0)=m_dvecMuP2P;
-            mu.col(1)=m_dvecMuKurtosis;
-            m_dvecMuMin = mu.rowwise().minCoeff();
-
-            if (m_dvecMuMin.maxCoeff() > m_dThreshold1)
+            if (KurtosisHistoryValues.rows() != trimmedData.rows())
             {
-                QList<int> checkChs;
-                for (int i= 0; i < m_dvecMuMin.rows(); i++)
-                {
-                    if (m_dvecMuMin(i) > m_dThreshold1)
-                        checkChs << i;
-                }
-
-                VectorXd newFuzzyEnVal = calculator.onSeizureDetection(m_iDim ,m_dR, m_iN, checkChs);
-                m_dvecMuFuzzyEn = FuzzyEn.getMembership(fuzzyEnHistory, FuzzyEnHistoryValues, newFuzzyEnVal, m_dvecEpiHistory,  m_dMargin, 'l' );
-                mu.col(0)= mu.rowwise().mean();
-                mu.col(1)= m_dvecMuFuzzyEn;
+                KurtosisHistoryValues.conservativeResize(trimmedData.rows(), 3);
+                P2PHistoryValues.conservativeResize(trimmedData.rows(), 3);
+                FuzzyEnHistoryValues.conservativeResize(trimmedData.rows(), 3);
+            }
 
-                for(int i = 0; i < checkChs.length(); i++)
-                {
-                    m_dMuGes = m_dMuGes + (m_dvecMuFuzzyEn(checkChs[i]));
-                }
+            calculator.m_iListLength = m_iListLength;
+            calculator.m_iFuzzyEnStep = m_iFuzzyEnStep;
+            calculator.calcAll(m_iDim, m_dR , m_iN);
+            MatrixXd mu;
+            MatrixXd p2pHistory =calculator.getP2PHistory();
+            MatrixXd kurtosisHistory = calculator.getKurtosisHistory();
+            MatrixXd fuzzyEnHistory = calculator.getFuzzyEnHistory();
+            VectorXd newP2PVal = calculator.getP2P();
+            VectorXd newKurtosisVal = calculator.getKurtosis();
+
+            if (counter == m_iFuzzyEnStep*m_iListLength-1)
+            {
+                FuzzyEnHistoryValues.col(0) = fuzzyEnHistory.rowwise().minCoeff();
+                FuzzyEnHistoryValues.col(1) = fuzzyEnHistory.rowwise().mean();
+                FuzzyEnHistoryValues.col(2) = fuzzyEnHistory.rowwise().maxCoeff();
+            }
 
-                m_dMuGes = m_dMuGes/(checkChs.length() + m_iChWeight);
+            if (counter % m_iListLength == m_iListLength - 1)
+            {
+                KurtosisHistoryValues.col(0) = kurtosisHistory.rowwise().minCoeff();
+                KurtosisHistoryValues.col(1) = kurtosisHistory.rowwise().mean();
+                KurtosisHistoryValues.col(2) = kurtosisHistory.rowwise().maxCoeff();
+                P2PHistoryValues.col(0) = p2pHistory.rowwise().minCoeff();
+                P2PHistoryValues.col(1) = p2pHistory.rowwise().mean();
+                P2PHistoryValues.col(2) = p2pHistory.rowwise().maxCoeff();
 
-                if (m_dMuGes < m_dThreshold2)
-                    m_dMuGes = 0;
 
-                if (overlap)
-                {
-                    t_mat(stimChs[0], 1) =  m_dMuGes;
+            }
 
-                }
-                else
+            if (calculator.m_bHistoryReady)
+            {
+                m_dvecMuP2P = P2P.getMembership(p2pHistory, P2PHistoryValues, newP2PVal, m_dvecEpiHistory, m_dMargin, 'r');
+                m_dvecMuKurtosis = Kurtosis.getMembership(kurtosisHistory, KurtosisHistoryValues, newKurtosisVal, m_dvecEpiHistory, m_dMargin, 'm'); //TODO: check whether it really is 'm'
+                mu.resize(0,0);
+                mu.resize(trimmedData.rows(),2);
+                mu.col(0)=m_dvecMuP2P;
+                mu.col(1)=m_dvecMuKurtosis;
+                m_dvecMuMin = mu.rowwise().minCoeff();
+
+                if (m_dvecMuMin.maxCoeff() > m_dThreshold1)
                 {
-                    t_mat(stimChs[0], (t_mat.cols()/2)) = m_dMuGes;
+                    QList<int> checkChs;
+                    for (int i= 0; i < m_dvecMuMin.rows(); i++)
+                    {
+                        if (m_dvecMuMin(i) > m_dThreshold1)
+                            checkChs << i;
+                    }
+
+                    VectorXd newFuzzyEnVal = calculator.onSeizureDetection(m_iDim ,m_dR, m_iN, checkChs);
+                    m_dvecMuFuzzyEn = FuzzyEn.getMembership(fuzzyEnHistory, FuzzyEnHistoryValues, newFuzzyEnVal, m_dvecEpiHistory,  m_dMargin, 'l' );
+                    mu.col(0)= mu.rowwise().mean();
+                    mu.col(1)= m_dvecMuFuzzyEn;
+
+                    for(int i = 0; i < checkChs.length(); i++)
+                    {
+                        m_dMuGes = m_dMuGes + (m_dvecMuFuzzyEn(checkChs[i]));
+                    }
+
+                    m_dMuGes = m_dMuGes/(checkChs.length() + m_iChWeight);
+
+                    if (m_dMuGes < m_dThreshold2)
+                        m_dMuGes = 0;
+
+                    if (iHalf == 0)
+                    {
+                        t_mat(stimChs[0], 1) =  m_dMuGes;
+
+                    }
+                    else
+                    {
+                        t_mat(stimChs[0], (t_mat.cols()/2)) = m_dMuGes;
+                    }
                 }
             }
         }
 
-        if (overlap)
-            m_pEpidetectOutput->data()->setValue(t_mat);
-        std::cout << timer.elapsed() << " ms \n";
+        //Report the per block processing time
+        qint64 iEndUs = PipelineTracer::currentTimeUs();
+        PipelineTracer::instance()->recordProcessing("epiDetect / Metrics", pFrame->frameId(), iStartUs, iEndUs);
+
+        iTimingSum += iEndUs - iStartUs;
+        iTimingMax = qMax(iTimingMax, iEndUs - iStartUs);
+        if(++iTimingBlocks == 100) {
+            double dMeanTime = iTimingSum / 1000.0 / iTimingBlocks;
+            double dMaxTime = iTimingMax / 1000.0;
+            if(m_bTimingLogging) {
+                qDebug() << "Epidetect::run - Block processing time over the last" << iTimingBlocks << "blocks: mean" << dMeanTime << "ms, max" << dMaxTime << "ms";
+            }
+            emit timingUpdated(dMeanTime, dMaxTime, iTimingBlocks);
+
+            iTimingSum = 0;
+            iTimingMax = 0;
+            iTimingBlocks = 0;
+        }
+
+        m_pEpidetectOutput->data()->setValue(t_mat, pFrame);
     }
 }
 
 
+//*************************************************************************************************************
+
+void Epidetect::setTimingLogging(bool bEnabled)
+{
+    m_bTimingLogging = bEnabled;
+}
+
+
 //*************************************************************************************************************
 
 void Epidetect::showWidget()
@@ -45,7 +45,7 @@
 #include "epidetect_global.h"
 
 #include <scShared/Interfaces/IAlgorithm.h>
-#include <utils/generics/circularmatrixbuffer.h>
+#include <scShared/Management/readylatch.h>
 #include <scMeas/newrealtimemultisamplearray.h>
 #include "FormFiles/epidetectsetupwidget.h"
 #include "FormFiles/epidetectwidget.h"
@@ -129,6 +129,15 @@ public:
     */
     void update(SCMEASLIB::NewMeasurement::SPtr pMeasurement);
 
+    //=========================================================================================================
+    /**
+    * Turns printing of the block processing time to the debug output on or off. The processing time is emitted via
+    * timingUpdated() regardless of this setting.
+    *
+    * @param[in] bEnabled   Whether to print the block processing time.
+    */
+    void setTimingLogging(bool bEnabled);
+
 protected:
     //=========================================================================================================
     /**
@@ -156,12 +165,14 @@ private:
     void updateValues();
 
     bool                                                               m_bIsRunning;        /**< Flag whether thread is running.*/
+    bool                                                               m_bTimingLogging;    /**< Flag whether the block processing time is printed to the debug output.*/
 
     FIFFLIB::FiffInfo::SPtr                                            m_pFiffInfo;         /**< Fiff measurement info.*/
+    ReadyLatch                                                         m_fiffInfoReady;     /**< Opened once the fiff info is set by the input.*/
     QSharedPointer<EpidetectWidget>                                    m_pWidget;           /**< flag whether thread is running.*/
     QAction*                                                           m_pActionShowWidget; /**< flag whether thread is running.*/
 
-    IOBUFFER::CircularMatrixBuffer<double>::SPtr                       m_pEpidetectBuffer;  /**< Holds incoming data.*/
+    SCMEASLIB::MeasurementFrameQueue::SPtr                             m_pEpidetectBuffer;  /**< Holds the incoming frames without copying their data.*/
 
     PluginInputData<SCMEASLIB::NewRealTimeMultiSampleArray>::SPtr      m_pEpidetectInput;   /**< The NewRealTimeMultiSampleArray of the Epidetect input.*/
     PluginOutputData<SCMEASLIB::NewRealTimeMultiSampleArray>::SPtr     m_pEpidetectOutput;  /**< The NewRealTimeMultiSampleArray of the Epidetect output.*/
@@ -187,12 +198,26 @@ private:
     double                                                              m_dMuGes;           /**< Overall membership.*/
     double                                                              m_dR;               /**< Width of FuzzyEn exponential function as set through the GUI.*/
 
+    QList<int>                                                          m_lSelectedChs;     /**< Indices of the channels the metrics are calculated for.*/
+    QList<int>                                                          m_lStimChs;         /**< Indices of the stim channels.*/
+    QStringList                                                         m_slSelectionBads;  /**< Bad channels m_lSelectedChs was created with.*/
+
 signals:
     //=========================================================================================================
     /**
     * Emitted when fiffInfo is available
     */
     void fiffInfoAvailable();
+
+    //=========================================================================================================
+    /**
+    * Emitted every 100 blocks with the metric processing time.
+    *
+    * @param[in] dMeanTime      The mean processing time per block in milli seconds.
+    * @param[in] dMaxTime       The maximal processing time per block in milli seconds.
+    * @param[in] iNumBlocks     The number of blocks the time was measured over.
+    */
+    void timingUpdated(double dMeanTime, double dMaxTime, int iNumBlocks);
 };
 
 } // NAMESPACE
@@ -61,6 +61,7 @@ using namespace SCSHAREDLIB;
 using namespace SCMEASLIB;
 using namespace GUSBAMPPLUGIN;
 using namespace IOBUFFER;
+using namespace FIFFLIB;
 using namespace std;
 
 
@@ -210,7 +211,6 @@ QSharedPointer<IPlugin> GUSBAmp::clone() const
 void GUSBAmp::init()
 {
     m_iSplitFileSizeMs = 10;
-    m_iSplitCount = 0;
     m_bSplitFile = false;
 
     QDate date;
@@ -332,8 +332,6 @@ QWidget* GUSBAmp::setupWidget()
 
 void GUSBAmp::run()
 {
-    qint32 size = 0;
-
     //get Matrix from the producer
     while(m_bIsRunning)
     {
@@ -352,60 +350,19 @@ void GUSBAmp::run()
             m_pRTMSA_GUSBAmp->data()->setValue(matValue_show.cast<double>());
             qDebug() << "PUSH!";
 
-            //Write raw data to fif file
+            //Hand raw data over to the recorder, which writes and splits the fif file on its own thread
             if(m_bWriteToFile)
             {
-                m_pOutfid->write_raw_buffer(matValue.cast<double>(), m_cals);
-                size += matValue.cols();
-
-                //                qDebug()<<"size"<<size;
-                //                qDebug()<<"(m_iSplitFileSizeMs/1000)*m_pFiffInfo->sfreq"<<(double(m_iSplitFileSizeMs)/1000.0)*m_pFiffInfo->sfreq;
-                if(size > (double(m_iSplitFileSizeMs)/1000.0)*m_pFiffInfo->sfreq && m_bSplitFile)
-                {
-                    size = 0;
-                    splitRecordingFile();
-                }
+                m_mutex.lock();
+                if(m_pFiffRawRecorder)
+                    m_pFiffRawRecorder->append(matValue);
+                m_mutex.unlock();
             }
-            else
-                size = 0;
         }
     }
 }
 
 
-//*************************************************************************************************************
-
-void GUSBAmp::splitRecordingFile()
-{
-    qDebug() << "Split recording file";
-    ++m_iSplitCount;
-    QString nextFileName = m_sOutputFilePath.remove("_raw.fif");
-    nextFileName += QString("-%1_raw.fif").arg(m_iSplitCount);
-
-    /*
-    * Write the link to the next file
-    */
-    qint32 data;
-    m_pOutfid->start_block(FIFFB_REF);
-    data = FIFFV_ROLE_NEXT_FILE;
-    m_pOutfid->write_int(FIFF_REF_ROLE,&data);
-    m_pOutfid->write_string(FIFF_REF_FILE_NAME, nextFileName);
-    m_pOutfid->write_id(FIFF_REF_FILE_ID);//ToDo meas_id
-    data = m_iSplitCount - 1;
-    m_pOutfid->write_int(FIFF_REF_FILE_NUM, &data);
-    m_pOutfid->end_block(FIFFB_REF);
-
-    //finish file
-    m_pOutfid->finish_writing_raw();
-
-    //start next file
-    m_fileOut.setFileName(nextFileName);
-    m_pOutfid = Fiff::start_writing_raw(m_fileOut, *m_pFiffInfo, m_cals);
-    fiff_int_t first = 0;
-    m_pOutfid->write_int(FIFF_FIRST_SAMPLE, &first);
-}
-
-
 //*************************************************************************************************************
 
 void GUSBAmp::showSetupProjectDialog()
@@ -428,13 +385,17 @@ void GUSBAmp::showSetupProjectDialog()
 
 void GUSBAmp::showStartRecording()
 {
-    m_iSplitCount = 0;
-
     //Setup writing to file
     if(m_bWriteToFile)
     {
-        m_pOutfid->finish_writing_raw();
         m_bWriteToFile = false;
+
+        m_mutex.lock();
+        FiffRawRecorder::SPtr pFiffRawRecorder = m_pFiffRawRecorder;
+        m_pFiffRawRecorder.clear();
+        m_mutex.unlock();
+
+        pFiffRawRecorder->stopRecording();
         m_pTimerRecordingChange->stop();
         m_pActionStartRecording->setIcon(QIcon(":/images/record.png"));
     }
@@ -457,8 +418,7 @@ void GUSBAmp::showStartRecording()
         }
 
         //Initiate the stream for writing to the fif file
-        m_fileOut.setFileName(m_sOutputFilePath);
-        if(m_fileOut.exists())
+        if(QFile::exists(m_sOutputFilePath))
         {
             QMessageBox msgBox;
             msgBox.setText("The file you want to write already exists.");
@@ -480,9 +440,20 @@ void GUSBAmp::showStartRecording()
             dir.mkpath(fileDir);
         }
 
-        m_pOutfid = Fiff::start_writing_raw(m_fileOut, *m_pFiffInfo, m_cals);
-        fiff_int_t first = 0;
-        m_pOutfid->write_int(FIFF_FIRST_SAMPLE, &first);
+        //The split size is given in ms, the recorder splits by bytes of float data
+        FiffRawRecorder::SPtr pFiffRawRecorder(new FiffRawRecorder(*m_pFiffInfo));
+        pFiffRawRecorder->setSplitSize(m_bSplitFile ? qint64(double(m_iSplitFileSizeMs)/1000.0 * m_pFiffInfo->sfreq) * m_pFiffInfo->nchan * 4 : 0);
+        if(!pFiffRawRecorder->startRecording(m_sOutputFilePath))
+        {
+            QMessageBox msgBox;
+            msgBox.setText("Could not open the file for writing.");
+            msgBox.exec();
+            return;
+        }
+
+        m_mutex.lock();
+        m_pFiffRawRecorder = pFiffRawRecorder;
+        m_mutex.unlock();
 
         m_bWriteToFile = true;
 
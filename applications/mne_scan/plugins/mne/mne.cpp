@@ -42,6 +42,8 @@
 
 #include "FormFiles/mnesetupwidget.h"
 
+#include <scShared/Management/pipelinetracer.h>
+
 
 //*************************************************************************************************************
 //=============================================================================================================
@@ -51,6 +53,7 @@
 #include <QtCore/QtPlugin>
 #include <QtConcurrent>
 #include <QDebug>
+#include <QStandardPaths>
 
 
 //*************************************************************************************************************
@@ -111,8 +114,10 @@ void MNE::init()
 {
     // Inits
     m_pFwd = MNEForwardSolution::SPtr(new MNEForwardSolution(m_qFileFwdSolution));
-    m_pAnnotationSet = AnnotationSet::SPtr(new AnnotationSet(m_sAtlasDir+"/lh.aparc.a2009s.annot", m_sAtlasDir+"/rh.aparc.a2009s.annot"));
-    m_pSurfaceSet = SurfaceSet::SPtr(new SurfaceSet(m_sSurfaceDir+"/lh.inflated", m_sSurfaceDir+"/rh.inflated"));
+    //parsed surfaces and annotations are cached, since they are read at every start
+    QString sCacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    m_pAnnotationSet = AnnotationSet::SPtr(new AnnotationSet(m_sAtlasDir+"/lh.aparc.a2009s.annot", m_sAtlasDir+"/rh.aparc.a2009s.annot", sCacheDir));
+    m_pSurfaceSet = SurfaceSet::SPtr(new SurfaceSet(m_sSurfaceDir+"/lh.inflated", m_sSurfaceDir+"/rh.inflated", sCacheDir));
 
     // Input
     m_pRTMSAInput = PluginInputData<NewRealTimeMultiSampleArray>::create(this, "MNE RTMSA In", "MNE real-time multi sample array input data");
@@ -255,7 +260,8 @@ void MNE::doClustering()
 
     m_qMutex.lock();
     m_bFinishedClustering = false;
-    m_pClusteredFwd = MNEForwardSolution::SPtr(new MNEForwardSolution(m_pFwd->cluster_forward_solution(*m_pAnnotationSet.data(), 40)));
+    MatrixXd matD;
+    m_pClusteredFwd = MNEForwardSolution::SPtr(new MNEForwardSolution(m_pFwd->cluster_forward_solution(*m_pAnnotationSet.data(), 40, matD, FiffCov(), FiffInfo(), QString("cityblock"), m_qFileFwdSolution.fileName())));
     //m_pClusteredFwd = m_pFwd;
     m_pRTSEOutput->data()->setFwdSolution(m_pClusteredFwd);
 
@@ -314,6 +320,11 @@ bool MNE::stop()
 
     m_qListCovChNames.clear();
 
+    if(m_pMatrixDataBuffer) {
+        m_pMatrixDataBuffer->releaseFromPop();
+        m_pMatrixDataBuffer->clear();
+    }
+
     // Stop filling buffers with data from the inputs
     m_bProcessData = false;
 
@@ -363,10 +374,13 @@ void MNE::updateRTMSA(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
 
     QSharedPointer<NewRealTimeMultiSampleArray> pRTMSA = pMeasurement.dynamicCast<NewRealTimeMultiSampleArray>();
 
-    if(pRTMSA && m_bReceiveData) {
+    //Always drain the input queue, frames received while not listening are discarded
+    QList<MeasurementFrame::ConstSPtr> lFrames = m_pRTMSAInput->takeFrames(pMeasurement);
+
+    if(pRTMSA && m_bReceiveData && !lFrames.isEmpty()) {
         //Check if buffer initialized
         if(!m_pMatrixDataBuffer)
-            m_pMatrixDataBuffer = CircularMatrixBuffer<double>::SPtr(new CircularMatrixBuffer<double>(64, pRTMSA->getNumChannels(), pRTMSA->getMultiSampleArray()[0].cols()));
+            m_pMatrixDataBuffer = MeasurementFrameQueue::SPtr(new MeasurementFrameQueue(64));
 
         //Fiff Information of the evoked
         if(!m_pFiffInfoInput) {
@@ -377,12 +391,9 @@ void MNE::updateRTMSA(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
 
         if(m_bProcessData)
         {
-            for(qint32 i = 0; i < pRTMSA->getMultiSampleArray().size(); ++i)
-            {
-                MatrixXd t_mat = pRTMSA->getMultiSampleArray()[i];
-
-                m_pMatrixDataBuffer->push(&t_mat);
-            }
+            //The frames are immutable and shared with the other consumers, hand them over without copying the data
+            for(qint32 i = 0; i < lFrames.size(); ++i)
+                m_pMatrixDataBuffer->push(lFrames.at(i));
         }
     }
 }
@@ -568,7 +579,12 @@ void MNE::run()
             //qDebug()<<"MNE::run - Processing RTMSA data";
             if(m_pMinimumNorm && ((skip_count % m_iDownSample) == 0))
             {
-                MatrixXd rawSegment = m_pMatrixDataBuffer->pop();
+                MeasurementFrame::ConstSPtr pFrame = m_pMatrixDataBuffer->pop();
+
+                if(!pFrame)
+                    continue;
+
+                const MatrixXd& rawSegment = pFrame->data();
 
                 float tmin = 1 / m_pFiffInfo->sfreq;
                 float tstep = 1 / m_pFiffInfo->sfreq;
@@ -576,7 +592,11 @@ void MNE::run()
                 m_qMutex.lock();
 
                 //TODO: Add picking here. See evoked part as input.
-                MNESourceEstimate sourceEstimate = m_pMinimumNorm->calculateInverse(rawSegment, tmin, tstep);
+                MNESourceEstimate sourceEstimate;
+                {
+                    PipelineTraceScope trace("RTC-MNE / Inverse", pFrame->frameId());
+                    sourceEstimate = m_pMinimumNorm->calculateInverse(rawSegment, tmin, tstep);
+                }
 
                 m_qMutex.unlock();
 
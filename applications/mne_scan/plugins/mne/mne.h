@@ -45,7 +45,6 @@
 #include "mne_global.h"
 #include <scShared/Interfaces/IAlgorithm.h>
 
-#include <utils/generics/circularmatrixbuffer.h>
 
 #include <fs/annotationset.h>
 #include <fs/surfaceset.h>
@@ -92,7 +91,6 @@ using namespace INVERSELIB;
 using namespace REALTIMELIB;
 using namespace SCSHAREDLIB;
 using namespace SCMEASLIB;
-using namespace IOBUFFER;
 
 
 //*************************************************************************************************************
@@ -214,7 +212,7 @@ private:
 
     PluginOutputData<RealTimeSourceEstimate>::SPtr          m_pRTSEOutput;          /**< The RealTimeSourceEstimate output.*/
 
-    CircularMatrixBuffer<double>::SPtr                      m_pMatrixDataBuffer;    /**< Holds incoming RealTimeMultiSampleArray data.*/
+    MeasurementFrameQueue::SPtr                             m_pMatrixDataBuffer;    /**< Holds the incoming RealTimeMultiSampleArray frames without copying their data.*/
 
     QMutex m_qMutex;
 
@@ -47,6 +47,8 @@
 #include <scMeas/realtimeconnectivityestimate.h>
 #include <scMeas/newrealtimemultisamplearray.h>
 
+#include <scShared/Management/pipelinetracer.h>
+
 #include "FormFiles/neuronalconnectivitysetupwidget.h"
 
 
@@ -58,7 +60,6 @@
 using namespace NEURONALCONNECTIVITYPLUGIN;
 using namespace SCSHAREDLIB;
 using namespace SCMEASLIB;
-using namespace IOBUFFER;
 using namespace CONNECTIVITYLIB;
 
 
@@ -72,7 +73,7 @@ NeuronalConnectivity::NeuronalConnectivity()
 , m_iDownSample(1)
 , m_pRTSEInput(Q_NULLPTR)
 , m_pRTCEOutput(Q_NULLPTR)
-, m_pNeuronalConnectivityBuffer(CircularMatrixBuffer<double>::SPtr())
+, m_pNeuronalConnectivityBuffer(MeasurementFrameQueue::SPtr(new MeasurementFrameQueue(64)))
 {
     //Add action which will be visible in the plugin's toolbar
     m_pActionShowYourWidget = new QAction(QIcon(":/images/options.png"), tr("Options"),this);
@@ -121,11 +122,6 @@ void NeuronalConnectivity::init()
     m_pRTCEOutput = PluginOutputData<RealTimeConnectivityEstimate>::create(this, "NeuronalConnectivityOut", "NeuronalConnectivity output data");
     m_outputConnectors.append(m_pRTCEOutput);
     m_pRTCEOutput->data()->setName(this->getName());//Provide name to auto store widget settings
-
-    //Delete Buffer - will be initialized with first incoming data
-    if(!m_pNeuronalConnectivityBuffer.isNull()) {
-        m_pNeuronalConnectivityBuffer = CircularMatrixBuffer<double>::SPtr();
-    }
 }
 
 
@@ -148,6 +144,8 @@ bool NeuronalConnectivity::start()
 
     m_bIsRunning = true;
 
+    m_fiffInfoReady.reset();
+
     //Start thread
     QThread::start();
 
@@ -160,9 +158,9 @@ bool NeuronalConnectivity::start()
 bool NeuronalConnectivity::stop()
 {
     m_bIsRunning = false;
+    m_fiffInfoReady.cancel();
 
     m_pNeuronalConnectivityBuffer->releaseFromPop();
-    m_pNeuronalConnectivityBuffer->releaseFromPush();
 
     m_pNeuronalConnectivityBuffer->clear();
 
@@ -202,11 +200,6 @@ void NeuronalConnectivity::updateSource(SCMEASLIB::NewMeasurement::SPtr pMeasure
     QSharedPointer<RealTimeSourceEstimate> pRTSE = pMeasurement.dynamicCast<RealTimeSourceEstimate>();
 
     if(pRTSE) {
-        //Check if buffer initialized
-        if(!m_pNeuronalConnectivityBuffer) {
-            m_pNeuronalConnectivityBuffer = CircularMatrixBuffer<double>::SPtr(new CircularMatrixBuffer<double>(64, pRTSE->getValue()->data.rows(), pRTSE->getValue()->data.cols()));
-        }
-
         //Fiff information
         if(!m_pFiffInfo) {
             m_pFiffInfo = pRTSE->getFiffInfo();
@@ -244,10 +237,14 @@ void NeuronalConnectivity::updateSource(SCMEASLIB::NewMeasurement::SPtr pMeasure
 
             m_matNodeVertComb.resize(m_matNodeVertLeft.rows() + m_matNodeVertRight.rows(),3);
             m_matNodeVertComb << m_matNodeVertLeft, m_matNodeVertRight;
+
+            //Wake up run(), which waits for the fiff info
+            m_fiffInfoReady.open();
         }
 
-        MatrixXd t_mat = pRTSE->getValue()->data;
-        m_pNeuronalConnectivityBuffer->push(&t_mat);
+        //Source estimates are not published as frames, the block is stamped when it arrives here
+        qint64 iNow = MeasurementFrame::currentTimeUs();
+        m_pNeuronalConnectivityBuffer->push(MeasurementFrame::ConstSPtr(new MeasurementFrame(pRTSE->getValue()->data, 0, iNow, MeasurementFrame::nextFrameId(), iNow)));
     }
 }
 
@@ -259,6 +256,12 @@ void NeuronalConnectivity::updateRTMSA(SCMEASLIB::NewMeasurement::SPtr pMeasurem
     QSharedPointer<NewRealTimeMultiSampleArray> pRTMSA = pMeasurement.dynamicCast<NewRealTimeMultiSampleArray>();
 
     if(pRTMSA) {
+        QList<MeasurementFrame::ConstSPtr> lFrames = m_pRTMSAInput->takeFrames(pMeasurement);
+
+        if(lFrames.isEmpty()) {
+            return;
+        }
+
         //Fiff information
         if(!m_pFiffInfo) {
             m_pFiffInfo = pRTMSA->info();
@@ -301,17 +304,16 @@ void NeuronalConnectivity::updateRTMSA(SCMEASLIB::NewMeasurement::SPtr pMeasurem
                 bPick = false;
             }
 
-            //Check if buffer initialized
-            if(!m_pNeuronalConnectivityBuffer) {
-                m_pNeuronalConnectivityBuffer = CircularMatrixBuffer<double>::SPtr(new CircularMatrixBuffer<double>(64, counter, pRTMSA->getMultiSampleArray()[0].cols()));
-            }
-
+            //Wake up run(), which waits for the fiff info
+            m_fiffInfoReady.open();
         }
 
+        //Only the picked channels are queued, the new frame keeps the id and the acquisition time of its source
         MatrixXd data;
-        for(qint32 i = 0; i < pRTMSA->getMultiSampleArray().size(); ++i)
+        for(qint32 i = 0; i < lFrames.size(); ++i)
         {
-            const MatrixXd& t_mat = pRTMSA->getMultiSampleArray()[i];
+            const MeasurementFrame::ConstSPtr& pFrame = lFrames.at(i);
+            const MatrixXd& t_mat = pFrame->data();
             data.resize(m_chIdx.size(), t_mat.cols());
 
             for(qint32 j = 0; j < m_chIdx.size(); ++j)
@@ -319,7 +321,7 @@ void NeuronalConnectivity::updateRTMSA(SCMEASLIB::NewMeasurement::SPtr pMeasurem
                 data.row(j) = t_mat.row(m_chIdx.at(j));
             }
 
-            m_pNeuronalConnectivityBuffer->push(&data);
+            m_pNeuronalConnectivityBuffer->push(MeasurementFrame::ConstSPtr(new MeasurementFrame(data, pFrame->sequenceNumber(), pFrame->timestamp(), pFrame->frameId(), pFrame->acquisitionTime())));
         }
     }
 }
@@ -332,8 +334,8 @@ void NeuronalConnectivity::run()
     //
     // Wait for Fiff Info
     //
-    while(!m_pFiffInfo) {
-        msleep(10);// Wait for fiff Info
+    if(!m_fiffInfoReady.wait()) {
+        return;// Stopped before the fiff info arrived
     }
 
     int skip_count = 0;
@@ -341,21 +343,21 @@ void NeuronalConnectivity::run()
     while(m_bIsRunning)
     {
         //Dispatch the inputs
-        MatrixXd t_mat = m_pNeuronalConnectivityBuffer->pop();
+        MeasurementFrame::ConstSPtr pFrame = m_pNeuronalConnectivityBuffer->pop();
+
+        if(!pFrame) {
+            continue;
+        }
 
         //Do processing after skip count has reached limit
         if((skip_count % m_iDownSample) == 0)
         {
             //ToDo: Implement your algorithm here
-            QElapsedTimer time;
-            time.start();
-
-            Network tNetwork = ConnectivityMeasures::crossCorrelation(t_mat, m_matNodeVertComb);
-            qDebug()<<"----------------------------------------";
-            qDebug()<<"----------------------------------------";
-            qDebug()<<"NeuronalConnectivity::run() - time.elapsed()" << time.elapsed();
-            qDebug()<<"----------------------------------------";
-            qDebug()<<"----------------------------------------";
+            Network tNetwork;
+            {
+                PipelineTraceScope trace("Neuronal Connectivity / CrossCorrelation", pFrame->frameId());
+                tNetwork = ConnectivityMeasures::crossCorrelation(pFrame->data(), m_matNodeVertComb);
+            }
 
             //Send the data to the connected plugins and the online display
             //Unocmment this if you also uncommented the m_pRTCEOutput in the constructor above
@@ -45,8 +45,8 @@
 #include "neuronalconnectivity_global.h"
 
 #include <scShared/Interfaces/IAlgorithm.h>
+#include <scShared/Management/readylatch.h>
 
-#include <utils/generics/circularmatrixbuffer.h>
 
 #include "FormFiles/neuronalconnectivityyourwidget.h"
 
@@ -169,10 +169,11 @@ private:
     qint32                                                                          m_iDownSample;                  /**< Sampling rate */
 
     QSharedPointer<FIFFLIB::FiffInfo>                                               m_pFiffInfo;                    /**< Fiff measurement info.*/
+    SCSHAREDLIB::ReadyLatch                                                         m_fiffInfoReady;                /**< Opened once the fiff info is set by the input.*/
     QSharedPointer<NeuronalConnectivityYourWidget>                                  m_pYourWidget;                  /**< flag whether thread is running.*/
     QAction*                                                                        m_pActionShowYourWidget;        /**< flag whether thread is running.*/
 
-    QSharedPointer<IOBUFFER::CircularMatrixBuffer<double> >                         m_pNeuronalConnectivityBuffer;  /**< Holds incoming data.*/
+    SCMEASLIB::MeasurementFrameQueue::SPtr                                          m_pNeuronalConnectivityBuffer;  /**< Holds the incoming frames, which keep the frame id and acquisition time of their source.*/
 
     SCSHAREDLIB::PluginInputData<SCMEASLIB::RealTimeSourceEstimate>::SPtr           m_pRTSEInput;                   /**< The RealTimeSourceEstimate input.*/
     SCSHAREDLIB::PluginInputData<SCMEASLIB::NewRealTimeMultiSampleArray>::SPtr      m_pRTMSAInput;                  /**< The RealTimeMultiSampleArray input.*/
@@ -42,6 +42,8 @@
 #include "noiseestimate.h"
 #include "FormFiles/noiseestimatesetupwidget.h"
 
+#include <scShared/Management/pipelinetracer.h>
+
 //*************************************************************************************************************
 //=============================================================================================================
 // QT INCLUDES
@@ -70,7 +72,8 @@ NoiseEstimate::NoiseEstimate()
 , m_bProcessData(false)
 , m_pRTMSAInput(NULL)
 , m_pFSOutput(NULL)
-, m_pBuffer(CircularMatrixBuffer<double>::SPtr())
+, m_pBuffer(MeasurementFrameQueue::SPtr(new MeasurementFrameQueue(8)))
+, m_iBlockSize(0)
 , m_Fs(600)
 , m_iFFTlength(16384)
 , m_DataLen(6)
@@ -125,10 +128,6 @@ void NoiseEstimate::init()
     //init channels when fiff info is available
     connect(this, &NoiseEstimate::fiffInfoAvailable, this, &NoiseEstimate::initConnector);
 
-    //Delete Buffer - will be initailzed with first incoming data
-    if(!m_pBuffer.isNull())
-        m_pBuffer = CircularMatrixBuffer<double>::SPtr();
-
 }
 
 
@@ -192,9 +191,8 @@ bool NoiseEstimate::stop()
 
     if(m_bProcessData)
     {
-        //In case the semaphore blocks the thread -> Release the QSemaphore and let it exit from the pop function (acquire statement)
+        //In case the queue blocks the thread -> Release it and let it exit from the pop function
         m_pBuffer->releaseFromPop();
-        m_pBuffer->releaseFromPush();
 
 //        m_pBuffer->clear();
 //        m_pNEOutput->data()->clear();
@@ -249,17 +247,16 @@ void NoiseEstimate::update(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
 
     if(pRTMSA)
     {
-        //Check if buffer initialized
+        QList<MeasurementFrame::ConstSPtr> lFrames = m_pRTMSAInput->takeFrames(pMeasurement);
 
-        m_qMutex.lock();
-        if(!m_pBuffer)
-        {
-            m_pBuffer = CircularMatrixBuffer<double>::SPtr(new CircularMatrixBuffer<double>(8, pRTMSA->getNumChannels(), pRTMSA->getMultiSampleArray()[0].cols()));
-        }
+        if(lFrames.isEmpty())
+            return;
 
+        m_qMutex.lock();
         //Fiff information
         if(!m_pFiffInfo)
         {
+            m_iBlockSize = lFrames.first()->data().cols();
             m_pFiffInfo = pRTMSA->info();
             emit fiffInfoAvailable();
         }
@@ -267,13 +264,8 @@ void NoiseEstimate::update(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
 
         if(m_bProcessData)
         {
-            MatrixXd t_mat;
-
-            for(qint32 i = 0; i < pRTMSA->getMultiArraySize(); ++i)
-            {
-                t_mat = pRTMSA->getMultiSampleArray()[i];
-                m_pBuffer->push(&t_mat);
-            }
+            for(qint32 i = 0; i < lFrames.size(); ++i)
+                m_pBuffer->push(lFrames.at(i));
         }
     }
 }
@@ -282,11 +274,9 @@ void NoiseEstimate::update(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
 
 void NoiseEstimate::appendNoiseSpectrum(MatrixXd t_send)
 { 
-    qDebug()<<"Spectrum"<<t_send(0,1)<<t_send(0,2)<<t_send(0,3);
     m_qMutex.lock();
     m_qVecSpecData.push_back(t_send);
     m_qMutex.unlock();
-    qDebug()<<"---------------------------------appendNoiseSpectrum--------------------------------";
 }
 
 
@@ -317,7 +307,7 @@ void NoiseEstimate::run()
     // calculate the segments according to the requested data length
     // here 500 is the number of samples for a block specified in babyMEG plugin
     m_Fs = m_pFiffInfo->sfreq;
-    int segments =  (qint32) ((m_DataLen * m_pFiffInfo->sfreq)/m_pBuffer->cols());
+    int segments =  (qint32) ((m_DataLen * m_pFiffInfo->sfreq)/m_iBlockSize);
 
     qDebug()<<"+++++++++++segments :"<<segments<< "m_DataLen"<<m_DataLen<<"m_Fs"<<m_Fs<<"++++++++++++++++++++++++";
 
@@ -338,21 +328,24 @@ void NoiseEstimate::run()
         if(m_bProcessData)
         {
             /* Dispatch the inputs */
-            MatrixXd t_mat = m_pBuffer->pop();
+            MeasurementFrame::ConstSPtr pFrame = m_pBuffer->pop();
 
-            //ToDo: Implement your algorithm here
-            m_pRtNoise->append(t_mat);
+            if(!pFrame)
+                continue;
 
-           if(m_qVecSpecData.size() > 0)
-           {
-               m_qMutex.lock();
-               qDebug()<<"%%%%%%%%%%%%%%%% send spectrum for display %%%%%%%%%%%%%%%%%%%";
-                //send spectrum to the output data
-               m_pFSOutput->data()->setValue(m_qVecSpecData[0]);
-               m_qVecSpecData.pop_front();
-               m_qMutex.unlock();
+            {
+                PipelineTraceScope trace("Noise Estimation / RtNoise", pFrame->frameId());
+                m_pRtNoise->append(pFrame->data());
+            }
 
+            m_qMutex.lock();
+            if(m_qVecSpecData.size() > 0)
+            {
+                //The spectrum is refreshed with every block, only the most recent one needs to be displayed
+                m_pFSOutput->data()->setValue(m_qVecSpecData.last());
+                m_qVecSpecData.clear();
             }
+            m_qMutex.unlock();
         }//m_bProcessData
     }//m_bIsRunning
     qDebug()<<"noise estimation [Run] is done!";
@@ -46,7 +46,6 @@
 #include "noiseestimate_global.h"
 
 #include <scShared/Interfaces/IAlgorithm.h>
-#include <utils/generics/circularmatrixbuffer.h>
 #include <scMeas/newrealtimemultisamplearray.h>
 #include <scMeas/frequencyspectrum.h>
 #include <realtime/rtProcessing/rtnoise.h>
@@ -94,7 +93,6 @@ namespace NoiseEstimatePlugin
 
 using namespace SCSHAREDLIB;
 using namespace SCMEASLIB;
-using namespace IOBUFFER;
 using namespace REALTIMELIB;
 
 //*************************************************************************************************************
@@ -193,7 +191,8 @@ private:
 
     FiffInfo::SPtr  m_pFiffInfo;                        /**< Fiff measurement info.*/
 
-    CircularMatrixBuffer<double>::SPtr   m_pBuffer;     /**< Holds incoming data.*/
+    MeasurementFrameQueue::SPtr          m_pBuffer;     /**< Holds the incoming frames without copying their data.*/
+    qint32                               m_iBlockSize;  /**< Number of samples per incoming frame.*/
 
     RtNoise::SPtr m_pRtNoise;                       /**< Real-time Noise Estimation. */
     //RtNoise * m_pRtNoise;                       /**< Real-time Noise Estimation. */
@@ -40,6 +40,8 @@
 
 #include "noisereduction.h"
 
+#include <scShared/Management/pipelinetracer.h>
+
 
 //*************************************************************************************************************
 //=============================================================================================================
@@ -50,7 +52,6 @@ using namespace NoiseReductionPlugin;
 using namespace SCSHAREDLIB;
 using namespace SCMEASLIB;
 using namespace UTILSLIB;
-using namespace IOBUFFER;
 using namespace Eigen;
 using namespace DISPLIB;
 using namespace REALTIMELIB;
@@ -65,7 +66,7 @@ NoiseReduction::NoiseReduction()
 : m_bIsRunning(false)
 , m_pNoiseReductionInput(NULL)
 , m_pNoiseReductionOutput(NULL)
-, m_pNoiseReductionBuffer(CircularMatrixBuffer<double>::SPtr())
+, m_pNoiseReductionBuffer(MeasurementFrameQueue::SPtr(new MeasurementFrameQueue(64)))
 , m_iMaxFilterTapSize(0)
 , m_bSpharaActive(false)
 , m_bFilterActivated(false)
@@ -160,10 +161,6 @@ void NoiseReduction::init()
     slFlags << "view" << "triggerdetection" << "scaling" << "colors";
     m_pNoiseReductionOutput->data()->setDisplayFlags(slFlags);
 
-    //Delete Buffer - will be initailzed with first incoming data
-    if(!m_pNoiseReductionBuffer.isNull())
-        m_pNoiseReductionBuffer = CircularMatrixBuffer<double>::SPtr();
-
     //Handle projections
     connect(m_pOptionsWidget.data(), &NoiseReductionOptionsWidget::projSelectionChanged,
             this, &NoiseReduction::updateProjection);
@@ -192,6 +189,8 @@ bool NoiseReduction::start()
 
     m_bIsRunning = true;
 
+    m_fiffInfoReady.reset();
+
     //Start thread
     QThread::start();
 
@@ -204,12 +203,11 @@ bool NoiseReduction::start()
 bool NoiseReduction::stop()
 {
     m_bIsRunning = false;
+    m_fiffInfoReady.cancel();
 
     m_pNoiseReductionBuffer->releaseFromPop();
     m_pNoiseReductionBuffer->clear();
 
-    m_pNoiseReductionBuffer->clear();
-
     return true;
 }
 
@@ -248,27 +246,18 @@ void NoiseReduction::update(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
     m_pRTMSA = pMeasurement.dynamicCast<NewRealTimeMultiSampleArray>();
 
     if(m_pRTMSA) {
-        //Check if buffer initialized
-        if(!m_pNoiseReductionBuffer) {
-            m_pNoiseReductionBuffer = CircularMatrixBuffer<double>::SPtr(new CircularMatrixBuffer<double>(64, m_pRTMSA->getNumChannels(), m_pRTMSA->getMultiSampleArray()[0].cols()));
+        QList<MeasurementFrame::ConstSPtr> lFrames = m_pNoiseReductionInput->takeFrames(pMeasurement);
+
+        if(lFrames.isEmpty()) {
+            return;
         }
 
         //Fiff information
         if(!m_pFiffInfo) {
             m_pFiffInfo = m_pRTMSA->info();
 
-            //Init the multiplication matrices
-            m_matSparseProjMult = SparseMatrix<double>(m_pFiffInfo->chs.size(),m_pFiffInfo->chs.size());
-            m_matSparseCompMult = SparseMatrix<double>(m_pFiffInfo->chs.size(),m_pFiffInfo->chs.size());
-            m_matSparseSpharaMult = SparseMatrix<double>(m_pFiffInfo->chs.size(),m_pFiffInfo->chs.size());
-            m_matSparseProjCompMult = SparseMatrix<double>(m_pFiffInfo->chs.size(),m_pFiffInfo->chs.size());
-            m_matSparseFull = SparseMatrix<double>(m_pFiffInfo->chs.size(),m_pFiffInfo->chs.size());
-
-            m_matSparseProjMult.setIdentity();
-            m_matSparseCompMult.setIdentity();
-            m_matSparseSpharaMult.setIdentity();
-            m_matSparseProjCompMult.setIdentity();
-            m_matSparseFull.setIdentity();
+            //Init the preprocessing pipeline, all operators start as identity
+            m_pRtPreprocessing = RtPreprocessing::SPtr(new RtPreprocessing(m_pFiffInfo));
 
             m_pOptionsWidget->setFiffInfo(m_pFiffInfo);
 
@@ -278,15 +267,16 @@ void NoiseReduction::update(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
             m_pNoiseReductionOutput->data()->setVisibility(true);            
 
             //Init the filter
-            m_iMaxFilterTapSize = m_pRTMSA->getMultiSampleArray().at(m_pRTMSA->getMultiSampleArray().size()-1).cols();
+            m_iMaxFilterTapSize = lFrames.last()->data().cols();
             initFilter();
-        }
 
-        MatrixXd t_mat;
+            //Wake up run(), which waits for the fiff info
+            m_fiffInfoReady.open();
+        }
 
-        for(unsigned char i = 0; i < m_pRTMSA->getMultiArraySize(); ++i) {
-            t_mat = m_pRTMSA->getMultiSampleArray()[i];
-            m_pNoiseReductionBuffer->push(&t_mat);
+        //The frames are immutable and shared with the other consumers, hand them over without copying the data
+        for(int i = 0; i < lFrames.size(); ++i) {
+            m_pNoiseReductionBuffer->push(lFrames.at(i));
         }
     }
 }
@@ -310,6 +300,10 @@ void NoiseReduction::setSpharaMode(bool state)
     m_mutex.lock();
     m_bSpharaActive = state;
     m_mutex.unlock();
+
+    if(m_pRtPreprocessing) {
+        m_pRtPreprocessing->setSpharaActive(state);
+    }
 }
 
 
@@ -346,50 +340,11 @@ void NoiseReduction::updateProjection()
 
         MatrixXd matProj;
         this->m_pFiffInfo->make_projector(matProj);
-//        qDebug() << "NoiseReduction::updateProjection - New projection calculated.";
-//        qDebug() << "NoiseReduction::updateProjection - m_bProjActivated:"<<m_bProjActivated;
-
-        //set columns of matrix to zero depending on bad channels indexes
-        for(qint32 j = 0; j < m_pFiffInfo->bads.size(); ++j) {
-            int index = m_pFiffInfo->ch_names.indexOf(m_pFiffInfo->bads.at(j));
-            if(index >= 0 && index<m_pFiffInfo->ch_names.size()) {
-                matProj.col(index).setZero();
-            }
-        }
-
-//        std::cout << "Bads\n" << m_vecBadIdcs << std::endl;
-//        std::cout << "Proj\n";
-//        std::cout << matProj.block(0,0,10,10) << std::endl;
-
-        //
-        // Make proj sparse
-        //
-        qint32 nchan = this->m_pFiffInfo->nchan;
-        qint32 i, k;
-
-        typedef Eigen::Triplet<double> T;
-        std::vector<T> tripletList;
-        tripletList.reserve(nchan);
-
-        tripletList.clear();
-        tripletList.reserve(matProj.rows()*matProj.cols());
-        for(i = 0; i < matProj.rows(); ++i) {
-            for(k = 0; k < matProj.cols(); ++k) {
-                if(matProj(i,k) != 0) {
-                    tripletList.push_back(T(i, k, matProj(i,k)));
-                }
-            }
-        }
-
-        m_matSparseProjMult = SparseMatrix<double>(matProj.rows(),matProj.cols());
-        if(tripletList.size() > 0)
-            m_matSparseProjMult.setFromTriplets(tripletList.begin(), tripletList.end());
-
-        //Create full multiplication matrix
-        m_matSparseProjCompMult = m_matSparseProjMult * m_matSparseCompMult;
-
-        m_matSparseFull = m_matSparseProjMult * m_matSparseCompMult;
         m_mutex.unlock();
+
+        //Bad channels are excluded from the projector by the preprocessing pipeline
+        m_pRtPreprocessing->updateBadChannels();
+        m_pRtPreprocessing->setProjector(matProj, m_bProjActivated);
     }
 }
 
@@ -419,35 +374,7 @@ void NoiseReduction::updateCompensator(int to)
         this->m_pFiffInfo->set_current_comp(to);
         MatrixXd matComp = newComp.data->data;
 
-        //
-        // Make proj sparse
-        //
-        qint32 nchan = this->m_pFiffInfo->nchan;
-        qint32 i, k;
-
-        typedef Eigen::Triplet<double> T;
-        std::vector<T> tripletList;
-        tripletList.reserve(nchan);
-
-        tripletList.clear();
-        tripletList.reserve(matComp.rows()*matComp.cols());
-        for(i = 0; i < matComp.rows(); ++i) {
-            for(k = 0; k < matComp.cols(); ++k) {
-                if(matComp(i,k) != 0) {
-                    tripletList.push_back(T(i, k, matComp(i,k)));
-                }
-            }
-        }
-
-        m_matSparseCompMult = SparseMatrix<double>(matComp.rows(),matComp.cols());
-        if(tripletList.size() > 0) {
-            m_matSparseCompMult.setFromTriplets(tripletList.begin(), tripletList.end());
-        }
-
-        //Create full multiplication matrix
-        m_matSparseProjCompMult = m_matSparseProjMult * m_matSparseCompMult;
-
-        m_matSparseFull = m_matSparseProjMult * m_matSparseCompMult;
+        m_pRtPreprocessing->setCompensator(matComp, m_bCompActivated);
     }
 }
 
@@ -474,6 +401,10 @@ void NoiseReduction::setFilterChannelType(QString sType)
             }
         }
     }
+
+    if(m_pRtPreprocessing) {
+        m_pRtPreprocessing->setFilter(m_filterData, m_lFilterChannelList);
+    }
 }
 
 
@@ -489,6 +420,10 @@ void NoiseReduction::filterChanged(QList<FilterData> filterData)
             m_iMaxFilterLength = filterData.at(i).m_iFilterOrder;
         }
     }
+
+    if(m_pRtPreprocessing) {
+        m_pRtPreprocessing->setFilter(m_filterData, m_lFilterChannelList);
+    }
 }
 
 
@@ -497,6 +432,10 @@ void NoiseReduction::filterChanged(QList<FilterData> filterData)
 void NoiseReduction::filterActivated(bool state)
 {
     m_bFilterActivated = state;
+
+    if(m_pRtPreprocessing) {
+        m_pRtPreprocessing->setFilterActive(state);
+    }
 }
 
 
@@ -595,8 +534,6 @@ void NoiseReduction::initFilter()
 
     m_pOptionsWidget->filterGroupChanged(m_pFilterWindow->getActivationCheckBoxList());
 
-    m_pRtFilter = RtFilter::SPtr(new RtFilter());
-
     this->setFilterChannelType("MEG");
 
     //Set stored filter settings from last session
@@ -658,57 +595,13 @@ void NoiseReduction::createSpharaOperator()
 //    IOUtils::write_eigen_matrix(matSpharaMultFirst, QString(QCoreApplication::applicationDirPath() + "/mne_scan_plugins/resources/noisereduction/SPHARA/matSpharaMultFirst.txt"));
 //    IOUtils::write_eigen_matrix(matSpharaMultSecond, QString(QCoreApplication::applicationDirPath() + "/mne_scan_plugins/resources/noisereduction/SPHARA/matSpharaMultSecond.txt"));
 
-    //
-    // Make operators sparse
-    //
-    qint32 nchan = this->m_pFiffInfo->nchan;
-    qint32 i, k;
-
-    typedef Eigen::Triplet<double> T;
-    std::vector<T> tripletList;
-    tripletList.reserve(nchan);
-
-    //First operator
-    tripletList.clear();
-    tripletList.reserve(matSpharaMultFirst.rows()*matSpharaMultFirst.cols());
-    for(i = 0; i < matSpharaMultFirst.rows(); ++i) {
-        for(k = 0; k < matSpharaMultFirst.cols(); ++k) {
-            if(matSpharaMultFirst(i,k) != 0) {
-                tripletList.push_back(T(i, k, matSpharaMultFirst(i,k)));
-            }
-        }
-    }
-
-    SparseMatrix<double> matSparseSpharaMultFirst = SparseMatrix<double>(m_pFiffInfo->chs.size(),m_pFiffInfo->chs.size());
-
-    if(tripletList.size() > 0) {
-        matSparseSpharaMultFirst.setFromTriplets(tripletList.begin(), tripletList.end());
-    }
-
-    //Second operator
-    tripletList.clear();
-    tripletList.reserve(matSpharaMultSecond.rows()*matSpharaMultSecond.cols());
-
-    for(i = 0; i < matSpharaMultSecond.rows(); ++i) {
-        for(k = 0; k < matSpharaMultSecond.cols(); ++k) {
-            if(matSpharaMultSecond(i,k) != 0) {
-                tripletList.push_back(T(i, k, matSpharaMultSecond(i,k)));
-            }
-        }
-    }
-
-    SparseMatrix<double>matSparseSpharaMultSecond = SparseMatrix<double>(m_pFiffInfo->chs.size(),m_pFiffInfo->chs.size());
-
-    if(tripletList.size() > 0) {
-        matSparseSpharaMultSecond.setFromTriplets(tripletList.begin(), tripletList.end());
-    }
-
-    //Create full multiplication matrix
-    m_matSparseSpharaMult = matSparseSpharaMultFirst * matSparseSpharaMultSecond;
-
-    m_matSparseFull = m_matSparseProjMult * m_matSparseCompMult;
+    //The pipeline composes the final operator and decides whether to apply it sparse or dense
+    MatrixXd matSphara = matSpharaMultFirst * matSpharaMultSecond;
+    bool bSpharaActive = m_bSpharaActive;
 
     m_mutex.unlock();
+
+    m_pRtPreprocessing->setSphara(matSphara, bSpharaActive);
 }
 
 
@@ -719,8 +612,8 @@ void NoiseReduction::run()
     //
     // Wait for Fiff Info
     //
-    while(!m_pFiffInfo) {
-        msleep(10);// Wait for fiff Info
+    if(!m_fiffInfoReady.wait()) {
+        return;// Stopped before the fiff info arrived
     }
 
     //Set visibility of options tool to true
@@ -733,72 +626,23 @@ void NoiseReduction::run()
     while(m_bIsRunning)
     {
         //Dispatch the inputs
-        MatrixXd t_mat = m_pNoiseReductionBuffer->pop();
+        MeasurementFrame::ConstSPtr pFrame = m_pNoiseReductionBuffer->pop();
 
-        m_mutex.lock();
-
-        //Do SSP's and compensators here
-        if(m_bCompActivated) {
-            if(m_bProjActivated) {
-                //Comp + Proj
-                t_mat = m_matSparseProjCompMult * t_mat;
-            } else {
-                //Comp
-                t_mat = m_matSparseCompMult * t_mat;
-            }
-        } else {
-            if(m_bProjActivated) {
-                //Proj
-                t_mat = m_matSparseProjMult * t_mat;
-            } else {
-                //None - Raw
-            }
+        if(!pFrame) {
+            continue;
         }
 
-        //Do temporal filtering here
-        if(m_bFilterActivated) {
-            t_mat = m_pRtFilter->filterChannelsConcurrently(t_mat, m_iMaxFilterLength, m_lFilterChannelList, m_filterData);
-        }
-
-//        qDebug()<<"t_mat dim:"<<t_mat.rows()<<"x"<<t_mat.cols();
-//        qDebug()<<"m_lFilterChannelList.size():"<<m_lFilterChannelList.size();
-//        qDebug()<<"m_filterData.size():"<<m_filterData.size();
-
-        //Do SPHARA here
-        if(m_bSpharaActive) {
-            //Set bad channels to zero so they do not get smeared into
-            for(int i = 0; i < m_pFiffInfo->bads.size(); ++i) {
-                t_mat.row(m_pFiffInfo->ch_names.indexOf(m_pFiffInfo->bads.at(i))).setZero();
-            }
-
-            t_mat = m_matSparseSpharaMult * t_mat;
+        //Projection, compensation, temporal filtering and SPHARA in one pass
+        MatrixXd t_mat;
+        {
+            PipelineTraceScope trace("NoiseReduction / Preprocessing", pFrame->frameId());
+            t_mat = m_pRtPreprocessing->process(pFrame->data());
         }
 
-//        //Common average
-//        MatrixXd commonAvr = MatrixXd(m_pFiffInfo->chs.size(),m_pFiffInfo->chs.size());
-//        commonAvr.setZero();
-
-//        int nEEGCh = 0;
-
-//        for(int i = 0; i <m_pFiffInfo->chs.size(); ++i) {
-//            if(m_pFiffInfo->chs.at(i).ch_name.contains("EEG") && !m_pFiffInfo->bads.contains(m_pFiffInfo->chs.at(i).ch_name)) {
-//                nEEGCh++;
-//            }
-//        }
-
-//        for(int i = 0; i <m_pFiffInfo->chs.size(); ++i) {
-//            for(int j = 0; j < m_pFiffInfo->chs.size(); ++j) {
-//                if(m_pFiffInfo->chs.at(j).ch_name.contains("EEG") && !m_pFiffInfo->bads.contains(m_pFiffInfo->chs.at(j).ch_name)) {
-//                    commonAvr(i,j) = 1/nEEGCh;
-//                }
-//            }
-//        }
-
-//        UTILSLIB::IOUtils::write_eigen_matrix(commonAvr, "commonAvr.txt", "common vaergae matrix");
-
-        m_mutex.unlock();
-
-        //Send the data to the connected plugins and the online display
-        m_pNoiseReductionOutput->data()->setValue(t_mat);
+        //Send the data to the connected plugins and the online display. The applied steps tell the display which
+        //of its own projection, compensation, SPHARA and filter settings must not be applied a second time.
+        m_pNoiseReductionOutput->data()->setPreprocessingVersion(m_pRtPreprocessing->getOperatorVersion());
+        m_pNoiseReductionOutput->data()->setPreprocessingSteps(m_pRtPreprocessing->getAppliedSteps());
+        m_pNoiseReductionOutput->data()->setValue(t_mat, pFrame);
     }
 }
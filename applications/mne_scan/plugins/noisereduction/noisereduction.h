@@ -50,10 +50,9 @@
 #include "disp/filterwindow.h"
 
 #include <scShared/Interfaces/IAlgorithm.h>
+#include <scShared/Management/readylatch.h>
 
-#include <realtime/rtProcessing/rtfilter.h>
-
-#include <utils/generics/circularmatrixbuffer.h>
+#include <realtime/rtProcessing/rtpreprocessing.h>
 
 #include <scMeas/newrealtimemultisamplearray.h>
 
@@ -281,12 +280,6 @@ private:
     Eigen::VectorXi                 m_vecIndicesSecondBabyMEG;                  /**< The indices of the channels to pick for the second SPHARA oerpator in case of a BabyMEG system.*/
     Eigen::VectorXi                 m_vecIndicesFirstEEG;                       /**< The indices of the channels to pick for the second SPHARA operator in case of an EEG system.*/
 
-    Eigen::SparseMatrix<double>     m_matSparseSpharaMult;                      /**< The final sparse SPHARA operator .*/
-    Eigen::SparseMatrix<double>     m_matSparseProjCompMult;                    /**< The final sparse projection + compensator operator.*/
-    Eigen::SparseMatrix<double>     m_matSparseProjMult;                        /**< The final sparse SSP projector */
-    Eigen::SparseMatrix<double>     m_matSparseCompMult;                        /**< The final sparse compensator matrix */
-    Eigen::SparseMatrix<double>     m_matSparseFull;                            /**< The final sparse full multiplication matrix  */
-
     Eigen::MatrixXd                 m_matSpharaVVGradLoaded;                    /**< The loaded VectorView gradiometer basis functions.*/
     Eigen::MatrixXd                 m_matSpharaVVMagLoaded;                     /**< The loaded VectorView magnetometer basis functions.*/
     Eigen::MatrixXd                 m_matSpharaBabyMEGInnerLoaded;              /**< The loaded babyMEG inner layer basis functions.*/
@@ -296,14 +289,15 @@ private:
     QVector<int>                    m_lFilterChannelList;                       /**< The indices of the channels to be filtered.*/
 
     FIFFLIB::FiffInfo::SPtr                         m_pFiffInfo;                /**< Fiff measurement info.*/
+    ReadyLatch                                      m_fiffInfoReady;            /**< Opened once the fiff info is set by the input.*/
 
-    IOBUFFER::CircularMatrixBuffer<double>::SPtr    m_pNoiseReductionBuffer;    /**< Holds incoming data.*/
+    SCMEASLIB::MeasurementFrameQueue::SPtr          m_pNoiseReductionBuffer;    /**< Holds the incoming frames without copying their data.*/
 
     NoiseReductionOptionsWidget::SPtr               m_pOptionsWidget;           /**< The noise reduction option widget object.*/
     QAction*                                        m_pActionShowOptionsWidget; /**< The noise reduction option widget action.*/
 
     DISPLIB::FilterWindow::SPtr                     m_pFilterWindow;            /**< Filter window. */
-    REALTIMELIB::RtFilter::SPtr                       m_pRtFilter;                /**< Real time filter object. */
+    REALTIMELIB::RtPreprocessing::SPtr              m_pRtPreprocessing;         /**< Fused projection, compensation, filter and SPHARA pipeline. */
 
     SCMEASLIB::NewRealTimeMultiSampleArray::SPtr     m_pRTMSA;                   /**< the real time multi sample array object. */
 
@@ -51,6 +51,7 @@
 #include <QtCore/QtPlugin>
 #include <QtConcurrent>
 #include <QDebug>
+#include <QStandardPaths>
 
 
 //*************************************************************************************************************
@@ -110,8 +111,10 @@ void RapMusicToolbox::init()
 {
     // Inits
     m_pFwd = MNEForwardSolution::SPtr(new MNEForwardSolution(m_qFileFwdSolution));
-    m_pAnnotationSet = AnnotationSet::SPtr(new AnnotationSet(m_sAtlasDir+"/lh.aparc.a2009s.annot", m_sAtlasDir+"/rh.aparc.a2009s.annot"));
-    m_pSurfaceSet = SurfaceSet::SPtr(new SurfaceSet(m_sSurfaceDir+"/lh.white", m_sSurfaceDir+"/rh.white"));
+    //parsed surfaces and annotations are cached, since they are read at every start
+    QString sCacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    m_pAnnotationSet = AnnotationSet::SPtr(new AnnotationSet(m_sAtlasDir+"/lh.aparc.a2009s.annot", m_sAtlasDir+"/rh.aparc.a2009s.annot", sCacheDir));
+    m_pSurfaceSet = SurfaceSet::SPtr(new SurfaceSet(m_sSurfaceDir+"/lh.white", m_sSurfaceDir+"/rh.white", sCacheDir));
 
     // Input
     m_pRTEInput = PluginInputData<RealTimeEvoked>::create(this, "RapMusic Toolbox RTE In", "RapMusic Toolbox real-time evoked input data");
@@ -172,7 +175,8 @@ void RapMusicToolbox::doClustering()
 
     m_qMutex.lock();
     m_bFinishedClustering = false;
-    m_pClusteredFwd = MNEForwardSolution::SPtr(new MNEForwardSolution(m_pFwd->cluster_forward_solution(*m_pAnnotationSet.data(), 40)));
+    MatrixXd matD;
+    m_pClusteredFwd = MNEForwardSolution::SPtr(new MNEForwardSolution(m_pFwd->cluster_forward_solution(*m_pAnnotationSet.data(), 40, matD, FiffCov(), FiffInfo(), QString("cityblock"), m_qFileFwdSolution.fileName())));
     m_qMutex.unlock();
 
     finishedClustering();
@@ -315,9 +319,9 @@ void RapMusicToolbox::run()
         msleep(10);// Wait for fiff Info
     }
 
-    m_pPwlRapMusic.reset();
+    m_pRapMusic.reset();
 
-    m_pPwlRapMusic = RapMusic::SPtr(new RapMusic(*m_pClusteredFwd, false, numDipolePairs));
+    m_pRapMusic = StreamingRapMusic::SPtr(new StreamingRapMusic(*m_pClusteredFwd, 0, numDipolePairs));
 
     //
     // start processing data
@@ -326,7 +330,6 @@ void RapMusicToolbox::run()
     m_bProcessData = true;
     m_qMutex.unlock();
 
-    qint32 skip_count = 0;
     while(true)
     {
         {
@@ -341,26 +344,20 @@ void RapMusicToolbox::run()
 
         if(t_evokedSize > 0)
         {
-            if(m_pPwlRapMusic && ((skip_count % 10) == 0))
-            {
-                m_qMutex.lock();
-                FiffEvoked t_fiffEvoked = m_qVecFiffEvoked[0];
-                m_pPwlRapMusic->setStcAttr(t_fiffEvoked.data.cols()/4.0,0.0);
-                m_qVecFiffEvoked.pop_front();
-                m_qMutex.unlock();
+            //Only the latest evoked is localized, older ones are outdated by it
+            m_qMutex.lock();
+            FiffEvoked t_fiffEvoked = m_qVecFiffEvoked.last();
+            m_qVecFiffEvoked.clear();
+            m_qMutex.unlock();
 
-                qDebug() << "m_pRapMusic->calculateInverse";
+            if(m_pRapMusic)
+            {
+                //Quarter evoked windows which slide by a quarter window, consecutive windows share most samples
+                m_pRapMusic->setStcAttr(t_fiffEvoked.data.cols()/4.0,0.75);
 
-                MNESourceEstimate sourceEstimate = m_pPwlRapMusic->calculateInverse(t_fiffEvoked);
+                MNESourceEstimate sourceEstimate = m_pRapMusic->calculateInverse(t_fiffEvoked);
                 m_pRTSEOutput->data()->setValue(sourceEstimate);
             }
-            else
-            {
-                m_qMutex.lock();
-                m_qVecFiffEvoked.pop_front();
-                m_qMutex.unlock();
-            }
-            ++skip_count;
         }
     }
 }
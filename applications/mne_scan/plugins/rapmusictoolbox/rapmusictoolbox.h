@@ -53,7 +53,7 @@
 #include <fiff/fiff_evoked.h>
 #include <mne/mne_forwardsolution.h>
 #include <mne/mne_sourceestimate.h>
-#include <inverse/rapMusic/pwlrapmusic.h>
+#include <inverse/rapMusic/streamingrapmusic.h>
 
 #include <scMeas/realtimesourceestimate.h>
 #include <scMeas/realtimeevoked.h>
@@ -213,7 +213,7 @@ private:
 
     QStringList                 m_qListPickChannels;        /**< Channels to pick */
 
-    PwlRapMusic::SPtr           m_pPwlRapMusic;     /**< Powell RAP MUSIC. */
+    StreamingRapMusic::SPtr     m_pRapMusic;        /**< Streaming RAP MUSIC. */
     qint32                      m_iDownSample;      /**< Sampling rate */
 
 //    RealTimeSourceEstimate::SPtr m_pRTSE_MNE; /**< Source Estimate output channel. */
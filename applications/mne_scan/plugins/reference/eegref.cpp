@@ -72,7 +72,7 @@ EEGRef::EEGRef()
 
 //*************************************************************************************************************
 
-MatrixXd EEGRef::applyCAR(MatrixXd &matIER, FIFFLIB::FiffInfo::SPtr &pFiffInfo)
+MatrixXd EEGRef::applyCAR(const MatrixXd &matIER, FIFFLIB::FiffInfo::SPtr &pFiffInfo)
 {
     unsigned int numTrueCh  = 0;
     unsigned int numCh      = pFiffInfo->chs.size();
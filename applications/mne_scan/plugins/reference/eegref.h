@@ -101,7 +101,7 @@ public:
     *
     * @return EEG data matrix with common average reference
     */
-    static Eigen::MatrixXd applyCAR(Eigen::MatrixXd& matIER, FIFFLIB::FiffInfo::SPtr &pFiffInfo);
+    static Eigen::MatrixXd applyCAR(const Eigen::MatrixXd& matIER, FIFFLIB::FiffInfo::SPtr &pFiffInfo);
 
 };
 
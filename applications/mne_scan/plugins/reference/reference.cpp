@@ -41,6 +41,8 @@
 
 #include "reference.h"
 
+#include <scShared/Management/pipelinetracer.h>
+
 
 //*************************************************************************************************************
 //=============================================================================================================
@@ -51,7 +53,6 @@ using namespace REFERENCEPLUGIN;
 using namespace SCSHAREDLIB;
 using namespace SCMEASLIB;
 using namespace UTILSLIB;
-using namespace IOBUFFER;
 
 
 //*************************************************************************************************************
@@ -64,7 +65,7 @@ Reference::Reference()
 , m_bProcessData(false)
 , m_pRefInput(Q_NULLPTR)
 , m_pRefOutput(Q_NULLPTR)
-, m_pRefBuffer(Q_NULLPTR)
+, m_pStrand(PluginExecutor::instance()->createStrand("EEG Reference"))
 {
     //Add action which will be visible in the plugin's toolbar
     m_pActionRefToolbarWidget = new QAction(QIcon(":/icons/options.png"), tr("Reference Toolbar"),this);
@@ -83,8 +84,8 @@ Reference::Reference()
 
 Reference::~Reference()
 {
-    if(this->isRunning())
-        stop();
+    //Always drain the strand, blocks may still be queued even if the plugin was never started or already stopped
+    stop();
 }
 
 
@@ -110,10 +111,6 @@ void Reference::init()
     // Also, this output stream will generate an online display in your plugin
     m_pRefOutput = PluginOutputData<NewRealTimeMultiSampleArray>::create(this, "ReferenceOut", "Reference output data");
     m_outputConnectors.append(m_pRefOutput);
-
-    //Delete Buffer - will be initailzed with first incoming data
-    if(!m_pRefBuffer.isNull())
-        m_pRefBuffer.clear();
 }
 
 
@@ -129,14 +126,10 @@ void Reference::unload()
 
 bool Reference::start()
 {
-    //Check if the thread is already or still running. This can happen if the start button is pressed immediately after the stop button was pressed. In this case the stopping process is not finished yet but the start process is initiated.
-    if(this->isRunning())
-        QThread::wait();
-
+    //The blocks are processed on the shared plugin executor as they arrive in update(), no thread is started here
+    QMutexLocker locker(&m_qMutex);
     m_bIsRunning = true;
-
-    //Start thread
-    QThread::start();
+    m_bProcessData = true;
 
     return true;
 }
@@ -146,19 +139,15 @@ bool Reference::start()
 
 bool Reference::stop()
 {
+    // Stop filling the strand with data from the inputs
+    m_qMutex.lock();
     m_bIsRunning = false;
-
-    // Only clear if buffers have been initialised
-    if(m_bProcessData)
-    {
-        m_pRefBuffer->releaseFromPop();
-        m_pRefBuffer->releaseFromPush();
-
-        m_pRefBuffer->clear();
-    }
-
-    // Stop filling buffers with data from the inputs
     m_bProcessData = false;
+    m_qMutex.unlock();
+
+    // Drop the blocks which were not processed yet and wait for the one in progress
+    m_pStrand->clear();
+    m_pStrand->waitForDone();
 
    return true;
 }
@@ -196,9 +185,10 @@ void Reference::update(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
     QSharedPointer<NewRealTimeMultiSampleArray> pRTMSA = pMeasurement.dynamicCast<NewRealTimeMultiSampleArray>();
 
     if(pRTMSA) {
-        //Check if buffer initialized
-        if(!m_pRefBuffer) {
-            m_pRefBuffer = CircularMatrixBuffer<double>::SPtr(new _double_CircularMatrixBuffer(64, pRTMSA->getNumChannels(), pRTMSA->getMultiSampleArray()[0].cols()));
+        QList<MeasurementFrame::ConstSPtr> lFrames = m_pRefInput->takeFrames(pMeasurement);
+
+        if(lFrames.isEmpty()) {
+            return;
         }
 
         //Fiff information
@@ -214,16 +204,29 @@ void Reference::update(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
         }
 
 
-        // filling the matrix buffer
+        // process the blocks in order on the shared plugin executor, the frames are immutable and shared with the task
+        QMutexLocker locker(&m_qMutex);
+
         if(m_bProcessData)
         {
-            MatrixXd t_mat;
-            for(qint32 i = 0; i < pRTMSA->getMultiArraySize(); ++i){
-                t_mat = pRTMSA->getMultiSampleArray()[i];
-                m_pRefBuffer->push(&t_mat);
-            }
+            FIFFLIB::FiffInfo::SPtr pFiffInfo = m_pFiffInfo;
+
+            m_pStrand->post([this, lFrames, pFiffInfo]() mutable {
+                for(qint32 i = 0; i < lFrames.size(); ++i){
+                    const MeasurementFrame::ConstSPtr& pFrame = lFrames.at(i);
+
+                    // apply common average reference
+                    MatrixXd matCAR;
+                    {
+                        PipelineTraceScope trace("EEG Reference / CAR", pFrame->frameId());
+                        matCAR = EEGRef::applyCAR(pFrame->data(), pFiffInfo);
+                    }
+
+                    //Send the data to the connected plugins and the online display
+                    m_pRefOutput->data()->setValue(matCAR, pFrame);
+                }
+            });
         }
-
     }
 }
 
@@ -232,24 +235,7 @@ void Reference::update(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
 
 void Reference::run()
 {
-    //
-    // Wait for Fiff Info
-    //
-    m_bProcessData = true;
-    while(!m_pFiffInfo)
-        msleep(10);// Wait for fiff Info
-
-    while(m_bIsRunning)
-    {
-        //Dispatch the inputs
-        MatrixXd t_mat = m_pRefBuffer->pop();
-
-        // apply common average reference
-        MatrixXd matCAR = EEGRef::applyCAR(t_mat, m_pFiffInfo);
-
-        //Send the data to the connected plugins and the online display
-        m_pRefOutput->data()->setValue(matCAR);
-    }
+    //Required by IAlgorithm only. start() never starts this thread, the blocks are processed on the strand posted to in update()
 }
 
 
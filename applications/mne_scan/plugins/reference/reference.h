@@ -46,7 +46,7 @@
 #include "reference_global.h"
 
 #include <scShared/Interfaces/IAlgorithm.h>
-#include <utils/generics/circularmatrixbuffer.h>
+#include <scShared/Management/pluginexecutor.h>
 #include <scMeas/newrealtimemultisamplearray.h>
 #include <eegref.h>
 
@@ -61,6 +61,7 @@
 
 #include <QtWidgets>
 #include <QtCore/QtPlugin>
+#include <QMutex>
 #include <QDebug>
 
 
@@ -130,7 +131,8 @@ public:
 protected:
     //=========================================================================================================
     /**
-    * IAlgorithm function
+    * IAlgorithm function. Empty, start() does not start the plugin thread since the incoming blocks are processed
+    * on the shared plugin executor, see update().
     */
     virtual void run();
 
@@ -144,16 +146,18 @@ private:
     bool                                            m_bIsRunning;           /**< Flag whether thread is running.*/
     bool                                            m_bProcessData;         /**< Flag for processing data.*/
 
+    QMutex                                          m_qMutex;               /**< Guards the flags, so no block is posted to the strand after stop().*/
+
     FIFFLIB::FiffInfo::SPtr                         m_pFiffInfo;            /**< Fiff measurement info.*/
 
     QSharedPointer<ReferenceToolbarWidget>              m_pRefToolbarWidget;            /**< flag whether thread is running.*/
     QAction*                                            m_pActionRefToolbarWidget;      /**< flag whether thread is running.*/
 
-    QSharedPointer<IOBUFFER::_double_CircularMatrixBuffer>  m_pRefBuffer;                   /**< Holds incoming data.*/
-
     SCSHAREDLIB::PluginInputData<SCMEASLIB::NewRealTimeMultiSampleArray>::SPtr      m_pRefInput;      /**< The NewRealTimeMultiSampleArray of the Reference input.*/
     SCSHAREDLIB::PluginOutputData<SCMEASLIB::NewRealTimeMultiSampleArray>::SPtr     m_pRefOutput;     /**< The NewRealTimeMultiSampleArray of the Reference output.*/
 
+    SCSHAREDLIB::PluginStrand::SPtr                     m_pStrand;                      /**< Runs the processing of the incoming blocks in order on the shared plugin executor. Declared last, so it is drained before the output is destroyed.*/
+
 signals:
     //=========================================================================================================
     /**
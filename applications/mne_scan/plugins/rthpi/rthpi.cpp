@@ -42,6 +42,7 @@
 #include <iostream>
 #include "rthpi.h"
 #include "FormFiles/rthpisetupwidget.h"
+#include <scShared/Management/pipelinetracer.h>
 #include <math.h>
 #include <string>
 #include <vector>
@@ -77,7 +78,7 @@ RtHpi::RtHpi()
 , m_bProcessData(false)
 , m_pRTMSAInput(NULL)
 , m_pRTMSAOutput(NULL)
-, m_pRtHpiBuffer(CircularMatrixBuffer<double>::SPtr())
+, m_pRtHpiBuffer(MeasurementFrameQueue::SPtr(new MeasurementFrameQueue(8)))
 {
 }
 
@@ -122,10 +123,6 @@ void RtHpi::init()
 
     //init channels when fiff info is available
     connect(this, &RtHpi::fiffInfoAvailable, this, &RtHpi::initConnector);
-
-    //Delete Buffer - will be initailzed with first incoming data
-    if(!m_pRtHpiBuffer.isNull())
-        m_pRtHpiBuffer = CircularMatrixBuffer<double>::SPtr();
 }
 
 
@@ -157,6 +154,8 @@ bool RtHpi::start()
 
     m_bIsRunning = true;
 
+    m_fiffInfoReady.reset();
+
     // Start threads
     QThread::start();
 
@@ -171,14 +170,14 @@ bool RtHpi::stop()
     //Wait until this thread is stopped
     m_qMutex.lock();
     m_bIsRunning = false;
+    m_fiffInfoReady.cancel();
     m_qMutex.unlock();
 
 
     if(m_bProcessData)
     {
-        //In case the semaphore blocks the thread -> Release the QSemaphore and let it exit from the pop function (acquire statement)
+        //In case the queue blocks the thread -> Release it and let it exit from the pop function
         m_pRtHpiBuffer->releaseFromPop();
-        m_pRtHpiBuffer->releaseFromPush();
 
 //        m_pRtHpiBuffer->clear();
 
@@ -222,28 +221,27 @@ void RtHpi::update(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
 
     if(pRTMSA)
     {
-        m_qMutex.lock();
-        //Check if buffer initialized
-        if(!m_pRtHpiBuffer)
-            m_pRtHpiBuffer = CircularMatrixBuffer<double>::SPtr(new CircularMatrixBuffer<double>(8, pRTMSA->getNumChannels(), pRTMSA->getMultiSampleArray()[0].cols()));
+        QList<MeasurementFrame::ConstSPtr> lFrames = m_pRTMSAInput->takeFrames(pMeasurement);
+
+        if(lFrames.isEmpty())
+            return;
 
+        m_qMutex.lock();
         //Fiff information
         if(!m_pFiffInfo)
         {
             m_pFiffInfo = pRTMSA->info();
             emit fiffInfoAvailable();
+
+            //Wake up run(), which waits for the fiff info
+            m_fiffInfoReady.open();
         }
 
         m_qMutex.unlock();
         if(m_bProcessData)
         {
-            MatrixXd t_mat;
-
-            for(qint32 i = 0; i < pRTMSA->getMultiArraySize(); ++i)
-            {
-                t_mat = pRTMSA->getMultiSampleArray()[i];
-                m_pRtHpiBuffer->push(&t_mat);
-            }
+            for(qint32 i = 0; i < lFrames.size(); ++i)
+                m_pRtHpiBuffer->push(lFrames.at(i));
         }
     }
 }
@@ -257,16 +255,8 @@ void RtHpi::run()
     //
     // Read Fiff Info and wait if absent
     //
-    bool waitForFiffInfo = true;
-    while(waitForFiffInfo)
-    {
-        m_qMutex.lock();
-
-        if(m_pFiffInfo) waitForFiffInfo = false;
-
-        m_qMutex.unlock();
-        msleep(10);// Wait for fiff Info
-    }
+    if(!m_fiffInfoReady.wait())
+        return;// Stopped before the fiff info arrived
 
     m_qMutex.lock();
     m_bProcessData = true;
@@ -278,8 +268,12 @@ void RtHpi::run()
 
     while (m_bIsRunning) {
         if(m_bProcessData) {
-            MatrixXd t_mat = m_pRtHpiBuffer->pop();
-            m_pRtHPIS->append(t_mat);
+            MeasurementFrame::ConstSPtr pFrame = m_pRtHpiBuffer->pop();
+
+            if(pFrame) {
+                PipelineTraceScope trace("RtHpi / Append", pFrame->frameId());
+                m_pRtHPIS->append(pFrame->data());
+            }
         }
         //msleep(1);
     }
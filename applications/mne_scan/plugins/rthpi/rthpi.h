@@ -46,7 +46,7 @@
 #include "rthpi_global.h"
 
 #include <scShared/Interfaces/IAlgorithm.h>
-#include <utils/generics/circularmatrixbuffer.h>
+#include <scShared/Management/readylatch.h>
 #include <scMeas/newrealtimemultisamplearray.h>
 #include <realtime/rtProcessing/rthpis.h>
 
@@ -83,7 +83,6 @@ namespace RtHpiPlugin
 
 using namespace SCSHAREDLIB;
 using namespace SCMEASLIB;
-using namespace IOBUFFER;
 using namespace REALTIMELIB;
 
 
@@ -165,8 +164,9 @@ private:
 
 
     FiffInfo::SPtr  m_pFiffInfo;                            /**< Fiff measurement info.*/
+    ReadyLatch      m_fiffInfoReady;                        /**< Opened once the fiff info is set by the input.*/
 
-    CircularMatrixBuffer<double>::SPtr   m_pRtHpiBuffer;    /**< Holds incoming data.*/
+    MeasurementFrameQueue::SPtr          m_pRtHpiBuffer;    /**< Holds the incoming frames without copying their data.*/
 
     bool m_bIsRunning;      /**< If source lab is running */
     bool m_bProcessData;    /**< If data should be received for processing */
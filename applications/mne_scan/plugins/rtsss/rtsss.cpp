@@ -42,6 +42,8 @@
 #include "rtsssalgo.h"
 #include "FormFiles/rtssssetupwidget.h"
 
+#include <scShared/Management/pipelinetracer.h>
+
 //*************************************************************************************************************
 //=============================================================================================================
 // QT INCLUDES
@@ -110,9 +112,7 @@ void RtSss::init()
 {
     //qDebug() << "*********** Initialization ************";
 
-    //Delete Buffer - will be initailzed with first incoming data
-    if(!m_pRtSssBuffer.isNull())
-        m_pRtSssBuffer = CircularMatrixBuffer<double>::SPtr();
+    m_pRtSssBuffer = MeasurementFrameQueue::SPtr(new MeasurementFrameQueue(32));
 
     // Input
     m_pRTMSAInput = PluginInputData<NewRealTimeMultiSampleArray>::create(this, "RtSssIn", "RtSss input data");
@@ -173,9 +173,8 @@ bool RtSss::stop()
 
     if(m_bProcessData)
     {
-        //In case the semaphore blocks the thread -> Release the QSemaphore and let it exit from the pop function (acquire statement)
+        //In case the queue blocks the thread -> Release it and let it exit from the pop function
         m_pRtSssBuffer->releaseFromPop();
-        m_pRtSssBuffer->releaseFromPush();
 
         m_pRtSssBuffer->clear();
     }
@@ -270,24 +269,19 @@ void RtSss::update(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
 
     QSharedPointer<NewRealTimeMultiSampleArray> pRTMSA = pMeasurement.dynamicCast<NewRealTimeMultiSampleArray>();
 
-    if(pRTMSA && m_bReceiveData)
-    {
-        //Check if buffer initialized
-        if(!m_pRtSssBuffer)
-            m_pRtSssBuffer = CircularMatrixBuffer<double>::SPtr(new CircularMatrixBuffer<double>(32, pRTMSA->getNumChannels(), pRTMSA->getMultiSampleArray()[0].cols()));
+    //Always drain the input queue, frames received while not listening are discarded
+    QList<MeasurementFrame::ConstSPtr> lFrames = m_pRTMSAInput->takeFrames(pMeasurement);
 
+    if(pRTMSA && m_bReceiveData && !lFrames.isEmpty())
+    {
         //Fiff information
         if(!m_pFiffInfo)
             m_pFiffInfo = pRTMSA->info();
 
         if(m_bProcessData)
         {
-            MatrixXd in_mat;
-            for(unsigned char i = 0; i < pRTMSA->getMultiArraySize(); ++i)
-            {
-                in_mat = pRTMSA->getMultiSampleArray()[i];
-                m_pRtSssBuffer->push(&in_mat);
-            }
+            for(qint32 i = 0; i < lFrames.size(); ++i)
+                m_pRtSssBuffer->push(lFrames.at(i));
         }
     }
 }
@@ -424,12 +418,13 @@ void RtSss::run()
 //            m_bIsHeadMov = true;
 //        }
 
-        qint16 nrows = m_pRtSssBuffer->rows();
+        // * Dispatch the inputs * //
+        MeasurementFrame::ConstSPtr pFrame = m_pRtSssBuffer->pop();
 
-        if(nrows > 0) // check if init
+        if(pFrame) // null when released on stop
         {
-            // * Dispatch the inputs * //
-            MatrixXd in_mat = m_pRtSssBuffer->pop();
+            //The picked channels are written back below, so work on a copy of the shared frame
+            MatrixXd in_mat = pFrame->data();
 //            qDebug() << "size of in_mat (run): " << in_mat.rows() << " x " << in_mat.cols();
 
             //Generate new matrix from picked channels
@@ -449,7 +444,10 @@ void RtSss::run()
 //                }
 //            in_mat_used = in_mat.block(0,0,nmegchanused,in_mat.cols());
 
-           in_mat_used = rt_sss(in_mat_used);
+            {
+                PipelineTraceScope trace("RtSss / SSS", pFrame->frameId());
+                in_mat_used = rt_sss(in_mat_used);
+            }
 
             // Implement Concurrent mapreduced for parallel processing
             // divide the in_mat_used into 2 or 4 matrices, which renders 50ms or 25ms data
@@ -480,7 +478,7 @@ void RtSss::run()
             }
 
             // Output to display
-            m_pRTMSAOutput->data()->setValue(0.01* in_mat);
+            m_pRTMSAOutput->data()->setValue(0.01* in_mat, pFrame);
 
 //            cnt++;
 //            qDebug() << cnt << "   " ;
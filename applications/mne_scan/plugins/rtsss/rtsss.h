@@ -46,7 +46,6 @@
 
 #include <scShared/Interfaces/IAlgorithm.h>
 #include <utils/generics/circularbuffer.h>
-#include <utils/generics/circularmatrixbuffer.h>
 
 #include <scMeas/newrealtimesamplearray.h>
 #include <scMeas/newrealtimemultisamplearray.h>
@@ -82,7 +81,6 @@ namespace RtSssPlugin
 using namespace SCSHAREDLIB;
 using namespace FIFFLIB;
 using namespace SCMEASLIB;
-using namespace IOBUFFER;
 
 
 //*************************************************************************************************************
@@ -171,7 +169,7 @@ private:
 
     FiffInfo::SPtr              m_pFiffInfo;        /**< Fiff information. */
 
-    CircularMatrixBuffer<double>::SPtr m_pRtSssBuffer;   /**< Holds incoming rt server data.*/
+    MeasurementFrameQueue::SPtr m_pRtSssBuffer;          /**< Holds the incoming rt server frames without copying their data.*/
 
     int LinRR, LoutRR, Lin, Lout;
 
@@ -44,6 +44,8 @@
 #include <Eigen/Dense>
 #include <utils/ioutils.h>
 
+#include <scShared/Management/pipelinetracer.h>
+
 
 //*************************************************************************************************************
 //=============================================================================================================
@@ -65,6 +67,7 @@ using namespace SCSHAREDLIB;
 using namespace SCMEASLIB;
 using namespace IOBUFFER;
 using namespace FSLIB;
+using namespace REALTIMELIB;
 using namespace std;
 
 
@@ -86,6 +89,7 @@ SsvepBci::SsvepBci()
 , m_iNumberOfClassHits(15)
 , m_iClassListSize(20)
 , m_iNumberOfClassBreaks(30)
+, m_bLatencyLogging(false)
 {
     // Create configuration action bar item/button
     m_pActionBCIConfiguration = new QAction(QIcon(":/images/configuration.png"),tr("BCI configuration feature"),this);
@@ -171,8 +175,8 @@ void SsvepBci::init()
 //    m_pBCIOutputFive->data()->setName("Right electrode");
 //    m_outputConnectors.append(m_pBCIOutputFive);
 
-    // Delete Buffer - will be initailzed with first incoming data
-    m_pBCIBuffer_Sensor = CircularMatrixBuffer<double>::SPtr();
+    // Delete Buffer - the source buffer will be initailzed with first incoming data
+    m_pBCIBuffer_Sensor = MeasurementFrameQueue::SPtr(new MeasurementFrameQueue(64));
     m_pBCIBuffer_Source = CircularMatrixBuffer<double>::SPtr();
 
     // Delete fiff info because the initialisation of the fiff info is seen as the first data acquisition from the input stream
@@ -206,13 +210,16 @@ bool SsvepBci::start()
     m_pFiffInfo_Sensor = FiffInfo::SPtr();
 
     // initialize time window parameters
-    m_iWriteIndex   = 0;
-    m_iReadIndex    = 0;
     m_iCounter      = 0;
     m_iReadToWriteBuffer = 0;
     m_iDownSampleIndex   = 0;
     m_iFormerDownSampleIndex = 0;
     m_iWindowSize        = 8;
+    m_iLatencySum   = 0;
+    m_iLatencyMax   = 0;
+    m_iLatencyCount = 0;
+    m_qQueueArrivalTimes.clear();
+    m_arrivalClock.start();
     m_bIsRunning    = true;
 
     // starting the thread for data processing
@@ -228,13 +235,15 @@ bool SsvepBci::stop()
 {
     m_bIsRunning = false;
 
+    // Wake the processing thread if it still waits for the fiff information
+    m_qWaitFiffInfo.wakeAll();
+
     // Get data buffers out of idle state if they froze in the acquire or release function
     //In case the semaphore blocks the thread -> Release the QSemaphore and let it exit from the pop function (acquire statement)
 
     if(m_bProcessData) // Only clear if buffers have been initialised
     {
         m_pBCIBuffer_Sensor->releaseFromPop();
-        m_pBCIBuffer_Sensor->releaseFromPush();
 //        m_pBCIBuffer_Source->releaseFromPop();
 //        m_pBCIBuffer_Source->releaseFromPush();
     }
@@ -284,13 +293,14 @@ void SsvepBci::updateSensor(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
 {
     // initialize the sample array which will be filled with raw data
     QSharedPointer<NewRealTimeMultiSampleArray> pRTMSA = pMeasurement.dynamicCast<NewRealTimeMultiSampleArray>();
-    if(pRTMSA){
-        //Check if buffer initialized
-        m_qMutex.lock();
-        if(!m_pBCIBuffer_Sensor)
-            m_pBCIBuffer_Sensor = CircularMatrixBuffer<double>::SPtr(new CircularMatrixBuffer<double>(64, pRTMSA->getNumChannels(), pRTMSA->getMultiSampleArray()[0].cols()));
-    }
+    if(!pRTMSA)
+        return;
 
+    QList<MeasurementFrame::ConstSPtr> lFrames = m_pRTMSAInput->takeFrames(pMeasurement);
+    if(lFrames.isEmpty())
+        return;
+
+    m_qMutex.lock();
     //Fiff information
     if(!m_pFiffInfo_Sensor)
     {
@@ -305,25 +315,30 @@ void SsvepBci::updateSensor(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
 
         // determine sliding time window parameters
         m_iReadSampleSize = 0.1*m_dSampleFrequency;    // about 0.1 second long time segment as basic read increment
-        m_iWriteSampleSize = pRTMSA->getMultiSampleArray()[0].cols();
-        m_iTimeWindowLength = int(5*m_dSampleFrequency) + int(pRTMSA->getMultiSampleArray()[0].cols()/m_iDownSampleIncrement) + 1 ;
+        m_iWriteSampleSize = lFrames.first()->data().cols();
+        m_iTimeWindowLength = int(5*m_dSampleFrequency) + int(lFrames.first()->data().cols()/m_iDownSampleIncrement) + 1 ;
         //m_iTimeWindowSegmentSize  = int(5*m_dSampleFrequency / m_iWriteSampleSize) + 1;   // 4 seconds long maximal sized window
-        m_matSlidingTimeWindow.resize(m_lElectrodeNumbers.size(), m_iTimeWindowLength);//m_matSlidingTimeWindow.resize(rows, m_iTimeWindowSegmentSize*pRTMSA->getMultiSampleArray()[0].cols());
+        m_pRtBciFeatures = RtBciFeatures::SPtr(new RtBciFeatures(m_lElectrodeNumbers.size(), m_iTimeWindowLength, m_dSampleFrequency));
 
         cout << "Down Sample Increment:" << m_iDownSampleIncrement << endl;
         cout << "Read Sample Size:" << m_iReadSampleSize << endl;
         cout << "Downsampled Frequency:" << m_dSampleFrequency << endl;
         cout << "Write Sample SIze :" << m_iWriteSampleSize<< endl;
         cout << "Length of the time window:" << m_iTimeWindowLength << endl;
+
+        m_qWaitFiffInfo.wakeAll();
     }
     m_qMutex.unlock();
 
-    // filling the matrix buffer
+    // filling the frame queue, the arrival time is stamped before the block is queued so that the latency includes the queueing time.
+    // A full queue drops its oldest frame, whose arrival time is dropped along with it.
     if(m_bProcessData){
-        MatrixXd t_mat;
-        for(qint32 i = 0; i < pRTMSA->getMultiArraySize(); ++i){
-            t_mat = pRTMSA->getMultiSampleArray()[i];
-            m_pBCIBuffer_Sensor->push(&t_mat);
+        for(qint32 i = 0; i < lFrames.size(); ++i){
+            m_qMutex.lock();
+            m_qQueueArrivalTimes.enqueue(m_arrivalClock.nsecsElapsed());
+            if(!m_pBCIBuffer_Sensor->push(lFrames.at(i)) && !m_qQueueArrivalTimes.isEmpty())
+                m_qQueueArrivalTimes.dequeue();
+            m_qMutex.unlock();
         }
     }
 }
@@ -417,6 +432,13 @@ void SsvepBci::setSizeClassList(int classListSize){
 }
 
 
+//*************************************************************************************************************
+
+void SsvepBci::setLatencyLogging(bool bEnabled){
+    m_bLatencyLogging = bEnabled;
+}
+
+
 //*************************************************************************************************************
 
 QString SsvepBci::getSsvepBciResourcePath(){
@@ -532,15 +554,16 @@ void SsvepBci::changeSSVEPParameter(){
             }
 
             // reset sliding time window parameter
-            m_iWriteIndex   = 0;
-            m_iReadIndex    = 0;
             m_iCounter      = 0;
             m_iReadToWriteBuffer = 0;
             m_iDownSampleIndex   = 0;
             m_iFormerDownSampleIndex = 0;
 
-            // resize the time window with new electrode numbers
-            m_matSlidingTimeWindow.resize(m_lElectrodeNumbers.size(), m_iTimeWindowLength);
+            // recreate the time window with new electrode numbers, it is swapped under the mutex since the input may (re)initialize it concurrently
+            RtBciFeatures::SPtr pRtBciFeatures(new RtBciFeatures(m_lElectrodeNumbers.size(), m_iTimeWindowLength, m_dSampleFrequency));
+            m_qMutex.lock();
+            m_pRtBciFeatures = pRtBciFeatures;
+            m_qMutex.unlock();
         }
     }
 
@@ -601,139 +624,60 @@ QList<double> SsvepBci::getCurrentListOfFrequencies(){
 }
 
 
-//*************************************************************************************************************
-
-double SsvepBci::MEC(MatrixXd &Y, MatrixXd &X)
-{
-
-    // Remove SSVEP harmonic frequencies
-    MatrixXd X_help = X.transpose()*X;
-    MatrixXd Ytilde = Y - X*X_help.inverse()*X.transpose()*Y;
-
-    // Find eigenvalues and eigenvectors
-    SelfAdjointEigenSolver<MatrixXd> eigensolver(Ytilde.transpose()*Ytilde);    
-
-    // Determine number of channels Ns
-    int Ns;
-    VectorXd cumsum = eigensolver.eigenvalues();
-    for(int j = 1; j < eigensolver.eigenvalues().size(); j++){
-        cumsum(j) += cumsum(j - 1);
-    }
-    for(Ns = 0; Ns < eigensolver.eigenvalues().size() ; Ns++){
-        if(cumsum(Ns)/eigensolver.eigenvalues().sum() > 0.1){
-            break;
-        }
-    }
-    Ns += 1;
-
-    // Determine spatial filter matrix W
-    MatrixXd W = eigensolver.eigenvectors().block(0, 0, eigensolver.eigenvectors().rows(), Ns);   
-    for(int k = 0; k < Ns; k++){
-        W.col(k) = W.col(k)*(1/sqrt(eigensolver.eigenvalues()(k)));
-    }
-
-    // Calcuclate channel signals
-    MatrixXd S = Y*W;
-
-    // Calculate signal energy
-    MatrixXd P(2, Ns);
-    double power = 0;
-    for(int k = 0; k < m_iNumberOfHarmonics; k++){
-        P = X.block(0, 2*k, X.rows(), 2).transpose()*S;
-        P = P.array()*P.array();
-        power += 1 / double(m_iNumberOfHarmonics*Ns) * P.sum();
-    }
-
-    return power;
-}
-
-
-//*************************************************************************************************************
-
-double SsvepBci::CCA(MatrixXd &Y, MatrixXd &X)
-{
-    // CCA parameter
-    int n  = X.rows();
-    int p1 = X.cols();
-    int p2 = Y.cols();
-
-    // center data sets
-    MatrixXd X_center(n, p1);
-    MatrixXd Y_center(n, p2);
-    for(int i = 0; i < p1; i++){
-        X_center.col(i) = X.col(i).array() - X.col(i).mean();
-    }
-
-    for(int i = 0; i < p2; i++){
-        Y_center.col(i) = Y.col(i).array() - Y.col(i).mean();
-    }
-
-    // QR decomposition
-    MatrixXd Q1, Q2;
-    ColPivHouseholderQR<MatrixXd> qr1(X_center), qr2(Y_center);
-    Q1 = qr1.householderQ() * MatrixXd::Identity(n, p1);
-    Q2 = qr2.householderQ() * MatrixXd::Identity(n, p2);
-
-    // SVD decomposition, determine max correlation
-    JacobiSVD<MatrixXd> svd(Q1.transpose()*Q2); // ComputeThinU | ComputeThinV
-
-    return svd.singularValues().maxCoeff();
-}
-
-
-//*************************************************************************************************************
-
-void SsvepBci::readFromSlidingTimeWindow(MatrixXd &data)
-{
-    data.resize(m_matSlidingTimeWindow.rows(), m_iWindowSize*m_iReadSampleSize);
-
-    // consider matrix overflow case
-    if(data.cols() > m_iReadIndex + 1){
-        int width = data.cols() - (m_iReadIndex + 1);
-        data.block(0, 0, data.rows(), width) = m_matSlidingTimeWindow.block(0, m_matSlidingTimeWindow.cols() - width , data.rows(), width );
-        data.block(0, width, data.rows(), m_iReadIndex + 1) = m_matSlidingTimeWindow.block(0, 0, data.rows(), m_iReadIndex + 1);
-    }
-    else{
-        data = m_matSlidingTimeWindow.block(0, m_iReadIndex - (data.cols() - 1), data.rows(), data.cols());  // consider case without matrix overflow
-    }
-    // transpose in the same data space and avoiding aliasing
-    data.transposeInPlace();
-}
-
-
 //*************************************************************************************************************
 
 void SsvepBci::ssvepBciOnSensor()
 {
 
     // Wait for fiff Info if not yet received - this is needed because we have to wait until the buffers are firstly initiated in the update functions
-    while(!m_pFiffInfo_Sensor){
-        msleep(10);
+    m_qMutex.lock();
+    while(!m_pFiffInfo_Sensor && m_bIsRunning){
+        m_qWaitFiffInfo.wait(&m_qMutex);
+    }
+    m_qMutex.unlock();
+
+    if(!m_pFiffInfo_Sensor){
+        return;
     }
     // reset list of classifiaction results
     MatrixXd m_matSSVEPProbabilities(m_lDesFrequencies.size(), 0);
 
     // Start filling buffers with data from the inputs
     m_bProcessData = true;
-    MatrixXd t_mat = m_pBCIBuffer_Sensor->pop();
+    MeasurementFrame::ConstSPtr pFrame = m_pBCIBuffer_Sensor->pop();
+    if(!pFrame){
+        return;
+    }
+    const MatrixXd& t_mat = pFrame->data();
+
+    // the feature extraction and classification of the block is traced as one processing run
+    PipelineTraceScope trace("SSVEP-BCI-EEG / Classification", pFrame->frameId());
 
-    // writing selected feature channels to the time window storage and increase the segment index
+    // the latency of each classification is measured from the arrival of the data block at the input. The time window is
+    // only referenced via a local pointer so that a concurrent swap does not destroy it while it is in use.
+    m_qMutex.lock();
+    qint64 iArrivalTime = m_qQueueArrivalTimes.isEmpty() ? m_arrivalClock.nsecsElapsed() : m_qQueueArrivalTimes.dequeue();
+    RtBciFeatures::SPtr pRtBciFeatures = m_pRtBciFeatures;
+    m_qMutex.unlock();
+
+    // collect the selected feature channels while downsampling and write them to the time window
+    MatrixXd matSamples(m_lElectrodeNumbers.size(), m_iWriteSampleSize/m_iDownSampleIncrement + 1);
     int   writtenSamples = 0;
     while(m_iDownSampleIndex >= m_iFormerDownSampleIndex){
 
-        // write from t_mat to the sliding time window while doing channel select and downsampling
         m_iFormerDownSampleIndex = m_iDownSampleIndex;
         for(int i = 0; i < m_lElectrodeNumbers.size(); i++){
-            m_matSlidingTimeWindow(i, m_iWriteIndex) = t_mat(m_lElectrodeNumbers.at(i), m_iDownSampleIndex);
+            matSamples(i, writtenSamples) = t_mat(m_lElectrodeNumbers.at(i), m_iDownSampleIndex);
         }
         writtenSamples++;
 
         // update counter variables
-        m_iWriteIndex = (m_iWriteIndex + 1) % m_iTimeWindowLength;
         m_iDownSampleIndex = (m_iDownSampleIndex + m_iDownSampleIncrement ) % m_iWriteSampleSize;
 
     }
     m_iFormerDownSampleIndex = m_iDownSampleIndex;
+    pRtBciFeatures->append(matSamples.leftCols(writtenSamples));
+    pRtBciFeatures->setReferenceFrequencies(m_lAllFrequencies, m_iNumberOfHarmonics);
 
     // calculate buffer between read- and write index
     m_iReadToWriteBuffer = m_iReadToWriteBuffer + writtenSamples;
@@ -752,45 +696,21 @@ void SsvepBci::ssvepBciOnSensor()
                 m_iWindowSize = 40;
             }
 
-            // create current data matrix Y
-            MatrixXd Y;
-            readFromSlidingTimeWindow(Y);
-
-            // create realtive timeline according to Y
-            int samples = Y.rows();
-            ArrayXd t = 2*M_PI/m_dSampleFrequency * ArrayXd::LinSpaced(samples, 1, samples);
+            // read current data matrix Y, it ends at the read index which lags m_iReadToWriteBuffer - 1 samples behind the newest sample
+            MatrixXd Y = pRtBciFeatures->getWindow(m_iWindowSize*m_iReadSampleSize, m_iReadToWriteBuffer - 1);
 
             // Remove 50 Hz Power line signal
             if(m_bRemovePowerLine){
-                MatrixXd Zp(samples,2);
-                ArrayXd t_PL = t*m_iPowerLine;
-                Zp.col(0) = t_PL.sin();
-                Zp.col(1) = t_PL.cos();
-                MatrixXd Zp_help = Zp.transpose()*Zp;
-                Y = Y - Zp*Zp_help.inverse()*Zp.transpose()*Y;
+                pRtBciFeatures->removeFrequency(Y, m_iPowerLine);
             }
 
-            qDebug() << "size of Matrix:" << Y.rows() << Y.cols();
-
-            // apply feature extraction for all frequencies of interest
-            VectorXd ssvepProbabilities(m_lAllFrequencies.size());
-            for(int i = 0; i < m_lAllFrequencies.size(); i++)
-            {
-                // create reference signal matrix X
-                MatrixXd X(samples, 2*m_iNumberOfHarmonics);
-                for(int k = 0; k < m_iNumberOfHarmonics; k++){
-                    ArrayXd t_k = t*(k+1)*m_lAllFrequencies.at(i);
-                    X.col(2*k)      = t_k.sin();
-                    X.col(2*k+1)    = t_k.cos();
-                }
-
-                // extracting the features from the data Y with the reference signal X
-                if(m_bUseMEC){
-                    ssvepProbabilities(i) = MEC(Y, X); // using Minimum Energy Combination as feature-extraction tool
-                }
-                else{
-                    ssvepProbabilities(i) = CCA(Y, X); // using Canonical Correlation Analysis as feature-extraction tool
-                }
+            // apply feature extraction for all frequencies of interest, the reference signals are cached per window size
+            VectorXd ssvepProbabilities;
+            if(m_bUseMEC){
+                ssvepProbabilities = pRtBciFeatures->mecFeatures(Y); // using Minimum Energy Combination as feature-extraction tool
+            }
+            else{
+                ssvepProbabilities = pRtBciFeatures->ccaFeatures(Y); // using Canonical Correlation Analysis as feature-extraction tool
             }
 
             // normalize features to probabilities and transfering it into a softmax function
@@ -824,12 +744,28 @@ void SsvepBci::ssvepBciOnSensor()
             m_matSSVEPProbabilities.conservativeResize(m_lDesFrequencies.size(), m_matSSVEPProbabilities.cols() + 1);
             m_matSSVEPProbabilities.col( m_matSSVEPProbabilities.cols() - 1) = ssvepProbabilities.head(m_lDesFrequencies.size());
 
+            // report the latency from data arrival to classification
+            qint64 iLatency = m_arrivalClock.nsecsElapsed() - iArrivalTime;
+            m_iLatencySum += iLatency;
+            m_iLatencyMax = qMax(m_iLatencyMax, iLatency);
+            m_iLatencyCount++;
+            if(m_iLatencyCount == 100){
+                double dMeanLatency = m_iLatencySum / m_iLatencyCount / 1e6;
+                double dMaxLatency = m_iLatencyMax / 1e6;
+                if(m_bLatencyLogging){
+                    qDebug() << "SsvepBci::ssvepBciOnSensor - Classification latency over the last" << m_iLatencyCount << "decisions: mean" << dMeanLatency << "ms, max" << dMaxLatency << "ms";
+                }
+                emit latencyUpdated(dMeanLatency, dMaxLatency, m_iLatencyCount);
+                m_iLatencySum   = 0;
+                m_iLatencyMax   = 0;
+                m_iLatencyCount = 0;
+            }
+
         }
 
         // update counter and index variables
         m_iCounter++;
         m_iReadToWriteBuffer = m_iReadToWriteBuffer - m_iReadSampleSize;
-        m_iReadIndex = (m_iReadIndex + m_iReadSampleSize) % (m_iTimeWindowLength);
 
     }
 
@@ -51,6 +51,7 @@
 #include <scMeas/newrealtimemultisamplearray.h>
 #include <scMeas/realtimesourceestimate.h>
 #include <utils/filterTools/filterdata.h>
+#include <realtime/rtProcessing/rtbcifeatures.h>
 
 #include <fstream>
 #include <iostream>
@@ -71,6 +72,9 @@
 
 #include <QtWidgets>
 #include <QtConcurrent/QtConcurrent>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QQueue>
 
 #include "FormFiles/ssvepbciwidget.h"
 #include "FormFiles/ssvepbciconfigurationwidget.h"
@@ -234,32 +238,6 @@ protected:
     void clearClassifications();
 
 
-    //=========================================================================================================
-    /**
-    * Applying the Minimum Energy Combination approach in order to get the signal energy in Y detected by the
-    * reference signal X.
-    *
-    * @param [in]   Y           measured signal.
-    * @param [in]   X           reference signal.
-    *
-    * @return       signal energy of the reference signal in the measured signal.
-    *
-    */
-    double MEC(SCMEASLIB::MatrixXd &Y, SCMEASLIB::MatrixXd &X);
-
-    //=========================================================================================================
-    /**
-    * Applying Canoncial Correlation Analysis to get the correlation between the sets of signals of reference
-    * Signal X and the EEG Signal Y.
-    *
-    * @param [in]   Y           measured signal.
-    * @param [in]   X           reference signal.
-    *
-    * @return       maximal correlation between the signals.
-    *
-    */
-    double CCA(SCMEASLIB::MatrixXd &Y, SCMEASLIB::MatrixXd &X);
-
     //=========================================================================================================
     /**
     * The starting point for the thread. After calling start(), the newly created thread calls this function.
@@ -343,6 +321,15 @@ public slots:
     */
     void setSizeClassList(int classListSize);
 
+    //=========================================================================================================
+    /**
+    * slot for turning the printing of the classification latency to the debug output on or off. The latency is
+    * emitted via latencyUpdated() regardless of this setting.
+    *
+    * @param [in]   bEnabled     whether to print the classification latency
+    */
+    void setLatencyLogging(bool bEnabled);
+
 signals:
     //=========================================================================================================
     /**
@@ -368,15 +355,17 @@ signals:
     */
     void getFrequencyLabels(MyQList frequencyList);
 
-private:    
     //=========================================================================================================
     /**
-    * Reading actual segment from the sliding time window and write it to a data Matrix.
+    * emits the latency from data arrival to classification every 100 decisions
     *
-    * @param [out] data      data space where current data from the sliding time window will be written to.
+    * @param [in]   dMeanLatency     mean latency of the last decisions [ms]
+    * @param [in]   dMaxLatency      maximal latency of the last decisions [ms]
+    * @param [in]   iNumDecisions    number of decisions the latency was measured over
     */
-    void readFromSlidingTimeWindow(SCMEASLIB::MatrixXd &data);
+    void latencyUpdated(double dMeanLatency, double dMaxLatency, int iNumDecisions);
 
+private:    
     //=========================================================================================================
     /**
     * Updates the parameter of the classifiaction process and resets the time window. This function is called
@@ -401,7 +390,7 @@ private:
     SCSHAREDLIB::PluginInputData<SCMEASLIB::NewRealTimeMultiSampleArray>::SPtr  m_pRTMSAInput;          /**< The RealTimeMultiSampleArray input.*/
     SCSHAREDLIB::PluginInputData<SCMEASLIB::RealTimeSourceEstimate>::SPtr       m_pRTSEInput;           /**< The RealTimeSourceEstimate input.*/
 
-    IOBUFFER::CircularMatrixBuffer<double>::SPtr                  m_pBCIBuffer_Sensor;    /**< Holds incoming sensor level data.*/
+    SCMEASLIB::MeasurementFrameQueue::SPtr                        m_pBCIBuffer_Sensor;    /**< Holds the incoming sensor level frames without copying their data.*/
     IOBUFFER::CircularMatrixBuffer<double>::SPtr                  m_pBCIBuffer_Source;    /**< Holds incoming source level data.*/
 
     // processing parameter
@@ -413,21 +402,26 @@ private:
     QMutex                  m_qMutex;                           /**< QMutex to guarantee thread safety.*/
 
     // adaptable sliding time window with downsampling function
-    SCMEASLIB::MatrixXd     m_matSlidingTimeWindow;             /**< Sensor Level: adaptational sliding time window. */
+    REALTIMELIB::RtBciFeatures::SPtr m_pRtBciFeatures;          /**< Sensor Level: ring buffered sliding time window and feature extraction. */
+    QWaitCondition          m_qWaitFiffInfo;                    /**< Wakes the processing thread when the fiff information is available. */
     int                     m_iCounter;                         /**< iterative index for counting the amount of misclassifications */
     double                  m_dSampleFrequency;                 /**< sample frequency of the device [Hz] */
     int                     m_iReadSampleSize;                  /**< numbers of sample for one time segment (about 0.1 seconds) */
     int                     m_iWriteSampleSize;                 /**< numbers of sample for writing to the time window  */
     int                     m_iTimeWindowSegmentSize;           /**< needed size of the buffer for reading with an adaptable sliding window */
     int                     m_iTimeWindowLength;                /**< required length of the time window */
-    int                     m_iWriteIndex;                      /**< Index for writing a new increment from the buffer to the time window */
-    int                     m_iReadIndex;                       /**< index for reading from the time window */
     int                     m_iDownSampleIncrement;             /**< Increment for downsampling from current sample rate to 128 Hz */
     int                     m_iDownSampleIndex;                 /**< index for reading from the raw buffer in order to downsample to 128 Hz */
     int                     m_iFormerDownSampleIndex;           /**< former downsampling Index: serves as comparison variable for handling storage overflow */
     int                     m_iReadToWriteBuffer;               /**< number of samples from the current readindex to current write index */
     int                     m_iNumberOfClassBreaks;             /**< number of classifiactions whicht will be skipped if a classifiaction was made */
     int                     m_iWindowSize;                      /**< size of current time window */
+    qint64                  m_iLatencySum;                      /**< Summed latency from data arrival to classification of the current report period [ns]. */
+    qint64                  m_iLatencyMax;                      /**< Maximal latency from data arrival to classification of the current report period [ns]. */
+    int                     m_iLatencyCount;                    /**< Number of classifications in the current report period. */
+    bool                    m_bLatencyLogging;                  /**< Whether the classification latency is printed to the debug output. */
+    QElapsedTimer           m_arrivalClock;                     /**< Monotonic clock the arrival of the data blocks is stamped with. */
+    QQueue<qint64>          m_qQueueArrivalTimes;               /**< Arrival times [ns] of the blocks in m_pBCIBuffer_Sensor, in push order. */
     // SSVEP parameter
     QList<int>              m_lElectrodeNumbers;                /**< Sensor level: numbers of chosen electrode channels. */
     QList<double>           m_lDesFrequencies;                  /**< Contains desired frequencies. */
@@ -127,7 +127,6 @@ void TMSI::init()
     m_iSamplesPerBlock = 16;
     m_iTriggerInterval = 5000;
     m_iSplitFileSizeMs = 10;
-    m_iSplitCount = 0;
 
     m_bUseChExponent = true;
     m_bUseUnitGain = true;
@@ -611,45 +610,10 @@ void TMSI::setKeyboardTriggerType(int type)
 }
 
 
-//*************************************************************************************************************
-
-void TMSI::splitRecordingFile()
-{
-    qDebug() << "Split recording file";
-    ++m_iSplitCount;
-    QString nextFileName = m_sOutputFilePath.remove("_raw.fif");
-    nextFileName += QString("-%1_raw.fif").arg(m_iSplitCount);
-
-    /*
-    * Write the link to the next file
-    */
-    qint32 data;
-    m_pOutfid->start_block(FIFFB_REF);
-    data = FIFFV_ROLE_NEXT_FILE;
-    m_pOutfid->write_int(FIFF_REF_ROLE,&data);
-    m_pOutfid->write_string(FIFF_REF_FILE_NAME, nextFileName);
-    m_pOutfid->write_id(FIFF_REF_FILE_ID);//ToDo meas_id
-    data = m_iSplitCount - 1;
-    m_pOutfid->write_int(FIFF_REF_FILE_NUM, &data);
-    m_pOutfid->end_block(FIFFB_REF);
-
-    //finish file
-    m_pOutfid->finish_writing_raw();
-
-    //start next file
-    m_fileOut.setFileName(nextFileName);
-    m_pOutfid = Fiff::start_writing_raw(m_fileOut, *m_pFiffInfo, m_cals);
-    fiff_int_t first = 0;
-    m_pOutfid->write_int(FIFF_FIRST_SAMPLE, &first);
-}
-
-
 //*************************************************************************************************************
 
 void TMSI::run()
 {
-    qint32 size = 0;
-
     while(m_bIsRunning)
     {
         //std::cout<<"TMSI::run(s)"<<std::endl;
@@ -681,19 +645,13 @@ void TMSI::run()
             if(m_bUseKeyboardTrigger && m_iTriggerType!=0)
                 matValue(136, m_iSamplesPerBlock-1) = m_iTriggerType;
 
-            //Write raw data to fif file
+            //Hand raw data over to the recorder, which writes and splits the fif file on its own thread
             if(m_bWriteToFile) {
-                m_pOutfid->write_raw_buffer(matValue.cast<double>(), m_cals);
-                size += matValue.cols();
-
-//                qDebug()<<"size"<<size;
-//                qDebug()<<"(m_iSplitFileSizeMs/1000)*m_pFiffInfo->sfreq"<<(double(m_iSplitFileSizeMs)/1000.0)*m_pFiffInfo->sfreq;
-                if(size > (double(m_iSplitFileSizeMs)/1000.0)*m_pFiffInfo->sfreq && m_bSplitFile) {
-                    size = 0;
-                    splitRecordingFile();
-                }
-            } else
-                size = 0;
+                m_qMutex.lock();
+                if(m_pFiffRawRecorder)
+                    m_pFiffRawRecorder->append(matValue);
+                m_qMutex.unlock();
+            }
 
             // TODO: Use preprocessing if wanted by the user
             if(m_bUseFiltering)
@@ -736,11 +694,9 @@ void TMSI::run()
                 QElapsedTimer timer;
                 timer.start();
 
-                FFT<float> fft;
-                Matrix<complex<float>, 138, 16> freq;
-
-                for(qint32 i = 0; i < matValue.rows(); ++i)
-                    fft.fwd(freq.row(i), matValue.row(i));
+                //All channels of the block in one batch with the cached plan of this thread
+                MatrixXcf freq;
+                FFTService::fwdRows(freq, matValue, -1, false);
 
 //                cout<<"FFT postprocessing done in "<<timer.nsecsElapsed()<<" nanosec"<<endl;
 //                cout<<"matValue before FFT:"<<endl<<matValue<<endl;
@@ -779,8 +735,15 @@ void TMSI::run()
     //Close the fif output stream
     if(m_bWriteToFile)
     {
-        m_pOutfid->finish_writing_raw();
         m_bWriteToFile = false;
+
+        m_qMutex.lock();
+        FiffRawRecorder::SPtr pFiffRawRecorder = m_pFiffRawRecorder;
+        m_pFiffRawRecorder.clear();
+        m_qMutex.unlock();
+
+        if(pFiffRawRecorder)
+            pFiffRawRecorder->stopRecording();
         m_pTimerRecordingChange->stop();
         m_pActionStartRecording->setIcon(QIcon(":/images/record.png"));
     }
@@ -831,13 +794,18 @@ void TMSI::showSetupProjectDialog()
 
 void TMSI::showStartRecording()
 {
-    m_iSplitCount = 0;
-
     //Setup writing to file
     if(m_bWriteToFile)
     {
-        m_pOutfid->finish_writing_raw();
         m_bWriteToFile = false;
+
+        m_qMutex.lock();
+        FiffRawRecorder::SPtr pFiffRawRecorder = m_pFiffRawRecorder;
+        m_pFiffRawRecorder.clear();
+        m_qMutex.unlock();
+
+        if(pFiffRawRecorder)
+            pFiffRawRecorder->stopRecording();
         m_pTimerRecordingChange->stop();
         m_pActionStartRecording->setIcon(QIcon(":/images/record.png"));
     }
@@ -860,8 +828,7 @@ void TMSI::showStartRecording()
         }
 
         //Initiate the stream for writing to the fif file
-        m_fileOut.setFileName(m_sOutputFilePath);
-        if(m_fileOut.exists())
+        if(QFile::exists(m_sOutputFilePath))
         {
             QMessageBox msgBox;
             msgBox.setText("The file you want to write already exists.");
@@ -883,9 +850,20 @@ void TMSI::showStartRecording()
             dir.mkpath(fileDir);
         }
 
-        m_pOutfid = Fiff::start_writing_raw(m_fileOut, *m_pFiffInfo, m_cals);
-        fiff_int_t first = 0;
-        m_pOutfid->write_int(FIFF_FIRST_SAMPLE, &first);
+        //The split size is given in ms, the recorder splits by bytes of float data
+        FiffRawRecorder::SPtr pFiffRawRecorder(new FiffRawRecorder(*m_pFiffInfo));
+        pFiffRawRecorder->setSplitSize(m_bSplitFile ? qint64(double(m_iSplitFileSizeMs)/1000.0 * m_pFiffInfo->sfreq) * m_pFiffInfo->nchan * 4 : 0);
+        if(!pFiffRawRecorder->startRecording(m_sOutputFilePath))
+        {
+            QMessageBox msgBox;
+            msgBox.setText("Could not open the file for writing.");
+            msgBox.exec();
+            return;
+        }
+
+        m_qMutex.lock();
+        m_pFiffRawRecorder = pFiffRawRecorder;
+        m_qMutex.unlock();
 
         m_bWriteToFile = true;
 
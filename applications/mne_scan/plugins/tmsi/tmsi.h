@@ -53,8 +53,8 @@
 #include <scMeas/newrealtimemultisamplearray.h>
 
 #include <utils/layoutloader.h>
+#include <utils/fftservice.h>
 
-#include <unsupported/Eigen/FFT>
 #include <Eigen/Geometry>
 
 
@@ -80,6 +80,7 @@
 //=============================================================================================================
 
 #include <fiff/fiff.h>
+#include <fiff/fiff_raw_recorder.h>
 
 
 //*************************************************************************************************************
@@ -187,8 +188,6 @@ public:
 
     void setKeyboardTriggerType(int type);
 
-    void splitRecordingFile();
-
 protected:
     //=========================================================================================================
     /**
@@ -239,7 +238,6 @@ private:
     int                                 m_iSamplingFreq;                    /**< The sampling frequency defined by the user via the GUI (in Hertz).*/
     int                                 m_iNumberOfChannels;                /**< The number of channels defined by the user via the GUI.*/
     int                                 m_iSamplesPerBlock;                 /**< The samples per block defined by the user via the GUI.*/
-    qint32                              m_iSplitCount;                      /**< File split count */
 
     int                                 m_iTriggerInterval;                 /**< The gap between the trigger signals which request the subject to do something (in ms).*/
     QTime                               m_qTimerTrigger;                    /**< Time stemp of the last trigger event (in ms).*/
@@ -264,10 +262,8 @@ private:
     ofstream                            m_outputFileStream;                 /**< fstream for writing the samples values to txt file.*/
     QString                             m_sOutputFilePath;                  /**< Holds the path for the sample output file. Defined by the user via the GUI.*/
     QString                             m_sElcFilePath;                     /**< Holds the path for the .elc file (electrode positions). Defined by the user via the GUI.*/
-    QFile                               m_fileOut;                          /**< QFile for writing to fif file.*/
-    FiffStream::SPtr                    m_pOutfid;                          /**< QFile for writing to fif file.*/
+    FiffRawRecorder::SPtr               m_pFiffRawRecorder;                 /**< Writes the recorded data to fif files on its own thread.*/
     QSharedPointer<FiffInfo>            m_pFiffInfo;                        /**< Fiff measurement info.*/
-    RowVectorXd                         m_cals;
 
     QSharedPointer<RawMatrixBuffer>     m_pRawMatrixBuffer_In;              /**< Holds incoming raw data.*/
 
@@ -275,7 +271,7 @@ private:
 
     MatrixXf                            m_matOldMatrix;                     /**< Last received sample matrix by the tmsiproducer/tmsidriver class. Used for simple HP filtering.*/
 
-    QMutex                              m_qMutex;                           /**< Holds the threads mutex.*/
+    QMutex                              m_qMutex;                           /**< Holds the threads mutex. Also guards the recorder between the acquisition and GUI thread.*/
 
     QAction*                            m_pActionImpedance;                 /**< shows impedance widget */
     QAction*                            m_pActionSetupProject;              /**< shows setup project dialog */
@@ -337,17 +337,17 @@ void TriggerControl::update(SCMEASLIB::NewMeasurement::SPtr pMeasurement)
     QSharedPointer<NewRealTimeMultiSampleArray> pRTMSA = pMeasurement.dynamicCast<NewRealTimeMultiSampleArray>();
     if(pRTMSA)
     {
+        QList<MeasurementFrame::ConstSPtr> lFrames = m_pRTMSAInput->takeFrames(pMeasurement);
+
+        if(lFrames.isEmpty())
+            return;
+
         //Check if buffer initialized
         if(!m_pDataMatrixBuffer)
-            m_pDataMatrixBuffer = CircularMatrixBuffer<double>::SPtr(new CircularMatrixBuffer<double>(64, pRTMSA->getNumChannels(), pRTMSA->getMultiSampleArray()[0].cols()));
-
-//        MatrixXd t_mat;
+            m_pDataMatrixBuffer = MeasurementFrameQueue::SPtr(new MeasurementFrameQueue(64));
 
-//        for(qint32 i = 0; i < pRTMSA->getMultiArraySize(); ++i)
-//        {
-//            t_mat = pRTMSA->getMultiSampleArray()[i];
-//            m_pDataMatrixBuffer->push(&t_mat);
-//        }
+//        for(qint32 i = 0; i < lFrames.size(); ++i)
+//            m_pDataMatrixBuffer->push(lFrames.at(i));
 
 ////        m_qMutex.lock();
 ////        m_iNumChs = pRTMSA->getNumChannels();
@@ -386,7 +386,8 @@ void TriggerControl::run()
     {
 
 //        if(m_pDataMatrixBuffer)
-//            t_mat = m_pDataMatrixBuffer->pop();
+//            if(MeasurementFrame::ConstSPtr pFrame = m_pDataMatrixBuffer->pop())
+//                t_mat = pFrame->data();
 
 //        m_qMutex.lock();
 //        if(m_pData.size() > 2 * m_refSin.size())
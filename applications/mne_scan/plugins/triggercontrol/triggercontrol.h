@@ -47,7 +47,6 @@
 
 #include <scShared/Interfaces/IAlgorithm.h>
 #include <utils/generics/circularbuffer.h>
-#include <utils/generics/circularmatrixbuffer.h>
 #include <scMeas/newrealtimesamplearray.h>
 #include <scMeas/newrealtimemultisamplearray.h>
 
@@ -227,7 +226,7 @@ private:
 
     QMutex m_qMutex;
 
-    CircularMatrixBuffer<double>::SPtr m_pDataMatrixBuffer;   /**< Holds incoming rt server data.*/
+    MeasurementFrameQueue::SPtr m_pDataMatrixBuffer;          /**< Holds the incoming rt server frames without copying their data.*/
 
     QVector<VectorXd> m_pData;
     dBuffer::SPtr m_pDataSingleChannel;
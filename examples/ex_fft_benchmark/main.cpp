@@ -0,0 +1,205 @@
+//=============================================================================================================
+/**
+* @file     main.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     Benchmark of the FFT service against per call Eigen::FFT objects for typical transform lengths
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <utils/fftservice.h>
+
+#include <iostream>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+#include <unsupported/Eigen/FFT>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtCore/QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QStringList>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace UTILSLIB;
+using namespace Eigen;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STATIC DEFINITIONS
+//=============================================================================================================
+
+//=============================================================================================================
+/**
+* Prints the time per block and per transform of one benchmark case.
+*/
+void printResult(const QString& sName, qint64 iNSecs, int iNumBlocks, int iNumChannels)
+{
+    double dMSecsPerBlock = iNSecs / 1000000.0 / iNumBlocks;
+    std::cout << "    " << sName.toUtf8().constData() << ": " << dMSecsPerBlock << " ms per block, "
+              << dMSecsPerBlock * 1000.0 / iNumChannels << " us per transform" << std::endl;
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+//=============================================================================================================
+/**
+* The function main marks the entry point of the program.
+* By default, main has the storage class extern.
+*
+* @param [in] argc (argument count) is an integer that indicates how many arguments were entered on the command line when the program was started.
+* @param [in] argv (argument vector) is an array of pointers to arrays of character objects. The array objects are null-terminated strings, representing the arguments that were entered on the command line when the program was started.
+* @return the value that was set to exit() (which is 0 if exit() is called via quit()).
+*/
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    // Command Line Parser
+    QCommandLineParser parser;
+    parser.setApplicationDescription("FFT Benchmark Example");
+    parser.addHelpOption();
+
+    QCommandLineOption lengthsOption("lengths", "Comma separated transform <lengths>.", "lengths", "256,512,1000,1024,2048,4096,8192,16384");
+    QCommandLineOption channelsOption("channels", "Number of <channels> per block.", "channels", "306");
+    QCommandLineOption blocksOption("blocks", "Number of <blocks> transformed per case.", "blocks", "20");
+
+    parser.addOption(lengthsOption);
+    parser.addOption(channelsOption);
+    parser.addOption(blocksOption);
+
+    parser.process(a);
+
+    int iNumChannels = qMax(1, parser.value(channelsOption).toInt());
+    int iNumBlocks = qMax(1, parser.value(blocksOption).toInt());
+    QStringList lLengths = parser.value(lengthsOption).split(",", QString::SkipEmptyParts);
+
+    std::cout << "FFT backend: " << FFTService::backendName() << ", " << iNumChannels << " channels, " << iNumBlocks << " blocks" << std::endl;
+
+    QElapsedTimer timer;
+
+    for(int l = 0; l < lLengths.size(); ++l) {
+        int iNfft = lLengths.at(l).trimmed().toInt();
+        if(iNfft < 2) {
+            continue;
+        }
+
+        std::cout << std::endl << "Length " << iNfft << std::endl;
+
+        MatrixXd matData = MatrixXd::Random(iNumChannels, iNfft);
+        MatrixXcd matRef(iNumChannels, iNfft/2 + 1);
+        MatrixXcd matFreq;
+        RowVectorXd vecTime;
+        RowVectorXcd vecFreq;
+
+        //A fresh Eigen::FFT object per channel, as done by the call sites before the FFT service
+        timer.start();
+        for(int b = 0; b < iNumBlocks; ++b) {
+            for(int i = 0; i < iNumChannels; ++i) {
+                Eigen::FFT<double> fft;
+                fft.SetFlag(fft.HalfSpectrum);
+                vecTime = matData.row(i);
+                fft.fwd(vecFreq, vecTime);
+                matRef.row(i) = vecFreq;
+            }
+        }
+        printResult("Eigen::FFT per channel   ", timer.nsecsElapsed(), iNumBlocks, iNumChannels);
+
+        //One Eigen::FFT object reused for all channels and blocks
+        {
+            Eigen::FFT<double> fft;
+            fft.SetFlag(fft.HalfSpectrum);
+
+            timer.restart();
+            for(int b = 0; b < iNumBlocks; ++b) {
+                for(int i = 0; i < iNumChannels; ++i) {
+                    vecTime = matData.row(i);
+                    fft.fwd(vecFreq, vecTime);
+                }
+            }
+            printResult("Eigen::FFT reused        ", timer.nsecsElapsed(), iNumBlocks, iNumChannels);
+        }
+
+        //The FFT service with one call per channel
+        timer.restart();
+        for(int b = 0; b < iNumBlocks; ++b) {
+            for(int i = 0; i < iNumChannels; ++i) {
+                FFTService::fwd(vecFreq, matData.row(i));
+            }
+        }
+        printResult("FFTService::fwd          ", timer.nsecsElapsed(), iNumBlocks, iNumChannels);
+
+        //The FFT service with one batched call per block
+        timer.restart();
+        for(int b = 0; b < iNumBlocks; ++b) {
+            FFTService::fwdRows(matFreq, matData);
+        }
+        printResult("FFTService::fwdRows      ", timer.nsecsElapsed(), iNumBlocks, iNumChannels);
+
+        //Batched round trip, e.g., frequency domain filtering
+        MatrixXd matTime;
+        timer.restart();
+        for(int b = 0; b < iNumBlocks; ++b) {
+            FFTService::fwdRows(matFreq, matData);
+            FFTService::invRows(matTime, matFreq, iNfft);
+        }
+        printResult("FFTService fwd/invRows   ", timer.nsecsElapsed(), iNumBlocks, iNumChannels);
+
+        std::cout << "    max deviation: spectrum " << (matFreq - matRef).cwiseAbs().maxCoeff()
+                  << ", round trip " << (matTime - matData).cwiseAbs().maxCoeff() << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,252 @@
+//=============================================================================================================
+/**
+* @file     main.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     Benchmark of the fif writing throughput for raw data and forward solutions.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <fiff/fiff.h>
+#include <mne/mne.h>
+
+#include <iostream>
+#include <math.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtCore/QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QBuffer>
+#include <QFile>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FIFFLIB;
+using namespace MNELIB;
+using namespace Eigen;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STATIC DEFINITIONS
+//=============================================================================================================
+
+//=============================================================================================================
+/**
+* Writes a float tag the way FiffStream did before the bulk writers, one value at a time through QDataStream.
+*/
+void writeFloatPerValue(FiffStream& stream, fiff_int_t kind, const float* data, fiff_int_t nel)
+{
+    stream << (qint32)kind;
+    stream << (qint32)FIFFT_FLOAT;
+    stream << (qint32)(nel * 4);
+    stream << (qint32)FIFFV_NEXT_SEQ;
+
+    for(qint32 i = 0; i < nel; ++i)
+        stream << data[i];
+}
+
+
+//*************************************************************************************************************
+
+void printResult(const QString& sName, qint64 iBytes, qint64 iNSecs)
+{
+    double dMSecs = iNSecs / 1000000.0;
+    std::cout << "    " << sName.toUtf8().constData() << ": " << dMSecs << " ms, "
+              << (dMSecs > 0 ? (iBytes / 1048576.0) / (dMSecs / 1000.0) : 0.0) << " MB/s" << std::endl;
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+//=============================================================================================================
+/**
+* The function main marks the entry point of the program.
+* By default, main has the storage class extern.
+*
+* @param [in] argc (argument count) is an integer that indicates how many arguments were entered on the command line when the program was started.
+* @param [in] argv (argument vector) is an array of pointers to arrays of character objects. The array objects are null-terminated strings, representing the arguments that were entered on the command line when the program was started.
+* @return the value that was set to exit() (which is 0 if exit() is called via quit()).
+*/
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    // Command Line Parser
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Fiff Write Benchmark Example");
+    parser.addHelpOption();
+
+    QCommandLineOption rawFileOption("fileIn", "The raw input file <in>.", "in", "./MNE-sample-data/MEG/sample/sample_audvis_raw.fif");
+    QCommandLineOption fwdFileOption("fwd", "Path to the forward solution <file>.", "file", "./MNE-sample-data/MEG/sample/sample_audvis-meg-eeg-oct-6-fwd.fif");
+    QCommandLineOption outputOption("fileOut", "The output file used for the disk benchmark <out>.", "out", "./MNE-sample-data/MEG/sample/test_write_benchmark.fif");
+
+    parser.addOption(rawFileOption);
+    parser.addOption(fwdFileOption);
+    parser.addOption(outputOption);
+
+    parser.process(a);
+
+    QElapsedTimer timer;
+
+    //
+    //   Raw data: read everything first, so only the writing is timed
+    //
+    QFile t_fileRaw(parser.value(rawFileOption));
+    FiffRawData raw(t_fileRaw);
+
+    QList<MatrixXd> lData;
+    MatrixXd data, times;
+    fiff_int_t quantum = ceil(10.0f*raw.info.sfreq);
+    qint64 iRawBytes = 0;
+
+    for(fiff_int_t first = raw.first_samp; first < raw.last_samp; first += quantum) {
+        fiff_int_t last = qMin(first + quantum - 1, raw.last_samp);
+        if(!raw.read_raw_segment(data, times, first, last)) {
+            printf("error during read_raw_segment\n");
+            return -1;
+        }
+        lData.append(data);
+        iRawBytes += data.size() * 4;
+    }
+
+    std::cout << "Raw data: " << raw.info.nchan << " channels, " << raw.last_samp - raw.first_samp + 1 << " samples, "
+              << iRawBytes / 1048576.0 << " MB" << std::endl;
+
+    RowVectorXd cals;
+
+    //Per value QDataStream writing, as done before the bulk writers
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        FiffStream stream(&buffer);
+
+        timer.start();
+        for(int i = 0; i < lData.size(); ++i) {
+            MatrixXf tmp = lData[i].cast<float>();
+            writeFloatPerValue(stream, FIFF_DATA_BUFFER, tmp.data(), tmp.size());
+        }
+        printResult("per value, memory", iRawBytes, timer.nsecsElapsed());
+    }
+
+    //Bulk writers into memory (CPU bound)
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        FiffStream stream(&buffer);
+
+        timer.restart();
+        for(int i = 0; i < lData.size(); ++i) {
+            MatrixXf tmp = lData[i].cast<float>();
+            stream.write_float(FIFF_DATA_BUFFER, tmp.data(), tmp.size());
+        }
+        printResult("bulk, memory     ", iRawBytes, timer.nsecsElapsed());
+    }
+
+    //Bulk writers into a complete raw file on disk
+    {
+        QFile t_fileOut(parser.value(outputOption));
+
+        timer.restart();
+        FiffStream::SPtr outfid = FiffStream::start_writing_raw(t_fileOut, raw.info, cals);
+        for(int i = 0; i < lData.size(); ++i) {
+            outfid->write_raw_buffer(lData[i], cals);
+        }
+        outfid->finish_writing_raw();
+        printResult("bulk, disk       ", iRawBytes, timer.nsecsElapsed());
+
+        t_fileOut.remove();
+    }
+
+    lData.clear();
+
+    //
+    //   Forward solution: source spaces and gain matrix
+    //
+    QFile t_fileFwd(parser.value(fwdFileOption));
+    MNEForwardSolution fwd(t_fileFwd);
+
+    if(fwd.isEmpty()) {
+        printf("Could not read the forward solution\n");
+        return -1;
+    }
+
+    MatrixXf matGain = fwd.sol->data.cast<float>();
+    qint64 iFwdBytes = matGain.size() * 4;
+
+    std::cout << std::endl << "Forward solution: " << fwd.sol->data.rows() << " x " << fwd.sol->data.cols() << ", "
+              << iFwdBytes / 1048576.0 << " MB" << std::endl;
+
+    //Per value QDataStream writing of the gain matrix
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        FiffStream stream(&buffer);
+
+        timer.restart();
+        writeFloatPerValue(stream, FIFF_MNE_FORWARD_SOLUTION, matGain.data(), matGain.size());
+        printResult("per value, gain matrix   ", iFwdBytes, timer.nsecsElapsed());
+    }
+
+    //Bulk writers: gain matrix as named matrix and the source spaces
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        FiffStream stream(&buffer);
+
+        timer.restart();
+        stream.write_named_matrix(FIFF_MNE_FORWARD_SOLUTION, *fwd.sol);
+        printResult("bulk, gain matrix        ", iFwdBytes, timer.nsecsElapsed());
+
+        qint64 iPos = buffer.pos();
+        timer.restart();
+        fwd.src.writeToStream(&stream);
+        printResult("bulk, source spaces      ", buffer.pos() - iPos, timer.nsecsElapsed());
+    }
+
+    return 0;
+}
@@ -45,6 +45,8 @@
 #include <disp3D/engine/model/data3Dtreemodel.h>
 
 #include <fs/surfaceset.h>
+#include <fs/annotationset.h>
+#include <fs/label.h>
 
 
 //*************************************************************************************************************
@@ -54,6 +56,8 @@
 
 #include <QApplication>
 #include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
 
 
 //*************************************************************************************************************
@@ -91,10 +95,12 @@ int main(int argc, char *argv[])
     QCommandLineOption hemiOption("hemi", "Selected hemisphere <hemi>.", "hemi", "2");
     QCommandLineOption subjectOption("subject", "Selected subject <subject>.", "subject", "sample");
     QCommandLineOption subjectPathOption("subjectPath", "Selected subject path <subjectPath>.", "subjectPath", "./MNE-sample-data/subjects");
+    QCommandLineOption benchmarkOption("benchmark", "Time reading the pial, inflated and white surfaces and two annotations of the subject with and without the binary cache, print the timings and quit.");
 
     parser.addOption(hemiOption);
     parser.addOption(subjectOption);
     parser.addOption(subjectPathOption);
+    parser.addOption(benchmarkOption);
 
     parser.process(a);
 
@@ -102,6 +108,43 @@ int main(int argc, char *argv[])
     QString subject = parser.value(subjectOption);
     QString subjectPath = parser.value(subjectPathOption);
 
+    if(parser.isSet(benchmarkOption)) {
+        QString sSurfDir = QString("%1/%2/surf").arg(subjectPath).arg(subject);
+        QString sLabelDir = QString("%1/%2/label").arg(subjectPath).arg(subject);
+        QStringList lSurfs = QStringList() << "pial" << "inflated" << "white";
+        QStringList lAtlases = QStringList() << "aparc" << "aparc.a2009s";
+
+        QTemporaryDir cacheDir;
+        QElapsedTimer timer;
+
+        // 0: parse without cache, 1: parse and write the cache, 2: read the cache
+        for(int run = 0; run < 3; ++run) {
+            QString sCacheDir = run == 0 ? QString() : cacheDir.path();
+
+            timer.start();
+            for(int i = 0; i < lSurfs.size(); ++i) {
+                SurfaceSet tSurfSet(sSurfDir+"/lh."+lSurfs[i], sSurfDir+"/rh."+lSurfs[i], sCacheDir);
+            }
+            qint64 iSurfTime = timer.elapsed();
+
+            timer.start();
+            SurfaceSet tSurfSetWhite(sSurfDir+"/lh.white", sSurfDir+"/rh.white", sCacheDir);
+            QList<Label> lLabels;
+            QList<RowVector4i> lLabelRGBAs;
+            for(int i = 0; i < lAtlases.size(); ++i) {
+                AnnotationSet tAnnotSet(sLabelDir+"/lh."+lAtlases[i]+".annot", sLabelDir+"/rh."+lAtlases[i]+".annot", sCacheDir);
+                tAnnotSet.toLabels(tSurfSetWhite, lLabels, lLabelRGBAs);
+            }
+            qint64 iAnnotTime = timer.elapsed();
+
+            printf("\n%s: surfaces %lld ms, annotations incl. labels %lld ms (%d labels)\n",
+                   run == 0 ? "parse" : (run == 1 ? "parse + write cache" : "read cache"),
+                   iSurfTime, iAnnotTime, lLabels.size());
+        }
+
+        return 0;
+    }
+
     //
     // pial
     //
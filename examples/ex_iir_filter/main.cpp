@@ -0,0 +1,177 @@
+//=============================================================================================================
+/**
+* @file     main.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     Benchmark of the IIR filter against the FFT based FIR filter in latency and throughput.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <utils/filterTools/filterdata.h>
+#include <utils/filterTools/iirfilter.h>
+
+#include <iostream>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtCore/QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace UTILSLIB;
+using namespace Eigen;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+//=============================================================================================================
+/**
+* The function main marks the entry point of the program.
+* By default, main has the storage class extern.
+*
+* @param [in] argc (argument count) is an integer that indicates how many arguments were entered on the command line when the program was started.
+* @param [in] argv (argument vector) is an array of pointers to arrays of character objects. The array objects are null-terminated strings, representing the arguments that were entered on the command line when the program was started.
+* @return the value that was set to exit() (which is 0 if exit() is called via quit()).
+*/
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    // Command Line Parser
+    QCommandLineParser parser;
+    parser.setApplicationDescription("ex_iir_filter");
+    parser.addHelpOption();
+
+    QCommandLineOption channelsOption("channels", "Number of channels <n>.", "n", "306");
+    QCommandLineOption sFreqOption("sFreq", "Sampling frequency in Hz <freq>.", "freq", "1000");
+    QCommandLineOption blockOption("block", "Number of samples per block <n>.", "n", "100");
+    QCommandLineOption durationOption("duration", "Length of the simulated data in seconds <sec>.", "sec", "60");
+    QCommandLineOption highpassOption("highpass", "Lower cut off frequency in Hz <freq>.", "freq", "1");
+    QCommandLineOption lowpassOption("lowpass", "Upper cut off frequency in Hz <freq>.", "freq", "40");
+    QCommandLineOption orderIirOption("orderIir", "Order of the IIR (Butterworth) prototype <n>.", "n", "4");
+    QCommandLineOption orderFirOption("orderFir", "Number of taps of the FIR (cosine) filter <n>.", "n", "2048");
+
+    parser.addOption(channelsOption);
+    parser.addOption(sFreqOption);
+    parser.addOption(blockOption);
+    parser.addOption(durationOption);
+    parser.addOption(highpassOption);
+    parser.addOption(lowpassOption);
+    parser.addOption(orderIirOption);
+    parser.addOption(orderFirOption);
+
+    parser.process(a);
+
+    const int iNumChannels = parser.value(channelsOption).toInt();
+    const double dSFreq = parser.value(sFreqOption).toDouble();
+    const int iBlockSize = parser.value(blockOption).toInt();
+    const int iNumSamples = (parser.value(durationOption).toDouble() * dSFreq / iBlockSize) * iBlockSize;
+    const double dHighpass = parser.value(highpassOption).toDouble();
+    const double dLowpass = parser.value(lowpassOption).toDouble();
+    const int iOrderFir = parser.value(orderFirOption).toInt();
+
+    //Normalized to the Nyquist frequency as expected by FilterData
+    const double dCenterFreq = (dLowpass + dHighpass) / dSFreq;
+    const double dBandwidth = 2.0 * (dLowpass - dHighpass) / dSFreq;
+
+    int iFFTLength = 1;
+    while(iFFTLength < 2 * iOrderFir + iBlockSize) {
+        iFFTLength *= 2;
+    }
+
+    FilterData filterFir("FIR", FilterData::BPF, iOrderFir, dCenterFreq, dBandwidth, 2.0 / dSFreq, dSFreq, iFFTLength, FilterData::Cosine);
+    IirFilter filterIir("IIR", FilterData::BPF, parser.value(orderIirOption).toInt(), dCenterFreq, dBandwidth, dSFreq, IirFilter::Butterworth);
+
+    MatrixXd matData = MatrixXd::Random(iNumChannels, iNumSamples);
+    MatrixXd matBlock;
+    RowVectorXd vecFiltered;
+    QElapsedTimer timer;
+
+    std::cout << "Filtering " << iNumChannels << " channels, " << iNumSamples / dSFreq << " s at " << dSFreq << " Hz in blocks of " << iBlockSize << " samples" << std::endl;
+    std::cout << "Pass band " << dHighpass << " - " << dLowpass << " Hz" << std::endl << std::endl;
+
+    //FIR filter via overlap-add in the frequency domain, one channel at a time as done by RtFilter
+    timer.start();
+
+    for(int t = 0; t < iNumSamples; t += iBlockSize) {
+        for(int c = 0; c < iNumChannels; ++c) {
+            vecFiltered = filterFir.applyFFTFilter(matData.block(c, t, 1, iBlockSize), true, FilterData::ZeroPad);
+        }
+    }
+
+    const double dTimeFir = timer.nsecsElapsed() / 1000000.0;
+
+    //IIR filter, all channels at once with the state kept between the blocks
+    timer.restart();
+
+    for(int t = 0; t < iNumSamples; t += iBlockSize) {
+        matBlock = matData.middleCols(t, iBlockSize);
+        filterIir.filterBlock(matBlock);
+    }
+
+    const double dTimeIir = timer.nsecsElapsed() / 1000000.0;
+
+    //Offline zero-phase IIR filtering of the whole data
+    timer.restart();
+    MatrixXd matZeroPhase = filterIir.applyZeroPhaseFilter(matData);
+    const double dTimeZeroPhase = timer.nsecsElapsed() / 1000000.0;
+
+    const double dDataTime = 1000.0 * iNumSamples / dSFreq;
+    const double dCenter = std::sqrt(dHighpass * dLowpass);
+
+    std::cout << "FIR (" << iOrderFir << " taps, FFT length " << iFFTLength << ")" << std::endl;
+    std::cout << "    group delay:          " << 1000.0 * (iOrderFir / 2) / dSFreq << " ms" << std::endl;
+    std::cout << "    processing time:      " << dTimeFir << " ms (" << dTimeFir / dDataTime * 100.0 << " % of real time)" << std::endl;
+    std::cout << "IIR (" << filterIir.m_matSos.rows() << " second-order sections)" << std::endl;
+    std::cout << "    group delay @ " << dCenter << " Hz: " << 1000.0 * filterIir.getGroupDelay(dCenter) / dSFreq << " ms" << std::endl;
+    std::cout << "    group delay @ " << dHighpass << " Hz: " << 1000.0 * filterIir.getGroupDelay(dHighpass) / dSFreq << " ms" << std::endl;
+    std::cout << "    processing time:      " << dTimeIir << " ms (" << dTimeIir / dDataTime * 100.0 << " % of real time)" << std::endl;
+    std::cout << "IIR zero-phase (offline)" << std::endl;
+    std::cout << "    processing time:      " << dTimeZeroPhase << " ms" << std::endl;
+
+    return 0;
+}
@@ -69,6 +69,7 @@
 
 #include <QApplication>
 #include <QCommandLineParser>
+#include <QElapsedTimer>
 
 
 //*************************************************************************************************************
@@ -115,6 +116,7 @@ int main(int argc, char *argv[])
     QCommandLineOption annotOption("annotType", "Annotation type <type>.", "type", "aparc.a2009s");
     QCommandLineOption numDipolePairsOption("numDip", "<number> of dipole pairs to localize.", "number", "1");
     QCommandLineOption surfOption("surfType", "Surface type <type>.", "type", "orig");
+    QCommandLineOption benchmarkOption("benchmark", "Compare the pair scan with the per pair SVD scan, print the timings and quit.");
 
     parser.addOption(fwdFileOption);
     parser.addOption(evokedFileOption);
@@ -124,6 +126,7 @@ int main(int argc, char *argv[])
     parser.addOption(annotOption);
     parser.addOption(numDipolePairsOption);
     parser.addOption(surfOption);
+    parser.addOption(benchmarkOption);
     parser.process(a);
 
     //Load data
@@ -174,6 +177,33 @@ int main(int argc, char *argv[])
 
     RapMusic t_rapMusic(t_clusteredFwd, false, numDipolePairs);
 
+    if(parser.isSet(benchmarkOption)) {
+        QElapsedTimer timer;
+        QList< DipolePair<double> > dipolesPairScan, dipolesSvd;
+
+        t_rapMusic.setUsePairScan(true);
+        timer.start();
+        t_rapMusic.calculateInverse(pickedEvoked.data, dipolesPairScan);
+        qint64 iTimePairScan = timer.elapsed();
+
+        t_rapMusic.setUsePairScan(false);
+        timer.restart();
+        t_rapMusic.calculateInverse(pickedEvoked.data, dipolesSvd);
+        qint64 iTimeSvd = timer.elapsed();
+
+        std::cout << "Sources: " << t_clusteredFwd.nsource << std::endl;
+        std::cout << "Pair scan: " << iTimePairScan << " ms" << std::endl;
+        std::cout << "Per pair SVD: " << iTimeSvd << " ms" << std::endl;
+
+        for(int i = 0; i < std::min(dipolesPairScan.size(), dipolesSvd.size()); ++i) {
+            std::cout << "Pair " << i+1 << ": "
+                      << dipolesPairScan[i].m_iIdx1 << " - " << dipolesPairScan[i].m_iIdx2 << " (" << dipolesPairScan[i].m_vCorrelation << ") vs. "
+                      << dipolesSvd[i].m_iIdx1 << " - " << dipolesSvd[i].m_iIdx2 << " (" << dipolesSvd[i].m_vCorrelation << ")" << std::endl;
+        }
+
+        return 0;
+    }
+
     int iWinSize = 200;
     if(doMovie) {
         t_rapMusic.setStcAttr(iWinSize, 0.6);
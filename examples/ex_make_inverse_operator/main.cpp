@@ -42,6 +42,7 @@
 #include <fiff/fiff_cov.h>
 #include <fiff/fiff_evoked.h>
 #include <mne/mne_sourceestimate.h>
+#include <mne/mne_inverse_operator_builder.h>
 #include <inverse/minimumNorm/minimumnorm.h>
 
 
@@ -60,6 +61,7 @@
 //=============================================================================================================
 
 #include <QtCore/QCoreApplication>
+#include <QElapsedTimer>
 
 
 //*************************************************************************************************************
@@ -100,6 +102,7 @@ int main(int argc, char *argv[])
     QCommandLineOption evokedFileOption("ave", "Path to the evoked/average <file>.", "file", "./MNE-sample-data/MEG/sample/sample_audvis-ave.fif");
     QCommandLineOption methodOption("method", "Inverse estimation <method>, i.e., 'MNE', 'dSPM' or 'sLORETA'.", "method", "dSPM");
     QCommandLineOption snrOption("snr", "The SNR value used for computation <snr>.", "snr", "3.0");//3.0;//0.1;//3.0;
+    QCommandLineOption benchmarkOption("benchmark", "Time making and preparing the MEG inverse operator with and without the cached builder, print the timings and quit.");
 
     parser.addOption(fwdMEGOption);
     parser.addOption(fwdEEGOption);
@@ -107,6 +110,7 @@ int main(int argc, char *argv[])
     parser.addOption(evokedFileOption);
     parser.addOption(methodOption);
     parser.addOption(snrOption);
+    parser.addOption(benchmarkOption);
 
     parser.process(a);
 
@@ -141,6 +145,49 @@ int main(int argc, char *argv[])
     // make an M/EEG, MEG-only, and EEG-only inverse operators
     FiffInfo info = evoked.info;
 
+    if(parser.isSet(benchmarkOption)) {
+        QElapsedTimer timer;
+        qint32 nave = evoked.nave;
+
+        // A second covariance update, as delivered by a real-time covariance estimation
+        FiffCov noise_cov_update = noise_cov;
+        noise_cov_update.data *= 1.1;
+
+        timer.start();
+        MNEInverseOperator::make_inverse_operator(info, t_forwardMeg, noise_cov, 0.2f, 0.8f);
+        MNEInverseOperator inverse_operator_meg = MNEInverseOperator::make_inverse_operator(info, t_forwardMeg, noise_cov_update, 0.2f, 0.8f);
+        qint64 iTimeMake = timer.elapsed();
+
+        MNEInverseOperatorBuilder builder(info, t_forwardMeg, 0.2f, 0.8f);
+        timer.restart();
+        builder.makeInverseOperator(noise_cov);
+        builder.makeInverseOperator(noise_cov_update);
+        qint64 iTimeMakeBuilder = timer.elapsed();
+
+        // Regularization sweep with both noise normalizations
+        QList<float> lambdas;
+        lambdas << 1.0f << 1.0f/4.0f << 1.0f/9.0f << 1.0f/16.0f << 1.0f/25.0f;
+
+        timer.restart();
+        for(int i = 0; i < lambdas.size(); ++i) {
+            inverse_operator_meg.prepare_inverse_operator(nave, lambdas[i], true, false);
+            inverse_operator_meg.prepare_inverse_operator(nave, lambdas[i], false, true);
+        }
+        qint64 iTimePrepare = timer.elapsed();
+
+        timer.restart();
+        for(int i = 0; i < lambdas.size(); ++i) {
+            builder.prepareInverseOperator(nave, lambdas[i], true, false);
+            builder.prepareInverseOperator(nave, lambdas[i], false, true);
+        }
+        qint64 iTimePrepareBuilder = timer.elapsed();
+
+        std::cout << "Make, two covariances: " << iTimeMake << " ms, cached builder: " << iTimeMakeBuilder << " ms" << std::endl;
+        std::cout << "Prepare, " << 2*lambdas.size() << " calls: " << iTimePrepare << " ms, cached builder: " << iTimePrepareBuilder << " ms" << std::endl;
+
+        return 0;
+    }
+
     MNEInverseOperator inverse_operator_meeg(info, t_forwardMeeg, noise_cov, 0.2f, 0.8f);
     MNEInverseOperator inverse_operator_meg(info, t_forwardMeg, noise_cov, 0.2f, 0.8f);
     MNEInverseOperator inverse_operator_eeg(info, t_forwardEeg, noise_cov, 0.2f, 0.8f);
@@ -43,7 +43,10 @@ SUBDIRS += \
     ex_cancel_noise \
     ex_evoked_grad_amp \
     ex_fiff_io \
+    ex_fiff_write_benchmark \
+    ex_fft_benchmark \
     ex_find_evoked \
+    ex_iir_filter \
     ex_inverse_mne \
     ex_make_inverse_operator \
     ex_make_layout \
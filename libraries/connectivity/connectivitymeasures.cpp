@@ -44,6 +44,8 @@
 #include "network/networkedge.h"
 #include "network/network.h"
 
+#include <utils/fftservice.h>
+
 #include <iostream>
 
 
@@ -55,14 +57,6 @@
 #include <QDebug>
 
 
-//*************************************************************************************************************
-//=============================================================================================================
-// Eigen INCLUDES
-//=============================================================================================================
-
-#include <unsupported/Eigen/FFT>
-
-
 //*************************************************************************************************************
 //=============================================================================================================
 // USED NAMESPACES
@@ -70,6 +64,7 @@
 
 using namespace CONNECTIVITYLIB;
 using namespace Eigen;
+using namespace UTILSLIB;
 
 
 //*************************************************************************************************************
@@ -181,8 +176,6 @@ double ConnectivityMeasures::calcPearsonsCorrelationCoeff(const Eigen::RowVector
 
 QPair<int,double> ConnectivityMeasures::calcCrossCorrelation(const RowVectorXd& vecFirst, const RowVectorXd& vecSecond)
 {
-    Eigen::FFT<double> fft;
-
     int N = std::max(vecFirst.cols(), vecSecond.cols());
 
     //Compute the FFT size as the "next power of 2" of the input vector's length (max)
@@ -202,8 +195,8 @@ QPair<int,double> ConnectivityMeasures::calcCrossCorrelation(const RowVectorXd&
     RowVectorXcd freqvec;
     RowVectorXcd freqvec2;
 
-    fft.fwd(freqvec, xCorrInputVecFirst);
-    fft.fwd(freqvec2, xCorrInputVecSecond);
+    FFTService::fwd(freqvec, xCorrInputVecFirst, false);
+    FFTService::fwd(freqvec2, xCorrInputVecSecond, false);
 
     //Create conjugate complex
     freqvec2.conjugate();
@@ -214,7 +207,7 @@ QPair<int,double> ConnectivityMeasures::calcCrossCorrelation(const RowVectorXd&
     }
 
     RowVectorXd result;
-    fft.inv(result, freqvec);
+    FFTService::inv(result, freqvec, fftsize);
 
     //Will get rid of extra zero padding
     RowVectorXd result2 = result;//.segment(maxlag, N);
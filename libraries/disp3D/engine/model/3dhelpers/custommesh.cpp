@@ -48,6 +48,9 @@
 
 #include <QSharedPointer>
 #include <QVector3D>
+#include <QVector>
+#include <QPair>
+#include <QHash>
 
 #include <Qt3DRender/QGeometry>
 #include <Qt3DRender/QAttribute>
@@ -59,6 +62,19 @@
 // Eigen INCLUDES
 //=============================================================================================================
 
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <limits>
+
 
 //*************************************************************************************************************
 //=============================================================================================================
@@ -69,6 +85,127 @@ using namespace DISP3DLIB;
 using namespace Eigen;
 
 
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINES
+//=============================================================================================================
+
+#define CUSTOMMESH_UPDATE_MAX_GAP       32      /**< Changed ranges which are separated by less unchanged elements are uploaded as one range. */
+#define CUSTOMMESH_UPDATE_MAX_RANGES    64      /**< Maximum number of partial uploads per update. Above the whole buffer is uploaded. */
+#define CUSTOMMESH_UPDATE_MAX_RATIO     0.5     /**< Maximum ratio of changed elements for partial uploads. Above the whole buffer is uploaded. */
+
+#define CUSTOMMESH_LOD_NUM_LEVELS       3       /**< Number of levels of detail including the full resolution. */
+#define CUSTOMMESH_LOD_MIN_VERTICES     10000   /**< Meshes with less vertices are always rendered in full resolution. */
+#define CUSTOMMESH_LOD_DISTANCE_RATIO   4.0f    /**< Camera distance in units of the bounding radius at which the first decimated level is used. Doubles with every level. */
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE GLOBAL METHODS
+//=============================================================================================================
+
+namespace {
+
+//=========================================================================================================
+/**
+* Decimates a triangle mesh by vertex clustering on a regular grid. All vertices falling into the same grid cell
+* are merged into their mean, triangles which collapse are dropped.
+*
+* @param[in] matVert        The vertices.
+* @param[in] matNorm        The normals.
+* @param[in] matTris        The triangles.
+* @param[in] fCellSize      The edge length of the grid cells.
+* @param[out] lod           The decimated mesh.
+*/
+void decimateMesh(const MatrixX3f& matVert,
+                  const MatrixX3f& matNorm,
+                  const MatrixXi& matTris,
+                  float fCellSize,
+                  MeshLevelOfDetail& lod)
+{
+    const int iNumVert = matVert.rows();
+    const RowVector3f vecMin = matVert.colwise().minCoeff();
+    const RowVector3f vecExtent = matVert.colwise().maxCoeff() - vecMin;
+    const qint64 iNumY = (qint64)(vecExtent(1) / fCellSize) + 1;
+    const qint64 iNumZ = (qint64)(vecExtent(2) / fCellSize) + 1;
+
+    //Assign every vertex to its grid cell
+    QHash<qint64, int> hashCells;
+    hashCells.reserve(iNumVert / 2);
+
+    VectorXi vecCluster(iNumVert);
+    MatrixX3f matSumVert = MatrixX3f::Zero(iNumVert, 3);
+    MatrixX3f matSumNorm = MatrixX3f::Zero(iNumVert, 3);
+    VectorXi vecCount = VectorXi::Zero(iNumVert);
+    int iNumClusters = 0;
+
+    for(int i = 0; i < iNumVert; ++i) {
+        const qint64 iX = (qint64)((matVert(i,0) - vecMin(0)) / fCellSize);
+        const qint64 iY = (qint64)((matVert(i,1) - vecMin(1)) / fCellSize);
+        const qint64 iZ = (qint64)((matVert(i,2) - vecMin(2)) / fCellSize);
+        const qint64 iKey = (iX * iNumY + iY) * iNumZ + iZ;
+
+        QHash<qint64, int>::const_iterator it = hashCells.constFind(iKey);
+        int iCluster;
+
+        if(it == hashCells.constEnd()) {
+            iCluster = iNumClusters++;
+            hashCells.insert(iKey, iCluster);
+        } else {
+            iCluster = it.value();
+        }
+
+        vecCluster(i) = iCluster;
+        matSumVert.row(iCluster) += matVert.row(i);
+        matSumNorm.row(iCluster) += matNorm.row(i);
+        vecCount(iCluster)++;
+    }
+
+    //Merge the clusters
+    lod.matVert.resize(iNumClusters, 3);
+    lod.matNorm.resize(iNumClusters, 3);
+
+    for(int i = 0; i < iNumClusters; ++i) {
+        lod.matVert.row(i) = matSumVert.row(i) / (float)vecCount(i);
+
+        const float fNorm = matSumNorm.row(i).norm();
+        lod.matNorm.row(i) = fNorm > 0.0f ? RowVector3f(matSumNorm.row(i) / fNorm) : RowVector3f(matNorm.row(0));
+    }
+
+    //Each merged vertex takes the color of the original vertex closest to it
+    lod.vecVertIdx.resize(iNumClusters);
+    VectorXf vecMinDist = VectorXf::Constant(iNumClusters, std::numeric_limits<float>::max());
+
+    for(int i = 0; i < iNumVert; ++i) {
+        const int iCluster = vecCluster(i);
+        const float fDist = (matVert.row(i) - lod.matVert.row(iCluster)).squaredNorm();
+
+        if(fDist < vecMinDist(iCluster)) {
+            vecMinDist(iCluster) = fDist;
+            lod.vecVertIdx(iCluster) = i;
+        }
+    }
+
+    //Remap the triangles and drop the collapsed ones
+    lod.matTris.resize(matTris.rows(), 3);
+    int iNumTris = 0;
+
+    for(int i = 0; i < matTris.rows(); ++i) {
+        const int iA = vecCluster(matTris(i,0));
+        const int iB = vecCluster(matTris(i,1));
+        const int iC = vecCluster(matTris(i,2));
+
+        if(iA != iB && iB != iC && iA != iC) {
+            lod.matTris.row(iNumTris++) << iA, iB, iC;
+        }
+    }
+
+    lod.matTris.conservativeResize(iNumTris, 3);
+}
+
+} // namespace
+
+
 //*************************************************************************************************************
 //=============================================================================================================
 // DEFINE MEMBER METHODS
@@ -76,6 +213,12 @@ using namespace Eigen;
 
 CustomMesh::CustomMesh()
 : Qt3DRender::QGeometryRenderer()
+, m_iVertexFront(0)
+, m_iNormalFront(0)
+, m_iColorFront(0)
+, m_iIndexFront(0)
+, m_iLevelOfDetail(0)
+, m_fBoundingRadius(0.0f)
 , m_iNumVert(0)
 {
     init();
@@ -90,6 +233,12 @@ CustomMesh::CustomMesh(const MatrixX3f& tMatVert,
                        const MatrixX3f& tMatColors,
                        Qt3DRender::QGeometryRenderer::PrimitiveType primitiveType)
 : Qt3DRender::QGeometryRenderer()
+, m_iVertexFront(0)
+, m_iNormalFront(0)
+, m_iColorFront(0)
+, m_iIndexFront(0)
+, m_iLevelOfDetail(0)
+, m_fBoundingRadius(0.0f)
 , m_iNumVert(tMatVert.rows())
 {
     init();
@@ -139,12 +288,13 @@ void CustomMesh::init()
     m_pNormalAttribute->setName(Qt3DRender::QAttribute::defaultNormalAttributeName());
     m_pNormalAttribute->setBuffer(m_pNormalDataBuffer);
 
+    //Colors are stored as 8-bit RGBA. Qt3D uploads them normalized, so the shaders still receive values in [0,1].
     m_pColorAttribute = new Qt3DRender::QAttribute();
     m_pColorAttribute->setAttributeType(Qt3DRender::QAttribute::VertexAttribute);
-    m_pColorAttribute->setDataType(Qt3DRender::QAttribute::Float);
-    m_pColorAttribute->setDataSize(3);
+    m_pColorAttribute->setDataType(Qt3DRender::QAttribute::UnsignedByte);
+    m_pColorAttribute->setDataSize(4);
     m_pColorAttribute->setByteOffset(0);
-    m_pColorAttribute->setByteStride(3 * sizeof(float));
+    m_pColorAttribute->setByteStride(4 * sizeof(uchar));
     m_pColorAttribute->setName(Qt3DRender::QAttribute::defaultColorAttributeName());
     m_pColorAttribute->setBuffer(m_pColorDataBuffer);
 
@@ -175,23 +325,95 @@ CustomMesh::~CustomMesh()
 
 void CustomMesh::setColor(const Eigen::MatrixX3f& tMatColors)
 {
-    QByteArray colorBufferData;
-    colorBufferData.resize(tMatColors.rows() * 3 * (int)sizeof(float));
-    float *rawColorArray = reinterpret_cast<float *>(colorBufferData.data());
+    if(m_iLevelOfDetail == 0) {
+        //Pack into the back buffer, which is not referenced by the Qt3D buffer anymore
+        colorsToRGBA8(tMatColors, m_arrayColorData[1 - m_iColorFront]);
+        uploadColorBuffer();
+    } else {
+        colorsToRGBA8(tMatColors, m_arrayColorFullRes);
+        uploadColor();
+    }
+}
 
-    int idxColor = 0;
 
-    for(int i = 0; i < tMatColors.rows(); ++i) {
-        rawColorArray[idxColor++] = tMatColors(i,0);
-        rawColorArray[idxColor++] = tMatColors(i,1);
-        rawColorArray[idxColor++] = tMatColors(i,2);
+//*************************************************************************************************************
+
+void CustomMesh::setColor(const QByteArray& arrayColorsRGBA8)
+{
+    if(m_iLevelOfDetail == 0) {
+        copyBytes(arrayColorsRGBA8, m_arrayColorData[1 - m_iColorFront]);
+        uploadColorBuffer();
+    } else {
+        copyBytes(arrayColorsRGBA8, m_arrayColorFullRes);
+        uploadColor();
+    }
+}
+
+
+//*************************************************************************************************************
+
+void CustomMesh::uploadColor()
+{
+    if(m_iLevelOfDetail == 0) {
+        return;
     }
 
-    //Update color
-    m_pColorDataBuffer->setData(colorBufferData);
+    //Gather the colors of the vertices representing the decimated ones
+    QByteArray& arrayColorData = m_arrayColorData[1 - m_iColorFront];
+    const VectorXi& vecVertIdx = m_lLevelsOfDetail.at(m_iLevelOfDetail - 1).vecVertIdx;
+    const int iNumColors = m_arrayColorFullRes.size() / 4;
+
+    arrayColorData.resize(vecVertIdx.rows() * 4 * (int)sizeof(uchar));
+
+    const quint32* pSrc = reinterpret_cast<const quint32*>(m_arrayColorFullRes.constData());
+    quint32* pDst = reinterpret_cast<quint32*>(arrayColorData.data());
+
+    for(int i = 0; i < vecVertIdx.rows(); ++i) {
+        pDst[i] = vecVertIdx(i) < iNumColors ? pSrc[vecVertIdx(i)] : 0xFFFFFFFF;
+    }
+
+    uploadColorBuffer();
+}
+
+
+//*************************************************************************************************************
+
+void CustomMesh::uploadColorBuffer()
+{
+    uploadBufferData(m_pColorDataBuffer, m_arrayColorData, m_iColorFront, 4 * (int)sizeof(uchar));
 
     m_pColorAttribute->setBuffer(m_pColorDataBuffer);
-    m_pColorAttribute->setCount(tMatColors.rows());
+    m_pColorAttribute->setCount(m_arrayColorData[m_iColorFront].size() / 4);
+}
+
+
+//*************************************************************************************************************
+
+void CustomMesh::copyBytes(const QByteArray& arraySource, QByteArray& arrayTarget)
+{
+    arrayTarget.resize(arraySource.size());
+
+    if(arraySource.size() > 0) {
+        std::memcpy(arrayTarget.data(), arraySource.constData(), arraySource.size());
+    }
+}
+
+
+//*************************************************************************************************************
+
+void CustomMesh::colorsToRGBA8(const Eigen::MatrixX3f& tMatColors, QByteArray& arrayColorsRGBA8)
+{
+    arrayColorsRGBA8.resize(tMatColors.rows() * 4 * (int)sizeof(uchar));
+    uchar *rawColorArray = reinterpret_cast<uchar *>(arrayColorsRGBA8.data());
+
+    int idxColor = 0;
+
+    for(int i = 0; i < tMatColors.rows(); ++i) {
+        rawColorArray[idxColor++] = (uchar)(qBound(0.0f, tMatColors(i,0), 1.0f) * 255.0f + 0.5f);
+        rawColorArray[idxColor++] = (uchar)(qBound(0.0f, tMatColors(i,1), 1.0f) * 255.0f + 0.5f);
+        rawColorArray[idxColor++] = (uchar)(qBound(0.0f, tMatColors(i,2), 1.0f) * 255.0f + 0.5f);
+        rawColorArray[idxColor++] = 255;
+    }
 }
 
 
@@ -199,19 +421,13 @@ void CustomMesh::setColor(const Eigen::MatrixX3f& tMatColors)
 
 void CustomMesh::setNormals(const Eigen::MatrixX3f& tMatNorm)
 {
-    QByteArray normalBufferData;
+    QByteArray& normalBufferData = m_arrayNormalData[1 - m_iNormalFront];
     normalBufferData.resize(tMatNorm.rows() * 3 * (int)sizeof(float));
-    float *rawNormalArray = reinterpret_cast<float *>(normalBufferData.data());
-
-    int idxNorm = 0;
-    for(int i = 0; i < tMatNorm.rows(); ++i) {
-        //Normal
-        rawNormalArray[idxNorm++] = tMatNorm(i,0);
-        rawNormalArray[idxNorm++] = tMatNorm(i,1);
-        rawNormalArray[idxNorm++] = tMatNorm(i,2);
-    }
 
-    m_pNormalDataBuffer->setData(normalBufferData);
+    //Interleave x,y,z per normal
+    Map<Matrix<float, Dynamic, 3, RowMajor> >(reinterpret_cast<float *>(normalBufferData.data()), tMatNorm.rows(), 3) = tMatNorm;
+
+    uploadBufferData(m_pNormalDataBuffer, m_arrayNormalData, m_iNormalFront, 3 * (int)sizeof(float));
 
     m_pNormalAttribute->setBuffer(m_pNormalDataBuffer);
     m_pNormalAttribute->setCount(tMatNorm.rows());
@@ -222,18 +438,13 @@ void CustomMesh::setNormals(const Eigen::MatrixX3f& tMatNorm)
 
 void CustomMesh::setVertex(const Eigen::MatrixX3f& tMatVert)
 {
-    QByteArray vertexBufferData;
+    QByteArray& vertexBufferData = m_arrayVertexData[1 - m_iVertexFront];
     vertexBufferData.resize(tMatVert.rows() * 3 * (int)sizeof(float));
-    float *rawVertexArray = reinterpret_cast<float *>(vertexBufferData.data());
 
-    int idxVert = 0;
-    for(int i = 0; i < tMatVert.rows(); ++i) {
-        rawVertexArray[idxVert++] = (tMatVert(i,0));
-        rawVertexArray[idxVert++] = (tMatVert(i,1));
-        rawVertexArray[idxVert++] = (tMatVert(i,2));
-    }
+    //Interleave x,y,z per vertex
+    Map<Matrix<float, Dynamic, 3, RowMajor> >(reinterpret_cast<float *>(vertexBufferData.data()), tMatVert.rows(), 3) = tMatVert;
 
-    m_pVertexDataBuffer->setData(vertexBufferData);
+    uploadBufferData(m_pVertexDataBuffer, m_arrayVertexData, m_iVertexFront, 3 * (int)sizeof(float));
 
     m_pVertexAttribute->setBuffer(m_pVertexDataBuffer);
     m_pVertexAttribute->setCount(tMatVert.rows());
@@ -244,19 +455,13 @@ void CustomMesh::setVertex(const Eigen::MatrixX3f& tMatVert)
 
 void CustomMesh::setIndex(const Eigen::MatrixXi& tMatTris)
 {
-    QByteArray indexBufferData;
+    QByteArray& indexBufferData = m_arrayIndexData[1 - m_iIndexFront];
     indexBufferData.resize(tMatTris.rows() * tMatTris.cols() * (int)sizeof(uint));
-    uint *rawIndexArray = reinterpret_cast<uint *>(indexBufferData.data());
-    int idxTris = 0;
 
-    for(int i = 0; i < tMatTris.rows(); ++i) {
-        //patches/tris/lines
-        for(int f = 0; f < tMatTris.cols(); ++f) {
-            rawIndexArray[idxTris++] = tMatTris(i,f);
-        }
-    }
+    //patches/tris/lines
+    Map<Matrix<uint, Dynamic, Dynamic, RowMajor> >(reinterpret_cast<uint *>(indexBufferData.data()), tMatTris.rows(), tMatTris.cols()) = tMatTris.cast<uint>();
 
-    m_pIndexDataBuffer->setData(indexBufferData);
+    uploadBufferData(m_pIndexDataBuffer, m_arrayIndexData, m_iIndexFront, qMax(1, (int)tMatTris.cols()) * (int)sizeof(uint));
 
     m_pIndexAttribute->setBuffer(m_pIndexDataBuffer);
     m_pIndexAttribute->setByteStride(tMatTris.cols() * sizeof(uint));
@@ -269,6 +474,67 @@ void CustomMesh::setIndex(const Eigen::MatrixXi& tMatTris)
 }
 
 
+//*************************************************************************************************************
+
+void CustomMesh::uploadBufferData(Qt3DRender::QBuffer* pBuffer,
+                                  QByteArray arrayData[2],
+                                  int& iFront,
+                                  int iElementSize)
+{
+    const QByteArray& arrayFront = arrayData[iFront];
+    const QByteArray& arrayBack = arrayData[1 - iFront];
+
+    if(arrayFront.size() != arrayBack.size() || iElementSize % (int)sizeof(quint32) != 0) {
+        pBuffer->setData(arrayBack);
+    } else {
+        //Collect the element ranges which changed. Ranges which lie close together are merged to keep the number of updates low.
+        const quint32* pFront = reinterpret_cast<const quint32*>(arrayFront.constData());
+        const quint32* pBack = reinterpret_cast<const quint32*>(arrayBack.constData());
+        const int iWords = iElementSize / (int)sizeof(quint32);
+        const int iNumElements = arrayBack.size() / iElementSize;
+
+        QVector<QPair<int,int> > lRanges;
+        int iNumChanged = 0;
+        int iStart = -1;
+        int iLast = -1;
+
+        for(int i = 0; i < iNumElements && lRanges.size() <= CUSTOMMESH_UPDATE_MAX_RANGES; ++i) {
+            if(std::equal(pBack + i * iWords, pBack + (i + 1) * iWords, pFront + i * iWords)) {
+                continue;
+            }
+
+            if(iStart < 0) {
+                iStart = i;
+            } else if(i - iLast > CUSTOMMESH_UPDATE_MAX_GAP) {
+                lRanges.append(qMakePair(iStart, iLast + 1));
+                iNumChanged += iLast + 1 - iStart;
+                iStart = i;
+            }
+
+            iLast = i;
+        }
+
+        if(iStart >= 0) {
+            lRanges.append(qMakePair(iStart, iLast + 1));
+            iNumChanged += iLast + 1 - iStart;
+        }
+
+        if(lRanges.size() > CUSTOMMESH_UPDATE_MAX_RANGES || iNumChanged > iNumElements * CUSTOMMESH_UPDATE_MAX_RATIO) {
+            pBuffer->setData(arrayBack);
+        } else {
+            for(int i = 0; i < lRanges.size(); ++i) {
+                const int iOffset = lRanges.at(i).first * iElementSize;
+                const int iSize = (lRanges.at(i).second - lRanges.at(i).first) * iElementSize;
+
+                pBuffer->updateData(iOffset, arrayBack.mid(iOffset, iSize));
+            }
+        }
+    }
+
+    iFront = 1 - iFront;
+}
+
+
 //*************************************************************************************************************
 
 void CustomMesh::setMeshData(const MatrixX3f& tMatVert,
@@ -279,6 +545,21 @@ void CustomMesh::setMeshData(const MatrixX3f& tMatVert,
 {
     m_iNumVert = tMatVert.rows();
 
+    //Keep the full resolution data to create and switch back from the decimated levels
+    m_matVert = tMatVert;
+    m_matNorm = tMatNorm;
+    m_matTris = tMatTris;
+    m_lLevelsOfDetail.clear();
+    m_iLevelOfDetail = 0;
+
+    m_fBoundingRadius = 0.0f;
+    m_vecBoundingCenter = QVector3D();
+    if(tMatVert.rows() > 0) {
+        const RowVector3f vecCenter = tMatVert.colwise().mean();
+        m_fBoundingRadius = std::sqrt((tMatVert.rowwise() - vecCenter).rowwise().squaredNorm().maxCoeff());
+        m_vecBoundingCenter = QVector3D(vecCenter(0), vecCenter(1), vecCenter(2));
+    }
+
     setVertex(tMatVert);
     setNormals(tMatNorm);
     setIndex(tMatTris);
@@ -291,3 +572,126 @@ void CustomMesh::setMeshData(const MatrixX3f& tMatVert,
     ////    //this->setFirstVertex(0);
     ////    this->setFirstInstance(0);
 }
+
+
+//*************************************************************************************************************
+
+void CustomMesh::setLevelOfDetail(int iLevel)
+{
+    if(m_matTris.cols() != 3
+       || m_matVert.rows() < CUSTOMMESH_LOD_MIN_VERTICES
+       || m_matNorm.rows() != m_matVert.rows()) {
+        iLevel = 0;
+    }
+
+    iLevel = qBound(0, iLevel, CUSTOMMESH_LOD_NUM_LEVELS - 1);
+
+    if(iLevel == m_iLevelOfDetail) {
+        return;
+    }
+
+    if(iLevel > 0 && m_lLevelsOfDetail.isEmpty()) {
+        createLevelsOfDetail();
+
+        if(m_lLevelsOfDetail.isEmpty()) {
+            return;
+        }
+    }
+
+    //Keep the full resolution colors only while a decimated level is shown. At full resolution they are in the front buffer.
+    if(m_iLevelOfDetail == 0) {
+        copyBytes(m_arrayColorData[m_iColorFront], m_arrayColorFullRes);
+    }
+
+    m_iLevelOfDetail = iLevel;
+
+    if(iLevel == 0) {
+        setVertex(m_matVert);
+        setNormals(m_matNorm);
+        setIndex(m_matTris);
+
+        copyBytes(m_arrayColorFullRes, m_arrayColorData[1 - m_iColorFront]);
+        m_arrayColorFullRes.clear();
+        m_arrayColorFullRes.squeeze();
+        uploadColorBuffer();
+    } else {
+        const MeshLevelOfDetail& lod = m_lLevelsOfDetail.at(iLevel - 1);
+        setVertex(lod.matVert);
+        setNormals(lod.matNorm);
+        setIndex(lod.matTris);
+
+        uploadColor();
+    }
+}
+
+
+//*************************************************************************************************************
+
+int CustomMesh::getLevelOfDetail() const
+{
+    return m_iLevelOfDetail;
+}
+
+
+//*************************************************************************************************************
+
+QVector3D CustomMesh::getBoundingCenter() const
+{
+    return m_vecBoundingCenter;
+}
+
+
+//*************************************************************************************************************
+
+void CustomMesh::updateLevelOfDetail(float fCameraDistance)
+{
+    if(m_fBoundingRadius <= 0.0f) {
+        return;
+    }
+
+    const float fRatio = fCameraDistance / m_fBoundingRadius;
+    float fThreshold = CUSTOMMESH_LOD_DISTANCE_RATIO;
+    int iLevel = 0;
+
+    while(iLevel < CUSTOMMESH_LOD_NUM_LEVELS - 1 && fRatio > fThreshold) {
+        ++iLevel;
+        fThreshold *= 2.0f;
+    }
+
+    setLevelOfDetail(iLevel);
+}
+
+
+//*************************************************************************************************************
+
+void CustomMesh::createLevelsOfDetail()
+{
+    m_lLevelsOfDetail.clear();
+
+    if(m_matTris.rows() == 0) {
+        return;
+    }
+
+    //Base the grid on the mean edge length, so that the first level merges roughly four vertices
+    const int iNumSampleTris = qMin((int)m_matTris.rows(), 10000);
+    float fEdgeSum = 0.0f;
+
+    for(int i = 0; i < iNumSampleTris; ++i) {
+        fEdgeSum += (m_matVert.row(m_matTris(i,0)) - m_matVert.row(m_matTris(i,1))).norm();
+        fEdgeSum += (m_matVert.row(m_matTris(i,1)) - m_matVert.row(m_matTris(i,2))).norm();
+        fEdgeSum += (m_matVert.row(m_matTris(i,2)) - m_matVert.row(m_matTris(i,0))).norm();
+    }
+
+    float fCellSize = 2.0f * fEdgeSum / (3.0f * iNumSampleTris);
+
+    if(fCellSize <= 0.0f) {
+        return;
+    }
+
+    m_lLevelsOfDetail.resize(CUSTOMMESH_LOD_NUM_LEVELS - 1);
+
+    for(int i = 0; i < m_lLevelsOfDetail.size(); ++i) {
+        decimateMesh(m_matVert, m_matNorm, m_matTris, fCellSize, m_lLevelsOfDetail[i]);
+        fCellSize *= 2.0f;
+    }
+}
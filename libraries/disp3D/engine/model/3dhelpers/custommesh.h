@@ -51,6 +51,9 @@
 
 #include <Qt3DRender/QGeometryRenderer>
 #include <QPointer>
+#include <QByteArray>
+#include <QVector>
+#include <QVector3D>
 
 
 //*************************************************************************************************************
@@ -80,6 +83,23 @@ namespace DISP3DLIB
 {
 
 
+//*************************************************************************************************************
+//=============================================================================================================
+// Declare all structures to be used
+//=============================================================================================================
+
+//=========================================================================================================
+/**
+* The struct specifing a decimated level of detail of a mesh.
+*/
+struct MeshLevelOfDetail {
+    Eigen::MatrixX3f        matVert;            /**< The decimated vertices. */
+    Eigen::MatrixX3f        matNorm;            /**< The decimated normals. */
+    Eigen::MatrixXi         matTris;            /**< The decimated triangles. */
+    Eigen::VectorXi         vecVertIdx;         /**< The full resolution vertex which represents each decimated vertex, i.e. which provides its color. */
+};
+
+
 //*************************************************************************************************************
 //=============================================================================================================
 // FORWARD DECLARATIONS
@@ -130,12 +150,33 @@ public:
 
     //=========================================================================================================
     /**
-    * Set the vertices colors of the mesh.
+    * Set the vertices colors of the mesh. The colors are packed to 8-bit RGBA and only the vertices whose color
+    * changed since the last call are uploaded.
     *
     * @param[in] tMatColors     New color information for the vertices.
     */
     void setColor(const Eigen::MatrixX3f &tMatColors);
 
+    //=========================================================================================================
+    /**
+    * Set the vertices colors of the mesh from an already packed 8-bit RGBA buffer (4 bytes per vertex).
+    * The colors are copied into a buffer owned by the mesh, no reference to the producer's buffer is kept.
+    * Hence, the producer can refill its buffer without detaching it.
+    *
+    * @param[in] arrayColorsRGBA8   New color information for the vertices in 8-bit RGBA format.
+    */
+    void setColor(const QByteArray& arrayColorsRGBA8);
+
+    //=========================================================================================================
+    /**
+    * Packs the colors to the 8-bit RGBA format used by the color attribute of this mesh.
+    *
+    * @param[in] tMatColors         The colors in the range [0,1].
+    * @param[out] arrayColorsRGBA8  The packed colors. The array is resized if needed.
+    */
+    static void colorsToRGBA8(const Eigen::MatrixX3f& tMatColors,
+                              QByteArray& arrayColorsRGBA8);
+
     //=========================================================================================================
     /**
     * Set the normals the mesh.
@@ -176,6 +217,40 @@ public:
                      const Eigen::MatrixX3f& tMatColors,
                      Qt3DRender::QGeometryRenderer::PrimitiveType primitiveType = Qt3DRender::QGeometryRenderer::Triangles);
 
+    //=========================================================================================================
+    /**
+    * Switches to a level of detail of the mesh data set via setMeshData(). Level 0 is the full resolution, every
+    * further level has roughly a quarter of the vertices of the previous one. The decimated levels are created on
+    * first use. Small and non triangle meshes always stay at level 0. Colors keep being set in full resolution.
+    *
+    * @param[in] iLevel         The new level of detail.
+    */
+    void setLevelOfDetail(int iLevel);
+
+    //=========================================================================================================
+    /**
+    * Returns the current level of detail.
+    *
+    * @return The current level of detail.
+    */
+    int getLevelOfDetail() const;
+
+    //=========================================================================================================
+    /**
+    * Chooses the level of detail based on the distance of the camera relative to the size of the mesh.
+    *
+    * @param[in] fCameraDistance    The distance between the camera and the center of the mesh's bounding sphere.
+    */
+    void updateLevelOfDetail(float fCameraDistance);
+
+    //=========================================================================================================
+    /**
+    * Returns the center of the bounding sphere of the full resolution mesh in mesh coordinates.
+    *
+    * @return The bounding sphere center.
+    */
+    QVector3D getBoundingCenter() const;
+
 protected:
     //=========================================================================================================
     /**
@@ -183,6 +258,50 @@ protected:
     */
     void init();
 
+    //=========================================================================================================
+    /**
+    * Uploads the back buffer of a double buffered attribute and swaps the buffers afterwards. If the size did not
+    * change only the ranges which differ from the front buffer are uploaded.
+    *
+    * @param[in] pBuffer            The Qt3D buffer to upload to.
+    * @param[in, out] arrayData     The front and back buffer.
+    * @param[in, out] iFront        The index of the front buffer.
+    * @param[in] iElementSize       The size of one element (i.e. one vertex) in bytes.
+    */
+    void uploadBufferData(Qt3DRender::QBuffer* pBuffer,
+                          QByteArray arrayData[2],
+                          int& iFront,
+                          int iElementSize);
+
+    //=========================================================================================================
+    /**
+    * Gathers the colors of the current level of detail from the full resolution colors into the back buffer
+    * and uploads them. Only used for decimated levels of detail.
+    */
+    void uploadColor();
+
+    //=========================================================================================================
+    /**
+    * Uploads the colors in the color back buffer.
+    */
+    void uploadColorBuffer();
+
+    //=========================================================================================================
+    /**
+    * Copies the content of a byte array into another one which is owned by this mesh. In contrast to an
+    * assignment, this does not share the data with the source.
+    *
+    * @param[in] arraySource        The data to copy.
+    * @param[out] arrayTarget       The target buffer.
+    */
+    static void copyBytes(const QByteArray& arraySource, QByteArray& arrayTarget);
+
+    //=========================================================================================================
+    /**
+    * Creates the decimated levels of detail from the full resolution mesh data.
+    */
+    void createLevelsOfDetail();
+
     QPointer<Qt3DRender::QBuffer>       m_pVertexDataBuffer;       /**< The vertex buffer. */
     QPointer<Qt3DRender::QBuffer>       m_pNormalDataBuffer;       /**< The normal buffer. */
     QPointer<Qt3DRender::QBuffer>       m_pColorDataBuffer;        /**< The color buffer. */
@@ -195,6 +314,26 @@ protected:
     QPointer<Qt3DRender::QAttribute>    m_pNormalAttribute;        /**< The normal attribute. */
     QPointer<Qt3DRender::QAttribute>    m_pColorAttribute;         /**< The color attribute. */
 
+    QByteArray                          m_arrayVertexData[2];       /**< The front and back buffer of the vertex data. */
+    QByteArray                          m_arrayNormalData[2];       /**< The front and back buffer of the normal data. */
+    QByteArray                          m_arrayColorData[2];        /**< The front and back buffer of the 8-bit RGBA color data. */
+    QByteArray                          m_arrayIndexData[2];        /**< The front and back buffer of the index data. */
+
+    int                                 m_iVertexFront;             /**< The index of the vertex front buffer, i.e. the one last uploaded. */
+    int                                 m_iNormalFront;             /**< The index of the normal front buffer, i.e. the one last uploaded. */
+    int                                 m_iColorFront;              /**< The index of the color front buffer, i.e. the one last uploaded. */
+    int                                 m_iIndexFront;              /**< The index of the index front buffer, i.e. the one last uploaded. */
+
+    Eigen::MatrixX3f                    m_matVert;                  /**< The full resolution vertices. */
+    Eigen::MatrixX3f                    m_matNorm;                  /**< The full resolution normals. */
+    Eigen::MatrixXi                     m_matTris;                  /**< The full resolution triangles. */
+    QByteArray                          m_arrayColorFullRes;        /**< The full resolution colors in 8-bit RGBA format. Only kept while a decimated level of detail is shown, at full resolution the color front buffer holds them. */
+
+    QVector<MeshLevelOfDetail>          m_lLevelsOfDetail;          /**< The decimated levels of detail, starting with level 1. */
+    int                                 m_iLevelOfDetail;           /**< The current level of detail. */
+    float                               m_fBoundingRadius;          /**< The radius of the bounding sphere of the full resolution mesh. */
+    QVector3D                           m_vecBoundingCenter;        /**< The center of the bounding sphere of the full resolution mesh. */
+
     int                                 m_iNumVert;                 /**< The total number of set vertices. */
 };
 
@@ -118,12 +118,41 @@ void GeometryMultiplier::setTransforms(const QVector<QMatrix4x4> &tInstanceTansf
     }
 
     m_pTransformBuffer->setData(buildTransformBuffer(tInstanceTansform));
+    m_pTransformAttribute->setName(QStringLiteral("instanceModelMatrix"));
+    m_pTransformAttribute->setVertexSize(16);
     m_pTransformAttribute->setBuffer(m_pTransformBuffer);
 
     updateInstanceCount(tInstanceTansform.size());
 }
 
 
+//*************************************************************************************************************
+
+void GeometryMultiplier::setPositions(const QVector<QVector3D> &tInstancePositions,
+                                      const QVector<float> &tInstanceScales)
+{
+    if(tInstancePositions.isEmpty())
+    {
+        qDebug ("ERROR!: GeometryMultiplier::setPositions: QVector is empty!");
+        return;
+    }
+
+    if(!tInstanceScales.isEmpty() && tInstanceScales.size() != tInstancePositions.size())
+    {
+        qDebug ("ERROR!: GeometryMultiplier::setPositions: Number of scales does not match the number of positions!");
+        return;
+    }
+
+    //Reuse the transform buffer, only the attribute layout changes
+    m_pTransformBuffer->setData(buildPositionBuffer(tInstancePositions, tInstanceScales));
+    m_pTransformAttribute->setName(QStringLiteral("instancePositionScale"));
+    m_pTransformAttribute->setVertexSize(4);
+    m_pTransformAttribute->setBuffer(m_pTransformBuffer);
+
+    updateInstanceCount(tInstancePositions.size());
+}
+
+
 //*************************************************************************************************************#
 
 void GeometryMultiplier::setColors(const QVector<QColor> &tInstanceColors)
@@ -209,6 +238,30 @@ QByteArray GeometryMultiplier::buildTransformBuffer(const QVector<QMatrix4x4> &t
 }
 
 
+//*************************************************************************************************************
+
+QByteArray GeometryMultiplier::buildPositionBuffer(const QVector<QVector3D> &tInstancePositions,
+                                                   const QVector<float> &tInstanceScales)
+{
+    const uint iVertSize = 4;
+    //create byte array
+    QByteArray bufferData;
+    bufferData.resize(tInstancePositions.size() * iVertSize * (int)sizeof(float));
+    float *rawVertexArray = reinterpret_cast<float *>(bufferData.data());
+
+    //copy position and scale into buffer
+    for(int i = 0; i < tInstancePositions.size(); i++)
+    {
+        rawVertexArray[iVertSize * i] = tInstancePositions[i].x();
+        rawVertexArray[iVertSize * i + 1] = tInstancePositions[i].y();
+        rawVertexArray[iVertSize * i + 2] = tInstancePositions[i].z();
+        rawVertexArray[iVertSize * i + 3] = tInstanceScales.isEmpty() ? 1.0f : tInstanceScales[i];
+    }
+
+    return bufferData;
+}
+
+
 //*************************************************************************************************************
 
 QByteArray GeometryMultiplier::buildColorBuffer(const QVector<QColor> &tInstanceColor)
@@ -51,6 +51,7 @@
 
 #include <QSharedPointer>
 #include <QPointer>
+#include <QVector>
 #include <Qt3DRender/QGeometryRenderer>
 
 
@@ -144,6 +145,18 @@ public:
      */
     void setTransforms(const QVector<QMatrix4x4> &tInstanceTansform);
 
+    //=========================================================================================================
+    /**
+     * Sets the position and the scale for each instance of the geometry. The instances are packed as one vec4 per
+     * instance, which is a quarter of the data uploaded by setTransforms. Requires the material to be switched via
+     * GeometryMultiplierMaterial::setUsePositionScale.
+     *
+     * @param tInstancePositions        Position of each instance.
+     * @param tInstanceScales           Scale of each instance. If empty all instances are drawn unscaled.
+     */
+    void setPositions(const QVector<QVector3D> &tInstancePositions,
+                      const QVector<float> &tInstanceScales = QVector<float>());
+
     //=========================================================================================================
     /**
      * Sets the color for each instance of the geometry.
@@ -171,6 +184,17 @@ private:
      */
     QByteArray buildTransformBuffer(const QVector<QMatrix4x4> &tInstanceTransform);
 
+    //=========================================================================================================
+    /**
+     * Builds the position and scale buffer content.
+     *
+     * @param tInstancePositions        Position for each instance.
+     * @param tInstanceScales           Scale for each instance, may be empty.
+     * @return                          buffer content.
+     */
+    QByteArray buildPositionBuffer(const QVector<QVector3D> &tInstancePositions,
+                                   const QVector<float> &tInstanceScales);
+
     //=========================================================================================================
     /**
      * Builds color buffer content.
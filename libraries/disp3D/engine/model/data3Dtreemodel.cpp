@@ -453,6 +453,7 @@ void Data3DTreeModel::initMetatypes()
 {
     //Init metatypes
     qRegisterMetaType<QPair<MatrixX3f, MatrixX3f> >("QPair<MatrixX3f, MatrixX3f>");
+    qRegisterMetaType<QPair<QByteArray, QByteArray> >("QPair<QByteArray, QByteArray>");
 
     qRegisterMetaType<Eigen::MatrixX3i>();
     qRegisterMetaType<Eigen::MatrixXd>();
@@ -72,6 +72,7 @@ Abstract3DTreeItem::Abstract3DTreeItem(QEntity* p3DEntityParent, int iType, cons
 : QStandardItem(text)
 , Renderable3DEntity(p3DEntityParent)
 , m_iType(iType)
+, m_fAlpha(1.0f)
 {
     initItem();
 }
@@ -268,7 +269,7 @@ void Abstract3DTreeItem::onCheckStateChanged(const Qt::CheckState& checkState)
         }
     }
 
-    this->setVisible(checkState == Qt::Unchecked ? false : true);
+    updateVisibility();
 }
 
 
@@ -332,5 +333,20 @@ void Abstract3DTreeItem::onColorChanged(const QVariant& color)
 void Abstract3DTreeItem::onAlphaChanged(const QVariant& fAlpha)
 {
     this->setMaterialParameter(fAlpha, "alpha");
+
+    if(fAlpha.canConvert<float>()) {
+        m_fAlpha = fAlpha.toFloat();
+        updateVisibility();
+    }
+}
+
+
+//*************************************************************************************************************
+
+void Abstract3DTreeItem::updateVisibility()
+{
+    const bool bChecked = !this->isCheckable() || this->checkState() != Qt::Unchecked;
+
+    this->setVisible(bChecked && m_fAlpha > 0.0f);
 }
 
@@ -206,7 +206,14 @@ protected:
     */
     virtual void onAlphaChanged(const QVariant& fAlpha);
 
+    //=========================================================================================================
+    /**
+    * Shows the item only if it is checked and not fully transparent, so that hidden items are culled from rendering.
+    */
+    void updateVisibility();
+
     int     m_iType;        /**< This item's type. */
+    float   m_fAlpha;       /**< This item's current alpha value. */
 
     QPointer<MetaTreeItem>      m_pItemTransformationOptions;       /**< The item holding the transfomation (translation, etc.) group. */
     QPointer<MetaTreeItem>      m_pItemAppearanceOptions;           /**< The item holding the appearance (color, alpha, etc.) group. */
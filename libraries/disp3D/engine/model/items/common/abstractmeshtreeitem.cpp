@@ -97,6 +97,14 @@ QPointer<CustomMesh> AbstractMeshTreeItem::getCustomMesh()
 
 void AbstractMeshTreeItem::setVertColor(const QVariant& vertColor)
 {
+    if(vertColor.type() == QVariant::ByteArray) {
+        if(m_pCustomMesh) {
+            m_pCustomMesh->setColor(vertColor.toByteArray());
+        }
+
+        return;
+    }
+
     this->setData(vertColor, Data3DTreeModelItemRoles::SurfaceCurrentColorVert);
 }
 
@@ -134,11 +134,10 @@ public:
 
     //=========================================================================================================
     /**
-    * Set new vertices colors to the mesh.
+    * Set new vertices colors to the mesh. A MatrixX3f is stored as the current surface color. A QByteArray
+    * holding 8-bit RGBA colors (i.e. streamed real time data) is passed to the mesh directly and not stored.
     *
-    * @param[in] vertColor New color matrix MatrixX3f in form of a QVariant.
-    *
-    * @return The costum mesh.
+    * @param[in] vertColor New color matrix MatrixX3f or 8-bit RGBA QByteArray in form of a QVariant.
     */
     virtual void setVertColor(const QVariant &vertColor);
 
@@ -53,7 +53,7 @@
 //=============================================================================================================
 
 #include <Qt3DExtras/QSphereGeometry>
-#include <QMatrix4x4>
+#include <QVector3D>
 #include <Qt3DCore/QTransform>
 
 
@@ -117,6 +117,7 @@ void DigitizerTreeItem::addData(const QList<FIFFLIB::FiffDigPoint>& tDigitizer,
 
         //Add material
         GeometryMultiplierMaterial* pMaterial = new GeometryMultiplierMaterial(true);
+        pMaterial->setUsePositionScale(true);
         pMaterial->setAmbient(tSphereColor);
         pSourceSphereEntity->addComponent(pMaterial);
     }
@@ -124,24 +125,17 @@ void DigitizerTreeItem::addData(const QList<FIFFLIB::FiffDigPoint>& tDigitizer,
     //Set transforms
     if(!tDigitizer.isEmpty())
     {
-        QVector<QMatrix4x4> vTransforms;
-        vTransforms.reserve(tDigitizer.size());
-
-        QVector3D tempPos;
+        QVector<QVector3D> vPositions;
+        vPositions.reserve(tDigitizer.size());
 
         for(int i = 0; i < tDigitizer.size(); ++i) {
-            QMatrix4x4 tempTransform;
-
-            tempPos.setX(tDigitizer[i].r[0]);
-            tempPos.setY(tDigitizer[i].r[1]);
-            tempPos.setZ(tDigitizer[i].r[2]);
-
-            tempTransform.translate(tempPos);
-            vTransforms.push_back(tempTransform);
+            vPositions.push_back(QVector3D(tDigitizer[i].r[0],
+                                           tDigitizer[i].r[1],
+                                           tDigitizer[i].r[2]));
         }
 
-        //Set instance Transform
-        m_pSphereMesh->setTransforms(vTransforms);
+        //Set instance positions
+        m_pSphereMesh->setPositions(vPositions);
     }
 
     //Update alpha
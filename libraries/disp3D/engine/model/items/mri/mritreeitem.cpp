@@ -164,18 +164,27 @@ FsSurfaceTreeItem* MriTreeItem::addData(const Surface& tSurface, const Annotatio
 
 void MriTreeItem::setRtVertColor(const QVariant& sourceColorSamples)
 {
-    QVariant data;
-    QPair<MatrixX3f, MatrixX3f> colorsPerHemi = sourceColorSamples.value<QPair<MatrixX3f, MatrixX3f> >();
+    QVariant dataLeft, dataRight;
+
+    //The rt source loc worker sends already packed 8-bit RGBA colors
+    if(sourceColorSamples.userType() == qMetaTypeId<QPair<QByteArray, QByteArray> >()) {
+        QPair<QByteArray, QByteArray> colorsPerHemi = sourceColorSamples.value<QPair<QByteArray, QByteArray> >();
+        dataLeft.setValue(colorsPerHemi.first);
+        dataRight.setValue(colorsPerHemi.second);
+    } else {
+        QPair<MatrixX3f, MatrixX3f> colorsPerHemi = sourceColorSamples.value<QPair<MatrixX3f, MatrixX3f> >();
+        dataLeft.setValue(colorsPerHemi.first);
+        dataRight.setValue(colorsPerHemi.second);
+    }
+
     QList<QStandardItem*> itemList = this->findChildren(Data3DTreeModelItemTypes::HemisphereItem);
 
     for(int j = 0; j < itemList.size(); ++j) {
         if(HemisphereTreeItem* pHemiItem = dynamic_cast<HemisphereTreeItem*>(itemList.at(j))) {
             if(pHemiItem->data(Data3DTreeModelItemRoles::SurfaceHemi).toInt() == 0) {
-                data.setValue(colorsPerHemi.first);
-                pHemiItem->getSurfaceItem()->setVertColor(data);
+                pHemiItem->getSurfaceItem()->setVertColor(dataLeft);
             } else if (pHemiItem->data(Data3DTreeModelItemRoles::SurfaceHemi).toInt() == 1) {
-                data.setValue(colorsPerHemi.second);
-                pHemiItem->getSurfaceItem()->setVertColor(data);
+                pHemiItem->getSurfaceItem()->setVertColor(dataRight);
             }
         }
     }
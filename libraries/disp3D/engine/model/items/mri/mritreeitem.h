@@ -150,7 +150,7 @@ public:
     /**
     * Call this function whenever new colors for the activation data plotting are available.
     *
-    * @param[in] sourceColorSamples     The color values for each estimated source for left and right hemisphere.
+    * @param[in] sourceColorSamples     The colors for the left and right hemisphere, either as QPair of MatrixX3f or as QPair of 8-bit RGBA QByteArray.
     */
     void setRtVertColor(const QVariant& sourceColorSamples);
 
@@ -63,6 +63,7 @@
 
 #include <Qt3DExtras/QSphereGeometry>
 #include <Qt3DCore/QTransform>
+#include <QVector3D>
 
 
 //*************************************************************************************************************
@@ -203,29 +204,22 @@ void NetworkTreeItem::plotNetwork(const Network& tNetworkData, const QVector3D&
         //create instanced renderer
         GeometryMultiplier *pSphereMesh = new GeometryMultiplier(pSourceSphereGeometry);
 
-        //Create transform matrix for each sphere instance
-        QVector<QMatrix4x4> vTransforms;
-        vTransforms.reserve(tMatVert.rows());
-        QVector3D tempPos;
+        //Create position for each sphere instance
+        QVector<QVector3D> vPositions;
+        vPositions.reserve(tMatVert.rows());
 
         for(int i = 0; i < tMatVert.rows(); ++i) {
-            QMatrix4x4 tempTransform;
-
-            tempPos.setX(tMatVert(i, 0));
-            tempPos.setY(tMatVert(i, 1));
-            tempPos.setZ(tMatVert(i, 2));
-            //Set position
-            tempTransform.translate(tempPos);
-            vTransforms.push_back(tempTransform);
+            vPositions.push_back(QVector3D(tMatVert(i, 0), tMatVert(i, 1), tMatVert(i, 2)));
         }
 
-        //Set instance Transform
-        pSphereMesh->setTransforms(vTransforms);
+        //Set instance positions
+        pSphereMesh->setPositions(vPositions);
 
         pSourceSphereEntity->addComponent(pSphereMesh);
 
         //Add material
         GeometryMultiplierMaterial* pMaterial = new GeometryMultiplierMaterial(true);
+        pMaterial->setUsePositionScale(true);
         pMaterial->setAmbient(Qt::blue);
         pMaterial->setAlpha(1.0f);
         pSourceSphereEntity->addComponent(pMaterial);
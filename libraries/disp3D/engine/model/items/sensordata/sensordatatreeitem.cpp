@@ -514,10 +514,10 @@ void SensorDataTreeItem::onCheckStateWorkerChanged(const Qt::CheckState& checkSt
 
 //*************************************************************************************************************
 
-void SensorDataTreeItem::onNewRtData(const MatrixX3f &sensorData)
+void SensorDataTreeItem::onNewRtData(const QByteArray &arrayColorsRGBA8)
 {
     QVariant data;
-    data.setValue(sensorData);
+    data.setValue(arrayColorsRGBA8);
     emit rtVertColorChanged(data);
 }
 
@@ -49,6 +49,7 @@
 //=============================================================================================================
 
 #include <QPointer>
+#include <QByteArray>
 
 
 //*************************************************************************************************************
@@ -253,11 +254,11 @@ protected:
 
     //=========================================================================================================
     /**
-    * This function gets called whenever this item receives new color values for each estimated source.
+    * This function gets called whenever this item receives new color values for each vertex of the sensor surface.
     *
-    * @param[in] sourceColorSamples         The color values for each estimated source for left and right hemisphere.
+    * @param[in] arrayColorsRGBA8           The colors for each vertex in 8-bit RGBA format.
     */
-    void onNewRtData(const MatrixX3f &sensorData);
+    void onNewRtData(const QByteArray &arrayColorsRGBA8);
 
     //=========================================================================================================
     /**
@@ -53,6 +53,7 @@
 //=============================================================================================================
 
 #include <QMatrix4x4>
+#include <QVector3D>
 #include <Qt3DExtras/QCuboidGeometry>
 #include <Qt3DCore/QEntity>
 #include <Qt3DExtras/QSphereGeometry>
@@ -157,31 +158,26 @@ void SensorPositionTreeItem::plotSensors(const QList<FIFFLIB::FiffChInfo>& lChIn
 
         pMesh = new GeometryMultiplier(pSourceSphere);
 
-        //Create transform matrix for each cuboid instance
-        QVector<QMatrix4x4> vTransforms;
-        vTransforms.reserve(lChInfo.size());
-        QVector3D tempPos;
+        //Create position for each sphere instance
+        QVector<QVector3D> vPositions;
+        vPositions.reserve(lChInfo.size());
 
         for(int i = 0; i < lChInfo.size(); ++i) {
-            QMatrix4x4 tempTransform;
-
-            tempPos.setX(lChInfo[i].chpos.r0(0));
-            tempPos.setY(lChInfo[i].chpos.r0(1));
-            tempPos.setZ(lChInfo[i].chpos.r0(2));
-            //Set position
-            tempTransform.translate(tempPos);
-
-            vTransforms.push_back(tempTransform);
+            vPositions.push_back(QVector3D(lChInfo[i].chpos.r0(0),
+                                           lChInfo[i].chpos.r0(1),
+                                           lChInfo[i].chpos.r0(2)));
         }
 
-        //Set instance Transform
-        pMesh->setTransforms(vTransforms);
+        //Set instance positions
+        pMesh->setPositions(vPositions);
     }
 
     pSensorEntity->addComponent(pMesh);
 
     //Add material
     GeometryMultiplierMaterial* pMaterial = new GeometryMultiplierMaterial(true);
+    //MEG coils need the full transform for their orientation, EEG electrodes only a position
+    pMaterial->setUsePositionScale(sDataType == "EEG");
 
     QColor colDefault(100,100,100);
     pMaterial->setAmbient(colDefault);
@@ -450,7 +450,7 @@ void MneEstimateTreeItem::onCheckStateWorkerChanged(const Qt::CheckState& checkS
 
 //*************************************************************************************************************
 
-void MneEstimateTreeItem::onNewRtData(const QPair<MatrixX3f, MatrixX3f>& sourceColors)
+void MneEstimateTreeItem::onNewRtData(const QPair<QByteArray, QByteArray>& sourceColors)
 {    
     QVariant data;
     data.setValue(sourceColors);
@@ -246,9 +246,9 @@ protected:
     /**
     * This function gets called whenever this item receives new color values for each estimated source.
     *
-    * @param[in] sourceColorSamples     The color values for each estimated source for left and right hemisphere.
+    * @param[in] sourceColorSamples     The 8-bit RGBA colors of the left and right hemisphere.
     */
-    void onNewRtData(const QPair<MatrixX3f, MatrixX3f> &sourceColorSamples);
+    void onNewRtData(const QPair<QByteArray, QByteArray> &sourceColorSamples);
 
     //=========================================================================================================
     /**
@@ -54,7 +54,7 @@
 //=============================================================================================================
 
 #include <Qt3DExtras/QSphereGeometry>
-#include <QMatrix4x4>
+#include <QVector3D>
 
 
 //*************************************************************************************************************
@@ -134,53 +134,39 @@ void SourceSpaceTreeItem::plotSources(const MNEHemisphere& tHemisphere)
     //create instanced renderer
     GeometryMultiplier *pSphereMesh = new GeometryMultiplier(pSourceSphereGeometry);
 
-    //Create transform matrix for each sphere instance
-    QVector<QMatrix4x4> vTransforms;
-    QVector3D tempPos;
+    //Create position for each sphere instance
+    QVector<QVector3D> vPositions;
 
     if(tHemisphere.isClustered())
     {
-        vTransforms.reserve(tHemisphere.cluster_info.centroidVertno.size());
+        vPositions.reserve(tHemisphere.cluster_info.centroidVertno.size());
 
         for(int i = 0; i < tHemisphere.cluster_info.centroidVertno.size(); i++)
         {
-            QMatrix4x4 tempTransform;
             const RowVector3f& sourcePos = tHemisphere.rr.row(tHemisphere.cluster_info.centroidVertno.at(i));
 
-            tempPos.setX(sourcePos(0));
-            tempPos.setY(sourcePos(1));
-            tempPos.setZ(sourcePos(2));
-
-            //Set position
-            tempTransform.translate(tempPos);
-            vTransforms.push_back(tempTransform);
+            vPositions.push_back(QVector3D(sourcePos(0), sourcePos(1), sourcePos(2)));
         }
     }
     else
     {
-        vTransforms.reserve(tHemisphere.vertno.rows());
+        vPositions.reserve(tHemisphere.vertno.rows());
 
         for(int i = 0; i < tHemisphere.vertno.rows(); i++)
         {
-            QMatrix4x4 tempTransform;
             const RowVector3f& sourcePos = tHemisphere.rr.row(tHemisphere.vertno(i));
 
-            tempPos.setX(sourcePos(0));
-            tempPos.setY(sourcePos(1));
-            tempPos.setZ(sourcePos(2));
-
-            //Set position
-            tempTransform.translate(tempPos);
-            vTransforms.push_back(tempTransform);
+            vPositions.push_back(QVector3D(sourcePos(0), sourcePos(1), sourcePos(2)));
         }
     }
-    //Set instance Transform
-    pSphereMesh->setTransforms(vTransforms);
+    //Set instance positions
+    pSphereMesh->setPositions(vPositions);
 
     pSourceSphereEntity->addComponent(pSphereMesh);
 
     //Add material
     GeometryMultiplierMaterial* pMaterial = new GeometryMultiplierMaterial(true);
+    pMaterial->setUsePositionScale(true);
     QColor defaultColor(255,0,0);
     pMaterial->setAmbient(defaultColor);
 
@@ -109,6 +109,7 @@ GeometryMultiplierMaterial::GeometryMultiplierMaterial(bool bUseAlpha, Qt3DCore:
     , m_pBlendState(new QBlendEquationArguments())
     , m_pBlendEquation(new QBlendEquation())
     , m_bUseAlpha(bUseAlpha)
+    , m_bUsePositionScale(false)
 {
     this->init();
 }
@@ -146,16 +147,26 @@ void GeometryMultiplierMaterial::setAlpha(float alpha)
 }
 
 
+//*************************************************************************************************************
+
+void GeometryMultiplierMaterial::setUsePositionScale(bool bUsePositionScale)
+{
+    if(m_bUsePositionScale == bUsePositionScale) {
+        return;
+    }
+
+    m_bUsePositionScale = bUsePositionScale;
+
+    loadShaders();
+}
+
+
 //*************************************************************************************************************
 
 void GeometryMultiplierMaterial::init()
 {
     //Set shader
-    m_pVertexGL3Shader->setVertexShaderCode(QShaderProgram::loadSource(QUrl(QStringLiteral("qrc:/engine/model/materials/shaders/gl3/instancedposition.vert"))));
-    m_pVertexGL3Shader->setFragmentShaderCode(QShaderProgram::loadSource(QUrl(QStringLiteral("qrc:/engine/model/materials/shaders/gl3/instancedposition.frag"))));
-
-    m_pVertexES2Shader->setVertexShaderCode(QShaderProgram::loadSource(QUrl(QStringLiteral("qrc:/engine/model/materials/shaders/es2/instancedposition.vert"))));
-    m_pVertexES2Shader->setFragmentShaderCode(QShaderProgram::loadSource(QUrl(QStringLiteral("qrc:/engine/model/materials/shaders/es2/instancedposition.frag"))));
+    loadShaders();
 
     m_pVertexGL3RenderPass->setShaderProgram(m_pVertexGL3Shader);
     m_pVertexGL2RenderPass->setShaderProgram(m_pVertexES2Shader);
@@ -220,4 +231,21 @@ void GeometryMultiplierMaterial::init()
     this->setEffect(m_pVertexEffect);
 }
 
+
+//*************************************************************************************************************
+
+void GeometryMultiplierMaterial::loadShaders()
+{
+    if(m_bUsePositionScale) {
+        m_pVertexGL3Shader->setVertexShaderCode(QShaderProgram::loadSource(QUrl(QStringLiteral("qrc:/engine/model/materials/shaders/gl3/instancedpositionscale.vert"))));
+        m_pVertexES2Shader->setVertexShaderCode(QShaderProgram::loadSource(QUrl(QStringLiteral("qrc:/engine/model/materials/shaders/es2/instancedpositionscale.vert"))));
+    } else {
+        m_pVertexGL3Shader->setVertexShaderCode(QShaderProgram::loadSource(QUrl(QStringLiteral("qrc:/engine/model/materials/shaders/gl3/instancedposition.vert"))));
+        m_pVertexES2Shader->setVertexShaderCode(QShaderProgram::loadSource(QUrl(QStringLiteral("qrc:/engine/model/materials/shaders/es2/instancedposition.vert"))));
+    }
+
+    m_pVertexGL3Shader->setFragmentShaderCode(QShaderProgram::loadSource(QUrl(QStringLiteral("qrc:/engine/model/materials/shaders/gl3/instancedposition.frag"))));
+    m_pVertexES2Shader->setFragmentShaderCode(QShaderProgram::loadSource(QUrl(QStringLiteral("qrc:/engine/model/materials/shaders/es2/instancedposition.frag"))));
+}
+
 //*************************************************************************************************************
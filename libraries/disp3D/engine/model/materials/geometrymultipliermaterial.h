@@ -159,6 +159,15 @@ public:
     */
     void setAlpha(float alpha);
 
+    //=========================================================================================================
+    /**
+    * Switches between the shaders for instances set via GeometryMultiplier::setTransforms (4x4 matrix per instance)
+    * and GeometryMultiplier::setPositions (position and scale per instance).
+    *
+    * @param[in] bUsePositionScale  Whether the instances are set via position and scale.
+    */
+    void setUsePositionScale(bool bUsePositionScale);
+
 private:
 
     //=========================================================================================================
@@ -167,6 +176,12 @@ private:
     */
     void init();
 
+    //=========================================================================================================
+    /**
+    * Loads the shader code matching the current instance layout.
+    */
+    void loadShaders();
+
     QPointer<Qt3DRender::QEffect>           m_pVertexEffect;
 
     QPointer<Qt3DRender::QParameter>        m_pAmbientColor;
@@ -193,6 +208,7 @@ private:
     QPointer<Qt3DRender::QBlendEquation>                m_pBlendEquation;
 
     bool        m_bUseAlpha;
+    bool        m_bUsePositionScale;
 
 };
 
@@ -0,0 +1,27 @@
+#version 150 core
+
+in vec3 vertexPosition;
+in vec3 vertexNormal;
+
+in vec4 instancePositionScale; //from GeometryMultiplier, xyz position and w scale
+in vec3 instanceColor;       //from GeometryMultiplier
+
+out vec3 worldPosition;
+out vec3 worldNormal;
+out vec3 color;
+
+uniform mat3 modelNormalMatrix;
+uniform mat4 modelMatrix;
+uniform mat4 mvp;
+
+void main()
+{
+    color = instanceColor;
+
+    vec4 pos = vec4(vertexPosition.xyz * instancePositionScale.w + instancePositionScale.xyz, 1.0);
+
+    worldNormal = normalize( modelNormalMatrix * vertexNormal );
+    worldPosition = vec3( modelMatrix * pos);
+
+    gl_Position = mvp * pos;
+}
@@ -45,6 +45,7 @@
 #include <utils/ioutils.h>
 #include "../../../../helpers/interpolation/interpolation.h"
 #include "../../../../helpers/geometryinfo/geometryinfo.h"
+#include "../../3dhelpers/custommesh.h"
 #include <mne/mne_bem_surface.h>
 #include <fiff/fiff_evoked.h>
 #include <fiff/fiff_constants.h>
@@ -58,6 +59,7 @@
 
 #include <QObject>
 #include <QTime>
+#include <QElapsedTimer>
 #include <QDebug>
 #include <QtConcurrent>
 
@@ -70,6 +72,14 @@
 #include <Eigen/Core>
 
 
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <cstring>
+
+
 //*************************************************************************************************************
 //=============================================================================================================
 // USED NAMESPACES
@@ -83,6 +93,16 @@ using namespace FIFFLIB;
 using namespace UTILSLIB;
 
 
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINES
+//=============================================================================================================
+
+#define RTSENSORDATAWORKER_BATCH_SIZE               8       /**< Maximum number of frames which are interpolated at once. */
+#define RTSENSORDATAWORKER_MAX_LAG_MSEC             100     /**< Queued data which can not be displayed within this time is dropped in stream mode. */
+#define RTSENSORDATAWORKER_TIMING_INTERVAL_MSEC     1000    /**< Interval in which the timing statistics are reported. */
+
+
 //*************************************************************************************************************
 //=============================================================================================================
 // DEFINE MEMBER METHODS
@@ -94,12 +114,14 @@ RtSensorDataWorker::RtSensorDataWorker(QObject* parent)
 , m_bIsLooping(true)
 , m_iAverageSamples(1)
 , m_iMSecIntervall(17)
+, m_bTimingLogging(false)
 , m_bSurfaceDataIsInit(false)
 , m_iNumSensors(0)
 , m_dSFreq(1000.0)
 {
-    m_lVisualizationInfo = VisualizationInfo();
+    m_lVisualizationInfo = SensorVisualizationInfo();
     m_lVisualizationInfo.functionHandlerColorMap = ColorMap::valueToHot;
+    m_lVisualizationInfo.iFinalVertColor = 0;
 
     m_lInterpolationData = InterpolationData();
     //5cm cancel distance
@@ -138,6 +160,8 @@ void RtSensorDataWorker::addData(const MatrixXd& data)
             break;
         }
     }
+
+    m_qWaitData.wakeAll();
 }
 
 
@@ -147,6 +171,7 @@ void RtSensorDataWorker::clear()
 {
     QMutexLocker locker(&m_qMutex);
     m_lDataQ.clear();
+    m_itCurrentSample = m_lDataQ.cbegin();
 }
 
 
@@ -171,6 +196,10 @@ void RtSensorDataWorker::calculateSurfaceData()
                                                                                m_lInterpolationData.dCancelDistance,
                                                                                m_lInterpolationData.fiffInfo,
                                                                                m_lInterpolationData.iSensorType);
+
+    if(m_lInterpolationData.pWeightMatrix) {
+        m_lInterpolationData.pWeightMatrixFloat = QSharedPointer<const SparseMatrix<float> >(new SparseMatrix<float>(m_lInterpolationData.pWeightMatrix->cast<float>()));
+    }
 }
 
 //*************************************************************************************************************
@@ -212,7 +241,7 @@ void RtSensorDataWorker::setSurfaceColor(const MatrixX3f& matSurfaceVertColor)
         return;
     }
 
-    m_lVisualizationInfo.matOriginalVertColor = matSurfaceVertColor;
+    CustomMesh::colorsToRGBA8(matSurfaceVertColor, m_lVisualizationInfo.arrayOriginalVertColor);
 }
 
 
@@ -309,6 +338,7 @@ void RtSensorDataWorker::setLoop(bool bLooping)
 {
     QMutexLocker locker(&m_qMutex);
     m_bIsLooping = bLooping;
+    m_qWaitData.wakeAll();
 }
 
 
@@ -347,6 +377,19 @@ void RtSensorDataWorker::updateBadChannels(const FiffInfo& info)
                                                                                m_lInterpolationData.dCancelDistance,
                                                                                m_lInterpolationData.fiffInfo,
                                                                                m_lInterpolationData.iSensorType);
+
+    if(m_lInterpolationData.pWeightMatrix) {
+        m_lInterpolationData.pWeightMatrixFloat = QSharedPointer<const SparseMatrix<float> >(new SparseMatrix<float>(m_lInterpolationData.pWeightMatrix->cast<float>()));
+    }
+}
+
+
+//*************************************************************************************************************
+
+void RtSensorDataWorker::setTimingLogging(bool bEnabled)
+{
+    QMutexLocker locker(&m_qMutex);
+    m_bTimingLogging = bEnabled;
 }
 
 
@@ -368,6 +411,7 @@ void RtSensorDataWorker::stop()
 {
     m_qMutex.lock();
     m_bIsRunning = false;
+    m_qWaitData.wakeAll();
     m_qMutex.unlock();
 
     QThread::wait();
@@ -378,137 +422,300 @@ void RtSensorDataWorker::stop()
 
 void RtSensorDataWorker::run()
 {
-    VectorXd t_vecAverage;
+    MatrixXf matSamples;
+    MatrixXf matSensorValues;
+    MatrixXf matInterpolatedValues;
+    QSharedPointer<const SparseMatrix<float> > pWeightMatrix;
+
+    QElapsedTimer timerStream;
+    QElapsedTimer timerStage;
+    QElapsedTimer timerReport;
+    qint64 iNextFrameTime = 0;
+
+    double dQueueLagSum = 0.0;
+    double dAverageTime = 0.0;
+    double dInterpolationTime = 0.0;
+    double dColorTime = 0.0;
+    int iNumBatches = 0;
+    int iNumProcessedFrames = 0;
+    int iNumFrames = 0;
+    int iNumSkippedFrames = 0;
 
-    uint iSampleCtr = 0;
+    m_qMutex.lock();
     m_bIsRunning = true;
-    QTime timer;
+    m_qMutex.unlock();
+
+    timerStream.start();
+    timerReport.start();
 
     while(true) {
-        timer.start();
+        m_qMutex.lock();
 
-        {
-            QMutexLocker locker(&m_qMutex);
-            if(!m_bIsRunning)
-                break;
+        if(!m_bIsRunning) {
+            m_qMutex.unlock();
+            break;
         }
 
-        bool doProcessing = false;
+        const int iAverageSamples = qMax(1, m_iAverageSamples);
+        const int iInterval = m_iMSecIntervall;
+        const bool bTimingLogging = m_bTimingLogging;
 
-        {
-            QMutexLocker locker(&m_qMutex);
-            if(m_lDataQ.size() > 0)
-                doProcessing = true;
+        //In loop mode there are always frames available as long as there is data
+        int iNumAvailable;
+        if(m_bIsLooping) {
+            iNumAvailable = m_lDataQ.isEmpty() ? 0 : RTSENSORDATAWORKER_BATCH_SIZE;
+        } else {
+            iNumAvailable = m_lDataQ.size() / iAverageSamples;
         }
 
-        if(doProcessing) {
-            if(m_bIsLooping) {
-                m_qMutex.lock();
+        if(iNumAvailable == 0) {
+            //Nothing to display, sleep until addData() or stop() wakes us and restart the schedule then
+            m_qWaitData.wait(&m_qMutex);
+            m_qMutex.unlock();
 
-                //Down sampling in loop mode
-                if(t_vecAverage.rows() != m_lDataQ.front().rows()) {
-                    t_vecAverage = *m_itCurrentSample;
-                } else {
-                    t_vecAverage += *m_itCurrentSample;
-                }
+            iNextFrameTime = timerStream.elapsed();
+            continue;
+        }
 
-                m_qMutex.unlock();
-            } else {
-                m_qMutex.lock();
+        //Drop stale frames: frames whose display time already passed and, in stream mode, queued frames which could
+        //not be displayed within the maximum lag. In stream mode the newest frame is always kept.
+        const qint64 iNow = timerStream.elapsed();
+        int iNumSkip = 0;
 
-                //Down sampling in stream mode
-                if(t_vecAverage.rows() != m_lDataQ.front().rows()) {
-                    t_vecAverage = m_lDataQ.front();
-                } else {
-                    t_vecAverage += m_lDataQ.front();
-                }
+        if(iInterval > 0) {
+            if(iNow - iNextFrameTime >= iInterval) {
+                iNumSkip = (iNow - iNextFrameTime) / iInterval;
+            }
+
+            if(!m_bIsLooping) {
+                const int iMaxQueuedFrames = qMax(1, RTSENSORDATAWORKER_MAX_LAG_MSEC / iInterval);
+                iNumSkip = qMax(iNumSkip, iNumAvailable - iMaxQueuedFrames);
+                iNumSkip = qMin(iNumSkip, iNumAvailable - 1);
+            }
+        }
 
-                m_lDataQ.pop_front();
+        if(iNumSkip > 0) {
+            skipFrames(iNumSkip, iAverageSamples);
+            iNumSkippedFrames += iNumSkip;
+            iNextFrameTime += (qint64)iNumSkip * iInterval;
+        }
 
-                m_qMutex.unlock();
+        //Still behind: the remaining frames are the freshest data available, display them right away
+        if(iNextFrameTime < iNow - iInterval) {
+            iNextFrameTime = iNow;
+        }
+
+        const int iBatchSize = qMin(m_bIsLooping ? iNumAvailable : iNumAvailable - iNumSkip, RTSENSORDATAWORKER_BATCH_SIZE);
+
+        if(!m_bIsLooping) {
+            dQueueLagSum += m_lDataQ.size() * 1000.0 / m_dSFreq;
+        }
+        iNumBatches++;
+
+        //Copy the samples of this batch out of the queue, everything else is done without holding the lock so that
+        //addData() is not blocked
+        timerStage.start();
+
+        matSamples.resize(m_lDataQ.front().rows(), iBatchSize * iAverageSamples);
+
+        for(int i = 0; i < iBatchSize; ++i) {
+            takeNextFrame(matSamples, i * iAverageSamples, iAverageSamples);
+        }
+
+        const bool bSurfaceDataIsInit = m_bSurfaceDataIsInit;
+        const int iNumSensors = m_iNumSensors;
+        pWeightMatrix = m_lInterpolationData.pWeightMatrixFloat;
+
+        m_qMutex.unlock();
+
+        //Average the frames of this batch, one column per frame
+        matSensorValues.resize(matSamples.rows(), iBatchSize);
+
+        for(int i = 0; i < iBatchSize; ++i) {
+            matSensorValues.col(i) = matSamples.middleCols(i * iAverageSamples, iAverageSamples).rowwise().sum() / (float)iAverageSamples;
+        }
+
+        dAverageTime += timerStage.nsecsElapsed() / 1000000.0;
+
+        //Interpolate all frames of this batch at once
+        timerStage.restart();
+
+        bool bIsInterpolated = false;
+
+        if(!bSurfaceDataIsInit || !pWeightMatrix) {
+            qDebug() << "RtSensorDataWorker::run - Surface data was not initialized. Emitting original colors ...";
+        } else if(matSensorValues.rows() != iNumSensors) {
+            qDebug() << "RtSensorDataWorker::run - Number of sensor values (" << matSensorValues.rows() << ") do not match with previously set number of sensors (" << iNumSensors << "). Emitting original colors ...";
+        } else {
+            bIsInterpolated = Interpolation::interpolateSignals(*pWeightMatrix,
+                                                                matSensorValues,
+                                                                matInterpolatedValues);
+        }
+
+        dInterpolationTime += timerStage.nsecsElapsed() / 1000000.0;
+        iNumProcessedFrames += iBatchSize;
+
+        //Transform to colors and emit each frame at its display time. Frames which became stale while the batch was
+        //processed or while waiting for the previous frames are skipped, the last frame of the batch is always shown.
+        for(int i = 0; i < iBatchSize; ++i) {
+            if(iInterval > 0 && i < iBatchSize - 1 && timerStream.elapsed() - iNextFrameTime >= iInterval) {
+                iNumSkippedFrames++;
+                iNextFrameTime += iInterval;
+                continue;
             }
 
             m_qMutex.lock();
 
-            m_itCurrentSample++;
-            iSampleCtr++;
+            if(!m_bIsRunning) {
+                m_qMutex.unlock();
+                break;
+            }
+
+            timerStage.restart();
+            QByteArray arrayColors = generateColorsFromSensorValues(matInterpolatedValues, i, bIsInterpolated);
+            dColorTime += timerStage.nsecsElapsed() / 1000000.0;
 
-            //Set iterator back to the front if needed
-            if(m_itCurrentSample == m_lDataQ.cend())
-            {
-                m_itCurrentSample = m_lDataQ.cbegin();
+            m_qMutex.unlock();
+
+            const qint64 iTimeLeft = iNextFrameTime - timerStream.elapsed();
+            if(iTimeLeft > 0) {
+                QThread::msleep(iTimeLeft);
+            } else if(iTimeLeft <= -iInterval) {
+                //Late even though it is the freshest frame, continue the schedule from now
+                iNextFrameTime = timerStream.elapsed();
             }
 
-            if(iSampleCtr % m_iAverageSamples == 0) {
-                //Perform the actual interpolation and send signal
-                t_vecAverage /= (double)m_iAverageSamples;
-                emit newRtData(generateColorsFromSensorValues(t_vecAverage));
-                t_vecAverage.setZero(t_vecAverage.rows());                
+            emit newRtData(arrayColors);
 
-                //Sleep specified amount of time
-                const int timerelap = timer.elapsed();
-                const int iTimeLeft = m_iMSecIntervall - timerelap;
+            iNumFrames++;
+            iNextFrameTime += iInterval;
+        }
 
-                //reset sample counter
-                iSampleCtr = 0;
+        //Report the scheduler statistics
+        if(timerReport.elapsed() >= RTSENSORDATAWORKER_TIMING_INTERVAL_MSEC) {
+            const double dQueueLag = dQueueLagSum / iNumBatches;
+            const double dNumProcessedFrames = qMax(1, iNumProcessedFrames);
 
-                //qDebug()<<"elapsed"<<timerelap<<"diff"<<iTimeLeft;
-                if(iTimeLeft > 0) {
-                    QThread::msleep(iTimeLeft);
-                }
+            if(bTimingLogging) {
+                qDebug() << "RtSensorDataWorker::run - frames" << iNumFrames << "skipped" << iNumSkippedFrames << "queue lag" << dQueueLag << "ms"
+                         << "average" << dAverageTime / dNumProcessedFrames << "ms interpolation" << dInterpolationTime / dNumProcessedFrames << "ms"
+                         << "color" << dColorTime / dNumProcessedFrames << "ms per frame";
             }
 
-            m_qMutex.unlock();
+            emit timingUpdated(dQueueLag,
+                               dAverageTime / dNumProcessedFrames,
+                               dInterpolationTime / dNumProcessedFrames,
+                               dColorTime / dNumProcessedFrames,
+                               iNumFrames,
+                               iNumSkippedFrames);
+
+            dQueueLagSum = 0.0;
+            dAverageTime = 0.0;
+            dInterpolationTime = 0.0;
+            dColorTime = 0.0;
+            iNumBatches = 0;
+            iNumProcessedFrames = 0;
+            iNumFrames = 0;
+            iNumSkippedFrames = 0;
+            timerReport.restart();
         }
+    }
+}
+
 
-        //qDebug()<<"m_lData.size()"<<m_lData.size();
+//*************************************************************************************************************
+
+void RtSensorDataWorker::takeNextFrame(MatrixXf& matSamples, int iFirstCol, int iAverageSamples)
+{
+    matSamples.middleCols(iFirstCol, iAverageSamples).setZero();
+
+    for(int i = 0; i < iAverageSamples && !m_lDataQ.isEmpty(); ++i) {
+        if(m_bIsLooping) {
+            //Set iterator back to the front if needed
+            if(m_itCurrentSample == m_lDataQ.cend()) {
+                m_itCurrentSample = m_lDataQ.cbegin();
+            }
+
+            if(m_itCurrentSample->rows() == matSamples.rows()) {
+                matSamples.col(iFirstCol + i) = m_itCurrentSample->cast<float>();
+            }
+
+            ++m_itCurrentSample;
+        } else {
+            if(m_lDataQ.front().rows() == matSamples.rows()) {
+                matSamples.col(iFirstCol + i) = m_lDataQ.front().cast<float>();
+            }
+
+            m_lDataQ.pop_front();
+            m_itCurrentSample = m_lDataQ.cbegin();
+        }
     }
 }
 
 
 //*************************************************************************************************************
 
-MatrixX3f RtSensorDataWorker::generateColorsFromSensorValues(const VectorXd& vecSensorValues)
+void RtSensorDataWorker::skipFrames(int iNumFrames, int iAverageSamples)
 {
-    // NOTE: This function is called for every new sample point and therefore must be kept highly efficient!
-    if(vecSensorValues.rows() != m_iNumSensors) {
-        qDebug() << "RtSensorDataWorker::generateColorsFromSensorValues - Number of new vertex colors (" << vecSensorValues.rows() << ") do not match with previously set number of vertices (" << m_iNumSensors << "). Returning...";
-        MatrixX3f matColor = m_lVisualizationInfo.matOriginalVertColor;
-        return matColor;
+    if(m_lDataQ.isEmpty()) {
+        return;
     }
 
-    if(!m_bSurfaceDataIsInit) {
-        qDebug() << "RtSensorDataWorker::generateColorsFromSensorValues - Surface data was not initialized. Returning ...";
-        MatrixX3f matColor = m_lVisualizationInfo.matOriginalVertColor;
-        return matColor;
+    if(m_bIsLooping) {
+        //Skipping whole loops has no effect
+        const int iNumSamples = (qint64)iNumFrames * iAverageSamples % m_lDataQ.size();
+
+        for(int i = 0; i < iNumSamples; ++i) {
+            if(m_itCurrentSample == m_lDataQ.cend()) {
+                m_itCurrentSample = m_lDataQ.cbegin();
+            }
+
+            ++m_itCurrentSample;
+        }
+    } else {
+        for(int i = 0; i < iNumFrames * iAverageSamples && !m_lDataQ.isEmpty(); ++i) {
+            m_lDataQ.pop_front();
+        }
+
+        m_itCurrentSample = m_lDataQ.cbegin();
     }
+}
+
 
+//*************************************************************************************************************
 
-    if(!m_lInterpolationData.pWeightMatrix) {
-        qDebug() << "RtSensorDataWorker::generateColorsFromSensorValues - weight matrix is no initialized. Returning ...";
+QByteArray RtSensorDataWorker::generateColorsFromSensorValues(const MatrixXf& matInterpolatedValues, int iCol, bool bIsInterpolated)
+{
+    // NOTE: This function is called for every new sample point and therefore must be kept highly efficient!
+    if(!bIsInterpolated) {
+        return m_lVisualizationInfo.arrayOriginalVertColor;
     }
 
-    // interpolate sensor signals
-    VectorXf vecIntrpltdVals = *Interpolation::interpolateSignal(m_lInterpolationData.pWeightMatrix, vecSensorValues);
+    //Reset to original color as default. Write to the buffer which was not emitted last, so that the one which is
+    //still held by the mesh does not need to be detached.
+    m_lVisualizationInfo.iFinalVertColor = 1 - m_lVisualizationInfo.iFinalVertColor;
 
-    // Reset to original color as default
-    m_lVisualizationInfo.matFinalVertColor = m_lVisualizationInfo.matOriginalVertColor;
+    QByteArray& arrayFinalVertColor = m_lVisualizationInfo.arrayFinalVertColor[m_lVisualizationInfo.iFinalVertColor];
+    arrayFinalVertColor.resize(m_lVisualizationInfo.arrayOriginalVertColor.size());
+    memcpy(arrayFinalVertColor.data(), m_lVisualizationInfo.arrayOriginalVertColor.constData(), m_lVisualizationInfo.arrayOriginalVertColor.size());
 
     //Generate color data for vertices
-    normalizeAndTransformToColor(vecIntrpltdVals,
-                                    m_lVisualizationInfo.matFinalVertColor,
-                                    m_lVisualizationInfo.dThresholdX,
-                                    m_lVisualizationInfo.dThresholdZ,
-                                    m_lVisualizationInfo.functionHandlerColorMap);
-
-    return m_lVisualizationInfo.matFinalVertColor;
+    normalizeAndTransformToColor(matInterpolatedValues,
+                                 iCol,
+                                 arrayFinalVertColor,
+                                 m_lVisualizationInfo.dThresholdX,
+                                 m_lVisualizationInfo.dThresholdZ,
+                                 m_lVisualizationInfo.functionHandlerColorMap);
+
+    return arrayFinalVertColor;
 }
 
 
 //*************************************************************************************************************
 
-void RtSensorDataWorker::normalizeAndTransformToColor(const VectorXf& vecData,
-                                                      MatrixX3f& matFinalVertColor,
+void RtSensorDataWorker::normalizeAndTransformToColor(const MatrixXf& matData,
+                                                      int iCol,
+                                                      QByteArray& arrayFinalVertColor,
                                                       double dThresholdX,
                                                       double dThreholdZ,
                                                       QRgb (*functionHandlerColorMap)(double v))
@@ -516,18 +723,20 @@ void RtSensorDataWorker::normalizeAndTransformToColor(const VectorXf& vecData,
     //Note: This function needs to be implemented extremly efficient. That is why we have three if clauses.
     //      Otherwise we would have to check which color map to take for each vertex.
 
-    if(vecData.rows() != matFinalVertColor.rows()) {
-        qDebug() << "RtSensorDataWorker::transformDataToColor - Sizes of input data (" << vecData.rows() <<") do not match output data ("<< matFinalVertColor.rows() <<"). Returning ...";
+    if(matData.rows() != arrayFinalVertColor.size() / 4) {
+        qDebug() << "RtSensorDataWorker::transformDataToColor - Sizes of input data (" << matData.rows() <<") do not match output data ("<< arrayFinalVertColor.size() / 4 <<"). Returning ...";
         return;
     }
 
+    const float* pData = matData.data() + (qint64)iCol * matData.rows();
+    uchar* pFinalVertColor = reinterpret_cast<uchar*>(arrayFinalVertColor.data());
     float fSample;
     QRgb qRgb;
     const double dTresholdDiff = dThreholdZ - dThresholdX;
 
-    for(int r = 0; r < vecData.rows(); ++r) {
+    for(int r = 0; r < matData.rows(); ++r) {
         //Take the absolute values because the histogram threshold is also calcualted using the absolute values
-        fSample = std::fabs(vecData(r));
+        fSample = std::fabs(pData[r]);
 
         if(fSample >= dThresholdX) {
             //Check lower and upper thresholds and normalize to one
@@ -543,9 +752,11 @@ void RtSensorDataWorker::normalizeAndTransformToColor(const VectorXf& vecData,
 
             qRgb = functionHandlerColorMap(fSample);
 
-            matFinalVertColor(r,0) = (float)qRed(qRgb)/255.0f;
-            matFinalVertColor(r,1) = (float)qGreen(qRgb)/255.0f;
-            matFinalVertColor(r,2) = (float)qBlue(qRgb)/255.0f;
+            //8-bit RGBA as used by the CustomMesh color attribute
+            pFinalVertColor[4*r] = qRed(qRgb);
+            pFinalVertColor[4*r + 1] = qGreen(qRgb);
+            pFinalVertColor[4*r + 2] = qBlue(qRgb);
+            pFinalVertColor[4*r + 3] = 255;
         }
     }
 }
@@ -54,9 +54,11 @@
 
 #include <QThread>
 #include <QMutex>
+#include <QWaitCondition>
 #include <QVector3D>
 #include <QSharedPointer>
 #include <QLinkedList>
+#include <QByteArray>
 
 
 //*************************************************************************************************************
@@ -89,14 +91,15 @@ namespace DISP3DLIB
 //=============================================================================================================
 
 /**
-* The struct specifing visualization info.
+* The struct specifing the sensor visualization info.
 */
-struct VisualizationInfo {
+struct SensorVisualizationInfo {
     double                      dThresholdX;
     double                      dThresholdZ;
 
-    MatrixX3f                   matOriginalVertColor;
-    MatrixX3f                   matFinalVertColor;
+    QByteArray                  arrayOriginalVertColor;     /**< The surface colors in 8-bit RGBA format. */
+    QByteArray                  arrayFinalVertColor[2];     /**< The two alternately written final colors in 8-bit RGBA format. */
+    int                         iFinalVertColor;            /**< The index of the final colors which are currently written. */
 
     QRgb (*functionHandlerColorMap)(double v);
 };
@@ -111,6 +114,7 @@ struct InterpolationData {
     double                                  dCancelDistance;                  /**< Cancel distance for the interpolaion in meters. */
     
     QSharedPointer<SparseMatrix<double> >   pWeightMatrix;                    /**< Weight matrix that holds all coefficients for a signal interpolation. */
+    QSharedPointer<const SparseMatrix<float> > pWeightMatrixFloat;            /**< Single precision copy of the weight matrix used for the batched interpolation. It is replaced, never modified, so the worker can use it without holding the lock. */
     QSharedPointer<MatrixXd>                pDistanceMatrix;                  /**< Distance matrix that holds distances from sensors positions to the near vertices in meters. */
     QSharedPointer<QVector<qint32>>         pVecMappedSubset;                 /**< Vector index position represents the id of the sensor and the qint in each cell is the vertex it is mapped to. */
 
@@ -268,6 +272,15 @@ public:
     */
     void updateBadChannels(const FIFFLIB::FiffInfo& info);
 
+    //=========================================================================================================
+    /**
+    * Turns printing of the queue lag and timing statistics to the debug output on or off. The statistics are
+    * emitted via timingUpdated() regardless of this setting.
+    *
+    * @param[in] bEnabled             Whether to print the timing statistics.
+    */
+    void setTimingLogging(bool bEnabled);
+
     //=========================================================================================================
     /**
     * Sets the running flag to false and waits for the worker to stop.
@@ -293,23 +306,49 @@ private:
     /**
      * @brief normalizeAndTransformToColor  This method normalizes final values for all vertices of the mesh and converts them to rgb using the specified color converter
      *
-     * @param[in] vecData                       The final values for each vertex of the surface
-     * @param[in,out] matFinalVertColor         The color matrix which the results are to be written to
+     * @param[in] matData                       The final values for each vertex of the surface, one column per time point
+     * @param[in] iCol                          The column (time point) to transform
+     * @param[in,out] arrayFinalVertColor       The 8-bit RGBA colors which the results are to be written to
      * @param[in] dThresholdX                   Lower threshold for normalizing
      * @param[in] dThreholdZ                    Upper threshold for normalizing
      * @param[in] functionHandlerColorMap       The pointer to the function which converts scalar values to rgb
      */
-    void normalizeAndTransformToColor(const VectorXf& vecData, MatrixX3f& matFinalVertColor, double dThresholdX, double dThreholdZ, QRgb (*functionHandlerColorMap)(double v));
+    void normalizeAndTransformToColor(const MatrixXf& matData, int iCol, QByteArray& arrayFinalVertColor, double dThresholdX, double dThreholdZ, QRgb (*functionHandlerColorMap)(double v));
 
     //=========================================================================================================
     /**
-     * @brief generateColorsFromSensorValues        Produces the final color matrix that is to be emitted
+     * @brief generateColorsFromSensorValues        Produces the final colors for one time point of a batch. The colors are
+     *                                              written alternately to one of two buffers, so that the buffer which is
+     *                                              still held by the mesh does not need to be detached.
      *
-     * @param[in] vecSensorValues                   A vector of sensor signals
+     * @param[in] matInterpolatedValues             The interpolated values, one column per time point
+     * @param[in] iCol                              The column (time point) to generate the colors for
+     * @param[in] bIsInterpolated                   Whether the interpolation succeeded. If not, the original colors are returned.
      *
-     * @return The final color values for the underlying mesh surface
+     * @return The final colors for the underlying mesh surface in 8-bit RGBA format
      */
-    Eigen::MatrixX3f generateColorsFromSensorValues(const Eigen::VectorXd& vecSensorValues);
+    QByteArray generateColorsFromSensorValues(const Eigen::MatrixXf& matInterpolatedValues, int iCol, bool bIsInterpolated);
+
+    //=========================================================================================================
+    /**
+     * Copies the samples of the next frame, i.e. the next iAverageSamples samples, into the batch. In stream mode
+     * the samples are removed from the queue, in loop mode the current sample iterator is advanced. Samples which
+     * are missing or do not match the number of rows are set to zero.
+     *
+     * @param[in,out] matSamples                    The batch of samples.
+     * @param[in] iFirstCol                         The first column to write the samples to.
+     * @param[in] iAverageSamples                   The number of samples per frame.
+     */
+    void takeNextFrame(Eigen::MatrixXf& matSamples, int iFirstCol, int iAverageSamples);
+
+    //=========================================================================================================
+    /**
+     * Drops the next frames without processing them. Used to skip stale frames which are already too late to be displayed.
+     *
+     * @param[in] iNumFrames                        The number of frames to drop.
+     * @param[in] iAverageSamples                   The number of samples per frame.
+     */
+    void skipFrames(int iNumFrames, int iAverageSamples);
 
     //=========================================================================================================
     /**
@@ -320,6 +359,7 @@ private:
 
     //=========================================================================================================
     QMutex                                              m_qMutex;                           /**< The thread's mutex. */
+    QWaitCondition                                      m_qWaitData;                        /**< Wakes the idle thread when new data arrives or it is stopped. */
 
     QLinkedList<Eigen::VectorXd>                        m_lDataQ;                            /**< List that holds the fiff matrix data <n_channels x n_samples>. */
     QLinkedList<Eigen::VectorXd>::const_iterator        m_itCurrentSample;                  /**< Iterator to current sample which is/was streamed. */
@@ -331,10 +371,12 @@ private:
     int                                                 m_iNumSensors;                      /**< Number of sensors that this worker does expect when receiving rt data. */
     int                                                 m_iAverageSamples;                  /**< Number of average to compute. */
     int                                                 m_iMSecIntervall;                   /**< Length in milli Seconds to wait inbetween data samples. */
+
+    bool                                                m_bTimingLogging;                   /**< Flag whether the timing statistics are printed to the debug output. */
     
     double                                              m_dSFreq;                           /**< The current sampling frequency. */
 
-    VisualizationInfo                                   m_lVisualizationInfo;               /**< Container for the visualization info. */
+    SensorVisualizationInfo                             m_lVisualizationInfo;               /**< Container for the visualization info. */
 
     InterpolationData                                   m_lInterpolationData;               /**< Container for the interpolation data. */
     
@@ -343,9 +385,27 @@ signals:
     /**
     * Emit this signal whenever this item should send new colors to its listeners.
     *
-    * @param[in] colorMatrix     The samples data in form of rgb colors for the mesh.
+    * @param[in] arrayColorsRGBA8   The samples data in form of 8-bit RGBA colors for the mesh.
+    */
+    void newRtData(const QByteArray &arrayColorsRGBA8);
+
+    //=========================================================================================================
+    /**
+    * Emitted once per second with the scheduler statistics.
+    *
+    * @param[in] dQueueLag              The mean amount of queued, not yet displayed data in milli seconds.
+    * @param[in] dAverageTime           The mean time to average one frame in milli seconds.
+    * @param[in] dInterpolationTime     The mean time to interpolate one frame in milli seconds.
+    * @param[in] dColorTime             The mean time to transform one frame to colors in milli seconds.
+    * @param[in] iNumFrames             The number of displayed frames.
+    * @param[in] iNumSkippedFrames      The number of frames which were dropped because they were too late.
     */
-    void newRtData(const Eigen::MatrixX3f &colorMatrix);
+    void timingUpdated(double dQueueLag,
+                       double dAverageTime,
+                       double dInterpolationTime,
+                       double dColorTime,
+                       int iNumFrames,
+                       int iNumSkippedFrames);
 };
 
 } // NAMESPACE
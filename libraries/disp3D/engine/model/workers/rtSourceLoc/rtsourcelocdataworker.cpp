@@ -40,6 +40,7 @@
 
 #include "rtsourcelocdataworker.h"
 #include "../../items/common/types.h"
+#include "../../3dhelpers/custommesh.h"
 
 #include <disp/helpers/colormap.h>
 #include <utils/ioutils.h>
@@ -47,6 +48,9 @@
 #include <fs/annotation.h>
 
 #include <iostream>
+#include <cstring>
+#include <vector>
+#include <algorithm>
 
 
 //*************************************************************************************************************
@@ -58,6 +62,8 @@
 #include <QList>
 #include <QSharedPointer>
 #include <QTime>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QDebug>
 #include <QtConcurrent>
 
@@ -82,6 +88,15 @@ using namespace FSLIB;
 using namespace UTILSLIB;
 
 
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINES
+//=============================================================================================================
+
+#define RTSOURCELOCDATAWORKER_BATCH_SIZE            8       /**< Maximum number of frames which are smoothed at once. */
+#define RTSOURCELOCDATAWORKER_MAX_LAG_MSEC          100     /**< Queued data which can not be displayed within this time is dropped in stream mode. */
+
+
 //*************************************************************************************************************
 //=============================================================================================================
 // DEFINE GLOBAL METHODS
@@ -167,56 +182,67 @@ void generateSmoothOperator(SmoothOperatorInfo& input)
 
 //*************************************************************************************************************
 
-void transformDataToColor(const VectorXd& data, MatrixX3f& matFinalVertColor, double dTrehsoldX, double dTrehsoldZ, QRgb (*functionHandlerColorMap)(double v))
+inline void setVertColor(uchar* pVertColor, int iVertIdx, QRgb qRgb)
+{
+    //8-bit RGBA as used by the CustomMesh color attribute
+    pVertColor[4*iVertIdx] = qRed(qRgb);
+    pVertColor[4*iVertIdx + 1] = qGreen(qRgb);
+    pVertColor[4*iVertIdx + 2] = qBlue(qRgb);
+    pVertColor[4*iVertIdx + 3] = 255;
+}
+
+
+//*************************************************************************************************************
+
+void transformDataToColor(const MatrixXf& matData,
+                          int iCol,
+                          const VectorXi& vecVertIdx,
+                          QByteArray& arrayFinalVertColor,
+                          double dTrehsoldX,
+                          double dTrehsoldZ,
+                          QRgb (*functionHandlerColorMap)(double v))
 {
     //Note: This function needs to be implemented extremley efficient. That is why we have three if clauses.
     //      Otherwise we would have to check which color map to take for each vertex.
-    //QElapsedTimer timer;
-    //timer.start();
-
-    if(data.rows() != matFinalVertColor.rows()) {
-        qDebug() << "RtSourceLocDataWorker::transformDataToColor - Sizes of input data (" <<data.rows() <<") do not match output data ("<< matFinalVertColor.rows() <<"). Returning ...";
+    if(matData.rows() != vecVertIdx.rows() || matData.rows() != arrayFinalVertColor.size() / 4) {
+        qDebug() << "RtSourceLocDataWorker::transformDataToColor - Sizes of input data (" <<matData.rows() <<") do not match output data ("<< arrayFinalVertColor.size() / 4 <<"). Returning ...";
+        return;
     }
 
+    const float* pData = matData.data() + (qint64)iCol * matData.rows();
+    uchar* pFinalVertColor = reinterpret_cast<uchar*>(arrayFinalVertColor.data());
     float dSample;
     QRgb qRgb;
     double dTresholdDiff = dTrehsoldZ - dTrehsoldX;
 
-    for(int r = 0; r < data.rows(); ++r) {
+    for(int r = 0; r < matData.rows(); ++r) {
         //Take the absolute values because the histogram threshold is also calcualted using the absolute values
-        dSample = std::fabs(data(r));
+        dSample = std::fabs(pData[r]);
 
         if(dSample >= dTrehsoldX) {
             //Check lower and upper thresholds and normalize to one
             if(dSample >= dTrehsoldZ) {
                 dSample = 1.0;
-            } else if(dSample < dTrehsoldX) {
-                dSample = 0.0;
             } else {
                 if(dTresholdDiff != 0.0) {
                     dSample = (dSample - dTrehsoldX) / (dTresholdDiff);
                 } else {
                     dSample = 0.0f;
                 }
-
             }
 
             qRgb = functionHandlerColorMap(dSample);
 
-            matFinalVertColor(r,0) = (float)qRed(qRgb)/255.0f;
-            matFinalVertColor(r,1) = (float)qGreen(qRgb)/255.0f;
-            matFinalVertColor(r,2) = (float)qBlue(qRgb)/255.0f;
+            //The rows of the smoothing operator are sorted, look up the vertex they belong to
+            setVertColor(pFinalVertColor, vecVertIdx(r), qRgb);
         }
     }
-
-    //int elapsed = timer.elapsed();
-    //qDebug()<<"RtSourceLocDataWorker::transformDataToColor - elapsed"<<elapsed;
 }
 
 
 //*************************************************************************************************************
 
-void transformDataToColor(float fSample, QColor& finalVertColor, double dTrehsoldX, double dTrehsoldZ, QRgb (*functionHandlerColorMap)(double v))
+QRgb transformDataToColor(float fSample, double dTrehsoldX, double dTrehsoldZ, QRgb (*functionHandlerColorMap)(double v))
 {
     //Note: This function needs to be implemented extremley efficient. That is why we have three if clauses.
     //      Otherwise we would have to check which color map to take for each vertex.
@@ -235,12 +261,7 @@ void transformDataToColor(float fSample, QColor& finalVertColor, double dTrehsol
         }
     }
 
-    QRgb qRgb;
-    qRgb = (functionHandlerColorMap)(fSample);
-
-    finalVertColor.setRedF((float)qRed(qRgb)/255.0f);
-    finalVertColor.setGreenF((float)qGreen(qRgb)/255.0f);
-    finalVertColor.setBlueF((float)qBlue(qRgb)/255.0f);
+    return (functionHandlerColorMap)(fSample);
 }
 
 
@@ -248,16 +269,15 @@ void transformDataToColor(float fSample, QColor& finalVertColor, double dTrehsol
 
 void generateColorsPerVertex(VisualizationInfo& input)
 {
-    QColor color;
+    uchar* pFinalVertColor = reinterpret_cast<uchar*>(input.arrayFinalVertColor[input.iFinalVertColor].data());
+    const float* pSourceColorSamples = input.matSourceColorSamples.data() + (qint64)input.iFrame * input.matSourceColorSamples.rows();
 
     //Fill final QByteArray with colors based on the current anatomical information
     for(int i = 0; i < input.vVertNo.rows(); ++i) {
-        if(input.vSourceColorSamples(i) >= input.dThresholdX) {
-            transformDataToColor(input.vSourceColorSamples(i), color, input.dThresholdX, input.dThresholdZ, input.functionHandlerColorMap);
-
-            input.matFinalVertColor(input.vVertNo(i),0) = color.redF();
-            input.matFinalVertColor(input.vVertNo(i),1) = color.greenF();
-            input.matFinalVertColor(input.vVertNo(i),2) = color.blueF();
+        if(pSourceColorSamples[i] >= input.dThresholdX) {
+            setVertColor(pFinalVertColor,
+                         input.vVertNo(i),
+                         transformDataToColor(pSourceColorSamples[i], input.dThresholdX, input.dThresholdZ, input.functionHandlerColorMap));
         }
     }
 }
@@ -265,34 +285,53 @@ void generateColorsPerVertex(VisualizationInfo& input)
 
 //*************************************************************************************************************
 
-void generateColorsPerAnnotation(VisualizationInfo& input)
+void poolLabelActivation(VisualizationInfo& input)
 {
-    //Find maximum actiavtion for each label
-    QMap<qint32, double> vecLabelActivation;
+    //Find the activation with the maximum absolute value for each label and frame
+    const SparseMatrix<float, RowMajor>& matLabelPooling = input.matLabelPooling;
+    const MatrixXf& matSourceColorSamples = input.matSourceColorSamples;
+
+    input.matLabelActivation.resize(matLabelPooling.rows(), matSourceColorSamples.cols());
+
+    for(int c = 0; c < matSourceColorSamples.cols(); ++c) {
+        const float* pSourceColorSamples = matSourceColorSamples.data() + (qint64)c * matSourceColorSamples.rows();
+
+        for(int l = 0; l < matLabelPooling.outerSize(); ++l) {
+            float fActivation = 0.0f;
 
-    for(int i = 0; i < input.vSourceColorSamples.rows(); ++i) {
-        //Find out label for source
-        qint32 labelIdx = input.mapLabelIdSources[input.vVertNo(i)];
+            for(SparseMatrix<float, RowMajor>::InnerIterator it(matLabelPooling, l); it; ++it) {
+                const float fSample = it.value() * pSourceColorSamples[it.col()];
 
-        if(std::fabs(input.vSourceColorSamples(i)) > std::fabs(vecLabelActivation[labelIdx]))
-            vecLabelActivation.insert(labelIdx, input.vSourceColorSamples(i));
+                if(std::fabs(fSample) > std::fabs(fActivation)) {
+                    fActivation = fSample;
+                }
+            }
+
+            input.matLabelActivation(l, c) = fActivation;
+        }
     }
+}
 
-    //Color all labels respectivley to their activation
-    QColor color;
 
-    for(int i = 0; i<input.lLabels.size(); i++) {
-        FSLIB::Label label = input.lLabels.at(i);
+//*************************************************************************************************************
+
+void generateColorsPerAnnotation(VisualizationInfo& input)
+{
+    //Color all labels respectivley to their activation
+    uchar* pFinalVertColor = reinterpret_cast<uchar*>(input.arrayFinalVertColor[input.iFinalVertColor].data());
+    const float* pLabelActivation = input.matLabelActivation.data() + (qint64)input.iFrame * input.matLabelActivation.rows();
+    QRgb qRgb;
 
+    for(int i = 0; i < input.lLabelVertices.size(); ++i) {
         //Transform label activations to rgb colors
         //Check if value is bigger than lower threshold. If not, don't plot activation
-        if(vecLabelActivation[label.label_id] >= input.dThresholdX) {
-            transformDataToColor(std::fabs(vecLabelActivation[label.label_id]), color, input.dThresholdX, input.dThresholdZ, input.functionHandlerColorMap);
+        if(pLabelActivation[i] >= input.dThresholdX) {
+            qRgb = transformDataToColor(std::fabs(pLabelActivation[i]), input.dThresholdX, input.dThresholdZ, input.functionHandlerColorMap);
+
+            const VectorXi& vecVertices = input.lLabelVertices.at(i);
 
-            for(int j = 0; j<label.vertices.rows(); j++) {
-                input.matFinalVertColor(label.vertices(j),0) = color.redF();
-                input.matFinalVertColor(label.vertices(j),1) = color.greenF();
-                input.matFinalVertColor(label.vertices(j),2) = color.blueF();
+            for(int j = 0; j < vecVertices.rows(); ++j) {
+                setVertColor(pFinalVertColor, vecVertices(j), qRgb);
             }
         }
     }
@@ -301,11 +340,8 @@ void generateColorsPerAnnotation(VisualizationInfo& input)
 
 //*************************************************************************************************************
 
-void generateSmoothedColors(VisualizationInfo& input)
+void smoothSourceSamples(VisualizationInfo& input)
 {
-    //QTime prodDataTimer;
-    //prodDataTimer.start();
-
 //    //Option 1 - Use Matti's version. Smoothes between different source "patches".
 //    //Activity is spread evenly around every source and then smoothed to neighboring source patches.
 //    //Init the variables
@@ -365,14 +401,100 @@ void generateSmoothedColors(VisualizationInfo& input)
 //        }
 //    }
 
-    //Option 2 - Inverse weighted distance smoothing operator
-    VectorXd smooth_val = input.matWDistSmooth * input.vSourceColorSamples;
+    //Option 2 - Inverse weighted distance smoothing operator. All frames of the batch are smoothed at once.
+    input.matSmoothedSamples.noalias() = input.matWDistSmooth * input.matSourceColorSamples;
+}
+
 
+//*************************************************************************************************************
+
+void generateSmoothedColors(VisualizationInfo& input)
+{
     //Produce final color
-    transformDataToColor(smooth_val, input.matFinalVertColor, input.dThresholdX, input.dThresholdZ, input.functionHandlerColorMap);
+    transformDataToColor(input.matSmoothedSamples,
+                         input.iFrame,
+                         input.vecSmoothVertIdx,
+                         input.arrayFinalVertColor[input.iFinalVertColor],
+                         input.dThresholdX,
+                         input.dThresholdZ,
+                         input.functionHandlerColorMap);
+}
 
-    //int iAllTimer = allTimer.elapsed();
-    //qDebug() << "All time" << iAllTimer;
+
+//*************************************************************************************************************
+
+void sortSmoothOperator(const SparseMatrix<double>& matWDistSmooth, VisualizationInfo& info)
+{
+    //Sort the rows by their first source, so that neighboring rows read neighboring source values during the
+    //smoothing. Vertices without any source in reach are moved to the end.
+    VectorXi vecFirstSource = VectorXi::Constant(matWDistSmooth.rows(), matWDistSmooth.cols());
+
+    for(int k = matWDistSmooth.outerSize() - 1; k >= 0; --k) {
+        for(SparseMatrix<double>::InnerIterator it(matWDistSmooth, k); it; ++it) {
+            vecFirstSource(it.row()) = k;
+        }
+    }
+
+    std::vector<int> vecOrder(matWDistSmooth.rows());
+    for(int i = 0; i < matWDistSmooth.rows(); ++i) {
+        vecOrder[i] = i;
+    }
+
+    std::stable_sort(vecOrder.begin(), vecOrder.end(), [&vecFirstSource](int i, int j) {
+        return vecFirstSource(i) < vecFirstSource(j);
+    });
+
+    VectorXi vecSortedRow(matWDistSmooth.rows());
+    info.vecSmoothVertIdx.resize(matWDistSmooth.rows());
+
+    for(int i = 0; i < matWDistSmooth.rows(); ++i) {
+        vecSortedRow(vecOrder[i]) = i;
+        info.vecSmoothVertIdx(i) = vecOrder[i];
+    }
+
+    //Store as single precision CSR
+    std::vector<Eigen::Triplet<float> > lTriplets;
+    lTriplets.reserve(matWDistSmooth.nonZeros());
+
+    for(int k = 0; k < matWDistSmooth.outerSize(); ++k) {
+        for(SparseMatrix<double>::InnerIterator it(matWDistSmooth, k); it; ++it) {
+            lTriplets.push_back(Eigen::Triplet<float>(vecSortedRow(it.row()), it.col(), it.value()));
+        }
+    }
+
+    info.matWDistSmooth.resize(matWDistSmooth.rows(), matWDistSmooth.cols());
+    info.matWDistSmooth.setFromTriplets(lTriplets.begin(), lTriplets.end());
+    info.matWDistSmooth.makeCompressed();
+}
+
+
+//*************************************************************************************************************
+
+void createLabelPoolingOperator(const VectorXi& vecLabelIds, const QList<FSLIB::Label>& lLabels, VisualizationInfo& info)
+{
+    //One row per label and one column per source
+    QHash<qint32, int> hashLabelRow;
+    info.lLabelVertices.resize(lLabels.size());
+
+    for(int i = 0; i < lLabels.size(); ++i) {
+        hashLabelRow.insert(lLabels.at(i).label_id, i);
+        info.lLabelVertices[i] = lLabels.at(i).vertices;
+    }
+
+    std::vector<Eigen::Triplet<float> > lTriplets;
+    lTriplets.reserve(info.vVertNo.rows());
+
+    for(int i = 0; i < info.vVertNo.rows(); ++i) {
+        QHash<qint32, int>::const_iterator it = hashLabelRow.constFind(vecLabelIds(info.vVertNo(i)));
+
+        if(it != hashLabelRow.constEnd()) {
+            lTriplets.push_back(Eigen::Triplet<float>(it.value(), i, 1.0f));
+        }
+    }
+
+    info.matLabelPooling.resize(lLabels.size(), info.vVertNo.rows());
+    info.matLabelPooling.setFromTriplets(lTriplets.begin(), lTriplets.end());
+    info.matLabelPooling.makeCompressed();
 }
 
 
@@ -395,6 +517,10 @@ RtSourceLocDataWorker::RtSourceLocDataWorker(QObject* parent)
     m_lVisualizationInfo << VisualizationInfo() << VisualizationInfo();
     m_lVisualizationInfo[0].functionHandlerColorMap = ColorMap::valueToHot;
     m_lVisualizationInfo[1].functionHandlerColorMap = ColorMap::valueToHot;
+    m_lVisualizationInfo[0].iFinalVertColor = 0;
+    m_lVisualizationInfo[1].iFinalVertColor = 0;
+    m_lVisualizationInfo[0].iFrame = 0;
+    m_lVisualizationInfo[1].iFrame = 0;
 }
 
 
@@ -476,8 +602,9 @@ void RtSourceLocDataWorker::setSurfaceColor(const MatrixX3f& matSurfaceVertColor
         return;
     }
 
-    m_lVisualizationInfo[0].matOriginalVertColor = matSurfaceVertColorLeftHemi;
-    m_lVisualizationInfo[1].matOriginalVertColor = matSurfaceVertColorRightHemi;
+    //Pack once to the format of the mesh color buffer, so that every new frame can start from a plain copy
+    CustomMesh::colorsToRGBA8(matSurfaceVertColorLeftHemi, m_lVisualizationInfo[0].arrayOriginalVertColor);
+    CustomMesh::colorsToRGBA8(matSurfaceVertColorRightHemi, m_lVisualizationInfo[1].arrayOriginalVertColor);
 }
 
 
@@ -495,17 +622,9 @@ void RtSourceLocDataWorker::setAnnotationData(const Eigen::VectorXi& vecLabelIds
         return;
     }
 
-    m_lVisualizationInfo[0].lLabels = lLabelsLeftHemi;
-    m_lVisualizationInfo[1].lLabels = lLabelsRightHemi;
-
-    //Generate fast lookup map for each source and corresponding label
-    for(qint32 i = 0; i < m_lVisualizationInfo[0].vVertNo.rows(); ++i) {
-        m_lVisualizationInfo[0].mapLabelIdSources.insert(m_lVisualizationInfo[0].vVertNo(i), vecLabelIdsLeftHemi(m_lVisualizationInfo[0].vVertNo(i)));
-    }
-
-    for(qint32 i = 0; i < m_lVisualizationInfo[1].vVertNo.rows(); ++i) {
-        m_lVisualizationInfo[1].mapLabelIdSources.insert(m_lVisualizationInfo[1].vVertNo(i), vecLabelIdsRightHemi(m_lVisualizationInfo[1].vVertNo(i)));
-    }
+    //Generate the pooling operator which maps each source to its label
+    createLabelPoolingOperator(vecLabelIdsLeftHemi, lLabelsLeftHemi, m_lVisualizationInfo[0]);
+    createLabelPoolingOperator(vecLabelIdsRightHemi, lLabelsRightHemi, m_lVisualizationInfo[1]);
 
     m_bAnnotationDataIsInit = true;
 }
@@ -621,132 +740,243 @@ void RtSourceLocDataWorker::stop()
 
 void RtSourceLocDataWorker::run()
 {
-    VectorXd t_vecAverage;
+    MatrixXf matSourceColorSamples;
+
+    QElapsedTimer timerStream;
+    qint64 iNextFrameTime = 0;
 
-    uint iSampleCtr = 0;
+    m_qMutex.lock();
     m_bIsRunning = true;
+    m_qMutex.unlock();
+
+    timerStream.start();
 
     while(true) {
-        QTime timer;
-        timer.start();
+        m_qMutex.lock();
 
-        {
-            QMutexLocker locker(&m_qMutex);
-            if(!m_bIsRunning)
-                break;
+        if(!m_bIsRunning) {
+            m_qMutex.unlock();
+            break;
+        }
+
+        const int iAverageSamples = qMax(1, m_iAverageSamples);
+        const int iInterval = m_iMSecIntervall;
+
+        //In loop mode there are always frames available as long as there is data
+        int iNumAvailable;
+        if(m_bIsLooping) {
+            iNumAvailable = m_lDataQ.isEmpty() ? 0 : RTSOURCELOCDATAWORKER_BATCH_SIZE;
+        } else {
+            iNumAvailable = m_lDataQ.size() / iAverageSamples;
         }
 
-        bool doProcessing = false;
+        if(iNumAvailable == 0) {
+            m_qMutex.unlock();
 
-        {
-            QMutexLocker locker(&m_qMutex);
-            if(m_lDataQ.size() > 0)
-                doProcessing = true;
+            //Nothing to display, restart the schedule once new data arrives
+            iNextFrameTime = timerStream.elapsed();
+            QThread::msleep(1);
+            continue;
         }
 
-        if(doProcessing) {
-            if(m_bIsLooping) {
-                m_qMutex.lock();
+        //Drop the frames the display can not show anymore before spending time on smoothing them. In stream mode
+        //the newest frame is always kept.
+        const qint64 iNow = timerStream.elapsed();
+        int iNumSkip = 0;
 
-                //Down sampling in loop mode
-                if(t_vecAverage.rows() != m_lDataQ.front().rows()) {
-                    t_vecAverage = *m_itCurrentSample;
-                } else {
-                    t_vecAverage += *m_itCurrentSample;
-                }
+        if(iInterval > 0) {
+            if(iNow - iNextFrameTime >= iInterval) {
+                iNumSkip = (iNow - iNextFrameTime) / iInterval;
+            }
 
-                m_qMutex.unlock();
-            } else {
-                m_qMutex.lock();
+            if(!m_bIsLooping) {
+                const int iMaxQueuedFrames = qMax(1, RTSOURCELOCDATAWORKER_MAX_LAG_MSEC / iInterval);
+                iNumSkip = qMax(iNumSkip, iNumAvailable - iMaxQueuedFrames);
+                iNumSkip = qMin(iNumSkip, iNumAvailable - 1);
+            }
+        }
 
-                //Down sampling in stream mode
-                if(t_vecAverage.rows() != m_lDataQ.front().rows()) {
-                    t_vecAverage = m_lDataQ.front();
-                } else {
-                    t_vecAverage += m_lDataQ.front();
-                }
+        if(iNumSkip > 0) {
+            skipFrames(iNumSkip, iAverageSamples);
+            iNextFrameTime += (qint64)iNumSkip * iInterval;
+        }
+
+        if(iNextFrameTime < iNow - iInterval) {
+            iNextFrameTime = iNow;
+        }
 
-                m_lDataQ.pop_front();
+        const int iBatchSize = qMin(m_bIsLooping ? iNumAvailable : iNumAvailable - iNumSkip, RTSOURCELOCDATAWORKER_BATCH_SIZE);
+
+        //Average the frames of this batch, one column per frame, and smooth them at once
+        matSourceColorSamples.resize(m_lDataQ.front().rows(), iBatchSize);
+
+        for(int i = 0; i < iBatchSize; ++i) {
+            averageNextFrame(matSourceColorSamples, i, iAverageSamples);
+        }
 
+        const bool bIsValid = performBatchCalculation(matSourceColorSamples);
+
+        m_qMutex.unlock();
+
+        //Transform to colors and emit each frame at its display time
+        for(int i = 0; i < iBatchSize; ++i) {
+            m_qMutex.lock();
+
+            if(!m_bIsRunning) {
                 m_qMutex.unlock();
+                break;
             }
 
-            m_qMutex.lock();
+            QPair<QByteArray, QByteArray> colorPair = performVisualizationTypeCalculation(i, bIsValid);
+
+            m_qMutex.unlock();
+
+            const qint64 iTimeLeft = iNextFrameTime - timerStream.elapsed();
+            if(iTimeLeft > 0) {
+                QThread::msleep(iTimeLeft);
+            }
+
+            emit newRtData(colorPair);
+
+            iNextFrameTime += iInterval;
+        }
+    }
+}
+
 
-            m_itCurrentSample++;
-            iSampleCtr++;
+//*************************************************************************************************************
+
+void RtSourceLocDataWorker::averageNextFrame(MatrixXf& matSourceColorSamples, int iCol, int iAverageSamples)
+{
+    matSourceColorSamples.col(iCol).setZero();
 
+    for(int i = 0; i < iAverageSamples && !m_lDataQ.isEmpty(); ++i) {
+        if(m_bIsLooping) {
             //Set iterator back to the front if needed
-            if(m_itCurrentSample == m_lDataQ.cend())
-            {
+            if(m_itCurrentSample == m_lDataQ.cend()) {
                 m_itCurrentSample = m_lDataQ.cbegin();
             }
 
-            if(iSampleCtr % m_iAverageSamples == 0) {
-                //Perform the actual interpolation and send signal
-                t_vecAverage /= (double)m_iAverageSamples;
+            if(m_itCurrentSample->rows() == matSourceColorSamples.rows()) {
+                matSourceColorSamples.col(iCol) += m_itCurrentSample->cast<float>();
+            }
 
-                emit newRtData(performVisualizationTypeCalculation(t_vecAverage));
-                t_vecAverage = VectorXd::Zero(t_vecAverage.rows());                
+            ++m_itCurrentSample;
+        } else {
+            if(m_lDataQ.front().rows() == matSourceColorSamples.rows()) {
+                matSourceColorSamples.col(iCol) += m_lDataQ.front().cast<float>();
+            }
 
-                //Sleep specified amount of time
-                const int timerelap = timer.elapsed();
-                const int iTimeLeft = m_iMSecIntervall - timerelap;
+            m_lDataQ.pop_front();
+            m_itCurrentSample = m_lDataQ.cbegin();
+        }
+    }
 
-                //reset sample counter
-                iSampleCtr = 0;
+    matSourceColorSamples.col(iCol) /= (float)iAverageSamples;
+}
 
-                //qDebug()<<"elapsed"<<timerelap<<"diff"<<iTimeLeft;
-                if(iTimeLeft > 0) {
-                    QThread::msleep(iTimeLeft);
-                }
+
+//*************************************************************************************************************
+
+void RtSourceLocDataWorker::skipFrames(int iNumFrames, int iAverageSamples)
+{
+    if(m_lDataQ.isEmpty()) {
+        return;
+    }
+
+    if(m_bIsLooping) {
+        //Skipping whole loops has no effect
+        const int iNumSamples = (qint64)iNumFrames * iAverageSamples % m_lDataQ.size();
+
+        for(int i = 0; i < iNumSamples; ++i) {
+            if(m_itCurrentSample == m_lDataQ.cend()) {
+                m_itCurrentSample = m_lDataQ.cbegin();
             }
 
-            m_qMutex.unlock();
+            ++m_itCurrentSample;
         }
+    } else {
+        for(int i = 0; i < iNumFrames * iAverageSamples && !m_lDataQ.isEmpty(); ++i) {
+            m_lDataQ.pop_front();
+        }
+
+        m_itCurrentSample = m_lDataQ.cbegin();
     }
 }
 
 
 //*************************************************************************************************************
 
-QPair<MatrixX3f, MatrixX3f> RtSourceLocDataWorker::performVisualizationTypeCalculation(const VectorXd& vSourceColorSamples)
+bool RtSourceLocDataWorker::performBatchCalculation(const MatrixXf& matSourceColorSamples)
 {
-    //NOTE: This function is called for every new sample point and therefore must be kept highly efficient!
-//    QTime allTimer;
-//    allTimer.start();
-
-    if(vSourceColorSamples.rows() != m_lVisualizationInfo[0].vVertNo.rows() + m_lVisualizationInfo[1].vVertNo.rows()) {
-        qDebug() << "RtSourceLocDataWorker::performVisualizationTypeCalculation - Number of new vertex colors (" << vSourceColorSamples.rows() << ") do not match with previously set number of vertices (" << m_lVisualizationInfo[0].vVertNo.rows() + m_lVisualizationInfo[1].vVertNo.rows() << "). Returning...";
-        QPair<MatrixX3f, MatrixX3f> colorPair;
-        colorPair.first =  m_lVisualizationInfo[0].matOriginalVertColor;
-        colorPair.second = m_lVisualizationInfo[1].matOriginalVertColor;
-        return colorPair;
+    if(matSourceColorSamples.rows() != m_lVisualizationInfo[0].vVertNo.rows() + m_lVisualizationInfo[1].vVertNo.rows()) {
+        qDebug() << "RtSourceLocDataWorker::performBatchCalculation - Number of new vertex colors (" << matSourceColorSamples.rows() << ") do not match with previously set number of vertices (" << m_lVisualizationInfo[0].vVertNo.rows() + m_lVisualizationInfo[1].vVertNo.rows() << "). Returning...";
+        return false;
     }
 
     if(!m_bSurfaceDataIsInit) {
-        qDebug() << "RtSourceLocDataWorker::performVisualizationTypeCalculation - Surface data was not initialized. Returning ...";
-        QPair<MatrixX3f, MatrixX3f> colorPair;
-        colorPair.first =  m_lVisualizationInfo[0].matOriginalVertColor;
-        colorPair.second = m_lVisualizationInfo[1].matOriginalVertColor;
-        return colorPair;
+        qDebug() << "RtSourceLocDataWorker::performBatchCalculation - Surface data was not initialized. Returning ...";
+        return false;
     }
 
     if(!m_bAnnotationDataIsInit) {
-        qDebug() << "RtSourceLocDataWorker::performVisualizationTypeCalculation - Annotation data was not initialized. Returning ...";
-        QPair<MatrixX3f, MatrixX3f> colorPair;
-        colorPair.first =  m_lVisualizationInfo[0].matOriginalVertColor;
-        colorPair.second = m_lVisualizationInfo[1].matOriginalVertColor;
-        return colorPair;
+        qDebug() << "RtSourceLocDataWorker::performBatchCalculation - Annotation data was not initialized. Returning ...";
+        return false;
+    }
+
+    if(m_lVisualizationInfo[0].arrayOriginalVertColor.isEmpty() || m_lVisualizationInfo[1].arrayOriginalVertColor.isEmpty()) {
+        qDebug() << "RtSourceLocDataWorker::performBatchCalculation - Surface color data was not initialized. Returning ...";
+        return false;
     }
 
     //Cut out left and right hemisphere from source data
-    m_lVisualizationInfo[0].vSourceColorSamples = vSourceColorSamples.segment(0, m_lVisualizationInfo[0].vVertNo.rows());
-    m_lVisualizationInfo[1].vSourceColorSamples = vSourceColorSamples.segment(m_lVisualizationInfo[0].vVertNo.rows(), m_lVisualizationInfo[1].vVertNo.rows());
+    m_lVisualizationInfo[0].matSourceColorSamples = matSourceColorSamples.topRows(m_lVisualizationInfo[0].vVertNo.rows());
+    m_lVisualizationInfo[1].matSourceColorSamples = matSourceColorSamples.bottomRows(m_lVisualizationInfo[1].vVertNo.rows());
 
-    //Reset to original color as default
-    m_lVisualizationInfo[0].matFinalVertColor = m_lVisualizationInfo[0].matOriginalVertColor;
-    m_lVisualizationInfo[1].matFinalVertColor = m_lVisualizationInfo[1].matOriginalVertColor;
+    //Smoothing and label pooling are done for the whole batch
+    switch(m_iVisualizationType) {
+        case Data3DTreeModelItemRoles::AnnotationBased: {
+            QFuture<void> future = QtConcurrent::map(m_lVisualizationInfo, poolLabelActivation);
+            future.waitForFinished();
+
+            break;
+        }
+
+        case Data3DTreeModelItemRoles::SmoothingBased: {
+            QFuture<void> future = QtConcurrent::map(m_lVisualizationInfo, smoothSourceSamples);
+            future.waitForFinished();
+
+            break;
+        }
+    }
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+QPair<QByteArray, QByteArray> RtSourceLocDataWorker::performVisualizationTypeCalculation(int iFrame, bool bIsValid)
+{
+    //NOTE: This function is called for every new sample point and therefore must be kept highly efficient!
+    if(!bIsValid) {
+        QPair<QByteArray, QByteArray> colorPair;
+        colorPair.first =  m_lVisualizationInfo[0].arrayOriginalVertColor;
+        colorPair.second = m_lVisualizationInfo[1].arrayOriginalVertColor;
+        return colorPair;
+    }
+
+    //Reset to original color as default. Write to the buffer which was not emitted last, so that the one which is
+    //still held by the mesh does not need to be detached.
+    for(int i = 0; i < m_lVisualizationInfo.size(); ++i) {
+        VisualizationInfo& info = m_lVisualizationInfo[i];
+        info.iFinalVertColor = 1 - info.iFinalVertColor;
+        info.iFrame = iFrame;
+
+        QByteArray& arrayFinalVertColor = info.arrayFinalVertColor[info.iFinalVertColor];
+        arrayFinalVertColor.resize(info.arrayOriginalVertColor.size());
+        memcpy(arrayFinalVertColor.data(), info.arrayOriginalVertColor.constData(), info.arrayOriginalVertColor.size());
+    }
 
     //Generate color data for vertices
     switch(m_iVisualizationType) {
@@ -772,12 +1002,9 @@ QPair<MatrixX3f, MatrixX3f> RtSourceLocDataWorker::performVisualizationTypeCalcu
         }
     }
 
-//    int iAllTimer = allTimer.elapsed();
-//    qDebug() << "All time" << iAllTimer;
-
-    QPair<MatrixX3f, MatrixX3f> colorPair;
-    colorPair.first =  m_lVisualizationInfo[0].matFinalVertColor;
-    colorPair.second = m_lVisualizationInfo[1].matFinalVertColor;
+    QPair<QByteArray, QByteArray> colorPair;
+    colorPair.first =  m_lVisualizationInfo[0].arrayFinalVertColor[m_lVisualizationInfo[0].iFinalVertColor];
+    colorPair.second = m_lVisualizationInfo[1].arrayFinalVertColor[m_lVisualizationInfo[1].iFinalVertColor];
     return colorPair;
 }
 
@@ -793,8 +1020,7 @@ void RtSourceLocDataWorker::createSmoothingOperator(const MatrixX3f& matVertPosL
     QList<SmoothOperatorInfo> inputData;
 
     SmoothOperatorInfo leftHemi;
-    m_lVisualizationInfo[0].matWDistSmooth.resize(matVertPosLeftHemi.rows(), m_lVisualizationInfo[0].vVertNo.rows());
-    leftHemi.sparseSmoothMatrix = m_lVisualizationInfo[0].matWDistSmooth;
+    leftHemi.sparseSmoothMatrix.resize(matVertPosLeftHemi.rows(), m_lVisualizationInfo[0].vVertNo.rows());
     leftHemi.vecVertNo = m_lVisualizationInfo[0].vVertNo;
     leftHemi.matVertPos = matVertPosLeftHemi;
     leftHemi.iDistPow = 3;
@@ -802,8 +1028,7 @@ void RtSourceLocDataWorker::createSmoothingOperator(const MatrixX3f& matVertPosL
     inputData.append(leftHemi);
 
     SmoothOperatorInfo rightHemi;
-    m_lVisualizationInfo[1].matWDistSmooth.resize(matVertPosRightHemi.rows(), m_lVisualizationInfo[1].vVertNo.rows());
-    rightHemi.sparseSmoothMatrix = m_lVisualizationInfo[1].matWDistSmooth;
+    rightHemi.sparseSmoothMatrix.resize(matVertPosRightHemi.rows(), m_lVisualizationInfo[1].vVertNo.rows());
     rightHemi.vecVertNo = m_lVisualizationInfo[1].vVertNo;
     rightHemi.matVertPos = matVertPosRightHemi;
     rightHemi.iDistPow = 3;
@@ -813,8 +1038,8 @@ void RtSourceLocDataWorker::createSmoothingOperator(const MatrixX3f& matVertPosL
     QFuture<void> future = QtConcurrent::map(inputData, generateSmoothOperator);
     future.waitForFinished();
 
-    m_lVisualizationInfo[0].matWDistSmooth = inputData.at(0).sparseSmoothMatrix;
-    m_lVisualizationInfo[1].matWDistSmooth = inputData.at(1).sparseSmoothMatrix;
+    sortSmoothOperator(inputData.at(0).sparseSmoothMatrix, m_lVisualizationInfo[0]);
+    sortSmoothOperator(inputData.at(1).sparseSmoothMatrix, m_lVisualizationInfo[1]);
 
 //    qDebug() << "RtSourceLocDataWorker::setSmootingInfo - time needed for smooth operator creation:" << timer.elapsed();
 
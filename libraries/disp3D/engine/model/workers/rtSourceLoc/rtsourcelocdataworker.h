@@ -54,6 +54,7 @@
 #include <QMutex>
 #include <QVector3D>
 #include <QLinkedList>
+#include <QByteArray>
 
 
 //*************************************************************************************************************
@@ -113,17 +114,22 @@ struct SmoothVertexInfo {
 * The struct specifing the smoothing visualization info.
 */
 struct VisualizationInfo {
-    VectorXd                    vSourceColorSamples;
-    VectorXi                    vVertNo;
-    QList<FSLIB::Label>         lLabels;
-    QMap<qint32, qint32>        mapLabelIdSources;
-    QVector<QVector<int> >      mapVertexNeighbors;
-    SparseMatrix<double>        matWDistSmooth;
+    MatrixXf                        matSourceColorSamples;      /**< The source values of the current batch, one column per frame. */
+    MatrixXf                        matSmoothedSamples;         /**< The smoothed values of the current batch in the row order of matWDistSmooth. */
+    MatrixXf                        matLabelActivation;         /**< The pooled label activations of the current batch, one row per label. */
+    int                             iFrame;                     /**< The frame (column) of the current batch which is to be transformed to colors. */
+    VectorXi                        vVertNo;
+    QVector<VectorXi>               lLabelVertices;             /**< The surface vertices of each label, in the row order of matLabelPooling. */
+    SparseMatrix<float, RowMajor>   matLabelPooling;            /**< Maps the sources to the labels they belong to <n_labels x n_sources>. */
+    QVector<QVector<int> >          mapVertexNeighbors;
+    SparseMatrix<float, RowMajor>   matWDistSmooth;             /**< The smoothing operator in CSR format with the rows sorted by their first source. */
+    VectorXi                        vecSmoothVertIdx;           /**< The surface vertex of each row of matWDistSmooth. */
     double                      dThresholdX;
     double                      dThresholdZ;
     QRgb (*functionHandlerColorMap)(double v);
-    MatrixX3f                   matOriginalVertColor;
-    MatrixX3f                   matFinalVertColor;
+    QByteArray                  arrayOriginalVertColor;     /**< The surface colors in 8-bit RGBA format. */
+    QByteArray                  arrayFinalVertColor[2];     /**< The two alternately written final colors in 8-bit RGBA format. */
+    int                         iFinalVertColor;            /**< The index of the final colors which are currently written. */
 };
 
 //*************************************************************************************************************
@@ -288,13 +294,45 @@ protected:
 private:
     //=========================================================================================================
     /**
-    * Perfrom the needed visualization type computations.
+    * Perform the visualization type computations which can be done for several frames at once, i.e. the smoothing
+    * and the label pooling.
     *
-    * @param[in] vSourceColorSamples        The color data for the sources.
+    * @param[in] matSourceColorSamples      The source data of the batch, one column per frame.
     *
-    * @return                               Returns the final colors in for the left and right hemisphere.
+    * @return                               Returns true if the batch can be visualized, false otherwise.
     */
-    QPair<MatrixX3f, MatrixX3f> performVisualizationTypeCalculation(const Eigen::VectorXd& vSourceColorSamples);
+    bool performBatchCalculation(const Eigen::MatrixXf& matSourceColorSamples);
+
+    //=========================================================================================================
+    /**
+    * Perfrom the needed visualization type computations for one frame of the batch.
+    *
+    * @param[in] iFrame                     The frame of the batch passed to performBatchCalculation.
+    * @param[in] bIsValid                   The return value of performBatchCalculation. If false, the original colors are returned.
+    *
+    * @return                               Returns the final colors in 8-bit RGBA format for the left and right hemisphere.
+    */
+    QPair<QByteArray, QByteArray> performVisualizationTypeCalculation(int iFrame, bool bIsValid);
+
+    //=========================================================================================================
+    /**
+    * Averages the next frame, i.e. the next m_iAverageSamples samples, into a column of the batch. In stream mode
+    * the samples are removed from the queue, in loop mode the current sample iterator is advanced.
+    *
+    * @param[in,out] matSourceColorSamples  The batch of averaged source values.
+    * @param[in] iCol                       The column to write the average to.
+    * @param[in] iAverageSamples            The number of samples to average.
+    */
+    void averageNextFrame(Eigen::MatrixXf& matSourceColorSamples, int iCol, int iAverageSamples);
+
+    //=========================================================================================================
+    /**
+    * Drops the next frames before they are smoothed. Used to skip frames which are already too late to be displayed.
+    *
+    * @param[in] iNumFrames                 The number of frames to drop.
+    * @param[in] iAverageSamples            The number of samples per frame.
+    */
+    void skipFrames(int iNumFrames, int iAverageSamples);
 
     //=========================================================================================================
     /**
@@ -328,9 +366,9 @@ signals:
     /**
     * Emit this signal whenever this item should send new colors to its listeners.
     *
-    * @param[in] colorPair     The samples data in form of a QPair rgb colors for each (left, right) hemisphere.
+    * @param[in] colorPair     The samples data in form of a QPair of 8-bit RGBA colors for each (left, right) hemisphere.
     */
-    void newRtData(const QPair<MatrixX3f, MatrixX3f>& colorPair);
+    void newRtData(const QPair<QByteArray, QByteArray>& colorPair);
 };
 
 } // NAMESPACE
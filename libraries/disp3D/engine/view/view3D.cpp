@@ -40,6 +40,7 @@
 
 #include "view3D.h"
 #include "../model/3dhelpers/renderable3Dentity.h"
+#include "../model/3dhelpers/custommesh.h"
 #include "../model/items/common/abstract3Dtreeitem.h"
 #include "../model/items/common/types.h"
 #include "../model/data3Dtreemodel.h"
@@ -69,6 +70,7 @@
 #include <Qt3DExtras/QForwardRenderer>
 #include <Qt3DExtras/QSphereMesh>
 #include <Qt3DRender/QRenderSettings>
+#include <Qt3DLogic/QFrameAction>
 
 
 //*************************************************************************************************************
@@ -82,6 +84,14 @@ using namespace FSLIB;
 using namespace CONNECTIVITYLIB;
 
 
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINES
+//=============================================================================================================
+
+#define VIEW3D_FRAMETIME_INTERVAL_MSEC  1000    /**< Length of one frame time measurement interval. */
+
+
 //*************************************************************************************************************
 //=============================================================================================================
 // DEFINE MEMBER METHODS
@@ -101,6 +111,12 @@ View3D::View3D()
 , m_vecViewRotation(QVector3D(-90.0,130.0,0.0))
 , m_vecViewRotationOld(QVector3D(-90.0,130.0,0.0))
 , m_pCameraTransform(new Qt3DCore::QTransform())
+, m_pFrameAction(new Qt3DLogic::QFrameAction())
+, m_bFrameTimeLogging(false)
+, m_iFrameCount(0)
+, m_dFrameTimeSum(0.0)
+, m_dFrameTimeMax(0.0)
+, m_dMeanFrameTime(0.0)
 {
     init();
 }
@@ -142,6 +158,12 @@ void View3D::init()
 
     //Only render new frames when needed
     this->renderSettings()->setRenderPolicy(Qt3DRender::QRenderSettings::OnDemand);
+
+    //Measure the frame times
+    m_pRootEntity->addComponent(m_pFrameAction);
+    connect(m_pFrameAction.data(), &Qt3DLogic::QFrameAction::triggered,
+            this, &View3D::onFrameTriggered);
+    m_frameTimeInterval.start();
 }
 
 
@@ -309,6 +331,67 @@ void View3D::setLightIntensity(double value)
 }
 
 
+//*************************************************************************************************************
+
+void View3D::setFrameTimeLogging(bool bEnabled)
+{
+    m_bFrameTimeLogging = bEnabled;
+}
+
+
+//*************************************************************************************************************
+
+double View3D::getMeanFrameTime() const
+{
+    return m_dMeanFrameTime;
+}
+
+
+//*************************************************************************************************************
+
+void View3D::setCameraDistance(float fDistance)
+{
+    m_vecViewTrans.setZ(-fDistance);
+    m_vecViewTransOld = m_vecViewTrans;
+
+    m_pCameraTransform->setTranslation(m_vecViewTrans);
+
+    updateLevelOfDetail();
+}
+
+
+//*************************************************************************************************************
+
+void View3D::onFrameTriggered(float dt)
+{
+    const double dFrameTime = dt * 1000.0;
+
+    m_dFrameTimeSum += dFrameTime;
+    m_dFrameTimeMax = qMax(m_dFrameTimeMax, dFrameTime);
+    m_iFrameCount++;
+
+    if(m_frameTimeInterval.elapsed() < VIEW3D_FRAMETIME_INTERVAL_MSEC) {
+        return;
+    }
+
+    m_dMeanFrameTime = m_dFrameTimeSum / m_iFrameCount;
+
+    //Meshes which were added since the last interval start with full resolution
+    updateLevelOfDetail();
+
+    if(m_bFrameTimeLogging) {
+        qDebug() << "View3D::onFrameTriggered - frames" << m_iFrameCount << "mean frame time" << m_dMeanFrameTime << "ms max frame time" << m_dFrameTimeMax << "ms";
+    }
+
+    emit frameTimeUpdated(m_dMeanFrameTime, m_dFrameTimeMax, m_iFrameCount);
+
+    m_dFrameTimeSum = 0.0;
+    m_dFrameTimeMax = 0.0;
+    m_iFrameCount = 0;
+    m_frameTimeInterval.restart();
+}
+
+
 //*************************************************************************************************************
 
 void View3D::keyPressEvent(QKeyEvent* e)
@@ -457,6 +540,8 @@ void View3D::wheelEvent(QWheelEvent* e)
     // Transform
     m_pCameraTransform->setTranslation(m_vecViewTrans);
 
+    updateLevelOfDetail();
+
     Qt3DWindow::wheelEvent(e);
 }
 
@@ -490,6 +575,47 @@ void View3D::setRotationRecursive(QObject* obj)
 }
 
 
+//*************************************************************************************************************
+
+void View3D::updateLevelOfDetail()
+{
+    const QVector3D vecCameraPos = m_pCameraTransform->matrix().map(m_pCameraEntity->position());
+
+    updateLevelOfDetailRecursive(m_p3DObjectsEntity, QMatrix4x4(), vecCameraPos);
+}
+
+
+//*************************************************************************************************************
+
+void View3D::updateLevelOfDetailRecursive(QObject* obj, const QMatrix4x4& matWorld, const QVector3D& vecCameraPos)
+{
+    for(int i = 0; i < obj->children().size(); ++i) {
+        QMatrix4x4 matChildWorld = matWorld;
+
+        if(Qt3DCore::QEntity* pEntity = qobject_cast<Qt3DCore::QEntity*>(obj->children().at(i))) {
+            const Qt3DCore::QComponentVector components = pEntity->components();
+
+            //Accumulate the transformations first, the meshes are placed by the transform of their own entity
+            for(int j = 0; j < components.size(); ++j) {
+                if(Qt3DCore::QTransform* pTransform = qobject_cast<Qt3DCore::QTransform*>(components.at(j))) {
+                    matChildWorld = matWorld * pTransform->matrix();
+                    break;
+                }
+            }
+
+            for(int j = 0; j < components.size(); ++j) {
+                if(CustomMesh* pMesh = qobject_cast<CustomMesh*>(components.at(j))) {
+                    const QVector3D vecCenter = matChildWorld.map(pMesh->getBoundingCenter());
+                    pMesh->updateLevelOfDetail((vecCameraPos - vecCenter).length());
+                }
+            }
+        }
+
+        updateLevelOfDetailRecursive(obj->children().at(i), matChildWorld, vecCameraPos);
+    }
+}
+
+
 //*************************************************************************************************************
 
 void View3D::mouseMoveEvent(QMouseEvent* e)
@@ -518,6 +644,8 @@ void View3D::mouseMoveEvent(QMouseEvent* e)
 
         // Camera translation transform
         m_pCameraTransform->setTranslation(m_vecViewTrans);
+
+        updateLevelOfDetail();
     }
 
     Qt3DWindow::mouseMoveEvent(e);
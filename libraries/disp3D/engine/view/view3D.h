@@ -56,7 +56,9 @@
 
 #include <Qt3DExtras/Qt3DWindow>
 #include <QVector3D>
+#include <QMatrix4x4>
 #include <QPointer>
+#include <QElapsedTimer>
 
 
 //*************************************************************************************************************
@@ -79,6 +81,10 @@ namespace Qt3DExtras {
     class QPhongMaterial;
 }
 
+namespace Qt3DLogic {
+    class QFrameAction;
+}
+
 
 //*************************************************************************************************************
 //=============================================================================================================
@@ -172,6 +178,32 @@ public:
     */
     void setLightIntensity(double value);
 
+    //=========================================================================================================
+    /**
+    * Turns printing of the frame time statistics to the debug output on or off. The statistics are emitted via
+    * frameTimeUpdated() regardless of this setting.
+    *
+    * @param[in] bEnabled       Whether to print the frame time statistics.
+    */
+    void setFrameTimeLogging(bool bEnabled);
+
+    //=========================================================================================================
+    /**
+    * Returns the mean frame time of the last completed measurement interval.
+    *
+    * @return The mean frame time in milli seconds. Zero if no frame was rendered yet.
+    */
+    double getMeanFrameTime() const;
+
+    //=========================================================================================================
+    /**
+    * Moves the camera along its viewing axis to the given distance from the origin and updates the level of
+    * detail of all meshes accordingly.
+    *
+    * @param[in] fDistance      The new camera distance.
+    */
+    void setCameraDistance(float fDistance);
+
 protected:
     //=========================================================================================================
     /**
@@ -218,6 +250,32 @@ protected:
     */
     void setRotationRecursive(QObject* obj);
 
+    //=========================================================================================================
+    /**
+    * Updates the level of detail of all meshes in the scene based on their distance to the camera.
+    */
+    void updateLevelOfDetail();
+
+    //=========================================================================================================
+    /**
+    * Updates the level of detail of all meshes being children based on the distance between the camera and the
+    * center of each mesh's bounding sphere.
+    *
+    * @param[in] obj            The parent of the children to be updated.
+    * @param[in] matWorld       The world transformation of obj.
+    * @param[in] vecCameraPos   The camera position in world coordinates.
+    */
+    void updateLevelOfDetailRecursive(QObject* obj, const QMatrix4x4& matWorld, const QVector3D& vecCameraPos);
+
+    //=========================================================================================================
+    /**
+    * Call this function whenever a new frame was processed. Accumulates the frame times and emits the
+    * statistics once per measurement interval.
+    *
+    * @param[in] dt             The time since the last frame in seconds.
+    */
+    void onFrameTriggered(float dt);
+
     QPointer<Qt3DCore::QEntity>         m_pRootEntity;                  /**< The root/most top level entity buffer. */
     QPointer<Qt3DCore::QEntity>         m_p3DObjectsEntity;             /**< The root/most top level entity buffer. */
     QPointer<Qt3DCore::QEntity>         m_pLightEntity;                 /**< The root/most top level entity buffer. */
@@ -244,6 +302,25 @@ protected:
 
     QList<QPointer<QPropertyAnimation> >  m_lPropertyAnimations;        /**< The animations for each 3D object. */
     QList<QPair<QPointer<Qt3DRender::QPointLight> , QPointer<Qt3DExtras::QPhongMaterial> > >  m_lLightSources;        /**< The light sources. */
+
+    QPointer<Qt3DLogic::QFrameAction>   m_pFrameAction;                 /**< The frame action used to measure the frame times. */
+    QElapsedTimer                       m_frameTimeInterval;            /**< The timer for the current frame time measurement interval. */
+    bool                                m_bFrameTimeLogging;            /**< Flag whether the frame time statistics are printed to the debug output. */
+    int                                 m_iFrameCount;                  /**< Number of frames in the current measurement interval. */
+    double                              m_dFrameTimeSum;                /**< Sum of the frame times in the current measurement interval in milli seconds. */
+    double                              m_dFrameTimeMax;                /**< Maximum frame time in the current measurement interval in milli seconds. */
+    double                              m_dMeanFrameTime;               /**< Mean frame time of the last completed measurement interval in milli seconds. */
+
+signals:
+    //=========================================================================================================
+    /**
+    * Emitted once per measurement interval with the frame time statistics.
+    *
+    * @param[in] dMeanFrameTime     The mean frame time in milli seconds.
+    * @param[in] dMaxFrameTime      The maximum frame time in milli seconds.
+    * @param[in] iNumFrames         The number of frames in the interval.
+    */
+    void frameTimeUpdated(double dMeanFrameTime, double dMaxFrameTime, int iNumFrames);
 };
 
 } // NAMESPACE
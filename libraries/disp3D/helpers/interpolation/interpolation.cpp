@@ -172,6 +172,23 @@ QSharedPointer<VectorXf> Interpolation::interpolateSignal(const QSharedPointer<S
 }
 
 
+//*************************************************************************************************************
+
+bool Interpolation::interpolateSignals(const SparseMatrix<float> &matInterpolationMatrix,
+                                       const MatrixXf &matMeasurementData,
+                                       MatrixXf &matInterpolatedData)
+{
+    if (matInterpolationMatrix.cols() != matMeasurementData.rows()) {
+        qDebug() << "[WARNING] Interpolation::interpolateSignals - Dimension mismatch. Returning...";
+        return false;
+    }
+
+    matInterpolatedData.noalias() = matInterpolationMatrix * matMeasurementData;
+
+    return true;
+}
+
+
 //*************************************************************************************************************
 
 double Interpolation::linear(const double dIn)
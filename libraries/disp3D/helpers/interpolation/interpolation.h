@@ -151,6 +151,23 @@ public:
      */
     static QSharedPointer<Eigen::VectorXf> interpolateSignal(const QSharedPointer<Eigen::SparseMatrix<double> > pInterpolationMatrix, const Eigen::VectorXd &vecMeasurementData);
 
+    //=========================================================================================================
+    /**
+     * Batched version of <i>interpolateSignal</i>: Interpolates several time points at once as one sparse * dense
+     * matrix product in single precision. The output matrix is only reallocated if its dimensions change, so it
+     * can be reused for consecutive calls.
+     *
+     * @brief <i>interpolateSignals</i>     Interpolate several samples of sensor data
+     * @param matInterpolationMatrix        The weight matrix in single precision
+     * @param matMeasurementData            The measured sensor data, one column per time point
+     * @param matInterpolatedData           Interpolated values for all vertices of the mesh, one column per time point
+     *
+     * @return                              True if successful, false if the dimensions do not match
+     */
+    static bool interpolateSignals(const Eigen::SparseMatrix<float> &matInterpolationMatrix,
+                                   const Eigen::MatrixXf &matMeasurementData,
+                                   Eigen::MatrixXf &matInterpolatedData);
+
     //=========================================================================================================
     /**
      * Serves as a placeholder for other functions and is needed in case a linear interpolation is wanted when calling <i>createInterplationMat</i>.
@@ -0,0 +1,588 @@
+//=============================================================================================================
+/**
+* @file     fiff_raw_recorder.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     FiffRawRecorder class definition.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "fiff_raw_recorder.h"
+#include "fiff_stream.h"
+#include "fiff_file.h"
+#include "fiff_constants.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <cmath>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QFileInfo>
+#include <QDebug>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FIFFLIB;
+using namespace Eigen;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE GLOBAL METHODS
+//=============================================================================================================
+
+namespace {
+
+const int   TAG_HEADER_SIZE     = 16;       /**< Size of a fif tag header in bytes. */
+const int   PART_TRAILER_SIZE   = 4096;     /**< Bytes reserved for the reference and end blocks of a file part. */
+
+//*************************************************************************************************************
+
+inline fiff_int_t bytesPerValue(fiff_int_t iDataType)
+{
+    return iDataType == FIFFT_DAU_PACK16 ? 2 : 4;
+}
+
+} // anonymous namespace
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+FiffRawRecorder::FiffRawRecorder(const FiffInfo& info, QObject *parent)
+: QThread(parent)
+, m_info(info)
+, m_iDataType(FIFFT_FLOAT)
+, m_iSplitSize(FIFF_RAW_RECORDER_DEFAULT_SPLIT_SIZE)
+, m_iQueueSize(FIFF_RAW_RECORDER_DEFAULT_QUEUE_SIZE)
+, m_bInputCalibrated(true)
+, m_bIsRecording(false)
+, m_iFileNum(0)
+, m_iPendingSkip(0)
+, m_iFirstSample(0)
+, m_iDroppedBlocks(0)
+, m_iBytesWritten(0)
+{
+}
+
+
+//*************************************************************************************************************
+
+FiffRawRecorder::~FiffRawRecorder()
+{
+    stopRecording();
+}
+
+
+//*************************************************************************************************************
+
+bool FiffRawRecorder::setDataType(fiff_int_t iDataType)
+{
+    if(iDataType != FIFFT_FLOAT && iDataType != FIFFT_INT && iDataType != FIFFT_DAU_PACK16) {
+        qWarning() << "FiffRawRecorder::setDataType - Data type" << iDataType << "is not supported.";
+        return false;
+    }
+
+    QMutexLocker locker(&m_qMutex);
+
+    if(m_bIsRecording) {
+        qWarning() << "FiffRawRecorder::setDataType - Cannot change the data type while recording.";
+        return false;
+    }
+
+    m_iDataType = iDataType;
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawRecorder::setSplitSize(qint64 iSplitSize)
+{
+    QMutexLocker locker(&m_qMutex);
+    m_iSplitSize = iSplitSize;
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawRecorder::setQueueSize(int iQueueSize)
+{
+    QMutexLocker locker(&m_qMutex);
+    m_iQueueSize = qMax(1, iQueueSize);
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawRecorder::setInputCalibrated(bool bIsCalibrated)
+{
+    QMutexLocker locker(&m_qMutex);
+    m_bInputCalibrated = bIsCalibrated;
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawRecorder::setFiffInfo(const FiffInfo& info)
+{
+    QMutexLocker locker(&m_qMutex);
+    m_info = info;
+}
+
+
+//*************************************************************************************************************
+
+bool FiffRawRecorder::startRecording(const QString& sFileName)
+{
+    if(m_bIsRecording) {
+        qWarning() << "FiffRawRecorder::startRecording - Recording is already in progress.";
+        return false;
+    }
+
+    if(QThread::isRunning()) {
+        QThread::wait();
+    }
+
+    m_sFileName = sFileName;
+    m_iFileNum = 0;
+    m_iPendingSkip = 0;
+    m_iFirstSample = 0;
+    m_iDroppedBlocks = 0;
+    m_iBytesWritten = 0;
+    m_lQueue.clear();
+
+    if(!openFilePart(0)) {
+        return false;
+    }
+
+    m_qElapsedTimer.start();
+    m_bIsRecording = true;
+    QThread::start();
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+bool FiffRawRecorder::stopRecording()
+{
+    if(!m_bIsRecording && !QThread::isRunning()) {
+        return false;
+    }
+
+    m_qMutex.lock();
+    m_bIsRecording = false;
+    m_qWaitCondition.wakeAll();
+    m_qMutex.unlock();
+
+    QThread::wait();
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+bool FiffRawRecorder::append(const MatrixXf& matData)
+{
+    QMutexLocker locker(&m_qMutex);
+
+    if(!m_bIsRecording) {
+        return false;
+    }
+
+    if(matData.rows() != m_vecInvCals.cols()) {
+        qWarning() << "FiffRawRecorder::append - Number of rows" << matData.rows() << "does not match the number of channels" << m_vecInvCals.cols();
+        return false;
+    }
+
+    if(m_lQueue.size() >= m_iQueueSize) {
+        ++m_iPendingSkip;
+        ++m_iDroppedBlocks;
+        return false;
+    }
+
+    QueuedBlock block;
+    block.matData = matData;
+    block.iSkip = m_iPendingSkip;
+    m_iPendingSkip = 0;
+
+    m_lQueue.append(block);
+    m_qWaitCondition.wakeOne();
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+bool FiffRawRecorder::append(const MatrixXd& matData)
+{
+    return append(MatrixXf(matData.cast<float>()));
+}
+
+
+//*************************************************************************************************************
+
+int FiffRawRecorder::queueDepth() const
+{
+    QMutexLocker locker(&m_qMutex);
+    return m_lQueue.size();
+}
+
+
+//*************************************************************************************************************
+
+qint64 FiffRawRecorder::droppedBlocks() const
+{
+    QMutexLocker locker(&m_qMutex);
+    return m_iDroppedBlocks;
+}
+
+
+//*************************************************************************************************************
+
+qint64 FiffRawRecorder::bytesWritten() const
+{
+    QMutexLocker locker(&m_qMutex);
+    return m_iBytesWritten;
+}
+
+
+//*************************************************************************************************************
+
+double FiffRawRecorder::throughput() const
+{
+    QMutexLocker locker(&m_qMutex);
+
+    qint64 iMSecs = m_qElapsedTimer.isValid() ? m_qElapsedTimer.elapsed() : 0;
+    return iMSecs > 0 ? 1000.0 * double(m_iBytesWritten) / double(iMSecs) : 0.0;
+}
+
+
+//*************************************************************************************************************
+
+int FiffRawRecorder::fileCount() const
+{
+    QMutexLocker locker(&m_qMutex);
+    return m_iFileNum + 1;
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawRecorder::run()
+{
+    QList<QueuedBlock> lBlocks;
+    int iNumBuffersInPart = 0;
+
+    while(true) {
+        m_qMutex.lock();
+        while(m_lQueue.isEmpty() && m_bIsRecording) {
+            m_qWaitCondition.wait(&m_qMutex);
+        }
+
+        //Swap the filled queue with the drained one, so the acquisition thread can continue right away
+        lBlocks.swap(m_lQueue);
+        bool bIsRecording = m_bIsRecording;
+        qint64 iSplitSize = m_iSplitSize;
+        m_qMutex.unlock();
+
+        for(int i = 0; i < lBlocks.size(); ++i) {
+            const QueuedBlock& block = lBlocks.at(i);
+
+            qint64 iTagSize = 2 * TAG_HEADER_SIZE + block.matData.size() * bytesPerValue(m_iDataType);
+            if(iSplitSize > 0
+               && iNumBuffersInPart > 0
+               && m_pStream->device()->pos() + iTagSize + PART_TRAILER_SIZE > iSplitSize) {
+                QString sNextFileName = partFileName(m_iFileNum + 1);
+                closeFilePart(sNextFileName);
+
+                m_qMutex.lock();
+                ++m_iFileNum;
+                m_qMutex.unlock();
+
+                if(!openFilePart(m_iFileNum)) {
+                    qWarning() << "FiffRawRecorder::run - Could not open" << sNextFileName << ". Recording stopped.";
+                    m_qMutex.lock();
+                    m_bIsRecording = false;
+                    m_lQueue.clear();
+                    m_qMutex.unlock();
+                    return;
+                }
+
+                iNumBuffersInPart = 0;
+                emit fileSplit(sNextFileName);
+            }
+
+            if(block.iSkip > 0) {
+                writeSkip(block.iSkip);
+                m_iFirstSample += block.iSkip * block.matData.cols();
+            }
+
+            writeBuffer(block.matData);
+            m_iFirstSample += block.matData.cols();
+            ++iNumBuffersInPart;
+        }
+
+        lBlocks.clear();
+
+        emit statisticsUpdated(queueDepth(), throughput(), droppedBlocks());
+
+        if(!bIsRecording) {
+            m_qMutex.lock();
+            bool bIsDrained = m_lQueue.isEmpty();
+            m_qMutex.unlock();
+
+            if(bIsDrained) {
+                break;
+            }
+        }
+    }
+
+    closeFilePart();
+}
+
+
+//*************************************************************************************************************
+
+bool FiffRawRecorder::openFilePart(int iFileNum)
+{
+    m_qMutex.lock();
+    FiffInfo info = m_info;
+    m_qMutex.unlock();
+
+    updateCalibration(info);
+
+    m_qFile.setFileName(iFileNum == 0 ? m_sFileName : partFileName(iFileNum));
+
+    RowVectorXd cals;
+    m_pStream = FiffStream::start_writing_raw(m_qFile, info, cals, defaultMatrixXi, false, m_iDataType);
+    if(!m_pStream || !m_qFile.isOpen()) {
+        m_pStream.clear();
+        return false;
+    }
+
+    if(iFileNum > 0) {
+        writeFileReference(FIFFV_ROLE_PREV_FILE, partFileName(iFileNum - 1), iFileNum - 1);
+    }
+
+    fiff_int_t first = m_iFirstSample;
+    m_pStream->write_int(FIFF_FIRST_SAMPLE, &first);
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawRecorder::closeFilePart(const QString& sNextFileName)
+{
+    if(!m_pStream) {
+        return;
+    }
+
+    if(!sNextFileName.isEmpty()) {
+        writeFileReference(FIFFV_ROLE_NEXT_FILE, sNextFileName, m_iFileNum + 1);
+    }
+
+    m_pStream->finish_writing_raw();
+    m_pStream.clear();
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawRecorder::writeFileReference(fiff_int_t iRole, const QString& sFileName, fiff_int_t iFileNum)
+{
+    m_qMutex.lock();
+    FiffId measId = m_info.meas_id;
+    m_qMutex.unlock();
+
+    m_pStream->start_block(FIFFB_REF);
+    m_pStream->write_int(FIFF_REF_ROLE, &iRole);
+    m_pStream->write_string(FIFF_REF_FILE_NAME, QFileInfo(sFileName).fileName());
+    if(measId.version != -1) {
+        m_pStream->write_id(FIFF_REF_FILE_ID, measId);
+    }
+    m_pStream->write_int(FIFF_REF_FILE_NUM, &iFileNum);
+    m_pStream->end_block(FIFFB_REF);
+}
+
+
+//*************************************************************************************************************
+
+QString FiffRawRecorder::partFileName(int iFileNum) const
+{
+    if(iFileNum == 0) {
+        return m_sFileName;
+    }
+
+    QString sBaseName = m_sFileName;
+    QString sSuffix = ".fif";
+    if(sBaseName.endsWith("_raw.fif")) {
+        sSuffix = "_raw.fif";
+    }
+    sBaseName.chop(sSuffix.size());
+
+    return QString("%1-%2%3").arg(sBaseName).arg(iFileNum).arg(sSuffix);
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawRecorder::writeBuffer(const MatrixXf& matData)
+{
+    const int iNumValues = matData.size();
+    const int iValueSize = bytesPerValue(m_iDataType);
+
+    //The conversion buffer only grows, so steady-state recording does not allocate
+    if(m_baBuffer.size() < iNumValues * iValueSize) {
+        m_baBuffer.resize(iNumValues * iValueSize);
+    }
+
+    m_qMutex.lock();
+    bool bInputCalibrated = m_bInputCalibrated;
+    m_qMutex.unlock();
+
+    //The column-major channels x samples layout is the sample-major layout of a fif data buffer
+    const int iNumChannels = matData.rows();
+    const float* pSrc = matData.data();
+
+    switch(m_iDataType) {
+        case FIFFT_FLOAT: {
+            float* pDest = reinterpret_cast<float*>(m_baBuffer.data());
+            for(int j = 0; j < matData.cols(); ++j) {
+                for(int i = 0; i < iNumChannels; ++i, ++pSrc, ++pDest) {
+                    *pDest = bInputCalibrated ? *pSrc * m_vecInvCals[i] : *pSrc;
+                }
+            }
+            break;
+        }
+
+        case FIFFT_INT: {
+            qint32* pDest = reinterpret_cast<qint32*>(m_baBuffer.data());
+            for(int j = 0; j < matData.cols(); ++j) {
+                for(int i = 0; i < iNumChannels; ++i, ++pSrc, ++pDest) {
+                    double dValue = bInputCalibrated ? double(*pSrc) * m_vecInvCals[i] : double(*pSrc);
+                    *pDest = qint32(qBound(-2147483648.0, std::floor(dValue + 0.5), 2147483647.0));
+                }
+            }
+            break;
+        }
+
+        case FIFFT_DAU_PACK16: {
+            qint16* pDest = reinterpret_cast<qint16*>(m_baBuffer.data());
+            for(int j = 0; j < matData.cols(); ++j) {
+                for(int i = 0; i < iNumChannels; ++i, ++pSrc, ++pDest) {
+                    float fValue = bInputCalibrated ? *pSrc * m_vecInvCals[i] : *pSrc;
+                    *pDest = qint16(qBound(-32768.0f, std::floor(fValue + 0.5f), 32767.0f));
+                }
+            }
+            break;
+        }
+    }
+
+    //The stream swaps the bytes in bulk and writes the whole tag at once
+    qint64 iStartPos = m_pStream->device()->pos();
+
+    m_pStream->begin_tag(FIFF_DATA_BUFFER, m_iDataType, iNumValues * iValueSize);
+    m_pStream->stage_values(m_baBuffer.constData(), iNumValues, iValueSize);
+    m_pStream->end_tag();
+
+    updateBytesWritten(iStartPos);
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawRecorder::writeSkip(fiff_int_t iSkip)
+{
+    qint64 iStartPos = m_pStream->device()->pos();
+
+    m_pStream->write_int(FIFF_DATA_SKIP, &iSkip);
+
+    updateBytesWritten(iStartPos);
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawRecorder::updateBytesWritten(qint64 iStartPos)
+{
+    if(m_pStream->status() != QDataStream::Ok) {
+        qWarning() << "FiffRawRecorder::updateBytesWritten - Writing to" << m_qFile.fileName() << "failed.";
+        m_pStream->resetStatus();
+    }
+
+    qint64 iWritten = m_pStream->device()->pos() - iStartPos;
+
+    if(iWritten > 0) {
+        QMutexLocker locker(&m_qMutex);
+        m_iBytesWritten += iWritten;
+    }
+}
+
+
+//*************************************************************************************************************
+
+void FiffRawRecorder::updateCalibration(const FiffInfo& info)
+{
+    RowVectorXf vecInvCals(info.nchan);
+
+    for(int k = 0; k < info.nchan; ++k) {
+        double dCal = double(info.chs[k].range) * double(info.chs[k].cal);
+        vecInvCals[k] = dCal != 0.0 ? float(1.0 / dCal) : 1.0f;
+    }
+
+    QMutexLocker locker(&m_qMutex);
+    m_vecInvCals = vecInvCals;
+}
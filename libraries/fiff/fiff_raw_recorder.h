@@ -0,0 +1,405 @@
+//=============================================================================================================
+/**
+* @file     fiff_raw_recorder.h
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     FiffRawRecorder class declaration.
+*
+*/
+
+#ifndef FIFF_RAW_RECORDER_H
+#define FIFF_RAW_RECORDER_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "fiff_global.h"
+#include "fiff_types.h"
+#include "fiff_info.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QByteArray>
+#include <QList>
+#include <QSharedPointer>
+#include <QString>
+#include <QFile>
+#include <QElapsedTimer>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINES
+//=============================================================================================================
+
+#define FIFF_RAW_RECORDER_DEFAULT_SPLIT_SIZE    2000000000LL    /**< Default file size in bytes after which a new file part is started. */
+#define FIFF_RAW_RECORDER_DEFAULT_QUEUE_SIZE    64              /**< Default number of blocks the recorder queue can hold. */
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE FIFFLIB
+//=============================================================================================================
+
+namespace FIFFLIB
+{
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Forward Declarations
+//=============================================================================================================
+
+class FiffStream;
+
+
+//=============================================================================================================
+/**
+* FiffRawRecorder writes raw data blocks to a fif file on its own I/O thread. The acquisition thread hands
+* blocks over with append(), which only copies the block into a bounded queue and never touches the disk.
+* The I/O thread swaps the whole queue out at once, converts every block into a preallocated buffer (FLOAT,
+* INT or DAU_PACK16) and writes each tag through the FiffStream staging buffer, i.e. with a bulk byte swap and
+* a single device write. Files are split into
+* parts once they reach the configured size, the parts are linked via FIFFB_REF blocks and carry the correct
+* FIFF_FIRST_SAMPLE, so they can be read back as one continuous recording. Blocks which do not fit into the
+* queue are dropped and replaced by a FIFF_DATA_SKIP tag to keep the time axis intact.
+*
+* @brief Asynchronous double-buffered fif raw data recorder.
+*/
+class FIFFSHARED_EXPORT FiffRawRecorder : public QThread
+{
+    Q_OBJECT
+
+public:
+    typedef QSharedPointer<FiffRawRecorder> SPtr;            /**< Shared pointer type for FiffRawRecorder. */
+    typedef QSharedPointer<const FiffRawRecorder> ConstSPtr; /**< Const shared pointer type for FiffRawRecorder. */
+
+    //=========================================================================================================
+    /**
+    * Constructs a FiffRawRecorder object.
+    *
+    * @param[in] info       The measurement info which is written to the header of each file part.
+    * @param[in] parent     Parent QObject (optional).
+    */
+    explicit FiffRawRecorder(const FiffInfo& info, QObject *parent = 0);
+
+    //=========================================================================================================
+    /**
+    * Destroys the FiffRawRecorder. A running recording is finished before the object is destroyed.
+    */
+    ~FiffRawRecorder();
+
+    //=========================================================================================================
+    /**
+    * Sets the storage format of the data buffers. Has to be called before startRecording().
+    *
+    * @param[in] iDataType      FIFFT_FLOAT (default), FIFFT_INT or FIFFT_DAU_PACK16.
+    *
+    * @return true if the data type is supported, false otherwise.
+    */
+    bool setDataType(fiff_int_t iDataType);
+
+    //=========================================================================================================
+    /**
+    * Sets the file size in bytes after which a new file part is started. Values <= 0 disable splitting.
+    *
+    * @param[in] iSplitSize     The maximum size of one file part in bytes.
+    */
+    void setSplitSize(qint64 iSplitSize);
+
+    //=========================================================================================================
+    /**
+    * Sets the number of blocks the queue can hold before blocks are dropped.
+    *
+    * @param[in] iQueueSize     The maximum number of queued blocks.
+    */
+    void setQueueSize(int iQueueSize);
+
+    //=========================================================================================================
+    /**
+    * Sets whether the appended data is already in the units stored in the file (i.e. uncalibrated device
+    * values) or in physical units. Physical data is divided by range*cal of each channel before it is stored.
+    *
+    * @param[in] bIsCalibrated  Whether appended data is in physical units (default true).
+    */
+    void setInputCalibrated(bool bIsCalibrated);
+
+    //=========================================================================================================
+    /**
+    * Updates the measurement info. The new info is used for all file parts which are started afterwards.
+    *
+    * @param[in] info       The new measurement info.
+    */
+    void setFiffInfo(const FiffInfo& info);
+
+    //=========================================================================================================
+    /**
+    * Opens the first file part, writes the header and starts the I/O thread.
+    *
+    * @param[in] sFileName      The file name of the first file part.
+    *
+    * @return true if succeeded, false otherwise.
+    */
+    bool startRecording(const QString& sFileName);
+
+    //=========================================================================================================
+    /**
+    * Writes all queued blocks, finishes the current file part and stops the I/O thread.
+    *
+    * @return true if succeeded, false otherwise.
+    */
+    bool stopRecording();
+
+    //=========================================================================================================
+    /**
+    * Queues a data block (channels x samples) for writing. Never blocks on disk I/O. If the queue is full the
+    * block is dropped and a data skip is written in its place.
+    *
+    * @param[in] matData    The data block.
+    *
+    * @return true if the block was queued, false if it was dropped or the recorder is not running.
+    */
+    bool append(const Eigen::MatrixXf& matData);
+
+    //=========================================================================================================
+    /**
+    * Queues a data block (channels x samples) for writing. See append(const Eigen::MatrixXf&).
+    *
+    * @param[in] matData    The data block.
+    *
+    * @return true if the block was queued, false if it was dropped or the recorder is not running.
+    */
+    bool append(const Eigen::MatrixXd& matData);
+
+    //=========================================================================================================
+    /**
+    * Returns whether a recording is in progress.
+    *
+    * @return true if recording, false otherwise.
+    */
+    inline bool isRecording() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of blocks currently waiting in the queue.
+    *
+    * @return the queue depth.
+    */
+    int queueDepth() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of blocks which were dropped because the queue was full.
+    *
+    * @return the number of dropped blocks.
+    */
+    qint64 droppedBlocks() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of bytes written since startRecording() over all file parts.
+    *
+    * @return the number of written bytes.
+    */
+    qint64 bytesWritten() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the write throughput in bytes per second, averaged since startRecording().
+    *
+    * @return the write throughput.
+    */
+    double throughput() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of file parts written so far.
+    *
+    * @return the number of file parts.
+    */
+    int fileCount() const;
+
+signals:
+    //=========================================================================================================
+    /**
+    * Emitted by the I/O thread after each flushed batch of blocks.
+    *
+    * @param[in] iQueueDepth        The number of blocks still waiting in the queue.
+    * @param[in] dThroughput        The write throughput in bytes per second.
+    * @param[in] iDroppedBlocks     The number of dropped blocks so far.
+    */
+    void statisticsUpdated(int iQueueDepth, double dThroughput, qint64 iDroppedBlocks);
+
+    //=========================================================================================================
+    /**
+    * Emitted by the I/O thread when a new file part was started.
+    *
+    * @param[in] sFileName      The file name of the new file part.
+    */
+    void fileSplit(const QString& sFileName);
+
+protected:
+    //=========================================================================================================
+    /**
+    * The I/O thread. Swaps the queue with its own list, encodes and writes the blocks.
+    */
+    virtual void run();
+
+private:
+    //=========================================================================================================
+    /**
+    * Opens a file part and writes the measurement info. Parts with iFileNum > 0 are linked to their predecessor.
+    *
+    * @param[in] iFileNum       The index of the file part.
+    *
+    * @return true if succeeded, false otherwise.
+    */
+    bool openFilePart(int iFileNum);
+
+    //=========================================================================================================
+    /**
+    * Links the current file part to the next one and finishes it.
+    *
+    * @param[in] sNextFileName  The file name of the next part. Empty if this is the last part.
+    */
+    void closeFilePart(const QString& sNextFileName = QString());
+
+    //=========================================================================================================
+    /**
+    * Writes a FIFF_REF block pointing to another file part.
+    *
+    * @param[in] iRole          FIFFV_ROLE_PREV_FILE or FIFFV_ROLE_NEXT_FILE.
+    * @param[in] sFileName      The file name of the referenced part.
+    * @param[in] iFileNum       The index of the referenced part.
+    */
+    void writeFileReference(fiff_int_t iRole, const QString& sFileName, fiff_int_t iFileNum);
+
+    //=========================================================================================================
+    /**
+    * Returns the file name of a file part, following the <name>-<n>_raw.fif convention.
+    *
+    * @param[in] iFileNum       The index of the file part.
+    *
+    * @return the file name.
+    */
+    QString partFileName(int iFileNum) const;
+
+    //=========================================================================================================
+    /**
+    * Converts a data block to the storage type in m_baBuffer and writes it as one FIFF_DATA_BUFFER tag.
+    *
+    * @param[in] matData        The data block.
+    */
+    void writeBuffer(const Eigen::MatrixXf& matData);
+
+    //=========================================================================================================
+    /**
+    * Writes a FIFF_DATA_SKIP tag for skipped buffers.
+    *
+    * @param[in] iSkip          The number of skipped buffers.
+    */
+    void writeSkip(fiff_int_t iSkip);
+
+    //=========================================================================================================
+    /**
+    * Adds the bytes written since iStartPos to the statistics and reports failed writes.
+    *
+    * @param[in] iStartPos      The device position before the tag was written.
+    */
+    void updateBytesWritten(qint64 iStartPos);
+
+    //=========================================================================================================
+    /**
+    * Updates the inverse calibration factors from the given measurement info.
+    *
+    * @param[in] info           The measurement info of the current file part.
+    */
+    void updateCalibration(const FiffInfo& info);
+
+    struct QueuedBlock {
+        Eigen::MatrixXf     matData;        /**< The data block. Empty for a skip marker. */
+        fiff_int_t          iSkip;          /**< Number of dropped blocks which precede this block. */
+    };
+
+    mutable QMutex              m_qMutex;               /**< Guards the queue, the info and the statistics. */
+    QWaitCondition              m_qWaitCondition;       /**< Wakes the I/O thread when blocks were queued. */
+    QList<QueuedBlock>          m_lQueue;               /**< The blocks filled by the acquisition thread. */
+
+    FiffInfo                    m_info;                 /**< The measurement info. */
+    Eigen::RowVectorXf          m_vecInvCals;           /**< Inverse of range*cal for each channel. */
+
+    QString                     m_sFileName;            /**< The file name of the first file part. */
+    QFile                       m_qFile;                /**< The file of the current part. Only used by the I/O thread after start. */
+    QSharedPointer<FiffStream>  m_pStream;              /**< The stream of the current part. */
+
+    QByteArray                  m_baBuffer;             /**< The preallocated buffer for the converted values of one block. */
+
+    fiff_int_t                  m_iDataType;            /**< The storage type of the data buffers. */
+    qint64                      m_iSplitSize;           /**< The maximum file part size in bytes. */
+    int                         m_iQueueSize;           /**< The maximum number of queued blocks. */
+    bool                        m_bInputCalibrated;     /**< Whether appended data is in physical units. */
+
+    volatile bool               m_bIsRecording;         /**< Whether a recording is in progress. */
+    int                         m_iFileNum;             /**< The index of the current file part. */
+    fiff_int_t                  m_iPendingSkip;         /**< Number of dropped blocks not yet attached to a queued block. */
+    fiff_int_t                  m_iFirstSample;         /**< The first sample of the next buffer, used for FIFF_FIRST_SAMPLE of new parts. */
+    qint64                      m_iDroppedBlocks;       /**< Number of dropped blocks. */
+    qint64                      m_iBytesWritten;        /**< Number of bytes written over all parts. */
+    QElapsedTimer               m_qElapsedTimer;        /**< Measures the recording time for the throughput. */
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline bool FiffRawRecorder::isRecording() const
+{
+    return m_bIsRecording;
+}
+
+} // NAMESPACE FIFFLIB
+
+#endif // FIFF_RAW_RECORDER_H
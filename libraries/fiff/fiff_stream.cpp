@@ -93,6 +93,26 @@
 
 #include <QFile>
 #include <QTcpSocket>
+#include <QtEndian>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// SIMD INCLUDES
+//=============================================================================================================
+
+#ifdef EIGEN_VECTORIZE_SSE2
+#include <emmintrin.h>
+#endif
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINES
+//=============================================================================================================
+
+#define FIFFSTREAM_STAGING_SIZE 4194304     /**< Maximal size of the bulk write staging buffer in bytes (4 MB). */
+#define FIFFSTREAM_TRANSPOSE_ROWS 32        /**< Number of matrix rows transposed per pass into the staging buffer. */
 
 
 //*************************************************************************************************************
@@ -104,6 +124,82 @@ using namespace FIFFLIB;
 using namespace UTILSLIB;
 
 
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE GLOBAL METHODS
+//=============================================================================================================
+
+namespace {
+
+//*************************************************************************************************************
+
+void swap_bytes_16(const uchar* src, uchar* dst, qint64 nel)
+{
+    qint64 i = 0;
+
+#if defined(EIGEN_VECTORIZE_SSE2) && Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    //Eight values at a time: swap the bytes of each 16 bit word
+    for(; i + 8 <= nel; i += 8) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2*i));
+        x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2*i), x);
+    }
+#endif
+
+    for(; i < nel; ++i) {
+        qToBigEndian<quint16>(qFromUnaligned<quint16>(src + 2*i), dst + 2*i);
+    }
+}
+
+
+//*************************************************************************************************************
+
+void swap_bytes_32(const uchar* src, uchar* dst, qint64 nel)
+{
+    qint64 i = 0;
+
+#if defined(EIGEN_VECTORIZE_SSE2) && Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    //Four values at a time: swap the bytes of each 16 bit word, then the words of each 32 bit value
+    for(; i + 4 <= nel; i += 4) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4*i));
+        x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+        x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(2,3,0,1));
+        x = _mm_shufflehi_epi16(x, _MM_SHUFFLE(2,3,0,1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4*i), x);
+    }
+#endif
+
+    for(; i < nel; ++i) {
+        qToBigEndian<quint32>(qFromUnaligned<quint32>(src + 4*i), dst + 4*i);
+    }
+}
+
+
+//*************************************************************************************************************
+
+void swap_bytes_64(const uchar* src, uchar* dst, qint64 nel)
+{
+    qint64 i = 0;
+
+#if defined(EIGEN_VECTORIZE_SSE2) && Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    //Two values at a time: swap the bytes of each 16 bit word, then reverse the words of each 64 bit value
+    for(; i + 2 <= nel; i += 2) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 8*i));
+        x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+        x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(0,1,2,3));
+        x = _mm_shufflehi_epi16(x, _MM_SHUFFLE(0,1,2,3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 8*i), x);
+    }
+#endif
+
+    for(; i < nel; ++i) {
+        qToBigEndian<quint64>(qFromUnaligned<quint64>(src + 8*i), dst + 8*i);
+    }
+}
+
+} // anonymous namespace
+
+
 //*************************************************************************************************************
 //=============================================================================================================
 // DEFINE MEMBER METHODS
@@ -111,6 +207,7 @@ using namespace UTILSLIB;
 
 FiffStream::FiffStream(QIODevice *p_pIODevice)
 : QDataStream(p_pIODevice)
+, m_iStagingPos(0)
 {
     this->setFloatingPointPrecision(QDataStream::SinglePrecision);
     this->setByteOrder(QDataStream::BigEndian);
@@ -122,6 +219,7 @@ FiffStream::FiffStream(QIODevice *p_pIODevice)
 
 FiffStream::FiffStream(QByteArray * a, QIODevice::OpenMode mode)
 : QDataStream(a, mode)
+, m_iStagingPos(0)
 {
     this->setFloatingPointPrecision(QDataStream::SinglePrecision);
     this->setByteOrder(QDataStream::BigEndian);
@@ -1987,12 +2085,8 @@ FiffStream::SPtr FiffStream::open_update(QIODevice &p_IODevice)
 
 //*************************************************************************************************************
 
-FiffStream::SPtr FiffStream::start_writing_raw(QIODevice &p_IODevice, const FiffInfo& info, RowVectorXd& cals, MatrixXi sel, bool resetRange)
+FiffStream::SPtr FiffStream::start_writing_raw(QIODevice &p_IODevice, const FiffInfo& info, RowVectorXd& cals, MatrixXi sel, bool resetRange, fiff_int_t data_type)
 {
-    //
-    //   We will always write floats
-    //
-    fiff_int_t data_type = 4;
     qint32 k;
 
     if(sel.cols() == 0)
@@ -2013,6 +2107,8 @@ FiffStream::SPtr FiffStream::start_writing_raw(QIODevice &p_IODevice, const Fiff
     //  Create the file and save the essentials
     //
     FiffStream::SPtr t_pStream = start_file(p_IODevice);//1, 2, 3
+    if(!t_pStream)
+        return t_pStream;
     t_pStream->start_block(FIFFB_MEAS);//4
     t_pStream->write_id(FIFF_BLOCK_ID);//5
     if(info.meas_id.version != -1)
@@ -2181,6 +2277,111 @@ FiffStream::SPtr FiffStream::start_writing_raw(QIODevice &p_IODevice, const Fiff
 }
 
 
+//*************************************************************************************************************
+
+void FiffStream::begin_tag(fiff_int_t kind, fiff_int_t type, fiff_int_t datasize, fiff_int_t next)
+{
+    qint32 header[4];
+    header[0] = kind;
+    header[1] = type;
+    header[2] = datasize;
+    header[3] = next;
+
+    m_iStagingPos = 0;
+    stage_values(header, 4, 4);
+}
+
+
+//*************************************************************************************************************
+
+void FiffStream::stage_values(const void* data, qint64 nel, int size)
+{
+    const uchar* src = static_cast<const uchar*>(data);
+
+    while(nel > 0) {
+        if(m_iStagingPos + size > m_baStaging.size()) {
+            if(m_baStaging.size() < FIFFSTREAM_STAGING_SIZE) {
+                //Grow to fit the tag, the buffer is kept for the next tags
+                m_baStaging.resize(int(qMin<qint64>(FIFFSTREAM_STAGING_SIZE, qMax<qint64>(2*m_baStaging.size(), m_iStagingPos + nel*size))));
+            } else {
+                end_tag();
+            }
+        }
+
+        qint64 chunk = qMin<qint64>(nel, (m_baStaging.size() - m_iStagingPos) / size);
+        uchar* dst = reinterpret_cast<uchar*>(m_baStaging.data()) + m_iStagingPos;
+
+        if(size == 8) {
+            swap_bytes_64(src, dst, chunk);
+        } else if(size == 2) {
+            swap_bytes_16(src, dst, chunk);
+        } else {
+            swap_bytes_32(src, dst, chunk);
+        }
+
+        src += chunk*size;
+        nel -= chunk;
+        m_iStagingPos += chunk*size;
+    }
+}
+
+
+//*************************************************************************************************************
+
+void FiffStream::stage_matrix_rows(const void* data, qint32 rows, qint32 cols)
+{
+    const uchar* src = static_cast<const uchar*>(data);
+    const qint64 rowSize = 4*qint64(cols);
+
+    qint32 r = 0;
+    while(r < rows && cols > 0) {
+        if(m_iStagingPos + rowSize > m_baStaging.size()) {
+            if(m_baStaging.size() < FIFFSTREAM_STAGING_SIZE) {
+                //Grow to fit the remaining rows, the buffer is kept for the next tags
+                m_baStaging.resize(int(qMin<qint64>(FIFFSTREAM_STAGING_SIZE, qMax<qint64>(2*m_baStaging.size(), m_iStagingPos + (rows - r)*rowSize))));
+            } else {
+                end_tag();
+            }
+        }
+
+        if(m_iStagingPos + rowSize > m_baStaging.size()) {
+            //A row which exceeds the whole buffer is staged value by value
+            for(qint32 c = 0; c < cols; ++c) {
+                stage_values(src + 4*(qint64(c)*rows + r), 1, 4);
+            }
+            ++r;
+            continue;
+        }
+
+        //Transpose a few rows at a time: the reads run down the columns, the writes fill the rows in the buffer
+        const qint32 n = qint32(qMin<qint64>(qMin(FIFFSTREAM_TRANSPOSE_ROWS, rows - r), (m_baStaging.size() - m_iStagingPos) / rowSize));
+        uchar* dst = reinterpret_cast<uchar*>(m_baStaging.data()) + m_iStagingPos;
+
+        for(qint32 c = 0; c < cols; ++c) {
+            const uchar* col = src + 4*(qint64(c)*rows + r);
+            for(qint32 i = 0; i < n; ++i) {
+                qToBigEndian<quint32>(qFromUnaligned<quint32>(col + 4*i), dst + i*rowSize + 4*c);
+            }
+        }
+
+        m_iStagingPos += n*rowSize;
+        r += n;
+    }
+}
+
+
+//*************************************************************************************************************
+
+void FiffStream::end_tag()
+{
+    if(m_iStagingPos > 0 && this->device()->write(m_baStaging.constData(), m_iStagingPos) != m_iStagingPos) {
+        this->setStatus(QDataStream::WriteFailed);
+    }
+
+    m_iStagingPos = 0;
+}
+
+
 //*************************************************************************************************************
 
 fiff_long_t FiffStream::write_tag(const QSharedPointer<FiffTag> &p_pTag, fiff_long_t pos)
@@ -2610,15 +2811,9 @@ fiff_long_t FiffStream::write_double(fiff_int_t kind, const double* data, fiff_i
 
     qint32 datasize = nel * 8;
 
-    *this << (qint32)kind;
-    *this << (qint32)FIFFT_DOUBLE;
-    *this << (qint32)datasize;
-    *this << (qint32)FIFFV_NEXT_SEQ;
-
-//    this->setFloatingPointPrecision(QDataStream::SinglePrecision);
-
-    for(qint32 i = 0; i < nel; ++i)
-        *this << data[i];
+    this->begin_tag(kind, FIFFT_DOUBLE, datasize);
+    this->stage_values(data, nel, 8);
+    this->end_tag();
 
     return pos;
 }
@@ -2632,15 +2827,9 @@ fiff_long_t FiffStream::write_float(fiff_int_t kind, const float* data, fiff_int
 
     qint32 datasize = nel * 4;
 
-    *this << (qint32)kind;
-    *this << (qint32)FIFFT_FLOAT;
-    *this << (qint32)datasize;
-    *this << (qint32)FIFFV_NEXT_SEQ;
-
-//    this->setFloatingPointPrecision(QDataStream::SinglePrecision);
-
-    for(qint32 i = 0; i < nel; ++i)
-        *this << data[i];
+    this->begin_tag(kind, FIFFT_FLOAT, datasize);
+    this->stage_values(data, nel, 4);
+    this->end_tag();
 
     return pos;
 }
@@ -2656,24 +2845,16 @@ fiff_long_t FiffStream::write_float_matrix(fiff_int_t kind, const MatrixXf& mat)
 
     fiff_int_t datasize = 4*numel + 4*3;
 
-    *this << (qint32)kind;
-    *this << (qint32)FIFFT_MATRIX_FLOAT;
-    *this << (qint32)datasize;
-    *this << (qint32)FIFFV_NEXT_SEQ;
-
-    qint32 i, j;
-    // Storage order: row-major
-    for(i = 0; i < mat.rows(); ++i)
-        for(j = 0; j < mat.cols(); ++j)
-            *this << mat(i,j);
-
     qint32 dims[3];
     dims[0] = mat.cols();
     dims[1] = mat.rows();
     dims[2] = 2;
 
-    for(i = 0; i < 3; ++i)
-        *this << dims[i];
+    // Storage order: row-major, transposed straight into the staging buffer
+    this->begin_tag(kind, FIFFT_MATRIX_FLOAT, datasize);
+    this->stage_matrix_rows(mat.data(), mat.rows(), mat.cols());
+    this->stage_values(dims, 3, 4);
+    this->end_tag();
 
     return pos;
 }
@@ -2722,22 +2903,15 @@ fiff_long_t FiffStream::write_float_sparse_ccs(fiff_int_t kind, const SparseMatr
         }
     }
 
-    *this << (qint32)kind;
-    *this << (qint32)FIFFT_CCS_MATRIX_FLOAT;
-    *this << (qint32)datasize;
-    *this << (qint32)FIFFV_NEXT_SEQ;
-
-    //
-    //  The data values
     //
-    for(i = 0; i < s.size(); ++i)
-        *this << s[i].value();
-
-    //
-    //  Row indices
+    //  The data values and row indices
     //
-    for(i = 0; i < s.size(); ++i)
-        *this << s[i].row();
+    std::vector<float> values(s.size());
+    std::vector<qint32> inds(s.size());
+    for(i = 0; i < s.size(); ++i) {
+        values[i] = s[i].value();
+        inds[i] = s[i].row();
+    }
 
     //
     //  Pointers
@@ -2755,9 +2929,6 @@ fiff_long_t FiffStream::write_float_sparse_ccs(fiff_int_t kind, const SparseMatr
        if(ptrs[k-1] < 0)
           ptrs[k-1] = ptrs[k];
     //
-    for(i = 0; i < (quint32)ptrs.size(); ++i)
-        *this << ptrs[i];
-    //
     //   Dimensions
     //
     qint32 dims[4];
@@ -2766,8 +2937,12 @@ fiff_long_t FiffStream::write_float_sparse_ccs(fiff_int_t kind, const SparseMatr
     dims[2] = mat.cols();
     dims[3] = 2;
 
-    for(i = 0; i < 4; ++i)
-        *this << dims[i];
+    this->begin_tag(kind, FIFFT_CCS_MATRIX_FLOAT, datasize);
+    this->stage_values(values.data(), nnzm, 4);
+    this->stage_values(inds.data(), nnzm, 4);
+    this->stage_values(ptrs.data(), ptrs.size(), 4);
+    this->stage_values(dims, 4, 4);
+    this->end_tag();
 
     return pos;
 }
@@ -2817,24 +2992,14 @@ fiff_long_t FiffStream::write_float_sparse_rcs(fiff_int_t kind, const SparseMatr
     }
 
     //
-    // Write tag info header
-    //
-    *this << (qint32)kind;
-    *this << (qint32)FIFFT_RCS_MATRIX_FLOAT;
-    *this << (qint32)datasize;
-    *this << (qint32)FIFFV_NEXT_SEQ;
-
-    //
-    //  The data values
-    //
-    for(i = 0; i < s.size(); ++i)
-        *this << s[i].value();
-
+    //  The data values and column indices
     //
-    //  Column indices
-    //
-    for(i = 0; i < s.size(); ++i)
-        *this << s[i].col();
+    std::vector<float> values(s.size());
+    std::vector<qint32> inds(s.size());
+    for(i = 0; i < s.size(); ++i) {
+        values[i] = s[i].value();
+        inds[i] = s[i].col();
+    }
 
     //
     //  Pointers
@@ -2853,10 +3018,6 @@ fiff_long_t FiffStream::write_float_sparse_rcs(fiff_int_t kind, const SparseMatr
        if(ptrs[k-1] < 0)
           ptrs[k-1] = ptrs[k];
 
-    //
-    for(i = 0; i < (quint32)ptrs.size(); ++i)
-        *this << ptrs[i];
-
     //
     //  Dimensions
     //
@@ -2866,8 +3027,15 @@ fiff_long_t FiffStream::write_float_sparse_rcs(fiff_int_t kind, const SparseMatr
     dims[2] = mat.cols();
     dims[3] = 2;
 
-    for(i = 0; i < 4; ++i)
-        *this << dims[i];
+    //
+    // Write tag info header and data
+    //
+    this->begin_tag(kind, FIFFT_RCS_MATRIX_FLOAT, datasize);
+    this->stage_values(values.data(), nnzm, 4);
+    this->stage_values(inds.data(), nnzm, 4);
+    this->stage_values(ptrs.data(), ptrs.size(), 4);
+    this->stage_values(dims, 4, 4);
+    this->end_tag();
 
     return pos;
 }
@@ -2990,13 +3158,9 @@ fiff_long_t FiffStream::write_int(fiff_int_t kind, const fiff_int_t* data, fiff_
 
     fiff_int_t datasize = nel * 4;
 
-    *this << (qint32)kind;
-    *this << (qint32)FIFFT_INT;
-    *this << (qint32)datasize;
-    *this << (qint32)next;
-
-    for(qint32 i = 0; i < nel; ++i)
-        *this << data[i];
+    this->begin_tag(kind, FIFFT_INT, datasize, next);
+    this->stage_values(data, nel, 4);
+    this->end_tag();
 
     return pos;
 }
@@ -3015,24 +3179,16 @@ fiff_long_t FiffStream::write_int_matrix(fiff_int_t kind, const MatrixXi& mat)
 
     fiff_int_t datasize = 4*numel + 4*3;
 
-    *this << (qint32)kind;
-    *this << (qint32)FIFFT_MATRIX_INT;
-    *this << (qint32)datasize;
-    *this << (qint32)FIFFV_NEXT_SEQ;
-
-    qint32 i, j;
-    // Storage order: row-major
-    for(i = 0; i < mat.rows(); ++i)
-        for(j = 0; j < mat.cols(); ++j)
-            *this << mat(i,j);
-
     qint32 dims[3];
     dims[0] = mat.cols();
     dims[1] = mat.rows();
     dims[2] = 2;
 
-    for(i = 0; i < 3; ++i)
-        *this << dims[i];
+    // Storage order: row-major, transposed straight into the staging buffer
+    this->begin_tag(kind, FIFFT_MATRIX_INT, datasize);
+    this->stage_matrix_rows(mat.data(), mat.rows(), mat.cols());
+    this->stage_values(dims, 3, 4);
+    this->end_tag();
 
     return pos;
 }
@@ -44,6 +44,7 @@
 #include "fiff_global.h"
 #include "fiff_types.h"
 #include "fiff_id.h"
+#include "fiff_file.h"
 
 #include "fiff_dir_node.h"
 #include "fiff_dir_entry.h"
@@ -521,10 +522,11 @@ public:
     * @param[out] cals          Thecalibration matrix
     * @param[in] sel            Which channels will be included in the output file (optional)
     * @param[in] resetRange     Flag if the channel range is to be resetted to 1.0f (TODO: The flag was introduced due to conformity to the babyMEG system. See Limin commit from Oct 1st 2014)
+    * @param[in] data_type      The storage type of the data buffers which is written to FIFF_DATA_PACK (default FIFFT_FLOAT)
     *
-    * @return the started fiff file
+    * @return the started fiff file, empty if the device could not be opened
     */
-    static FiffStream::SPtr start_writing_raw(QIODevice &p_IODevice, const FiffInfo& info, RowVectorXd& cals, MatrixXi sel = defaultMatrixXi, bool resetRange = false);
+    static FiffStream::SPtr start_writing_raw(QIODevice &p_IODevice, const FiffInfo& info, RowVectorXd& cals, MatrixXi sel = defaultMatrixXi, bool resetRange = false, fiff_int_t data_type = FIFFT_FLOAT);
 
     //=========================================================================================================
     /**
@@ -866,6 +868,35 @@ public:
     */
     void write_rt_command(fiff_int_t command, const QString& data);
 
+    //=========================================================================================================
+    /**
+    * Starts a new tag in the staging buffer by writing its header. Together with stage_values() and end_tag()
+    * this replaces the per value QDataStream output for large tags: the values are byte-swapped in bulk into
+    * the staging buffer and the tag is written with one device write (or a few, if it exceeds the buffer size).
+    *
+    * @param[in] kind       The tag kind
+    * @param[in] type       The data type of the tag
+    * @param[in] datasize   The size of the tag data in bytes
+    * @param[in] next       The next tag (default FIFFV_NEXT_SEQ)
+    */
+    void begin_tag(fiff_int_t kind, fiff_int_t type, fiff_int_t datasize, fiff_int_t next = FIFFV_NEXT_SEQ);
+
+    //=========================================================================================================
+    /**
+    * Appends values to the staged tag, converted to big-endian byte order.
+    *
+    * @param[in] data       The values
+    * @param[in] nel        The number of values
+    * @param[in] size       The size of one value in bytes, 2, 4 or 8
+    */
+    void stage_values(const void* data, qint64 nel, int size);
+
+    //=========================================================================================================
+    /**
+    * Writes the staged bytes to the device.
+    */
+    void end_tag();
+
 private:
     //=========================================================================================================
     /**
@@ -889,6 +920,17 @@ private:
     */
     QList<FiffDirEntry::SPtr> make_dir(bool *ok=Q_NULLPTR);
 
+    //=========================================================================================================
+    /**
+    * Appends the values of a column-major matrix of 32 bit values to the staged tag in row-major order,
+    * converted to big-endian byte order. The rows are transposed in small blocks directly into the staging buffer.
+    *
+    * @param[in] data       The matrix values in column-major order
+    * @param[in] rows       The number of rows
+    * @param[in] cols       The number of columns
+    */
+    void stage_matrix_rows(const void* data, qint32 rows, qint32 cols);
+
 private:
 
 //    char         *file_name;    /**< Name of the file */ -> Use streamName() instead
@@ -897,6 +939,8 @@ private:
     QList<FiffDirEntry::SPtr>   m_dir;  /**< This is the directory. If no directory exists, open automatically scans the file to create one. */
 //    int         nent;           /**< How many entries? */ -> Use nent() instead
     FiffDirNode::SPtr           m_dirtree; /**< Directory compiled into a tree */
+    QByteArray                  m_baStaging;    /**< Staging buffer for bulk writes. Grows on demand up to FIFFSTREAM_STAGING_SIZE. */
+    qint64                      m_iStagingPos;  /**< Number of staged bytes in m_baStaging. */
 //    char        *ext_file_name; /**< Name of the file holding the external data */
 //    FILE        *ext_fd;        /**< The file descriptor of the above file if open  */
 
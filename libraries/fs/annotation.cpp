@@ -43,6 +43,8 @@
 #include "label.h"
 #include "surface.h"
 
+#include <utils/ioutils.h>
+
 
 //*************************************************************************************************************
 //=============================================================================================================
@@ -61,6 +63,7 @@
 #include <QFile>
 #include <QDataStream>
 #include <QFileInfo>
+#include <QHash>
 
 
 //*************************************************************************************************************
@@ -68,6 +71,7 @@
 // USED NAMESPACES
 //=============================================================================================================
 
+using namespace UTILSLIB;
 using namespace FSLIB;
 
 
@@ -188,14 +192,17 @@ bool Annotation::read(const QString& p_sFileName, Annotation &p_Annotation)
     qint32 numEl;
     t_Stream >> numEl;
 
-    p_Annotation.m_Vertices = VectorXi(numEl);
-    p_Annotation.m_LabelIds = VectorXi(numEl);
-
-    for(qint32 i = 0; i < numEl; ++i)
+    //vertex and label id pairs are read in one go and byte swapped afterwards
+    Matrix<qint32, Dynamic, 2, RowMajor> vertLabelIds(numEl, 2);
+    if(t_Stream.readRawData((char *)vertLabelIds.data(), numEl*2*sizeof(qint32)) != (int)(numEl*2*sizeof(qint32)))
     {
-        t_Stream >> p_Annotation.m_Vertices[i];
-        t_Stream >> p_Annotation.m_LabelIds[i];
+        printf("\tError: Unexpected end of the file\n");
+        return false;
     }
+    IOUtils::swap_intp(vertLabelIds.data(), vertLabelIds.size());
+
+    p_Annotation.m_Vertices = vertLabelIds.col(0);
+    p_Annotation.m_LabelIds = vertLabelIds.col(1);
 
     qint32 hasColortable;
     t_Stream >> hasColortable;
@@ -330,60 +337,68 @@ bool Annotation::toLabels(const Surface &p_surf, QList<Label> &p_qListLabels, QL
 
     printf("Converting labels from annotation...");
 
-//n_read = 0
-//labels = list()
-//label_colors = list()
-
     VectorXi label_ids = m_Colortable.getLabelIds();
     QStringList label_names = m_Colortable.getNames();
     MatrixX4i label_rgbas = m_Colortable.getRGBAs();
 
     // load the vertex positions from surface
-    MatrixX3f vert_pos = p_surf.rr();
+    const MatrixX3f& vert_pos = p_surf.rr();
+
+    //
+    // Bucket the vertices by their colortable entry in a single pass (counting sort), instead of searching all
+    // vertices once per entry. Vertices keep their ascending order within each bucket.
+    //
+    QHash<qint32, qint32> hashEntryIdx;
+    hashEntryIdx.reserve(label_ids.size());
+    for(qint32 i = label_ids.size() - 1; i >= 0; --i)
+        hashEntryIdx.insert(label_ids[i], i);   // first entry wins for duplicate ids
+
+    VectorXi vertEntryIdx(m_LabelIds.size());
+    VectorXi counts = VectorXi::Zero(label_ids.size());
+    for(qint32 j = 0; j < m_LabelIds.size(); ++j)
+    {
+        vertEntryIdx[j] = hashEntryIdx.value(m_LabelIds[j], -1);
+        if(vertEntryIdx[j] >= 0)
+            ++counts[vertEntryIdx[j]];
+    }
 
-//    qDebug() << label_rgbas.rows() << label_ids.size() << label_names.size();
+    VectorXi offsets(label_ids.size() + 1);
+    offsets[0] = 0;
+    for(qint32 i = 0; i < label_ids.size(); ++i)
+        offsets[i+1] = offsets[i] + counts[i];
 
-//    std::cout << label_ids;
+    VectorXi sortedVerts(offsets[label_ids.size()]);
+    VectorXi fill = offsets.head(label_ids.size());
+    for(qint32 j = 0; j < m_LabelIds.size(); ++j)
+        if(vertEntryIdx[j] >= 0)
+            sortedVerts[fill[vertEntryIdx[j]]++] = j;
 
-    qint32 label_id, count;
-    RowVector4i label_rgba;
     VectorXi vertices;
-    VectorXd values;
     MatrixX3f pos;
     QString name;
     for(qint32 i = 0; i < label_rgbas.rows(); ++i)
     {
-        label_id = label_ids[i];
-        label_rgba = label_rgbas.row(i);
-        count = 0;
-        vertices.resize(m_LabelIds.size());
-        //Where
-        for(qint32 j = 0; j < m_LabelIds.size(); ++j)
-        {
-            if(m_LabelIds[j] == label_id)
-            {
-                vertices[count] = j;
-                ++count;
-            }
-        }
+        // entries with a duplicate id share the bucket of the first one
+        qint32 bucket = hashEntryIdx.value(label_ids[i]);
+
         // check if label is part of cortical surface
-        if(count == 0)
+        if(counts[bucket] == 0)
             continue;
-        vertices.conservativeResize(count);
 
-        pos.resize(count, 3);
-        for(qint32 j = 0; j < count; ++j)
+        vertices = sortedVerts.segment(offsets[bucket], counts[bucket]);
+
+        pos.resize(vertices.size(), 3);
+        for(qint32 j = 0; j < vertices.size(); ++j)
             pos.row(j) = vert_pos.row(vertices[j]);
 
-        values = VectorXd::Zero(count);
         name = QString("%1-%2").arg(label_names[i]).arg(this->m_iHemi == 0 ? "lh" : "rh");
 
         // put it all together
         //t_tris
-        p_qListLabels.append(Label(vertices, pos, values, this->m_iHemi, name, label_id));
+        p_qListLabels.append(Label(vertices, pos, VectorXd::Zero(vertices.size()), this->m_iHemi, name, label_ids[i]));
 
         // store the color
-        p_qListLabelRGBAs.append(label_rgba);
+        p_qListLabelRGBAs.append(label_rgbas.row(i));
     }
 
 
@@ -419,3 +434,42 @@ bool Annotation::toLabels(const Surface &p_surf, QList<Label> &p_qListLabels, QL
 
     return true;
 }
+
+
+//*************************************************************************************************************
+
+void Annotation::serialize(QDataStream &p_Stream) const
+{
+    p_Stream << m_sFileName << m_sFilePath << m_iHemi;
+
+    IOUtils::write_eigen_matrix(m_Vertices, p_Stream);
+    IOUtils::write_eigen_matrix(m_LabelIds, p_Stream);
+
+    p_Stream << m_Colortable.orig_tab << m_Colortable.numEntries << m_Colortable.struct_names;
+    IOUtils::write_eigen_matrix(m_Colortable.table, p_Stream);
+}
+
+
+//*************************************************************************************************************
+
+bool Annotation::deserialize(QDataStream &p_Stream, Annotation &p_Annotation)
+{
+    p_Annotation.clear();
+
+    p_Stream >> p_Annotation.m_sFileName >> p_Annotation.m_sFilePath >> p_Annotation.m_iHemi;
+
+    bool bOk = IOUtils::read_eigen_matrix(p_Annotation.m_Vertices, p_Stream)
+            && IOUtils::read_eigen_matrix(p_Annotation.m_LabelIds, p_Stream);
+
+    if(bOk) {
+        p_Stream >> p_Annotation.m_Colortable.orig_tab >> p_Annotation.m_Colortable.numEntries >> p_Annotation.m_Colortable.struct_names;
+        bOk = IOUtils::read_eigen_matrix(p_Annotation.m_Colortable.table, p_Stream);
+    }
+
+    if(!bOk || p_Stream.status() != QDataStream::Ok) {
+        p_Annotation.clear();
+        return false;
+    }
+
+    return true;
+}
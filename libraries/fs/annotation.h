@@ -53,6 +53,7 @@
 
 #include <QString>
 #include <QSharedPointer>
+#include <QDataStream>
 
 
 //*************************************************************************************************************
@@ -266,6 +267,25 @@ public:
     */
     bool toLabels(const Surface &p_surf, QList<Label> &p_qListLabels, QList<RowVector4i> &p_qListLabelRGBAs) const;
 
+    //=========================================================================================================
+    /**
+    * Writes the parsed annotation in binary form to a stream, e.g., to cache it.
+    *
+    * @param[in] p_Stream   The stream to write to
+    */
+    void serialize(QDataStream &p_Stream) const;
+
+    //=========================================================================================================
+    /**
+    * Reads an annotation which was written by serialize.
+    *
+    * @param[in] p_Stream       The stream to read from
+    * @param[out] p_Annotation  The read annotation
+    *
+    * @return true if successful, false otherwise
+    */
+    static bool deserialize(QDataStream &p_Stream, Annotation &p_Annotation);
+
     //=========================================================================================================
     /**
     * annotation file path
@@ -41,7 +41,13 @@
 #include "annotationset.h"
 #include "surfaceset.h"
 
+#include <utils/ioutils.h>
+
 #include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QSaveFile>
+#include <QDataStream>
 #include <QDebug>
 
 
@@ -50,9 +56,74 @@
 // USED NAMESPACES
 //=============================================================================================================
 
+using namespace UTILSLIB;
 using namespace FSLIB;
 
 
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE GLOBAL METHODS
+//=============================================================================================================
+
+namespace
+{
+
+const quint32 ANNOTATIONSET_CACHE_MAGIC = 0x46534153;   /**< "FSAS" */
+const qint32 ANNOTATIONSET_CACHE_VERSION = 1;
+
+bool readAnnotationSetCache(const QString& sCacheFileName, const QByteArray& baKey, AnnotationSet& annotationSet)
+{
+    QFile file(sCacheFileName);
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic;
+    qint32 version, count;
+    QByteArray key;
+    stream >> magic >> version >> key >> count;
+    if(magic != ANNOTATIONSET_CACHE_MAGIC || version != ANNOTATIONSET_CACHE_VERSION || key != baKey || count < 0 || count > 2)
+        return false;
+
+    for(qint32 i = 0; i < count; ++i) {
+        Annotation t_Annotation;
+        if(!Annotation::deserialize(stream, t_Annotation)) {
+            annotationSet.clear();
+            return false;
+        }
+        annotationSet.insert(t_Annotation);
+    }
+
+    return true;
+}
+
+void writeAnnotationSetCache(const QString& sCacheFileName, const QByteArray& baKey, AnnotationSet& annotationSet)
+{
+    QDir().mkpath(QFileInfo(sCacheFileName).absolutePath());
+
+    QSaveFile file(sCacheFileName);
+    if(!file.open(QIODevice::WriteOnly)) {
+        qWarning("AnnotationSet: Could not write cache file %s", sCacheFileName.toUtf8().constData());
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    stream << ANNOTATIONSET_CACHE_MAGIC << ANNOTATIONSET_CACHE_VERSION << baKey << (qint32)annotationSet.size();
+
+    QMap<qint32, Annotation>::const_iterator it;
+    for(it = annotationSet.data().constBegin(); it != annotationSet.data().constEnd(); ++it)
+        it.value().serialize(stream);
+
+    file.commit();
+}
+
+}
+
+
 //*************************************************************************************************************
 //=============================================================================================================
 // DEFINE MEMBER METHODS
@@ -124,10 +195,10 @@ AnnotationSet::AnnotationSet(const Annotation& p_LHAnnotation, const Annotation&
 
 //*************************************************************************************************************
 
-AnnotationSet::AnnotationSet(const QString& p_sLHFileName, const QString& p_sRHFileName)
+AnnotationSet::AnnotationSet(const QString& p_sLHFileName, const QString& p_sRHFileName, const QString& p_sCacheDir)
 {
     AnnotationSet t_AnnotationSet;
-    if(AnnotationSet::read(p_sLHFileName, p_sRHFileName, t_AnnotationSet))
+    if(AnnotationSet::read(p_sLHFileName, p_sRHFileName, t_AnnotationSet, p_sCacheDir))
         *this = t_AnnotationSet;
 }
 
@@ -156,13 +227,27 @@ void AnnotationSet::insert(const Annotation& p_Annotation)
 
 //*************************************************************************************************************
 
-bool AnnotationSet::read(const QString& p_sLHFileName, const QString& p_sRHFileName, AnnotationSet &p_AnnotationSet)
+bool AnnotationSet::read(const QString& p_sLHFileName, const QString& p_sRHFileName, AnnotationSet &p_AnnotationSet, const QString& p_sCacheDir)
 {
     p_AnnotationSet.clear();
 
     QStringList t_qListFileName;
     t_qListFileName << p_sLHFileName << p_sRHFileName;
 
+    QString sCacheFileName;
+    QByteArray baKey;
+    if(!p_sCacheDir.isEmpty())
+    {
+        baKey = IOUtils::file_stamp_key(t_qListFileName);
+        sCacheFileName = QString("%1/%2-%3.bin").arg(p_sCacheDir).arg(QFileInfo(p_sLHFileName).fileName()).arg(QString(baKey.toHex().left(16)));
+
+        if(readAnnotationSetCache(sCacheFileName, baKey, p_AnnotationSet))
+        {
+            printf("Read annotation set from cache %s\n", sCacheFileName.toUtf8().constData());
+            return true;
+        }
+    }
+
     for(qint32 i = 0; i < t_qListFileName.size(); ++i)
     {
         Annotation t_Annotation;
@@ -177,6 +262,9 @@ bool AnnotationSet::read(const QString& p_sLHFileName, const QString& p_sRHFileN
         }
     }
 
+    if(!sCacheFileName.isEmpty() && !p_AnnotationSet.isEmpty())
+        writeAnnotationSetCache(sCacheFileName, baKey, p_AnnotationSet);
+
     return true;
 }
 
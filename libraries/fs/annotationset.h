@@ -141,8 +141,9 @@ public:
     *
     * @param[in] p_sLHFileName  Left hemisphere annotation file
     * @param[in] p_sRHFileName  Right hemisphere annotation file
+    * @param[in] p_sCacheDir    Directory of the binary cache of parsed annotation sets. No cache is used if empty (default).
     */
-    explicit AnnotationSet(const QString& p_sLHFileName, const QString& p_sRHFileName);
+    explicit AnnotationSet(const QString& p_sLHFileName, const QString& p_sRHFileName, const QString& p_sCacheDir = QString());
 
     //=========================================================================================================
     /**
@@ -184,13 +185,17 @@ public:
     /**
     * Reads different annotation files and assembles them to a AnnotationSet
     *
+    * If a cache directory is given, the parsed annotations are stored there in binary form and read from there on
+    * subsequent calls, as long as the annotation files did not change.
+    *
     * @param[in] p_sLHFileName  Left hemisphere annotation file
     * @param[in] p_sRHFileName  Right hemisphere annotation file
     * @param[out] p_AnnotationSet   The read annotation set
+    * @param[in] p_sCacheDir    Directory of the binary cache. No cache is used if empty (default).
     *
     * @return true if succesfull, false otherwise
     */
-    static bool read(const QString& p_sLHFileName, const QString& p_sRHFileName, AnnotationSet &p_AnnotationSet);
+    static bool read(const QString& p_sLHFileName, const QString& p_sRHFileName, AnnotationSet &p_AnnotationSet, const QString& p_sCacheDir = QString());
 
     //=========================================================================================================
     /**
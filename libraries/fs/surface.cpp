@@ -52,6 +52,17 @@
 #include <QFile>
 #include <QDataStream>
 #include <QTextStream>
+#include <QThread>
+#include <QVector>
+#include <QtConcurrent>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Geometry>
 
 
 //*************************************************************************************************************
@@ -63,6 +74,26 @@ using namespace UTILSLIB;
 using namespace FSLIB;
 
 
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE GLOBAL METHODS
+//=============================================================================================================
+
+namespace
+{
+
+const qint32 SURFACE_NORMALS_MIN_BLOCK_SIZE = 65536;    /**< Minimal number of triangles per concurrently processed block. */
+
+struct NormalBlock
+{
+    qint32 iFirstTri;                               /**< First triangle of the block. */
+    qint32 iLastTri;                                /**< One past the last triangle of the block. */
+    Matrix<float, Dynamic, 3, RowMajor> matNN;      /**< Accumulated vertex normals of the block. */
+};
+
+}
+
+
 //*************************************************************************************************************
 //=============================================================================================================
 // DEFINE MEMBER METHODS
@@ -144,45 +175,41 @@ void Surface::clear()
 MatrixX3f Surface::compute_normals(const MatrixX3f& rr, const MatrixX3i& tris)
 {
     printf("\tcomputing normals\n");
-    // first, compute triangle normals
-    MatrixX3f r1(tris.rows(),3); MatrixX3f r2(tris.rows(),3); MatrixX3f r3(tris.rows(),3);
 
-    for(qint32 i = 0; i < tris.rows(); ++i)
-    {
-        r1.row(i) = rr.row(tris(i, 0));
-        r2.row(i) = rr.row(tris(i, 1));
-        r3.row(i) = rr.row(tris(i, 2));
-    }
+    //
+    // The triangles are split into blocks. Each block accumulates the normalized triangle normals of its triangles
+    // into its own vertex normal matrix, hence the blocks can be processed concurrently without locking.
+    //
+    qint32 nBlocks = qBound(1, (qint32)(tris.rows() / SURFACE_NORMALS_MIN_BLOCK_SIZE), QThread::idealThreadCount());
 
-    MatrixX3f x = r2 - r1;
-    MatrixX3f y = r3 - r1;
-    MatrixX3f tri_nn(x.rows(),y.cols());
-    tri_nn.col(0) = x.col(1).cwiseProduct(y.col(2)) - x.col(2).cwiseProduct(y.col(1));
-    tri_nn.col(1) = x.col(2).cwiseProduct(y.col(0)) - x.col(0).cwiseProduct(y.col(2));
-    tri_nn.col(2) = x.col(0).cwiseProduct(y.col(1)) - x.col(1).cwiseProduct(y.col(0));
+    QVector<NormalBlock> blocks(nBlocks);
+    qint32 blockSize = (qint32)(tris.rows() / nBlocks) + 1;
+    for(qint32 i = 0; i < nBlocks; ++i) {
+        blocks[i].iFirstTri = i * blockSize;
+        blocks[i].iLastTri = qMin((qint32)tris.rows(), (i + 1) * blockSize);
+    }
 
-    //   Triangle normals and areas
-    MatrixX3f tmp = tri_nn.cwiseProduct(tri_nn);
-    VectorXf normSize = tmp.rowwise().sum();
-    normSize = normSize.cwiseSqrt();
+    QtConcurrent::blockingMap(blocks, [&rr, &tris](NormalBlock& block) {
+        block.matNN = Matrix<float, Dynamic, 3, RowMajor>::Zero(rr.rows(), 3);
 
-    for(qint32 i = 0; i < normSize.size(); ++i)
-        if(normSize(i) != 0)
-            tri_nn.row(i) /= normSize(i);
+        for(qint32 p = block.iFirstTri; p < block.iLastTri; ++p) {
+            Vector3f r1 = rr.row(tris(p,0));
+            Vector3f triNN = (rr.row(tris(p,1)).transpose() - r1).cross(rr.row(tris(p,2)).transpose() - r1);
 
-    MatrixX3f nn = MatrixX3f::Zero(rr.rows(), 3);
+            float normSize = triNN.norm();
+            if(normSize != 0)
+                triNN /= normSize;
 
-    for(qint32 p = 0; p < tris.rows(); ++p)
-    {
-        Vector3i verts = tris.row(p);
-        for(qint32 j = 0; j < verts.size(); ++j)
-            nn.row(verts(j)) = tri_nn.row(p);
-    }
+            for(qint32 j = 0; j < 3; ++j)
+                block.matNN.row(tris(p,j)) += triNN.transpose();
+        }
+    });
 
-    tmp = nn.cwiseProduct(nn);
-    normSize = tmp.rowwise().sum();
-    normSize = normSize.cwiseSqrt();
+    Matrix<float, Dynamic, 3, RowMajor> nn = blocks[0].matNN;
+    for(qint32 i = 1; i < nBlocks; ++i)
+        nn += blocks[i].matNN;
 
+    VectorXf normSize = nn.rowwise().norm();
     for(qint32 i = 0; i < normSize.size(); ++i)
         if(normSize(i) != 0)
             nn.row(i) /= normSize(i);
@@ -263,8 +290,10 @@ bool Surface::read(const QString &p_sFile, Surface &p_Surface, bool p_bLoadCurva
     qint32 nvert = 0;
     qint32 nquad = 0;
     qint32 nface = 0;
-    MatrixXf verts;
-    MatrixXi faces;
+
+    //vertices and faces are stored interleaved in the file, hence they are read in one go into row major storage
+    Matrix<float, Dynamic, 3, RowMajor> verts;
+    Matrix<qint32, Dynamic, 3, RowMajor> faces;
 
     if(magic == QUAD_FILE_MAGIC_NUMBER || magic == NEW_QUAD_FILE_MAGIC_NUMBER)
     {
@@ -276,70 +305,43 @@ bool Surface::read(const QString &p_sFile, Surface &p_Surface, bool p_bLoadCurva
             printf("\t%s is a new quad file (nvert = %d nquad = %d)\n", p_sFile.toUtf8().constData(),nvert,nquad);
 
         //vertices
-        verts.resize(nvert, 3);
         if(magic == QUAD_FILE_MAGIC_NUMBER)
         {
-            qint16 iVal;
-            for(qint32 i = 0; i < nvert; ++i)
-            {
-                for(qint32 j = 0; j < 3; ++j)
-                {
-                    t_DataStream >> iVal;
-                    IOUtils::swap_short(iVal);
-                    verts(i,j) = ((float)iVal) / 100;
-                }
+            Matrix<qint16, Dynamic, 3, RowMajor> iVerts(nvert, 3);
+            if(t_DataStream.readRawData((char *)iVerts.data(), nvert*3*sizeof(qint16)) != (int)(nvert*3*sizeof(qint16))) {
+                qWarning("Unexpected end of surface file %s",p_sFile.toUtf8().constData());
+                return false;
             }
+            IOUtils::swap_shortp(iVerts.data(), iVerts.size());
+            verts = iVerts.cast<float>() / 100.0f;
         }
         else
         {
-            t_DataStream.readRawData((char *)verts.data(), nvert*3*sizeof(float));
-            for(qint32 i = 0; i < nvert; ++i)
-                for(qint32 j = 0; j < 3; ++j)
-                    IOUtils::swap_floatp(&verts(i,j));
-        }
-
-        MatrixXi quads = IOUtils::fread3_many(t_DataStream, nquad*4);
-        MatrixXi quads_new(4, nquad);
-        qint32 count = 0;
-        for(qint32 j = 0; j < quads.cols(); ++j)
-        {
-            for(qint32 i = 0; i < quads.rows(); ++i)
-            {
-                quads_new(i,j) = quads(count, 0);
-                ++count;
+            verts.resize(nvert, 3);
+            if(t_DataStream.readRawData((char *)verts.data(), nvert*3*sizeof(float)) != (int)(nvert*3*sizeof(float))) {
+                qWarning("Unexpected end of surface file %s",p_sFile.toUtf8().constData());
+                return false;
             }
+            IOUtils::swap_floatp(verts.data(), verts.size());
         }
-        quads = quads_new.transpose();
+
+        VectorXi quadData = IOUtils::fread3_many(t_DataStream, nquad*4);
+        Map<const Matrix<int, Dynamic, 4, RowMajor> > quads(quadData.data(), nquad, 4);
         //
         //  Face splitting follows
         //
-        faces = MatrixXi::Zero(2*nquad,3);
+        faces.resize(2*nquad,3);
         for(qint32 k = 0; k < nquad; ++k)
         {
-            RowVectorXi quad = quads.row(k);
-            if ((quad[0] % 2) == 0)
+            if ((quads(k,0) % 2) == 0)
             {
-                faces(nface,0) = quad[0];
-                faces(nface,1) = quad[1];
-                faces(nface,2) = quad[3];
-                ++nface;
-
-                faces(nface,0) = quad[2];
-                faces(nface,1) = quad[3];
-                faces(nface,2) = quad[1];
-                ++nface;
+                faces.row(nface++) << quads(k,0), quads(k,1), quads(k,3);
+                faces.row(nface++) << quads(k,2), quads(k,3), quads(k,1);
             }
             else
             {
-                faces(nface,0) = quad(0);
-                faces(nface,1) = quad(1);
-                faces(nface,2) = quad(2);
-                ++nface;
-
-                faces(nface,0) = quad(0);
-                faces(nface,1) = quad(2);
-                faces(nface,2) = quad(3);
-                ++nface;
+                faces.row(nface++) << quads(k,0), quads(k,1), quads(k,2);
+                faces.row(nface++) << quads(k,0), quads(k,2), quads(k,3);
             }
         }
     }
@@ -350,31 +352,25 @@ bool Surface::read(const QString &p_sFile, Surface &p_Surface, bool p_bLoadCurva
 
         t_DataStream >> nvert;
         t_DataStream >> nface;
-        IOUtils::swap_int(nvert);
-        IOUtils::swap_int(nface);
 
         printf("\t%s is a triangle file (nvert = %d ntri = %d)\n", p_sFile.toUtf8().constData(), nvert, nface);
         printf("\t%s", s.toUtf8().constData());
 
         //vertices
-        verts.resize(3, nvert);
-        t_DataStream.readRawData((char *)verts.data(), nvert*3*sizeof(float));
-        for(qint32 i = 0; i < 3; ++i)
-            for(qint32 j = 0; j < nvert; ++j)
-                IOUtils::swap_floatp(&verts(i,j));
+        verts.resize(nvert, 3);
+        if(t_DataStream.readRawData((char *)verts.data(), nvert*3*sizeof(float)) != (int)(nvert*3*sizeof(float))) {
+            qWarning("Unexpected end of surface file %s",p_sFile.toUtf8().constData());
+            return false;
+        }
+        IOUtils::swap_floatp(verts.data(), verts.size());
 
         //faces
         faces.resize(nface, 3);
-        qint32 iVal;
-        for(qint32 i = 0; i < nface; ++i)
-        {
-            for(qint32 j = 0; j < 3; ++j)
-            {
-                t_DataStream >> iVal;
-                IOUtils::swap_int(iVal);
-                faces(i,j) = iVal;
-            }
+        if(t_DataStream.readRawData((char *)faces.data(), nface*3*sizeof(qint32)) != (int)(nface*3*sizeof(qint32))) {
+            qWarning("Unexpected end of surface file %s",p_sFile.toUtf8().constData());
+            return false;
         }
+        IOUtils::swap_intp(faces.data(), faces.size());
     }
     else
     {
@@ -382,11 +378,10 @@ bool Surface::read(const QString &p_sFile, Surface &p_Surface, bool p_bLoadCurva
         return false;
     }
 
-    verts.transposeInPlace();
-    verts.array() *= 0.001f;
+    verts *= 0.001f;
 
-    p_Surface.m_matRR = verts.block(0,0,verts.rows(),3);
-    p_Surface.m_matTris = faces.block(0,0,faces.rows(),3);
+    p_Surface.m_matRR = verts;
+    p_Surface.m_matTris = faces;
 
     //-> not needed since qglbuilder is doing that for us
     p_Surface.m_matNN = compute_normals(p_Surface.m_matRR, p_Surface.m_matTris);
@@ -420,6 +415,40 @@ bool Surface::read(const QString &p_sFile, Surface &p_Surface, bool p_bLoadCurva
 }
 
 
+//*************************************************************************************************************
+
+void Surface::serialize(QDataStream &p_Stream) const
+{
+    p_Stream << m_sFilePath << m_sFileName << m_iHemi << m_sSurf;
+
+    IOUtils::write_eigen_matrix(m_matRR, p_Stream);
+    IOUtils::write_eigen_matrix(m_matTris, p_Stream);
+    IOUtils::write_eigen_matrix(m_matNN, p_Stream);
+    IOUtils::write_eigen_matrix(m_vecCurv, p_Stream);
+}
+
+
+//*************************************************************************************************************
+
+bool Surface::deserialize(QDataStream &p_Stream, Surface &p_Surface)
+{
+    p_Surface.clear();
+
+    p_Stream >> p_Surface.m_sFilePath >> p_Surface.m_sFileName >> p_Surface.m_iHemi >> p_Surface.m_sSurf;
+
+    if(!IOUtils::read_eigen_matrix(p_Surface.m_matRR, p_Stream)
+            || !IOUtils::read_eigen_matrix(p_Surface.m_matTris, p_Stream)
+            || !IOUtils::read_eigen_matrix(p_Surface.m_matNN, p_Stream)
+            || !IOUtils::read_eigen_matrix(p_Surface.m_vecCurv, p_Stream)
+            || p_Stream.status() != QDataStream::Ok) {
+        p_Surface.clear();
+        return false;
+    }
+
+    return true;
+}
+
+
 //*************************************************************************************************************
 
 VectorXf Surface::read_curv(const QString &p_sFileName)
@@ -450,22 +479,23 @@ VectorXf Surface::read_curv(const QString &p_sFileName)
         t_DataStream >> vals_per_vertex;
 
         curv.resize(vnum, 1);
-        t_DataStream.readRawData((char *)curv.data(), vnum*sizeof(float));
-        for(qint32 i = 0; i < vnum; ++i)
-           IOUtils::swap_floatp(&curv(i));
+        if(t_DataStream.readRawData((char *)curv.data(), vnum*sizeof(float)) != (int)(vnum*sizeof(float))) {
+            printf("\tError: Unexpected end of the curvature file\n");
+            return VectorXf();
+        }
+        IOUtils::swap_floatp(curv.data(), vnum);
     }
     else
     {
         qint32 fnum = IOUtils::fread3(t_DataStream);
         Q_UNUSED(fnum)
-        qint16 iVal;
-        curv.resize(vnum, 1);
-        for(qint32 i = 0; i < vnum; ++i)
-        {
-            t_DataStream >> iVal;
-            IOUtils::swap_short(iVal);
-            curv(i) = ((float)iVal) / 100;
+        Matrix<qint16, Dynamic, 1> iCurv(vnum);
+        if(t_DataStream.readRawData((char *)iCurv.data(), vnum*sizeof(qint16)) != (int)(vnum*sizeof(qint16))) {
+            printf("\tError: Unexpected end of the curvature file\n");
+            return VectorXf();
         }
+        IOUtils::swap_shortp(iCurv.data(), vnum);
+        curv = iCurv.cast<float>() / 100.0f;
     }
     t_File.close();
 
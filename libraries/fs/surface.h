@@ -50,6 +50,7 @@
 //=============================================================================================================
 
 #include <QSharedPointer>
+#include <QDataStream>
 
 
 //*************************************************************************************************************
@@ -224,7 +225,27 @@ public:
 
     //=========================================================================================================
     /**
-    * Efficiently compute vertex normals for triangulated surface
+    * Writes the parsed surface in binary form to a stream, e.g., to cache it.
+    *
+    * @param[in] p_Stream   The stream to write to
+    */
+    void serialize(QDataStream &p_Stream) const;
+
+    //=========================================================================================================
+    /**
+    * Reads a surface which was written by serialize.
+    *
+    * @param[in] p_Stream       The stream to read from
+    * @param[out] p_Surface     The read surface
+    *
+    * @return true if read sucessful, false otherwise
+    */
+    static bool deserialize(QDataStream &p_Stream, Surface &p_Surface);
+
+    //=========================================================================================================
+    /**
+    * Efficiently compute vertex normals for triangulated surface. The normalized triangle normals are accumulated
+    * at their vertices, large surfaces are processed concurrently.
     *
     * @param[in] rr     Vertex coordinates in meters
     * @param[out] tris  The triangle descriptions
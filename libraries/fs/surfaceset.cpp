@@ -40,6 +40,8 @@
 
 #include "surfaceset.h"
 
+#include <utils/ioutils.h>
+
 
 //*************************************************************************************************************
 //=============================================================================================================
@@ -47,6 +49,11 @@
 //=============================================================================================================
 
 #include <QStringList>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QSaveFile>
+#include <QDataStream>
 
 
 //*************************************************************************************************************
@@ -54,9 +61,74 @@
 // USED NAMESPACES
 //=============================================================================================================
 
+using namespace UTILSLIB;
 using namespace FSLIB;
 
 
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE GLOBAL METHODS
+//=============================================================================================================
+
+namespace
+{
+
+const quint32 SURFACESET_CACHE_MAGIC = 0x46535353;  /**< "FSSS" */
+const qint32 SURFACESET_CACHE_VERSION = 1;
+
+bool readSurfaceSetCache(const QString& sCacheFileName, const QByteArray& baKey, SurfaceSet& surfaceSet)
+{
+    QFile file(sCacheFileName);
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic;
+    qint32 version, count;
+    QByteArray key;
+    stream >> magic >> version >> key >> count;
+    if(magic != SURFACESET_CACHE_MAGIC || version != SURFACESET_CACHE_VERSION || key != baKey || count < 0 || count > 2)
+        return false;
+
+    for(qint32 i = 0; i < count; ++i) {
+        Surface t_Surface;
+        if(!Surface::deserialize(stream, t_Surface)) {
+            surfaceSet.clear();
+            return false;
+        }
+        surfaceSet.insert(t_Surface);
+    }
+
+    return true;
+}
+
+void writeSurfaceSetCache(const QString& sCacheFileName, const QByteArray& baKey, SurfaceSet& surfaceSet)
+{
+    QDir().mkpath(QFileInfo(sCacheFileName).absolutePath());
+
+    QSaveFile file(sCacheFileName);
+    if(!file.open(QIODevice::WriteOnly)) {
+        qWarning("SurfaceSet: Could not write cache file %s", sCacheFileName.toUtf8().constData());
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    stream << SURFACESET_CACHE_MAGIC << SURFACESET_CACHE_VERSION << baKey << (qint32)surfaceSet.size();
+
+    QMap<qint32, Surface>::const_iterator it;
+    for(it = surfaceSet.data().constBegin(); it != surfaceSet.data().constEnd(); ++it)
+        it.value().serialize(stream);
+
+    file.commit();
+}
+
+}
+
+
 //*************************************************************************************************************
 //=============================================================================================================
 // DEFINE MEMBER METHODS
@@ -132,10 +204,10 @@ SurfaceSet::SurfaceSet(const Surface& p_LHSurface, const Surface& p_RHSurface)
 
 //*************************************************************************************************************
 
-SurfaceSet::SurfaceSet(const QString& p_sLHFileName, const QString& p_sRHFileName)
+SurfaceSet::SurfaceSet(const QString& p_sLHFileName, const QString& p_sRHFileName, const QString& p_sCacheDir)
 {
     SurfaceSet t_SurfaceSet;
-    if(SurfaceSet::read(p_sLHFileName, p_sRHFileName, t_SurfaceSet))
+    if(SurfaceSet::read(p_sLHFileName, p_sRHFileName, t_SurfaceSet, p_sCacheDir))
         *this = t_SurfaceSet;
 }
 
@@ -171,13 +243,33 @@ void SurfaceSet::insert(const Surface& p_Surface)
 
 //*************************************************************************************************************
 
-bool SurfaceSet::read(const QString& p_sLHFileName, const QString& p_sRHFileName, SurfaceSet &p_SurfaceSet)
+bool SurfaceSet::read(const QString& p_sLHFileName, const QString& p_sRHFileName, SurfaceSet &p_SurfaceSet, const QString& p_sCacheDir)
 {
     p_SurfaceSet.clear();
 
     QStringList t_qListFileName;
     t_qListFileName << p_sLHFileName << p_sRHFileName;
 
+    QString sCacheFileName;
+    QByteArray baKey;
+    if(!p_sCacheDir.isEmpty())
+    {
+        //the parsed surfaces contain the curvature, hence the curvature files are part of the key
+        QStringList t_qListSourceFiles = t_qListFileName;
+        for(qint32 i = 0; i < t_qListFileName.size(); ++i)
+            t_qListSourceFiles << QString("%1/%2.curv").arg(QFileInfo(t_qListFileName[i]).absolutePath()).arg(t_qListFileName[i].contains("lh.") ? "lh" : "rh");
+
+        baKey = IOUtils::file_stamp_key(t_qListSourceFiles);
+        sCacheFileName = QString("%1/%2-%3.bin").arg(p_sCacheDir).arg(QFileInfo(p_sLHFileName).fileName()).arg(QString(baKey.toHex().left(16)));
+
+        if(readSurfaceSetCache(sCacheFileName, baKey, p_SurfaceSet))
+        {
+            printf("Read surface set from cache %s\n", sCacheFileName.toUtf8().constData());
+            p_SurfaceSet.calcOffset();
+            return true;
+        }
+    }
+
     for(qint32 i = 0; i < t_qListFileName.size(); ++i)
     {
         Surface t_Surface;
@@ -194,6 +286,9 @@ bool SurfaceSet::read(const QString& p_sLHFileName, const QString& p_sRHFileName
 
     p_SurfaceSet.calcOffset();
 
+    if(!sCacheFileName.isEmpty() && !p_SurfaceSet.isEmpty())
+        writeSurfaceSetCache(sCacheFileName, baKey, p_SurfaceSet);
+
     return true;
 }
 
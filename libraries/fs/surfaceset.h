@@ -124,12 +124,13 @@ public:
 
     //=========================================================================================================
     /**
-    * Constructs an annotation set by reading from annotation files
+    * Constructs a surface set by reading from surface files
     *
-    * @param[in] p_sLHFileName  Left hemisphere annotation file
-    * @param[in] p_sRHFileName  Right hemisphere annotation file
+    * @param[in] p_sLHFileName  Left hemisphere surface file
+    * @param[in] p_sRHFileName  Right hemisphere surface file
+    * @param[in] p_sCacheDir    Directory of the binary cache of parsed surface sets. No cache is used if empty (default).
     */
-    explicit SurfaceSet(const QString& p_sLHFileName, const QString& p_sRHFileName);
+    explicit SurfaceSet(const QString& p_sLHFileName, const QString& p_sRHFileName, const QString& p_sCacheDir = QString());
 
     //=========================================================================================================
     /**
@@ -171,13 +172,17 @@ public:
     /**
     * Reads different surface files and assembles them to a SurfaceSet
     *
+    * If a cache directory is given, the parsed surfaces (incl. normals and curvature) are stored there in binary form
+    * and read from there on subsequent calls, as long as the surface and curvature files did not change.
+    *
     * @param[in] p_sLHFileName      Left hemisphere surface file
     * @param[in] p_sRHFileName      Right hemisphere surface file
     * @param[out] p_SurfaceSet      The read surface set
+    * @param[in] p_sCacheDir        Directory of the binary cache. No cache is used if empty (default).
     *
     * @return true if succesfull, false otherwise
     */
-    static bool read(const QString& p_sLHFileName, const QString& p_sRHFileName, SurfaceSet &p_SurfaceSet);
+    static bool read(const QString& p_sLHFileName, const QString& p_sRHFileName, SurfaceSet &p_SurfaceSet, const QString& p_sCacheDir = QString());
 
     //=========================================================================================================
     /**
@@ -100,6 +100,8 @@ SOURCES += \
     minimumNorm/minimumnorm.cpp \
     rapMusic/rapmusic.cpp \
     rapMusic/pwlrapmusic.cpp \
+    rapMusic/rapmusicpairscan.cpp \
+    rapMusic/streamingrapmusic.cpp \
     rapMusic/dipole.cpp \
     dipoleFit/dipole_fit.cpp \
     dipoleFit/dipole_fit_data.cpp \
@@ -121,6 +123,8 @@ HEADERS +=\
     minimumNorm/minimumnorm.h \
     rapMusic/rapmusic.h \
     rapMusic/pwlrapmusic.h \
+    rapMusic/rapmusicpairscan.h \
+    rapMusic/streamingrapmusic.h \
     rapMusic/dipole.h \
     dipoleFit/analyze_types.h \
     dipoleFit/dipole_fit.h \
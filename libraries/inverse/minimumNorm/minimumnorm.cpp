@@ -77,6 +77,7 @@ using namespace INVERSELIB;
 
 MinimumNorm::MinimumNorm(const MNEInverseOperator &p_inverseOperator, float lambda, const QString method)
 : m_inverseOperator(p_inverseOperator)
+, m_invOpBuilder(p_inverseOperator)
 , inverseSetup(false)
 {
     this->setRegularization(lambda);
@@ -87,6 +88,7 @@ MinimumNorm::MinimumNorm(const MNEInverseOperator &p_inverseOperator, float lamb
 
 MinimumNorm::MinimumNorm(const MNEInverseOperator &p_inverseOperator, float lambda, bool dSPM, bool sLORETA)
 : m_inverseOperator(p_inverseOperator)
+, m_invOpBuilder(p_inverseOperator)
 , inverseSetup(false)
 {
     this->setRegularization(lambda);
@@ -249,7 +251,7 @@ void MinimumNorm::doInverseSetup(qint32 nave, bool pick_normal)
     //
     //   Set up the inverse according to the parameters
     //
-    inv = m_inverseOperator.prepare_inverse_operator(nave, m_fLambda, m_bdSPM, m_bsLORETA);
+    inv = m_invOpBuilder.prepareInverseOperator(nave, m_fLambda, m_bdSPM, m_bsLORETA);
 
     printf("Computing inverse...");
     inv.assemble_kernel(label, m_sMethod, pick_normal, K, noise_norm, vertno);
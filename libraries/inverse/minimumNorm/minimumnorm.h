@@ -45,6 +45,7 @@
 #include "../IInverseAlgorithm.h"
 
 #include <mne/mne_inverse_operator.h>
+#include <mne/mne_inverse_operator_builder.h>
 #include <fs/label.h>
 
 #include <QSharedPointer>
@@ -171,6 +172,7 @@ public:
 
 private:
     MNEInverseOperator m_inverseOperator;   /**< The inverse operator */
+    MNEInverseOperatorBuilder m_invOpBuilder; /**< Prepares the inverse operator with cached whitener and noise norms */
     float m_fLambda;                        /**< Regularization parameter */
     QString m_sMethod;                      /**< Selected method */
     bool m_bsLORETA;                        /**< Do sLORETA method */
@@ -221,30 +221,52 @@ MNESourceEstimate PwlRapMusic::calculateInverse(const MatrixXd& p_matMeasurement
 
         int t_iNumVecElements = m_iNumGridPoints;
 
+        RapMusicPairScan t_pairScan;
+        if(m_bUsePairScan)
+            t_pairScan.setSubspace(t_matProj_LeadField, t_matU_B);
+
         while(t_iMaxFound == 0)
         {
-
-            //Multithreading correlation calculation
-            #ifdef _OPENMP
-            #pragma omp parallel num_threads(m_iMaxNumThreads)
-            #endif
+            if(m_bUsePairScan)
             {
-            #ifdef _OPENMP
-            #pragma omp for
-            #endif
+                //All pairs of the current row at once from the per source bases
+                VectorXd t_vecRowCorr;
+                t_pairScan.rowCorrelations(t_iCurrentRow, t_vecRowCorr);
+
                 for(int i = 0; i < t_iNumVecElements; i++)
                 {
                     int k = t_pVecIdxElements(i);
-                    //new Version: calculate matrix multiplication before
-                    //Create Lead Field combinations -> It would be better to use a pointer construction, to increase performance
-                    MatrixX6T t_matProj_G(t_matProj_LeadField.rows(),6);
 
                     int idx1 = m_ppPairIdxCombinations[k]->x1;
                     int idx2 = m_ppPairIdxCombinations[k]->x2;
 
-                    RapMusic::getGainMatrixPair(t_matProj_LeadField, t_matProj_G, idx1, idx2);
-
-                    t_vecRoh(k) = RapMusic::subcorr(t_matProj_G, t_matU_B);//t_vecRoh holds the correlations roh_k
+                    t_vecRoh(k) = t_vecRowCorr(idx1 == t_iCurrentRow ? idx2 : idx1);
+                }
+            }
+            else
+            {
+                //Multithreading correlation calculation
+                #ifdef _OPENMP
+                #pragma omp parallel num_threads(m_iMaxNumThreads)
+                #endif
+                {
+                #ifdef _OPENMP
+                #pragma omp for
+                #endif
+                    for(int i = 0; i < t_iNumVecElements; i++)
+                    {
+                        int k = t_pVecIdxElements(i);
+                        //new Version: calculate matrix multiplication before
+                        //Create Lead Field combinations -> It would be better to use a pointer construction, to increase performance
+                        MatrixX6T t_matProj_G(t_matProj_LeadField.rows(),6);
+
+                        int idx1 = m_ppPairIdxCombinations[k]->x1;
+                        int idx2 = m_ppPairIdxCombinations[k]->x2;
+
+                        RapMusic::getGainMatrixPair(t_matProj_LeadField, t_matProj_G, idx1, idx2);
+
+                        t_vecRoh(k) = RapMusic::subcorr(t_matProj_G, t_matU_B);//t_vecRoh holds the correlations roh_k
+                    }
                 }
             }
 
@@ -67,6 +67,7 @@ RapMusic::RapMusic()
 , m_iNumLeadFieldCombinations(0)
 , m_ppPairIdxCombinations(NULL)
 , m_iMaxNumThreads(1)
+, m_bUsePairScan(true)
 , m_bIsInit(false)
 , m_iSamplesStcWindow(-1)
 , m_fStcOverlap(-1)
@@ -84,6 +85,7 @@ RapMusic::RapMusic(MNEForwardSolution& p_pFwd, bool p_bSparsed, int p_iN, double
 , m_iNumLeadFieldCombinations(0)
 , m_ppPairIdxCombinations(NULL)
 , m_iMaxNumThreads(1)
+, m_bUsePairScan(true)
 , m_bIsInit(false)
 , m_iSamplesStcWindow(-1)
 , m_fStcOverlap(-1)
@@ -469,37 +471,54 @@ MNESourceEstimate RapMusic::calculateInverse(const MatrixXd& p_matMeasurement, Q
         MatrixXT t_matU_B;
         useFullRank(t_svdProj_Phi_S.matrixU(), t_svdProj_Phi_S.singularValues().asDiagonal(), t_matU_B);
 
-        //Inits
-        VectorXT t_vecRoh(m_iNumLeadFieldCombinations,1);
-        t_vecRoh.setZero();
-
         //subcorr benchmark
         //Stop the time
         clock_t start_subcorr, end_subcorr;
         start_subcorr = clock();
 
-        //Multithreading correlation calculation
-        #ifdef _OPENMP
-        #pragma omp parallel num_threads(m_iMaxNumThreads)
-        #endif
-        {
-        #ifdef _OPENMP
-        #pragma omp for
-        #endif
-            for(int i = 0; i < m_iNumLeadFieldCombinations; i++)
-            {
-                //new Version: calculate matrix multiplication before
-                //Create Lead Field combinations -> It would be better to use a pointer construction, to increase performance
-                MatrixX6T t_matProj_G(t_matProj_LeadField.rows(),6);
+        double t_val_roh_k;
+        int t_iIdx1;
+        int t_iIdx2;
 
-                int idx1 = m_ppPairIdxCombinations[i]->x1;
-                int idx2 = m_ppPairIdxCombinations[i]->x2;
+        if(m_bUsePairScan)
+        {
+            //Correlate all pairs from per source bases, skipping pairs which can't beat the current maximum
+            RapMusicPairScan t_pairScan;
+            t_pairScan.setSubspace(t_matProj_LeadField, t_matU_B);
 
-                RapMusic::getGainMatrixPair(t_matProj_LeadField, t_matProj_G, idx1, idx2);
+            qint64 t_iNumEvaluated;
+            t_val_roh_k = t_pairScan.scan(t_iIdx1, t_iIdx2, &t_iNumEvaluated);
 
-                t_vecRoh(i) = RapMusic::subcorr(t_matProj_G, t_matU_B);//t_vecRoh holds the correlations roh_k
-            }
+            std::cout << "Evaluated pairs: " << t_iNumEvaluated << " of " << m_iNumLeadFieldCombinations << std::endl;
         }
+        else
+        {
+            //Inits
+            VectorXT t_vecRoh(m_iNumLeadFieldCombinations,1);
+            t_vecRoh.setZero();
+
+            //Multithreading correlation calculation
+            #ifdef _OPENMP
+            #pragma omp parallel num_threads(m_iMaxNumThreads)
+            #endif
+            {
+            #ifdef _OPENMP
+            #pragma omp for
+            #endif
+                for(int i = 0; i < m_iNumLeadFieldCombinations; i++)
+                {
+                    //new Version: calculate matrix multiplication before
+                    //Create Lead Field combinations -> It would be better to use a pointer construction, to increase performance
+                    MatrixX6T t_matProj_G(t_matProj_LeadField.rows(),6);
+
+                    int idx1 = m_ppPairIdxCombinations[i]->x1;
+                    int idx2 = m_ppPairIdxCombinations[i]->x2;
+
+                    RapMusic::getGainMatrixPair(t_matProj_LeadField, t_matProj_G, idx1, idx2);
+
+                    t_vecRoh(i) = RapMusic::subcorr(t_matProj_G, t_matU_B);//t_vecRoh holds the correlations roh_k
+                }
+            }
 
 
 //         if(r==0)
@@ -518,23 +537,22 @@ MNESourceEstimate RapMusic::calculateInverse(const MatrixXd& p_matMeasurement, Q
 //             //exit(0);
 //         }
 
+            //Find the maximum of correlation - can't put this in the for loop because it's running in different threads.
+            VectorXT::Index t_iMaxIdx;
+
+            t_val_roh_k = t_vecRoh.maxCoeff(&t_iMaxIdx);//p_vecCor = ^roh_k
+
+            //get positions in sparsed leadfield from index combinations;
+            t_iIdx1 = m_ppPairIdxCombinations[t_iMaxIdx]->x1;
+            t_iIdx2 = m_ppPairIdxCombinations[t_iMaxIdx]->x2;
+        }
+
         //subcorr benchmark
         end_subcorr = clock();
 
         float t_fSubcorrElapsedTime = ( (float)(end_subcorr-start_subcorr) / (float)CLOCKS_PER_SEC ) * 1000.0f;
         std::cout << "Time Elapsed: " << t_fSubcorrElapsedTime << " ms" << std::endl;
 
-        //Find the maximum of correlation - can't put this in the for loop because it's running in different threads.
-        double t_val_roh_k;
-
-        VectorXT::Index t_iMaxIdx;
-
-        t_val_roh_k = t_vecRoh.maxCoeff(&t_iMaxIdx);//p_vecCor = ^roh_k
-
-        //get positions in sparsed leadfield from index combinations;
-        int t_iIdx1 = m_ppPairIdxCombinations[t_iMaxIdx]->x1;
-        int t_iIdx2 = m_ppPairIdxCombinations[t_iMaxIdx]->x2;
-
         // (Idx+1) because of MATLAB positions -> starting with 1 not with 0
         std::cout << "Iteration: " << r+1 << " of " << t_iMaxSearch
             << "; Correlation: " << t_val_roh_k<< "; Position (Idx+1): " << t_iIdx1+1 << " - " << t_iIdx2+1 <<"\n\n";
@@ -907,3 +925,11 @@ void RapMusic::setStcAttr(int p_iSampStcWin, float p_fStcOverlap)
     m_iSamplesStcWindow = p_iSampStcWin;
     m_fStcOverlap = p_fStcOverlap;
 }
+
+
+//*************************************************************************************************************
+
+void RapMusic::setUsePairScan(bool p_bUsePairScan)
+{
+    m_bUsePairScan = p_bUsePairScan;
+}
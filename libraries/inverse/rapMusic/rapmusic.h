@@ -44,6 +44,7 @@
 #include "../IInverseAlgorithm.h"
 
 #include "dipole.h"
+#include "rapmusicpairscan.h"
 
 #include <mne/mne_forwardsolution.h>
 #include <mne/mne_sourceestimate.h>
@@ -183,6 +184,16 @@ public:
     */
     void setStcAttr(int p_iSampStcWin, float p_fStcOverlap);
 
+    //=========================================================================================================
+    /**
+    * Selects how the dipole pairs are scanned. The pair scan (default) evaluates the subspace correlations from
+    * precomputed per source bases (see RapMusicPairScan). Otherwise every pair is correlated by subcorr, which
+    * runs two SVDs per pair.
+    *
+    * @param[in] p_bUsePairScan     Whether to use the Gram matrix based pair scan.
+    */
+    void setUsePairScan(bool p_bUsePairScan);
+
 protected:
     //=========================================================================================================
     /**
@@ -328,6 +339,8 @@ protected:
 
     int m_iMaxNumThreads;   /**< Number of available CPU threads. */
 
+    bool m_bUsePairScan;    /**< Whether the Gram matrix based pair scan is used instead of one subcorr per pair. */
+
     bool m_bIsInit; /**< Whether the algorithm is initialized. */
 
     //Stc stuff
@@ -0,0 +1,329 @@
+//=============================================================================================================
+/**
+* @file     rapmusicpairscan.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     RapMusicPairScan class definition.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "rapmusicpairscan.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtConcurrent>
+#include <QMutex>
+#include <QVector>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// EIGEN INCLUDES
+//=============================================================================================================
+
+#include <Eigen/SVD>
+#include <Eigen/Cholesky>
+#include <Eigen/Eigenvalues>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <atomic>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace INVERSELIB;
+using namespace Eigen;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE GLOBAL METHODS
+//=============================================================================================================
+
+namespace
+{
+
+const double RANK_TOL   = 1e-5;     /**< Relative singular value threshold, in line with RapMusic::getRank. */
+const int    TILE_SIZE  = 32;       /**< Number of sources whose pairs are evaluated by one task. */
+
+typedef Matrix<double, 6, 6> Matrix6d;
+
+} // namespace
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+RapMusicPairScan::RapMusicPairScan()
+: m_iNumSources(0)
+{
+}
+
+
+//*************************************************************************************************************
+
+void RapMusicPairScan::setSubspace(const MatrixXd& p_matProjLeadField, const MatrixXd& p_matU_B)
+{
+    setLeadField(p_matProjLeadField);
+    setSignalSubspace(p_matU_B);
+}
+
+
+//*************************************************************************************************************
+
+void RapMusicPairScan::setLeadField(const MatrixXd& p_matProjLeadField)
+{
+    m_iNumSources = p_matProjLeadField.cols()/3;
+
+    m_matQ = MatrixXd::Zero(p_matProjLeadField.rows(), 3*m_iNumSources);
+
+    //Orthonormalize every projected source block once per recursion instead of once per pair
+    QVector<int> t_vecSources(m_iNumSources);
+    for(int i = 0; i < m_iNumSources; ++i) {
+        t_vecSources[i] = i;
+    }
+
+    QtConcurrent::blockingMap(t_vecSources, [&](int i) {
+        JacobiSVD<MatrixXd> t_svd(p_matProjLeadField.middleCols(3*i, 3), ComputeThinU);
+        const VectorXd& t_vecSigma = t_svd.singularValues();
+
+        for(int k = 0; k < 3; ++k) {
+            if(t_vecSigma(k) > RANK_TOL * t_vecSigma(0)) {
+                m_matQ.col(3*i + k) = t_svd.matrixU().col(k);
+            }
+        }
+    });
+
+    m_matKDiag.resize(3, 3*m_iNumSources);
+    for(int i = 0; i < m_iNumSources; ++i) {
+        m_matKDiag.middleCols(3*i, 3) = m_matQ.middleCols(3*i, 3).transpose() * m_matQ.middleCols(3*i, 3);
+    }
+}
+
+
+//*************************************************************************************************************
+
+void RapMusicPairScan::setSignalSubspace(const MatrixXd& p_matU_B)
+{
+    m_matB = p_matU_B.transpose() * m_matQ;
+
+    m_matMDiag.resize(3, 3*m_iNumSources);
+    m_vecCorrSq.resize(m_iNumSources);
+
+    for(int i = 0; i < m_iNumSources; ++i) {
+        m_matMDiag.middleCols(3*i, 3) = m_matB.middleCols(3*i, 3).transpose() * m_matB.middleCols(3*i, 3);
+
+        //The pair (i,i) spans the subspace of source i only
+        Matrix3d t_matMii = m_matMDiag.middleCols(3*i, 3);
+        m_vecCorrSq(i) = SelfAdjointEigenSolver<Matrix3d>(t_matMii, EigenvaluesOnly).eigenvalues()(2);
+    }
+}
+
+
+//*************************************************************************************************************
+
+double RapMusicPairScan::correlation(int p_iIdx1, int p_iIdx2) const
+{
+    if(p_iIdx1 == p_iIdx2) {
+        return std::sqrt(std::max(m_vecCorrSq(p_iIdx1), 0.0));
+    }
+
+    Matrix3d t_matKij = m_matQ.middleCols(3*p_iIdx1, 3).transpose() * m_matQ.middleCols(3*p_iIdx2, 3);
+    Matrix3d t_matMij = m_matB.middleCols(3*p_iIdx1, 3).transpose() * m_matB.middleCols(3*p_iIdx2, 3);
+
+    return std::sqrt(pairCorrelationSquared(m_matKDiag.middleCols(3*p_iIdx1, 3), t_matKij, m_matKDiag.middleCols(3*p_iIdx2, 3),
+                                            m_matMDiag.middleCols(3*p_iIdx1, 3), t_matMij, m_matMDiag.middleCols(3*p_iIdx2, 3)));
+}
+
+
+//*************************************************************************************************************
+
+void RapMusicPairScan::rowCorrelations(int p_iIdx, VectorXd& p_vecCorr) const
+{
+    p_vecCorr.resize(m_iNumSources);
+
+    MatrixXd t_matK = m_matQ.middleCols(3*p_iIdx, 3).transpose() * m_matQ;
+    MatrixXd t_matM = m_matB.middleCols(3*p_iIdx, 3).transpose() * m_matB;
+
+    for(int j = 0; j < m_iNumSources; ++j) {
+        if(j == p_iIdx) {
+            p_vecCorr(j) = std::sqrt(std::max(m_vecCorrSq(j), 0.0));
+        } else {
+            p_vecCorr(j) = std::sqrt(pairCorrelationSquared(m_matKDiag.middleCols(3*p_iIdx, 3), t_matK.middleCols(3*j, 3), m_matKDiag.middleCols(3*j, 3),
+                                                            m_matMDiag.middleCols(3*p_iIdx, 3), t_matM.middleCols(3*j, 3), m_matMDiag.middleCols(3*j, 3)));
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+double RapMusicPairScan::scan(int& p_iIdx1, int& p_iIdx2, qint64* p_pNumEvaluated) const
+{
+    if(m_iNumSources == 0) {
+        p_iIdx1 = p_iIdx2 = -1;
+        return 0.0;
+    }
+
+    //The pair (i,i) of the best single source is a lower bound for the best pair
+    VectorXd::Index t_iBestSingle;
+    double t_dBestSq = m_vecCorrSq.maxCoeff(&t_iBestSingle);
+    int t_iBestIdx1 = t_iBestSingle;
+    int t_iBestIdx2 = t_iBestSingle;
+
+    std::atomic<double> t_dBound(t_dBestSq);
+    std::atomic<qint64> t_iNumEvaluated(m_iNumSources);
+    QMutex t_mutex;
+
+    QVector<int> t_vecTiles((m_iNumSources + TILE_SIZE - 1) / TILE_SIZE);
+    for(int t = 0; t < t_vecTiles.size(); ++t) {
+        t_vecTiles[t] = t;
+    }
+
+    QtConcurrent::blockingMap(t_vecTiles, [&](int t) {
+        const int iFirst = t*TILE_SIZE;
+        const int iLast = std::min(m_iNumSources, iFirst + TILE_SIZE);
+        const int iNumCols = 3*(m_iNumSources - iFirst);
+
+        //Cross Gram blocks of all pairs (i >= iFirst, j >= iFirst) of this tile as two matrix products
+        MatrixXd t_matK = m_matQ.middleCols(3*iFirst, 3*(iLast - iFirst)).transpose() * m_matQ.rightCols(iNumCols);
+        MatrixXd t_matM = m_matB.middleCols(3*iFirst, 3*(iLast - iFirst)).transpose() * m_matB.rightCols(iNumCols);
+
+        double dLocalBestSq = -1.0;
+        int iLocalIdx1 = -1, iLocalIdx2 = -1;
+        qint64 iLocalEvaluated = 0;
+
+        for(int i = iFirst; i < iLast; ++i) {
+            const int iRow = 3*(i - iFirst);
+
+            for(int j = i + 1; j < m_iNumSources; ++j) {
+                const int iCol = 3*(j - iFirst);
+
+                const double dBoundSq = std::max(dLocalBestSq, t_dBound.load(std::memory_order_relaxed));
+
+                //Skip pairs whose correlation cannot exceed the current best: c^2 <= (c_i^2 + c_j^2)/(1 - ||Q_i^T*Q_j||)
+                const double dNormKij = t_matK.block(iRow, iCol, 3, 3).norm();
+                if(dNormKij < 1.0 && (m_vecCorrSq(i) + m_vecCorrSq(j)) <= dBoundSq * (1.0 - dNormKij)) {
+                    continue;
+                }
+
+                ++iLocalEvaluated;
+
+                const double dCorrSq = pairCorrelationSquared(m_matKDiag.middleCols(3*i, 3), t_matK.block(iRow, iCol, 3, 3), m_matKDiag.middleCols(3*j, 3),
+                                                              m_matMDiag.middleCols(3*i, 3), t_matM.block(iRow, iCol, 3, 3), m_matMDiag.middleCols(3*j, 3));
+
+                if(dCorrSq > dBoundSq) {
+                    dLocalBestSq = dCorrSq;
+                    iLocalIdx1 = i;
+                    iLocalIdx2 = j;
+                }
+            }
+        }
+
+        t_iNumEvaluated += iLocalEvaluated;
+
+        if(iLocalIdx1 >= 0) {
+            QMutexLocker locker(&t_mutex);
+            if(dLocalBestSq > t_dBestSq) {
+                t_dBestSq = dLocalBestSq;
+                t_iBestIdx1 = iLocalIdx1;
+                t_iBestIdx2 = iLocalIdx2;
+                t_dBound.store(t_dBestSq, std::memory_order_relaxed);
+            }
+        }
+    });
+
+    p_iIdx1 = t_iBestIdx1;
+    p_iIdx2 = t_iBestIdx2;
+
+    if(p_pNumEvaluated) {
+        *p_pNumEvaluated = t_iNumEvaluated;
+    }
+
+    return std::sqrt(std::max(t_dBestSq, 0.0));
+}
+
+
+//*************************************************************************************************************
+
+double RapMusicPairScan::pairCorrelationSquared(const Matrix3d& p_matKii,
+                                                const Matrix3d& p_matKij,
+                                                const Matrix3d& p_matKjj,
+                                                const Matrix3d& p_matMii,
+                                                const Matrix3d& p_matMij,
+                                                const Matrix3d& p_matMjj)
+{
+    Matrix6d t_matK, t_matM;
+    t_matK << p_matKii, p_matKij, p_matKij.transpose(), p_matKjj;
+    t_matM << p_matMii, p_matMij, p_matMij.transpose(), p_matMjj;
+
+    //Well conditioned pair: c^2 = lambda_max(L^-1*M*L^-T) with K = L*L^T
+    LLT<Matrix6d> t_llt(t_matK);
+    if(t_llt.info() == Success && t_llt.matrixLLT().diagonal().minCoeff() > RANK_TOL) {
+        Matrix6d t_matLinvM = t_llt.matrixL().solve(t_matM);
+        Matrix6d t_matY = t_llt.matrixL().solve(t_matLinvM.transpose());
+
+        return SelfAdjointEigenSolver<Matrix6d>(t_matY, EigenvaluesOnly).eigenvalues()(5);
+    }
+
+    //Rank deficient pair: restrict the problem to the range of K, like RapMusic::useFullRank does for U_A
+    SelfAdjointEigenSolver<Matrix6d> t_eigK(t_matK);
+    Matrix6d t_matW = t_eigK.eigenvectors();
+    for(int k = 0; k < 6; ++k) {
+        const double dLambda = t_eigK.eigenvalues()(k);
+        if(dLambda > RANK_TOL * RANK_TOL * t_eigK.eigenvalues()(5)) {
+            t_matW.col(k) /= std::sqrt(dLambda);
+        } else {
+            t_matW.col(k).setZero();
+        }
+    }
+
+    Matrix6d t_matY = t_matW.transpose() * t_matM * t_matW;
+
+    return SelfAdjointEigenSolver<Matrix6d>(t_matY, EigenvaluesOnly).eigenvalues()(5);
+}
@@ -0,0 +1,205 @@
+//=============================================================================================================
+/**
+* @file     rapmusicpairscan.h
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     RapMusicPairScan class declaration.
+*
+*/
+
+#ifndef RAPMUSICPAIRSCAN_H
+#define RAPMUSICPAIRSCAN_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "../inverse_global.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QSharedPointer>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// EIGEN INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE INVERSELIB
+//=============================================================================================================
+
+namespace INVERSELIB
+{
+
+
+//=============================================================================================================
+/**
+* Evaluates the RAP MUSIC subspace correlation of dipole pairs without a per pair SVD.
+*
+* For the current recursion the projected gain matrix of every source is orthonormalized once (Q_i, m x 3) and
+* multiplied with the signal subspace basis U_B (B_i = U_B^T*Q_i). The subspace correlation of a pair (i,j) is
+* then the largest generalized eigenvalue of the 6 x 6 problem M*x = c^2*K*x with the Gram matrix
+* K = [Q_i Q_j]^T*[Q_i Q_j] and M = [B_i B_j]^T*[B_i B_j], which equals the first singular value of U_A^T*U_B
+* computed by RapMusic::subcorr. The cross terms Q_i^T*Q_j and B_i^T*B_j are computed tile wise as matrix
+* products. Pairs are scanned multi-threaded on the global QThreadPool, and a pair is skipped when the upper bound
+* (c_i^2 + c_j^2)/(1 - ||Q_i^T*Q_j||_F) of its correlation cannot beat the best correlation found so far.
+*
+* @brief Gram matrix based RAP MUSIC dipole pair scan.
+*/
+class INVERSESHARED_EXPORT RapMusicPairScan
+{
+public:
+    typedef QSharedPointer<RapMusicPairScan> SPtr;             /**< Shared pointer type for RapMusicPairScan. */
+    typedef QSharedPointer<const RapMusicPairScan> ConstSPtr;  /**< Const shared pointer type for RapMusicPairScan. */
+
+    //=========================================================================================================
+    /**
+    * Constructs an empty pair scan. Call setSubspace (or setLeadField and setSignalSubspace) before evaluating pairs.
+    */
+    RapMusicPairScan();
+
+    //=========================================================================================================
+    /**
+    * Precomputes the per source bases for the current RAP MUSIC recursion.
+    *
+    * @param[in] p_matProjLeadField The projected gain matrix (channels x 3*sources).
+    * @param[in] p_matU_B           The orthonormal basis of the projected signal subspace (channels x rank).
+    */
+    void setSubspace(const Eigen::MatrixXd& p_matProjLeadField, const Eigen::MatrixXd& p_matU_B);
+
+    //=========================================================================================================
+    /**
+    * Orthonormalizes the blocks of the projected gain matrix. Only needs to be called again when the projector
+    * changes, e.g. the unprojected gain matrix of the first recursion can be kept for successive signal subspaces.
+    *
+    * @param[in] p_matProjLeadField The projected gain matrix (channels x 3*sources).
+    */
+    void setLeadField(const Eigen::MatrixXd& p_matProjLeadField);
+
+    //=========================================================================================================
+    /**
+    * Updates the signal subspace for the lead field set by setLeadField.
+    *
+    * @param[in] p_matU_B   The orthonormal basis of the projected signal subspace (channels x rank).
+    */
+    void setSignalSubspace(const Eigen::MatrixXd& p_matU_B);
+
+    //=========================================================================================================
+    /**
+    * Returns the subspace correlation of the source pair (p_iIdx1, p_iIdx2).
+    *
+    * @param[in] p_iIdx1    First source index.
+    * @param[in] p_iIdx2    Second source index.
+    *
+    * @return The subspace correlation.
+    */
+    double correlation(int p_iIdx1, int p_iIdx2) const;
+
+    //=========================================================================================================
+    /**
+    * Computes the subspace correlations of one source with all sources.
+    *
+    * @param[in] p_iIdx         The source index.
+    * @param[out] p_vecCorr     The correlation of the pair (p_iIdx, j) for all sources j.
+    */
+    void rowCorrelations(int p_iIdx, Eigen::VectorXd& p_vecCorr) const;
+
+    //=========================================================================================================
+    /**
+    * Scans all pairs (i <= j) for the maximal subspace correlation.
+    *
+    * @param[out] p_iIdx1           First source index of the best pair.
+    * @param[out] p_iIdx2           Second source index of the best pair.
+    * @param[out] p_pNumEvaluated   If set, returns the number of pairs which were not skipped by the bound.
+    *
+    * @return The maximal subspace correlation.
+    */
+    double scan(int& p_iIdx1, int& p_iIdx2, qint64* p_pNumEvaluated = Q_NULLPTR) const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of sources.
+    *
+    * @return The number of sources.
+    */
+    inline int getNumSources() const;
+
+private:
+    //=========================================================================================================
+    /**
+    * Computes the squared subspace correlation of a pair from its Gram blocks.
+    *
+    * @param[in] p_matKii   Q_i^T*Q_i.
+    * @param[in] p_matKij   Q_i^T*Q_j.
+    * @param[in] p_matKjj   Q_j^T*Q_j.
+    * @param[in] p_matMii   B_i^T*B_i.
+    * @param[in] p_matMij   B_i^T*B_j.
+    * @param[in] p_matMjj   B_j^T*B_j.
+    *
+    * @return The squared subspace correlation.
+    */
+    static double pairCorrelationSquared(const Eigen::Matrix3d& p_matKii,
+                                         const Eigen::Matrix3d& p_matKij,
+                                         const Eigen::Matrix3d& p_matKjj,
+                                         const Eigen::Matrix3d& p_matMii,
+                                         const Eigen::Matrix3d& p_matMij,
+                                         const Eigen::Matrix3d& p_matMjj);
+
+    int                 m_iNumSources;  /**< Number of sources. */
+    Eigen::MatrixXd     m_matQ;         /**< Orthonormal basis of each projected source block (channels x 3*sources), rank deficient directions are zero. */
+    Eigen::MatrixXd     m_matB;         /**< U_B^T*m_matQ (rank x 3*sources). */
+    Eigen::MatrixXd     m_matKDiag;     /**< Diagonal Gram blocks Q_i^T*Q_i (3 x 3*sources). */
+    Eigen::MatrixXd     m_matMDiag;     /**< Diagonal blocks B_i^T*B_i (3 x 3*sources). */
+    Eigen::VectorXd     m_vecCorrSq;    /**< Squared subspace correlation of each single source, equal to the pair (i,i). */
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline int RapMusicPairScan::getNumSources() const
+{
+    return m_iNumSources;
+}
+
+} //NAMESPACE
+
+#endif // RAPMUSICPAIRSCAN_H
@@ -0,0 +1,427 @@
+//=============================================================================================================
+/**
+* @file     streamingrapmusic.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     StreamingRapMusic class definition.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "streamingrapmusic.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// EIGEN INCLUDES
+//=============================================================================================================
+
+#include <Eigen/SVD>
+#include <Eigen/QR>
+#include <Eigen/Cholesky>
+#include <Eigen/Eigenvalues>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace INVERSELIB;
+using namespace MNELIB;
+using namespace FIFFLIB;
+using namespace Eigen;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE GLOBAL METHODS
+//=============================================================================================================
+
+namespace
+{
+
+const double RANK_TOL               = 1e-5;     /**< Relative eigenvalue threshold of the tracked subspace. */
+const int    SUBSPACE_ITERATIONS    = 2;        /**< Warm started subspace iterations per update. */
+const int    MAX_SEED_ITERATIONS    = 10;       /**< Maximal number of row scans of the seeded search. */
+
+//*************************************************************************************************************
+
+void assignDipoles(const QList< DipolePair<double> >& p_RapDipoles, int p_iStart, int p_iNumSamples, MatrixXd& p_matData)
+{
+    for(int i = 0; i < p_RapDipoles.size(); ++i) {
+        const Dipole<double>& t_dip1 = p_RapDipoles[i].m_Dipole1;
+        const Dipole<double>& t_dip2 = p_RapDipoles[i].m_Dipole2;
+
+        double dip1 = sqrt(pow(t_dip1.phi_x(),2) + pow(t_dip1.phi_y(),2) + pow(t_dip1.phi_z(),2)) * p_RapDipoles[i].m_vCorrelation;
+        double dip2 = sqrt(pow(t_dip2.phi_x(),2) + pow(t_dip2.phi_y(),2) + pow(t_dip2.phi_z(),2)) * p_RapDipoles[i].m_vCorrelation;
+
+        p_matData.block(p_RapDipoles[i].m_iIdx1, p_iStart, 1, p_iNumSamples).setConstant(dip1);
+        p_matData.block(p_RapDipoles[i].m_iIdx2, p_iStart, 1, p_iNumSamples).setConstant(dip2);
+    }
+}
+
+} // namespace
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+StreamingRapMusic::StreamingRapMusic(MNEForwardSolution& p_Fwd, int p_iWindowSize, int p_iN, double p_dThr)
+: RapMusic(p_Fwd, false, p_iN, p_dThr)
+, m_iWindowSize(0)
+, m_iNumSamples(0)
+, m_iWriteIdx(0)
+, m_iSamplesSinceResync(0)
+, m_dRescanThreshold(0.95)
+, m_bLastFullScan(false)
+{
+    if(m_bIsInit) {
+        m_pairScanUnprojected.setLeadField(m_ForwardSolution.sol->data);
+    }
+
+    setWindowSize(p_iWindowSize);
+}
+
+
+//*************************************************************************************************************
+
+void StreamingRapMusic::setWindowSize(int p_iWindowSize)
+{
+    m_iWindowSize = p_iWindowSize > 0 ? p_iWindowSize : 0;
+    reset();
+}
+
+
+//*************************************************************************************************************
+
+void StreamingRapMusic::setRescanThreshold(double p_dRescanThreshold)
+{
+    m_dRescanThreshold = p_dRescanThreshold;
+}
+
+
+//*************************************************************************************************************
+
+void StreamingRapMusic::reset()
+{
+    m_iNumSamples = 0;
+    m_iWriteIdx = 0;
+    m_iSamplesSinceResync = 0;
+    m_bLastFullScan = false;
+
+    m_matWindow = MatrixXd::Zero(m_iNumChannels, m_iWindowSize);
+    m_matCov = MatrixXd::Zero(m_iNumChannels, m_iNumChannels);
+    m_matPhi_s.resize(0, 0);
+    m_matPhi_sScan.resize(0, 0);
+    m_lastDipoles.clear();
+}
+
+
+//*************************************************************************************************************
+
+void StreamingRapMusic::append(const MatrixXd& p_matData)
+{
+    if(m_iWindowSize <= 0 || p_matData.rows() != m_iNumChannels) {
+        std::cout << "StreamingRapMusic::append - Data channels (" << p_matData.rows() << ") do not fit to the number of channels (" << m_iNumChannels << ") of the forward solution." << std::endl;
+        return;
+    }
+
+    //Only the last window size samples can still be part of the window
+    int t_iPos = std::max(0, (int)p_matData.cols() - m_iWindowSize);
+
+    while(t_iPos < p_matData.cols()) {
+        int t_iNum = std::min((int)p_matData.cols() - t_iPos, m_iWindowSize - m_iWriteIdx);
+
+        //Remove the leaving and add the entering samples, slots which were never written are zero
+        m_matCov.selfadjointView<Lower>().rankUpdate(m_matWindow.middleCols(m_iWriteIdx, t_iNum), -1.0);
+        m_matCov.selfadjointView<Lower>().rankUpdate(p_matData.middleCols(t_iPos, t_iNum), 1.0);
+        m_matWindow.middleCols(m_iWriteIdx, t_iNum) = p_matData.middleCols(t_iPos, t_iNum);
+
+        m_iWriteIdx = (m_iWriteIdx + t_iNum) % m_iWindowSize;
+        m_iNumSamples = std::min(m_iWindowSize, m_iNumSamples + t_iNum);
+        m_iSamplesSinceResync += t_iNum;
+        t_iPos += t_iNum;
+    }
+
+    //Recompute the covariance once per window length to keep the rounding errors of the downdates bounded
+    if(m_iSamplesSinceResync >= m_iWindowSize) {
+        m_matCov.setZero();
+        m_matCov.selfadjointView<Lower>().rankUpdate(m_matWindow);
+        m_iSamplesSinceResync = 0;
+    }
+}
+
+
+//*************************************************************************************************************
+
+bool StreamingRapMusic::localize(QList< DipolePair<double> >& p_RapDipoles)
+{
+    if(!m_bIsInit || !isWindowFull()) {
+        return false;
+    }
+
+    double t_dCos = trackSubspace();
+
+    bool t_bFullScan = m_lastDipoles.isEmpty() || t_dCos < m_dRescanThreshold;
+
+    //Rank of the tracked subspace from its Rayleigh quotients
+    VectorXd t_vecLambda = (m_matPhi_s.transpose() * (m_matCov.selfadjointView<Lower>() * m_matPhi_s)).diagonal();
+    double t_dMaxLambda = t_vecLambda.maxCoeff();
+
+    int t_iRank = 0;
+    for(int i = 0; i < t_vecLambda.size(); ++i) {
+        if(t_vecLambda(i) > RANK_TOL * t_dMaxLambda) {
+            ++t_iRank;
+        }
+    }
+
+    int t_iMaxSearch = std::min(m_iN, t_iRank);
+
+    const MatrixXd& t_matG = m_ForwardSolution.sol->data;
+
+    MatrixXT t_matA_k_1 = MatrixXT::Zero(m_iNumChannels, t_iMaxSearch);
+    MatrixXT t_matOrthProj = MatrixXT::Identity(m_iNumChannels, m_iNumChannels);
+
+    QList< DipolePair<double> > t_RapDipoles;
+
+    for(int r = 0; r < t_iMaxSearch; ++r) {
+        MatrixXT t_matProj_Phi_s = r == 0 ? m_matPhi_s : MatrixXT(t_matOrthProj * m_matPhi_s);
+
+        Eigen::JacobiSVD< MatrixXT > t_svdProj_Phi_S(t_matProj_Phi_s, Eigen::ComputeThinU);
+        MatrixXT t_matU_B;
+        useFullRank(t_svdProj_Phi_S.matrixU(), t_svdProj_Phi_S.singularValues().asDiagonal(), t_matU_B);
+
+        //The first recursion keeps the per source bases of the unprojected gain matrix
+        RapMusicPairScan t_pairScanProjected;
+        const RapMusicPairScan* t_pPairScan = &m_pairScanUnprojected;
+
+        if(r == 0) {
+            m_pairScanUnprojected.setSignalSubspace(t_matU_B);
+        } else {
+            //P*G = G - A*(A^T*A)^-1*A^T*G without multiplying the full projector
+            const MatrixXT t_matA = t_matA_k_1.leftCols(r);
+            MatrixXT t_matProj_LeadField = t_matG - t_matA * (t_matA.transpose() * t_matA).ldlt().solve(t_matA.transpose() * t_matG);
+
+            t_pairScanProjected.setSubspace(t_matProj_LeadField, t_matU_B);
+            t_pPairScan = &t_pairScanProjected;
+        }
+
+        double t_val_roh_k = 0.0;
+        int t_iIdx1 = -1;
+        int t_iIdx2 = -1;
+
+        if(!t_bFullScan && r < m_lastDipoles.size()) {
+            t_iIdx1 = m_lastDipoles[r].m_iIdx1;
+            t_iIdx2 = m_lastDipoles[r].m_iIdx2;
+            t_val_roh_k = seededSearch(*t_pPairScan, t_iIdx1, t_iIdx2);
+        }
+
+        //Fall back to the full scan when there is no seed or the seeded optimum lost the source
+        if(t_iIdx1 < 0 || t_val_roh_k < m_dThreshold) {
+            t_val_roh_k = t_pPairScan->scan(t_iIdx1, t_iIdx2);
+            t_bFullScan = true;
+        }
+
+        //Source direction of the found pair
+        MatrixX6T t_matG_k_1(m_iNumChannels, 6);
+        RapMusic::getGainMatrixPair(t_matG, t_matG_k_1, t_iIdx1, t_iIdx2);
+
+        MatrixX6T t_matProj_G_k_1 = t_matOrthProj * t_matG_k_1;
+
+        Vector6T t_vec_phi_k_1(6);
+        RapMusic::subcorr(t_matProj_G_k_1, t_matU_B, t_vec_phi_k_1);
+
+        RapMusic::insertSource(t_iIdx1, t_iIdx2, t_vec_phi_k_1, t_val_roh_k, t_RapDipoles);
+
+        //Stop Searching when Correlation is smaller then the Threshold
+        if(t_val_roh_k < m_dThreshold) {
+            break;
+        }
+
+        RapMusic::calcA_k_1(t_matG_k_1, t_vec_phi_k_1, r, t_matA_k_1);
+        calcOrthProj(t_matA_k_1.leftCols(r+1), t_matOrthProj);
+    }
+
+    if(t_bFullScan) {
+        m_matPhi_sScan = m_matPhi_s;
+    }
+
+    m_bLastFullScan = t_bFullScan;
+    m_lastDipoles = t_RapDipoles;
+    p_RapDipoles = t_RapDipoles;
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+MNESourceEstimate StreamingRapMusic::calculateInverse(const FiffEvoked &p_fiffEvoked, bool pick_normal)
+{
+    Q_UNUSED(pick_normal);
+
+    MNESourceEstimate p_sourceEstimate;
+
+    if(p_fiffEvoked.data.rows() != m_iNumChannels) {
+        std::cout << "Number of FiffEvoked channels (" << p_fiffEvoked.data.rows() << ") doesn't match the number of channels (" << m_iNumChannels << ") of the forward solution." << std::endl;
+        return p_sourceEstimate;
+    }
+
+    int t_iNumSamples = p_fiffEvoked.data.cols();
+
+    p_sourceEstimate.data = MatrixXd::Zero(m_ForwardSolution.nsource, t_iNumSamples);
+
+    p_sourceEstimate.vertices = VectorXi(m_ForwardSolution.src[0].vertno.size() + m_ForwardSolution.src[1].vertno.size());
+    p_sourceEstimate.vertices << m_ForwardSolution.src[0].vertno, m_ForwardSolution.src[1].vertno;
+
+    p_sourceEstimate.times = p_fiffEvoked.times;
+    p_sourceEstimate.tmin = p_fiffEvoked.times[0];
+    p_sourceEstimate.tstep = p_fiffEvoked.times[1] - p_fiffEvoked.times[0];
+
+    //Window and hop from the stc attributes, the full evoked if they are not set
+    int t_iWindowSize = (m_iSamplesStcWindow > 3 && m_iSamplesStcWindow < t_iNumSamples) ? m_iSamplesStcWindow : t_iNumSamples;
+    int t_iHopSize = std::max(1, (int)((1.0f - std::max(m_fStcOverlap, 0.0f)) * t_iWindowSize));
+
+    //Keep the tracked subspace and dipoles as seed, only the samples are restarted
+    if(t_iWindowSize != m_iWindowSize) {
+        setWindowSize(t_iWindowSize);
+    } else {
+        m_iNumSamples = 0;
+        m_iWriteIdx = 0;
+        m_iSamplesSinceResync = 0;
+        m_matWindow.setZero();
+        m_matCov.setZero();
+    }
+
+    QList< DipolePair<double> > t_RapDipoles;
+
+    int t_iPos = 0;
+    while(t_iPos < t_iNumSamples) {
+        int t_iNum = t_iPos == 0 ? t_iWindowSize : std::min(t_iHopSize, t_iNumSamples - t_iPos);
+
+        append(p_fiffEvoked.data.middleCols(t_iPos, t_iNum));
+
+        if(localize(t_RapDipoles)) {
+            assignDipoles(t_RapDipoles, t_iPos, t_iNum, p_sourceEstimate.data);
+        }
+
+        t_iPos += t_iNum;
+    }
+
+    return p_sourceEstimate;
+}
+
+
+//*************************************************************************************************************
+
+const char* StreamingRapMusic::getName() const
+{
+    return "Streaming RAP MUSIC";
+}
+
+
+//*************************************************************************************************************
+
+double StreamingRapMusic::trackSubspace()
+{
+    int t_iDim = std::min(m_iN, m_iNumChannels);
+
+    if(m_matPhi_s.rows() != m_iNumChannels || m_matPhi_s.cols() != t_iDim) {
+        //Cold start with the dominant eigenvectors, the solver reads the lower triangle only
+        SelfAdjointEigenSolver<MatrixXd> t_eigSolver(m_matCov);
+        m_matPhi_s = t_eigSolver.eigenvectors().rightCols(t_iDim).rowwise().reverse();
+    } else {
+        //Warm started subspace iteration, the basis of the previous update is already close
+        for(int i = 0; i < SUBSPACE_ITERATIONS; ++i) {
+            HouseholderQR<MatrixXd> t_qr(m_matCov.selfadjointView<Lower>() * m_matPhi_s);
+            m_matPhi_s = t_qr.householderQ() * MatrixXd::Identity(m_iNumChannels, t_iDim);
+        }
+    }
+
+    if(m_matPhi_sScan.rows() != m_matPhi_s.rows() || m_matPhi_sScan.cols() != m_matPhi_s.cols()) {
+        return 0.0;
+    }
+
+    //Cosine of the largest principal angle to the subspace of the last full scan
+    JacobiSVD<MatrixXd> t_svd(m_matPhi_sScan.transpose() * m_matPhi_s);
+    return t_svd.singularValues().minCoeff();
+}
+
+
+//*************************************************************************************************************
+
+double StreamingRapMusic::seededSearch(const RapMusicPairScan& p_pairScan, int& p_iIdx1, int& p_iIdx2)
+{
+    int t_iFixed = p_iIdx1;
+    int t_iFree = p_iIdx2;
+    double t_dBest = p_pairScan.correlation(t_iFixed, t_iFree);
+
+    //Alternate between the two rows of the current pair until neither of them improves
+    VectorXd t_vecRowCorr;
+    int t_iNumUnchanged = 0;
+
+    for(int i = 0; i < MAX_SEED_ITERATIONS && t_iNumUnchanged < 2; ++i) {
+        p_pairScan.rowCorrelations(t_iFixed, t_vecRowCorr);
+
+        VectorXd::Index t_iMaxIdx;
+        double t_dMax = t_vecRowCorr.maxCoeff(&t_iMaxIdx);
+
+        if(t_dMax > t_dBest) {
+            t_dBest = t_dMax;
+            t_iFree = t_iMaxIdx;
+            t_iNumUnchanged = 0;
+        } else {
+            ++t_iNumUnchanged;
+        }
+
+        std::swap(t_iFixed, t_iFree);
+    }
+
+    p_iIdx1 = std::min(t_iFixed, t_iFree);
+    p_iIdx2 = std::max(t_iFixed, t_iFree);
+
+    return t_dBest;
+}
@@ -0,0 +1,254 @@
+//=============================================================================================================
+/**
+* @file     streamingrapmusic.h
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     StreamingRapMusic class declaration.
+*
+*/
+
+#ifndef STREAMINGRAPMUSIC_H
+#define STREAMINGRAPMUSIC_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "../inverse_global.h"
+#include "rapmusic.h"
+#include "rapmusicpairscan.h"
+#include "dipole.h"
+
+#include <mne/mne_forwardsolution.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QSharedPointer>
+#include <QList>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// EIGEN INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE INVERSELIB
+//=============================================================================================================
+
+namespace INVERSELIB
+{
+
+
+//=============================================================================================================
+/**
+* RAP MUSIC for a sliding window of streamed samples. Instead of a full SVD of every window the data covariance
+* F*F^T of the window is updated with the samples entering and leaving the window, and the signal subspace is
+* tracked by a few subspace iterations warm started with the basis of the previous update. As long as the tracked
+* subspace stays close to the one of the last full scan (smallest principal angle cosine above the rescan
+* threshold) every recursion only runs an alternating row search seeded with the dipole pair found before, which
+* evaluates O(sources) instead of O(sources^2) pairs. A full pair scan is done on the first update and whenever the
+* subspace changed too much.
+*
+* @brief Streaming RAP MUSIC with incremental signal subspace tracking.
+*/
+class INVERSESHARED_EXPORT StreamingRapMusic : public RapMusic
+{
+public:
+    typedef QSharedPointer<StreamingRapMusic> SPtr;             /**< Shared pointer type for StreamingRapMusic. */
+    typedef QSharedPointer<const StreamingRapMusic> ConstSPtr;  /**< Const shared pointer type for StreamingRapMusic. */
+
+    //=========================================================================================================
+    /**
+    * Constructs the streaming RAP MUSIC algorithm.
+    *
+    * @param[in] p_Fwd          The model which contains the gain matrix and its corresponding grid matrix.
+    * @param[in] p_iWindowSize  The number of samples of the sliding window.
+    * @param[in] p_iN           The number (default 2) of uncorrelated sources, which should be found. Starting with
+    *                           the strongest. This is also the dimension of the tracked signal subspace.
+    * @param[in] p_dThr         The correlation threshold (default 0.5) at which the search for sources stops.
+    */
+    StreamingRapMusic(MNEForwardSolution& p_Fwd, int p_iWindowSize, int p_iN = 2, double p_dThr = 0.5);
+
+    //=========================================================================================================
+    /**
+    * Sets the number of samples of the sliding window. Resets the stream.
+    *
+    * @param[in] p_iWindowSize  The number of samples of the sliding window.
+    */
+    void setWindowSize(int p_iWindowSize);
+
+    //=========================================================================================================
+    /**
+    * Returns the number of samples of the sliding window.
+    *
+    * @return The number of samples of the sliding window.
+    */
+    inline int getWindowSize() const;
+
+    //=========================================================================================================
+    /**
+    * Sets the cosine of the largest principal angle between the tracked subspace and the subspace of the last full
+    * scan below which a full scan is done again. 1.0 forces a full scan on every update.
+    *
+    * @param[in] p_dRescanThreshold     The principal angle cosine threshold (default 0.95).
+    */
+    void setRescanThreshold(double p_dRescanThreshold);
+
+    //=========================================================================================================
+    /**
+    * Clears the window, the tracked subspace and the previously found dipoles.
+    */
+    void reset();
+
+    //=========================================================================================================
+    /**
+    * Appends samples to the sliding window. The oldest samples leave the window once it is full.
+    *
+    * @param[in] p_matData  The new samples (channels x samples).
+    */
+    void append(const Eigen::MatrixXd& p_matData);
+
+    //=========================================================================================================
+    /**
+    * Returns whether the sliding window holds enough samples to localize.
+    *
+    * @return True if the window is full.
+    */
+    inline bool isWindowFull() const;
+
+    //=========================================================================================================
+    /**
+    * Localizes the dipole pairs of the current window.
+    *
+    * @param[out] p_RapDipoles  The found dipole pairs.
+    *
+    * @return True if the window was full and the dipoles were updated.
+    */
+    bool localize(QList< DipolePair<double> >& p_RapDipoles);
+
+    //=========================================================================================================
+    /**
+    * Returns whether the last call of localize did a full pair scan instead of the seeded row search.
+    *
+    * @return True if the last update was a full scan.
+    */
+    inline bool lastUpdateWasFullScan() const;
+
+    //=========================================================================================================
+    /**
+    * Streams the evoked data through the sliding window and localizes once per hop. The window size and overlap are
+    * taken from setStcAttr, the dipoles of each update are assigned to the samples which entered the window with it.
+    * The samples of a previous call are discarded, the tracked subspace and dipoles are kept to seed the search.
+    *
+    * @param[in] p_fiffEvoked   The evoked data.
+    * @param[in] pick_normal    Not used.
+    *
+    * @return The source estimate.
+    */
+    virtual MNESourceEstimate calculateInverse(const FiffEvoked &p_fiffEvoked, bool pick_normal = false);
+
+    using RapMusic::calculateInverse;
+
+    virtual const char* getName() const;
+
+private:
+    //=========================================================================================================
+    /**
+    * Tracks the dominant signal subspace of the current window covariance.
+    *
+    * @return The cosine of the largest principal angle to the subspace of the last full scan.
+    */
+    double trackSubspace();
+
+    //=========================================================================================================
+    /**
+    * Searches the best pair with alternating row scans starting at the given pair.
+    *
+    * @param[in] p_pairScan     The pair scan of the current recursion.
+    * @param[in, out] p_iIdx1   First source index, seed on input.
+    * @param[in, out] p_iIdx2   Second source index, seed on input.
+    *
+    * @return The subspace correlation of the found pair.
+    */
+    static double seededSearch(const RapMusicPairScan& p_pairScan, int& p_iIdx1, int& p_iIdx2);
+
+    int                             m_iWindowSize;          /**< Number of samples of the sliding window. */
+    int                             m_iNumSamples;          /**< Number of samples currently in the window. */
+    int                             m_iWriteIdx;            /**< Ring buffer position of the next sample. */
+    int                             m_iSamplesSinceResync;  /**< Number of samples since the covariance was recomputed from the window. */
+    double                          m_dRescanThreshold;     /**< Principal angle cosine below which a full scan is done. */
+    bool                            m_bLastFullScan;        /**< Whether the last update was a full scan. */
+
+    Eigen::MatrixXd                 m_matWindow;            /**< Ring buffer of the window samples (channels x window size). */
+    Eigen::MatrixXd                 m_matCov;               /**< Window covariance F*F^T. */
+    Eigen::MatrixXd                 m_matPhi_s;             /**< Tracked signal subspace basis (channels x rank). */
+    Eigen::MatrixXd                 m_matPhi_sScan;         /**< Signal subspace basis of the last full scan. */
+    RapMusicPairScan                m_pairScanUnprojected;  /**< Pair scan of the unprojected gain matrix, reused by the first recursion of every update. */
+    QList< DipolePair<double> >     m_lastDipoles;          /**< Dipole pairs of the previous update, seeding the search. */
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline int StreamingRapMusic::getWindowSize() const
+{
+    return m_iWindowSize;
+}
+
+
+//*************************************************************************************************************
+
+inline bool StreamingRapMusic::isWindowFull() const
+{
+    return m_iWindowSize > 0 && m_iNumSamples >= m_iWindowSize;
+}
+
+
+//*************************************************************************************************************
+
+inline bool StreamingRapMusic::lastUpdateWasFullScan() const
+{
+    return m_bLastFullScan;
+}
+
+} //NAMESPACE
+
+#endif // STREAMINGRAPMUSIC_H
@@ -40,7 +40,11 @@
 
 #include "mne_raw_data.h"
 
+#include <utils/fftservice.h>
+
 #include <QFile>
+#include <QVector>
+#include <QtConcurrent>
 
 #include <Eigen/Core>
 
@@ -326,9 +330,12 @@ void mne_channel_names_to_name_list(fiffChInfo chs, int nch,
 typedef struct {
     float *freq_resp;		/* Frequency response */
     float *eog_freq_resp;		/* Frequency response (EOG) */
-    float *precalc;		/* Precalculated data for FFT */
+    float *precalc;		/* Precalculated data for FFT (unused, the plans are cached by UTILSLIB::FFTService) */
     int   np;			/* Length */
     float nprec;
+    mneFilterDefRec def;	/* The filter definition this response was created for */
+    float sfreq;		/* The sampling frequency this response was created for */
+    int   highpass_effective;	/* Is the highpass part effective? */
 } *filterData,filterDataRec;
 
 static void filter_data_free(void *datap)
@@ -353,6 +360,8 @@ static filterData new_filter_data()
     data->eog_freq_resp = NULL;
     data->precalc       = NULL;
     data->np            = 0;
+    data->sfreq         = 0.0;
+    data->highpass_effective = FALSE;
     return data;
 }
 
@@ -386,57 +395,61 @@ int mne_compare_filters(mneFilterDef f1,
 //============================= mne_fft.c =============================
 
 
-void mne_fft_ana(float *data,int np, float **precalcp)
+void MneRawData::mne_fft_ana(float *data,int np, float **precalcp)
 /*
       * FFT analysis for real data
+      *
+      * The result replaces the data in the FFTPACK arrangement
+      * r0, r1, i1, r2, i2, ... (and r(np/2) if np is even).
+      * The plans are cached per thread by UTILSLIB::FFTService,
+      * precalcp is not used any more.
       */
 {
-    float *precalc;
-
-    printf("##################### DEBUG Error: FFT analysis needs to be implemented");
-
-    //  if (precalcp && *precalcp)
-    //    precalc = *precalcp;
-    //  else {
-    //    precalc = MALLOC(2*np+15,float);
-    //    rffti(&np,precalc);
-    //    if (precalcp)
-    //      *precalcp = precalc;
-    //  }
-    //  rfftf(&np,data,precalc);
-    if (!precalcp)
-        FREE_36(precalc);
+    int k,p;
+    Q_UNUSED(precalcp);
+
+    if (np < 1)
+        return;
+
+    VectorXcf spectrum(np/2+1);
+    UTILSLIB::FFTService::fwd(spectrum.data(),data,np);
+
+    p = 0;
+    data[p++] = spectrum[0].real();
+    for (k = 1; k < (np+1)/2; k++) {
+        data[p++] = spectrum[k].real();
+        data[p++] = spectrum[k].imag();
+    }
+    if (np % 2 == 0)
+        data[p] = spectrum[np/2].real();
     return;
 }
 
 
-void mne_fft_syn(float *data,int np, float **precalcp)
+void MneRawData::mne_fft_syn(float *data,int np, float **precalcp)
 /*
       * FFT synthesis for real data
+      *
+      * The input is in the arrangement produced by mne_fft_ana,
+      * the result is normalized, i.e., syn(ana(x)) = x.
       */
 {
-    float *precalc;
-    float mult;
-
-    printf("##################### DEBUG Error: FFT synthesis needs to be implemented");
-
-    //  if (precalcp && *precalcp)
-    //    precalc = *precalcp;
-    //  else {
-    //    precalc = MALLOC(2*np+15,float);
-    //    rffti(&np,precalc);
-    //    if (precalcp)
-    //      *precalcp = precalc;
-    //  }
-    //  rfftb(&np,data,precalc);
-    //  /*
-    //   * Normalization
-    //   */
-    //  mult = 1.0/np;
-    //  mne_scale_vector(mult,data,np);
-
-    if (!precalcp)
-        FREE_36(precalc);
+    int k,p;
+    Q_UNUSED(precalcp);
+
+    if (np < 1)
+        return;
+
+    VectorXcf spectrum(np/2+1);
+
+    p = 0;
+    spectrum[0] = std::complex<float>(data[p++],0.0f);
+    for (k = 1; k < (np+1)/2; k++, p += 2)
+        spectrum[k] = std::complex<float>(data[p],data[p+1]);
+    if (np % 2 == 0)
+        spectrum[np/2] = std::complex<float>(data[p],0.0f);
+
+    UTILSLIB::FFTService::inv(data,spectrum.data(),np);
     return;
 }
 
@@ -484,7 +497,7 @@ int mne_apply_filter(mneFilterDef filter, void *datap, float *data, int ns, int
     /*
    * Next comes the FFT
    */
-    mne_fft_ana(data,ns,&d->precalc);
+    MneRawData::mne_fft_ana(data,ns,&d->precalc);
     /*
    * Multiply with the frequency response
    * See FFTpack doc for details of the arrangement
@@ -512,12 +525,30 @@ int mne_apply_filter(mneFilterDef filter, void *datap, float *data, int ns, int
     if (ns % 2 == 0)
         data[p] = data[p]*freq_resp[k];
 
-    mne_fft_syn(data,ns,&d->precalc);
+    MneRawData::mne_fft_syn(data,ns,&d->precalc);
 
     return OK;
 }
 
 
+static int mne_apply_filter_ch(mneFilterDef filter, void *datap, float *data, int ns, float dc_offset, int kind)
+/*
+      * Filter one channel of a filter buffer. Stimulus channels are only zero padded.
+      * They are handled with a switched-off copy of the definition so that the shared
+      * one is never modified and several channels can be filtered concurrently.
+      */
+{
+    mneFilterDefRec no_filter;
+
+    if (kind == FIFFV_STIM_CH) {
+        no_filter           = *filter;
+        no_filter.filter_on = FALSE;
+        return mne_apply_filter(&no_filter,datap,data,ns,TRUE,0.0,kind);
+    }
+    return mne_apply_filter(filter,datap,data,ns,TRUE,dc_offset,kind);
+}
+
+
 
 
 
@@ -546,6 +577,8 @@ void mne_create_filter_response(mneFilterDef    filter,
     filter_data->freq_resp     = MALLOC_36(resp_size,float);
     filter_data->eog_freq_resp = MALLOC_36(resp_size,float);
     filter_data->np            = resp_size;
+    filter_data->def           = *filter;
+    filter_data->sfreq         = sfreq;
 
     for (k = 0; k < resp_size; k++) {
         filter_data->freq_resp[k]     = 1.0;
@@ -628,12 +661,39 @@ void mne_create_filter_response(mneFilterDef    filter,
         else
             fprintf(stderr,"NOTE: Filter is presently switched off.\n");
     }
+    filter_data->highpass_effective = *highpass_effective;
     *filter_datap      = filter_data;
     *filter_data_freep = filter_data_free;
     return;
 }
 
 
+int mne_filter_response_matches(mneFilterDef    filter,
+                                float           sfreq,
+                                void            *filter_datap,
+                                mneUserFreeFunc filter_data_freep,
+                                int             *highpass_effective)
+/*
+      * Has the response in filter_datap been created by mne_create_filter_response
+      * for this filter definition and sampling frequency? If so, it can be reused as is.
+      */
+{
+    filterData filter_data = (filterData)filter_datap;
+
+    if (!filter || !filter_data || filter_data_freep != filter_data_free)
+        return FALSE;
+    if (filter_data->sfreq != sfreq)
+        return FALSE;
+    if (filter_data->def.size != filter->size || filter_data->def.taper_size != filter->taper_size)
+        return FALSE;
+    if (mne_compare_filters(&filter_data->def,filter) != 0)
+        return FALSE;
+    if (highpass_effective)
+        *highpass_effective = filter_data->highpass_effective;
+    return TRUE;
+}
+
+
 
 
 
@@ -728,6 +788,18 @@ void mne_allocate_from_ring(void *ringp, int nrow, int ncol, float ***res)
     return;
 }
 
+static float ***mne_ring_next_owner(void *ringp)
+/*
+ * Which matrix loses its buffer at the next mne_allocate_from_ring call?
+ */
+{
+    ringBuf ring = (ringBuf)ringp;
+
+    if (!ring || ring->nbuf < 1)
+        return NULL;
+    return ring->bufs[ring->next > ring->nbuf-1 ? 0 : ring->next]->datap;
+}
+
 
 
 
@@ -1072,6 +1144,16 @@ void MneRawData::mne_raw_add_filter_response(MneRawData *data, int *highpass_eff
 {
     if (!data)
         return;
+    /*
+       * The frequency response depends on the filter definition and the sampling frequency only.
+       * Keep the previous one if neither has changed.
+       */
+    if (mne_filter_response_matches(data->filter,
+                                    data->info->sfreq,
+                                    data->filter_data,
+                                    data->filter_data_free,
+                                    highpass_effective))
+        return;
     /*
        * Free the previous filter definition
        */
@@ -1528,6 +1610,31 @@ int MneRawData::mne_raw_pick_data_proj(MneRawData *data, mneChSelection sel, int
 }
 
 
+//*************************************************************************************************************
+
+typedef struct {
+    MneRawBufDef *buf;		/* The filter buffer */
+    int          ch;		/* The channel to filter */
+    int          res;		/* Result of the filtering */
+} filtTaskRec;
+
+static void add_filter_task(QVector<filtTaskRec>& tasks, MneRawBufDef *buf, int ch)
+/*
+ * Schedule a channel for filtering unless it is done already or scheduled
+ */
+{
+    filtTaskRec task;
+
+    if (buf->ch_filtered[ch])
+        return;
+    buf->ch_filtered[ch] = TRUE;
+    task.buf = buf;
+    task.ch  = ch;
+    task.res = OK;
+    tasks.append(task);
+}
+
+
 //*************************************************************************************************************
 
 int MneRawData::load_one_filt_buf(MneRawData *data, MneRawBufDef *buf)
@@ -1572,18 +1679,25 @@ int MneRawData::load_one_filt_buf(MneRawData *data, MneRawBufDef *buf)
 int MneRawData::mne_raw_pick_data_filt(MneRawData *data, mneChSelection sel, int firsts, int ns, float **picked)
 /*
      * Data for a selection (filtered and picked)
+     *
+     * The filtered buffers stay in the filter ring so that overlapping requests
+     * only filter the channels which have not been done yet. The buffers needed
+     * are loaded in batches which fit in the ring and the channels of a batch are
+     * filtered in parallel before the overlap-add into picked.
      */
 {
-    int          k,s,bs,c;
+    int          k,s,bs,c,j;
+    int          kfirst,klast,knext;
     int          bs1,bs2,s1,s2,lasts;
     MneRawBufDef* this_buf;
     float        *values;
     float        **deriv_vals = NULL;
     float        *dc          = NULL;
-    float        dc_offset;
+    float        ***owner;
     int          deriv_ns     = 0;
     int          nderiv       = 0;
-    int          filter_was;
+    int          nfailed;
+    QVector<filtTaskRec> tasks;
 
     if (!data->filter || !data->filter->filter_on)
         return mne_raw_pick_data_proj(data,sel,firsts,ns,picked);
@@ -1617,162 +1731,148 @@ int MneRawData::mne_raw_pick_data_filt(MneRawData *data, mneChSelection sel, int
             if (MneProjOp::mne_proj_op_proj_vector(data->proj,dc,data->info->nchan,TRUE) != OK)
                 goto bad;
     }
-    filter_was = data->filter->filter_on;
     /*
-       * Find the first buffer to consider
+       * Find the range of buffers to consider
        */
-    for (k = 0, this_buf = data->filt_bufs; k < data->nfilt_buf; k++, this_buf++) {
-        if (this_buf->lasts >= firsts)
+    for (kfirst = 0; kfirst < data->nfilt_buf; kfirst++)
+        if (data->filt_bufs[kfirst].lasts >= firsts)
             break;
-    }
-    for (; k < data->nfilt_buf && this_buf->firsts <= lasts; k++, this_buf++) {
+    for (klast = kfirst; klast < data->nfilt_buf && data->filt_bufs[klast].firsts <= lasts; klast++)
+        ;
+    for (k = kfirst; k < klast; k = knext) {
+        /*
+         * Load the buffers first and apply projection. A batch ends before a buffer
+         * whose allocation would recycle the ring entry of a buffer in this batch.
+         */
+        for (knext = k; knext < klast; knext++) {
+            this_buf = data->filt_bufs + knext;
+            if (knext > k && !this_buf->vals) {
+                owner = mne_ring_next_owner(data->filt_ring);
+                for (j = k; j < knext; j++)
+                    if (owner == &data->filt_bufs[j].vals)
+                        break;
+                if (j < knext)
+                    break;
+            }
 #ifdef DEBUG
-        fprintf(stderr,"this_buf (%d): %d..%d\n",k,this_buf->firsts,this_buf->lasts);
+            fprintf(stderr,"this_buf (%d): %d..%d\n",knext,this_buf->firsts,this_buf->lasts);
 #endif
+            if (load_one_filt_buf(data,this_buf) != OK)
+                goto bad;
+        }
         /*
-         * Load the buffer first and apply projection
+         * Then collect the relevant channels which have not been filtered yet
          */
-        if (load_one_filt_buf(data,this_buf) != OK)
-            goto bad;
+        tasks.clear();
+        for (j = k; j < knext; j++) {
+            this_buf = data->filt_bufs + j;
+            if (sel) {
+                for (c = 0; c < sel->nchan; c++)
+                    if (sel->pick[c] >= 0)
+                        add_filter_task(tasks,this_buf,sel->pick[c]);
+                /*
+             * Also check channels included in derivations if they are used
+             */
+                if (sel->nderiv > 0 && data->deriv_matched) {
+                    MneDeriv* der = data->deriv_matched;
+                    for (c = 0; c < der->deriv_data->ncol; c++)
+                        if (der->in_use[c] > 0)
+                            add_filter_task(tasks,this_buf,c);
+                }
+            }
+            else {
+                /*
+             * Simply filter all channels if there is no selection
+             */
+                for (c = 0; c < data->info->nchan; c++)
+                    add_filter_task(tasks,this_buf,c);
+            }
+        }
         /*
-         * Then filter all relevant channels (not stimuli)
+         * Filter them in parallel (stimulus channels are only zero padded)
          */
-        if (sel) {
-            for (c = 0; c < sel->nchan; c++) {
-                if (sel->pick[c] >= 0) {
-                    if (!this_buf->ch_filtered[sel->pick[c]]) {
-                        /*
-                 * Do not filter stimulus channels
-                 */
-                        dc_offset = 0.0;
-                        if (data->info->chInfo[sel->pick[c]].kind == FIFFV_STIM_CH)
-                            data->filter->filter_on = FALSE;
-                        else if (dc)
-                            dc_offset = dc[sel->pick[c]];
-                        if (mne_apply_filter(data->filter,data->filter_data,this_buf->vals[sel->pick[c]],this_buf->ns,TRUE,
-                                             dc_offset,data->info->chInfo[sel->pick[c]].kind) != OK) {
-                            data->filter->filter_on = filter_was;
-                            goto bad;
-                        }
-                        this_buf->ch_filtered[sel->pick[c]] = TRUE;
-                        data->filter->filter_on = filter_was;
-                    }
-                }
+        QtConcurrent::blockingMap(tasks, [data,dc](filtTaskRec& task) {
+            int kind = data->info->chInfo[task.ch].kind;
+            task.res = mne_apply_filter_ch(data->filter,data->filter_data,task.buf->vals[task.ch],task.buf->ns,
+                                           dc ? dc[task.ch] : 0.0,kind);
+        });
+        for (j = 0, nfailed = 0; j < tasks.size(); j++) {
+            if (tasks[j].res != OK) {
+                tasks[j].buf->valid = FALSE;	/* Reload this one the next time */
+                nfailed++;
             }
+        }
+        if (nfailed > 0)
+            goto bad;
+        /*
+         * Pick data from the batch
+         */
+        for (j = k; j < knext; j++) {
+            this_buf = data->filt_bufs + j;
             /*
-           * Also check channels included in derivations if they are used
+           * Decide the picking limits
            */
-            if (sel->nderiv > 0 && data->deriv_matched) {
-                MneDeriv* der = data->deriv_matched;
-                for (c = 0; c < der->deriv_data->ncol; c++) {
-                    if (der->in_use[c] > 0 &&
-                            !this_buf->ch_filtered[c]) {
-                        /*
-                 * Do not filter stimulus channels
-                 */
-                        dc_offset = 0.0;
-                        if (data->info->chInfo[c].kind == FIFFV_STIM_CH)
-                            data->filter->filter_on = FALSE;
-                        else if (dc)
-                            dc_offset = dc[c];
-                        if (mne_apply_filter(data->filter,data->filter_data,this_buf->vals[c],this_buf->ns,TRUE,
-                                             dc_offset,data->info->chInfo[c].kind) != OK) {
-                            data->filter->filter_on = filter_was;
-                            goto bad;
-                        }
-                        this_buf->ch_filtered[c] = TRUE;
-                        data->filter->filter_on = filter_was;
-                    }
-                }
+            if (firsts >= this_buf->firsts) {
+                bs1 = firsts - this_buf->firsts;
+                s1  = 0;
             }
-        }
-        else {
+            else {
+                bs1 = 0;
+                s1  = this_buf->firsts - firsts;
+            }
+            if (lasts >= this_buf->lasts) {
+                bs2 = this_buf->ns;
+                s2  = this_buf->lasts - lasts + ns;
+            }
+            else {
+                bs2 = lasts - this_buf->lasts + this_buf->ns;
+                s2  = ns;
+            }
+#ifdef DEBUG
+            fprintf(stderr,"buf  : %d..%d %d\n",bs1,bs2,bs2-bs1);
+            fprintf(stderr,"dest : %d..%d %d\n",s1,s2,s2-s1);
+#endif
             /*
-           * Simply filter all channels if there is no selection
+           * Then pick data from all relevant channels
            */
-            for (c = 0; c < data->info->nchan; c++) {
-                if (!this_buf->ch_filtered[c]) {
+            if (sel) {
+                if (sel->nderiv > 0 && data->deriv_matched) {
                     /*
-               * Do not filter stimulus channels
+               * Compute derived data if we need it
                */
-                    dc_offset = 0.0;
-                    if (data->info->chInfo[c].kind == FIFFV_STIM_CH)
-                        data->filter->filter_on = FALSE;
-                    else if (dc)
-                        dc_offset = dc[c];
-                    if (mne_apply_filter(data->filter,data->filter_data,this_buf->vals[c],this_buf->ns,TRUE,
-                                         dc_offset,data->info->chInfo[c].kind) != OK) {
-                        data->filter->filter_on = filter_was;
-                        goto bad;
+                    if (deriv_ns < this_buf->ns || nderiv != data->deriv_matched->deriv_data->nrow) {
+                        FREE_CMATRIX_36(deriv_vals);
+                        deriv_vals  = ALLOC_CMATRIX_36(data->deriv_matched->deriv_data->nrow,this_buf->ns);
+                        nderiv      = data->deriv_matched->deriv_data->nrow;
+                        deriv_ns    = this_buf->ns;
                     }
-                    this_buf->ch_filtered[c] = TRUE;
-                    data->filter->filter_on = filter_was;
+                    if (mne_sparse_mat_mult2(data->deriv_matched->deriv_data->data,this_buf->vals,this_buf->ns,deriv_vals) == FAIL)
+                        goto bad;
                 }
-            }
-        }
-        /*
-         * Decide the picking limits
-         */
-        if (firsts >= this_buf->firsts) {
-            bs1 = firsts - this_buf->firsts;
-            s1  = 0;
-        }
-        else {
-            bs1 = 0;
-            s1  = this_buf->firsts - firsts;
-        }
-        if (lasts >= this_buf->lasts) {
-            bs2 = this_buf->ns;
-            s2  = this_buf->lasts - lasts + ns;
-        }
-        else {
-            bs2 = lasts - this_buf->lasts + this_buf->ns;
-            s2  = ns;
-        }
-#ifdef DEBUG
-        fprintf(stderr,"buf  : %d..%d %d\n",bs1,bs2,bs2-bs1);
-        fprintf(stderr,"dest : %d..%d %d\n",s1,s2,s2-s1);
-#endif
-        /*
-         * Then pick data from all relevant channels
-         */
-        if (sel) {
-            if (sel->nderiv > 0 && data->deriv_matched) {
-                /*
-             * Compute derived data if we need it
-             */
-                if (deriv_ns < this_buf->ns || nderiv != data->deriv_matched->deriv_data->nrow) {
-                    FREE_CMATRIX_36(deriv_vals);
-                    deriv_vals  = ALLOC_CMATRIX_36(data->deriv_matched->deriv_data->nrow,this_buf->ns);
-                    nderiv      = data->deriv_matched->deriv_data->nrow;
-                    deriv_ns    = this_buf->ns;
+                for (c = 0; c < sel->nchan; c++) {
+                    /*
+               * First the ordinary channels
+               */
+                    if (sel->pick[c] >= 0) {
+                        values = this_buf->vals[sel->pick[c]];
+                        for (s = s1, bs = bs1; s < s2; s++, bs++)
+                            picked[c][s] += values[bs];
+                    }
+                    else if (sel->pick_deriv[c] >= 0 && data->deriv_matched) {
+                        values = deriv_vals[sel->pick_deriv[c]];
+                        for (s = s1, bs = bs1; s < s2; s++, bs++)
+                            picked[c][s] += values[bs];
+                    }
                 }
-                if (mne_sparse_mat_mult2(data->deriv_matched->deriv_data->data,this_buf->vals,this_buf->ns,deriv_vals) == FAIL)
-                    goto bad;
             }
-            for (c = 0; c < sel->nchan; c++) {
-                /*
-             * First the ordinary channels
-             */
-                if (sel->pick[c] >= 0) {
-                    values = this_buf->vals[sel->pick[c]];
-                    for (s = s1, bs = bs1; s < s2; s++, bs++)
-                        picked[c][s] += values[bs];
-                }
-                else if (sel->pick_deriv[c] >= 0 && data->deriv_matched) {
-                    values = deriv_vals[sel->pick_deriv[c]];
+            else {
+                for (c = 0; c < data->info->nchan; c++) {
+                    values = this_buf->vals[c];
                     for (s = s1, bs = bs1; s < s2; s++, bs++)
                         picked[c][s] += values[bs];
                 }
             }
         }
-        else {
-            for (c = 0; c < data->info->nchan; c++) {
-                values = this_buf->vals[c];
-                for (s = s1, bs = bs1; s < s2; s++, bs++)
-                    picked[c][s] += values[bs];
-            }
-        }
     }
     FREE_CMATRIX_36(deriv_vals);
     FREE_36(dc);
@@ -116,6 +116,12 @@ public:
 
 
 
+    static void mne_fft_ana(float *data, int np, float **precalcp);
+
+
+    static void mne_fft_syn(float *data, int np, float **precalcp);
+
+
     static void mne_raw_add_filter_response(MneRawData* data, int *highpass_effective);
 
 
@@ -89,6 +89,7 @@ SOURCES += \
     mne_sourceestimate.cpp \
     mne_hemisphere.cpp \
     mne_inverse_operator.cpp \
+    mne_inverse_operator_builder.cpp \
     mne_epoch_data.cpp \
     mne_epoch_data_list.cpp \
     mne_cluster_info.cpp \
@@ -97,6 +98,7 @@ SOURCES += \
     mne_bem.cpp\
     mne_bem_surface.cpp \
     mne_project_to_surface.cpp \
+    mne_event_index.cpp \
     c/mne_cov_matrix.cpp \
     c/mne_ctf_comp_data.cpp \
     c/mne_ctf_comp_data_set.cpp \
@@ -139,6 +141,7 @@ HEADERS += \
     mne_forwardsolution.h \
     mne_sourceestimate.h \
     mne_inverse_operator.h \
+    mne_inverse_operator_builder.h \
     mne_epoch_data.h \
     mne_epoch_data_list.h \
     mne_cluster_info.h \
@@ -147,6 +150,7 @@ HEADERS += \
     mne_bem.h\
     mne_bem_surface.h \
     mne_project_to_surface.h \
+    mne_event_index.h \
     c/mne_cov_matrix.h \
     c/mne_ctf_comp_data.h \
     c/mne_ctf_comp_data_set.h \
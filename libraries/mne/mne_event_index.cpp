@@ -0,0 +1,336 @@
+//=============================================================================================================
+/**
+* @file     mne_event_index.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     MNEEventIndex class definition.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "mne_event_index.h"
+
+#include <utils/eventdetector.h>
+#include <utils/ioutils.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QSaveFile>
+#include <QCryptographicHash>
+#include <QDebug>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <algorithm>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace MNELIB;
+using namespace FIFFLIB;
+using namespace UTILSLIB;
+using namespace Eigen;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE GLOBAL METHODS
+//=============================================================================================================
+
+namespace
+{
+
+const quint32 EVENTINDEX_CACHE_MAGIC = 0x4d4e4549;  /**< "MNEI" */
+const qint32 EVENTINDEX_CACHE_VERSION = 1;
+
+bool readEventIndexCache(const QString& sCacheFileName, const QByteArray& baKey, MNEEventIndex& eventIndex)
+{
+    QFile file(sCacheFileName);
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic;
+    qint32 version;
+    QByteArray key;
+    stream >> magic >> version >> key;
+    if(magic != EVENTINDEX_CACHE_MAGIC || version != EVENTINDEX_CACHE_VERSION || key != baKey)
+        return false;
+
+    return MNEEventIndex::deserialize(stream, eventIndex);
+}
+
+void writeEventIndexCache(const QString& sCacheFileName, const QByteArray& baKey, const MNEEventIndex& eventIndex)
+{
+    QDir().mkpath(QFileInfo(sCacheFileName).absolutePath());
+
+    QSaveFile file(sCacheFileName);
+    if(!file.open(QIODevice::WriteOnly)) {
+        qWarning("MNEEventIndex: Could not write cache file %s", sCacheFileName.toUtf8().constData());
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    stream << EVENTINDEX_CACHE_MAGIC << EVENTINDEX_CACHE_VERSION << baKey;
+    eventIndex.serialize(stream);
+
+    file.commit();
+}
+
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+MNEEventIndex::MNEEventIndex()
+: m_matEvents(0,4)
+{
+}
+
+
+//*************************************************************************************************************
+
+bool MNEEventIndex::build(const QString& sRawFile,
+                          MNEEventIndex& eventIndex,
+                          const QStringList& slChannels,
+                          const QString& sCacheDir,
+                          double dThreshold)
+{
+    eventIndex.clear();
+
+    QString sCacheFileName;
+    QByteArray baKey;
+    if(!sCacheDir.isEmpty())
+    {
+        //the index depends on the picked channels and the threshold, hence both are part of the key
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        hash.addData(IOUtils::file_stamp_key(QStringList() << sRawFile));
+        hash.addData(QString("%1;%2").arg(slChannels.join(",")).arg(dThreshold).toUtf8());
+        baKey = hash.result();
+        sCacheFileName = QString("%1/%2-%3.bin").arg(sCacheDir).arg(QFileInfo(sRawFile).fileName()).arg(QString(baKey.toHex().left(16)));
+
+        if(readEventIndexCache(sCacheFileName, baKey, eventIndex))
+        {
+            printf("Read event index from cache %s\n", sCacheFileName.toUtf8().constData());
+            return true;
+        }
+    }
+
+    QFile t_fileRaw(sRawFile);
+    FiffRawData raw(t_fileRaw);
+    if(raw.isEmpty())
+        return false;
+
+    if(!build(raw, eventIndex, slChannels, dThreshold))
+        return false;
+
+    if(!sCacheFileName.isEmpty())
+        writeEventIndexCache(sCacheFileName, baKey, eventIndex);
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+bool MNEEventIndex::build(FiffRawData& raw,
+                          MNEEventIndex& eventIndex,
+                          const QStringList& slChannels,
+                          double dThreshold)
+{
+    eventIndex.clear();
+
+    if(raw.isEmpty())
+        return false;
+
+    RowVectorXi picks;
+    if(slChannels.isEmpty())
+        picks = raw.info.pick_types(false, false, true);
+    else
+        picks = raw.info.pick_channels(raw.info.ch_names, slChannels);
+
+    if(picks.cols() == 0) {
+        qWarning("MNEEventIndex::build - No stim channels to index.");
+        return false;
+    }
+
+    QStringList slPicked;
+    QList<int> lRows;
+    for(int i = 0; i < picks.cols(); ++i) {
+        slPicked << raw.info.ch_names.at(picks(i));
+        lRows << i;
+    }
+
+    //The picked rows are scanned at once, the detector carries the edges over the block boundaries
+    EventDetector detector(lRows, dThreshold, EventDetector::Gradient, EventDetector::Rising);
+
+    const qint32 iBlockSize = qMax(1, static_cast<qint32>(MNE_EVENT_INDEX_BLOCK_SEC * raw.info.sfreq));
+
+    QVector<DetectedEvent> vecEvents;
+    MatrixXd matData, matTimes;
+
+    for(qint32 iFrom = raw.first_samp; iFrom <= raw.last_samp; iFrom += iBlockSize) {
+        qint32 iTo = qMin(iFrom + iBlockSize - 1, raw.last_samp);
+
+        if(!raw.read_raw_segment(matData, matTimes, iFrom, iTo, picks)) {
+            qWarning("MNEEventIndex::build - Could not read raw segment %d to %d.", iFrom, iTo);
+            return false;
+        }
+
+        QVector<DetectedEvent> vecBlockEvents = detector.detect(matData, iFrom);
+        for(int i = 0; i < vecBlockEvents.size(); ++i)
+            vecEvents.append(vecBlockEvents.at(i));
+    }
+
+    eventIndex.m_slChannels = slPicked;
+    eventIndex.m_matEvents.resize(vecEvents.size(), 4);
+    for(int i = 0; i < vecEvents.size(); ++i) {
+        eventIndex.m_matEvents(i,0) = static_cast<int>(vecEvents.at(i).iSample);
+        eventIndex.m_matEvents(i,1) = vecEvents.at(i).iChannel;
+        eventIndex.m_matEvents(i,2) = qRound(vecEvents.at(i).dBefore);
+        eventIndex.m_matEvents(i,3) = qRound(vecEvents.at(i).dAfter);
+    }
+
+    printf("Indexed %d events on %d stim channels\n", static_cast<int>(vecEvents.size()), slPicked.size());
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+void MNEEventIndex::clear()
+{
+    m_slChannels.clear();
+    m_matEvents.resize(0,4);
+}
+
+
+//*************************************************************************************************************
+
+MatrixXi MNEEventIndex::eventList(const QString& sChannel) const
+{
+    int iChannel = sChannel.isEmpty() ? 0 : m_slChannels.indexOf(sChannel);
+    if(iChannel < 0 || iChannel >= m_slChannels.size())
+        return MatrixXi(0,3);
+
+    int iCount = (m_matEvents.col(1).array() == iChannel).count();
+
+    MatrixXi matEventList(iCount, 3);
+    for(int i = 0, k = 0; i < m_matEvents.rows(); ++i) {
+        if(m_matEvents(i,1) != iChannel)
+            continue;
+
+        matEventList(k,0) = m_matEvents(i,0);
+        matEventList(k,1) = m_matEvents(i,2);
+        matEventList(k,2) = m_matEvents(i,3);
+        ++k;
+    }
+
+    return matEventList;
+}
+
+
+//*************************************************************************************************************
+
+MatrixXi MNEEventIndex::eventsInRange(int iFrom, int iTo) const
+{
+    const int* pSamples = m_matEvents.col(0).data();
+    const int iNumEvents = static_cast<int>(m_matEvents.rows());
+
+    int iFirst = static_cast<int>(std::lower_bound(pSamples, pSamples + iNumEvents, iFrom) - pSamples);
+    int iLast = static_cast<int>(std::upper_bound(pSamples, pSamples + iNumEvents, iTo) - pSamples);
+
+    if(iLast <= iFirst)
+        return MatrixXi(0,4);
+
+    return m_matEvents.middleRows(iFirst, iLast - iFirst);
+}
+
+
+//*************************************************************************************************************
+
+void MNEEventIndex::serialize(QDataStream& stream) const
+{
+    stream << m_slChannels << static_cast<qint32>(m_matEvents.rows());
+
+    for(int i = 0; i < m_matEvents.rows(); ++i)
+        stream << m_matEvents(i,0) << m_matEvents(i,1) << m_matEvents(i,2) << m_matEvents(i,3);
+}
+
+
+//*************************************************************************************************************
+
+bool MNEEventIndex::deserialize(QDataStream& stream, MNEEventIndex& eventIndex)
+{
+    eventIndex.clear();
+
+    QStringList slChannels;
+    qint32 iNumEvents;
+    stream >> slChannels >> iNumEvents;
+    if(stream.status() != QDataStream::Ok || iNumEvents < 0)
+        return false;
+
+    MatrixXi matEvents(iNumEvents, 4);
+    for(int i = 0; i < iNumEvents; ++i)
+        stream >> matEvents(i,0) >> matEvents(i,1) >> matEvents(i,2) >> matEvents(i,3);
+
+    if(stream.status() != QDataStream::Ok)
+        return false;
+
+    eventIndex.m_slChannels = slChannels;
+    eventIndex.m_matEvents = matEvents;
+
+    return true;
+}
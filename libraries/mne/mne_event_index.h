@@ -0,0 +1,248 @@
+//=============================================================================================================
+/**
+* @file     mne_event_index.h
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     MNEEventIndex class declaration.
+*
+*/
+
+#ifndef MNE_EVENT_INDEX_H
+#define MNE_EVENT_INDEX_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "mne_global.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// FIFF INCLUDES
+//=============================================================================================================
+
+#include <fiff/fiff_raw_data.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QSharedPointer>
+#include <QStringList>
+#include <QDataStream>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE MNELIB
+//=============================================================================================================
+
+namespace MNELIB
+{
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINES
+//=============================================================================================================
+
+#define MNE_EVENT_INDEX_BLOCK_SEC   10.0    /**< Length in seconds of the blocks read while indexing. */
+
+
+//=============================================================================================================
+/**
+* The events are found in one pass over the raw file with a UTILSLIB::EventDetector, which keeps the state of all
+* stim channels across the read blocks. The index is held as one compact integer matrix with a row per event
+* (sample, channel, value before, value after), sorted by sample. It can be cached next to other parsed data and
+* converted to the MNE event list format read by MNE::read_events.
+*
+* @brief One pass event index of the stim channels of a raw file.
+*/
+class MNESHARED_EXPORT MNEEventIndex
+{
+public:
+    typedef QSharedPointer<MNEEventIndex> SPtr;            /**< Shared pointer type for MNEEventIndex. */
+    typedef QSharedPointer<const MNEEventIndex> ConstSPtr; /**< Const shared pointer type for MNEEventIndex. */
+
+    //=========================================================================================================
+    /**
+    * Constructs an empty event index.
+    */
+    MNEEventIndex();
+
+    //=========================================================================================================
+    /**
+    * Builds the event index of a raw file. If a cache directory is given, the index is read from there when the
+    * raw file did not change, and written there otherwise.
+    *
+    * @param[in] sRawFile       The raw file.
+    * @param[out] eventIndex    The event index.
+    * @param[in] slChannels     The stim channels to index. All stim channels are indexed if empty (default).
+    * @param[in] sCacheDir      Directory of the binary cache. No cache is used if empty (default).
+    * @param[in] dThreshold     The step a channel value has to rise by to form an event.
+    *
+    * @return true if the index was built.
+    */
+    static bool build(const QString& sRawFile,
+                      MNEEventIndex& eventIndex,
+                      const QStringList& slChannels = QStringList(),
+                      const QString& sCacheDir = QString(),
+                      double dThreshold = 0.5);
+
+    //=========================================================================================================
+    /**
+    * Builds the event index of an opened raw file.
+    *
+    * @param[in] raw            The raw data.
+    * @param[out] eventIndex    The event index.
+    * @param[in] slChannels     The stim channels to index. All stim channels are indexed if empty (default).
+    * @param[in] dThreshold     The step a channel value has to rise by to form an event.
+    *
+    * @return true if the index was built.
+    */
+    static bool build(FIFFLIB::FiffRawData& raw,
+                      MNEEventIndex& eventIndex,
+                      const QStringList& slChannels = QStringList(),
+                      double dThreshold = 0.5);
+
+    //=========================================================================================================
+    /**
+    * Clears the index.
+    */
+    void clear();
+
+    //=========================================================================================================
+    /**
+    * Returns whether the index holds no channels.
+    *
+    * @return true if no channels were indexed.
+    */
+    inline bool isEmpty() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the indexed channels.
+    *
+    * @return the names of the indexed stim channels, in the order referred to by the channel column of events().
+    */
+    inline const QStringList& channelNames() const;
+
+    //=========================================================================================================
+    /**
+    * Returns all events.
+    *
+    * @return the events sorted by sample, one row per event: sample, channel, value before, value after.
+    */
+    inline const Eigen::MatrixXi& events() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the events of one channel in the MNE event list format.
+    *
+    * @param[in] sChannel   The channel name. The first indexed channel is used if empty (default).
+    *
+    * @return the events, one row per event: sample, value before, value after.
+    */
+    Eigen::MatrixXi eventList(const QString& sChannel = QString()) const;
+
+    //=========================================================================================================
+    /**
+    * Returns the events of all channels within a sample range.
+    *
+    * @param[in] iFrom      The first sample of the range.
+    * @param[in] iTo        The last sample of the range.
+    *
+    * @return the events within the range in the format of events().
+    */
+    Eigen::MatrixXi eventsInRange(int iFrom, int iTo) const;
+
+    //=========================================================================================================
+    /**
+    * Writes the index to a binary stream.
+    *
+    * @param[in] stream     The stream to write to.
+    */
+    void serialize(QDataStream& stream) const;
+
+    //=========================================================================================================
+    /**
+    * Reads an index written by serialize.
+    *
+    * @param[in] stream         The stream to read from.
+    * @param[out] eventIndex    The read index.
+    *
+    * @return true if the index was read.
+    */
+    static bool deserialize(QDataStream& stream, MNEEventIndex& eventIndex);
+
+private:
+    QStringList         m_slChannels;   /**< The indexed stim channels. */
+    Eigen::MatrixXi     m_matEvents;    /**< The events: sample, channel, value before, value after. */
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline bool MNEEventIndex::isEmpty() const
+{
+    return m_slChannels.isEmpty();
+}
+
+
+//*************************************************************************************************************
+
+inline const QStringList& MNEEventIndex::channelNames() const
+{
+    return m_slChannels;
+}
+
+
+//*************************************************************************************************************
+
+inline const Eigen::MatrixXi& MNEEventIndex::events() const
+{
+    return m_matEvents;
+}
+
+} // NAMESPACE MNELIB
+
+#endif // MNE_EVENT_INDEX_H
@@ -70,8 +70,20 @@
 //=============================================================================================================
 
 #include <iostream>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
 #include <QtConcurrent>
 #include <QFuture>
+#include <QThreadPool>
+#include <QThreadStorage>
+#include <QCryptographicHash>
+#include <QFileInfo>
+#include <QSaveFile>
 
 
 //*************************************************************************************************************
@@ -84,6 +96,198 @@ using namespace UTILSLIB;
 using namespace FSLIB;
 
 
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE GLOBAL METHODS
+//=============================================================================================================
+
+namespace
+{
+
+const quint32 CLUSTER_CACHE_MAGIC   = 0x4d434c53;   /**< "MCLS" */
+const qint32  CLUSTER_CACHE_VERSION = 1;
+
+//=============================================================================================================
+/**
+* K-means workspace which is kept alive per clustering thread, so that consecutive regions reuse its buffers.
+*/
+struct ClusterWorkspace
+{
+    ClusterWorkspace(const QString& sDistMeasure)
+    : m_sDistMeasure(sDistMeasure)
+    , m_kMeans(sDistMeasure, QString("sample"), 5)
+    {
+    }
+
+    QString m_sDistMeasure;     /**< Distance measure the k-means object was configured with. */
+    KMeans  m_kMeans;           /**< The k-means workspace. */
+};
+
+
+//*************************************************************************************************************
+
+QThreadPool* clusterThreadPool()
+{
+    //Dedicated pool, so clustering does not compete with other users of the global pool
+    static QThreadPool s_threadPool;
+    return &s_threadPool;
+}
+
+
+//*************************************************************************************************************
+
+KMeans& clusterWorkspace(const QString& sDistMeasure)
+{
+    static QThreadStorage<ClusterWorkspace*> s_workspaces;
+
+    //QThreadStorage takes ownership and deletes a previously set workspace
+    if(!s_workspaces.hasLocalData() || s_workspaces.localData()->m_sDistMeasure != sDistMeasure) {
+        s_workspaces.setLocalData(new ClusterWorkspace(sDistMeasure));
+    }
+
+    return s_workspaces.localData()->m_kMeans;
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd reshapeRegionGain(const MatrixXd& matG, const VectorXi& vecIdcs, qint32 iOffset)
+{
+    //Every source becomes one row holding its sensors x (x,y,z) block in row-major order. This is the column-major
+    //layout of the transposed block, so gather into the transposed result column by column.
+    MatrixXd matRoiGT(3*matG.rows(), vecIdcs.rows());
+
+    for(qint32 j = 0; j < vecIdcs.rows(); ++j) {
+        Map<MatrixXd>(matRoiGT.col(j).data(), 3, matG.rows()) = matG.middleCols((vecIdcs[j]+iOffset)*3, 3).transpose();
+    }
+
+    return matRoiGT.transpose();
+}
+
+
+//*************************************************************************************************************
+
+template<typename T>
+void addMatrixToHash(QCryptographicHash& hash, const T& mat)
+{
+    qint64 dims[2] = {mat.rows(), mat.cols()};
+    hash.addData(reinterpret_cast<const char*>(dims), sizeof(dims));
+    hash.addData(reinterpret_cast<const char*>(mat.data()), int(mat.size() * sizeof(typename T::Scalar)));
+}
+
+
+//*************************************************************************************************************
+
+template<typename T>
+void writeMatrix(QDataStream& stream, const T& mat)
+{
+    stream << qint32(mat.rows()) << qint32(mat.cols());
+    for(qint32 i = 0; i < mat.size(); ++i) {
+        stream << mat.data()[i];
+    }
+}
+
+
+//*************************************************************************************************************
+
+template<typename T>
+void readMatrix(QDataStream& stream, T& mat)
+{
+    qint32 rows, cols;
+    stream >> rows >> cols;
+    if(stream.status() != QDataStream::Ok || rows < 0 || cols < 0 || (T::ColsAtCompileTime == 1 && cols != 1)) {
+        stream.setStatus(QDataStream::ReadCorruptData);
+        return;
+    }
+
+    mat.resize(rows, cols);
+    for(qint32 i = 0; i < mat.size(); ++i) {
+        stream >> mat.data()[i];
+    }
+}
+
+
+//*************************************************************************************************************
+
+bool readClusterCache(const QString& sFileName, const QByteArray& baKey, QList<QList<RegionDataOut> >& qListRegionDataOut)
+{
+    QFile file(sFileName);
+    if(!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic;
+    qint32 version;
+    QByteArray key;
+    stream >> magic >> version >> key;
+    if(magic != CLUSTER_CACHE_MAGIC || version != CLUSTER_CACHE_VERSION || key != baKey) {
+        return false;
+    }
+
+    qint32 nHemis;
+    stream >> nHemis;
+    for(qint32 h = 0; h < nHemis && stream.status() == QDataStream::Ok; ++h) {
+        qint32 nRegions;
+        stream >> nRegions;
+
+        QList<RegionDataOut> qListHemi;
+        for(qint32 i = 0; i < nRegions && stream.status() == QDataStream::Ok; ++i) {
+            RegionDataOut regionDataOut;
+            stream >> regionDataOut.iLabelIdxOut;
+            readMatrix(stream, regionDataOut.roiIdx);
+            readMatrix(stream, regionDataOut.ctrs);
+            readMatrix(stream, regionDataOut.sumd);
+            readMatrix(stream, regionDataOut.D);
+            qListHemi.append(regionDataOut);
+        }
+        qListRegionDataOut.append(qListHemi);
+    }
+
+    if(stream.status() != QDataStream::Ok) {
+        qListRegionDataOut.clear();
+        return false;
+    }
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+bool writeClusterCache(const QString& sFileName, const QByteArray& baKey, const QList<QList<RegionDataOut> >& qListRegionDataOut)
+{
+    //Write to a temporary file first, so concurrent readers never see a partially written cache
+    QSaveFile file(sFileName);
+    if(!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    stream << CLUSTER_CACHE_MAGIC << CLUSTER_CACHE_VERSION << baKey;
+    stream << qint32(qListRegionDataOut.size());
+    for(qint32 h = 0; h < qListRegionDataOut.size(); ++h) {
+        stream << qint32(qListRegionDataOut[h].size());
+        for(qint32 i = 0; i < qListRegionDataOut[h].size(); ++i) {
+            const RegionDataOut& regionDataOut = qListRegionDataOut[h][i];
+            stream << regionDataOut.iLabelIdxOut;
+            writeMatrix(stream, regionDataOut.roiIdx);
+            writeMatrix(stream, regionDataOut.ctrs);
+            writeMatrix(stream, regionDataOut.sumd);
+            writeMatrix(stream, regionDataOut.D);
+        }
+    }
+
+    return stream.status() == QDataStream::Ok && file.commit();
+}
+
+} // namespace
+
+
 //*************************************************************************************************************
 //=============================================================================================================
 // DEFINE MEMBER METHODS
@@ -178,7 +382,7 @@ void MNEForwardSolution::clear()
 
 //*************************************************************************************************************
 
-MNEForwardSolution MNEForwardSolution::cluster_forward_solution(const AnnotationSet &p_AnnotationSet, qint32 p_iClusterSize, MatrixXd& p_D, const FiffCov &p_pNoise_cov, const FiffInfo &p_pInfo, QString p_sMethod) const
+MNEForwardSolution MNEForwardSolution::cluster_forward_solution(const AnnotationSet &p_AnnotationSet, qint32 p_iClusterSize, MatrixXd& p_D, const FiffCov &p_pNoise_cov, const FiffInfo &p_pInfo, QString p_sMethod, const QString& p_sFwdFileName) const
 {
     printf("Cluster forward solution using %s.\n", p_sMethod.toUtf8().constData());
 
@@ -235,6 +439,52 @@ MNEForwardSolution MNEForwardSolution::cluster_forward_solution(const Annotation
     }
 
 
+    //
+    // Get label ids for every vertex
+    //
+    QList<VectorXi> t_qListVertnoLabeled;
+    for(qint32 h = 0; h < this->src.size(); ++h)
+    {
+        //ToDo make this more universal -> using Label instead of annotations - obsolete when using Labels
+        const VectorXi t_vecLabelIds = p_AnnotationSet[h].getLabelIds();
+        VectorXi vertno_labeled(this->src[h].vertno.rows());
+
+        for(qint32 i = 0; i < vertno_labeled.rows(); ++i)
+            vertno_labeled[i] = t_vecLabelIds[this->src[h].vertno[i]];
+
+        t_qListVertnoLabeled.append(vertno_labeled);
+    }
+
+    //
+    // Look up a cached clustering of the same forward model, annotation and parameters
+    //
+    QString t_sCacheFileName;
+    QByteArray t_baCacheKey;
+    QList<QList<RegionDataOut> > t_qListCachedRegionDataOut;
+
+    if(!p_sFwdFileName.isEmpty())
+    {
+        QCryptographicHash t_hash(QCryptographicHash::Sha1);
+        t_hash.addData(p_sMethod.toUtf8());
+        t_hash.addData(QByteArray::number(p_iClusterSize));
+        addMatrixToHash(t_hash, this->sol->data);
+        if(t_bUseWhitened)
+            addMatrixToHash(t_hash, t_G_Whitened);
+        for(qint32 h = 0; h < this->src.size(); ++h)
+        {
+            addMatrixToHash(t_hash, this->src[h].vertno);
+            addMatrixToHash(t_hash, t_qListVertnoLabeled[h]);
+            addMatrixToHash(t_hash, p_AnnotationSet[h].getColortable().getLabelIds());
+        }
+        t_baCacheKey = t_hash.result();
+
+        QFileInfo t_fileInfo(p_sFwdFileName);
+        t_sCacheFileName = QString("%1/%2-clust-%3.bin").arg(t_fileInfo.absolutePath()).arg(t_fileInfo.completeBaseName()).arg(QString(t_baCacheKey.toHex().left(16)));
+
+        if(readClusterCache(t_sCacheFileName, t_baCacheKey, t_qListCachedRegionDataOut))
+            printf("\tUsing cached clustering %s.\n", t_sCacheFileName.toUtf8().constData());
+    }
+
     //
     // Assemble input data
     //
@@ -242,6 +492,8 @@ MNEForwardSolution MNEForwardSolution::cluster_forward_solution(const Annotation
     qint32 offset;
 
     MatrixXd t_G_new;
+    QList<QList<RegionDataOut> > t_qListRegionDataOutAll;
+    bool t_bUpdateCache = false;
 
     for(qint32 h = 0; h < this->src.size(); ++h )
     {
@@ -262,16 +514,18 @@ MNEForwardSolution MNEForwardSolution::cluster_forward_solution(const Annotation
         Colortable t_CurrentColorTable = p_AnnotationSet[h].getColortable();
         VectorXi label_ids = t_CurrentColorTable.getLabelIds();
 
-        // Get label ids for every vertex
-        VectorXi vertno_labeled = VectorXi::Zero(this->src[h].vertno.rows());
+        const VectorXi& vertno_labeled = t_qListVertnoLabeled[h];
 
-        //ToDo make this more universal -> using Label instead of annotations - obsolete when using Labels
-        for(qint32 i = 0; i < vertno_labeled.rows(); ++i)
-            vertno_labeled[i] = p_AnnotationSet[h].getLabelIds()[this->src[h].vertno[i]];
+        //Select ROIs - group the source space indices by label in one pass
+        QHash<qint32, QVector<qint32> > t_hashLabelIdcs;
+        for(qint32 j = 0; j < vertno_labeled.rows(); ++j)
+            t_hashLabelIdcs[vertno_labeled[j]].append(j);
 
         //Qt Concurrent List
         QList<RegionData> m_qListRegionDataIn;
 
+        qint32 nSens = this->sol->data.rows();
+
         //
         // Generate cluster input data
         //
@@ -285,33 +539,10 @@ MNEForwardSolution MNEForwardSolution::cluster_forward_solution(const Annotation
                 //
                 // Get source space indeces
                 //
-                VectorXi idcs = VectorXi::Zero(vertno_labeled.rows());
-                qint32 c = 0;
-
-                //Select ROIs //change this use label info with a hash tabel
-                for(qint32 j = 0; j < vertno_labeled.rows(); ++j)
-                {
-                    if(vertno_labeled[j] == label_ids[i])
-                    {
-                        idcs[c] = j;
-                        ++c;
-                    }
-                }
-                idcs.conservativeResize(c);
-
-                //get selected G
-                MatrixXd t_G(this->sol->data.rows(), idcs.rows()*3);
-                MatrixXd t_G_Whitened_Roi(t_G_Whitened.rows(), idcs.rows()*3);
-
-                for(qint32 j = 0; j < idcs.rows(); ++j)
-                {
-                    t_G.block(0, j*3, t_G.rows(), 3) = this->sol->data.block(0, (idcs[j]+offset)*3, t_G.rows(), 3);
-                    if(t_bUseWhitened)
-                        t_G_Whitened_Roi.block(0, j*3, t_G_Whitened_Roi.rows(), 3) = t_G_Whitened.block(0, (idcs[j]+offset)*3, t_G_Whitened_Roi.rows(), 3);
-                }
+                const QVector<qint32> t_vecIdcs = t_hashLabelIdcs.value(label_ids[i]);
+                VectorXi idcs = Map<const VectorXi>(t_vecIdcs.constData(), t_vecIdcs.size());
 
-                qint32 nSens = t_G.rows();
-                qint32 nSources = t_G.cols()/3;
+                qint32 nSources = idcs.rows();
 
                 if (nSources > 0)
                 {
@@ -321,29 +552,17 @@ MNEForwardSolution MNEForwardSolution::cluster_forward_solution(const Annotation
                     t_sensG.iLabelIdxIn = i;
                     t_sensG.nClusters = ceil((double)nSources/(double)p_iClusterSize);
 
-                    t_sensG.matRoiGOrig = t_G;
-//                    if(t_bUseWhitened)
-//                        t_sensG.matRoiGOrigWhitened = t_G_Whitened_Roi;
+                    //get selected G
+                    t_sensG.matRoiGOrig.resize(nSens, nSources*3);
+                    for(qint32 j = 0; j < nSources; ++j)
+                        t_sensG.matRoiGOrig.middleCols(j*3, 3) = this->sol->data.middleCols((idcs[j]+offset)*3, 3);
 
                     printf("%d Cluster(s)... ", t_sensG.nClusters);
 
-                    // Reshape Input data -> sources rows; sensors columns
-                    t_sensG.matRoiG = MatrixXd(t_G.cols()/3, 3*nSens);
-                    if(t_bUseWhitened)
-                        t_sensG.matRoiGWhitened = MatrixXd(t_G_Whitened_Roi.cols()/3, 3*nSens);
-
-                    for(qint32 j = 0; j < nSens; ++j)
-                    {
-                        for(qint32 k = 0; k < t_sensG.matRoiG.rows(); ++k)
-                            t_sensG.matRoiG.block(k,j*3,1,3) = t_G.block(j,k*3,1,3);
-                        if(t_bUseWhitened)
-                            for(qint32 k = 0; k < t_sensG.matRoiGWhitened.rows(); ++k)
-                                t_sensG.matRoiGWhitened.block(k,j*3,1,3) = t_G_Whitened_Roi.block(j,k*3,1,3);
-                    }
-
+                    // The reshaped input data (sources rows; sensors columns) is gathered by the clustering task itself
                     t_sensG.bUseWhitened = t_bUseWhitened;
 
-                    t_sensG.sDistMeasure = p_sMethod;
+                    t_sensG.sDistMeasure = p_sMethod.isEmpty() ? QString("cityblock") : p_sMethod;
 
                     m_qListRegionDataIn.append(t_sensG);
 
@@ -360,10 +579,44 @@ MNEForwardSolution MNEForwardSolution::cluster_forward_solution(const Annotation
         //
         // Calculate clusters
         //
-        printf("Clustering... ");
-        QFuture< RegionDataOut > res;
-        res = QtConcurrent::mapped(m_qListRegionDataIn, &RegionData::cluster);
-        res.waitForFinished();
+        QList<RegionDataOut> t_qListRegionDataOut;
+
+        bool t_bCached = h < t_qListCachedRegionDataOut.size() && t_qListCachedRegionDataOut[h].size() == m_qListRegionDataIn.size();
+        for(qint32 i = 0; t_bCached && i < m_qListRegionDataIn.size(); ++i)
+            t_bCached = t_qListCachedRegionDataOut[h][i].iLabelIdxOut == m_qListRegionDataIn[i].iLabelIdxIn
+                        && t_qListCachedRegionDataOut[h][i].roiIdx.size() == m_qListRegionDataIn[i].idcs.size();
+
+        if(t_bCached)
+        {
+            printf("Clustering... [cached] ");
+            t_qListRegionDataOut = t_qListCachedRegionDataOut[h];
+        }
+        else
+        {
+            printf("Clustering... ");
+            QList<QFuture<RegionDataOut> > t_qListFutures;
+
+            for(qint32 i = 0; i < m_qListRegionDataIn.size(); ++i)
+            {
+                RegionData& t_regionData = m_qListRegionDataIn[i];
+                const MatrixXd& t_G = this->sol->data;
+
+                t_qListFutures.append(QtConcurrent::run(clusterThreadPool(), [&t_regionData, &t_G, &t_G_Whitened, offset]() {
+                    t_regionData.matRoiG = reshapeRegionGain(t_G, t_regionData.idcs, offset);
+                    if(t_regionData.bUseWhitened)
+                        t_regionData.matRoiGWhitened = reshapeRegionGain(t_G_Whitened, t_regionData.idcs, offset);
+
+                    return t_regionData.cluster(clusterWorkspace(t_regionData.sDistMeasure));
+                }));
+            }
+
+            for(qint32 i = 0; i < t_qListFutures.size(); ++i)
+                t_qListRegionDataOut.append(t_qListFutures[i].result());
+
+            t_bUpdateCache = true;
+        }
+
+        t_qListRegionDataOutAll.append(t_qListRegionDataOut);
 
         //
         // Assign results
@@ -371,15 +624,13 @@ MNEForwardSolution MNEForwardSolution::cluster_forward_solution(const Annotation
         MatrixXd t_G_partial;
 
         qint32 nClusters;
-        qint32 nSens;
         QList<RegionData>::const_iterator itIn;
-        itIn = m_qListRegionDataIn.begin();
-        QFuture<RegionDataOut>::const_iterator itOut;
-        for (itOut = res.constBegin(); itOut != res.constEnd(); ++itOut)
+        itIn = m_qListRegionDataIn.constBegin();
+        QList<RegionDataOut>::const_iterator itOut;
+        for (itOut = t_qListRegionDataOut.constBegin(); itOut != t_qListRegionDataOut.constEnd(); ++itOut)
         {
             nClusters = itOut->ctrs.rows();
-            nSens = itOut->ctrs.cols()/3;
-            t_G_partial = MatrixXd::Zero(nSens, nClusters*3);
+            t_G_partial = MatrixXd(nSens, nClusters*3);
 
 //            std::cout << "Number of Clusters: " << nClusters << " x " << nSens << std::endl;//itOut->iLabelIdcsOut << std::endl;
 
@@ -387,9 +638,9 @@ MNEForwardSolution MNEForwardSolution::cluster_forward_solution(const Annotation
             // Assign the centroid for each cluster to the partial G
             //
             //ToDo change this use indeces found with whitened data
-            for(qint32 j = 0; j < nSens; ++j)
-                for(qint32 k = 0; k < nClusters; ++k)
-                    t_G_partial.block(j, k*3, 1, 3) = itOut->ctrs.block(k,j*3,1,3);
+            const MatrixXd t_ctrsT = itOut->ctrs.transpose();
+            for(qint32 k = 0; k < nClusters; ++k)
+                t_G_partial.middleCols(k*3, 3) = Map<const MatrixXd>(t_ctrsT.col(k).data(), 3, nSens).transpose();
 
             //
             // Get cluster indizes and its distances to the centroid
@@ -494,6 +745,14 @@ MNEForwardSolution MNEForwardSolution::cluster_forward_solution(const Annotation
         printf("[done]\n");
     }
 
+    if(t_bUpdateCache && !t_sCacheFileName.isEmpty())
+    {
+        if(writeClusterCache(t_sCacheFileName, t_baCacheKey, t_qListRegionDataOutAll))
+            printf("\tClustering cached to %s.\n", t_sCacheFileName.toUtf8().constData());
+        else
+            qWarning("MNEForwardSolution::cluster_forward_solution - Could not write cluster cache %s.", t_sCacheFileName.toUtf8().constData());
+    }
+
 
     //
     // Cluster operator D (sources x clusters)
@@ -144,42 +144,47 @@ struct RegionData
 
     RegionDataOut cluster() const
     {
-        QString t_sDistMeasure;
-        if(sDistMeasure.isEmpty())
-            t_sDistMeasure = QString("cityblock");
-        else
-            t_sDistMeasure = sDistMeasure;
+        KMeans t_kMeans(sDistMeasure.isEmpty() ? QString("cityblock") : sDistMeasure, QString("sample"), 5);
+
+        return cluster(t_kMeans);
+    }
 
+    //=========================================================================================================
+    /**
+    * Clusters the region using the provided k-means object as workspace, so that its buffers can be reused
+    * for subsequent regions processed by the same thread.
+    *
+    * @param[in] p_kMeans   K-means workspace configured with the distance measure of this region.
+    *
+    * @return the clustered region.
+    */
+    RegionDataOut cluster(KMeans& p_kMeans) const
+    {
         // Kmeans Reduction
         RegionDataOut p_RegionDataOut;
 
-        KMeans t_kMeans(t_sDistMeasure, QString("sample"), 5);
-
         if(bUseWhitened)
         {
-            t_kMeans.calculate(this->matRoiGWhitened, this->nClusters, p_RegionDataOut.roiIdx, p_RegionDataOut.ctrs, p_RegionDataOut.sumd, p_RegionDataOut.D);
+            p_kMeans.calculate(this->matRoiGWhitened, this->nClusters, p_RegionDataOut.roiIdx, p_RegionDataOut.ctrs, p_RegionDataOut.sumd, p_RegionDataOut.D);
 
             MatrixXd newCtrs = MatrixXd::Zero(p_RegionDataOut.ctrs.rows(), p_RegionDataOut.ctrs.cols());
-            for(qint32 c = 0; c < p_RegionDataOut.ctrs.rows(); ++c)
+            VectorXi num = VectorXi::Zero(p_RegionDataOut.ctrs.rows());
+
+            //just take whitened to get indeces calculate centroids using the original matrix
+            for(qint32 idx = 0; idx < p_RegionDataOut.roiIdx.size(); ++idx)
             {
-                qint32 num = 0;
-
-                for(qint32 idx = 0; idx < p_RegionDataOut.roiIdx.size(); ++idx)
-                {
-                    if(c == p_RegionDataOut.roiIdx[idx])
-                    {
-                        newCtrs.row(c) += this->matRoiG.row(idx); //just take whitened to get indeces calculate centroids using the original matrix
-                        ++num;
-                    }
-                }
-
-                if(num > 0)
-                    newCtrs.row(c) /= num;
+                newCtrs.row(p_RegionDataOut.roiIdx[idx]) += this->matRoiG.row(idx);
+                ++num[p_RegionDataOut.roiIdx[idx]];
             }
+
+            for(qint32 c = 0; c < newCtrs.rows(); ++c)
+                if(num[c] > 0)
+                    newCtrs.row(c) /= num[c];
+
             p_RegionDataOut.ctrs = newCtrs; //Replace whitened with original
         }
         else
-            t_kMeans.calculate(this->matRoiG, this->nClusters, p_RegionDataOut.roiIdx, p_RegionDataOut.ctrs, p_RegionDataOut.sumd, p_RegionDataOut.D);
+            p_kMeans.calculate(this->matRoiG, this->nClusters, p_RegionDataOut.roiIdx, p_RegionDataOut.ctrs, p_RegionDataOut.sumd, p_RegionDataOut.D);
 
         p_RegionDataOut.iLabelIdxOut = this->iLabelIdxIn;
 
@@ -257,10 +262,13 @@ public:
     * @param[in]    p_pNoise_cov
     * @param[in]    p_pInfo
     * @param[in]    p_sMethod           "cityblock" or "sqeuclidean"
+    * @param[in]    p_sFwdFileName      Path of the -fwd.fif this solution was read from. If set, the clustering result is
+    *                                   cached next to it, keyed by a hash of the gain matrix, source spaces, annotation
+    *                                   and clustering parameters, and reused on subsequent calls.
     *
     * @return clustered MNE forward solution
     */
-    MNEForwardSolution cluster_forward_solution(const AnnotationSet &p_AnnotationSet, qint32 p_iClusterSize, MatrixXd& p_D = defaultD, const FiffCov &p_pNoise_cov = defaultCov, const FiffInfo &p_pInfo = defaultInfo, QString p_sMethod = "cityblock") const;
+    MNEForwardSolution cluster_forward_solution(const AnnotationSet &p_AnnotationSet, qint32 p_iClusterSize, MatrixXd& p_D = defaultD, const FiffCov &p_pNoise_cov = defaultCov, const FiffInfo &p_pInfo = defaultInfo, QString p_sMethod = "cityblock", const QString& p_sFwdFileName = QString()) const;
 
     //=========================================================================================================
     /**
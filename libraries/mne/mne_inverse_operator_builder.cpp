@@ -0,0 +1,632 @@
+//=============================================================================================================
+/**
+* @file     mne_inverse_operator_builder.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     MNEInverseOperatorBuilder class definition.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "mne_inverse_operator_builder.h"
+
+#include <fiff/fiff_proj.h>
+#include <fiff/fiff_named_matrix.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QtConcurrent>
+#include <QVector>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/SVD>
+#include <Eigen/SparseCore>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace MNELIB;
+using namespace FIFFLIB;
+using namespace Eigen;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE GLOBAL METHODS
+//=============================================================================================================
+
+namespace
+{
+
+const int NOISE_NORM_BLOCK_SIZE = 1024;    /**< Number of eigen lead rows per noise norm task. */
+
+//*************************************************************************************************************
+
+bool isSameCov(const FiffCov& p_cov1, const FiffCov& p_cov2)
+{
+    return p_cov1.diag == p_cov2.diag
+            && p_cov1.names == p_cov2.names
+            && p_cov1.bads == p_cov2.bads
+            && p_cov1.projs.size() == p_cov2.projs.size()
+            && p_cov1.data.rows() == p_cov2.data.rows()
+            && p_cov1.data.cols() == p_cov2.data.cols()
+            && p_cov1.data == p_cov2.data;
+}
+
+} // namespace
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+MNEInverseOperatorBuilder::MNEInverseOperatorBuilder()
+: m_fLoose(0.2f)
+, m_fDepth(0.8f)
+, m_bFixed(false)
+, m_bConvertToFixed(false)
+, m_bLimitDepthChs(true)
+, m_bForwardValid(false)
+, m_iMethods(FIFFV_MNE_MEG)
+, m_bHasNoiseCov(false)
+, m_bWhitenerValid(false)
+, m_bNoiseNormValid(false)
+, m_fNoiseNormLambda2(0.0f)
+{
+}
+
+
+//*************************************************************************************************************
+
+MNEInverseOperatorBuilder::MNEInverseOperatorBuilder(const FiffInfo &info, const MNEForwardSolution& forward, float loose, float depth, bool fixed, bool limit_depth_chs)
+: MNEInverseOperatorBuilder()
+{
+    setForwardSolution(info, forward, loose, depth, fixed, limit_depth_chs);
+}
+
+
+//*************************************************************************************************************
+
+MNEInverseOperatorBuilder::MNEInverseOperatorBuilder(const MNEInverseOperator& p_inverseOperator)
+: MNEInverseOperatorBuilder()
+{
+    setInverseOperator(p_inverseOperator);
+}
+
+
+//*************************************************************************************************************
+
+bool MNEInverseOperatorBuilder::setForwardSolution(const FiffInfo &info, const MNEForwardSolution& forward, float loose, float depth, bool fixed, bool limit_depth_chs)
+{
+    m_info = info;
+    m_forward = forward;
+    m_forwardFixed = MNEForwardSolution();
+    m_bLimitDepthChs = limit_depth_chs;
+    m_bForwardValid = false;
+    m_bConvertToFixed = false;
+
+    m_priorChNames.clear();
+    m_pDepthPrior = FiffCov::SDPtr();
+    m_pOrientPrior = FiffCov::SDPtr();
+    m_pSourceCov = FiffCov::SDPtr();
+
+    setInverseOperator(MNEInverseOperator());
+
+    bool is_fixed_ori = m_forward.isFixedOrient();
+
+    std::cout << "ToDo MNEInverseOperator::make_inverse_operator: do surf_ori check" << std::endl;
+
+    //Check parameters
+    if(fixed && loose > 0)
+    {
+        qWarning("Warning: When invoking make_inverse_operator with fixed = true, the loose parameter is ignored.\n");
+        loose = 0.0f;
+    }
+
+    if(is_fixed_ori && !fixed)
+    {
+        qWarning("Warning: Setting fixed parameter = true. Because the given forward operator has fixed orientation and can only be used to make a fixed-orientation inverse operator.\n");
+        fixed = true;
+    }
+
+    if(m_forward.source_ori == -1 && loose > 0)
+    {
+        qCritical("Error: Forward solution is not oriented in surface coordinates. loose parameter should be 0 not %f.\n", loose);
+        return false;
+    }
+
+    if(loose < 0 || loose > 1)
+    {
+        qWarning("Warning: Loose value should be in interval [0,1] not %f.\n", loose);
+        loose = loose > 1 ? 1 : 0;
+        printf("Setting loose to %f.\n", loose);
+    }
+
+    if(depth < 0 || depth > 1)
+    {
+        qWarning("Warning: Depth value should be in interval [0,1] not %f.\n", depth);
+        depth = depth > 1 ? 1 : 0;
+        printf("Setting depth to %f.\n", depth);
+    }
+
+    m_fLoose = loose;
+    m_fDepth = depth;
+    m_bFixed = fixed;
+
+    // Convert to the fixed orientation forward solution once, the priors are still computed from the free one
+    if(m_bFixed && !is_fixed_ori)
+    {
+        m_forwardFixed = m_forward;
+        m_forwardFixed.to_fixed_ori();
+        m_bConvertToFixed = true;
+    }
+
+    m_bForwardValid = true;
+
+    return true;
+}
+
+
+//*************************************************************************************************************
+
+void MNEInverseOperatorBuilder::setInverseOperator(const MNEInverseOperator& p_inverseOperator)
+{
+    m_inverseOperator = p_inverseOperator;
+    m_lastNoiseCov = FiffCov();
+    m_bHasNoiseCov = false;
+    m_bWhitenerValid = false;
+    m_bNoiseNormValid = false;
+}
+
+
+//*************************************************************************************************************
+
+MNEInverseOperator MNEInverseOperatorBuilder::makeInverseOperator(const FiffCov& p_noise_cov)
+{
+    if(!m_bForwardValid)
+    {
+        qWarning("Warning in MNEInverseOperatorBuilder::makeInverseOperator: No valid forward solution set.\n");
+        return MNEInverseOperator();
+    }
+
+    //The whitened gain and its SVD depend on the noise covariance only
+    if(m_bHasNoiseCov && isSameCov(m_lastNoiseCov, p_noise_cov))
+        return m_inverseOperator;
+
+    //
+    // 1. Read the bad channels
+    // 2. Read the necessary data from the forward solution matrix file
+    // 3. Load the projection data
+    // 4. Load the sensor noise covariance matrix and attach it to the forward
+    //
+    QStringList t_chNames = selectChannels(p_noise_cov);
+
+    //
+    // 5. - 6. Depth weighting and source covariance, cached per channel selection
+    //
+    if(!m_pSourceCov || t_chNames != m_priorChNames)
+        computeSourcePriors(p_noise_cov);
+
+    const MNEForwardSolution& t_forward = m_bConvertToFixed ? m_forwardFixed : m_forward;
+
+    FiffInfo gain_info;
+    MatrixXd gain;
+    MatrixXd whitener;
+    qint32 n_nzero;
+    FiffCov p_outNoiseCov;
+    t_forward.prepare_forward(m_info, p_noise_cov, false, gain_info, gain, p_outNoiseCov, whitener, n_nzero);
+
+    printf("\tComputing inverse operator with %d channels.\n", gain_info.ch_names.size());
+
+    // 7. Apply fMRI weighting (not done)
+
+    //
+    // 8. Apply the linear projection to the forward solution
+    // 9. Apply whitening to the forward computation matrix
+    // 11. Do appropriate source weighting to the forward computation matrix
+    //
+    printf("\tWhitening the forward solution.\n");
+    VectorXd source_std = m_pSourceCov.constData()->data.col(0).array().sqrt();
+    gain = (whitener * gain) * source_std.asDiagonal();
+
+    // Adjusting Source Covariance matrix to make trace of G*R*G' equal
+    // to number of sensors.
+    printf("\tAdjusting source covariance matrix.\n");
+    double trace_GRGT = gain.squaredNorm();
+    double scaling_source_cov = (double)n_nzero / trace_GRGT;
+
+    FiffCov::SDPtr p_source_cov = m_pSourceCov;
+    p_source_cov->data.array() *= scaling_source_cov;
+
+    gain.array() *= sqrt(scaling_source_cov);
+
+    //
+    // 12. Decompose the combined matrix
+    //
+    printf("Computing SVD of whitened and weighted lead field matrix.\n");
+    BDCSVD<MatrixXd> svd(gain, ComputeThinU | ComputeThinV);
+
+    //Singular values are returned in decreasing order
+    VectorXd p_sing = svd.singularValues();
+
+    FiffNamedMatrix::SDPtr p_eigen_fields = FiffNamedMatrix::SDPtr(new FiffNamedMatrix( svd.matrixU().cols(),
+                                                                                        svd.matrixU().rows(),
+                                                                                        defaultQStringList,
+                                                                                        gain_info.ch_names,
+                                                                                        svd.matrixU().transpose() ));
+
+    FiffNamedMatrix::SDPtr p_eigen_leads = FiffNamedMatrix::SDPtr(new FiffNamedMatrix( svd.matrixV().rows(),
+                                                                                       svd.matrixV().cols(),
+                                                                                       defaultQStringList,
+                                                                                       defaultQStringList,
+                                                                                       svd.matrixV() ));
+    printf("\tlargest singular value = %f\n", p_sing.size() > 0 ? p_sing.maxCoeff() : 0.0);
+    printf("\tscaling factor to adjust the trace = %f\n", trace_GRGT);
+
+    MNEInverseOperator p_MNEInverseOperator;
+
+    p_MNEInverseOperator.eigen_fields = p_eigen_fields;
+    p_MNEInverseOperator.eigen_leads = p_eigen_leads;
+    p_MNEInverseOperator.sing = p_sing;
+    p_MNEInverseOperator.nave = 1;
+    // We set this for consistency with mne C code written inverses
+    p_MNEInverseOperator.depth_prior = m_fDepth == 0 ? FiffCov::SDPtr() : m_pDepthPrior;
+    p_MNEInverseOperator.source_cov = p_source_cov;
+    p_MNEInverseOperator.noise_cov = FiffCov::SDPtr(new FiffCov(p_outNoiseCov));
+    p_MNEInverseOperator.orient_prior = m_pOrientPrior;
+    p_MNEInverseOperator.projs = m_info.projs;
+    p_MNEInverseOperator.eigen_leads_weighted = false;
+    p_MNEInverseOperator.source_ori = t_forward.source_ori;
+    p_MNEInverseOperator.mri_head_t = t_forward.mri_head_t;
+    p_MNEInverseOperator.methods = m_iMethods;
+    p_MNEInverseOperator.nsource = t_forward.nsource;
+    p_MNEInverseOperator.coord_frame = t_forward.coord_frame;
+    p_MNEInverseOperator.source_nn = t_forward.source_nn;
+    p_MNEInverseOperator.src = t_forward.src;
+    p_MNEInverseOperator.info = t_forward.info;
+    p_MNEInverseOperator.info.bads = m_info.bads;
+
+    setInverseOperator(p_MNEInverseOperator);
+    m_lastNoiseCov = p_noise_cov;
+    m_bHasNoiseCov = true;
+
+    return p_MNEInverseOperator;
+}
+
+
+//*************************************************************************************************************
+
+MNEInverseOperator MNEInverseOperatorBuilder::prepareInverseOperator(qint32 nave, float lambda2, bool dSPM, bool sLORETA)
+{
+    if(nave <= 0)
+    {
+        printf("The number of averages should be positive\n");
+        return MNEInverseOperator();
+    }
+    printf("Preparing the inverse operator for use...\n");
+
+    //Shares the eigen leads and fields, only the scaled members are detached
+    const MNEInverseOperator& t_inv = m_inverseOperator;
+    MNEInverseOperator inv(t_inv);
+    //
+    //   Scale some of the stuff
+    //
+    float scale = ((float)t_inv.nave)/((float)nave);
+    if(scale != 1.0f)
+    {
+        inv.noise_cov->data  *= scale;
+        inv.noise_cov->eig   *= scale;
+        inv.source_cov->data *= scale;
+        //
+        if (inv.eigen_leads_weighted)
+            inv.eigen_leads->data *= sqrt(scale);
+    }
+    //
+    printf("\tScaled noise and source covariance from nave = %d to nave = %d\n", t_inv.nave, nave);
+    inv.nave = nave;
+    //
+    //   Create the diagonal matrix for computing the regularized inverse
+    //
+    inv.reginv = t_inv.sing.array() / (t_inv.sing.array().square() + lambda2);
+    printf("\tCreated the regularized inverter\n");
+    //
+    //   Create the projection operator and the whitener, both depend on the noise covariance only
+    //
+    if(!m_bWhitenerValid)
+        computeWhitener();
+
+    inv.proj = m_matProj;
+    inv.whitener = scale != 1.0f ? MatrixXd(m_matWhitener / sqrt(scale)) : m_matWhitener;
+    //
+    //   Finally, compute the noise-normalization factors
+    //
+    if (dSPM || sLORETA)
+    {
+        if(!m_bNoiseNormValid || m_fNoiseNormLambda2 != lambda2)
+            computeNoiseNorms(lambda2);
+
+        printf("\tComputing noise-normalization factors (%s)...", dSPM ? "dSPM" : "sLORETA");
+
+        //The noise norms grow with sqrt(scale) through the scaled source covariance or eigen leads
+        const VectorXd& t_vecNoiseNormSq = dSPM ? m_vecNoiseNormSqDSPM : m_vecNoiseNormSqSLORETA;
+
+        typedef Eigen::Triplet<double> T;
+        std::vector<T> tripletList;
+        tripletList.reserve(t_vecNoiseNormSq.size());
+        for(qint32 i = 0; i < t_vecNoiseNormSq.size(); ++i)
+            tripletList.push_back(T(i, i, 1.0 / sqrt(scale * t_vecNoiseNormSq[i])));
+
+        inv.noisenorm = SparseMatrix<double>(t_vecNoiseNormSq.size(),t_vecNoiseNormSq.size());
+        inv.noisenorm.setFromTriplets(tripletList.begin(), tripletList.end());
+
+        printf("[done]\n");
+    }
+    else
+    {
+        inv.noisenorm = SparseMatrix<double>();
+    }
+
+    return inv;
+}
+
+
+//*************************************************************************************************************
+
+QStringList MNEInverseOperatorBuilder::selectChannels(const FiffCov& p_noise_cov) const
+{
+    QStringList fwd_ch_names;
+    for(qint32 i = 0; i < m_forward.info.chs.size(); ++i)
+        fwd_ch_names << m_forward.info.chs[i].ch_name;
+
+    QStringList ch_names;
+    for(qint32 i = 0; i < m_info.chs.size(); ++i)
+        if(     !m_info.bads.contains(m_info.chs[i].ch_name)
+            &&  !p_noise_cov.bads.contains(m_info.chs[i].ch_name)
+            &&  fwd_ch_names.contains(m_info.chs[i].ch_name))
+            ch_names << m_info.chs[i].ch_name;
+
+    return ch_names;
+}
+
+
+//*************************************************************************************************************
+
+void MNEInverseOperatorBuilder::computeSourcePriors(const FiffCov& p_noise_cov)
+{
+    bool is_fixed_ori = m_forward.isFixedOrient();
+
+    FiffInfo gain_info;
+    MatrixXd gain;
+    MatrixXd whitener;
+    qint32 n_nzero;
+    FiffCov t_noiseCov;
+    m_forward.prepare_forward(m_info, p_noise_cov, false, gain_info, gain, t_noiseCov, whitener, n_nzero);
+
+    m_priorChNames = gain_info.ch_names;
+
+    //
+    // 5. Compose the depth weight matrix
+    //
+    if(m_fDepth > 0)
+    {
+        std::cout << "ToDo: patch_areas" << std::endl;
+        MatrixXd patch_areas;
+        m_pDepthPrior = FiffCov::SDPtr(new FiffCov(MNEForwardSolution::compute_depth_prior(gain, gain_info, is_fixed_ori, m_fDepth, 10.0, patch_areas, m_bLimitDepthChs)));
+    }
+    else
+    {
+        m_pDepthPrior = FiffCov::SDPtr(new FiffCov());
+        m_pDepthPrior->data = MatrixXd::Ones(gain.cols(), 1);
+        m_pDepthPrior->kind = FIFFV_MNE_DEPTH_PRIOR_COV;
+        m_pDepthPrior->diag = true;
+        m_pDepthPrior->dim = gain.cols();
+        m_pDepthPrior->nfree = 1;
+    }
+
+    // Convert the depth prior into a fixed-orientation one
+    if(m_bConvertToFixed)
+    {
+        qint32 count = 0;
+        for(qint32 i = 2; i < m_pDepthPrior->data.rows(); i+=3)
+        {
+            m_pDepthPrior->data.row(count) = m_pDepthPrior->data.row(i);
+            ++count;
+        }
+        m_pDepthPrior->data.conservativeResize(count, 1);
+        m_pDepthPrior->dim = count;
+        is_fixed_ori = true;
+    }
+
+    //
+    // 6. Compose the source covariance matrix
+    //
+    printf("\tCreating the source covariance matrix\n");
+    m_pSourceCov = m_pDepthPrior;
+
+    // apply loose orientations
+    m_pOrientPrior = FiffCov::SDPtr();
+    if(!is_fixed_ori)
+    {
+        m_pOrientPrior = FiffCov::SDPtr(new FiffCov(m_forward.compute_orient_prior(m_fLoose)));
+        m_pSourceCov->data.array() *= m_pOrientPrior->data.array();
+    }
+
+    // Handle methods
+    bool has_meg = false;
+    bool has_eeg = false;
+
+    for(qint32 i = 0; i < m_info.chs.size(); ++i)
+    {
+        if(!gain_info.ch_names.contains(m_info.chs[i].ch_name))
+            continue;
+
+        QString ch_type = m_info.channel_type(i);
+        if (ch_type == "eeg")
+            has_eeg = true;
+        if ((ch_type == "mag") || (ch_type == "grad"))
+            has_meg = true;
+    }
+
+    if(has_eeg && has_meg)
+        m_iMethods = FIFFV_MNE_MEG_EEG;
+    else if(has_meg)
+        m_iMethods = FIFFV_MNE_MEG;
+    else
+        m_iMethods = FIFFV_MNE_EEG;
+}
+
+
+//*************************************************************************************************************
+
+void MNEInverseOperatorBuilder::computeWhitener()
+{
+    const MNEInverseOperator& t_inv = m_inverseOperator;
+    const FiffCov& t_noiseCov = *t_inv.noise_cov;
+
+    qint32 ncomp = FiffProj::make_projector(t_inv.projs, t_noiseCov.names, m_matProj);
+    if (ncomp > 0)
+        printf("\tCreated an SSP operator (subspace dimension = %d)\n",ncomp);
+
+    m_matWhitener = MatrixXd::Zero(t_noiseCov.dim, t_noiseCov.dim);
+
+    qint32 nnzero, k;
+    if (t_noiseCov.diag == 0)
+    {
+        //
+        //   Omit the zeroes due to projection
+        //
+        nnzero = 0;
+
+        for (k = ncomp; k < t_noiseCov.dim; ++k)
+        {
+            if (t_noiseCov.eig[k] > 0)
+            {
+                m_matWhitener(k,k) = 1.0/sqrt(t_noiseCov.eig[k]);
+                ++nnzero;
+            }
+        }
+        //
+        //   Rows of eigvec are the eigenvectors
+        //
+        m_matWhitener *= t_noiseCov.eigvec;
+        printf("\tCreated the whitener using a full noise covariance matrix (%d small eigenvalues omitted)\n", t_noiseCov.dim - nnzero);
+    }
+    else
+    {
+        //
+        //   No need to omit the zeroes due to projection
+        //
+        for (k = 0; k < t_noiseCov.dim; ++k)
+            m_matWhitener(k,k) = 1.0/sqrt(t_noiseCov.data(k,0));
+
+        printf("\tCreated the whitener using a diagonal noise covariance matrix (%d small eigenvalues discarded)\n",ncomp);
+    }
+
+    m_bWhitenerValid = true;
+}
+
+
+//*************************************************************************************************************
+
+void MNEInverseOperatorBuilder::computeNoiseNorms(float lambda2)
+{
+    const MNEInverseOperator& t_inv = m_inverseOperator;
+    const MatrixXd& t_matLeads = t_inv.eigen_leads->data;
+    const qint32 nrow = t_matLeads.rows();
+
+    //
+    //   Squared noise weights of both methods as columns: dSPM uses the regularized inverter, sLORETA
+    //   additionally weights it with sqrt(1 + sing^2/lambda2)
+    //
+    ArrayXd t_arrSingSq = t_inv.sing.array().square();
+    ArrayXd t_arrRegInvSq = (t_inv.sing.array() / (t_arrSingSq + lambda2)).square();
+
+    MatrixXd t_matWeightsSq(t_inv.sing.size(), 2);
+    t_matWeightsSq.col(0) = t_arrRegInvSq.matrix();
+    t_matWeightsSq.col(1) = (t_arrRegInvSq * (1.0 + t_arrSingSq / lambda2)).matrix();
+
+    //Unweighted eigen leads are scaled by the source standard deviation
+    VectorXd t_vecSourceVar = t_inv.eigen_leads_weighted ? VectorXd::Ones(nrow) : VectorXd(t_inv.source_cov->data.col(0));
+
+    MatrixXd t_matNormSq(nrow, 2);
+
+    QVector<qint32> t_vecBlocks;
+    for(qint32 i = 0; i < nrow; i += NOISE_NORM_BLOCK_SIZE)
+        t_vecBlocks.append(i);
+
+    QtConcurrent::blockingMap(t_vecBlocks, [&](qint32 iStart) {
+        qint32 n = std::min(NOISE_NORM_BLOCK_SIZE, nrow - iStart);
+        t_matNormSq.middleRows(iStart, n).noalias() = t_matLeads.middleRows(iStart, n).array().square().matrix() * t_matWeightsSq;
+        t_matNormSq.middleRows(iStart, n).array().colwise() *= t_vecSourceVar.segment(iStart, n).array();
+    });
+
+    if (t_inv.source_ori == FIFFV_MNE_FREE_ORI)
+    {
+        //
+        //   The three-component case is a little bit more involved
+        //   The variances at three consequtive entries must be added together
+        //
+        //   Even in this case return only one noise-normalization factor
+        //   per source location
+        //
+        qint32 nsource = nrow/3;
+        m_vecNoiseNormSqDSPM.resize(nsource);
+        m_vecNoiseNormSqSLORETA.resize(nsource);
+        for(qint32 i = 0; i < nsource; ++i)
+        {
+            m_vecNoiseNormSqDSPM[i] = t_matNormSq.block(3*i, 0, 3, 1).sum();
+            m_vecNoiseNormSqSLORETA[i] = t_matNormSq.block(3*i, 1, 3, 1).sum();
+        }
+    }
+    else
+    {
+        m_vecNoiseNormSqDSPM = t_matNormSq.col(0);
+        m_vecNoiseNormSqSLORETA = t_matNormSq.col(1);
+    }
+
+    m_fNoiseNormLambda2 = lambda2;
+    m_bNoiseNormValid = true;
+}
@@ -0,0 +1,268 @@
+//=============================================================================================================
+/**
+* @file     mne_inverse_operator_builder.h
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     MNEInverseOperatorBuilder class declaration.
+*
+*/
+
+#ifndef MNE_INVERSE_OPERATOR_BUILDER_H
+#define MNE_INVERSE_OPERATOR_BUILDER_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "mne_global.h"
+#include "mne_forwardsolution.h"
+#include "mne_inverse_operator.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// FIFF INCLUDES
+//=============================================================================================================
+
+#include <fiff/fiff_cov.h>
+#include <fiff/fiff_info.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QSharedPointer>
+#include <QStringList>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE MNELIB
+//=============================================================================================================
+
+namespace MNELIB
+{
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FIFFLIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* Builds and prepares inverse operators while keeping everything which does not change between calls.
+*
+* For a fixed forward solution the depth and orientation priors depend only on the selected channels, so they are
+* computed once per channel selection and a new noise covariance only costs the whitening and the SVD of the
+* whitened gain matrix. Preparing an operator for another nave or lambda2 reuses the SVD, the SSP projector and the
+* unscaled whitener. The dSPM and sLORETA noise normalizations are evaluated together, row blocks in parallel, as
+* a function of the singular values and cached per lambda2; nave only rescales them.
+*
+* @brief Cached inverse operator construction and preparation
+*/
+class MNESHARED_EXPORT MNEInverseOperatorBuilder
+{
+public:
+    typedef QSharedPointer<MNEInverseOperatorBuilder> SPtr;            /**< Shared pointer type for MNEInverseOperatorBuilder. */
+    typedef QSharedPointer<const MNEInverseOperatorBuilder> ConstSPtr; /**< Const shared pointer type for MNEInverseOperatorBuilder. */
+
+    //=========================================================================================================
+    /**
+    * Default constructor
+    */
+    MNEInverseOperatorBuilder();
+
+    //=========================================================================================================
+    /**
+    * Constructs a builder which makes inverse operators for the given forward solution.
+    *
+    * @param[in] info               The measurement info to specify the channels to include. Bad channels in info['bads'] are not used.
+    * @param[in] forward            Forward operator.
+    * @param[in] loose              float in [0, 1]. Value that weights the source variances of the dipole components defining the tangent space of the cortical surfaces.
+    * @param[in] depth              float in [0, 1]. Depth weighting coefficients. If None, no depth weighting is performed.
+    * @param[in] fixed              Use fixed source orientations normal to the cortical mantle. If True, the loose parameter is ignored.
+    * @param[in] limit_depth_chs    If True, use only grad channels in depth weighting (equivalent to MNE C code). If grad chanels aren't present, only mag channels will be used (if no mag, then eeg). If False, use all channels.
+    */
+    MNEInverseOperatorBuilder(const FiffInfo &info, const MNEForwardSolution& forward, float loose = 0.2f, float depth = 0.8f, bool fixed = false, bool limit_depth_chs = true);
+
+    //=========================================================================================================
+    /**
+    * Constructs a builder which prepares the given inverse operator.
+    *
+    * @param[in] p_inverseOperator  The inverse operator to prepare.
+    */
+    explicit MNEInverseOperatorBuilder(const MNEInverseOperator& p_inverseOperator);
+
+    //=========================================================================================================
+    /**
+    * Sets the forward solution the inverse operators are made for. Clears all caches.
+    *
+    * @param[in] info               The measurement info to specify the channels to include.
+    * @param[in] forward            Forward operator.
+    * @param[in] loose              float in [0, 1]. Value that weights the source variances of the tangential dipole components.
+    * @param[in] depth              float in [0, 1]. Depth weighting coefficients.
+    * @param[in] fixed              Use fixed source orientations normal to the cortical mantle.
+    * @param[in] limit_depth_chs    If True, use only grad channels in depth weighting.
+    *
+    * @return true if the parameters are valid, false otherwise.
+    */
+    bool setForwardSolution(const FiffInfo &info, const MNEForwardSolution& forward, float loose = 0.2f, float depth = 0.8f, bool fixed = false, bool limit_depth_chs = true);
+
+    //=========================================================================================================
+    /**
+    * Sets the inverse operator which is prepared by prepareInverseOperator. Clears the preparation caches.
+    *
+    * @param[in] p_inverseOperator  The inverse operator to prepare.
+    */
+    void setInverseOperator(const MNEInverseOperator& p_inverseOperator);
+
+    //=========================================================================================================
+    /**
+    * Returns the current inverse operator, i.e. the last one which was made or set.
+    *
+    * @return The current inverse operator.
+    */
+    inline const MNEInverseOperator& getInverseOperator() const;
+
+    //=========================================================================================================
+    /**
+    * Makes an inverse operator for the noise covariance, see MNEInverseOperator::make_inverse_operator. The result
+    * becomes the current inverse operator. Calling it again with the same covariance returns the cached operator.
+    *
+    * @param[in] p_noise_cov    The noise covariance matrix.
+    *
+    * @return the assembled inverse operator, an empty one on error.
+    */
+    MNEInverseOperator makeInverseOperator(const FiffCov& p_noise_cov);
+
+    //=========================================================================================================
+    /**
+    * Prepares the current inverse operator for actual inverse computations, see
+    * MNEInverseOperator::prepare_inverse_operator.
+    *
+    * @param[in] nave      Number of averages (scales the noise covariance)
+    * @param[in] lambda2   The regularization factor
+    * @param[in] dSPM      Compute the noise-normalization factors for dSPM?
+    * @param[in] sLORETA   Compute the noise-normalization factors for sLORETA?
+    *
+    * @return the prepared inverse operator
+    */
+    MNEInverseOperator prepareInverseOperator(qint32 nave, float lambda2, bool dSPM, bool sLORETA = false);
+
+private:
+    //=========================================================================================================
+    /**
+    * Returns the channels prepare_forward selects for the noise covariance.
+    *
+    * @param[in] p_noise_cov    The noise covariance matrix.
+    *
+    * @return The selected channel names.
+    */
+    QStringList selectChannels(const FiffCov& p_noise_cov) const;
+
+    //=========================================================================================================
+    /**
+    * Computes the depth weighted and orientation weighted source covariance for the selected channels.
+    *
+    * @param[in] p_noise_cov    The noise covariance matrix.
+    */
+    void computeSourcePriors(const FiffCov& p_noise_cov);
+
+    //=========================================================================================================
+    /**
+    * Computes the SSP projector and the whitener of the current inverse operator at its own nave.
+    */
+    void computeWhitener();
+
+    //=========================================================================================================
+    /**
+    * Computes the squared dSPM and sLORETA noise norms per source of the current inverse operator at its own nave.
+    *
+    * @param[in] lambda2   The regularization factor.
+    */
+    void computeNoiseNorms(float lambda2);
+
+    FiffInfo            m_info;                 /**< Measurement info to pick the channels from. */
+    MNEForwardSolution  m_forward;              /**< Forward solution, as given. */
+    MNEForwardSolution  m_forwardFixed;         /**< Forward solution converted to fixed orientation, if needed. */
+    float               m_fLoose;               /**< Loose orientation weight. */
+    float               m_fDepth;               /**< Depth weighting exponent. */
+    bool                m_bFixed;               /**< Whether a fixed orientation inverse is made. */
+    bool                m_bConvertToFixed;      /**< Whether the free orientation forward has to be converted for a fixed inverse. */
+    bool                m_bLimitDepthChs;       /**< Whether the depth prior uses a single channel type. */
+    bool                m_bForwardValid;        /**< Whether a forward solution with valid parameters is set. */
+
+    QStringList         m_priorChNames;         /**< Channel selection of the cached priors. */
+    FiffCov::SDPtr      m_pDepthPrior;          /**< Cached depth prior. */
+    FiffCov::SDPtr      m_pOrientPrior;         /**< Cached orientation prior. */
+    FiffCov::SDPtr      m_pSourceCov;           /**< Cached source covariance before the trace scaling. */
+    qint32              m_iMethods;             /**< Cached MEG/EEG method of the selection. */
+
+    FiffCov             m_lastNoiseCov;         /**< Noise covariance of the current inverse operator, if it was made. */
+    bool                m_bHasNoiseCov;         /**< Whether the current inverse operator was made by this builder. */
+    MNEInverseOperator  m_inverseOperator;      /**< Current inverse operator. */
+
+    bool                m_bWhitenerValid;       /**< Whether whitener and projector are computed. */
+    MatrixXd            m_matProj;              /**< SSP projector. */
+    MatrixXd            m_matWhitener;          /**< Whitener at the nave of the current inverse operator. */
+
+    bool                m_bNoiseNormValid;      /**< Whether the noise norms are computed. */
+    float               m_fNoiseNormLambda2;    /**< Regularization of the cached noise norms. */
+    VectorXd            m_vecNoiseNormSqDSPM;   /**< Squared dSPM noise norm per source. */
+    VectorXd            m_vecNoiseNormSqSLORETA;/**< Squared sLORETA noise norm per source. */
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline const MNEInverseOperator& MNEInverseOperatorBuilder::getInverseOperator() const
+{
+    return m_inverseOperator;
+}
+
+} // NAMESPACE
+
+#endif // MNE_INVERSE_OPERATOR_BUILDER_H
@@ -99,8 +99,11 @@ SOURCES += \
     rtProcessing/rtinvop.cpp \
     rtProcessing/rtave.cpp \
     rtProcessing/rtnoise.cpp \
+    rtProcessing/rtpsd.cpp \
     rtProcessing/rthpis.cpp \
-    rtProcessing/rtfilter.cpp
+    rtProcessing/rtfilter.cpp \
+    rtProcessing/rtpreprocessing.cpp \
+    rtProcessing/rtbcifeatures.cpp
 
 HEADERS +=  \
     realtime_global.h \
@@ -115,8 +118,11 @@ HEADERS +=  \
     rtProcessing/rtinvop.h \
     rtProcessing/rtave.h \
     rtProcessing/rtnoise.h \
+    rtProcessing/rtpsd.h \
     rtProcessing/rthpis.h \
-    rtProcessing/rtfilter.h
+    rtProcessing/rtfilter.h \
+    rtProcessing/rtpreprocessing.h \
+    rtProcessing/rtbcifeatures.h
 
 INCLUDEPATH += $${EIGEN_INCLUDE_DIR}
 INCLUDEPATH += $${MNE_INCLUDE_DIR}
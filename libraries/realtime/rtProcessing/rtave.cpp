@@ -43,7 +43,7 @@
 #include "rtave.h"
 
 #include <utils/ioutils.h>
-#include <utils/detecttrigger.h>
+#include <utils/eventdetector.h>
 #include <utils/mnemath.h>
 
 #include <iostream>
@@ -108,6 +108,7 @@ RtAve::RtAve(quint32 numAverages,
 , m_bIsRunning(false)
 , m_bAutoAspect(true)
 , m_fTriggerThreshold(0.5)
+, m_eventDetector(QList<int>(), 0.5, EventDetector::Level, EventDetector::Rising)
 , m_iTriggerChIndex(-1)
 , m_iNewTriggerIndex(p_iTriggerIndex)
 , m_iAverageMode(0)
@@ -334,7 +335,14 @@ void RtAve::doAveraging(const MatrixXd& rawSegment)
     //QElapsedTimer time;
     //time.start();
 
-    QList<QPair<int,double> > lDetectedTriggers = DetectTrigger::detectTriggerFlanksMax(rawSegment, m_iTriggerChIndex, 0, m_fTriggerThreshold, true);
+    //Edges are searched against the last sample of the previous block, so a trigger on the block boundary is found once
+    qint64 iBlockStart = m_eventDetector.nextSample();
+    QVector<DetectedEvent> vecEvents = m_eventDetector.detect(rawSegment);
+
+    QList<QPair<int,double> > lDetectedTriggers;
+    for(int i = 0; i < vecEvents.size(); ++i) {
+        lDetectedTriggers.append(QPair<int,double>(static_cast<int>(vecEvents.at(i).iSample - iBlockStart), vecEvents.at(i).dAfter));
+    }
 
     //qDebug()<<"RtAve::doAveraging() - time for detection"<<time.elapsed();
     //time.start();
@@ -740,6 +748,9 @@ void RtAve::reset()
     m_iPostStimSamples = m_iNewPostStimSamples;
     m_iTriggerChIndex = m_iNewTriggerIndex;
     m_iAverageMode = m_iNewAverageMode;
+
+    m_eventDetector.setChannels(QList<int>() << m_iTriggerChIndex);
+    m_eventDetector.setThreshold(m_fTriggerThreshold);
     m_iNumAverages = m_iNewNumAverages;
 
     qDebug()<<"RtAve::reset() - 2";
@@ -811,5 +822,9 @@ void RtAve::init()
     m_iNewPreStimSamples = m_iPreStimSamples;
     m_iNewPostStimSamples = m_iPostStimSamples;
     m_iNewNumAverages = m_iNumAverages;
+
+    //Ignore the remaining samples of a trigger pulse for 100 ms, independent of the sampling frequency
+    if(m_pFiffInfo)
+        m_eventDetector.setDeadTimeSec(0.1, m_pFiffInfo->sfreq);
 }
 
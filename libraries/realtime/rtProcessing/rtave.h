@@ -48,6 +48,7 @@
 #include <fiff/fiff_info.h>
 
 #include <utils/generics/circularmatrixbuffer.h>
+#include <utils/eventdetector.h>
 
 
 //*************************************************************************************************************
@@ -332,6 +333,8 @@ private:
 
     float                                           m_fTriggerThreshold;        /**< Threshold to detect trigger */
 
+    UTILSLIB::EventDetector                         m_eventDetector;            /**< Trigger detector which keeps the trigger channel state across the data blocks. */
+
     bool                                            m_bActivateThreshold;       /**< Whether to do threshold artifact reduction or not. */
     bool                                            m_bActivateVariance;        /**< Whether to do variance artifact reduction or not. */
     bool                                            m_bIsRunning;               /**< Holds if real-time Covariance estimation is running.*/
@@ -0,0 +1,280 @@
+//=============================================================================================================
+/**
+* @file     rtbcifeatures.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     RtBciFeatures class definition.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "rtbcifeatures.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Dense>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace REALTIMELIB;
+using namespace Eigen;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+RtBciFeatures::RtBciFeatures(int iNumChannels,
+                             int iWindowCapacity,
+                             double dSFreq)
+: m_matRingBuffer(MatrixXd::Zero(iNumChannels, iWindowCapacity))
+, m_iWritePosition(0)
+, m_iNumSamples(0)
+, m_dSFreq(dSFreq)
+, m_iNumHarmonics(1)
+{
+}
+
+
+//*************************************************************************************************************
+
+void RtBciFeatures::append(const MatrixXd& matData)
+{
+    int iCapacity = m_matRingBuffer.cols();
+    int iReadPos = 0;
+
+    //Only the newest iCapacity samples can end up in the ring buffer
+    if(matData.cols() > iCapacity) {
+        iReadPos = matData.cols() - iCapacity;
+        m_iWritePosition = (m_iWritePosition + iReadPos) % iCapacity;
+    }
+
+    //Copy up to the end of the ring buffer, then wrap around
+    while(iReadPos < matData.cols()) {
+        int iChunk = std::min(static_cast<int>(matData.cols()) - iReadPos, iCapacity - m_iWritePosition);
+        m_matRingBuffer.middleCols(m_iWritePosition, iChunk) = matData.middleCols(iReadPos, iChunk);
+
+        iReadPos += iChunk;
+        m_iWritePosition = (m_iWritePosition + iChunk) % iCapacity;
+    }
+
+    m_iNumSamples += matData.cols();
+}
+
+
+//*************************************************************************************************************
+
+void RtBciFeatures::reset()
+{
+    m_matRingBuffer.setZero();
+    m_iWritePosition = 0;
+    m_iNumSamples = 0;
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd RtBciFeatures::getWindow(int iLength, int iLag) const
+{
+    int iCapacity = m_matRingBuffer.cols();
+    int iStart = ((m_iWritePosition - iLag - iLength) % iCapacity + iCapacity) % iCapacity;
+    int iFirst = qMin(iLength, iCapacity - iStart);
+
+    MatrixXd matY(iLength, m_matRingBuffer.rows());
+    matY.topRows(iFirst) = m_matRingBuffer.block(0, iStart, m_matRingBuffer.rows(), iFirst).transpose();
+    if(iFirst < iLength) {
+        matY.bottomRows(iLength - iFirst) = m_matRingBuffer.leftCols(iLength - iFirst).transpose();
+    }
+
+    return matY;
+}
+
+
+//*************************************************************************************************************
+
+void RtBciFeatures::setReferenceFrequencies(const QList<double>& lFrequencies, int iNumHarmonics)
+{
+    if(lFrequencies == m_lFrequencies && iNumHarmonics == m_iNumHarmonics) {
+        return;
+    }
+
+    m_lFrequencies = lFrequencies;
+    m_iNumHarmonics = iNumHarmonics;
+    m_mapReferenceBanks.clear();
+}
+
+
+//*************************************************************************************************************
+
+void RtBciFeatures::removeFrequency(MatrixXd& matY, double dFrequency)
+{
+    QPair<int,double> key(matY.rows(), dFrequency);
+
+    if(!m_mapInterferenceBases.contains(key)) {
+        MatrixXd matZ = createReferences(matY.rows(), dFrequency, 1);
+        HouseholderQR<MatrixXd> qr(matZ);
+        m_mapInterferenceBases.insert(key, qr.householderQ() * MatrixXd::Identity(matZ.rows(), matZ.cols()));
+    }
+
+    const MatrixXd& matQ = m_mapInterferenceBases[key];
+    matY -= matQ * (matQ.transpose() * matY);
+}
+
+
+//*************************************************************************************************************
+
+VectorXd RtBciFeatures::ccaFeatures(const MatrixXd& matY)
+{
+    const ReferenceBank& bank = referenceBank(matY.rows());
+    int iNumRef = 2*m_iNumHarmonics;
+    VectorXd vecFeatures(m_lFrequencies.size());
+
+    //The data basis is shared by all frequencies
+    MatrixXd matYCentered = matY.rowwise() - matY.colwise().mean();
+    ColPivHouseholderQR<MatrixXd> qr(matYCentered);
+    MatrixXd matQY = qr.householderQ() * MatrixXd::Identity(matY.rows(), matY.cols());
+
+    MatrixXd matCorr = bank.matQCentered.transpose() * matQY;
+
+    for(int i = 0; i < m_lFrequencies.size(); ++i) {
+        JacobiSVD<MatrixXd> svd(matCorr.middleRows(i*iNumRef, iNumRef));
+        vecFeatures(i) = svd.singularValues().maxCoeff();
+    }
+
+    return vecFeatures;
+}
+
+
+//*************************************************************************************************************
+
+VectorXd RtBciFeatures::mecFeatures(const MatrixXd& matY)
+{
+    const ReferenceBank& bank = referenceBank(matY.rows());
+    int iNumRef = 2*m_iNumHarmonics;
+    VectorXd vecFeatures(m_lFrequencies.size());
+
+    MatrixXd matYtY = matY.transpose() * matY;
+    MatrixXd matXtY = bank.matX.transpose() * matY;
+    MatrixXd matQtY = bank.matQ.transpose() * matY;
+
+    for(int i = 0; i < m_lFrequencies.size(); ++i) {
+        //Covariance of the data with the SSVEP components projected out
+        MatrixXd matQtYi = matQtY.middleRows(i*iNumRef, iNumRef);
+        SelfAdjointEigenSolver<MatrixXd> eigensolver(matYtY - matQtYi.transpose() * matQtYi);
+
+        //Determine number of channels Ns which hold 10% of the noise energy
+        const VectorXd& vecEigenvalues = eigensolver.eigenvalues();
+        double dTotal = vecEigenvalues.sum();
+        double dCumSum = 0;
+        int Ns;
+        for(Ns = 0; Ns < vecEigenvalues.size(); ++Ns) {
+            dCumSum += vecEigenvalues(Ns);
+            if(dCumSum/dTotal > 0.1) {
+                break;
+            }
+        }
+        Ns += 1;
+
+        //Spatial filter matrix W
+        MatrixXd W = eigensolver.eigenvectors().leftCols(Ns);
+        for(int k = 0; k < Ns; ++k) {
+            W.col(k) *= 1/sqrt(vecEigenvalues(k));
+        }
+
+        //Signal energy of all harmonics, X^T * S = (X^T * Y) * W
+        MatrixXd P = matXtY.middleRows(i*iNumRef, iNumRef) * W;
+        vecFeatures(i) = P.array().square().sum() / double(m_iNumHarmonics*Ns);
+    }
+
+    return vecFeatures;
+}
+
+
+//*************************************************************************************************************
+
+const RtBciFeatures::ReferenceBank& RtBciFeatures::referenceBank(int iLength)
+{
+    if(!m_mapReferenceBanks.contains(iLength)) {
+        int iNumRef = 2*m_iNumHarmonics;
+        ReferenceBank bank;
+        bank.matX.resize(iLength, iNumRef*m_lFrequencies.size());
+        bank.matQ.resize(iLength, iNumRef*m_lFrequencies.size());
+        bank.matQCentered.resize(iLength, iNumRef*m_lFrequencies.size());
+
+        for(int i = 0; i < m_lFrequencies.size(); ++i) {
+            MatrixXd matX = createReferences(iLength, m_lFrequencies.at(i), m_iNumHarmonics);
+            bank.matX.middleCols(i*iNumRef, iNumRef) = matX;
+
+            HouseholderQR<MatrixXd> qr(matX);
+            bank.matQ.middleCols(i*iNumRef, iNumRef) = qr.householderQ() * MatrixXd::Identity(iLength, iNumRef);
+
+            MatrixXd matXCentered = matX.rowwise() - matX.colwise().mean();
+            ColPivHouseholderQR<MatrixXd> qrCentered(matXCentered);
+            bank.matQCentered.middleCols(i*iNumRef, iNumRef) = qrCentered.householderQ() * MatrixXd::Identity(iLength, iNumRef);
+        }
+
+        m_mapReferenceBanks.insert(iLength, bank);
+    }
+
+    return m_mapReferenceBanks[iLength];
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd RtBciFeatures::createReferences(int iLength, double dFrequency, int iNumHarmonics) const
+{
+    //Relative timeline of the window
+    ArrayXd t = 2*M_PI/m_dSFreq * ArrayXd::LinSpaced(iLength, 1, iLength);
+
+    MatrixXd matX(iLength, 2*iNumHarmonics);
+    for(int k = 0; k < iNumHarmonics; ++k) {
+        ArrayXd t_k = t*(k+1)*dFrequency;
+        matX.col(2*k) = t_k.sin();
+        matX.col(2*k+1) = t_k.cos();
+    }
+
+    return matX;
+}
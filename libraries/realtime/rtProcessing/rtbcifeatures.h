@@ -0,0 +1,232 @@
+//=============================================================================================================
+/**
+* @file     rtbcifeatures.h
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     RtBciFeatures class declaration.
+*
+*/
+
+#ifndef RTBCIFEATURES_H
+#define RTBCIFEATURES_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "../realtime_global.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QSharedPointer>
+#include <QList>
+#include <QPair>
+#include <QMap>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE REALTIMELIB
+//=============================================================================================================
+
+namespace REALTIMELIB
+{
+
+
+//=============================================================================================================
+/**
+* Streaming feature extraction for BCI applications. Incoming samples are written into a per-channel ring buffer
+* from which windows of arbitrary length can be read without shifting data. The sine/cosine reference signals
+* of the frequency set, their orthonormal bases and the power line basis only depend on the window length. They
+* are therefore computed once per window length and reused for every decision. CCA and MEC features of all
+* frequencies are computed from one product of the stacked reference bases with the data window.
+*
+* @brief Streaming BCI feature extraction
+*/
+class REALTIMESHARED_EXPORT RtBciFeatures
+{
+
+public:
+    typedef QSharedPointer<RtBciFeatures> SPtr;             /**< Shared pointer type for RtBciFeatures. */
+    typedef QSharedPointer<const RtBciFeatures> ConstSPtr;  /**< Const shared pointer type for RtBciFeatures. */
+
+    //=========================================================================================================
+    /**
+    * Creates the feature extraction.
+    *
+    * @param[in] iNumChannels       Number of channels.
+    * @param[in] iWindowCapacity    Maximal window length in samples, i.e. the size of the ring buffer.
+    * @param[in] dSFreq             The sampling frequency.
+    */
+    explicit RtBciFeatures(int iNumChannels,
+                           int iWindowCapacity,
+                           double dSFreq);
+
+    //=========================================================================================================
+    /**
+    * Writes new samples to the ring buffer.
+    *
+    * @param[in] matData    The new samples (channels x samples).
+    */
+    void append(const Eigen::MatrixXd& matData);
+
+    //=========================================================================================================
+    /**
+    * Clears the ring buffer.
+    */
+    void reset();
+
+    //=========================================================================================================
+    /**
+    * Returns a window of the latest samples in the layout used by CCA and MEC (samples x channels).
+    *
+    * @param[in] iLength    Length of the window in samples. Must not exceed the window capacity.
+    * @param[in] iLag       Number of the newest samples which are excluded from the window.
+    *
+    * @return the data window.
+    */
+    Eigen::MatrixXd getWindow(int iLength, int iLag = 0) const;
+
+    //=========================================================================================================
+    /**
+    * Sets the frequencies and the number of harmonics of the reference signals. Cached reference banks are
+    * dropped.
+    *
+    * @param[in] lFrequencies       The frequencies of interest.
+    * @param[in] iNumHarmonics      Number of harmonics (including the fundamental) per frequency.
+    */
+    void setReferenceFrequencies(const QList<double>& lFrequencies, int iNumHarmonics);
+
+    //=========================================================================================================
+    /**
+    * Removes a sinusoidal interference, e.g. the power line, from a data window by projecting out its
+    * sine/cosine basis.
+    *
+    * @param[in, out] matY      The data window (samples x channels).
+    * @param[in] dFrequency     The frequency to remove.
+    */
+    void removeFrequency(Eigen::MatrixXd& matY, double dFrequency);
+
+    //=========================================================================================================
+    /**
+    * Calculates the largest canonical correlation between the data window and the references of every frequency.
+    *
+    * @param[in] matY       The data window (samples x channels).
+    *
+    * @return the canonical correlation per frequency.
+    */
+    Eigen::VectorXd ccaFeatures(const Eigen::MatrixXd& matY);
+
+    //=========================================================================================================
+    /**
+    * Calculates the minimum energy combination signal power of the data window for every frequency.
+    *
+    * @param[in] matY       The data window (samples x channels).
+    *
+    * @return the normalized signal power per frequency.
+    */
+    Eigen::VectorXd mecFeatures(const Eigen::MatrixXd& matY);
+
+    //=========================================================================================================
+    /**
+    * Returns the number of samples written since the last reset.
+    *
+    * @return the number of samples.
+    */
+    inline qint64 getNumSamples() const;
+
+private:
+    /**
+    * Reference signals of all frequencies for one window length.
+    */
+    struct ReferenceBank {
+        Eigen::MatrixXd matX;           /**< The sine/cosine references of all frequencies, stacked column wise. */
+        Eigen::MatrixXd matQ;           /**< Orthonormal basis of the references of each frequency, stacked column wise. */
+        Eigen::MatrixXd matQCentered;   /**< Orthonormal basis of the mean free references of each frequency, stacked column wise. */
+    };
+
+    //=========================================================================================================
+    /**
+    * Returns the reference bank for a window length, computes it if it is not cached yet.
+    *
+    * @param[in] iLength    The window length.
+    *
+    * @return the reference bank.
+    */
+    const ReferenceBank& referenceBank(int iLength);
+
+    //=========================================================================================================
+    /**
+    * Creates the sine/cosine references of a frequency for a window length.
+    *
+    * @param[in] iLength        The window length.
+    * @param[in] dFrequency     The frequency.
+    * @param[in] iNumHarmonics  Number of harmonics.
+    *
+    * @return the references (iLength x 2*iNumHarmonics).
+    */
+    Eigen::MatrixXd createReferences(int iLength, double dFrequency, int iNumHarmonics) const;
+
+    Eigen::MatrixXd             m_matRingBuffer;        /**< The ring buffer (channels x capacity). */
+    int                         m_iWritePosition;       /**< The column the next sample is written to. */
+    qint64                      m_iNumSamples;          /**< Number of samples written since the last reset. */
+    double                      m_dSFreq;               /**< The sampling frequency. */
+
+    QList<double>               m_lFrequencies;         /**< The reference frequencies. */
+    int                         m_iNumHarmonics;        /**< Number of harmonics per reference frequency. */
+    QMap<int, ReferenceBank>    m_mapReferenceBanks;    /**< Reference banks per window length. */
+    QMap<QPair<int,double>, Eigen::MatrixXd> m_mapInterferenceBases;  /**< Orthonormal interference bases per window length and frequency. */
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline qint64 RtBciFeatures::getNumSamples() const
+{
+    return m_iNumSamples;
+}
+
+} // NAMESPACE
+
+#endif // RTBCIFEATURES_H
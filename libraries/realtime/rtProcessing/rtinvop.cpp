@@ -116,14 +116,20 @@ void RtInvOp::run()
     {
         if(m_vecNoiseCov.size() > 0)
         {
-            // Restrict forward solution as necessary for MEG
-            MNEForwardSolution t_forwardMeg = m_pFwd->pick_types(true, false);
+            // Restrict forward solution as necessary for MEG, once for all covariance updates
+            if(!m_pInvOpBuilder)
+            {
+                MNEForwardSolution t_forwardMeg = m_pFwd->pick_types(true, false);
+                m_pInvOpBuilder = MNEInverseOperatorBuilder::SPtr(new MNEInverseOperatorBuilder(*m_pFiffInfo.data(), t_forwardMeg, 0.2f, 0.8f));
+            }
 
             mutex.lock();
-            MNEInverseOperator::SPtr t_invOpMeg(new MNEInverseOperator(*m_pFiffInfo.data(), t_forwardMeg, m_vecNoiseCov[0], 0.2f, 0.8f));
+            FiffCov t_noiseCov = m_vecNoiseCov[0];
             m_vecNoiseCov.pop_front();
             mutex.unlock();
 
+            MNEInverseOperator::SPtr t_invOpMeg(new MNEInverseOperator(m_pInvOpBuilder->makeInverseOperator(t_noiseCov)));
+
             emit invOperatorCalculated(t_invOpMeg);
         }
     }
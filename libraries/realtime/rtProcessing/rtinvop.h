@@ -58,6 +58,7 @@
 
 #include <mne/mne_forwardsolution.h>
 #include <mne/mne_inverse_operator.h>
+#include <mne/mne_inverse_operator_builder.h>
 
 
 //*************************************************************************************************************
@@ -176,6 +177,8 @@ private:
 
     FiffInfo::SPtr m_pFiffInfo;         /**< The fiff measurement information. */
     MNEForwardSolution::SPtr m_pFwd;    /**< The forward solution. */
+
+    MNEInverseOperatorBuilder::SPtr m_pInvOpBuilder;    /**< Keeps the forward dependent parts between covariance updates. */
 };
 
 //*************************************************************************************************************
@@ -78,7 +78,6 @@ RtNoise::RtNoise(qint32 p_iMaxSamples, FiffInfo::SPtr p_pFiffInfo, qint32 p_data
 , m_iNumOfBlocks(0)
 , m_iBlockSize(0)
 , m_iSensors(0)
-, m_iBlockIndex(0)
 {
     qRegisterMetaType<Eigen::MatrixXd>("Eigen::MatrixXd");
     //qRegisterMetaType<QVector<double>>("QVector<double>");
@@ -86,14 +85,6 @@ RtNoise::RtNoise(qint32 p_iMaxSamples, FiffInfo::SPtr p_pFiffInfo, qint32 p_data
     m_Fs = m_pFiffInfo->sfreq;
 
     m_bSendDataToBuffer = true;
-
-    m_fWin.clear();
-
-    //create a hanning window
-    m_fWin = hanning(m_iFFTlength,0);
-
-    qDebug()<<"Hanning window is created.";
-
 }
 
 
@@ -108,52 +99,6 @@ RtNoise::~RtNoise()
 
 //*************************************************************************************************************
 
-QVector <float> RtNoise::hanning(int N, short itype)
-{
-    int half, i, idx, n;
-    QVector <float> w(N,0.0);
-
-    if(itype==1)    //periodic function
-        n = N-1;
-    else
-        n = N;
-
-    if(n%2==0)
-    {
-        half = n/2;
-        for(i=0; i<half; i++) //CALC_HANNING   Calculates Hanning window samples.
-            w[i] = 0.5 * (1 - cos(2*3.14159265*(i+1) / (n+1)));
-
-        idx = half-1;
-        for(i=half; i<n; i++) {
-            w[i] = w[idx];
-            idx--;
-        }
-    }
-    else
-    {
-        half = (n+1)/2;
-        for(i=0; i<half; i++) //CALC_HANNING   Calculates Hanning window samples.
-            w[i] = 0.5 * (1 - cos(23.14159265*(i+1) / (n+1)));
-
-        idx = half-2;
-        for(i=half; i<n; i++) {
-            w[i] = w[idx];
-            idx--;
-        }
-    }
-
-    if(itype==1)    //periodic function
-    {
-        for(i=N-1; i>=1; i--)
-            w[i] = w[i-1];
-        w[0] = 0.0;
-    }
-    return(w);
-}
-
-//*************************************************************************************************************
-
 void RtNoise::append(const MatrixXd &p_DataSegment)
 {
     if(!m_pRawMatrixBuffer)
@@ -199,114 +144,37 @@ bool RtNoise::stop()
 
 void RtNoise::run()
 {
-    bool FirstStart = true;
-
     while(m_bIsRunning)
     {
         if(m_pRawMatrixBuffer)
         {
             MatrixXd block = m_pRawMatrixBuffer->pop();
 
-            if(FirstStart){
-                //init the circ buffer and parameters
+            if(!m_pRtPsd){
+                //init the estimator, m_dataLength defines how many blocks are averaged
                 if(m_dataLength < 0) m_dataLength = 10;
-                m_iNumOfBlocks = m_dataLength;//60;
+                m_iNumOfBlocks = m_dataLength;
                 m_iBlockSize =  block.cols();
                 m_iSensors =  block.rows();
 
-                m_matCircBuf.resize(m_iSensors,m_iNumOfBlocks*m_iBlockSize);
+                int iOverlap = m_iFFTlength/2;
+                int iHop = m_iFFTlength - iOverlap;
+                int iNumAverages = qMax(1, (m_iNumOfBlocks*m_iBlockSize - m_iFFTlength)/iHop + 1);
 
-                m_iBlockIndex = 0;
-                FirstStart = false;
-            }
-            //concate blocks
-            for (int i=0; i< m_iSensors; i++)
-                for (int j=0; j< m_iBlockSize; j++)
-                    m_matCircBuf(i,j+m_iBlockIndex*m_iBlockSize) = block(i,j);
-
-
-            m_iBlockIndex ++;
-            if (m_iBlockIndex >= m_iNumOfBlocks){
-
-                //m_pRawMatrixBuffer.clear(); //empty the buffer
-
-                m_bSendDataToBuffer = false;
-                //stop collect block and start to calculate the spectrum
-                m_iBlockIndex = 0;
-
-                MatrixXd sum_psdx = MatrixXd::Zero(m_iSensors,m_iFFTlength/2+1);
-
-                int nb = floor(m_iNumOfBlocks*m_iBlockSize/m_iFFTlength)+1;
-                qDebug()<<"nb"<<nb<<"NumOfBlocks"<<m_iNumOfBlocks<<"BlockSize"<<m_iBlockSize;
-                MatrixXd t_mat(m_iSensors,m_iFFTlength);
-                MatrixXd t_psdx(m_iSensors,m_iFFTlength/2+1);
-                for (int n = 0; n<nb; n++){
-                    //collect a data block with data length of m_iFFTlength;
-                    if(n==nb-1)
-                    {
-                        for(qint32 ii=0; ii<m_iSensors; ii++)
-                        for(qint32 jj=0; jj<m_iFFTlength; jj++)
-                            if(jj+n*m_iFFTlength<m_iNumOfBlocks*m_iBlockSize)
-                                t_mat(ii,jj) = m_matCircBuf(ii,jj+n*m_iFFTlength);
-                            else
-                                t_mat(ii,jj) = 0.0;
-
-                    }
-                    else
-                    {
-                        for(qint32 ii=0; ii<m_iSensors; ii++)
-                        for(qint32 jj=0; jj<m_iFFTlength; jj++)
-                            t_mat(ii,jj) = m_matCircBuf(ii,jj+n*m_iFFTlength);
-                    }
-
-                    //FFT calculation by row
-                    for(qint32 i = 0; i < t_mat.rows(); i++){
-                        RowVectorXd data;
-
-                        data = t_mat.row(i);
-
-                        //zero-pad data to m_iFFTlength
-                        RowVectorXd t_dataZeroPad = RowVectorXd::Zero(m_iFFTlength);
-                        t_dataZeroPad.head(data.cols()) = data;
-
-                        for (qint32 lk = 0; lk<m_iFFTlength; lk++)
-                            t_dataZeroPad[lk] = t_dataZeroPad[lk]*m_fWin[lk];
-
-                        //generate fft object
-                        Eigen::FFT<double> fft;
-                        fft.SetFlag(fft.HalfSpectrum);
-
-                        //fft-transform data sequence
-                        RowVectorXcd t_freqData(m_iFFTlength/2+1);
-                        fft.fwd(t_freqData,t_dataZeroPad);
-
-                        // calculate spectrum from FFT
-                        for(qint32 j=0; j<m_iFFTlength/2+1;j++)
-                        {
-                            double mag_abs = sqrt(t_freqData(j).real()* t_freqData(j).real() +  t_freqData(j).imag()*t_freqData(j).imag());
-                            double spower = (1.0/(m_Fs*m_iFFTlength))* mag_abs;
-                            if (j>0&&j<m_iFFTlength/2) spower = 2.0*spower;
-                            sum_psdx(i,j) = sum_psdx(i,j) + spower;
-                        }
-                     }//row computing is done
-                }//nb
-
-                //DB-calculation
-                for(qint32 ii=0; ii<m_iSensors; ii++)
-                    for(qint32 jj=0; jj<m_iFFTlength/2+1; jj++)
-                        t_psdx(ii,jj) = 10.0*log10(sum_psdx(ii,jj)/nb);
-
-                qDebug()<<"Send spectrum to Noise Estimator";
-                emit SpecCalculated(t_psdx); //send back the spectrum result
-                if(m_pRawMatrixBuffer->size()>0)
-                    m_pRawMatrixBuffer->clear();
-
-                m_bSendDataToBuffer = true;
+                m_pRtPsd = RtPsd::SPtr(new RtPsd(m_iSensors,
+                                                 m_iFFTlength,
+                                                 m_Fs,
+                                                 iOverlap,
+                                                 RtPsd::SlidingWindowAveraging,
+                                                 iNumAverages));
             }
 
+            //Every completed segment is transformed only once, the average is refreshed with constant cost
+            if(m_pRtPsd->append(block) > 0) {
+                emit SpecCalculated(m_pRtPsd->getPsdDb());
+            }
         }
-
     }
 
+    m_pRtPsd.reset();
 }
-
@@ -43,6 +43,7 @@
 //=============================================================================================================
 
 #include "../realtime_global.h"
+#include "rtpsd.h"
 
 
 //*************************************************************************************************************
@@ -79,7 +80,6 @@
 //=============================================================================================================
 
 #include <Eigen/Core>
-#include <unsupported/Eigen/FFT>
 
 //*************************************************************************************************************
 //=============================================================================================================
@@ -180,8 +180,6 @@ protected:
     */
     virtual void run();
 
-    QVector <float> hanning(int N, short itype);
-
 private:
     QMutex      mutex;                  /**< Provides access serialization between threads*/
 
@@ -191,7 +189,7 @@ private:
 
     CircularMatrixBuffer<double>::SPtr m_pRawMatrixBuffer;   /**< The Circular Raw Matrix Buffer. */
 
-    QVector <float> m_fWin;
+    RtPsd::SPtr m_pRtPsd;               /**< Streaming Welch estimator, initialized with the first incoming block. */
 
     double m_Fs;
 
@@ -202,9 +200,6 @@ protected:
     int m_iNumOfBlocks;
     int m_iBlockSize;
     int m_iSensors;
-    int m_iBlockIndex;
-
-    MatrixXd m_matCircBuf;
 
 public:
     MatrixXd m_matSpecData;
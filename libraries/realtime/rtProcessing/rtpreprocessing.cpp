@@ -0,0 +1,406 @@
+//=============================================================================================================
+/**
+* @file     rtpreprocessing.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     RtPreprocessing class definition.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "rtpreprocessing.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QMutexLocker>
+#include <QHash>
+#include <QDebug>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace REALTIMELIB;
+using namespace Eigen;
+using namespace UTILSLIB;
+using namespace FIFFLIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+RtPreprocessing::RtPreprocessing(const FiffInfo::SPtr& pFiffInfo)
+: m_pFiffInfo(pFiffInfo)
+, m_iNumChannels(pFiffInfo->chs.size())
+, m_bProjActive(false)
+, m_bCompActive(false)
+, m_bSpharaActive(false)
+, m_iMaxFilterLength(1)
+, m_bFilterActive(false)
+, m_bFused(true)
+, m_iOperatorVersion(0)
+, m_iBlockCount(0)
+, m_iAppliedSteps(NoStep)
+{
+    m_matProj = MatrixXd::Identity(m_iNumChannels, m_iNumChannels);
+    m_matComp = MatrixXd::Identity(m_iNumChannels, m_iNumChannels);
+    m_matSphara = MatrixXd::Identity(m_iNumChannels, m_iNumChannels);
+    m_vecIsFiltered.fill(false, m_iNumChannels);
+
+    updateBadChannels();
+}
+
+
+//*************************************************************************************************************
+
+void RtPreprocessing::setProjector(const MatrixXd& matProj, bool bActive)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(matProj.rows() != m_iNumChannels || matProj.cols() != m_iNumChannels) {
+        qWarning() << "RtPreprocessing::setProjector - Projector dimensions do not match the number of channels.";
+        return;
+    }
+
+    m_matProj = matProj;
+    m_bProjActive = bActive;
+    updateOperators();
+}
+
+
+//*************************************************************************************************************
+
+void RtPreprocessing::setCompensator(const MatrixXd& matComp, bool bActive)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(matComp.rows() != m_iNumChannels || matComp.cols() != m_iNumChannels) {
+        qWarning() << "RtPreprocessing::setCompensator - Compensator dimensions do not match the number of channels.";
+        return;
+    }
+
+    m_matComp = matComp;
+    m_bCompActive = bActive;
+    updateOperators();
+}
+
+
+//*************************************************************************************************************
+
+void RtPreprocessing::setSphara(const MatrixXd& matSphara, bool bActive)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(matSphara.rows() != m_iNumChannels || matSphara.cols() != m_iNumChannels) {
+        qWarning() << "RtPreprocessing::setSphara - SPHARA operator dimensions do not match the number of channels.";
+        return;
+    }
+
+    m_matSphara = matSphara;
+    m_bSpharaActive = bActive;
+    updateOperators();
+}
+
+
+//*************************************************************************************************************
+
+void RtPreprocessing::setSpharaActive(bool bActive)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(m_bSpharaActive != bActive) {
+        m_bSpharaActive = bActive;
+        updateOperators();
+    }
+}
+
+
+//*************************************************************************************************************
+
+void RtPreprocessing::setFilter(const QList<FilterData>& lFilterData, const QVector<int>& lFilterChannelList)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_lFilterData = lFilterData;
+    m_lFilterChannelList = lFilterChannelList;
+
+    m_iMaxFilterLength = 1;
+    for(int i = 0; i < m_lFilterData.size(); ++i) {
+        if(m_iMaxFilterLength < m_lFilterData.at(i).m_iFilterOrder) {
+            m_iMaxFilterLength = m_lFilterData.at(i).m_iFilterOrder;
+        }
+    }
+
+    m_vecIsFiltered.fill(false, m_iNumChannels);
+    for(int i = 0; i < m_lFilterChannelList.size(); ++i) {
+        int iChIdx = m_lFilterChannelList.at(i);
+        if(iChIdx >= 0 && iChIdx < m_iNumChannels) {
+            m_vecIsFiltered[iChIdx] = true;
+        }
+    }
+
+    updateOperators();
+}
+
+
+//*************************************************************************************************************
+
+void RtPreprocessing::setFilterActive(bool bActive)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(m_bFilterActive != bActive) {
+        m_bFilterActive = bActive;
+        updateOperators();
+    }
+}
+
+
+//*************************************************************************************************************
+
+void RtPreprocessing::updateBadChannels()
+{
+    QMutexLocker locker(&m_mutex);
+
+    resolveBadChannels();
+    updateOperators();
+}
+
+
+//*************************************************************************************************************
+
+void RtPreprocessing::resolveBadChannels()
+{
+    //Resolve the bad channel names once instead of searching them for every block
+    m_slBads = m_pFiffInfo->bads;
+    m_vecBadIdcs.clear();
+
+    QHash<QString, int> hashChIdx;
+    for(int i = 0; i < m_pFiffInfo->ch_names.size(); ++i) {
+        hashChIdx.insert(m_pFiffInfo->ch_names.at(i), i);
+    }
+
+    for(int i = 0; i < m_pFiffInfo->bads.size(); ++i) {
+        int iChIdx = hashChIdx.value(m_pFiffInfo->bads.at(i), -1);
+        if(iChIdx >= 0 && iChIdx < m_iNumChannels) {
+            m_vecBadIdcs.append(iChIdx);
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd RtPreprocessing::process(const MatrixXd& matData)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(matData.rows() != m_iNumChannels) {
+        qWarning() << "RtPreprocessing::process - Number of rows" << matData.rows() << "does not match the number of channels" << m_iNumChannels;
+        return matData;
+    }
+
+    //Bad channels can be changed at any time, e.g. from the display's channel selection
+    if(m_pFiffInfo->bads != m_slBads) {
+        resolveBadChannels();
+        updateOperators();
+    }
+
+    MatrixXd matDataOut = matData;
+
+    applySpatialOperator(m_opPreFilter, matDataOut);
+
+    bool bFilterActive = m_bFilterActive && !m_lFilterData.isEmpty();
+
+    if(bFilterActive) {
+        matDataOut = m_rtFilter.filterChannelsConcurrently(matDataOut, m_iMaxFilterLength, m_lFilterChannelList, m_lFilterData);
+    }
+
+    applySpatialOperator(m_opPostFilter, matDataOut);
+
+    m_iAppliedSteps = (m_bProjActive ? Projection : NoStep)
+                      | (m_bCompActive ? Compensation : NoStep)
+                      | (m_bSpharaActive ? Sphara : NoStep)
+                      | (bFilterActive ? Filter : NoStep);
+
+    ++m_iBlockCount;
+
+    return matDataOut;
+}
+
+
+//*************************************************************************************************************
+
+qint64 RtPreprocessing::getOperatorVersion() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_iOperatorVersion;
+}
+
+
+//*************************************************************************************************************
+
+int RtPreprocessing::getAppliedSteps() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_iAppliedSteps;
+}
+
+
+//*************************************************************************************************************
+
+qint64 RtPreprocessing::getBlockCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_iBlockCount;
+}
+
+
+//*************************************************************************************************************
+
+bool RtPreprocessing::isFused() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_bFused;
+}
+
+
+//*************************************************************************************************************
+
+void RtPreprocessing::updateOperators()
+{
+    //Projection x compensation. Bad channels are excluded from the projector input.
+    MatrixXd matPre = MatrixXd::Identity(m_iNumChannels, m_iNumChannels);
+
+    if(m_bCompActive) {
+        matPre = m_matComp;
+    }
+
+    if(m_bProjActive) {
+        MatrixXd matProj = m_matProj;
+        for(int i = 0; i < m_vecBadIdcs.size(); ++i) {
+            matProj.col(m_vecBadIdcs.at(i)).setZero();
+        }
+        matPre = matProj * matPre;
+    }
+
+    //SPHARA, bad channels are excluded from the input so they do not get smeared into their neighbours
+    MatrixXd matPost = MatrixXd::Identity(m_iNumChannels, m_iNumChannels);
+
+    if(m_bSpharaActive) {
+        matPost = m_matSphara;
+        for(int i = 0; i < m_vecBadIdcs.size(); ++i) {
+            matPost.col(m_vecBadIdcs.at(i)).setZero();
+        }
+    }
+
+    bool bFilterActive = m_bFilterActive && !m_lFilterData.isEmpty();
+
+    m_bFused = !m_bSpharaActive || !bFilterActive || commutesWithFilter(matPost);
+
+    if(m_bFused) {
+        setSpatialOperator(matPost * matPre, m_opPreFilter);
+        setSpatialOperator(MatrixXd::Identity(m_iNumChannels, m_iNumChannels), m_opPostFilter);
+    } else {
+        setSpatialOperator(matPre, m_opPreFilter);
+        setSpatialOperator(matPost, m_opPostFilter);
+    }
+
+    ++m_iOperatorVersion;
+}
+
+
+//*************************************************************************************************************
+
+void RtPreprocessing::setSpatialOperator(const MatrixXd& matOperator, SpatialOperator& op)
+{
+    op.bIdentity = matOperator.isIdentity(0.0);
+    op.matDense.resize(0,0);
+    op.matSparse.resize(0,0);
+
+    if(op.bIdentity) {
+        op.bDense = false;
+        return;
+    }
+
+    //A sparse product only pays off if the operator is clearly sparse
+    qint64 iNonZeros = (matOperator.array() != 0.0).count();
+    op.bDense = iNonZeros > matOperator.size() / 4;
+
+    if(op.bDense) {
+        op.matDense = matOperator;
+    } else {
+        op.matSparse = matOperator.sparseView();
+        op.matSparse.makeCompressed();
+    }
+}
+
+
+//*************************************************************************************************************
+
+void RtPreprocessing::applySpatialOperator(const SpatialOperator& op, MatrixXd& matData)
+{
+    if(op.bIdentity) {
+        return;
+    }
+
+    if(op.bDense) {
+        matData = op.matDense * matData;
+    } else {
+        matData = op.matSparse * matData;
+    }
+}
+
+
+//*************************************************************************************************************
+
+bool RtPreprocessing::commutesWithFilter(const MatrixXd& matOperator) const
+{
+    for(int c = 0; c < matOperator.cols(); ++c) {
+        for(int r = 0; r < matOperator.rows(); ++r) {
+            if(matOperator(r,c) != 0.0 && m_vecIsFiltered.at(r) != m_vecIsFiltered.at(c)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,303 @@
+//=============================================================================================================
+/**
+* @file     rtpreprocessing.h
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     RtPreprocessing class declaration.
+*
+*/
+
+#ifndef RTPREPROCESSING_H
+#define RTPREPROCESSING_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "../realtime_global.h"
+#include "rtfilter.h"
+
+#include <utils/filterTools/filterdata.h>
+#include <fiff/fiff_info.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QSharedPointer>
+#include <QMutex>
+#include <QVector>
+#include <QList>
+#include <QStringList>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+#include <Eigen/SparseCore>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE REALTIMELIB
+//=============================================================================================================
+
+namespace REALTIMELIB
+{
+
+
+//=============================================================================================================
+/**
+* Preprocessing chain of projection x compensation -> temporal filter -> SPHARA. All spatial operators are
+* composed once whenever one of them changes. If the SPHARA operator only mixes channels which share the same
+* temporal operator (i.e. the filter and the SPHARA operator commute), the complete spatial chain is fused into
+* a single matrix which is applied before filtering. Depending on its density the composed operator is stored
+* sparse or dense. Bad channels are resolved to indices once instead of per block.
+*
+* Every change of the operators increments the operator version, every processed block the block count. Both
+* are meant to be handed on with the processed block so that consumers, e.g. the display, know the data was
+* already preprocessed and do not apply the same chain a second time.
+*
+* @brief Fused spatial and temporal real-time preprocessing
+*/
+class REALTIMESHARED_EXPORT RtPreprocessing
+{
+
+public:
+    typedef QSharedPointer<RtPreprocessing> SPtr;             /**< Shared pointer type for RtPreprocessing. */
+    typedef QSharedPointer<const RtPreprocessing> ConstSPtr;  /**< Const shared pointer type for RtPreprocessing. */
+
+    /** Flags of the processing steps which were applied to a block. */
+    enum ProcessingStep {
+        NoStep          = 0x0,    /**< Raw data. */
+        Projection      = 0x1,    /**< The SSP projector was applied. */
+        Compensation    = 0x2,    /**< The compensator was applied. */
+        Sphara          = 0x4,    /**< The SPHARA operator was applied. */
+        Filter          = 0x8     /**< The temporal filters were applied. */
+    };
+
+    //=========================================================================================================
+    /**
+    * Creates the preprocessing pipeline. All operators are initialized as inactive.
+    *
+    * @param[in] pFiffInfo      The measurement info the incoming blocks are described by.
+    */
+    explicit RtPreprocessing(const FIFFLIB::FiffInfo::SPtr& pFiffInfo);
+
+    //=========================================================================================================
+    /**
+    * Sets the SSP projector. Columns of bad channels are zeroed.
+    *
+    * @param[in] matProj        The projector (nchan x nchan).
+    * @param[in] bActive        Whether the projector is applied.
+    */
+    void setProjector(const Eigen::MatrixXd& matProj, bool bActive);
+
+    //=========================================================================================================
+    /**
+    * Sets the CTF compensator.
+    *
+    * @param[in] matComp        The compensator (nchan x nchan).
+    * @param[in] bActive        Whether the compensator is applied.
+    */
+    void setCompensator(const Eigen::MatrixXd& matComp, bool bActive);
+
+    //=========================================================================================================
+    /**
+    * Sets the SPHARA operator. Bad channels are excluded from its input so they do not get smeared in.
+    *
+    * @param[in] matSphara      The SPHARA operator (nchan x nchan).
+    * @param[in] bActive        Whether SPHARA is applied.
+    */
+    void setSphara(const Eigen::MatrixXd& matSphara, bool bActive);
+
+    //=========================================================================================================
+    /**
+    * Switches SPHARA on or off without changing the operator.
+    *
+    * @param[in] bActive        Whether SPHARA is applied.
+    */
+    void setSpharaActive(bool bActive);
+
+    //=========================================================================================================
+    /**
+    * Sets the temporal filters and the channels they are applied to.
+    *
+    * @param[in] lFilterData            The filters.
+    * @param[in] lFilterChannelList     The indices of the channels which are to be filtered.
+    */
+    void setFilter(const QList<UTILSLIB::FilterData>& lFilterData, const QVector<int>& lFilterChannelList);
+
+    //=========================================================================================================
+    /**
+    * Switches the temporal filter on or off.
+    *
+    * @param[in] bActive        Whether the filters are applied.
+    */
+    void setFilterActive(bool bActive);
+
+    //=========================================================================================================
+    /**
+    * Updates the bad channels from the current measurement info and rebuilds the operators. This is also done
+    * automatically by process() whenever the bad channel list of the measurement info has changed.
+    */
+    void updateBadChannels();
+
+    //=========================================================================================================
+    /**
+    * Preprocesses a data block.
+    *
+    * @param[in] matData        The raw data block (nchan x samples).
+    *
+    * @return the preprocessed block.
+    */
+    Eigen::MatrixXd process(const Eigen::MatrixXd& matData);
+
+    //=========================================================================================================
+    /**
+    * Returns the version of the operators. It is incremented with every operator change.
+    *
+    * @return the operator version.
+    */
+    qint64 getOperatorVersion() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the processing steps which were applied to the last processed block.
+    *
+    * @return the applied steps as ProcessingStep flags.
+    */
+    int getAppliedSteps() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of blocks processed so far.
+    *
+    * @return the number of processed blocks.
+    */
+    qint64 getBlockCount() const;
+
+    //=========================================================================================================
+    /**
+    * Returns whether all spatial operators are currently fused into one matrix.
+    *
+    * @return true if the spatial chain is applied as a single matrix.
+    */
+    bool isFused() const;
+
+private:
+    //=========================================================================================================
+    /**
+    * A composed spatial operator, stored either sparse or dense depending on its density.
+    */
+    struct SpatialOperator {
+        bool                            bIdentity;  /**< Whether the operator is the identity and can be skipped. */
+        bool                            bDense;     /**< Whether the dense or the sparse representation is used. */
+        Eigen::MatrixXd                 matDense;   /**< Dense representation. */
+        Eigen::SparseMatrix<double>     matSparse;  /**< Sparse representation. */
+    };
+
+    //=========================================================================================================
+    /**
+    * Resolves the bad channel names of the measurement info to indices. Must be called with m_mutex locked.
+    */
+    void resolveBadChannels();
+
+    //=========================================================================================================
+    /**
+    * Composes the spatial operators. Must be called with m_mutex locked.
+    */
+    void updateOperators();
+
+    //=========================================================================================================
+    /**
+    * Stores a dense operator in the representation which is cheaper to apply.
+    *
+    * @param[in] matOperator    The operator.
+    * @param[out] op            The spatial operator.
+    */
+    static void setSpatialOperator(const Eigen::MatrixXd& matOperator, SpatialOperator& op);
+
+    //=========================================================================================================
+    /**
+    * Applies a spatial operator.
+    *
+    * @param[in] op             The spatial operator.
+    * @param[in, out] matData   The data.
+    */
+    static void applySpatialOperator(const SpatialOperator& op, Eigen::MatrixXd& matData);
+
+    //=========================================================================================================
+    /**
+    * Returns whether the operator only mixes channels which share the same temporal operator.
+    *
+    * @param[in] matOperator    The spatial operator.
+    *
+    * @return true if the spatial operator commutes with the current temporal filter.
+    */
+    bool commutesWithFilter(const Eigen::MatrixXd& matOperator) const;
+
+    mutable QMutex                  m_mutex;                /**< Serializes operator changes and processing. */
+
+    FIFFLIB::FiffInfo::SPtr         m_pFiffInfo;            /**< The measurement info. */
+    int                             m_iNumChannels;         /**< Number of channels. */
+    QStringList                     m_slBads;               /**< The bad channel names m_vecBadIdcs was resolved from. */
+    QVector<int>                    m_vecBadIdcs;           /**< Indices of the bad channels. */
+
+    Eigen::MatrixXd                 m_matProj;              /**< The SSP projector. */
+    Eigen::MatrixXd                 m_matComp;              /**< The compensator. */
+    Eigen::MatrixXd                 m_matSphara;            /**< The SPHARA operator. */
+    bool                            m_bProjActive;          /**< Whether the projector is applied. */
+    bool                            m_bCompActive;          /**< Whether the compensator is applied. */
+    bool                            m_bSpharaActive;        /**< Whether SPHARA is applied. */
+
+    QList<UTILSLIB::FilterData>     m_lFilterData;          /**< The temporal filters. */
+    QVector<int>                    m_lFilterChannelList;   /**< The indices of the filtered channels. */
+    QVector<bool>                   m_vecIsFiltered;        /**< Per channel flag whether it is filtered. */
+    int                             m_iMaxFilterLength;     /**< The maximal filter length. */
+    bool                            m_bFilterActive;        /**< Whether the filters are applied. */
+    RtFilter                        m_rtFilter;             /**< The overlap-add filter which keeps the state across blocks. */
+
+    SpatialOperator                 m_opPreFilter;          /**< Spatial operator applied before filtering. */
+    SpatialOperator                 m_opPostFilter;         /**< Spatial operator applied after filtering. */
+    bool                            m_bFused;               /**< Whether the whole spatial chain is in m_opPreFilter. */
+
+    qint64                          m_iOperatorVersion;     /**< Incremented with every operator change. */
+    qint64                          m_iBlockCount;          /**< Number of processed blocks. */
+    int                             m_iAppliedSteps;        /**< The ProcessingStep flags of the last processed block. */
+};
+
+} // NAMESPACE
+
+#endif // RTPREPROCESSING_H
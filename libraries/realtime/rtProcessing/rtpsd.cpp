@@ -0,0 +1,270 @@
+//=============================================================================================================
+/**
+* @file     rtpsd.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     RtPsd class definition.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "rtpsd.h"
+
+#include <utils/fftservice.h>
+
+#include <cmath>
+#include <limits>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QDebug>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace REALTIMELIB;
+using namespace Eigen;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+RtPsd::RtPsd(int iNumChannels,
+             int iSegmentLength,
+             double dSFreq,
+             int iOverlap,
+             AveragingMode mode,
+             int iNumAverages)
+: m_iNumChannels(iNumChannels)
+, m_iSegmentLength(iSegmentLength)
+, m_iNumBins(iSegmentLength/2+1)
+, m_dSFreq(dSFreq)
+{
+    if(iOverlap < 0 || iOverlap >= m_iSegmentLength) {
+        iOverlap = m_iSegmentLength/2;
+    }
+
+    m_iHop = m_iSegmentLength - iOverlap;
+
+    m_vecWindow = hanningWindow(m_iSegmentLength);
+    m_dScale = 1.0 / (m_dSFreq * m_vecWindow.squaredNorm());
+
+    m_matRing = MatrixXd::Zero(m_iNumChannels, m_iSegmentLength);
+    m_matSegment.resize(m_iNumChannels, m_iSegmentLength);
+    m_matPeriodogram.resize(m_iNumChannels, m_iNumBins);
+    m_matSpectrum.resize(m_iNumChannels, m_iNumBins);
+
+    setAveraging(mode, iNumAverages);
+}
+
+
+//*************************************************************************************************************
+
+int RtPsd::append(const MatrixXd& matData)
+{
+    if(matData.rows() != m_iNumChannels) {
+        qWarning() << "RtPsd::append - Number of rows" << matData.rows() << "does not match the number of channels" << m_iNumChannels;
+        return 0;
+    }
+
+    int iNumSegments = 0;
+    int iReadPos = 0;
+    const int iNumSamples = static_cast<int>(matData.cols());
+
+    while(iReadPos < iNumSamples) {
+        //Copy at most up to the next segment boundary or the end of the ring buffer
+        int iChunk = std::min(iNumSamples - iReadPos, m_iHop - m_iSamplesSinceSegment);
+        iChunk = std::min(iChunk, m_iSegmentLength - m_iWritePos);
+
+        m_matRing.middleCols(m_iWritePos, iChunk) = matData.middleCols(iReadPos, iChunk);
+
+        iReadPos += iChunk;
+        m_iWritePos = (m_iWritePos + iChunk) % m_iSegmentLength;
+        m_iSamplesSinceSegment += iChunk;
+        m_iSamplesBuffered = std::min(m_iSamplesBuffered + iChunk, m_iSegmentLength);
+
+        if(m_iSamplesSinceSegment == m_iHop) {
+            m_iSamplesSinceSegment = 0;
+
+            //Only process full segments
+            if(m_iSamplesBuffered == m_iSegmentLength) {
+                processSegment();
+                ++iNumSegments;
+            }
+        }
+    }
+
+    return iNumSegments;
+}
+
+
+//*************************************************************************************************************
+
+void RtPsd::reset()
+{
+    m_iWritePos = 0;
+    m_iSamplesSinceSegment = 0;
+    m_iSamplesBuffered = 0;
+    m_iNumAveraged = 0;
+    m_iHistoryPos = 0;
+
+    m_matRing.setZero();
+    m_matPsd = MatrixXd::Zero(m_iNumChannels, m_iNumBins);
+
+    for(int i = 0; i < m_qVecHistory.size(); ++i) {
+        m_qVecHistory[i].setZero();
+    }
+}
+
+
+//*************************************************************************************************************
+
+void RtPsd::setAveraging(AveragingMode mode, int iNumAverages)
+{
+    m_averagingMode = mode;
+    m_iNumAverages = std::max(1, iNumAverages);
+
+    m_qVecHistory.clear();
+
+    if(m_averagingMode == SlidingWindowAveraging) {
+        m_qVecHistory.fill(MatrixXd::Zero(m_iNumChannels, m_iNumBins), m_iNumAverages);
+    }
+
+    reset();
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd RtPsd::getPsd() const
+{
+    if(m_iNumAveraged == 0) {
+        return MatrixXd::Zero(m_iNumChannels, m_iNumBins);
+    }
+
+    if(m_averagingMode == SlidingWindowAveraging) {
+        return m_matPsd / static_cast<double>(std::min(m_iNumAveraged, m_iNumAverages));
+    }
+
+    return m_matPsd;
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd RtPsd::getPsdDb() const
+{
+    //Guard against log10(0) for flat or zero channels
+    return 10.0 * getPsd().array().max(std::numeric_limits<double>::min()).log10().matrix();
+}
+
+
+//*************************************************************************************************************
+
+RowVectorXd RtPsd::getFrequencies() const
+{
+    return RowVectorXd::LinSpaced(m_iNumBins, 0.0, (m_iNumBins - 1) * m_dSFreq / m_iSegmentLength);
+}
+
+
+//*************************************************************************************************************
+
+RowVectorXd RtPsd::hanningWindow(int iLength)
+{
+    RowVectorXd vecWindow(iLength);
+
+    if(iLength == 1) {
+        vecWindow(0) = 1.0;
+        return vecWindow;
+    }
+
+    for(int i = 0; i < iLength; ++i) {
+        vecWindow(i) = 0.5 * (1.0 - std::cos(2.0 * M_PI * (i + 1) / (iLength + 1)));
+    }
+
+    return vecWindow;
+}
+
+
+//*************************************************************************************************************
+
+void RtPsd::processSegment()
+{
+    //Unroll the ring buffer (oldest sample first) and apply the window to all channels at once
+    const int iTail = m_iSegmentLength - m_iWritePos;
+    m_matSegment.leftCols(iTail) = m_matRing.rightCols(iTail);
+    m_matSegment.rightCols(m_iWritePos) = m_matRing.leftCols(m_iWritePos);
+    m_matSegment.array().rowwise() *= m_vecWindow.array();
+
+    //Transform all channels in one batch with the cached plan of this thread
+    UTILSLIB::FFTService::fwdRows(m_matSpectrum, m_matSegment);
+    m_matPeriodogram = m_matSpectrum.cwiseAbs2();
+
+    //One-sided density: double all bins except DC and Nyquist
+    m_matPeriodogram *= m_dScale;
+    int iLastDoubled = (m_iSegmentLength % 2 == 0) ? m_iNumBins - 2 : m_iNumBins - 1;
+    if(iLastDoubled >= 1) {
+        m_matPeriodogram.middleCols(1, iLastDoubled) *= 2.0;
+    }
+
+    ++m_iNumAveraged;
+
+    if(m_averagingMode == SlidingWindowAveraging) {
+        //Keep a running sum and exchange the oldest periodogram
+        MatrixXd& matOldest = m_qVecHistory[m_iHistoryPos];
+        m_matPsd += m_matPeriodogram - matOldest;
+        matOldest = m_matPeriodogram;
+        m_iHistoryPos = (m_iHistoryPos + 1) % m_iNumAverages;
+
+        //Resum once per cycle to avoid accumulating round-off errors
+        if(m_iHistoryPos == 0) {
+            m_matPsd = m_qVecHistory[0];
+            for(int i = 1; i < m_qVecHistory.size(); ++i) {
+                m_matPsd += m_qVecHistory[i];
+            }
+        }
+    } else {
+        //Arithmetic mean until the exponential averaging length is reached
+        double dAlpha = std::max(2.0 / (m_iNumAverages + 1), 1.0 / m_iNumAveraged);
+        m_matPsd = dAlpha * m_matPeriodogram + (1.0 - dAlpha) * m_matPsd;
+    }
+}
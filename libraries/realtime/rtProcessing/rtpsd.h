@@ -0,0 +1,257 @@
+//=============================================================================================================
+/**
+* @file     rtpsd.h
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     RtPsd class declaration.
+*
+*/
+
+#ifndef RTPSD_H
+#define RTPSD_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "../realtime_global.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QSharedPointer>
+#include <QVector>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE REALTIMELIB
+//=============================================================================================================
+
+namespace REALTIMELIB
+{
+
+
+//=============================================================================================================
+/**
+* Streaming Welch power spectral density estimator. Incoming blocks of arbitrary size are written into a
+* per-channel ring buffer. Every time iHop = iSegmentLength - iOverlap new samples have arrived, the latest
+* segment is windowed (Hanning), transformed for all channels with the same cached FFT plan and merged into
+* either an exponentially averaged or a sliding-window averaged spectrum. The cost per block is therefore
+* constant and does not depend on the averaging length.
+*
+* @brief Streaming Welch PSD estimation
+*/
+class REALTIMESHARED_EXPORT RtPsd
+{
+
+public:
+    typedef QSharedPointer<RtPsd> SPtr;             /**< Shared pointer type for RtPsd. */
+    typedef QSharedPointer<const RtPsd> ConstSPtr;  /**< Const shared pointer type for RtPsd. */
+
+    enum AveragingMode {
+        ExponentialAveraging,       /**< psd = alpha * periodogram + (1 - alpha) * psd */
+        SlidingWindowAveraging      /**< Mean of the last iNumAverages periodograms */
+    };
+
+    //=========================================================================================================
+    /**
+    * Creates the streaming PSD estimator.
+    *
+    * @param[in] iNumChannels       Number of channels (rows) of the incoming data blocks.
+    * @param[in] iSegmentLength     Segment length, i.e. the FFT length.
+    * @param[in] dSFreq             The sampling frequency.
+    * @param[in] iOverlap           Number of samples two consecutive segments overlap. Defaults to 50%.
+    * @param[in] mode               The averaging mode.
+    * @param[in] iNumAverages       Number of segments which are averaged. For exponential averaging this
+    *                               defines alpha = 2/(iNumAverages+1).
+    */
+    explicit RtPsd(int iNumChannels,
+                   int iSegmentLength,
+                   double dSFreq,
+                   int iOverlap = -1,
+                   AveragingMode mode = SlidingWindowAveraging,
+                   int iNumAverages = 8);
+
+    //=========================================================================================================
+    /**
+    * Appends a data block and processes all segments which were completed by it.
+    *
+    * @param[in] matData    The data block (channels x samples).
+    *
+    * @return the number of segments which were processed, i.e. > 0 if the spectrum was updated.
+    */
+    int append(const Eigen::MatrixXd& matData);
+
+    //=========================================================================================================
+    /**
+    * Clears the ring buffer and the averaged spectrum.
+    */
+    void reset();
+
+    //=========================================================================================================
+    /**
+    * Sets the averaging mode and length. The averaged spectrum is reset.
+    *
+    * @param[in] mode               The averaging mode.
+    * @param[in] iNumAverages       Number of segments which are averaged.
+    */
+    void setAveraging(AveragingMode mode, int iNumAverages);
+
+    //=========================================================================================================
+    /**
+    * Returns the current one-sided power spectral density (channels x (iSegmentLength/2+1)) in unit^2/Hz.
+    *
+    * @return the averaged power spectral density.
+    */
+    Eigen::MatrixXd getPsd() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the current one-sided power spectral density in dB, i.e. 10*log10(psd).
+    *
+    * @return the averaged power spectral density in dB.
+    */
+    Eigen::MatrixXd getPsdDb() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the frequency of each spectral bin.
+    *
+    * @return the frequency axis in Hz.
+    */
+    Eigen::RowVectorXd getFrequencies() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of segments which entered the currently averaged spectrum.
+    *
+    * @return the number of averaged segments.
+    */
+    inline int getNumAveraged() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the segment (FFT) length.
+    *
+    * @return the segment length.
+    */
+    inline int getSegmentLength() const;
+
+    //=========================================================================================================
+    /**
+    * Returns the number of new samples after which a new segment is processed.
+    *
+    * @return the hop size.
+    */
+    inline int getHopSize() const;
+
+    //=========================================================================================================
+    /**
+    * Calculates a symmetric Hanning window.
+    *
+    * @param[in] iLength    The window length.
+    *
+    * @return the window samples.
+    */
+    static Eigen::RowVectorXd hanningWindow(int iLength);
+
+private:
+    //=========================================================================================================
+    /**
+    * Windows and transforms the most recent segment of the ring buffer and merges it into the average.
+    */
+    void processSegment();
+
+    int                         m_iNumChannels;         /**< Number of channels. */
+    int                         m_iSegmentLength;       /**< The segment (FFT) length. */
+    int                         m_iNumBins;             /**< Number of one-sided spectral bins. */
+    int                         m_iHop;                 /**< Number of new samples between two segments. */
+    int                         m_iNumAverages;         /**< Averaging length in segments. */
+    double                      m_dSFreq;               /**< The sampling frequency. */
+    double                      m_dScale;               /**< Density scaling 1/(fs * sum(w^2)). */
+    AveragingMode               m_averagingMode;        /**< The averaging mode. */
+
+    int                         m_iWritePos;            /**< Next write column in the ring buffer. */
+    int                         m_iSamplesSinceSegment; /**< New samples since the last processed segment. */
+    int                         m_iSamplesBuffered;     /**< Number of valid samples in the ring buffer (<= m_iSegmentLength). */
+    int                         m_iNumAveraged;         /**< Number of segments in the current average. */
+    int                         m_iHistoryPos;          /**< Next slot in m_qVecHistory for sliding window averaging. */
+
+    Eigen::RowVectorXd          m_vecWindow;            /**< The cached window. */
+    Eigen::MatrixXd             m_matRing;              /**< Ring buffer holding the last m_iSegmentLength samples. */
+    Eigen::MatrixXd             m_matSegment;           /**< Reusable workspace for the windowed segment. */
+    Eigen::MatrixXd             m_matPeriodogram;       /**< Reusable workspace for the current periodogram. */
+    Eigen::MatrixXd             m_matPsd;               /**< The averaged spectrum (exponential) or the running sum (sliding window). */
+    QVector<Eigen::MatrixXd>    m_qVecHistory;          /**< Periodogram history for sliding window averaging. */
+
+    Eigen::MatrixXcd            m_matSpectrum;          /**< Reusable workspace for the spectra of all channels. */
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline int RtPsd::getNumAveraged() const
+{
+    return m_iNumAveraged;
+}
+
+
+//*************************************************************************************************************
+
+inline int RtPsd::getSegmentLength() const
+{
+    return m_iSegmentLength;
+}
+
+
+//*************************************************************************************************************
+
+inline int RtPsd::getHopSize() const
+{
+    return m_iHop;
+}
+
+} // NAMESPACE
+
+#endif // RTPSD_H
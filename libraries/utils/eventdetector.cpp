@@ -0,0 +1,212 @@
+//=============================================================================================================
+/**
+* @file     eventdetector.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     EventDetector class definition.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "eventdetector.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <limits>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace Eigen;
+using namespace UTILSLIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+EventDetector::EventDetector(const QList<int>& lChannels, double dThreshold, DetectionMode mode, EdgeType edge, int iDeadTimeSamp)
+: m_dThreshold(dThreshold)
+, m_mode(mode)
+, m_edge(edge)
+, m_iDeadTimeSamp(qMax(0, iDeadTimeSamp))
+, m_bHasLastSample(false)
+, m_iNextSample(0)
+{
+    setChannels(lChannels);
+}
+
+
+//*************************************************************************************************************
+
+void EventDetector::setChannels(const QList<int>& lChannels)
+{
+    m_lChannels = lChannels;
+    m_iNextSample = 0;
+    reset();
+}
+
+
+//*************************************************************************************************************
+
+void EventDetector::setThreshold(double dThreshold)
+{
+    m_dThreshold = dThreshold;
+}
+
+
+//*************************************************************************************************************
+
+void EventDetector::setEdge(DetectionMode mode, EdgeType edge)
+{
+    m_mode = mode;
+    m_edge = edge;
+}
+
+
+//*************************************************************************************************************
+
+void EventDetector::setDeadTime(int iDeadTimeSamp)
+{
+    m_iDeadTimeSamp = qMax(0, iDeadTimeSamp);
+}
+
+
+//*************************************************************************************************************
+
+void EventDetector::setDeadTimeSec(double dDeadTimeSec, double dSFreq)
+{
+    setDeadTime(qRound(dDeadTimeSec * dSFreq));
+}
+
+
+//*************************************************************************************************************
+
+void EventDetector::reset()
+{
+    m_bHasLastSample = false;
+    m_vecLastSample = VectorXd::Zero(m_lChannels.size());
+    m_vecNextAllowed.fill(std::numeric_limits<qint64>::min(), m_lChannels.size());
+}
+
+
+//*************************************************************************************************************
+
+QVector<DetectedEvent> EventDetector::detect(const MatrixXd& matData, qint64 iFirstSample)
+{
+    QVector<DetectedEvent> vecEvents;
+
+    if(iFirstSample >= 0 && iFirstSample != m_iNextSample) {
+        reset();
+        m_iNextSample = iFirstSample;
+    }
+
+    const int iNumChannels = m_lChannels.size();
+    const int iNumCols = static_cast<int>(matData.cols());
+
+    if(iNumChannels == 0 || iNumCols == 0) {
+        return vecEvents;
+    }
+
+    //Gather the trigger rows behind the last sample of the previous block, so edges on the boundary are seen
+    MatrixXd matSignal = MatrixXd::Zero(iNumChannels, iNumCols + 1);
+
+    for(int i = 0; i < iNumChannels; ++i) {
+        int iRow = m_lChannels.at(i);
+        if(iRow < 0 || iRow >= matData.rows()) {
+            continue;
+        }
+
+        matSignal.row(i).tail(iNumCols) = matData.row(iRow);
+        matSignal(i,0) = m_bHasLastSample ? m_vecLastSample(i) : matData(iRow,0);
+    }
+
+    //Compare all channels and samples at once
+    ArrayXXd arrBefore = matSignal.leftCols(iNumCols).array();
+    ArrayXXd arrAfter = matSignal.rightCols(iNumCols).array();
+    Array<bool,Dynamic,Dynamic> arrEdges;
+
+    if(m_mode == Level) {
+        if(m_edge == Rising) {
+            arrEdges = (arrBefore < m_dThreshold) && (arrAfter >= m_dThreshold);
+        } else {
+            arrEdges = (arrBefore >= m_dThreshold) && (arrAfter < m_dThreshold);
+        }
+    } else {
+        if(m_edge == Rising) {
+            arrEdges = (arrAfter - arrBefore) >= m_dThreshold;
+        } else {
+            arrEdges = (arrBefore - arrAfter) >= m_dThreshold;
+        }
+    }
+
+    //Edges are rare, only walk the samples which have one
+    Array<bool,1,Dynamic> arrSamplesWithEdges = arrEdges.colwise().any();
+
+    for(int j = 0; j < iNumCols; ++j) {
+        if(!arrSamplesWithEdges(j)) {
+            continue;
+        }
+
+        qint64 iSample = m_iNextSample + j;
+
+        for(int i = 0; i < iNumChannels; ++i) {
+            if(!arrEdges(i,j) || iSample < m_vecNextAllowed[i]) {
+                continue;
+            }
+
+            DetectedEvent event;
+            event.iSample = iSample;
+            event.iChannel = i;
+            event.dBefore = arrBefore(i,j);
+            event.dAfter = arrAfter(i,j);
+            vecEvents.append(event);
+
+            m_vecNextAllowed[i] = iSample + m_iDeadTimeSamp + 1;
+        }
+    }
+
+    m_vecLastSample = matSignal.col(iNumCols);
+    m_bHasLastSample = true;
+    m_iNextSample += iNumCols;
+
+    return vecEvents;
+}
@@ -0,0 +1,252 @@
+//=============================================================================================================
+/**
+* @file     eventdetector.h
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     EventDetector class declaration.
+*
+*/
+
+#ifndef EVENTDETECTOR_H
+#define EVENTDETECTOR_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "utils_global.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QSharedPointer>
+#include <QList>
+#include <QVector>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// EIGEN INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE UTILSLIB
+//=============================================================================================================
+
+namespace UTILSLIB
+{
+
+//=============================================================================================================
+/**
+* A trigger edge found by the EventDetector.
+*/
+struct DetectedEvent {
+    qint64  iSample;        /**< The sample index of the first sample after the edge. */
+    int     iChannel;       /**< The position of the channel in the list of scanned channels. */
+    double  dBefore;        /**< The channel value before the edge. */
+    double  dAfter;         /**< The channel value after the edge. */
+};
+
+
+//=============================================================================================================
+/**
+* Streaming trigger edge detection. In contrast to the per block DetectTrigger routines the detector keeps the last
+* sample and the dead time of every channel, so edges on block boundaries are found exactly once. All channels of a
+* block are compared at once on the gathered trigger rows.
+*
+* @brief Stateful trigger edge detection across data blocks
+*/
+class UTILSSHARED_EXPORT EventDetector
+{
+
+public:
+    typedef QSharedPointer<EventDetector> SPtr;            /**< Shared pointer type for EventDetector class. */
+    typedef QSharedPointer<const EventDetector> ConstSPtr; /**< Const shared pointer type for EventDetector class. */
+
+    enum DetectionMode {
+        Level,          /**< An edge is a crossing of the threshold. */
+        Gradient        /**< An edge is a step of at least the threshold between two samples. */
+    };
+
+    enum EdgeType {
+        Rising,
+        Falling
+    };
+
+    //=========================================================================================================
+    /**
+    * Constructs an EventDetector.
+    *
+    * @param[in] lChannels      The row indices of the trigger channels in the scanned data.
+    * @param[in] dThreshold     The level or step threshold.
+    * @param[in] mode           Whether to detect threshold crossings or steps.
+    * @param[in] edge           Whether to detect rising or falling edges.
+    * @param[in] iDeadTimeSamp  The number of samples after an edge in which further edges of the same channel are ignored.
+    */
+    EventDetector(const QList<int>& lChannels = QList<int>(),
+                  double dThreshold = 0.5,
+                  DetectionMode mode = Level,
+                  EdgeType edge = Rising,
+                  int iDeadTimeSamp = 0);
+
+    //=========================================================================================================
+    /**
+    * Sets the trigger channels and resets the detector.
+    *
+    * @param[in] lChannels      The row indices of the trigger channels in the scanned data.
+    */
+    void setChannels(const QList<int>& lChannels);
+
+    //=========================================================================================================
+    /**
+    * Returns the trigger channels.
+    *
+    * @return the row indices of the trigger channels.
+    */
+    inline const QList<int>& channels() const;
+
+    //=========================================================================================================
+    /**
+    * Sets the threshold. The channel state is kept.
+    *
+    * @param[in] dThreshold     The level or step threshold.
+    */
+    void setThreshold(double dThreshold);
+
+    //=========================================================================================================
+    /**
+    * Returns the threshold.
+    *
+    * @return the level or step threshold.
+    */
+    inline double threshold() const;
+
+    //=========================================================================================================
+    /**
+    * Sets what is detected as edge. The channel state is kept.
+    *
+    * @param[in] mode           Whether to detect threshold crossings or steps.
+    * @param[in] edge           Whether to detect rising or falling edges.
+    */
+    void setEdge(DetectionMode mode, EdgeType edge);
+
+    //=========================================================================================================
+    /**
+    * Sets the dead time after an edge.
+    *
+    * @param[in] iDeadTimeSamp  The number of samples after an edge in which further edges of the same channel are ignored.
+    */
+    void setDeadTime(int iDeadTimeSamp);
+
+    //=========================================================================================================
+    /**
+    * Sets the dead time after an edge in seconds, converted with the sampling frequency of the scanned data.
+    *
+    * @param[in] dDeadTimeSec   The time after an edge in which further edges of the same channel are ignored.
+    * @param[in] dSFreq         The sampling frequency of the scanned data.
+    */
+    void setDeadTimeSec(double dDeadTimeSec, double dSFreq);
+
+    //=========================================================================================================
+    /**
+    * Forgets the last samples and dead times. The next block is treated as the start of the data, i.e., no edge is
+    * reported at its first sample.
+    */
+    void reset();
+
+    //=========================================================================================================
+    /**
+    * Returns the sample index the next block is expected to start at.
+    *
+    * @return the sample index following the last scanned block.
+    */
+    inline qint64 nextSample() const;
+
+    //=========================================================================================================
+    /**
+    * Scans the next data block for edges.
+    *
+    * @param[in] matData        The data block, channels in rows.
+    * @param[in] iFirstSample   The sample index of the first column. If it does not continue the last block the
+    *                           detector is reset first. Pass -1 to continue after the last block.
+    *
+    * @return the detected edges ordered by sample.
+    */
+    QVector<DetectedEvent> detect(const Eigen::MatrixXd& matData, qint64 iFirstSample = -1);
+
+private:
+    QList<int>          m_lChannels;        /**< The row indices of the trigger channels. */
+    double              m_dThreshold;       /**< The level or step threshold. */
+    DetectionMode       m_mode;             /**< Threshold crossings or steps. */
+    EdgeType            m_edge;             /**< Rising or falling edges. */
+    int                 m_iDeadTimeSamp;    /**< Samples ignored after an edge. */
+
+    bool                m_bHasLastSample;   /**< Whether m_vecLastSample holds the sample before the next block. */
+    qint64              m_iNextSample;      /**< The sample index of the next block. */
+    Eigen::VectorXd     m_vecLastSample;    /**< The last sample of every trigger channel. */
+    QVector<qint64>     m_vecNextAllowed;   /**< The first sample after the dead time of every trigger channel. */
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline const QList<int>& EventDetector::channels() const
+{
+    return m_lChannels;
+}
+
+
+//*************************************************************************************************************
+
+inline double EventDetector::threshold() const
+{
+    return m_dThreshold;
+}
+
+
+//*************************************************************************************************************
+
+inline qint64 EventDetector::nextSample() const
+{
+    return m_iNextSample;
+}
+
+} // NAMESPACE UTILSLIB
+
+#endif // EVENTDETECTOR_H
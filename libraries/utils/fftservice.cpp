@@ -0,0 +1,580 @@
+//=============================================================================================================
+/**
+* @file     fftservice.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     FFTService class definition.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "fftservice.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QThreadStorage>
+#include <QScopedPointer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// EIGEN INCLUDES
+//=============================================================================================================
+
+#include <unsupported/Eigen/FFT>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace Eigen;
+using namespace UTILSLIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE GLOBAL METHODS
+//=============================================================================================================
+
+namespace
+{
+
+enum TransformType {
+    RealForward = 0,
+    ComplexForward = 1,
+    RealInverse = 2,
+    ComplexInverse = 3
+};
+
+#ifdef EIGEN_FFTW_DEFAULT
+// Creating and destroying FFTW plans is not thread-safe, executing existing plans on new arrays is
+QMutex s_plannerMutex;
+#endif
+
+
+//=============================================================================================================
+/**
+* The cached transforms and workspaces of one scalar type. Real and complex transforms use separate Eigen::FFT
+* objects, since the FFTW wrapper of Eigen does not distinguish them in its plan keys.
+*/
+template<typename T>
+struct FFTPlanSet
+{
+    FFTPlanSet()
+    {
+        fftReal.SetFlag(fftReal.HalfSpectrum);
+    }
+
+    Eigen::FFT<T>                                       fftReal;        /**< Real to half spectrum and back, caches its plans by length and direction. */
+    Eigen::FFT<T>                                       fftComplex;     /**< Complex transforms, caches its plans by length and direction. */
+    Eigen::Matrix<T, Eigen::Dynamic, 1>                 vecTime;        /**< Aligned time domain workspace of the batched transforms. */
+    Eigen::Matrix<std::complex<T>, Eigen::Dynamic, 1>   vecFreq;        /**< Aligned frequency domain workspace of the batched transforms. */
+};
+
+
+//=============================================================================================================
+/**
+* Everything FFTService caches for one thread.
+*/
+struct FFTThreadCache
+{
+    FFTThreadCache()
+    : pPlansDouble(new FFTPlanSet<double>())
+    , pPlansFloat(new FFTPlanSet<float>())
+    {
+    }
+
+    ~FFTThreadCache()
+    {
+#ifdef EIGEN_FFTW_DEFAULT
+        QMutexLocker locker(&s_plannerMutex);
+#endif
+        pPlansDouble.reset();
+        pPlansFloat.reset();
+    }
+
+    QScopedPointer<FFTPlanSet<double> >     pPlansDouble;
+    QScopedPointer<FFTPlanSet<float> >      pPlansFloat;
+#ifdef EIGEN_FFTW_DEFAULT
+    QSet<qint64>                            setPlanned;     /**< The keys of the FFTW plans this thread created already. */
+#endif
+};
+
+QThreadStorage<FFTThreadCache*> s_threadCache;
+
+
+//*************************************************************************************************************
+
+FFTThreadCache& threadCache()
+{
+    if(!s_threadCache.hasLocalData()) {
+        s_threadCache.setLocalData(new FFTThreadCache());
+    }
+
+    return *s_threadCache.localData();
+}
+
+
+//*************************************************************************************************************
+
+template<typename T>
+FFTPlanSet<T>& planSet(FFTThreadCache& cache);
+
+template<>
+FFTPlanSet<double>& planSet<double>(FFTThreadCache& cache)
+{
+    return *cache.pPlansDouble;
+}
+
+template<>
+FFTPlanSet<float>& planSet<float>(FFTThreadCache& cache)
+{
+    return *cache.pPlansFloat;
+}
+
+
+//*************************************************************************************************************
+
+template<typename T, typename T_Transform>
+inline void runTransform(FFTThreadCache& cache, TransformType type, int iNfft, const void* pDst, const void* pSrc, T_Transform transform)
+{
+#ifdef EIGEN_FFTW_DEFAULT
+    //The first transform of a plan key creates the plan, do that under the planner lock. Eigen keys its plans by
+    //length, direction, in-place and alignment.
+    const bool bInplace = pDst == pSrc;
+    const bool bAligned = ((reinterpret_cast<quintptr>(pDst) | reinterpret_cast<quintptr>(pSrc)) & 15) == 0;
+    const qint64 iKey = (qint64(iNfft) << 8) | (qint64(sizeof(T) == sizeof(double)) << 4) | (qint64(type) << 2) | (qint64(bInplace) << 1) | qint64(bAligned);
+
+    if(!cache.setPlanned.contains(iKey)) {
+        QMutexLocker locker(&s_plannerMutex);
+        transform();
+        cache.setPlanned.insert(iKey);
+        return;
+    }
+#else
+    Q_UNUSED(cache);
+    Q_UNUSED(type);
+    Q_UNUSED(iNfft);
+    Q_UNUSED(pDst);
+    Q_UNUSED(pSrc);
+#endif
+
+    transform();
+}
+
+
+//*************************************************************************************************************
+
+template<typename T>
+void reflectSpectrum(std::complex<T>* pFreq, int iNfft)
+{
+    //Create the negative frequencies as conjugate mirror of the positive ones
+    for(int k = iNfft/2 + 1; k < iNfft; ++k) {
+        pFreq[k] = std::conj(pFreq[iNfft - k]);
+    }
+}
+
+
+//*************************************************************************************************************
+
+template<typename T>
+void fwdReal(std::complex<T>* pFreq, const T* pTime, int iNfft, bool bHalfSpectrum)
+{
+    if(iNfft < 1) {
+        return;
+    }
+
+    //kissfft does not handle the trivial length
+    if(iNfft == 1) {
+        pFreq[0] = std::complex<T>(pTime[0], 0);
+        return;
+    }
+
+    FFTThreadCache& cache = threadCache();
+    FFTPlanSet<T>& plans = planSet<T>(cache);
+
+    runTransform<T>(cache, RealForward, iNfft, pFreq, pTime, [&]() {
+        plans.fftReal.fwd(pFreq, pTime, iNfft);
+    });
+
+    if(!bHalfSpectrum) {
+        reflectSpectrum(pFreq, iNfft);
+    }
+}
+
+
+//*************************************************************************************************************
+
+template<typename T>
+void fwdComplex(std::complex<T>* pFreq, const std::complex<T>* pTime, int iNfft)
+{
+    if(iNfft < 1) {
+        return;
+    }
+
+    if(iNfft == 1) {
+        pFreq[0] = pTime[0];
+        return;
+    }
+
+    FFTThreadCache& cache = threadCache();
+    FFTPlanSet<T>& plans = planSet<T>(cache);
+
+    runTransform<T>(cache, ComplexForward, iNfft, pFreq, pTime, [&]() {
+        plans.fftComplex.fwd(pFreq, pTime, iNfft);
+    });
+}
+
+
+//*************************************************************************************************************
+
+template<typename T>
+void invReal(T* pTime, const std::complex<T>* pFreq, int iNfft)
+{
+    if(iNfft < 1) {
+        return;
+    }
+
+    if(iNfft == 1) {
+        pTime[0] = pFreq[0].real();
+        return;
+    }
+
+    FFTThreadCache& cache = threadCache();
+    FFTPlanSet<T>& plans = planSet<T>(cache);
+
+    runTransform<T>(cache, RealInverse, iNfft, pTime, pFreq, [&]() {
+        plans.fftReal.inv(pTime, pFreq, iNfft);
+    });
+}
+
+
+//*************************************************************************************************************
+
+template<typename T>
+void invComplex(std::complex<T>* pTime, const std::complex<T>* pFreq, int iNfft)
+{
+    if(iNfft < 1) {
+        return;
+    }
+
+    if(iNfft == 1) {
+        pTime[0] = pFreq[0];
+        return;
+    }
+
+    FFTThreadCache& cache = threadCache();
+    FFTPlanSet<T>& plans = planSet<T>(cache);
+
+    runTransform<T>(cache, ComplexInverse, iNfft, pTime, pFreq, [&]() {
+        plans.fftComplex.inv(pTime, pFreq, iNfft);
+    });
+}
+
+
+//*************************************************************************************************************
+
+template<typename T>
+void fwdRowsImpl(Matrix<std::complex<T>, Dynamic, Dynamic>& matFreq, const Matrix<T, Dynamic, Dynamic>& matTime, int iNfft, bool bHalfSpectrum)
+{
+    if(iNfft < 1) {
+        iNfft = static_cast<int>(matTime.cols());
+    }
+
+    const int iNumBins = bHalfSpectrum ? iNfft/2 + 1 : iNfft;
+    matFreq.resize(matTime.rows(), iNfft > 0 ? iNumBins : 0);
+
+    if(iNfft < 1) {
+        return;
+    }
+
+    //Rows are strided, gather them into the workspace. Samples beyond the row length stay zero for all rows.
+    FFTPlanSet<T>& plans = planSet<T>(threadCache());
+    const int iNumCopy = qMin(iNfft, static_cast<int>(matTime.cols()));
+    plans.vecTime.setZero(iNfft);
+    plans.vecFreq.resize(iNfft);
+
+    for(int i = 0; i < matTime.rows(); ++i) {
+        plans.vecTime.head(iNumCopy) = matTime.row(i).head(iNumCopy).transpose();
+        fwdReal<T>(plans.vecFreq.data(), plans.vecTime.data(), iNfft, bHalfSpectrum);
+        matFreq.row(i) = plans.vecFreq.head(iNumBins).transpose();
+    }
+}
+
+
+//*************************************************************************************************************
+
+template<typename T>
+void fwdColumnsImpl(Matrix<std::complex<T>, Dynamic, Dynamic>& matFreq, const Matrix<T, Dynamic, Dynamic>& matTime, int iNfft, bool bHalfSpectrum)
+{
+    if(iNfft < 1) {
+        iNfft = static_cast<int>(matTime.rows());
+    }
+
+    const int iNumBins = bHalfSpectrum ? iNfft/2 + 1 : iNfft;
+    matFreq.resize(iNfft > 0 ? iNumBins : 0, matTime.cols());
+
+    if(iNfft < 1) {
+        return;
+    }
+
+    if(iNfft == matTime.rows()) {
+        //Columns are contiguous, transform them directly
+        for(int i = 0; i < matTime.cols(); ++i) {
+            fwdReal<T>(matFreq.col(i).data(), matTime.col(i).data(), iNfft, bHalfSpectrum);
+        }
+        return;
+    }
+
+    FFTPlanSet<T>& plans = planSet<T>(threadCache());
+    const int iNumCopy = qMin(iNfft, static_cast<int>(matTime.rows()));
+    plans.vecTime.setZero(iNfft);
+
+    for(int i = 0; i < matTime.cols(); ++i) {
+        plans.vecTime.head(iNumCopy) = matTime.col(i).head(iNumCopy);
+        fwdReal<T>(matFreq.col(i).data(), plans.vecTime.data(), iNfft, bHalfSpectrum);
+    }
+}
+
+
+//*************************************************************************************************************
+
+template<typename T>
+void invRowsImpl(Matrix<T, Dynamic, Dynamic>& matTime, const Matrix<std::complex<T>, Dynamic, Dynamic>& matFreq, int iNfft)
+{
+    if(iNfft < 1) {
+        iNfft = static_cast<int>(2*(matFreq.cols() - 1));
+    }
+
+    matTime.resize(matFreq.rows(), qMax(iNfft, 0));
+
+    if(iNfft < 1) {
+        return;
+    }
+
+    //Missing bins are zero for all rows
+    FFTPlanSet<T>& plans = planSet<T>(threadCache());
+    const int iNumBins = iNfft/2 + 1;
+    const int iNumCopy = qMin(iNumBins, static_cast<int>(matFreq.cols()));
+    plans.vecFreq.setZero(iNumBins);
+    plans.vecTime.resize(iNfft);
+
+    for(int i = 0; i < matFreq.rows(); ++i) {
+        plans.vecFreq.head(iNumCopy) = matFreq.row(i).head(iNumCopy).transpose();
+        invReal<T>(plans.vecTime.data(), plans.vecFreq.data(), iNfft);
+        matTime.row(i) = plans.vecTime.transpose();
+    }
+}
+
+
+//*************************************************************************************************************
+
+template<typename T>
+void invColumnsImpl(Matrix<T, Dynamic, Dynamic>& matTime, const Matrix<std::complex<T>, Dynamic, Dynamic>& matFreq, int iNfft)
+{
+    if(iNfft < 1) {
+        iNfft = static_cast<int>(2*(matFreq.rows() - 1));
+    }
+
+    matTime.resize(qMax(iNfft, 0), matFreq.cols());
+
+    if(iNfft < 1) {
+        return;
+    }
+
+    const int iNumBins = iNfft/2 + 1;
+
+    if(matFreq.rows() >= iNumBins) {
+        for(int i = 0; i < matFreq.cols(); ++i) {
+            invReal<T>(matTime.col(i).data(), matFreq.col(i).data(), iNfft);
+        }
+        return;
+    }
+
+    FFTPlanSet<T>& plans = planSet<T>(threadCache());
+    plans.vecFreq.setZero(iNumBins);
+
+    for(int i = 0; i < matFreq.cols(); ++i) {
+        plans.vecFreq.head(matFreq.rows()) = matFreq.col(i);
+        invReal<T>(matTime.col(i).data(), plans.vecFreq.data(), iNfft);
+    }
+}
+
+} // NAMESPACE
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+void FFTService::fwd(std::complex<double>* pFreq, const double* pTime, int iNfft, bool bHalfSpectrum)
+{
+    fwdReal<double>(pFreq, pTime, iNfft, bHalfSpectrum);
+}
+
+
+//*************************************************************************************************************
+
+void FFTService::fwd(std::complex<float>* pFreq, const float* pTime, int iNfft, bool bHalfSpectrum)
+{
+    fwdReal<float>(pFreq, pTime, iNfft, bHalfSpectrum);
+}
+
+
+//*************************************************************************************************************
+
+void FFTService::fwd(std::complex<double>* pFreq, const std::complex<double>* pTime, int iNfft)
+{
+    fwdComplex<double>(pFreq, pTime, iNfft);
+}
+
+
+//*************************************************************************************************************
+
+void FFTService::fwd(std::complex<float>* pFreq, const std::complex<float>* pTime, int iNfft)
+{
+    fwdComplex<float>(pFreq, pTime, iNfft);
+}
+
+
+//*************************************************************************************************************
+
+void FFTService::inv(double* pTime, const std::complex<double>* pFreq, int iNfft)
+{
+    invReal<double>(pTime, pFreq, iNfft);
+}
+
+
+//*************************************************************************************************************
+
+void FFTService::inv(float* pTime, const std::complex<float>* pFreq, int iNfft)
+{
+    invReal<float>(pTime, pFreq, iNfft);
+}
+
+
+//*************************************************************************************************************
+
+void FFTService::inv(std::complex<double>* pTime, const std::complex<double>* pFreq, int iNfft)
+{
+    invComplex<double>(pTime, pFreq, iNfft);
+}
+
+
+//*************************************************************************************************************
+
+void FFTService::inv(std::complex<float>* pTime, const std::complex<float>* pFreq, int iNfft)
+{
+    invComplex<float>(pTime, pFreq, iNfft);
+}
+
+
+//*************************************************************************************************************
+
+void FFTService::fwdRows(MatrixXcd& matFreq, const MatrixXd& matTime, int iNfft, bool bHalfSpectrum)
+{
+    fwdRowsImpl<double>(matFreq, matTime, iNfft, bHalfSpectrum);
+}
+
+
+//*************************************************************************************************************
+
+void FFTService::fwdRows(MatrixXcf& matFreq, const MatrixXf& matTime, int iNfft, bool bHalfSpectrum)
+{
+    fwdRowsImpl<float>(matFreq, matTime, iNfft, bHalfSpectrum);
+}
+
+
+//*************************************************************************************************************
+
+void FFTService::fwdColumns(MatrixXcd& matFreq, const MatrixXd& matTime, int iNfft, bool bHalfSpectrum)
+{
+    fwdColumnsImpl<double>(matFreq, matTime, iNfft, bHalfSpectrum);
+}
+
+
+//*************************************************************************************************************
+
+void FFTService::fwdColumns(MatrixXcf& matFreq, const MatrixXf& matTime, int iNfft, bool bHalfSpectrum)
+{
+    fwdColumnsImpl<float>(matFreq, matTime, iNfft, bHalfSpectrum);
+}
+
+
+//*************************************************************************************************************
+
+void FFTService::invRows(MatrixXd& matTime, const MatrixXcd& matFreq, int iNfft)
+{
+    invRowsImpl<double>(matTime, matFreq, iNfft);
+}
+
+
+//*************************************************************************************************************
+
+void FFTService::invColumns(MatrixXd& matTime, const MatrixXcd& matFreq, int iNfft)
+{
+    invColumnsImpl<double>(matTime, matFreq, iNfft);
+}
+
+
+//*************************************************************************************************************
+
+void FFTService::clearThreadCache()
+{
+    if(s_threadCache.hasLocalData()) {
+        //Deletes the cache of this thread
+        s_threadCache.setLocalData(0);
+    }
+}
+
+
+//*************************************************************************************************************
+
+const char* FFTService::backendName()
+{
+#ifdef EIGEN_FFTW_DEFAULT
+    return "fftw";
+#else
+    return "kissfft";
+#endif
+}
@@ -0,0 +1,321 @@
+//=============================================================================================================
+/**
+* @file     fftservice.h
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     FFTService class declaration.
+*
+*/
+
+#ifndef FFTSERVICE_H
+#define FFTSERVICE_H
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "utils_global.h"
+
+#include <complex>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// EIGEN INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE UTILSLIB
+//=============================================================================================================
+
+namespace UTILSLIB
+{
+
+//=============================================================================================================
+/**
+* Central FFT service of MNE-CPP. Eigen::FFT computes the twiddle factors and the factorization of a transform length
+* when it is used for the first time and keeps them in its instance, so constructing a fresh Eigen::FFT per call or
+* per channel pays for the planning every time. FFTService keeps one set of transform objects and workspaces per
+* thread, so plans are cached by length, scalar type, real or complex input and direction, and are reused by all
+* callers of that thread without any locking.
+*
+* Real forward transforms return the half spectrum (nfft/2+1 bins) by default, inverse transforms are scaled by
+* 1/nfft, i.e., the conventions of Eigen::FFT with the HalfSpectrum flag.
+*
+* The backend is the kissfft shipped with Eigen. Building with MNECPP_CONFIG+=useFFTW switches to FFTW3, in which
+* case the creation of new plans is serialized, since the FFTW planner is not thread-safe.
+*
+* @brief Preplanned FFTs with a per thread plan cache
+*/
+class UTILSSHARED_EXPORT FFTService
+{
+
+public:
+    //=========================================================================================================
+    /**
+    * Forward transform of real data.
+    *
+    * @param[out] pFreq         The spectrum, nfft/2+1 bins if bHalfSpectrum, nfft bins otherwise.
+    * @param[in] pTime          The nfft time samples.
+    * @param[in] iNfft          The transform length.
+    * @param[in] bHalfSpectrum  Whether to only compute the non-negative frequencies.
+    */
+    static void fwd(std::complex<double>* pFreq, const double* pTime, int iNfft, bool bHalfSpectrum = true);
+    static void fwd(std::complex<float>* pFreq, const float* pTime, int iNfft, bool bHalfSpectrum = true);
+
+    //=========================================================================================================
+    /**
+    * Forward transform of complex data.
+    *
+    * @param[out] pFreq         The nfft bins of the spectrum.
+    * @param[in] pTime          The nfft time samples.
+    * @param[in] iNfft          The transform length.
+    */
+    static void fwd(std::complex<double>* pFreq, const std::complex<double>* pTime, int iNfft);
+    static void fwd(std::complex<float>* pFreq, const std::complex<float>* pTime, int iNfft);
+
+    //=========================================================================================================
+    /**
+    * Scaled inverse transform to real data. Only the first nfft/2+1 bins of the spectrum are read.
+    *
+    * @param[out] pTime         The nfft time samples.
+    * @param[in] pFreq          The spectrum.
+    * @param[in] iNfft          The transform length.
+    */
+    static void inv(double* pTime, const std::complex<double>* pFreq, int iNfft);
+    static void inv(float* pTime, const std::complex<float>* pFreq, int iNfft);
+
+    //=========================================================================================================
+    /**
+    * Scaled inverse transform to complex data.
+    *
+    * @param[out] pTime         The nfft time samples.
+    * @param[in] pFreq          The nfft bins of the spectrum.
+    * @param[in] iNfft          The transform length.
+    */
+    static void inv(std::complex<double>* pTime, const std::complex<double>* pFreq, int iNfft);
+    static void inv(std::complex<float>* pTime, const std::complex<float>* pFreq, int iNfft);
+
+    //=========================================================================================================
+    /**
+    * Forward transform of a real or complex vector. The transform length is the length of the input, which may be
+    * any vector expression.
+    *
+    * @param[out] vecFreq       The spectrum, resized to nfft/2+1 bins for real input if bHalfSpectrum, to nfft otherwise.
+    * @param[in] vecTime        The time samples.
+    * @param[in] bHalfSpectrum  Whether to only compute the non-negative frequencies of real input.
+    */
+    template<typename T_Freq, typename T_Time>
+    static void fwd(Eigen::PlainObjectBase<T_Freq>& vecFreq, const Eigen::MatrixBase<T_Time>& vecTime, bool bHalfSpectrum = true);
+
+    //=========================================================================================================
+    /**
+    * Scaled inverse transform of a spectrum to a real or complex vector.
+    *
+    * @param[out] vecTime       The time samples, resized to nfft.
+    * @param[in] vecFreq        The spectrum. Real output reads the first nfft/2+1 bins.
+    * @param[in] iNfft          The transform length. Defaults to 2*(bins-1) for real and to bins for complex output.
+    */
+    template<typename T_Time, typename T_Freq>
+    static void inv(Eigen::PlainObjectBase<T_Time>& vecTime, const Eigen::MatrixBase<T_Freq>& vecFreq, int iNfft = -1);
+
+    //=========================================================================================================
+    /**
+    * Batched forward transform of every row of a real matrix, e.g., of all channels of a data block. All rows share
+    * the cached plan and workspace of the calling thread.
+    *
+    * @param[out] matFreq       The spectra in rows, nfft/2+1 columns if bHalfSpectrum, nfft columns otherwise.
+    * @param[in] matTime        The time samples in rows.
+    * @param[in] iNfft          The transform length, the rows are zero-padded or truncated. Defaults to the number of columns.
+    * @param[in] bHalfSpectrum  Whether to only compute the non-negative frequencies.
+    */
+    static void fwdRows(Eigen::MatrixXcd& matFreq, const Eigen::MatrixXd& matTime, int iNfft = -1, bool bHalfSpectrum = true);
+    static void fwdRows(Eigen::MatrixXcf& matFreq, const Eigen::MatrixXf& matTime, int iNfft = -1, bool bHalfSpectrum = true);
+
+    //=========================================================================================================
+    /**
+    * Batched forward transform of every column of a real matrix. Columns are contiguous, so they are transformed in
+    * place of the input without copying unless they need to be zero-padded or truncated.
+    *
+    * @param[out] matFreq       The spectra in columns, nfft/2+1 rows if bHalfSpectrum, nfft rows otherwise.
+    * @param[in] matTime        The time samples in columns.
+    * @param[in] iNfft          The transform length, the columns are zero-padded or truncated. Defaults to the number of rows.
+    * @param[in] bHalfSpectrum  Whether to only compute the non-negative frequencies.
+    */
+    static void fwdColumns(Eigen::MatrixXcd& matFreq, const Eigen::MatrixXd& matTime, int iNfft = -1, bool bHalfSpectrum = true);
+    static void fwdColumns(Eigen::MatrixXcf& matFreq, const Eigen::MatrixXf& matTime, int iNfft = -1, bool bHalfSpectrum = true);
+
+    //=========================================================================================================
+    /**
+    * Batched scaled inverse transform of every row of a spectrum matrix to real data.
+    *
+    * @param[out] matTime       The nfft time samples in rows.
+    * @param[in] matFreq        The spectra in rows, at least nfft/2+1 columns.
+    * @param[in] iNfft          The transform length. Defaults to 2*(columns-1).
+    */
+    static void invRows(Eigen::MatrixXd& matTime, const Eigen::MatrixXcd& matFreq, int iNfft = -1);
+
+    //=========================================================================================================
+    /**
+    * Batched scaled inverse transform of every column of a spectrum matrix to real data.
+    *
+    * @param[out] matTime       The nfft time samples in columns.
+    * @param[in] matFreq        The spectra in columns, at least nfft/2+1 rows.
+    * @param[in] iNfft          The transform length. Defaults to 2*(rows-1).
+    */
+    static void invColumns(Eigen::MatrixXd& matTime, const Eigen::MatrixXcd& matFreq, int iNfft = -1);
+
+    //=========================================================================================================
+    /**
+    * Releases the plans and workspaces cached for the calling thread, e.g., after a one-off analysis with unusual
+    * transform lengths. They are released automatically when the thread finishes.
+    */
+    static void clearThreadCache();
+
+    //=========================================================================================================
+    /**
+    * Returns the name of the FFT backend the service was built with.
+    *
+    * @return "kissfft" or "fftw".
+    */
+    static const char* backendName();
+
+private:
+    //=========================================================================================================
+    /**
+    * Selects the real or complex forward transform for the vector interface. bHalfSpectrum is ignored for complex input.
+    */
+    inline static void fwdVector(std::complex<double>* pFreq, const double* pTime, int iNfft, bool bHalfSpectrum);
+    inline static void fwdVector(std::complex<float>* pFreq, const float* pTime, int iNfft, bool bHalfSpectrum);
+    inline static void fwdVector(std::complex<double>* pFreq, const std::complex<double>* pTime, int iNfft, bool bHalfSpectrum);
+    inline static void fwdVector(std::complex<float>* pFreq, const std::complex<float>* pTime, int iNfft, bool bHalfSpectrum);
+};
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INLINE DEFINITIONS
+//=============================================================================================================
+
+inline void FFTService::fwdVector(std::complex<double>* pFreq, const double* pTime, int iNfft, bool bHalfSpectrum)
+{
+    fwd(pFreq, pTime, iNfft, bHalfSpectrum);
+}
+
+
+//*************************************************************************************************************
+
+inline void FFTService::fwdVector(std::complex<float>* pFreq, const float* pTime, int iNfft, bool bHalfSpectrum)
+{
+    fwd(pFreq, pTime, iNfft, bHalfSpectrum);
+}
+
+
+//*************************************************************************************************************
+
+inline void FFTService::fwdVector(std::complex<double>* pFreq, const std::complex<double>* pTime, int iNfft, bool bHalfSpectrum)
+{
+    Q_UNUSED(bHalfSpectrum);
+    fwd(pFreq, pTime, iNfft);
+}
+
+
+//*************************************************************************************************************
+
+inline void FFTService::fwdVector(std::complex<float>* pFreq, const std::complex<float>* pTime, int iNfft, bool bHalfSpectrum)
+{
+    Q_UNUSED(bHalfSpectrum);
+    fwd(pFreq, pTime, iNfft);
+}
+
+
+//*************************************************************************************************************
+
+template<typename T_Freq, typename T_Time>
+void FFTService::fwd(Eigen::PlainObjectBase<T_Freq>& vecFreq, const Eigen::MatrixBase<T_Time>& vecTime, bool bHalfSpectrum)
+{
+    typedef typename T_Time::Scalar TimeScalar;
+    EIGEN_STATIC_ASSERT_VECTOR_ONLY(T_Time)
+    EIGEN_STATIC_ASSERT_VECTOR_ONLY(T_Freq)
+
+    const int iNfft = static_cast<int>(vecTime.size());
+    const bool bRealInput = Eigen::NumTraits<TimeScalar>::IsComplex == 0;
+    vecFreq.resize(bRealInput && bHalfSpectrum ? iNfft/2 + 1 : iNfft);
+
+    if(iNfft == 0) {
+        return;
+    }
+
+    //Strided input, e.g., a row of a column-major matrix, is packed into a temporary by the Ref
+    Eigen::Ref<const Eigen::Matrix<TimeScalar, Eigen::Dynamic, 1> > refTime(vecTime);
+
+    fwdVector(vecFreq.data(), refTime.data(), iNfft, bHalfSpectrum);
+}
+
+
+//*************************************************************************************************************
+
+template<typename T_Time, typename T_Freq>
+void FFTService::inv(Eigen::PlainObjectBase<T_Time>& vecTime, const Eigen::MatrixBase<T_Freq>& vecFreq, int iNfft)
+{
+    typedef typename T_Freq::Scalar FreqScalar;
+    EIGEN_STATIC_ASSERT_VECTOR_ONLY(T_Time)
+    EIGEN_STATIC_ASSERT_VECTOR_ONLY(T_Freq)
+
+    const bool bRealOutput = Eigen::NumTraits<typename T_Time::Scalar>::IsComplex == 0;
+    if(iNfft < 1) {
+        iNfft = static_cast<int>(bRealOutput ? 2*(vecFreq.size() - 1) : vecFreq.size());
+    }
+    vecTime.resize(iNfft);
+
+    if(iNfft < 1) {
+        return;
+    }
+
+    //Pad missing bins with zeros, so the transform never reads past the end of the spectrum
+    const int iNumBins = bRealOutput ? iNfft/2 + 1 : iNfft;
+    Eigen::Matrix<FreqScalar, Eigen::Dynamic, 1> vecPadded;
+    if(vecFreq.size() < iNumBins) {
+        vecPadded.setZero(iNumBins);
+        vecPadded.head(vecFreq.size()) = vecFreq;
+        inv(vecTime.data(), vecPadded.data(), iNfft);
+        return;
+    }
+
+    Eigen::Ref<const Eigen::Matrix<FreqScalar, Eigen::Dynamic, 1> > refFreq(vecFreq);
+    inv(vecTime.data(), refFreq.data(), iNfft);
+}
+
+} // NAMESPACE UTILSLIB
+
+#endif // FFTSERVICE_H
@@ -41,22 +41,12 @@
 
 #include "cosinefilter.h"
 
+#include "../fftservice.h"
+
 #define _USE_MATH_DEFINES
 #include <math.h>
 
 
-//*************************************************************************************************************
-//=============================================================================================================
-// Eigen INCLUDES
-//=============================================================================================================
-
-//#ifndef EIGEN_FFTW_DEFAULT
-//#define EIGEN_FFTW_DEFAULT
-//#endif
-
-#include <unsupported/Eigen/FFT>
-
-
 //*************************************************************************************************************
 //=============================================================================================================
 // USED NAMESPACES
@@ -153,11 +143,7 @@ CosineFilter::CosineFilter(int fftLength, float lowpass, float lowpass_width, fl
     m_dFFTCoeffA = filterFreqResp;
 
     //Generate windowed impulse response - invert fft coeeficients to time domain
-    Eigen::FFT<double> fft;
-    fft.SetFlag(fft.HalfSpectrum);
-
-    //invert to time domain and
-    fft.inv(m_dCoeffA, filterFreqResp);/*
+    FFTService::inv(m_dCoeffA, filterFreqResp, fftLength);/*
     m_dCoeffA = m_dCoeffA.segment(0,1024).eval();
 
     //window/zero-pad m_dCoeffA to m_iFFTlength
@@ -166,7 +152,7 @@ CosineFilter::CosineFilter(int fftLength, float lowpass, float lowpass_width, fl
 
     //fft-transform filter coeffs
     m_dFFTCoeffA = RowVectorXcd::Zero(fftLength);
-    fft.fwd(m_dFFTCoeffA,t_coeffAzeroPad);*/
+    FFTService::fwd(m_dFFTCoeffA, t_coeffAzeroPad);*/
 }
 
 
@@ -43,6 +43,7 @@
 #include "filterdata.h"
 
 #include "../mnemath.h"
+#include "../fftservice.h"
 
 #include "parksmcclellan.h"
 #include "cosinefilter.h"
@@ -70,10 +71,6 @@
 //=============================================================================================================
 
 #include <Eigen/SparseCore>
-//#ifndef EIGEN_FFTW_DEFAULT
-//#define EIGEN_FFTW_DEFAULT
-//#endif
-#include <unsupported/Eigen/FFT>
 
 
 //*************************************************************************************************************
@@ -213,13 +210,8 @@ void FilterData::fftTransformCoeffs()
     RowVectorXd t_coeffAzeroPad = RowVectorXd::Zero(m_iFFTlength);
     t_coeffAzeroPad.head(m_dCoeffA.cols()) = m_dCoeffA;
 
-    //generate fft object
-    Eigen::FFT<double> fft;
-    fft.SetFlag(fft.HalfSpectrum);
-
     //fft-transform filter coeffs
-    m_dFFTCoeffA = RowVectorXcd::Zero(m_iFFTlength);
-    fft.fwd(m_dFFTCoeffA,t_coeffAzeroPad);
+    FFTService::fwd(m_dFFTCoeffA, t_coeffAzeroPad);
 }
 
 
@@ -300,20 +292,16 @@ RowVectorXd FilterData::applyFFTFilter(const RowVectorXd& data, bool keepOverhea
             break;
     }
 
-    //generate fft object
-    Eigen::FFT<double> fft;
-    fft.SetFlag(fft.HalfSpectrum);
-
-    //fft-transform data sequence
+    //fft-transform data sequence, the plan for m_iFFTlength is cached by the FFT service
     RowVectorXcd t_freqData;
-    fft.fwd(t_freqData,t_dataZeroPad);
+    FFTService::fwd(t_freqData, t_dataZeroPad);
 
     //perform frequency-domain filtering
     RowVectorXcd t_filteredFreq = m_dFFTCoeffA.array()*t_freqData.array();
 
     //inverse-FFT
     RowVectorXd t_filteredTime;
-    fft.inv(t_filteredTime,t_filteredFreq);
+    FFTService::inv(t_filteredTime, t_filteredFreq, m_iFFTlength);
 
     //Return filtered data
     if(!keepOverhead)
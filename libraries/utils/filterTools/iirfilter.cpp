@@ -0,0 +1,730 @@
+//=============================================================================================================
+/**
+* @file     iirfilter.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     Definition of the IirFilter class.
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "iirfilter.h"
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <vector>
+#include <algorithm>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QDebug>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace UTILSLIB;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE GLOBAL METHODS
+//=============================================================================================================
+
+namespace {
+
+typedef std::complex<double> Complex;
+
+//=============================================================================================================
+/**
+* Zeros, poles and gain of a filter. Used during the design only.
+*/
+struct ZeroPoleGain {
+    std::vector<Complex>    zeros;
+    std::vector<Complex>    poles;
+    double                  gain;
+};
+
+//*************************************************************************************************************
+
+Complex product(const std::vector<Complex>& values, Complex offset)
+{
+    //Computes prod(offset - values)
+    Complex result(1.0, 0.0);
+
+    for(size_t i = 0; i < values.size(); ++i) {
+        result *= offset - values[i];
+    }
+
+    return result;
+}
+
+
+//*************************************************************************************************************
+
+ZeroPoleGain analogPrototype(IirFilter::DesignMethod designMethod, int iOrder, double dRipple)
+{
+    //Low pass prototype with a cut off frequency of 1 rad/s
+    ZeroPoleGain zpk;
+    zpk.gain = 1.0;
+
+    switch(designMethod) {
+        case IirFilter::Chebyshev: {
+            double dEps = std::sqrt(std::pow(10.0, 0.1 * dRipple) - 1.0);
+            double dMu = std::asinh(1.0 / dEps) / iOrder;
+
+            for(int k = 0; k < iOrder; ++k) {
+                double dTheta = M_PI * (2 * k + 1) / (2.0 * iOrder);
+                zpk.poles.push_back(Complex(-std::sinh(dMu) * std::sin(dTheta), std::cosh(dMu) * std::cos(dTheta)));
+            }
+
+            zpk.gain = std::real(product(zpk.poles, Complex(0.0, 0.0)));
+
+            //Even orders have their DC gain at the bottom of the ripple
+            if(iOrder % 2 == 0) {
+                zpk.gain /= std::sqrt(1.0 + dEps * dEps);
+            }
+
+            break;
+        }
+
+        default: {
+            for(int k = 0; k < iOrder; ++k) {
+                zpk.poles.push_back(std::exp(Complex(0.0, M_PI * (2 * k + iOrder + 1) / (2.0 * iOrder))));
+            }
+
+            break;
+        }
+    }
+
+    return zpk;
+}
+
+
+//*************************************************************************************************************
+
+std::vector<Complex> transformRoots(const std::vector<Complex>& roots, FilterData::FilterType type, double dWo, double dBw)
+{
+    //Frequency transformation of the roots of the low pass prototype
+    std::vector<Complex> result;
+
+    for(size_t i = 0; i < roots.size(); ++i) {
+        switch(type) {
+            case FilterData::HPF:
+                result.push_back(dWo / roots[i]);
+                break;
+
+            case FilterData::BPF: {
+                Complex lp = roots[i] * dBw / 2.0;
+                Complex root = std::sqrt(lp * lp - dWo * dWo);
+                result.push_back(lp + root);
+                result.push_back(lp - root);
+                break;
+            }
+
+            case FilterData::NOTCH: {
+                Complex hp = (dBw / 2.0) / roots[i];
+                Complex root = std::sqrt(hp * hp - dWo * dWo);
+                result.push_back(hp + root);
+                result.push_back(hp - root);
+                break;
+            }
+
+            default:
+                result.push_back(roots[i] * dWo);
+                break;
+        }
+    }
+
+    return result;
+}
+
+
+//*************************************************************************************************************
+
+ZeroPoleGain transformPrototype(const ZeroPoleGain& prototype, FilterData::FilterType type, double dWo, double dBw)
+{
+    ZeroPoleGain zpk;
+    zpk.zeros = transformRoots(prototype.zeros, type, dWo, dBw);
+    zpk.poles = transformRoots(prototype.poles, type, dWo, dBw);
+
+    const int iDegree = prototype.poles.size() - prototype.zeros.size();
+
+    switch(type) {
+        case FilterData::HPF:
+            zpk.zeros.insert(zpk.zeros.end(), iDegree, Complex(0.0, 0.0));
+            zpk.gain = prototype.gain * std::real(product(prototype.zeros, 0.0) / product(prototype.poles, 0.0));
+            break;
+
+        case FilterData::BPF:
+            zpk.zeros.insert(zpk.zeros.end(), iDegree, Complex(0.0, 0.0));
+            zpk.gain = prototype.gain * std::pow(dBw, iDegree);
+            break;
+
+        case FilterData::NOTCH:
+            for(int i = 0; i < iDegree; ++i) {
+                zpk.zeros.push_back(Complex(0.0, dWo));
+                zpk.zeros.push_back(Complex(0.0, -dWo));
+            }
+            zpk.gain = prototype.gain * std::real(product(prototype.zeros, 0.0) / product(prototype.poles, 0.0));
+            break;
+
+        default:
+            zpk.gain = prototype.gain * std::pow(dWo, iDegree);
+            break;
+    }
+
+    return zpk;
+}
+
+
+//*************************************************************************************************************
+
+ZeroPoleGain bilinearTransform(const ZeroPoleGain& analog, double dSFreq)
+{
+    const double dFs2 = 2.0 * dSFreq;
+    ZeroPoleGain zpk;
+
+    for(size_t i = 0; i < analog.zeros.size(); ++i) {
+        zpk.zeros.push_back((dFs2 + analog.zeros[i]) / (dFs2 - analog.zeros[i]));
+    }
+
+    for(size_t i = 0; i < analog.poles.size(); ++i) {
+        zpk.poles.push_back((dFs2 + analog.poles[i]) / (dFs2 - analog.poles[i]));
+    }
+
+    //Zeros at infinity are mapped to the Nyquist frequency
+    zpk.zeros.insert(zpk.zeros.end(), analog.poles.size() - analog.zeros.size(), Complex(-1.0, 0.0));
+
+    zpk.gain = analog.gain * std::real(product(analog.zeros, dFs2) / product(analog.poles, dFs2));
+
+    return zpk;
+}
+
+
+//*************************************************************************************************************
+
+void splitRoots(const std::vector<Complex>& roots, std::vector<Complex>& complexRoots, std::vector<double>& realRoots)
+{
+    //Keep one root of each conjugate pair
+    const double dTolerance = 1e-10;
+
+    for(size_t i = 0; i < roots.size(); ++i) {
+        if(std::fabs(roots[i].imag()) <= dTolerance * std::max(1.0, std::abs(roots[i]))) {
+            realRoots.push_back(roots[i].real());
+        } else if(roots[i].imag() > 0.0) {
+            complexRoots.push_back(roots[i]);
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd zeroPoleGainToSos(const ZeroPoleGain& zpk)
+{
+    std::vector<Complex> complexPoles, complexZeros;
+    std::vector<double> realPoles, realZeros;
+
+    splitRoots(zpk.poles, complexPoles, realPoles);
+    splitRoots(zpk.zeros, complexZeros, realZeros);
+
+    //Group the poles into sections: each complex conjugate pair and each pair of real poles. An odd number of
+    //real poles leaves one first-order section.
+    std::sort(realPoles.begin(), realPoles.end());
+
+    std::vector<std::vector<Complex> > lPoleGroups;
+
+    for(size_t i = 0; i < complexPoles.size(); ++i) {
+        lPoleGroups.push_back(std::vector<Complex>(1, complexPoles[i]));
+    }
+
+    for(size_t i = 0; i < realPoles.size(); i += 2) {
+        std::vector<Complex> group(1, Complex(realPoles[i], 0.0));
+
+        if(i + 1 < realPoles.size()) {
+            group.push_back(Complex(realPoles[i + 1], 0.0));
+        }
+
+        lPoleGroups.push_back(group);
+    }
+
+    //Start with the poles farthest from the unit circle, the resonant sections come last
+    std::sort(lPoleGroups.begin(), lPoleGroups.end(), [](const std::vector<Complex>& a, const std::vector<Complex>& b) {
+        return std::abs(a.front()) < std::abs(b.front());
+    });
+
+    MatrixXd matSos = MatrixXd::Zero(lPoleGroups.size(), 6);
+
+    for(size_t s = 0; s < lPoleGroups.size(); ++s) {
+        const std::vector<Complex>& poles = lPoleGroups[s];
+        const bool bComplexPole = poles.front().imag() != 0.0;
+        const Complex reference = poles.front();
+
+        //Denominator
+        matSos(s, 3) = 1.0;
+
+        if(bComplexPole) {
+            matSos(s, 4) = -2.0 * reference.real();
+            matSos(s, 5) = std::norm(reference);
+        } else if(poles.size() == 2) {
+            matSos(s, 4) = -(poles[0].real() + poles[1].real());
+            matSos(s, 5) = poles[0].real() * poles[1].real();
+        } else {
+            matSos(s, 4) = -poles[0].real();
+        }
+
+        //Numerator with the zeros closest to the poles of this section
+        matSos(s, 0) = 1.0;
+
+        const int iOrder = bComplexPole ? 2 : poles.size();
+
+        if(iOrder == 2 && !complexZeros.empty() && (bComplexPole || realZeros.size() < 2)) {
+            std::vector<Complex>::iterator itZero = std::min_element(complexZeros.begin(), complexZeros.end(), [&reference](const Complex& a, const Complex& b) {
+                return std::abs(a - reference) < std::abs(b - reference);
+            });
+
+            matSos(s, 1) = -2.0 * itZero->real();
+            matSos(s, 2) = std::norm(*itZero);
+            complexZeros.erase(itZero);
+        } else {
+            double dZeros[2] = {0.0, 0.0};
+            int iNumZeros = 0;
+
+            for(; iNumZeros < iOrder && !realZeros.empty(); ++iNumZeros) {
+                std::vector<double>::iterator itZero = std::min_element(realZeros.begin(), realZeros.end(), [&reference](double a, double b) {
+                    return std::abs(a - reference) < std::abs(b - reference);
+                });
+
+                dZeros[iNumZeros] = *itZero;
+                realZeros.erase(itZero);
+            }
+
+            matSos(s, 1) = -(dZeros[0] + dZeros[1]);
+            matSos(s, 2) = dZeros[0] * dZeros[1];
+        }
+    }
+
+    //Put the overall gain into the first section
+    matSos.block(0, 0, 1, 3) *= zpk.gain;
+
+    return matSos;
+}
+
+} // NAMESPACE
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE MEMBER METHODS
+//=============================================================================================================
+
+IirFilter::IirFilter()
+: m_designMethod(Butterworth)
+, m_Type(FilterData::UNKNOWN)
+, m_sFreq(1000)
+, m_iFilterOrder(0)
+, m_dCenterFreq(0.5)
+, m_dBandwidth(0.1)
+, m_dRipple(1.0)
+, m_dLowpassFreq(0)
+, m_dHighpassFreq(0)
+, m_sName("Unknown")
+{
+    //Identity section
+    m_matSos = MatrixXd::Zero(1, 6);
+    m_matSos(0, 0) = 1.0;
+    m_matSos(0, 3) = 1.0;
+}
+
+
+//*************************************************************************************************************
+
+IirFilter::IirFilter(const QString& sName,
+                     FilterData::FilterType type,
+                     int iOrder,
+                     double dCenterFreq,
+                     double dBandwidth,
+                     double dSFreq,
+                     DesignMethod designMethod,
+                     double dRipple)
+: m_designMethod(designMethod)
+, m_Type(type)
+, m_sFreq(dSFreq)
+, m_iFilterOrder(iOrder)
+, m_dCenterFreq(dCenterFreq)
+, m_dBandwidth(dBandwidth)
+, m_dRipple(dRipple)
+, m_dLowpassFreq(0)
+, m_dHighpassFreq(0)
+, m_sName(sName)
+{
+    designFilter();
+}
+
+
+//*************************************************************************************************************
+
+void IirFilter::designFilter()
+{
+    reset();
+
+    m_matSos = MatrixXd::Zero(1, 6);
+    m_matSos(0, 0) = 1.0;
+    m_matSos(0, 3) = 1.0;
+
+    switch(m_Type) {
+        case FilterData::LPF:
+            m_dLowpassFreq = 0;
+            m_dHighpassFreq = m_dCenterFreq*(m_sFreq/2);
+        break;
+
+        case FilterData::HPF:
+            m_dLowpassFreq = m_dCenterFreq*(m_sFreq/2);
+            m_dHighpassFreq = 0;
+        break;
+
+        case FilterData::BPF:
+        case FilterData::NOTCH:
+            m_dLowpassFreq = (m_dCenterFreq + m_dBandwidth/2)*(m_sFreq/2);
+            m_dHighpassFreq = (m_dCenterFreq - m_dBandwidth/2)*(m_sFreq/2);
+        break;
+
+        default:
+            qDebug() << "IirFilter::designFilter - Unknown filter type. Returning ...";
+            return;
+    }
+
+    if(m_dCenterFreq <= 0.0 || m_dCenterFreq >= 1.0) {
+        qDebug() << "IirFilter::designFilter - Center frequency must lie between 0 and the Nyquist frequency. Returning ...";
+        return;
+    }
+
+    if(m_designMethod == Notch) {
+        //Single second-order notch section (RBJ audio EQ cookbook) with the bandwidth as its -3 dB width
+        if(m_Type != FilterData::NOTCH) {
+            qDebug() << "IirFilter::designFilter - The notch design method only supports the NOTCH filter type. Returning ...";
+            return;
+        }
+
+        const double dW0 = M_PI * m_dCenterFreq;
+        const double dQ = m_dCenterFreq / std::max(m_dBandwidth, 1e-6);
+        const double dAlpha = std::sin(dW0) / (2.0 * dQ);
+        const double dA0 = 1.0 + dAlpha;
+
+        m_matSos(0, 0) = 1.0 / dA0;
+        m_matSos(0, 1) = -2.0 * std::cos(dW0) / dA0;
+        m_matSos(0, 2) = 1.0 / dA0;
+        m_matSos(0, 3) = 1.0;
+        m_matSos(0, 4) = -2.0 * std::cos(dW0) / dA0;
+        m_matSos(0, 5) = (1.0 - dAlpha) / dA0;
+
+        return;
+    }
+
+    if(m_iFilterOrder < 1) {
+        qDebug() << "IirFilter::designFilter - Filter order must be at least 1. Returning ...";
+        return;
+    }
+
+    //Pre-warp the frequencies of the analog filter for the bilinear transform
+    double dWo, dBw;
+
+    if(m_Type == FilterData::LPF || m_Type == FilterData::HPF) {
+        dWo = 2.0 * m_sFreq * std::tan(M_PI * m_dCenterFreq / 2.0);
+        dBw = 0.0;
+    } else {
+        const double dLow = std::max(m_dCenterFreq - m_dBandwidth/2, 1e-6);
+        const double dHigh = std::min(m_dCenterFreq + m_dBandwidth/2, 1.0 - 1e-6);
+        const double dWLow = 2.0 * m_sFreq * std::tan(M_PI * dLow / 2.0);
+        const double dWHigh = 2.0 * m_sFreq * std::tan(M_PI * dHigh / 2.0);
+
+        dWo = std::sqrt(dWLow * dWHigh);
+        dBw = dWHigh - dWLow;
+    }
+
+    ZeroPoleGain zpk = analogPrototype(m_designMethod, m_iFilterOrder, m_dRipple);
+    zpk = transformPrototype(zpk, m_Type, dWo, dBw);
+    zpk = bilinearTransform(zpk, m_sFreq);
+
+    m_matSos = zeroPoleGainToSos(zpk);
+}
+
+
+//*************************************************************************************************************
+
+void IirFilter::reset()
+{
+    m_matState.resize(0, 0);
+}
+
+
+//*************************************************************************************************************
+
+void IirFilter::filterBlock(MatrixXd& matData)
+{
+    if(matData.cols() == 0) {
+        return;
+    }
+
+    if(m_matState.rows() != matData.rows() || m_matState.cols() != 2 * m_matSos.rows()) {
+        initState(matData.col(0), m_matState);
+    }
+
+    filterSections(matData, m_matState);
+}
+
+
+//*************************************************************************************************************
+
+int IirFilter::getSettlingLength(double dTolerance) const
+{
+    if(m_matSos.rows() == 0) {
+        return 0;
+    }
+
+    //Run the step response in chunks until a whole chunk stays within the tolerance of its final value, i.e. the
+    //DC gain. In contrast to the impulse response the initial spike of high pass filters does not hide the tail.
+    //Cap it at one minute of data.
+    const int iChunk = 256;
+    const int iMaxLength = std::max(iChunk, (int)(60.0 * m_sFreq));
+    const double dFinal = getFrequencyResponse(0.0).real();
+
+    MatrixXd matState = MatrixXd::Zero(1, 2 * m_matSos.rows());
+    MatrixXd matChunk;
+
+    double dPeak = std::abs(dFinal);
+    int iLength = 0;
+
+    while(iLength < iMaxLength) {
+        matChunk = MatrixXd::Ones(1, iChunk);
+        filterSections(matChunk, matState);
+
+        dPeak = std::max(dPeak, matChunk.cwiseAbs().maxCoeff());
+
+        if((matChunk.array() - dFinal).abs().maxCoeff() < dTolerance * dPeak) {
+            break;
+        }
+
+        iLength += iChunk;
+    }
+
+    return std::min(iLength, iMaxLength);
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd IirFilter::applyZeroPhaseFilter(const MatrixXd& matData,
+                                         int iPadLength,
+                                         PaddingMode padding) const
+{
+    if(iPadLength < 0) {
+        iPadLength = getSettlingLength();
+    }
+
+    if(matData.cols() < 1) {
+        return matData;
+    }
+
+    //The odd reflection needs data to reflect, a single sample is filtered without padding
+    const int iPad = padding == ReflectPadding ? std::min(iPadLength, (int)matData.cols() - 1) : iPadLength;
+
+    MatrixXd matExtended = MatrixXd::Zero(matData.rows(), matData.cols() + 2 * iPad);
+    matExtended.block(0, iPad, matData.rows(), matData.cols()) = matData;
+
+    if(padding == ReflectPadding && iPad > 0) {
+        matExtended.block(0, 0, matData.rows(), iPad) = (2.0 * matData.col(0)).replicate(1, iPad) - matData.block(0, 1, matData.rows(), iPad).rowwise().reverse();
+        matExtended.block(0, iPad + matData.cols(), matData.rows(), iPad) = (2.0 * matData.col(matData.cols() - 1)).replicate(1, iPad) - matData.block(0, matData.cols() - 1 - iPad, matData.rows(), iPad).rowwise().reverse();
+    }
+
+    //With zero padding both passes start from rest, also when there is no padding, otherwise from the steady state
+    //of the first sample
+    const MatrixXd matRest = MatrixXd::Zero(matData.rows(), 2 * m_matSos.rows());
+    MatrixXd matState;
+
+    //Forward
+    if(padding == ZeroPadding) {
+        matState = matRest;
+    } else {
+        initState(matExtended.col(0), matState);
+    }
+    filterSections(matExtended, matState);
+
+    //Backward
+    matExtended = matExtended.rowwise().reverse().eval();
+    if(padding == ZeroPadding) {
+        matState = matRest;
+    } else {
+        initState(matExtended.col(0), matState);
+    }
+    filterSections(matExtended, matState);
+
+    return matExtended.block(0, iPad, matData.rows(), matData.cols()).rowwise().reverse();
+}
+
+
+//*************************************************************************************************************
+
+RowVectorXd IirFilter::applyZeroPhaseFilter(const RowVectorXd& data,
+                                            int iPadLength,
+                                            PaddingMode padding) const
+{
+    MatrixXd matData = data;
+    return applyZeroPhaseFilter(matData, iPadLength, padding).row(0);
+}
+
+
+//*************************************************************************************************************
+
+std::complex<double> IirFilter::getFrequencyResponse(double dFreq) const
+{
+    const std::complex<double> z1 = std::exp(std::complex<double>(0.0, -2.0 * M_PI * dFreq / m_sFreq));
+    const std::complex<double> z2 = z1 * z1;
+    std::complex<double> response(1.0, 0.0);
+
+    for(int s = 0; s < m_matSos.rows(); ++s) {
+        response *= (m_matSos(s, 0) + m_matSos(s, 1) * z1 + m_matSos(s, 2) * z2)
+                    / (m_matSos(s, 3) + m_matSos(s, 4) * z1 + m_matSos(s, 5) * z2);
+    }
+
+    return response;
+}
+
+
+//*************************************************************************************************************
+
+double IirFilter::getGroupDelay(double dFreq) const
+{
+    //Numerical derivative of the phase, the ratio avoids unwrapping
+    const double dDeltaFreq = 1e-4 * m_sFreq;
+    const double dDeltaOmega = 2.0 * M_PI * 2.0 * dDeltaFreq / m_sFreq;
+
+    return -std::arg(getFrequencyResponse(dFreq + dDeltaFreq) / getFrequencyResponse(dFreq - dDeltaFreq)) / dDeltaOmega;
+}
+
+
+//*************************************************************************************************************
+
+QString IirFilter::getStringForDesignMethod(const IirFilter::DesignMethod &designMethod)
+{
+    QString designMethodString = "Butterworth";
+
+    if(designMethod == IirFilter::Chebyshev)
+        designMethodString = "Chebyshev";
+
+    if(designMethod == IirFilter::Notch)
+        designMethodString = "Notch";
+
+    return designMethodString;
+}
+
+
+//*************************************************************************************************************
+
+IirFilter::DesignMethod IirFilter::getDesignMethodForString(const QString &designMethodString)
+{
+    IirFilter::DesignMethod designMethod = IirFilter::Butterworth;
+
+    if(designMethodString == "Chebyshev")
+        designMethod = IirFilter::Chebyshev;
+
+    if(designMethodString == "Notch")
+        designMethod = IirFilter::Notch;
+
+    return designMethod;
+}
+
+
+//*************************************************************************************************************
+
+void IirFilter::initState(const VectorXd& vecSample, MatrixXd& matState) const
+{
+    //Steady state of the transposed direct form II for a constant input x: y = g*x, z1 = y - b0*x, z2 = b2*x - a2*y
+    matState.resize(vecSample.rows(), 2 * m_matSos.rows());
+
+    ArrayXd x = vecSample.array();
+
+    for(int s = 0; s < m_matSos.rows(); ++s) {
+        const double dDenominator = m_matSos(s, 3) + m_matSos(s, 4) + m_matSos(s, 5);
+        const double dGain = dDenominator != 0.0 ? (m_matSos(s, 0) + m_matSos(s, 1) + m_matSos(s, 2)) / dDenominator : 0.0;
+        const ArrayXd y = dGain * x;
+
+        matState.col(2 * s) = y - m_matSos(s, 0) * x;
+        matState.col(2 * s + 1) = m_matSos(s, 2) * x - m_matSos(s, 5) * y;
+
+        x = y;
+    }
+}
+
+
+//*************************************************************************************************************
+
+void IirFilter::filterSections(MatrixXd& matData, MatrixXd& matState) const
+{
+    //Each column holds one time point of all channels. All operations run over the channels and are vectorized.
+    const int iNumChannels = matData.rows();
+    ArrayXd x(iNumChannels);
+    ArrayXd y(iNumChannels);
+
+    for(int t = 0; t < matData.cols(); ++t) {
+        x = matData.col(t).array();
+
+        for(int s = 0; s < m_matSos.rows(); ++s) {
+            const double b0 = m_matSos(s, 0), b1 = m_matSos(s, 1), b2 = m_matSos(s, 2);
+            const double a1 = m_matSos(s, 4), a2 = m_matSos(s, 5);
+
+            //Transposed direct form II, z1 and z2 are the two delay elements of this section
+            y = b0 * x + matState.col(2 * s).array();
+            matState.col(2 * s).array() = b1 * x - a1 * y + matState.col(2 * s + 1).array();
+            matState.col(2 * s + 1).array() = b2 * x - a2 * y;
+
+            x.swap(y);
+        }
+
+        matData.col(t) = x.matrix();
+    }
+}
@@ -0,0 +1,292 @@
+//=============================================================================================================
+/**
+* @file     iirfilter.h
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief     Declaration of the IirFilter class.
+*
+*/
+
+#ifndef IIRFILTER_H
+#define IIRFILTER_H
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include "../utils_global.h"
+#include "filterdata.h"
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Eigen INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// Qt INCLUDES
+//=============================================================================================================
+
+#include <QString>
+#include <QSharedPointer>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <complex>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINE NAMESPACE UTILSLIB
+//=============================================================================================================
+
+namespace UTILSLIB
+{
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* IIR filter realized as a cascade of second-order sections (biquads). In contrast to the FIR filters of
+* FilterData, whose group delay is half the number of taps, the delay of an IIR filter is in the order of a few
+* samples, which makes it suited for closed-loop applications. The filter is designed from an analog Butterworth
+* or Chebyshev type I prototype via the bilinear transform, or as a single notch section.
+*
+* Each row of the coefficient matrix holds one section [b0 b1 b2 a0 a1 a2] with a0 = 1. The sections are run in
+* transposed direct form II. Data is passed as channels x samples, so that each column, i.e. one time point of all
+* channels, is contiguous in memory and the inner loop runs vectorized over the channels.
+*
+* @brief IIR filter in second-order sections with streaming and zero-phase application.
+*/
+class UTILSSHARED_EXPORT IirFilter
+{
+
+public:
+    typedef QSharedPointer<IirFilter> SPtr;             /**< Shared pointer type for IirFilter. */
+    typedef QSharedPointer<const IirFilter> ConstSPtr;  /**< Const shared pointer type for IirFilter. */
+
+    enum DesignMethod {
+        Butterworth,
+        Chebyshev,
+        Notch
+    };
+
+    enum PaddingMode {
+        ReflectPadding,
+        ZeroPadding
+    };
+
+    //=========================================================================================================
+    /**
+    * Constructs a default IirFilter object which passes the data unchanged.
+    */
+    IirFilter();
+
+    //=========================================================================================================
+    /**
+    * Constructs an IirFilter object. The frequencies are normalized to the Nyquist frequency as in FilterData.
+    *
+    * @param [in] sName             The name of the filter.
+    * @param [in] type              The filter type: LPF, HPF, BPF or NOTCH.
+    * @param [in] iOrder            The order of the analog prototype. Band pass and band stop filters have twice this order. Ignored for the Notch design method.
+    * @param [in] dCenterFreq       The cut off frequency for LPF and HPF, the center frequency for BPF and NOTCH.
+    * @param [in] dBandwidth        Ignored for LPF and HPF. The width of the pass or stop band for BPF and NOTCH.
+    * @param [in] dSFreq            The sampling frequency.
+    * @param [in] designMethod      The design method: Butterworth, Chebyshev (type I) or Notch (single second-order section).
+    * @param [in] dRipple           The pass band ripple in dB. Only used for the Chebyshev design method.
+    */
+    IirFilter(const QString& sName,
+              FilterData::FilterType type,
+              int iOrder,
+              double dCenterFreq,
+              double dBandwidth,
+              double dSFreq,
+              DesignMethod designMethod = Butterworth,
+              double dRipple = 1.0);
+
+    //=========================================================================================================
+    /**
+    * Designs the second-order sections with the current parameters and resets the filter state.
+    */
+    void designFilter();
+
+    //=========================================================================================================
+    /**
+    * Clears the filter state. The state is initialized again with the steady state of the next sample passed to
+    * filterBlock, so that a constant offset does not cause a transient.
+    */
+    void reset();
+
+    //=========================================================================================================
+    /**
+    * Filters the next block of a continuous multi-channel stream. The filter state of each channel is kept
+    * between calls. The state is reset whenever the number of channels changes.
+    *
+    * @param [in, out] matData      The data block (channels x samples), filtered in place.
+    */
+    void filterBlock(MatrixXd& matData);
+
+    //=========================================================================================================
+    /**
+    * Returns the number of samples after which the step response of the filter stays within dTolerance times its
+    * peak of the final value. This is the length the data has to be padded with in applyZeroPhaseFilter to suppress the
+    * start-up transient, which can be several seconds for low high pass cut off frequencies.
+    *
+    * @param [in] dTolerance        The remaining deviation relative to the peak of the step response.
+    *
+    * @return The settling length in samples.
+    */
+    int getSettlingLength(double dTolerance = 1e-3) const;
+
+    //=========================================================================================================
+    /**
+    * Applies the filter forward and backward (zero-phase). The data is extended at both ends by iPadLength samples
+    * before filtering, which are cut off again afterwards. With ReflectPadding the extension is an odd reflection
+    * of the data, limited to the number of samples minus one, and the state is initialized with the steady state.
+    * With ZeroPadding the data is extended by zeros and both passes start from rest, i.e. the filter stays linear
+    * and time invariant, so that filtered segments can be combined by overlap-add. Not real-time capable.
+    *
+    * @param [in] matData           The data (channels x samples).
+    * @param [in] iPadLength        The number of samples to pad at each end. Negative values use getSettlingLength().
+    * @param [in] padding           The padding mode.
+    *
+    * @return The filtered data.
+    */
+    MatrixXd applyZeroPhaseFilter(const MatrixXd& matData,
+                                  int iPadLength = -1,
+                                  PaddingMode padding = ReflectPadding) const;
+
+    //=========================================================================================================
+    /**
+    * Applies the filter forward and backward (zero-phase) to a single channel.
+    *
+    * @param [in] data              The data.
+    * @param [in] iPadLength        The number of samples to pad at each end. Negative values use getSettlingLength().
+    * @param [in] padding           The padding mode.
+    *
+    * @return The filtered data.
+    */
+    RowVectorXd applyZeroPhaseFilter(const RowVectorXd& data,
+                                     int iPadLength = -1,
+                                     PaddingMode padding = ReflectPadding) const;
+
+    //=========================================================================================================
+    /**
+    * Returns the complex frequency response of the filter.
+    *
+    * @param [in] dFreq             The frequency in Hz.
+    *
+    * @return The frequency response.
+    */
+    std::complex<double> getFrequencyResponse(double dFreq) const;
+
+    //=========================================================================================================
+    /**
+    * Returns the group delay of the filter.
+    *
+    * @param [in] dFreq             The frequency in Hz.
+    *
+    * @return The group delay in samples.
+    */
+    double getGroupDelay(double dFreq) const;
+
+    //=========================================================================================================
+    /**
+    * Returns the current design method as a string.
+    */
+    static QString getStringForDesignMethod(const IirFilter::DesignMethod &designMethod);
+
+    //=========================================================================================================
+    /**
+    * Returns the design method dependent on an input string.
+    */
+    static IirFilter::DesignMethod getDesignMethodForString(const QString &designMethodString);
+
+    DesignMethod                m_designMethod;     /**< the design method. */
+    FilterData::FilterType      m_Type;             /**< the filter type. */
+
+    double          m_sFreq;            /**< the sampling frequency. */
+    int             m_iFilterOrder;     /**< the order of the analog prototype. */
+    double          m_dCenterFreq;      /**< contains center freq of the filter, normalized to the Nyquist frequency. */
+    double          m_dBandwidth;       /**< contains bandwidth of the filter, normalized to the Nyquist frequency. */
+    double          m_dRipple;          /**< the pass band ripple in dB of the Chebyshev design. */
+
+    double          m_dLowpassFreq;     /**< lowpass freq (higher cut off) of the filter. */
+    double          m_dHighpassFreq;    /**< highpass freq (lower cut off) of the filter. */
+
+    QString         m_sName;            /**< contains name of the filter. */
+
+    MatrixXd        m_matSos;           /**< the second-order sections, one [b0 b1 b2 a0 a1 a2] row per section. */
+
+protected:
+    //=========================================================================================================
+    /**
+    * Sets the state to the steady state response of each section to a constant input.
+    *
+    * @param [in] vecSample         The constant input, one value per channel.
+    * @param [out] matState         The state (channels x 2*sections).
+    */
+    void initState(const VectorXd& vecSample, MatrixXd& matState) const;
+
+    //=========================================================================================================
+    /**
+    * Runs the sections over the data in transposed direct form II.
+    *
+    * @param [in, out] matData      The data (channels x samples), filtered in place.
+    * @param [in, out] matState     The state (channels x 2*sections).
+    */
+    void filterSections(MatrixXd& matData, MatrixXd& matState) const;
+
+    MatrixXd        m_matState;         /**< the streaming state (channels x 2*sections): z1 and z2 of each section. */
+};
+
+} // NAMESPACE UTILSLIB
+
+#ifndef metatype_iirfilterdesign
+#define metatype_iirfilterdesign
+Q_DECLARE_METATYPE(UTILSLIB::IirFilter::DesignMethod)
+#endif
+
+#endif // IIRFILTER_H
@@ -47,6 +47,12 @@
 //=============================================================================================================
 
 #include <QDataStream>
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QFileInfo>
+#include <QDateTime>
+
+#include <cstring>
 
 
 //*************************************************************************************************************
@@ -87,13 +93,52 @@ VectorXi IOUtils::fread3_many(QDataStream &p_qStream, qint32 count)
 {
     VectorXi res(count);
 
+    //read all values at once instead of one stream access per value
+    QByteArray bytes(3*count, 0);
+    if(p_qStream.readRawData(bytes.data(), bytes.size()) != bytes.size()) {
+        res.setZero();
+        return res;
+    }
+
+    const unsigned char* data = (const unsigned char*)bytes.constData();
     for(qint32 i = 0; i < count; ++i)
-        res[i] = IOUtils::fread3(p_qStream);
+        res[i] = (data[3*i] << 16) + (data[3*i+1] << 8) + data[3*i+2];
 
     return res;
 }
 
 
+//*************************************************************************************************************
+
+QByteArray IOUtils::file_stamp_key(const QStringList& lFileNames)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    for(int i = 0; i < lFileNames.size(); ++i) {
+        QFileInfo fileInfo(lFileNames[i]);
+        hash.addData(fileInfo.absoluteFilePath().toUtf8());
+
+        if(fileInfo.exists())
+            hash.addData(QString("%1:%2").arg(fileInfo.size()).arg(fileInfo.lastModified().toMSecsSinceEpoch()).toUtf8());
+        else
+            hash.addData("missing");
+    }
+
+    return hash.result();
+}
+
+
+//*************************************************************************************************************
+
+void IOUtils::swap_shortp(qint16 *source, qint64 count)
+{
+    quint16 *usource = (quint16 *)(source);
+
+    for(qint64 i = 0; i < count; ++i)
+        usource[i] = (quint16)((usource[i] >> 8) | (usource[i] << 8));
+}
+
+
 //*************************************************************************************************************
 //fiff_combat
 qint16 IOUtils::swap_short(qint16 source)
@@ -225,6 +270,35 @@ void IOUtils::swap_floatp(float *source)
 }
 
 
+//*************************************************************************************************************
+
+void IOUtils::swap_intp(qint32 *source, qint64 count)
+{
+    quint32 *usource = (quint32 *)(source);
+
+    for(qint64 i = 0; i < count; ++i) {
+        quint32 v = usource[i];
+        usource[i] = (v >> 24) | ((v >> 8) & 0x0000ff00u) | ((v << 8) & 0x00ff0000u) | (v << 24);
+    }
+}
+
+
+//*************************************************************************************************************
+
+void IOUtils::swap_floatp(float *source, qint64 count)
+{
+    //go through memcpy instead of a reinterpreting pointer to not break strict aliasing - this is optimized away
+    char *csource = (char *)(source);
+
+    for(qint64 i = 0; i < count; ++i) {
+        quint32 v;
+        memcpy(&v, csource + 4*i, 4);
+        v = (v >> 24) | ((v >> 8) & 0x0000ff00u) | ((v << 8) & 0x00ff0000u) | (v << 24);
+        memcpy(csource + 4*i, &v, 4);
+    }
+}
+
+
 //*************************************************************************************************************
 
 void IOUtils::swap_doublep(double *source)
@@ -51,6 +51,7 @@
 
 #include <QSharedPointer>
 #include <QTextStream>
+#include <QDataStream>
 #include <QFile>
 #include <QDebug>
 
@@ -129,6 +130,26 @@ public:
     */
     static VectorXi fread3_many(QDataStream &p_qStream, qint32 count);
 
+    //=========================================================================================================
+    /**
+    * Returns a SHA-1 key over the absolute path, size and modification time of the given files, e.g., to check
+    * whether a binary cache of the parsed files is still valid.
+    *
+    * @param[in] lFileNames     The files to generate the key for. Missing files enter the key as missing.
+    *
+    * @return the key
+    */
+    static QByteArray file_stamp_key(const QStringList& lFileNames);
+
+    //=========================================================================================================
+    /**
+    * swap an array of shorts in place
+    *
+    * @param[in, out] source     shorts to swap
+    * @param[in] count           number of shorts
+    */
+    static void swap_shortp (qint16 *source, qint64 count);
+
     //=========================================================================================================
     /**
     * swap short
@@ -157,6 +178,16 @@ public:
     */
     static void swap_intp (qint32 *source);
 
+    //=========================================================================================================
+    /**
+    * swap an array of integers in place. The loop is written branch free on whole words, so that the compiler
+    * can vectorize it.
+    *
+    * @param[in, out] source     integers to swap
+    * @param[in] count           number of integers
+    */
+    static void swap_intp (qint32 *source, qint64 count);
+
     //=========================================================================================================
     /**
     * swap long
@@ -193,6 +224,15 @@ public:
     */
     static void swap_floatp (float *source);
 
+    //=========================================================================================================
+    /**
+    * swap an array of floats in place
+    *
+    * @param[in, out] source     floats to swap
+    * @param[in] count           number of floats
+    */
+    static void swap_floatp (float *source, qint64 count);
+
     //=========================================================================================================
     /**
     * swap double
@@ -229,6 +269,30 @@ public:
     template<typename T>
     static bool read_eigen_matrix(Matrix<T, Dynamic, 1>& out, const QString& path);
 
+    //=========================================================================================================
+    /**
+    * Write Eigen Matrix in binary form to a stream. The dimensions are written through the stream, the
+    * coefficients are written raw in native byte order and storage order, hence this is meant for caches
+    * which are read on the same machine.
+    *
+    * @param[in] in         input eigen value which is to be written to the stream
+    * @param[in] stream     stream to write to
+    */
+    template<typename T, int Rows, int Cols, int Options>
+    static void write_eigen_matrix(const Matrix<T, Rows, Cols, Options>& in, QDataStream& stream);
+
+    //=========================================================================================================
+    /**
+    * Read Eigen Matrix in binary form from a stream, which was written by write_eigen_matrix.
+    *
+    * @param[out] out       output eigen value
+    * @param[in] stream     stream to read from
+    *
+    * @return true if successful, false if the stream is corrupt or the dimensions do not fit the matrix type
+    */
+    template<typename T, int Rows, int Cols, int Options>
+    static bool read_eigen_matrix(Matrix<T, Rows, Cols, Options>& out, QDataStream& stream);
+
     //=========================================================================================================
     /**
     * Returns the new channel naming conventions (whitespcae between channel type and number) for the input list.
@@ -398,6 +462,41 @@ bool IOUtils::read_eigen_matrix(Matrix<T, Dynamic, Dynamic>& out, const QString&
     return true;
 }
 
+
+//*************************************************************************************************************
+
+template<typename T, int Rows, int Cols, int Options>
+void IOUtils::write_eigen_matrix(const Matrix<T, Rows, Cols, Options>& in, QDataStream& stream)
+{
+    stream << (qint64)in.rows() << (qint64)in.cols();
+    stream.writeRawData((const char*)in.data(), in.size()*sizeof(T));
+}
+
+
+//*************************************************************************************************************
+
+template<typename T, int Rows, int Cols, int Options>
+bool IOUtils::read_eigen_matrix(Matrix<T, Rows, Cols, Options>& out, QDataStream& stream)
+{
+    qint64 rows, cols;
+    stream >> rows >> cols;
+
+    if(stream.status() != QDataStream::Ok || rows < 0 || cols < 0
+            || (Rows != Dynamic && rows != Rows) || (Cols != Dynamic && cols != Cols)) {
+        return false;
+    }
+
+    //do not trust corrupt dimensions with the allocation
+    QIODevice* pDevice = stream.device();
+    if(pDevice && !pDevice->isSequential() && rows*cols*(qint64)sizeof(T) > pDevice->bytesAvailable())
+        return false;
+
+    out.resize(rows, cols);
+    qint64 size = rows*cols*sizeof(T);
+
+    return stream.readRawData((char*)out.data(), size) == size;
+}
+
 } // NAMESPACE
 
 #endif // IOUTILS_H
@@ -44,6 +44,7 @@
 //=============================================================================================================
 
 #include "adaptivemp.h"
+#include "../fftservice.h"
 
 
 //*************************************************************************************************************
@@ -61,7 +62,6 @@
 // Eigen INCLUDES
 //=============================================================================================================
 
-#include <unsupported/Eigen/FFT>
 #include <Eigen/SparseCore>
 
 
@@ -109,7 +109,6 @@ QList<QList<GaborAtom> > AdaptiveMp::matching_pursuit(MatrixXd signal, qint32 ma
     std::cout << "\nAdaptive Matching Pursuit Algorithm started...\n";
 
     max_it = max_iterations;
-    Eigen::FFT<double> fft;
     MatrixXd residuum = signal; //residuum initialised with signal
     qint32 sample_count = signal.rows();
     qint32 channel_count = signal.cols();
@@ -152,7 +151,7 @@ QList<QList<GaborAtom> > AdaptiveMp::matching_pursuit(MatrixXd signal, qint32 ma
             p = floor(sample_count / 2);         //translation
             VectorXd envelope = GaborAtom::gauss_function(sample_count, s, p);
             VectorXcd fft_envelope = RowVectorXcd::Zero(sample_count);
-            fft.fwd(fft_envelope, envelope);
+            FFTService::fwd(fft_envelope, envelope, false);
 
             while(k < sample_count/2)
             {
@@ -175,12 +174,12 @@ QList<QList<GaborAtom> > AdaptiveMp::matching_pursuit(MatrixXd signal, qint32 ma
                     for(qint32 l = 0; l< sample_count; l++)
                         modulated_resid[l] = residuum(l, chn) * modulation[l];
 
-                    fft.fwd(fft_modulated_resid, modulated_resid);
+                    FFTService::fwd(fft_modulated_resid, modulated_resid);
 
                     for( qint32 m = 0; m < sample_count; m++)
                         fft_m_e_resid[m] = fft_modulated_resid[m] * conj(fft_envelope[m]);
 
-                    fft.inv(corr_coeffs, fft_m_e_resid);
+                    FFTService::inv(corr_coeffs, fft_m_e_resid, sample_count);
                     maximum = corr_coeffs[0];
 
                     //find index of maximum correlation-coefficient to use in translation
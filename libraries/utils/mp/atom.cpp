@@ -62,7 +62,6 @@
 //=============================================================================================================
 
 #include <Eigen/SparseCore>
-#include <unsupported/Eigen/FFT>
 
 
 //*************************************************************************************************************
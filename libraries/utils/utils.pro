@@ -86,7 +86,10 @@ SOURCES += \
     filterTools/parksmcclellan.cpp \
     filterTools/filterdata.cpp \
     filterTools/filterio.cpp \
+    filterTools/iirfilter.cpp \
     detecttrigger.cpp \
+    eventdetector.cpp \
+    fftservice.cpp \
     spectrogram.cpp \
     warp.cpp \
     filterTools/sphara.cpp \
@@ -113,7 +116,10 @@ HEADERS += \
     filterTools/parksmcclellan.h \
     filterTools/filterdata.h \
     filterTools/filterio.h \
+    filterTools/iirfilter.h \
     detecttrigger.h \
+    eventdetector.h \
+    fftservice.h \
     spectrogram.h \
     warp.h \
     filterTools/sphara.h \
@@ -49,6 +49,9 @@ QMAKE_TARGET_COPYRIGHT = Copyright (C) 2016 Authors of mne-cpp. All rights reser
 ## Build MNE-CPP Deep library
 MNECPP_CONFIG += buildDeep
 
+## Use FFTW3 instead of the built-in kissfft as backend of UTILSLIB::FFTService, requires FFTW3 (double and float) to be installed
+#MNECPP_CONFIG += useFFTW
+
 #Build minimalVersion for qt versions <5.7.1
 !minQtVersion(5, 7, 1) {
     message("Building minimal version due to Qt version $${QT_VERSION}.")
@@ -122,3 +125,19 @@ MNE_BINARY_DIR = $$MNE_BINARY_DIR
 isEmpty( MNE_BINARY_DIR ) {
     MNE_BINARY_DIR = $${PWD}/bin
 }
+
+
+# FFTW3
+contains(MNECPP_CONFIG, useFFTW) {
+    # Switches all Eigen::FFT instances to FFTW, must be defined consistently for every project
+    DEFINES += EIGEN_FFTW_DEFAULT
+    FFTW_LIBRARY_DIR = $$FFTW_LIBRARY_DIR
+    !isEmpty( FFTW_LIBRARY_DIR ) {
+        LIBS += -L$${FFTW_LIBRARY_DIR}
+    }
+    FFTW_INCLUDE_DIR = $$FFTW_INCLUDE_DIR
+    !isEmpty( FFTW_INCLUDE_DIR ) {
+        INCLUDEPATH += $${FFTW_INCLUDE_DIR}
+    }
+    LIBS += -lfftw3 -lfftw3f
+}
@@ -41,6 +41,8 @@
 
 #include <inverse/dipoleFit/dipole_fit_settings.h>
 #include <inverse/dipoleFit/dipole_fit.h>
+#include <mne/c/mne_raw_data.h>
+#include <fiff/fiff_constants.h>
 
 
 //*************************************************************************************************************
@@ -51,12 +53,47 @@
 #include <QtTest>
 
 
+//*************************************************************************************************************
+//=============================================================================================================
+// EIGEN INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+#include <unsupported/Eigen/FFT>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// STL INCLUDES
+//=============================================================================================================
+
+#include <random>
+#include <vector>
+#include <complex>
+
+
 //*************************************************************************************************************
 //=============================================================================================================
 // USED NAMESPACES
 //=============================================================================================================
 
 using namespace INVERSELIB;
+using namespace MNELIB;
+using namespace Eigen;
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// DEFINES
+//=============================================================================================================
+
+#ifndef FAIL
+#define FAIL -1
+#endif
+
+#ifndef OK
+#define OK 0
+#endif
 
 
 //=============================================================================================================
@@ -77,15 +114,22 @@ private slots:
     void initTestCase();
     void dipoleFitSimple();
     void dipoleFitAdvanced();
+    void compareFftAnaSyn();
+    void compareFilteredRead();
+    void compareFilteredReadCached();
     void cleanupTestCase();
 
 private:
     void compareFit();
+    MatrixXd referenceFilter(MneRawData* raw, int firsts, int ns, VectorXd& inputMax);
 
     double epsilon;
 
     ECDSet m_ECDSet;
     ECDSet m_refECDSet;
+
+    QString         m_sRawName;     /**< The raw file which is read through the filter buffers. */
+    mneFilterDefRec m_filter;       /**< The lowpass used for the filtered reads. */
 };
 
 
@@ -94,6 +138,17 @@ private:
 TestDipoleFit::TestDipoleFit()
 : epsilon(0.000001)
 {
+    m_filter.filter_on          = true;
+    m_filter.size               = 1024;
+    m_filter.taper_size         = 512;
+    m_filter.highpass           = 0.0;
+    m_filter.highpass_width     = 0.0;
+    m_filter.lowpass            = 40.0;
+    m_filter.lowpass_width      = 10.0;
+    m_filter.eog_highpass       = m_filter.highpass;
+    m_filter.eog_highpass_width = m_filter.highpass_width;
+    m_filter.eog_lowpass        = m_filter.lowpass;
+    m_filter.eog_lowpass_width  = m_filter.lowpass_width;
 }
 
 
@@ -101,7 +156,7 @@ TestDipoleFit::TestDipoleFit()
 
 void TestDipoleFit::initTestCase()
 {
-
+    m_sRawName = QDir::currentPath()+"/mne-cpp-test-data/MEG/sample/sample_audvis_raw_short.fif";
 }
 
 
@@ -310,6 +365,249 @@ void TestDipoleFit::compareFit()
 }
 
 
+//*************************************************************************************************************
+
+void TestDipoleFit::compareFftAnaSyn()
+{
+    printf(">>>>>>>>>>>>>>>>>>>>>>>>> Compare FFT Analysis and Synthesis >>>>>>>>>>>>>>>>>>>>>>>>>\n");
+
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> distribution(-1.0f,1.0f);
+    FFT<double> fft;
+    fft.SetFlag(FFT<double>::HalfSpectrum);
+
+    QList<int> lengths = QList<int>() << 1 << 2 << 3 << 4 << 7 << 16 << 45 << 1000 << 1001 << 4096;
+
+    for (int i = 0; i < lengths.size(); ++i) {
+        int np = lengths[i];
+        std::vector<float> x(np);
+        std::vector<double> xd(np);
+        for (int k = 0; k < np; ++k) {
+            x[k] = distribution(generator);
+            xd[k] = x[k];
+        }
+        //
+        // Analysis: r0, r1, i1, r2, i2, ... and r(np/2) if np is even
+        //
+        std::vector<std::complex<double> > spectrum;
+        if (np == 1)
+            spectrum.assign(1,std::complex<double>(xd[0],0.0));
+        else
+            fft.fwd(spectrum,xd);
+
+        std::vector<float> data(x);
+        MneRawData::mne_fft_ana(data.data(),np,NULL);
+
+        double tol = 1e-6*np;
+        int p = 0;
+        QVERIFY(std::fabs(data[p++] - spectrum[0].real()) < tol);
+        for (int k = 1; k < (np+1)/2; ++k) {
+            QVERIFY(std::fabs(data[p++] - spectrum[k].real()) < tol);
+            QVERIFY(std::fabs(data[p++] - spectrum[k].imag()) < tol);
+        }
+        if (np % 2 == 0)
+            QVERIFY(std::fabs(data[p++] - spectrum[np/2].real()) < tol);
+        QVERIFY(p == np);
+        //
+        // Synthesis is normalized: syn(ana(x)) == x
+        //
+        MneRawData::mne_fft_syn(data.data(),np,NULL);
+        for (int k = 0; k < np; ++k)
+            QVERIFY(std::fabs(data[k] - x[k]) < 1e-5);
+    }
+
+    printf("<<<<<<<<<<<<<<<<<<<<<<<<< Compare FFT Analysis and Synthesis Finished <<<<<<<<<<<<<<<<<<<<<<<<<\n");
+}
+
+
+//*************************************************************************************************************
+
+void TestDipoleFit::compareFilteredRead()
+{
+    printf(">>>>>>>>>>>>>>>>>>>>>>>>> Compare Filtered Raw Read >>>>>>>>>>>>>>>>>>>>>>>>>\n");
+
+    MneRawData* raw = MneRawData::mne_raw_open_file(m_sRawName,true,false,&m_filter);
+    QVERIFY(raw != NULL);
+    QVERIFY(!(raw->comp && raw->comp->current));
+
+    int nchan = raw->info->nchan;
+    int np = m_filter.size + 2*m_filter.taper_size;
+    //
+    // A span which starts inside a filter buffer and crosses several of them
+    //
+    int firsts = raw->first_samp + m_filter.size/2 + 100;
+    int ns = 2*m_filter.size + 500;
+    QVERIFY(firsts + ns + np < raw->first_samp + raw->nsamp);
+
+    int nbuf = 0;
+    for (int k = 0; k < raw->nfilt_buf; ++k)
+        if (raw->filt_bufs[k].lasts >= firsts && raw->filt_bufs[k].firsts <= firsts + ns - 1)
+            nbuf++;
+    QVERIFY(nbuf >= 4);
+
+    MatrixXf filtered(ns,nchan);
+    std::vector<float*> picked(nchan);
+    for (int c = 0; c < nchan; ++c)
+        picked[c] = filtered.col(c).data();
+    QVERIFY(MneRawData::mne_raw_pick_data_filt(raw,NULL,firsts,ns,picked.data()) == OK);
+    //
+    // Compare with one linear convolution of the whole span
+    //
+    VectorXd inputMax;
+    MatrixXd reference = referenceFilter(raw,firsts,ns,inputMax);
+    QVERIFY(reference.rows() == nchan);
+
+    for (int c = 0; c < nchan; ++c) {
+        double diff = (filtered.col(c).cast<double>() - reference.row(c).transpose()).cwiseAbs().maxCoeff();
+        if (raw->info->chInfo[c].kind == FIFFV_STIM_CH)
+            QVERIFY(diff == 0.0);
+        else
+            QVERIFY(diff <= 5e-4*inputMax[c]);
+    }
+
+    delete raw;
+
+    printf("<<<<<<<<<<<<<<<<<<<<<<<<< Compare Filtered Raw Read Finished <<<<<<<<<<<<<<<<<<<<<<<<<\n");
+}
+
+
+//*************************************************************************************************************
+
+void TestDipoleFit::compareFilteredReadCached()
+{
+    printf(">>>>>>>>>>>>>>>>>>>>>>>>> Compare Cached Filtered Raw Read >>>>>>>>>>>>>>>>>>>>>>>>>\n");
+
+    MneRawData* raw = MneRawData::mne_raw_open_file(m_sRawName,true,false,&m_filter);
+    QVERIFY(raw != NULL);
+
+    int nchan = raw->info->nchan;
+    int np = m_filter.size + 2*m_filter.taper_size;
+    int ns = 2*m_filter.size + 500;
+    int firsts1 = raw->first_samp + m_filter.size/2 + 100;
+    int firsts2 = firsts1 + ns/2;
+    QVERIFY(firsts2 + ns + np < raw->first_samp + raw->nsamp);
+
+    MatrixXf first(ns,nchan), second(ns,nchan), again(ns,nchan);
+    std::vector<float*> pickedFirst(nchan), pickedSecond(nchan), pickedAgain(nchan);
+    for (int c = 0; c < nchan; ++c) {
+        pickedFirst[c] = first.col(c).data();
+        pickedSecond[c] = second.col(c).data();
+        pickedAgain[c] = again.col(c).data();
+    }
+    QVERIFY(MneRawData::mne_raw_pick_data_filt(raw,NULL,firsts1,ns,pickedFirst.data()) == OK);
+    //
+    // The buffers of the first request stay filtered in the ring
+    //
+    QList<int> used;
+    for (int k = 0; k < raw->nfilt_buf; ++k)
+        if (raw->filt_bufs[k].lasts >= firsts1 && raw->filt_bufs[k].firsts <= firsts1 + ns - 1)
+            used << k;
+    QVERIFY(used.size() >= 4);
+    for (int i = 0; i < used.size(); ++i) {
+        QVERIFY(raw->filt_bufs[used[i]].valid);
+        for (int c = 0; c < nchan; ++c)
+            QVERIFY(raw->filt_bufs[used[i]].ch_filtered[c]);
+    }
+    //
+    // An overlapping request and a repeated one give identical data
+    //
+    QVERIFY(MneRawData::mne_raw_pick_data_filt(raw,NULL,firsts2,ns,pickedSecond.data()) == OK);
+    QVERIFY(MneRawData::mne_raw_pick_data_filt(raw,NULL,firsts1,ns,pickedAgain.data()) == OK);
+
+    for (int i = 0; i < used.size(); ++i)
+        QVERIFY(raw->filt_bufs[used[i]].valid);
+
+    QVERIFY((second.topRows(ns - ns/2).array() == first.bottomRows(ns - ns/2).array()).all());
+    QVERIFY((again.array() == first.array()).all());
+
+    delete raw;
+
+    printf("<<<<<<<<<<<<<<<<<<<<<<<<< Compare Cached Filtered Raw Read Finished <<<<<<<<<<<<<<<<<<<<<<<<<\n");
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd TestDipoleFit::referenceFilter(MneRawData* raw, int firsts, int ns, VectorXd& inputMax)
+{
+    int nchan = raw->info->nchan;
+    int np = m_filter.size + 2*m_filter.taper_size;
+    int resp_size = np/2 + 1;
+    int k,s,c;
+    //
+    // The lowpass response of the filter buffers (cos^2 transition, no highpass)
+    //
+    float sfreq = raw->info->sfreq;
+    int lowpasss = ((resp_size-1)*m_filter.lowpass)/(0.5*sfreq);
+    int w = ((resp_size-1)*m_filter.lowpass_width)/(0.5*sfreq);
+    w = (w+1)/2;
+
+    std::vector<std::complex<double> > resp(resp_size,std::complex<double>(1.0,0.0));
+    for (k = -w+1, s = lowpasss-w+1; k < w; k++, s++) {
+        double cs = std::cos(M_PI/4.0*((double)k/w + 1.0));
+        resp[s] *= cs*cs;
+    }
+    for (; s < resp_size; s++)
+        resp[s] = 0.0;
+
+    FFT<double> fft;
+    fft.SetFlag(FFT<double>::HalfSpectrum);
+    std::vector<double> impulse;
+    fft.inv(impulse,resp,np);
+    //
+    // Linear convolution over the span and half a filter length on both sides
+    //
+    int start = firsts - np/2;
+    int len = ns + np;
+    int skip = std::max(0,raw->first_samp - start);
+    int nfft = 1;
+    while (nfft < len + np)
+        nfft *= 2;
+
+    std::vector<double> kernel(nfft,0.0);
+    for (k = 0; k < np; k++)
+        kernel[k < np/2 ? k : nfft - np + k] = impulse[k];
+    std::vector<std::complex<double> > kernelSpectrum;
+    fft.fwd(kernelSpectrum,kernel);
+
+    MatrixXf data(len - skip,nchan);
+    std::vector<float*> picked(nchan);
+    for (c = 0; c < nchan; c++)
+        picked[c] = data.col(c).data();
+    if (MneRawData::mne_raw_pick_data_proj(raw,NULL,start + skip,len - skip,picked.data()) == FAIL)
+        return MatrixXd();
+    //
+    // The dc offset is removed before filtering
+    //
+    std::vector<float> dc(raw->first_sample_val,raw->first_sample_val + nchan);
+    if (raw->proj)
+        MneProjOp::mne_proj_op_proj_vector(raw->proj,dc.data(),nchan,true);
+
+    MatrixXd result(nchan,ns);
+    inputMax = VectorXd::Zero(nchan);
+    std::vector<double> in(nfft),out;
+    std::vector<std::complex<double> > spectrum;
+    for (c = 0; c < nchan; c++) {
+        if (raw->info->chInfo[c].kind == FIFFV_STIM_CH) {
+            result.row(c) = data.col(c).segment(np/2 - skip,ns).cast<double>().transpose();
+            continue;
+        }
+        std::fill(in.begin(),in.end(),0.0);
+        for (s = skip; s < len; s++) {
+            in[s] = data(s - skip,c) - dc[c];
+            inputMax[c] = std::max(inputMax[c],std::fabs(in[s]));
+        }
+        fft.fwd(spectrum,in);
+        for (k = 0; k < (int)spectrum.size(); k++)
+            spectrum[k] *= kernelSpectrum[k];
+        fft.inv(out,spectrum,nfft);
+        for (s = 0; s < ns; s++)
+            result(c,s) = out[np/2 + s];
+    }
+    return result;
+}
+
+
 //*************************************************************************************************************
 
 void TestDipoleFit::cleanupTestCase()
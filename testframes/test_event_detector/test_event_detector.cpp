@@ -0,0 +1,383 @@
+//=============================================================================================================
+/**
+* @file     test_event_detector.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+* @brief    Test of the streaming trigger edge detection and the offline event index
+* @brief    Test of the IIR filter in second-order sections
+*
+*/
+
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+#include <utils/eventdetector.h>
+#include <fiff/fiff.h>
+#include <mne/mne_event_index.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// EIGEN INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace UTILSLIB;
+using namespace FIFFLIB;
+using namespace MNELIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestEventDetector
+*
+* @brief The TestEventDetector class checks the trigger edge detection across block boundaries and the event index
+*        of a raw file
+*
+*/
+class TestEventDetector: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestEventDetector();
+
+private slots:
+    void initTestCase();
+    void compareBlockBoundaryEdge();
+    void compareDeadTimeAcrossBlocks();
+    void compareResetOnGap();
+    void compareLevelAndGradient();
+    void compareChannelOrdering();
+    void compareEventIndex();
+    void cleanupTestCase();
+
+private:
+    //=========================================================================================================
+    /**
+    * Scans the data in consecutive blocks of the given size.
+    *
+    * @param[in] detector       The detector.
+    * @param[in] matData        The data, channels in rows.
+    * @param[in] iBlockSize     The number of samples per block.
+    *
+    * @return the edges of all blocks.
+    */
+    QVector<DetectedEvent> detectInBlocks(EventDetector& detector, const MatrixXd& matData, int iBlockSize) const;
+
+    QString     m_sRawFile;     /**< The raw file which is indexed. */
+};
+
+
+//*************************************************************************************************************
+
+TestEventDetector::TestEventDetector()
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestEventDetector::initTestCase()
+{
+    m_sRawFile = QDir::currentPath()+"/mne-cpp-test-data/MEG/sample/sample_audvis_raw_short.fif";
+}
+
+
+//*************************************************************************************************************
+
+void TestEventDetector::compareBlockBoundaryEdge()
+{
+    //One rising edge at sample 50, which is the first or last sample of a block for some of the splits
+    MatrixXd matData = MatrixXd::Zero(1, 100);
+    matData.rightCols(50).setOnes();
+
+    for(int iBlockSize = 1; iBlockSize <= 100; ++iBlockSize) {
+        EventDetector detector(QList<int>() << 0, 0.5, EventDetector::Level, EventDetector::Rising);
+        QVector<DetectedEvent> vecEvents = detectInBlocks(detector, matData, iBlockSize);
+
+        QCOMPARE(vecEvents.size(), 1);
+        QCOMPARE(vecEvents[0].iSample, qint64(50));
+        QCOMPARE(vecEvents[0].dBefore, 0.0);
+        QCOMPARE(vecEvents[0].dAfter, 1.0);
+        QCOMPARE(detector.nextSample(), qint64(100));
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestEventDetector::compareDeadTimeAcrossBlocks()
+{
+    //Short pulses at 10, 30, 60 and 120. The dead time after the first pulse covers the next two and spans
+    //two block boundaries.
+    MatrixXd matData = MatrixXd::Zero(1, 200);
+    QList<int> lPulses = QList<int>() << 10 << 30 << 60 << 120;
+    for(int i = 0; i < lPulses.size(); ++i) {
+        matData.block(0, lPulses[i], 1, 3).setOnes();
+    }
+
+    EventDetector detector(QList<int>() << 0, 0.5, EventDetector::Level, EventDetector::Rising, 55);
+    QVector<DetectedEvent> vecEvents = detectInBlocks(detector, matData, 25);
+
+    QCOMPARE(vecEvents.size(), 2);
+    QCOMPARE(vecEvents[0].iSample, qint64(10));
+    QCOMPARE(vecEvents[1].iSample, qint64(120));
+
+    //An edge right after the dead time is found again
+    EventDetector detectorShort(QList<int>() << 0, 0.5, EventDetector::Level, EventDetector::Rising, 19);
+    vecEvents = detectInBlocks(detectorShort, matData, 25);
+
+    QCOMPARE(vecEvents.size(), 4);
+
+    //The dead time in seconds is converted with the sampling frequency
+    EventDetector detectorSec(QList<int>() << 0, 0.5, EventDetector::Level, EventDetector::Rising);
+    detectorSec.setDeadTimeSec(0.02, 1000.0);
+    vecEvents = detectInBlocks(detectorSec, matData, 7);
+
+    QCOMPARE(vecEvents.size(), 3);
+    QCOMPARE(vecEvents[1].iSample, qint64(60));
+}
+
+
+//*************************************************************************************************************
+
+void TestEventDetector::compareResetOnGap()
+{
+    //The first block ends low with an edge inside the dead time, the next block starts high with another edge
+    MatrixXd matFirst = MatrixXd::Zero(1, 100);
+    matFirst.block(0, 90, 1, 5).setOnes();
+
+    MatrixXd matSecond = MatrixXd::Zero(1, 50);
+    matSecond.leftCols(3).setOnes();
+    matSecond.block(0, 10, 1, 3).setOnes();
+
+    //Contiguous: the boundary edge at 100 and the one at 110 are inside the dead time of the edge at 90
+    EventDetector detector(QList<int>() << 0, 0.5, EventDetector::Level, EventDetector::Rising, 1000);
+    QCOMPARE(detector.detect(matFirst, 0).size(), 1);
+    QCOMPARE(detector.detect(matSecond, 100).size(), 0);
+    QCOMPARE(detector.nextSample(), qint64(150));
+
+    //Without dead time the boundary edge of the contiguous block is found
+    EventDetector detectorNoDead(QList<int>() << 0, 0.5, EventDetector::Level, EventDetector::Rising);
+    QCOMPARE(detectorNoDead.detect(matFirst, 0).size(), 1);
+    QVector<DetectedEvent> vecEvents = detectorNoDead.detect(matSecond);
+    QCOMPARE(vecEvents.size(), 2);
+    QCOMPARE(vecEvents[0].iSample, qint64(100));
+    QCOMPARE(vecEvents[1].iSample, qint64(110));
+
+    //Not contiguous: the last sample and the dead time are forgotten, the block start is no edge
+    EventDetector detectorGap(QList<int>() << 0, 0.5, EventDetector::Level, EventDetector::Rising, 1000);
+    QCOMPARE(detectorGap.detect(matFirst, 0).size(), 1);
+    vecEvents = detectorGap.detect(matSecond, 500);
+    QCOMPARE(vecEvents.size(), 1);
+    QCOMPARE(vecEvents[0].iSample, qint64(510));
+    QCOMPARE(detectorGap.nextSample(), qint64(550));
+}
+
+
+//*************************************************************************************************************
+
+void TestEventDetector::compareLevelAndGradient()
+{
+    //A slow ramp across the threshold, a step which stays above it and a step down to zero
+    RowVectorXd vecSignal(16);
+    vecSignal << 0.0, 0.2, 0.4, 0.6, 0.8, 1.0, 1.0, 3.0, 3.0, 3.0, 0.0, 0.0, 0.3, 0.0, 0.0, 0.0;
+    MatrixXd matData = vecSignal;
+
+    EventDetector detector(QList<int>() << 0, 0.5, EventDetector::Level, EventDetector::Rising);
+    QVector<DetectedEvent> vecEvents = detector.detect(matData, 0);
+    QCOMPARE(vecEvents.size(), 1);
+    QCOMPARE(vecEvents[0].iSample, qint64(3));
+
+    detector.reset();
+    detector.setEdge(EventDetector::Level, EventDetector::Falling);
+    vecEvents = detector.detect(matData, 0);
+    QCOMPARE(vecEvents.size(), 1);
+    QCOMPARE(vecEvents[0].iSample, qint64(10));
+
+    //The ramp steps are below the threshold, the step from 1 to 3 is found although the level stays high
+    detector.reset();
+    detector.setEdge(EventDetector::Gradient, EventDetector::Rising);
+    vecEvents = detector.detect(matData, 0);
+    QCOMPARE(vecEvents.size(), 1);
+    QCOMPARE(vecEvents[0].iSample, qint64(7));
+    QCOMPARE(vecEvents[0].dBefore, 1.0);
+    QCOMPARE(vecEvents[0].dAfter, 3.0);
+
+    detector.reset();
+    detector.setEdge(EventDetector::Gradient, EventDetector::Falling);
+    vecEvents = detector.detect(matData, 0);
+    QCOMPARE(vecEvents.size(), 1);
+    QCOMPARE(vecEvents[0].iSample, qint64(10));
+
+    //A lower threshold also finds the small pulse and the ramp steps
+    detector.reset();
+    detector.setEdge(EventDetector::Gradient, EventDetector::Rising);
+    detector.setThreshold(0.15);
+    vecEvents = detector.detect(matData, 0);
+    QCOMPARE(vecEvents.size(), 7);
+}
+
+
+//*************************************************************************************************************
+
+void TestEventDetector::compareChannelOrdering()
+{
+    //Rows 3 and 1 are scanned in this order, the other rows carry edges which must be ignored
+    MatrixXd matData = MatrixXd::Zero(4, 40);
+    matData.block(0, 5, 1, 35).setConstant(7.0);
+    matData.block(2, 15, 1, 25).setConstant(7.0);
+    matData.block(1, 10, 1, 5).setConstant(2.0);
+    matData.block(1, 20, 1, 20).setConstant(4.0);
+    matData.block(3, 20, 1, 20).setConstant(1.0);
+
+    EventDetector detector(QList<int>() << 3 << 1, 0.5, EventDetector::Gradient, EventDetector::Rising);
+    QVector<DetectedEvent> vecEvents = detectInBlocks(detector, matData, 20);
+
+    //Ordered by sample, edges on the same sample by the position in the channel list
+    QCOMPARE(vecEvents.size(), 3);
+    QCOMPARE(vecEvents[0].iSample, qint64(10));
+    QCOMPARE(vecEvents[0].iChannel, 1);
+    QCOMPARE(vecEvents[0].dAfter, 2.0);
+    QCOMPARE(vecEvents[1].iSample, qint64(20));
+    QCOMPARE(vecEvents[1].iChannel, 0);
+    QCOMPARE(vecEvents[1].dAfter, 1.0);
+    QCOMPARE(vecEvents[2].iSample, qint64(20));
+    QCOMPARE(vecEvents[2].iChannel, 1);
+    QCOMPARE(vecEvents[2].dBefore, 0.0);
+    QCOMPARE(vecEvents[2].dAfter, 4.0);
+}
+
+
+//*************************************************************************************************************
+
+void TestEventDetector::compareEventIndex()
+{
+    MNEEventIndex eventIndex;
+    QVERIFY(MNEEventIndex::build(m_sRawFile, eventIndex));
+    QVERIFY(!eventIndex.isEmpty());
+
+    //Count the rising steps of every stim channel sample by sample over the whole file
+    QFile t_fileRaw(m_sRawFile);
+    FiffRawData raw(t_fileRaw);
+    RowVectorXi picks = raw.info.pick_types(false, false, true);
+    QCOMPARE(static_cast<int>(picks.cols()), eventIndex.channelNames().size());
+
+    MatrixXd matData, matTimes;
+    QVERIFY(raw.read_raw_segment(matData, matTimes, raw.first_samp, raw.last_samp, picks));
+
+    QList<int> lSamples;
+    QList<int> lChannels;
+    for(int j = 1; j < matData.cols(); ++j) {
+        for(int i = 0; i < matData.rows(); ++i) {
+            if(matData(i,j) - matData(i,j-1) >= 0.5) {
+                lSamples << raw.first_samp + j;
+                lChannels << i;
+            }
+        }
+    }
+
+    QVERIFY(lSamples.size() > 0);
+
+    const MatrixXi& matEvents = eventIndex.events();
+    QCOMPARE(static_cast<int>(matEvents.rows()), lSamples.size());
+    for(int k = 0; k < lSamples.size(); ++k) {
+        QCOMPARE(matEvents(k,0), lSamples[k]);
+        QCOMPARE(matEvents(k,1), lChannels[k]);
+        QCOMPARE(matEvents(k,2), qRound(matData(lChannels[k], lSamples[k] - raw.first_samp - 1)));
+        QCOMPARE(matEvents(k,3), qRound(matData(lChannels[k], lSamples[k] - raw.first_samp)));
+    }
+
+    //Ranges return the events between both samples, including the limits
+    int iFrom = lSamples[lSamples.size() / 3];
+    int iTo = lSamples[2 * lSamples.size() / 3];
+    int iCount = 0;
+    for(int k = 0; k < lSamples.size(); ++k) {
+        if(lSamples[k] >= iFrom && lSamples[k] <= iTo) {
+            ++iCount;
+        }
+    }
+
+    MatrixXi matRange = eventIndex.eventsInRange(iFrom, iTo);
+    QCOMPARE(static_cast<int>(matRange.rows()), iCount);
+    QCOMPARE(matRange(0,0), iFrom);
+    QCOMPARE(matRange(matRange.rows() - 1, 0), iTo);
+
+    QCOMPARE(static_cast<int>(eventIndex.eventsInRange(raw.last_samp + 1, raw.last_samp + 1000).rows()), 0);
+    QCOMPARE(static_cast<int>(eventIndex.eventsInRange(raw.first_samp, raw.last_samp).rows()), lSamples.size());
+}
+
+
+//*************************************************************************************************************
+
+void TestEventDetector::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+
+QVector<DetectedEvent> TestEventDetector::detectInBlocks(EventDetector& detector, const MatrixXd& matData, int iBlockSize) const
+{
+    QVector<DetectedEvent> vecEvents;
+
+    for(int iFrom = 0; iFrom < matData.cols(); iFrom += iBlockSize) {
+        int iNumCols = qMin(iBlockSize, static_cast<int>(matData.cols()) - iFrom);
+        vecEvents += detector.detect(matData.middleCols(iFrom, iNumCols), iFrom);
+    }
+
+    return vecEvents;
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestEventDetector)
+#include "test_event_detector.moc"
@@ -0,0 +1,564 @@
+//=============================================================================================================
+/**
+* @file     test_fft_service.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+* @brief    Test of the FFT service against Eigen::FFT
+* @brief    Test of the IIR filter in second-order sections
+*
+*/
+
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+#include <utils/fftservice.h>
+
+#include <random>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+#include <QtConcurrent>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// EIGEN INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+#include <unsupported/Eigen/FFT>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace UTILSLIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestFFTService
+*
+* @brief The TestFFTService class compares the cached transforms of FFTService with freshly planned Eigen::FFT
+*        transforms for even and odd lengths
+*
+*/
+class TestFFTService: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestFFTService();
+
+private slots:
+    void initTestCase();
+    void compareRealForward();
+    void compareHalfAndFullSpectrum();
+    void compareComplex();
+    void compareRows();
+    void compareColumns();
+    void compareInverseBatched();
+    void compareRoundTrip();
+    void compareThreadCache();
+    void cleanupTestCase();
+
+private:
+    //=========================================================================================================
+    /**
+    * Returns the spectrum of real data computed by a new Eigen::FFT, or directly for the trivial length.
+    *
+    * @param[in] vecTime        The time samples.
+    * @param[in] bHalfSpectrum  Whether to only return the non-negative frequencies.
+    *
+    * @return the spectrum.
+    */
+    VectorXcd referenceFwd(const VectorXd& vecTime, bool bHalfSpectrum) const;
+
+    //=========================================================================================================
+    /**
+    * Returns the real data of a half spectrum computed by a new Eigen::FFT, or directly for the trivial length.
+    *
+    * @param[in] vecFreq        The half spectrum.
+    * @param[in] iNfft          The transform length.
+    *
+    * @return the time samples.
+    */
+    VectorXd referenceInv(const VectorXcd& vecFreq, int iNfft) const;
+
+    //=========================================================================================================
+    /**
+    * Returns a vector of random numbers.
+    *
+    * @param[in] iSize          The number of elements.
+    *
+    * @return the random vector.
+    */
+    VectorXd randomVector(int iSize);
+
+    double epsilon;
+
+    QList<int>      m_lLengths;     /**< The tested transform lengths, even and odd. */
+    std::mt19937    m_generator;    /**< Random numbers for the test signals. */
+};
+
+
+//*************************************************************************************************************
+
+TestFFTService::TestFFTService()
+: epsilon(0.000000001)
+, m_generator(7)
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestFFTService::initTestCase()
+{
+    m_lLengths << 1 << 2 << 3 << 4 << 5 << 7 << 16 << 45 << 64 << 127 << 250 << 1000 << 1001;
+}
+
+
+//*************************************************************************************************************
+
+void TestFFTService::compareRealForward()
+{
+    for(int i = 0; i < m_lLengths.size(); ++i) {
+        const int iNfft = m_lLengths[i];
+        VectorXd vecTime = randomVector(iNfft);
+
+        //Twice per length, the second transform uses the cached plan
+        for(int iRun = 0; iRun < 2; ++iRun) {
+            VectorXcd vecFreq(iNfft/2 + 1);
+            FFTService::fwd(vecFreq.data(), vecTime.data(), iNfft);
+            QVERIFY((vecFreq - referenceFwd(vecTime, true)).norm() <= epsilon * iNfft);
+
+            VectorXcd vecFreqTemplate;
+            FFTService::fwd(vecFreqTemplate, vecTime);
+            QCOMPARE(static_cast<int>(vecFreqTemplate.size()), iNfft/2 + 1);
+            QVERIFY(vecFreqTemplate == vecFreq);
+        }
+
+        //Single precision
+        VectorXf vecTimeFloat = vecTime.cast<float>();
+        VectorXcf vecFreqFloat;
+        FFTService::fwd(vecFreqFloat, vecTimeFloat);
+        QVERIFY((vecFreqFloat.cast<std::complex<double> >() - referenceFwd(vecTimeFloat.cast<double>(), true)).norm() <= 0.0001 * iNfft);
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestFFTService::compareHalfAndFullSpectrum()
+{
+    for(int i = 0; i < m_lLengths.size(); ++i) {
+        const int iNfft = m_lLengths[i];
+        VectorXd vecTime = randomVector(iNfft);
+
+        VectorXcd vecHalf, vecFull;
+        FFTService::fwd(vecHalf, vecTime, true);
+        FFTService::fwd(vecFull, vecTime, false);
+
+        QCOMPARE(static_cast<int>(vecHalf.size()), iNfft/2 + 1);
+        QCOMPARE(static_cast<int>(vecFull.size()), iNfft);
+        QVERIFY(vecFull.head(vecHalf.size()) == vecHalf);
+
+        //The negative frequencies mirror the positive ones, for odd lengths there is no Nyquist bin
+        for(int k = 1; k < iNfft; ++k) {
+            QVERIFY(vecFull(k) == std::conj(vecFull(iNfft - k)));
+        }
+
+        QVERIFY((vecFull - referenceFwd(vecTime, false)).norm() <= epsilon * iNfft);
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestFFTService::compareComplex()
+{
+    for(int i = 0; i < m_lLengths.size(); ++i) {
+        const int iNfft = m_lLengths[i];
+        VectorXcd vecTime(iNfft);
+        vecTime.real() = randomVector(iNfft);
+        vecTime.imag() = randomVector(iNfft);
+
+        VectorXcd vecFreq;
+        FFTService::fwd(vecFreq, vecTime);
+        QCOMPARE(static_cast<int>(vecFreq.size()), iNfft);
+
+        VectorXcd vecInv;
+        FFTService::inv(vecInv, vecFreq);
+
+        if(iNfft == 1) {
+            QVERIFY(vecFreq == vecTime);
+            QVERIFY(vecInv == vecTime);
+        } else {
+            Eigen::FFT<double> fft;
+            VectorXcd vecReference;
+            fft.fwd(vecReference, vecTime);
+            QVERIFY((vecFreq - vecReference).norm() <= epsilon * iNfft);
+
+            VectorXcd vecInvReference;
+            fft.inv(vecInvReference, vecFreq);
+            QVERIFY((vecInv - vecInvReference).norm() <= epsilon * iNfft);
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestFFTService::compareRows()
+{
+    const int iNumRows = 5;
+
+    for(int i = 0; i < m_lLengths.size(); ++i) {
+        const int iNumCols = m_lLengths[i];
+        MatrixXd matTime(iNumRows, iNumCols);
+        for(int r = 0; r < iNumRows; ++r) {
+            matTime.row(r) = randomVector(iNumCols).transpose();
+        }
+
+        //The default length, zero-padding to an odd and an even length and truncation
+        QList<int> lNfft = QList<int>() << -1 << 2*iNumCols + 1 << 2*iNumCols + 2 << (iNumCols + 1)/2;
+
+        for(int j = 0; j < lNfft.size(); ++j) {
+            const int iNfft = lNfft[j] < 1 ? iNumCols : lNfft[j];
+
+            for(int iHalf = 0; iHalf < 2; ++iHalf) {
+                MatrixXcd matFreq;
+                FFTService::fwdRows(matFreq, matTime, lNfft[j], iHalf == 1);
+
+                QCOMPARE(static_cast<int>(matFreq.rows()), iNumRows);
+                QCOMPARE(static_cast<int>(matFreq.cols()), iHalf == 1 ? iNfft/2 + 1 : iNfft);
+
+                for(int r = 0; r < iNumRows; ++r) {
+                    VectorXd vecPadded = VectorXd::Zero(iNfft);
+                    vecPadded.head(qMin(iNfft, iNumCols)) = matTime.row(r).head(qMin(iNfft, iNumCols)).transpose();
+
+                    QVERIFY((matFreq.row(r).transpose() - referenceFwd(vecPadded, iHalf == 1)).norm() <= epsilon * iNfft);
+                }
+            }
+        }
+
+        //Single precision
+        MatrixXcf matFreqFloat;
+        FFTService::fwdRows(matFreqFloat, MatrixXf(matTime.cast<float>()));
+        for(int r = 0; r < iNumRows; ++r) {
+            QVERIFY((matFreqFloat.row(r).transpose().cast<std::complex<double> >() - referenceFwd(matTime.row(r).cast<float>().cast<double>().transpose(), true)).norm() <= 0.0001 * iNumCols);
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestFFTService::compareColumns()
+{
+    const int iNumCols = 4;
+
+    for(int i = 0; i < m_lLengths.size(); ++i) {
+        const int iNumRows = m_lLengths[i];
+        MatrixXd matTime(iNumRows, iNumCols);
+        for(int c = 0; c < iNumCols; ++c) {
+            matTime.col(c) = randomVector(iNumRows);
+        }
+
+        //The contiguous path for the default length, the copying path otherwise
+        QList<int> lNfft = QList<int>() << -1 << 2*iNumRows + 1 << 2*iNumRows + 2 << (iNumRows + 1)/2;
+
+        for(int j = 0; j < lNfft.size(); ++j) {
+            const int iNfft = lNfft[j] < 1 ? iNumRows : lNfft[j];
+
+            for(int iHalf = 0; iHalf < 2; ++iHalf) {
+                MatrixXcd matFreq;
+                FFTService::fwdColumns(matFreq, matTime, lNfft[j], iHalf == 1);
+
+                QCOMPARE(static_cast<int>(matFreq.rows()), iHalf == 1 ? iNfft/2 + 1 : iNfft);
+                QCOMPARE(static_cast<int>(matFreq.cols()), iNumCols);
+
+                for(int c = 0; c < iNumCols; ++c) {
+                    VectorXd vecPadded = VectorXd::Zero(iNfft);
+                    vecPadded.head(qMin(iNfft, iNumRows)) = matTime.col(c).head(qMin(iNfft, iNumRows));
+
+                    QVERIFY((matFreq.col(c) - referenceFwd(vecPadded, iHalf == 1)).norm() <= epsilon * iNfft);
+                }
+            }
+        }
+
+        MatrixXcf matFreqFloat;
+        FFTService::fwdColumns(matFreqFloat, MatrixXf(matTime.cast<float>()));
+        for(int c = 0; c < iNumCols; ++c) {
+            QVERIFY((matFreqFloat.col(c).cast<std::complex<double> >() - referenceFwd(matTime.col(c).cast<float>().cast<double>(), true)).norm() <= 0.0001 * iNumRows);
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestFFTService::compareInverseBatched()
+{
+    const int iNumSpectra = 3;
+
+    for(int i = 0; i < m_lLengths.size(); ++i) {
+        const int iNfft = m_lLengths[i];
+        const int iNumBins = iNfft/2 + 1;
+
+        //Half spectra of real signals, so the reference inverse is well defined
+        MatrixXcd matFreqRows(iNumSpectra, iNumBins);
+        for(int r = 0; r < iNumSpectra; ++r) {
+            matFreqRows.row(r) = referenceFwd(randomVector(iNfft), true).transpose();
+        }
+        MatrixXcd matFreqCols = matFreqRows.transpose();
+
+        MatrixXd matTimeRows, matTimeCols;
+        FFTService::invRows(matTimeRows, matFreqRows, iNfft);
+        FFTService::invColumns(matTimeCols, matFreqCols, iNfft);
+
+        QCOMPARE(static_cast<int>(matTimeRows.rows()), iNumSpectra);
+        QCOMPARE(static_cast<int>(matTimeRows.cols()), iNfft);
+        QCOMPARE(static_cast<int>(matTimeCols.rows()), iNfft);
+        QCOMPARE(static_cast<int>(matTimeCols.cols()), iNumSpectra);
+
+        for(int r = 0; r < iNumSpectra; ++r) {
+            VectorXd vecReference = referenceInv(matFreqRows.row(r).transpose(), iNfft);
+            QVERIFY((matTimeRows.row(r).transpose() - vecReference).norm() <= epsilon * iNfft);
+            QVERIFY((matTimeCols.col(r) - vecReference).norm() <= epsilon * iNfft);
+        }
+
+        //Missing bins are treated as zeros
+        if(iNumBins > 1) {
+            MatrixXd matTimeShort;
+            FFTService::invColumns(matTimeShort, MatrixXcd(matFreqCols.topRows(iNumBins - 1)), iNfft);
+
+            VectorXcd vecZeroPadded = matFreqCols.col(0);
+            vecZeroPadded(iNumBins - 1) = 0.0;
+            QVERIFY((matTimeShort.col(0) - referenceInv(vecZeroPadded, iNfft)).norm() <= epsilon * iNfft);
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestFFTService::compareRoundTrip()
+{
+    for(int i = 0; i < m_lLengths.size(); ++i) {
+        const int iNfft = m_lLengths[i];
+        VectorXd vecTime = randomVector(iNfft);
+
+        //Pointer interface
+        VectorXcd vecFreq(iNfft/2 + 1);
+        VectorXd vecBack(iNfft);
+        FFTService::fwd(vecFreq.data(), vecTime.data(), iNfft);
+        FFTService::inv(vecBack.data(), vecFreq.data(), iNfft);
+        QVERIFY((vecBack - vecTime).norm() <= epsilon * iNfft);
+
+        //Vector interface, the length has to be given for odd lengths
+        VectorXd vecBackTemplate;
+        FFTService::inv(vecBackTemplate, vecFreq, iNfft);
+        QVERIFY((vecBackTemplate - vecTime).norm() <= epsilon * iNfft);
+
+        if(iNfft % 2 == 0) {
+            FFTService::inv(vecBackTemplate, vecFreq);
+            QCOMPARE(static_cast<int>(vecBackTemplate.size()), iNfft);
+            QVERIFY((vecBackTemplate - vecTime).norm() <= epsilon * iNfft);
+        }
+
+        //The full spectrum gives the same signal
+        VectorXcd vecFull;
+        FFTService::fwd(vecFull, vecTime, false);
+        FFTService::inv(vecBackTemplate, vecFull, iNfft);
+        QVERIFY((vecBackTemplate - vecTime).norm() <= epsilon * iNfft);
+
+        //Batched
+        MatrixXd matTime(3, iNfft);
+        for(int r = 0; r < matTime.rows(); ++r) {
+            matTime.row(r) = randomVector(iNfft).transpose();
+        }
+
+        MatrixXcd matFreq;
+        MatrixXd matBack;
+        FFTService::fwdRows(matFreq, matTime);
+        FFTService::invRows(matBack, matFreq, iNfft);
+        QVERIFY((matBack - matTime).norm() <= epsilon * iNfft);
+
+        MatrixXd matTimeT = matTime.transpose();
+        FFTService::fwdColumns(matFreq, matTimeT);
+        FFTService::invColumns(matBack, matFreq, iNfft);
+        QVERIFY((matBack - matTimeT).norm() <= epsilon * iNfft);
+
+        //Single precision
+        VectorXf vecTimeFloat = vecTime.cast<float>();
+        VectorXcf vecFreqFloat;
+        VectorXf vecBackFloat;
+        FFTService::fwd(vecFreqFloat, vecTimeFloat);
+        FFTService::inv(vecBackFloat, vecFreqFloat, iNfft);
+        QVERIFY((vecBackFloat - vecTimeFloat).norm() <= 0.0001f * iNfft);
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestFFTService::compareThreadCache()
+{
+    //Every thread of the pool transforms all lengths in a different order with its own cache, the results have to
+    //be bit-identical to the ones of this thread
+    QList<VectorXd> lSignals;
+    QList<VectorXcd> lSpectra;
+    for(int i = 0; i < m_lLengths.size(); ++i) {
+        lSignals << randomVector(m_lLengths[i]);
+
+        VectorXcd vecFreq;
+        FFTService::fwd(vecFreq, lSignals.last());
+        lSpectra << vecFreq;
+    }
+
+    QList<int> lTasks;
+    for(int iTask = 0; iTask < 4 * QThread::idealThreadCount(); ++iTask) {
+        lTasks << iTask;
+    }
+
+    QList<bool> lResults = QtConcurrent::blockingMapped(lTasks, [&lSignals, &lSpectra](int iTask) {
+        bool bEqual = true;
+
+        for(int iRun = 0; iRun < 20; ++iRun) {
+            for(int i = 0; i < lSignals.size(); ++i) {
+                int k = (i * (iTask + 1) + iRun) % lSignals.size();
+
+                VectorXcd vecFreq;
+                FFTService::fwd(vecFreq, lSignals[k]);
+                bEqual = bEqual && vecFreq == lSpectra[k];
+            }
+        }
+
+        if(iTask % 2 == 0) {
+            FFTService::clearThreadCache();
+        }
+
+        return bEqual;
+    });
+
+    QCOMPARE(lResults.size(), lTasks.size());
+    for(int i = 0; i < lResults.size(); ++i) {
+        QVERIFY(lResults[i]);
+    }
+
+    //A cleared cache is rebuilt on the next transform
+    FFTService::clearThreadCache();
+    for(int i = 0; i < lSignals.size(); ++i) {
+        VectorXcd vecFreq;
+        FFTService::fwd(vecFreq, lSignals[i]);
+        QVERIFY(vecFreq == lSpectra[i]);
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestFFTService::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+
+VectorXcd TestFFTService::referenceFwd(const VectorXd& vecTime, bool bHalfSpectrum) const
+{
+    const int iNfft = static_cast<int>(vecTime.size());
+
+    if(iNfft == 1) {
+        return VectorXcd::Constant(1, std::complex<double>(vecTime(0), 0.0));
+    }
+
+    Eigen::FFT<double> fft;
+    if(bHalfSpectrum) {
+        fft.SetFlag(fft.HalfSpectrum);
+    }
+
+    VectorXcd vecFreq;
+    fft.fwd(vecFreq, vecTime);
+
+    return vecFreq;
+}
+
+
+//*************************************************************************************************************
+
+VectorXd TestFFTService::referenceInv(const VectorXcd& vecFreq, int iNfft) const
+{
+    if(iNfft == 1) {
+        return VectorXd::Constant(1, vecFreq(0).real());
+    }
+
+    Eigen::FFT<double> fft;
+    fft.SetFlag(fft.HalfSpectrum);
+
+    VectorXd vecTime;
+    fft.inv(vecTime, vecFreq, iNfft);
+
+    return vecTime;
+}
+
+
+//*************************************************************************************************************
+
+VectorXd TestFFTService::randomVector(int iSize)
+{
+    std::normal_distribution<double> normal(0.0, 1.0);
+
+    VectorXd vecRandom(iSize);
+    for(int i = 0; i < iSize; ++i) {
+        vecRandom(i) = normal(m_generator);
+    }
+
+    return vecRandom;
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestFFTService)
+#include "test_fft_service.moc"
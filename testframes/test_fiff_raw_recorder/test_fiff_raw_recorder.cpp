@@ -0,0 +1,335 @@
+//=============================================================================================================
+/**
+* @file     test_fiff_raw_recorder.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+* @brief    Test of the asynchronous fif raw data recorder
+* @brief    Test of the IIR filter in second-order sections
+*
+*/
+
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+#include <fiff/fiff.h>
+#include <fiff/fiff_raw_recorder.h>
+
+#include <random>
+#include <vector>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// EIGEN INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace FIFFLIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestFiffRawRecorder
+*
+* @brief The TestFiffRawRecorder class records synthetic data into split files with every supported storage type
+*        and reads the parts back with FiffRawData
+*
+*/
+class TestFiffRawRecorder: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestFiffRawRecorder();
+
+private slots:
+    void initTestCase();
+    void compareFloat();
+    void compareInt();
+    void compareDauPack16();
+    void cleanupTestCase();
+
+private:
+    //=========================================================================================================
+    /**
+    * Records blocks into a queue of size one until blocks were dropped, then reads all file parts back and
+    * compares the samples, the first samples of the parts and their FIFFB_REF links.
+    *
+    * @param[in] iDataType      The storage type of the data buffers.
+    */
+    void recordAndCompare(fiff_int_t iDataType);
+
+    //=========================================================================================================
+    /**
+    * Returns the file name of a file part.
+    *
+    * @param[in] iFileNum       The index of the file part.
+    *
+    * @return the file name.
+    */
+    QString partFileName(int iFileNum) const;
+
+    double epsilon;
+
+    FiffInfo    m_info;             /**< The synthetic measurement info. */
+    QString     m_sFileName;        /**< The file name of the first file part. */
+    int         m_iBlockSize;       /**< Number of samples per block. */
+    qint64      m_iSplitSize;       /**< The file part size, small enough for several parts. */
+};
+
+
+//*************************************************************************************************************
+
+TestFiffRawRecorder::TestFiffRawRecorder()
+: epsilon(0.000001)
+, m_iBlockSize(100)
+, m_iSplitSize(24000)
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRawRecorder::initTestCase()
+{
+    m_sFileName = QDir::currentPath()+"/mne-cpp-test-data/MEG/sample/test_fiff_raw_recorder_raw.fif";
+
+    //Channels with different range and cal, so the recorder has to apply the inverse calibration per channel
+    m_info.nchan = 6;
+    m_info.sfreq = 1000.0f;
+    m_info.highpass = 0.0f;
+    m_info.lowpass = 500.0f;
+
+    for(int k = 0; k < m_info.nchan; ++k) {
+        FiffChInfo ch;
+        ch.scanNo = k + 1;
+        ch.logNo = k + 1;
+        ch.kind = FIFFV_MISC_CH;
+        ch.range = k % 2 == 0 ? 1.0f : 2.0f;
+        ch.cal = 0.25f * (k + 1);
+        ch.unit = FIFF_UNIT_V;
+        ch.ch_name = QString("MISC %1").arg(k + 1, 3, 10, QChar('0'));
+
+        m_info.chs.append(ch);
+        m_info.ch_names.append(ch.ch_name);
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRawRecorder::compareFloat()
+{
+    recordAndCompare(FIFFT_FLOAT);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRawRecorder::compareInt()
+{
+    recordAndCompare(FIFFT_INT);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRawRecorder::compareDauPack16()
+{
+    recordAndCompare(FIFFT_DAU_PACK16);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRawRecorder::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRawRecorder::recordAndCompare(fiff_int_t iDataType)
+{
+    FiffRawRecorder recorder(m_info);
+    QVERIFY(recorder.setDataType(iDataType));
+    recorder.setSplitSize(m_iSplitSize);
+    recorder.setQueueSize(1);
+
+    QVERIFY(recorder.startRecording(m_sFileName));
+
+    //Integer device values fit all storage types, so the round trip only differs by float rounding
+    std::mt19937 generator(iDataType);
+    std::uniform_int_distribution<int> uniform(-30000, 30000);
+
+    RowVectorXd vecCals(m_info.nchan);
+    for(int k = 0; k < m_info.nchan; ++k) {
+        vecCals[k] = m_info.chs[k].range * m_info.chs[k].cal;
+    }
+
+    //Append faster than the I/O thread writes until blocks were dropped and a later block was queued again
+    QList<MatrixXd> lBlocks;
+    QList<bool> lQueued;
+    bool bHasDropped = false;
+
+    for(int iBlock = 0; iBlock < 10000; ++iBlock) {
+        MatrixXd matBlock(m_info.nchan, m_iBlockSize);
+        for(int j = 0; j < matBlock.cols(); ++j) {
+            for(int i = 0; i < matBlock.rows(); ++i) {
+                matBlock(i,j) = uniform(generator) * vecCals[i];
+            }
+        }
+
+        bool bQueued = recorder.append(matBlock);
+        lBlocks.append(matBlock);
+        lQueued.append(bQueued);
+
+        bHasDropped |= !bQueued;
+        if(bHasDropped && bQueued && iBlock >= 40) {
+            break;
+        }
+    }
+
+    QVERIFY(recorder.stopRecording());
+    QVERIFY(recorder.droppedBlocks() > 0);
+    QVERIFY(lQueued.last());
+    QVERIFY(recorder.fileCount() >= 3);
+
+    //Dropped blocks are read back as zeros
+    MatrixXd matExpected(m_info.nchan, lBlocks.size() * m_iBlockSize);
+    std::vector<bool> vecDropped(matExpected.cols(), false);
+    for(int b = 0; b < lBlocks.size(); ++b) {
+        if(lQueued[b]) {
+            matExpected.middleCols(b * m_iBlockSize, m_iBlockSize) = lBlocks[b];
+        } else {
+            matExpected.middleCols(b * m_iBlockSize, m_iBlockSize).setZero();
+            std::fill(vecDropped.begin() + b * m_iBlockSize, vecDropped.begin() + (b + 1) * m_iBlockSize, true);
+        }
+    }
+
+    const double dMax = matExpected.cwiseAbs().maxCoeff();
+    fiff_int_t iLastSamp = -1;
+
+    for(int iFileNum = 0; iFileNum < recorder.fileCount(); ++iFileNum) {
+        QFile t_fileRaw(partFileName(iFileNum));
+        FiffRawData raw(t_fileRaw);
+
+        //Consecutive parts continue the time axis, a skip at the start of a part only leaves out dropped samples
+        QVERIFY(raw.first_samp > iLastSamp);
+        for(fiff_int_t s = iLastSamp + 1; s < raw.first_samp; ++s) {
+            QVERIFY(vecDropped[s]);
+        }
+        QVERIFY(raw.last_samp >= raw.first_samp && raw.last_samp < matExpected.cols());
+
+        MatrixXd data, times;
+        QVERIFY(raw.read_raw_segment(data, times, raw.first_samp, raw.last_samp));
+        QCOMPARE(static_cast<int>(data.cols()), raw.last_samp - raw.first_samp + 1);
+
+        MatrixXd matDiff = data - matExpected.middleCols(raw.first_samp, data.cols());
+        QVERIFY(matDiff.cwiseAbs().maxCoeff() <= epsilon * dMax);
+
+        iLastSamp = raw.last_samp;
+
+        //Each part links to its neighbours
+        QFile t_fileRef(partFileName(iFileNum));
+        FiffStream::SPtr t_pStream(new FiffStream(&t_fileRef));
+        QVERIFY(t_pStream->open());
+
+        bool bHasPrev = false;
+        bool bHasNext = false;
+        QList<FiffDirNode::SPtr> refs = t_pStream->dirtree()->dir_tree_find(FIFFB_REF);
+        for(int r = 0; r < refs.size(); ++r) {
+            FiffTag::SPtr t_pTag;
+            QVERIFY(refs[r]->find_tag(t_pStream, FIFF_REF_ROLE, t_pTag));
+            fiff_int_t iRole = *t_pTag->toInt();
+            QVERIFY(refs[r]->find_tag(t_pStream, FIFF_REF_FILE_NUM, t_pTag));
+            fiff_int_t iRefNum = *t_pTag->toInt();
+
+            if(iRole == FIFFV_ROLE_PREV_FILE) {
+                QCOMPARE(iRefNum, iFileNum - 1);
+                bHasPrev = true;
+            } else if(iRole == FIFFV_ROLE_NEXT_FILE) {
+                QCOMPARE(iRefNum, iFileNum + 1);
+                bHasNext = true;
+            }
+        }
+        t_pStream->close();
+
+        QCOMPARE(bHasPrev, iFileNum > 0);
+        QCOMPARE(bHasNext, iFileNum < recorder.fileCount() - 1);
+    }
+
+    //The recording ends with a queued block, so nothing is missing at the end
+    QCOMPARE(static_cast<int>(iLastSamp), static_cast<int>(matExpected.cols()) - 1);
+
+    for(int iFileNum = 0; iFileNum < recorder.fileCount(); ++iFileNum) {
+        QFile::remove(partFileName(iFileNum));
+    }
+}
+
+
+//*************************************************************************************************************
+
+QString TestFiffRawRecorder::partFileName(int iFileNum) const
+{
+    if(iFileNum == 0) {
+        return m_sFileName;
+    }
+
+    QString sBaseName = m_sFileName;
+    sBaseName.chop(QString("_raw.fif").size());
+
+    return QString("%1-%2_raw.fif").arg(sBaseName).arg(iFileNum);
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestFiffRawRecorder)
+#include "test_fiff_raw_recorder.moc"
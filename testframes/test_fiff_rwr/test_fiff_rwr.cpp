@@ -42,6 +42,9 @@
 #include <fiff/fiff.h>
 
 #include <iostream>
+#include <random>
+#include <cstring>
+#include <limits>
 
 
 //*************************************************************************************************************
@@ -78,11 +81,42 @@ private slots:
     void compareData();
     void compareTimes();
     void compareInfo();
+    void compareFloatTag();
+    void compareIntTag();
+    void compareDoubleTag();
+    void compareFloatMatrixTag();
+    void compareIntMatrixTag();
+    void compareSparseTags();
     void cleanupTestCase();
 
 private:
+    //=========================================================================================================
+    /**
+    * Reads a tag back from a buffer written by a FiffStream.
+    *
+    * @param[in] baBuffer   The written buffer.
+    * @param[in] pos        The position of the tag.
+    *
+    * @return the tag.
+    */
+    FiffTag::SPtr readTag(QByteArray& baBuffer, fiff_long_t pos) const;
+
+    //=========================================================================================================
+    /**
+    * Returns a random sparse matrix.
+    *
+    * @param[in] rows       The number of rows.
+    * @param[in] cols       The number of columns.
+    * @param[in] density    The fraction of non-zero entries.
+    *
+    * @return the sparse matrix.
+    */
+    SparseMatrix<float> randomSparse(int rows, int cols, double density);
+
     double epsilon;
 
+    std::mt19937 m_generator;   /**< Random numbers for the written tags. */
+
     FiffRawData first_in_raw;
 
     MatrixXd first_in_data;
@@ -100,6 +134,7 @@ private:
 
 TestFiffRWR::TestFiffRWR()
 : epsilon(0.000001)
+, m_generator(42)
 {
 }
 
@@ -319,6 +354,163 @@ void TestFiffRWR::compareInfo()
     }
 }
 
+//*************************************************************************************************************
+
+void TestFiffRWR::compareFloatTag()
+{
+    std::uniform_real_distribution<float> uniform(-1e3f, 1e3f);
+    std::vector<float> vecData(1001);
+    for(size_t i = 0; i < vecData.size(); ++i)
+        vecData[i] = uniform(m_generator);
+
+    QByteArray baBuffer;
+    FiffStream outStream(&baBuffer, QIODevice::WriteOnly);
+    fiff_long_t posSingle = outStream.write_float(FIFF_SFREQ, vecData.data());
+    fiff_long_t posArray = outStream.write_float(FIFF_DATA_BUFFER, vecData.data(), vecData.size());
+
+    FiffTag::SPtr t_pTag = readTag(baBuffer, posSingle);
+    QVERIFY(t_pTag->kind == FIFF_SFREQ && t_pTag->getType() == FIFFT_FLOAT && t_pTag->size() == 4);
+    QVERIFY(std::memcmp(t_pTag->toFloat(), vecData.data(), 4) == 0);
+
+    t_pTag = readTag(baBuffer, posArray);
+    QVERIFY(t_pTag->kind == FIFF_DATA_BUFFER && t_pTag->getType() == FIFFT_FLOAT);
+    QCOMPARE(t_pTag->size(), static_cast<int>(4*vecData.size()));
+    QVERIFY(std::memcmp(t_pTag->toFloat(), vecData.data(), 4*vecData.size()) == 0);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRWR::compareIntTag()
+{
+    std::uniform_int_distribution<qint32> uniform(std::numeric_limits<qint32>::min(), std::numeric_limits<qint32>::max());
+    std::vector<qint32> vecData(1003);
+    for(size_t i = 0; i < vecData.size(); ++i)
+        vecData[i] = uniform(m_generator);
+
+    QByteArray baBuffer;
+    FiffStream outStream(&baBuffer, QIODevice::WriteOnly);
+    fiff_long_t pos = outStream.write_int(FIFF_DATA_BUFFER, vecData.data(), vecData.size());
+
+    FiffTag::SPtr t_pTag = readTag(baBuffer, pos);
+    QVERIFY(t_pTag->getType() == FIFFT_INT);
+    QCOMPARE(t_pTag->size(), static_cast<int>(4*vecData.size()));
+    QVERIFY(std::memcmp(t_pTag->toInt(), vecData.data(), 4*vecData.size()) == 0);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRWR::compareDoubleTag()
+{
+    std::uniform_real_distribution<double> uniform(-1e9, 1e9);
+    std::vector<double> vecData(1005);
+    for(size_t i = 0; i < vecData.size(); ++i)
+        vecData[i] = uniform(m_generator);
+
+    QByteArray baBuffer;
+    FiffStream outStream(&baBuffer, QIODevice::WriteOnly);
+    fiff_long_t pos = outStream.write_double(FIFF_DATA_BUFFER, vecData.data(), vecData.size());
+
+    FiffTag::SPtr t_pTag = readTag(baBuffer, pos);
+    QVERIFY(t_pTag->getType() == FIFFT_DOUBLE);
+    QCOMPARE(t_pTag->size(), static_cast<int>(8*vecData.size()));
+    QVERIFY(std::memcmp(t_pTag->toDouble(), vecData.data(), 8*vecData.size()) == 0);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRWR::compareFloatMatrixTag()
+{
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+
+    //A small matrix with an odd shape, a large one which exceeds the 4 MB staging buffer, and a tag after it
+    MatrixXf matSmall(37, 5);
+    MatrixXf matLarge(1100, 1001);
+    for(qint32 j = 0; j < matSmall.cols(); ++j)
+        for(qint32 i = 0; i < matSmall.rows(); ++i)
+            matSmall(i,j) = uniform(m_generator);
+    for(qint32 j = 0; j < matLarge.cols(); ++j)
+        for(qint32 i = 0; i < matLarge.rows(); ++i)
+            matLarge(i,j) = uniform(m_generator);
+
+    QVERIFY(4*matLarge.size() > 4194304);
+
+    QByteArray baBuffer;
+    FiffStream outStream(&baBuffer, QIODevice::WriteOnly);
+    fiff_long_t posSmall = outStream.write_float_matrix(FIFF_MNE_FORWARD_SOLUTION, matSmall);
+    fiff_long_t posLarge = outStream.write_float_matrix(FIFF_MNE_FORWARD_SOLUTION, matLarge);
+    fiff_long_t posAfter = outStream.write_float_matrix(FIFF_MNE_FORWARD_SOLUTION, matSmall.transpose());
+
+    FiffTag::SPtr t_pTag = readTag(baBuffer, posSmall);
+    MatrixXf matRead = t_pTag->toFloatMatrix().transpose();
+    QVERIFY(matRead.rows() == matSmall.rows() && matRead.cols() == matSmall.cols());
+    QVERIFY(std::memcmp(matRead.data(), matSmall.data(), 4*matSmall.size()) == 0);
+
+    t_pTag = readTag(baBuffer, posLarge);
+    matRead = t_pTag->toFloatMatrix().transpose();
+    QVERIFY(matRead.rows() == matLarge.rows() && matRead.cols() == matLarge.cols());
+    QVERIFY(std::memcmp(matRead.data(), matLarge.data(), 4*matLarge.size()) == 0);
+
+    t_pTag = readTag(baBuffer, posAfter);
+    matRead = t_pTag->toFloatMatrix();
+    QVERIFY(matRead.rows() == matSmall.rows() && matRead.cols() == matSmall.cols());
+    QVERIFY(std::memcmp(matRead.data(), matSmall.data(), 4*matSmall.size()) == 0);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRWR::compareIntMatrixTag()
+{
+    std::uniform_int_distribution<qint32> uniform(-100000, 100000);
+    MatrixXi matData(41, 3);
+    for(qint32 j = 0; j < matData.cols(); ++j)
+        for(qint32 i = 0; i < matData.rows(); ++i)
+            matData(i,j) = uniform(m_generator);
+
+    QByteArray baBuffer;
+    FiffStream outStream(&baBuffer, QIODevice::WriteOnly);
+    fiff_long_t pos = outStream.write_int_matrix(FIFF_MNE_FORWARD_SOLUTION, matData);
+
+    FiffTag::SPtr t_pTag = readTag(baBuffer, pos);
+    MatrixXi matRead = t_pTag->toIntMatrix().transpose();
+    QVERIFY(matRead == matData);
+}
+
+
+//*************************************************************************************************************
+
+void TestFiffRWR::compareSparseTags()
+{
+    //Including empty rows and columns
+    SparseMatrix<float> matSparse = randomSparse(200, 150, 0.05);
+    matSparse.prune([](int i, int j, float) { return i % 17 != 3 && j % 13 != 5; });
+
+    QByteArray baBuffer;
+    FiffStream outStream(&baBuffer, QIODevice::WriteOnly);
+    fiff_long_t posCcs = outStream.write_float_sparse_ccs(FIFF_MNE_SOURCE_SPACE_DIST, matSparse);
+    fiff_long_t posRcs = outStream.write_float_sparse_rcs(FIFF_MNE_SOURCE_SPACE_DIST, matSparse);
+
+    MatrixXd matExpected = MatrixXd(matSparse.cast<double>());
+
+    FiffTag::SPtr t_pTag = readTag(baBuffer, posCcs);
+    QVERIFY(t_pTag->getMatrixCoding() == FIFFTS_MC_CCS);
+    SparseMatrix<double> matRead = t_pTag->toSparseFloatMatrix();
+    QVERIFY(matRead.rows() == matSparse.rows() && matRead.cols() == matSparse.cols());
+    QCOMPARE(static_cast<int>(matRead.nonZeros()), static_cast<int>(matSparse.nonZeros()));
+    QVERIFY(MatrixXd(matRead) == matExpected);
+
+    t_pTag = readTag(baBuffer, posRcs);
+    QVERIFY(t_pTag->getMatrixCoding() == FIFFTS_MC_RCS);
+    matRead = t_pTag->toSparseFloatMatrix();
+    QVERIFY(matRead.rows() == matSparse.rows() && matRead.cols() == matSparse.cols());
+    QCOMPARE(static_cast<int>(matRead.nonZeros()), static_cast<int>(matSparse.nonZeros()));
+    QVERIFY(MatrixXd(matRead) == matExpected);
+}
+
+
 //*************************************************************************************************************
 
 void TestFiffRWR::cleanupTestCase()
@@ -326,6 +518,39 @@ void TestFiffRWR::cleanupTestCase()
 }
 
 
+//*************************************************************************************************************
+
+FiffTag::SPtr TestFiffRWR::readTag(QByteArray& baBuffer, fiff_long_t pos) const
+{
+    FiffStream inStream(&baBuffer, QIODevice::ReadOnly);
+
+    FiffTag::SPtr t_pTag;
+    inStream.read_tag(t_pTag, pos);
+
+    return t_pTag;
+}
+
+
+//*************************************************************************************************************
+
+SparseMatrix<float> TestFiffRWR::randomSparse(int rows, int cols, double density)
+{
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::uniform_real_distribution<float> values(-10.0f, 10.0f);
+
+    std::vector< Eigen::Triplet<float> > tripletList;
+    for(int j = 0; j < cols; ++j)
+        for(int i = 0; i < rows; ++i)
+            if(uniform(m_generator) < density)
+                tripletList.push_back(Eigen::Triplet<float>(i, j, values(m_generator)));
+
+    SparseMatrix<float> matSparse(rows, cols);
+    matSparse.setFromTriplets(tripletList.begin(), tripletList.end());
+
+    return matSparse;
+}
+
+
 //*************************************************************************************************************
 //=============================================================================================================
 // MAIN
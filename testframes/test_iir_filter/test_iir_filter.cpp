@@ -0,0 +1,346 @@
+//=============================================================================================================
+/**
+* @file     test_iir_filter.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test of the IIR filter in second-order sections
+*
+*/
+
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <utils/filterTools/iirfilter.h>
+
+#include <random>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// EIGEN INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace UTILSLIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestIirFilter
+*
+* @brief The TestIirFilter class checks the frequency response, the streaming and the zero-phase application of
+*        the IIR filter
+*
+*/
+class TestIirFilter: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestIirFilter();
+
+private slots:
+    void initTestCase();
+    void compareLowpassResponse();
+    void compareHighpassResponse();
+    void compareBandpassResponse();
+    void compareNotchResponse();
+    void compareFilterBlockSplit();
+    void compareZeroPhaseSine();
+    void compareZeroPhaseWithoutPadding();
+    void cleanupTestCase();
+
+private:
+    //=========================================================================================================
+    /**
+    * Returns the digital frequency the bilinear transform maps to the geometric center of the prewarped edges.
+    *
+    * @param[in] dLow       The lower edge in Hz.
+    * @param[in] dHigh      The upper edge in Hz.
+    *
+    * @return the center frequency in Hz.
+    */
+    double bilinearCenter(double dLow, double dHigh) const;
+
+    double epsilon;
+
+    double m_dSFreq;        /**< Sampling frequency. */
+    double m_dNyquist;      /**< Nyquist frequency. */
+    double m_dHalfPower;    /**< Magnitude at the -3 dB points, 1/sqrt(2). */
+
+    MatrixXd m_matNoise;    /**< Three channels of white noise. */
+};
+
+
+//*************************************************************************************************************
+
+TestIirFilter::TestIirFilter()
+: epsilon(1e-9)
+, m_dSFreq(1000.0)
+, m_dNyquist(500.0)
+, m_dHalfPower(1.0 / std::sqrt(2.0))
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestIirFilter::initTestCase()
+{
+    std::mt19937 generator(42);
+    std::normal_distribution<double> normal(0.0, 1.0);
+
+    m_matNoise.resize(3, 2000);
+    for(int i = 0; i < m_matNoise.rows(); ++i) {
+        for(int j = 0; j < m_matNoise.cols(); ++j) {
+            m_matNoise(i,j) = normal(generator) + 5.0 * i;
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestIirFilter::compareLowpassResponse()
+{
+    IirFilter filter("LPF", FilterData::LPF, 4, 100.0 / m_dNyquist, 0.0, m_dSFreq);
+
+    QVERIFY(std::abs(std::abs(filter.getFrequencyResponse(0.0)) - 1.0) < epsilon);
+    QVERIFY(std::abs(std::abs(filter.getFrequencyResponse(100.0)) - m_dHalfPower) < epsilon);
+    QVERIFY(std::abs(filter.getFrequencyResponse(m_dNyquist)) < epsilon);
+
+    //The Chebyshev type I design ends its ripple band at the cut off
+    const double dRipple = 1.0;
+    IirFilter chebyshev("LPF", FilterData::LPF, 4, 100.0 / m_dNyquist, 0.0, m_dSFreq, IirFilter::Chebyshev, dRipple);
+
+    QVERIFY(std::abs(std::abs(chebyshev.getFrequencyResponse(0.0)) - std::pow(10.0, -dRipple / 20.0)) < epsilon);
+    QVERIFY(std::abs(std::abs(chebyshev.getFrequencyResponse(100.0)) - std::pow(10.0, -dRipple / 20.0)) < epsilon);
+    QVERIFY(std::abs(chebyshev.getFrequencyResponse(m_dNyquist)) < epsilon);
+}
+
+
+//*************************************************************************************************************
+
+void TestIirFilter::compareHighpassResponse()
+{
+    IirFilter filter("HPF", FilterData::HPF, 4, 1.0 / m_dNyquist, 0.0, m_dSFreq);
+
+    QVERIFY(std::abs(filter.getFrequencyResponse(0.0)) < epsilon);
+    QVERIFY(std::abs(std::abs(filter.getFrequencyResponse(1.0)) - m_dHalfPower) < epsilon);
+    QVERIFY(std::abs(std::abs(filter.getFrequencyResponse(m_dNyquist)) - 1.0) < epsilon);
+}
+
+
+//*************************************************************************************************************
+
+void TestIirFilter::compareBandpassResponse()
+{
+    //Pass band from 75 Hz to 125 Hz
+    IirFilter filter("BPF", FilterData::BPF, 2, 100.0 / m_dNyquist, 50.0 / m_dNyquist, m_dSFreq);
+
+    QVERIFY(std::abs(filter.getFrequencyResponse(0.0)) < epsilon);
+    QVERIFY(std::abs(std::abs(filter.getFrequencyResponse(75.0)) - m_dHalfPower) < epsilon);
+    QVERIFY(std::abs(std::abs(filter.getFrequencyResponse(bilinearCenter(75.0, 125.0))) - 1.0) < epsilon);
+    QVERIFY(std::abs(std::abs(filter.getFrequencyResponse(125.0)) - m_dHalfPower) < epsilon);
+    QVERIFY(std::abs(filter.getFrequencyResponse(m_dNyquist)) < epsilon);
+}
+
+
+//*************************************************************************************************************
+
+void TestIirFilter::compareNotchResponse()
+{
+    //Butterworth band stop from 45 Hz to 55 Hz
+    IirFilter bandStop("NOTCH", FilterData::NOTCH, 2, 50.0 / m_dNyquist, 10.0 / m_dNyquist, m_dSFreq);
+
+    QVERIFY(std::abs(std::abs(bandStop.getFrequencyResponse(0.0)) - 1.0) < epsilon);
+    QVERIFY(std::abs(std::abs(bandStop.getFrequencyResponse(45.0)) - m_dHalfPower) < epsilon);
+    QVERIFY(std::abs(bandStop.getFrequencyResponse(bilinearCenter(45.0, 55.0))) < epsilon);
+    QVERIFY(std::abs(std::abs(bandStop.getFrequencyResponse(55.0)) - m_dHalfPower) < epsilon);
+    QVERIFY(std::abs(std::abs(bandStop.getFrequencyResponse(m_dNyquist)) - 1.0) < epsilon);
+
+    //Single notch section at 50 Hz with Q = 10. It is the bilinear transform of the analog notch prewarped at the
+    //notch, whose -3 dB points lie at W - 1/W = +-1/Q of the normalized analog frequency W.
+    IirFilter notch("NOTCH", FilterData::NOTCH, 0, 50.0 / m_dNyquist, 5.0 / m_dNyquist, m_dSFreq, IirFilter::Notch);
+
+    const double dQ = 10.0;
+    const double dTanW0 = std::tan(M_PI * 50.0 / m_dSFreq);
+    const double dWLow = (-1.0 / dQ + std::sqrt(1.0 / (dQ * dQ) + 4.0)) / 2.0;
+    const double dWHigh = (1.0 / dQ + std::sqrt(1.0 / (dQ * dQ) + 4.0)) / 2.0;
+
+    QVERIFY(std::abs(std::abs(notch.getFrequencyResponse(0.0)) - 1.0) < epsilon);
+    QVERIFY(std::abs(std::abs(notch.getFrequencyResponse(m_dSFreq / M_PI * std::atan(dWLow * dTanW0))) - m_dHalfPower) < epsilon);
+    QVERIFY(std::abs(notch.getFrequencyResponse(50.0)) < epsilon);
+    QVERIFY(std::abs(std::abs(notch.getFrequencyResponse(m_dSFreq / M_PI * std::atan(dWHigh * dTanW0))) - m_dHalfPower) < epsilon);
+    QVERIFY(std::abs(std::abs(notch.getFrequencyResponse(m_dNyquist)) - 1.0) < epsilon);
+}
+
+
+//*************************************************************************************************************
+
+void TestIirFilter::compareFilterBlockSplit()
+{
+    IirFilter filter("BPF", FilterData::BPF, 3, 40.0 / m_dNyquist, 20.0 / m_dNyquist, m_dSFreq);
+
+    MatrixXd matWhole = m_matNoise;
+    filter.filterBlock(matWhole);
+
+    //The same stream in blocks of different sizes, including single samples
+    filter.reset();
+
+    const int vecBlockSizes[] = {1, 7, 1, 64, 250, 3, 500};
+    MatrixXd matSplit(m_matNoise.rows(), m_matNoise.cols());
+    int iStart = 0;
+    int iBlock = 0;
+
+    while(iStart < m_matNoise.cols()) {
+        int iSize = std::min(vecBlockSizes[iBlock % 7], (int)m_matNoise.cols() - iStart);
+
+        MatrixXd matBlock = m_matNoise.middleCols(iStart, iSize);
+        filter.filterBlock(matBlock);
+        matSplit.middleCols(iStart, iSize) = matBlock;
+
+        iStart += iSize;
+        ++iBlock;
+    }
+
+    QVERIFY((matSplit - matWhole).cwiseAbs().maxCoeff() < epsilon);
+
+    //A different number of channels restarts the stream
+    MatrixXd matSingle = m_matNoise.topRows(1);
+    filter.filterBlock(matSingle);
+
+    QVERIFY((matSingle - matWhole.topRows(1)).cwiseAbs().maxCoeff() < epsilon);
+}
+
+
+//*************************************************************************************************************
+
+void TestIirFilter::compareZeroPhaseSine()
+{
+    IirFilter filter("LPF", FilterData::LPF, 4, 100.0 / m_dNyquist, 0.0, m_dSFreq);
+
+    const double dFreq = 60.0;
+    const int iNumSamples = 2000;
+    RowVectorXd vecSine(iNumSamples);
+    for(int t = 0; t < iNumSamples; ++t) {
+        vecSine(t) = std::sin(2.0 * M_PI * dFreq * t / m_dSFreq);
+    }
+
+    //Forward and backward the sine is scaled by |H|^2 and not shifted, away from the edges
+    const double dGain = std::norm(filter.getFrequencyResponse(dFreq));
+    QVERIFY(dGain < 1.0);
+
+    RowVectorXd vecFiltered = filter.applyZeroPhaseFilter(vecSine);
+    QCOMPARE(static_cast<int>(vecFiltered.size()), iNumSamples);
+
+    const int iEdge = 200;
+    RowVectorXd vecDiff = vecFiltered.segment(iEdge, iNumSamples - 2 * iEdge) - dGain * vecSine.segment(iEdge, iNumSamples - 2 * iEdge);
+    QVERIFY(vecDiff.cwiseAbs().maxCoeff() < 1e-6);
+
+    //The forward pass alone delays the sine
+    MatrixXd matForward = vecSine;
+    filter.reset();
+    filter.filterBlock(matForward);
+    RowVectorXd vecForwardDiff = matForward.row(0).segment(iEdge, iNumSamples - 2 * iEdge) - std::sqrt(dGain) * vecSine.segment(iEdge, iNumSamples - 2 * iEdge);
+    QVERIFY(vecForwardDiff.cwiseAbs().maxCoeff() > 0.1);
+}
+
+
+//*************************************************************************************************************
+
+void TestIirFilter::compareZeroPhaseWithoutPadding()
+{
+    IirFilter filter("HPF", FilterData::HPF, 2, 10.0 / m_dNyquist, 0.0, m_dSFreq);
+
+    //Without padding the data is still filtered forward and backward, each pass from the steady state of its first sample
+    MatrixXd matExpected = m_matNoise;
+    filter.reset();
+    filter.filterBlock(matExpected);
+    matExpected = matExpected.rowwise().reverse().eval();
+    filter.reset();
+    filter.filterBlock(matExpected);
+    matExpected = matExpected.rowwise().reverse().eval();
+
+    MatrixXd matFiltered = filter.applyZeroPhaseFilter(m_matNoise, 0, IirFilter::ReflectPadding);
+    QVERIFY((matFiltered - matExpected).cwiseAbs().maxCoeff() < epsilon);
+
+    //Zero padding of length zero starts both passes from rest
+    matFiltered = filter.applyZeroPhaseFilter(m_matNoise, 0, IirFilter::ZeroPadding);
+    QVERIFY((matFiltered - m_matNoise).cwiseAbs().maxCoeff() > 1.0);
+
+    //A single sample can't be reflected, the high pass still removes the constant
+    MatrixXd matSample = m_matNoise.col(0);
+    matFiltered = filter.applyZeroPhaseFilter(matSample, -1, IirFilter::ReflectPadding);
+    QCOMPARE(static_cast<int>(matFiltered.cols()), 1);
+    QVERIFY(matFiltered.cwiseAbs().maxCoeff() < epsilon);
+}
+
+
+//*************************************************************************************************************
+
+void TestIirFilter::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+
+double TestIirFilter::bilinearCenter(double dLow, double dHigh) const
+{
+    return m_dSFreq / M_PI * std::atan(std::sqrt(std::tan(M_PI * dLow / m_dSFreq) * std::tan(M_PI * dHigh / m_dSFreq)));
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestIirFilter)
+#include "test_iir_filter.moc"
@@ -81,6 +81,7 @@ private slots:
     void testDimensionsForInterpolation();
     void testSumOfRow();
     void testEmptyInputsForWeightMatrix();
+    void testBatchedInterpolation();
     void cleanupTestCase();
 
 private:
@@ -218,6 +219,31 @@ void TestInterpolation::testEmptyInputsForWeightMatrix() {
 
 //*************************************************************************************************************
 
+void TestInterpolation::testBatchedInterpolation() {
+    QSharedPointer<MatrixXd> distTable = GeometryInfo::scdc(smallSurface, smallSubset);
+    QSharedPointer<SparseMatrix<double>> testWeightMatrix = Interpolation::createInterpolationMat(smallSubset, distTable, Interpolation::linear);
+    SparseMatrix<float> testWeightMatrixFloat = testWeightMatrix->cast<float>();
+
+    // several time points at once
+    MatrixXd testSignals = MatrixXd::Random(smallSubset->size(), 8);
+    MatrixXf testInterpolatedSignals;
+
+    QVERIFY(Interpolation::interpolateSignals(testWeightMatrixFloat, testSignals.cast<float>(), testInterpolatedSignals));
+    QVERIFY(testInterpolatedSignals.rows() == smallSurface.rr.rows());
+    QVERIFY(testInterpolatedSignals.cols() == testSignals.cols());
+
+    // each column has to match the single sample interpolation
+    for(int i = 0; i < testSignals.cols(); ++i) {
+        QSharedPointer<VectorXf> testInterpolatedSignal = Interpolation::interpolateSignal(testWeightMatrix, testSignals.col(i));
+        QVERIFY((testInterpolatedSignals.col(i) - *testInterpolatedSignal).cwiseAbs().maxCoeff() < 1e-5f);
+    }
+
+    // dimension mismatch
+    QVERIFY(!Interpolation::interpolateSignals(testWeightMatrixFloat, MatrixXf::Random(smallSubset->size() + 1, 2), testInterpolatedSignals));
+}
+
+//*************************************************************************************************************
+
 void TestInterpolation::cleanupTestCase() {
 
 }
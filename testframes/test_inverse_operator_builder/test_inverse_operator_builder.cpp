@@ -0,0 +1,563 @@
+//=============================================================================================================
+/**
+* @file     test_inverse_operator_builder.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test of the cached inverse operator builder against the make and prepare algorithm
+*
+*/
+
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <mne/mne_inverse_operator.h>
+#include <mne/mne_inverse_operator_builder.h>
+#include <mne/mne_forwardsolution.h>
+#include <fiff/fiff_evoked.h>
+#include <fiff/fiff_cov.h>
+#include <fiff/fiff_proj.h>
+#include <utils/mnemath.h>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// EIGEN INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Dense>
+#include <Eigen/SVD>
+#include <Eigen/SparseCore>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace MNELIB;
+using namespace FIFFLIB;
+using namespace UTILSLIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestInverseOperatorBuilder
+*
+* @brief The TestInverseOperatorBuilder class compares the cached inverse operator builder with the make and prepare
+*        algorithm it replaced
+*
+*/
+class TestInverseOperatorBuilder: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestInverseOperatorBuilder();
+
+private slots:
+    void initTestCase();
+    void compareMake();
+    void compareDSPM();
+    void compareSLORETA();
+    void compareLambdaChange();
+    void compareNaveChange();
+    void cleanupTestCase();
+
+private:
+    //=========================================================================================================
+    /**
+    * The make_inverse_operator algorithm before the builder, JacobiSVD and the explicit trace of G*R*G^T included.
+    *
+    * @param[in] info           The measurement info.
+    * @param[in] forward        Forward operator.
+    * @param[in] p_noise_cov    The noise covariance matrix.
+    * @param[in] loose          Loose orientation weight.
+    * @param[in] depth          Depth weighting coefficient, has to be positive.
+    *
+    * @return the assembled inverse operator.
+    */
+    MNEInverseOperator makeBaseline(const FiffInfo &info, MNEForwardSolution forward, const FiffCov &p_noise_cov, float loose, float depth) const;
+
+    //=========================================================================================================
+    /**
+    * The prepare_inverse_operator algorithm before the builder, noise norms computed row by row.
+    *
+    * @param[in] p_inverseOperator  The inverse operator to prepare.
+    * @param[in] nave               Number of averages.
+    * @param[in] lambda2            The regularization factor.
+    * @param[in] dSPM               Compute the noise-normalization factors for dSPM?
+    * @param[in] sLORETA            Compute the noise-normalization factors for sLORETA?
+    *
+    * @return the prepared inverse operator.
+    */
+    MNEInverseOperator prepareBaseline(const MNEInverseOperator &p_inverseOperator, qint32 nave, float lambda2, bool dSPM, bool sLORETA) const;
+
+    //=========================================================================================================
+    /**
+    * Compares reginv, whitener, projector and noise normalization of two prepared inverse operators.
+    *
+    * @param[in] p_invBuilder   The operator prepared by the builder.
+    * @param[in] p_invBaseline  The operator prepared by the baseline algorithm.
+    *
+    * @return true if all of them agree within epsilon, relative to their norm.
+    */
+    bool isSamePrepared(const MNEInverseOperator &p_invBuilder, const MNEInverseOperator &p_invBaseline) const;
+
+    //=========================================================================================================
+    /**
+    * Returns whether two matrices agree within epsilon relative to the norm of the reference.
+    *
+    * @param[in] p_matA     The matrix to check.
+    * @param[in] p_matRef   The reference matrix.
+    *
+    * @return true if the relative difference is smaller than epsilon.
+    */
+    bool isClose(const MatrixXd &p_matA, const MatrixXd &p_matRef) const;
+
+    double epsilon;
+
+    float m_fLambda2;                       /**< Regularization of the first preparation, snr = 3. */
+    float m_fLambda2Changed;                /**< Regularization of the second preparation, snr = 1. */
+    qint32 m_iNave;                         /**< Number of averages of the sample evoked set. */
+
+    FiffInfo m_info;                        /**< Measurement info of the sample evoked set. */
+    MNEForwardSolution m_forward;           /**< MEG part of the sample forward solution. */
+    FiffCov m_noiseCov;                     /**< Regularized sample noise covariance. */
+
+    MNEInverseOperatorBuilder m_builder;    /**< Builder which is reused by all preparations. */
+    MNEInverseOperator m_invBuilder;        /**< Inverse operator made by the builder. */
+    MNEInverseOperator m_invBaseline;       /**< Inverse operator made by the baseline algorithm. */
+};
+
+
+//*************************************************************************************************************
+
+TestInverseOperatorBuilder::TestInverseOperatorBuilder()
+: epsilon(1e-6)
+, m_fLambda2(1.0f/9.0f)
+, m_fLambda2Changed(1.0f)
+, m_iNave(1)
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestInverseOperatorBuilder::initTestCase()
+{
+    qDebug() << "Epsilon" << epsilon;
+
+    QFile t_fileFwd(QDir::currentPath()+"/mne-cpp-test-data/MEG/sample/sample_audvis-meg-eeg-oct-6-fwd.fif");
+    QFile t_fileCov(QDir::currentPath()+"/mne-cpp-test-data/MEG/sample/sample_audvis-cov.fif");
+    QFile t_fileEvoked(QDir::currentPath()+"/mne-cpp-test-data/MEG/sample/sample_audvis-ave.fif");
+
+    fiff_int_t setno = 0;
+    QPair<QVariant, QVariant> baseline(QVariant(), 0);
+    FiffEvoked evoked(t_fileEvoked, setno, baseline);
+    QVERIFY(!evoked.isEmpty());
+
+    m_info = evoked.info;
+    m_iNave = evoked.nave;
+    QVERIFY(m_iNave > 1);
+
+    MNEForwardSolution t_forwardMeeg(t_fileFwd, false, true);
+    QVERIFY(!t_forwardMeeg.isEmpty());
+    m_forward = t_forwardMeeg.pick_types(true, false);
+
+    FiffCov t_noiseCov(t_fileCov);
+    m_noiseCov = t_noiseCov.regularize(m_info, 0.05, 0.05, 0.1, true);
+
+    m_builder.setForwardSolution(m_info, m_forward, 0.2f, 0.8f);
+    m_invBuilder = m_builder.makeInverseOperator(m_noiseCov);
+    m_invBaseline = makeBaseline(m_info, m_forward, m_noiseCov, 0.2f, 0.8f);
+
+    QVERIFY(m_invBuilder.sing.size() > 0);
+    QVERIFY(m_invBaseline.sing.size() > 0);
+}
+
+
+//*************************************************************************************************************
+
+void TestInverseOperatorBuilder::compareMake()
+{
+    QCOMPARE(m_invBuilder.sing.size(), m_invBaseline.sing.size());
+    QVERIFY(isClose(m_invBuilder.sing, m_invBaseline.sing));
+
+    QVERIFY(isClose(m_invBuilder.source_cov->data, m_invBaseline.source_cov->data));
+    QVERIFY(isClose(m_invBuilder.noise_cov->data, m_invBaseline.noise_cov->data));
+
+    QCOMPARE(m_invBuilder.eigen_leads->data.rows(), m_invBaseline.eigen_leads->data.rows());
+    QCOMPARE(m_invBuilder.eigen_fields->data.cols(), m_invBaseline.eigen_fields->data.cols());
+    QCOMPARE(m_invBuilder.methods, m_invBaseline.methods);
+    QCOMPARE(m_invBuilder.source_ori, m_invBaseline.source_ori);
+    QCOMPARE(m_invBuilder.nave, m_invBaseline.nave);
+
+    //Passing the same covariance again returns the cached operator
+    MNEInverseOperator t_invCached = m_builder.makeInverseOperator(m_noiseCov);
+    QVERIFY(t_invCached.sing == m_invBuilder.sing);
+}
+
+
+//*************************************************************************************************************
+
+void TestInverseOperatorBuilder::compareDSPM()
+{
+    MNEInverseOperator t_invBuilder = m_builder.prepareInverseOperator(1, m_fLambda2, true, false);
+    MNEInverseOperator t_invBaseline = prepareBaseline(m_invBaseline, 1, m_fLambda2, true, false);
+    QVERIFY(isSamePrepared(t_invBuilder, t_invBaseline));
+
+    t_invBuilder = m_builder.prepareInverseOperator(m_iNave, m_fLambda2, true, false);
+    t_invBaseline = prepareBaseline(m_invBaseline, m_iNave, m_fLambda2, true, false);
+    QVERIFY(isSamePrepared(t_invBuilder, t_invBaseline));
+}
+
+
+//*************************************************************************************************************
+
+void TestInverseOperatorBuilder::compareSLORETA()
+{
+    MNEInverseOperator t_invBuilder = m_builder.prepareInverseOperator(1, m_fLambda2, false, true);
+    MNEInverseOperator t_invBaseline = prepareBaseline(m_invBaseline, 1, m_fLambda2, false, true);
+    QVERIFY(isSamePrepared(t_invBuilder, t_invBaseline));
+
+    t_invBuilder = m_builder.prepareInverseOperator(m_iNave, m_fLambda2, false, true);
+    t_invBaseline = prepareBaseline(m_invBaseline, m_iNave, m_fLambda2, false, true);
+    QVERIFY(isSamePrepared(t_invBuilder, t_invBaseline));
+}
+
+
+//*************************************************************************************************************
+
+void TestInverseOperatorBuilder::compareLambdaChange()
+{
+    //The builder has cached the noise norms of the first lambda2, they have to be recomputed
+    MNEInverseOperator t_invBuilder = m_builder.prepareInverseOperator(m_iNave, m_fLambda2Changed, true, false);
+    MNEInverseOperator t_invBaseline = prepareBaseline(m_invBaseline, m_iNave, m_fLambda2Changed, true, false);
+    QVERIFY(isSamePrepared(t_invBuilder, t_invBaseline));
+
+    t_invBuilder = m_builder.prepareInverseOperator(m_iNave, m_fLambda2Changed, false, true);
+    t_invBaseline = prepareBaseline(m_invBaseline, m_iNave, m_fLambda2Changed, false, true);
+    QVERIFY(isSamePrepared(t_invBuilder, t_invBaseline));
+
+    //And back again
+    t_invBuilder = m_builder.prepareInverseOperator(1, m_fLambda2, true, false);
+    t_invBaseline = prepareBaseline(m_invBaseline, 1, m_fLambda2, true, false);
+    QVERIFY(isSamePrepared(t_invBuilder, t_invBaseline));
+}
+
+
+//*************************************************************************************************************
+
+void TestInverseOperatorBuilder::compareNaveChange()
+{
+    //A prepared operator with nave > 1 is prepared again, both ways have to rescale from its nave
+    MNEInverseOperator t_invPreparedBuilder = m_builder.prepareInverseOperator(m_iNave, m_fLambda2, false, false);
+    MNEInverseOperator t_invPreparedBaseline = prepareBaseline(m_invBaseline, m_iNave, m_fLambda2, false, false);
+    QCOMPARE(t_invPreparedBuilder.nave, m_iNave);
+    QVERIFY(t_invPreparedBuilder.noisenorm.nonZeros() == 0);
+
+    MNEInverseOperatorBuilder t_builder(t_invPreparedBuilder);
+    MNEInverseOperator t_invBuilder = t_builder.prepareInverseOperator(1, m_fLambda2Changed, true, false);
+    MNEInverseOperator t_invBaseline = prepareBaseline(t_invPreparedBaseline, 1, m_fLambda2Changed, true, false);
+    QVERIFY(isSamePrepared(t_invBuilder, t_invBaseline));
+
+    t_invBuilder = t_builder.prepareInverseOperator(2*m_iNave, m_fLambda2Changed, false, true);
+    t_invBaseline = prepareBaseline(t_invPreparedBaseline, 2*m_iNave, m_fLambda2Changed, false, true);
+    QVERIFY(isSamePrepared(t_invBuilder, t_invBaseline));
+}
+
+
+//*************************************************************************************************************
+
+void TestInverseOperatorBuilder::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+
+MNEInverseOperator TestInverseOperatorBuilder::makeBaseline(const FiffInfo &info, MNEForwardSolution forward, const FiffCov &p_noise_cov, float loose, float depth) const
+{
+    bool is_fixed_ori = forward.isFixedOrient();
+    MNEInverseOperator p_MNEInverseOperator;
+
+    FiffInfo gain_info;
+    MatrixXd gain;
+    MatrixXd whitener;
+    qint32 n_nzero;
+    FiffCov p_outNoiseCov;
+    forward.prepare_forward(info, p_noise_cov, false, gain_info, gain, p_outNoiseCov, whitener, n_nzero);
+
+    //Depth weight matrix
+    MatrixXd patch_areas;
+    FiffCov::SDPtr p_depth_prior = FiffCov::SDPtr(new FiffCov(MNEForwardSolution::compute_depth_prior(gain, gain_info, is_fixed_ori, depth, 10.0, patch_areas, true)));
+
+    //Source covariance matrix with loose orientations
+    FiffCov::SDPtr p_source_cov = p_depth_prior;
+
+    FiffCov::SDPtr p_orient_prior;
+    if(!is_fixed_ori)
+    {
+        p_orient_prior = FiffCov::SDPtr(new FiffCov(forward.compute_orient_prior(loose)));
+        p_source_cov->data.array() *= p_orient_prior->data.array();
+    }
+
+    //Whitening and source weighting
+    gain = whitener*gain;
+
+    RowVectorXd source_std = p_source_cov->data.array().sqrt().transpose();
+
+    for(qint32 i = 0; i < gain.rows(); ++i)
+        gain.row(i) = gain.row(i).array() * source_std.array();
+
+    double trace_GRGT = (gain * gain.transpose()).trace();
+    double scaling_source_cov = (double)n_nzero / trace_GRGT;
+
+    p_source_cov->data.array() *= scaling_source_cov;
+
+    gain.array() *= sqrt(scaling_source_cov);
+
+    //Decompose the combined matrix
+    JacobiSVD<MatrixXd> svd(gain, ComputeThinU | ComputeThinV);
+    VectorXd p_sing = svd.singularValues();
+    MatrixXd t_U = svd.matrixU();
+    MNEMath::sort<double>(p_sing, t_U);
+    FiffNamedMatrix::SDPtr p_eigen_fields = FiffNamedMatrix::SDPtr(new FiffNamedMatrix( svd.matrixU().cols(),
+                                                                                        svd.matrixU().rows(),
+                                                                                        defaultQStringList,
+                                                                                        gain_info.ch_names,
+                                                                                        t_U.transpose() ));
+
+    p_sing = svd.singularValues();
+    MatrixXd t_V = svd.matrixV();
+    MNEMath::sort<double>(p_sing, t_V);
+    FiffNamedMatrix::SDPtr p_eigen_leads = FiffNamedMatrix::SDPtr(new FiffNamedMatrix( svd.matrixV().rows(),
+                                                                                       svd.matrixV().cols(),
+                                                                                       defaultQStringList,
+                                                                                       defaultQStringList,
+                                                                                       t_V ));
+
+    //Methods
+    bool has_meg = false;
+    bool has_eeg = false;
+
+    for(qint32 i = 0; i < info.chs.size(); ++i)
+    {
+        if(!gain_info.ch_names.contains(info.chs[i].ch_name))
+            continue;
+
+        QString ch_type = info.channel_type(i);
+        if (ch_type == "eeg")
+            has_eeg = true;
+        if ((ch_type == "mag") || (ch_type == "grad"))
+            has_meg = true;
+    }
+
+    qint32 p_iMethods;
+    if(has_eeg && has_meg)
+        p_iMethods = FIFFV_MNE_MEG_EEG;
+    else if(has_meg)
+        p_iMethods = FIFFV_MNE_MEG;
+    else
+        p_iMethods = FIFFV_MNE_EEG;
+
+    p_MNEInverseOperator.eigen_fields = p_eigen_fields;
+    p_MNEInverseOperator.eigen_leads = p_eigen_leads;
+    p_MNEInverseOperator.sing = p_sing;
+    p_MNEInverseOperator.nave = 1;
+    p_MNEInverseOperator.depth_prior = p_depth_prior;
+    p_MNEInverseOperator.source_cov = p_source_cov;
+    p_MNEInverseOperator.noise_cov = FiffCov::SDPtr(new FiffCov(p_outNoiseCov));
+    p_MNEInverseOperator.orient_prior = p_orient_prior;
+    p_MNEInverseOperator.projs = info.projs;
+    p_MNEInverseOperator.eigen_leads_weighted = false;
+    p_MNEInverseOperator.source_ori = forward.source_ori;
+    p_MNEInverseOperator.mri_head_t = forward.mri_head_t;
+    p_MNEInverseOperator.methods = p_iMethods;
+    p_MNEInverseOperator.nsource = forward.nsource;
+    p_MNEInverseOperator.coord_frame = forward.coord_frame;
+    p_MNEInverseOperator.source_nn = forward.source_nn;
+    p_MNEInverseOperator.src = forward.src;
+    p_MNEInverseOperator.info = forward.info;
+    p_MNEInverseOperator.info.bads = info.bads;
+
+    return p_MNEInverseOperator;
+}
+
+
+//*************************************************************************************************************
+
+MNEInverseOperator TestInverseOperatorBuilder::prepareBaseline(const MNEInverseOperator &p_inverseOperator, qint32 nave, float lambda2, bool dSPM, bool sLORETA) const
+{
+    MNEInverseOperator inv(p_inverseOperator);
+
+    //Scale some of the stuff
+    float scale     = ((float)inv.nave)/((float)nave);
+    inv.noise_cov->data  *= scale;
+    inv.noise_cov->eig   *= scale;
+    inv.source_cov->data *= scale;
+
+    if (inv.eigen_leads_weighted)
+        inv.eigen_leads->data *= sqrt(scale);
+
+    inv.nave = nave;
+
+    //Regularized inverse
+    VectorXd tmp = inv.sing.cwiseProduct(inv.sing) + VectorXd::Constant(inv.sing.size(), lambda2);
+    inv.reginv = VectorXd(inv.sing.cwiseQuotient(tmp));
+
+    //Projection operator
+    qint32 ncomp = FiffProj::make_projector(inv.projs, inv.noise_cov->names, inv.proj);
+
+    //Whitener
+    inv.whitener = MatrixXd::Zero(inv.noise_cov->dim, inv.noise_cov->dim);
+
+    qint32 k;
+    if (inv.noise_cov->diag == 0)
+    {
+        for (k = ncomp; k < inv.noise_cov->dim; ++k)
+            if (inv.noise_cov->eig[k] > 0)
+                inv.whitener(k,k) = 1.0/sqrt(inv.noise_cov->eig[k]);
+
+        inv.whitener *= inv.noise_cov->eigvec;
+    }
+    else
+    {
+        for (k = 0; k < inv.noise_cov->dim; ++k)
+            inv.whitener(k,k) = 1.0/sqrt(inv.noise_cov->data(k,0));
+    }
+
+    //Noise-normalization factors
+    if (dSPM || sLORETA)
+    {
+        VectorXd noise_norm = VectorXd::Zero(inv.eigen_leads->nrow);
+        VectorXd noise_weight;
+        if (dSPM)
+        {
+           noise_weight = VectorXd(inv.reginv);
+        }
+        else
+        {
+           VectorXd tmp = (VectorXd::Constant(inv.sing.size(), 1) + inv.sing.cwiseProduct(inv.sing)/lambda2);
+           noise_weight = inv.reginv.cwiseProduct(tmp.cwiseSqrt());
+        }
+
+        VectorXd one;
+        for (k = 0; k < inv.eigen_leads->nrow; ++k)
+        {
+            double c = inv.eigen_leads_weighted ? 1.0 : sqrt(inv.source_cov->data(k,0));
+            one = c*(inv.eigen_leads->data.row(k).transpose()).cwiseProduct(noise_weight);
+            noise_norm[k] = sqrt(one.dot(one));
+        }
+
+        VectorXd noise_norm_new;
+        if (inv.source_ori == FIFFV_MNE_FREE_ORI)
+        {
+            VectorXd* t = MNEMath::combine_xyz(noise_norm.transpose());
+            noise_norm_new = t->cwiseSqrt();
+            delete t;
+        }
+        else
+        {
+            noise_norm_new = noise_norm;
+        }
+
+        typedef Eigen::Triplet<double> T;
+        std::vector<T> tripletList;
+        tripletList.reserve(noise_norm_new.size());
+        for(qint32 i = 0; i < noise_norm_new.size(); ++i)
+            tripletList.push_back(T(i, i, 1.0/std::abs(noise_norm_new[i])));
+
+        inv.noisenorm = SparseMatrix<double>(noise_norm_new.size(),noise_norm_new.size());
+        inv.noisenorm.setFromTriplets(tripletList.begin(), tripletList.end());
+    }
+    else
+    {
+        inv.noisenorm = SparseMatrix<double>();
+    }
+
+    return inv;
+}
+
+
+//*************************************************************************************************************
+
+bool TestInverseOperatorBuilder::isSamePrepared(const MNEInverseOperator &p_invBuilder, const MNEInverseOperator &p_invBaseline) const
+{
+    if(p_invBuilder.nave != p_invBaseline.nave)
+        return false;
+
+    if(!isClose(p_invBuilder.reginv, p_invBaseline.reginv)
+            || !isClose(p_invBuilder.whitener, p_invBaseline.whitener)
+            || !isClose(p_invBuilder.proj, p_invBaseline.proj))
+        return false;
+
+    if(p_invBuilder.noisenorm.rows() != p_invBaseline.noisenorm.rows())
+        return false;
+
+    if(p_invBaseline.noisenorm.rows() == 0)
+        return true;
+
+    VectorXd vecNoiseNormBuilder = p_invBuilder.noisenorm.diagonal();
+    VectorXd vecNoiseNormBaseline = p_invBaseline.noisenorm.diagonal();
+
+    return isClose(vecNoiseNormBuilder, vecNoiseNormBaseline);
+}
+
+
+//*************************************************************************************************************
+
+bool TestInverseOperatorBuilder::isClose(const MatrixXd &p_matA, const MatrixXd &p_matRef) const
+{
+    if(p_matA.rows() != p_matRef.rows() || p_matA.cols() != p_matRef.cols())
+        return false;
+
+    return (p_matA - p_matRef).norm() <= epsilon * p_matRef.norm();
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestInverseOperatorBuilder)
+#include "test_inverse_operator_builder.moc"
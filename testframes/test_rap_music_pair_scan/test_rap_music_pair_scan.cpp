@@ -0,0 +1,448 @@
+//=============================================================================================================
+/**
+* @file     test_rap_music_pair_scan.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test of the Gram matrix based RAP-MUSIC pair scan against the subcorr path
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <inverse/rapMusic/rapmusic.h>
+#include <inverse/rapMusic/rapmusicpairscan.h>
+#include <mne/mne_forwardsolution.h>
+
+#include <random>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// EIGEN INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Dense>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace INVERSELIB;
+using namespace MNELIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* Gives the test access to the per pair correlation of RapMusic.
+*/
+class RapMusicSubcorr : public RapMusic
+{
+public:
+    using RapMusic::subcorr;
+    using RapMusic::getGainMatrixPair;
+};
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestRapMusicPairScan
+*
+* @brief The TestRapMusicPairScan class compares the pair scan with the per pair subcorr of RapMusic
+*
+*/
+class TestRapMusicPairScan: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestRapMusicPairScan();
+
+private slots:
+    void initTestCase();
+    void compareCorrelations();
+    void compareRowCorrelations();
+    void compareScanExhaustive();
+    void compareScanPruned();
+    void compareScanProjected();
+    void compareRapMusic();
+    void cleanupTestCase();
+
+private:
+    //=========================================================================================================
+    /**
+    * Returns the orthonormal basis of the column space of a matrix with the rank cut of RapMusic.
+    *
+    * @param[in] matA   The matrix.
+    *
+    * @return the basis.
+    */
+    MatrixXd rangeBasis(const MatrixXd& matA) const;
+
+    //=========================================================================================================
+    /**
+    * Finds the best pair of the lead field by correlating every pair with subcorr.
+    *
+    * @param[in] matLeadField   The lead field.
+    * @param[in] matU_B         The signal subspace.
+    * @param[out] iIdx1         The first source of the best pair.
+    * @param[out] iIdx2         The second source of the best pair.
+    *
+    * @return the correlation of the best pair.
+    */
+    double scanSubcorr(const MatrixXd& matLeadField, const MatrixXd& matU_B, int& iIdx1, int& iIdx2) const;
+
+    double      epsilon;
+
+    int         m_iNumChannels;     /**< Number of channels. */
+    int         m_iNumSources;      /**< Number of sources. */
+    int         m_iSourceA;         /**< First source of the first correlated pair, its neighbour is nearly collinear. */
+    int         m_iSourceB;         /**< Second source of the first correlated pair. */
+    int         m_iSourceC;         /**< First source of the correlated triple, its gain has rank 2. */
+    int         m_iSourceD;         /**< Second source of the correlated triple. */
+    int         m_iSourceE;         /**< Third source of the correlated triple. */
+
+    Vector3d    m_vecOriA;          /**< Orientation of source A. */
+    Vector3d    m_vecOriB;          /**< Orientation of source B, scaled by its amplitude. */
+
+    MatrixXd    m_matLeadField;     /**< The lead field (channels x 3*sources). */
+    MatrixXd    m_matData;          /**< Noise free measurement of the correlated pair and the correlated triple. */
+    MatrixXd    m_matU_B;           /**< Signal subspace of the measurement. */
+};
+
+
+//*************************************************************************************************************
+
+TestRapMusicPairScan::TestRapMusicPairScan()
+: epsilon(1e-9)
+, m_iNumChannels(40)
+, m_iNumSources(60)
+, m_iSourceA(10)
+, m_iSourceB(37)
+, m_iSourceC(52)
+, m_iSourceD(21)
+, m_iSourceE(45)
+, m_vecOriA(0.3, -0.5, 0.81)
+, m_vecOriB(-0.56, 0.08, 0.56)
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestRapMusicPairScan::initTestCase()
+{
+    std::mt19937 generator(7);
+    std::normal_distribution<double> normal(0.0, 1.0);
+
+    m_matLeadField.resize(m_iNumChannels, 3*m_iNumSources);
+    for(int i = 0; i < m_matLeadField.rows(); ++i) {
+        for(int j = 0; j < m_matLeadField.cols(); ++j) {
+            m_matLeadField(i,j) = normal(generator);
+        }
+    }
+
+    //Near-collinear neighbour of source A
+    for(int i = 0; i < m_iNumChannels; ++i) {
+        for(int k = 0; k < 3; ++k) {
+            m_matLeadField(i, 3*(m_iSourceA+1) + k) = m_matLeadField(i, 3*m_iSourceA + k) + 1e-3 * normal(generator);
+        }
+    }
+
+    //Source C only spans two directions
+    m_matLeadField.col(3*m_iSourceC + 2) = 0.6 * m_matLeadField.col(3*m_iSourceC) - 0.8 * m_matLeadField.col(3*m_iSourceC + 1);
+
+    //A perfectly correlated pair, which is the only pair reaching a correlation of one, and a perfectly correlated
+    //triple, which no pair explains completely. This keeps the best pair unique in every iteration.
+    const int iNumSamples = 100;
+    MatrixXd matSignals(15, iNumSamples);
+
+    Vector3d vecOriC(0.5, 0.5, 0.0), vecOriD(0.0, 0.7, -0.2), vecOriE(-0.4, 0.0, 0.3);
+    for(int t = 0; t < iNumSamples; ++t) {
+        double dTime = t / 100.0;
+        matSignals.block(0, t, 3, 1) = m_vecOriA * std::sin(2*M_PI*5*dTime);
+        matSignals.block(3, t, 3, 1) = m_vecOriB * std::sin(2*M_PI*5*dTime);
+        matSignals.block(6, t, 3, 1) = vecOriC * std::cos(2*M_PI*11*dTime);
+        matSignals.block(9, t, 3, 1) = vecOriD * std::cos(2*M_PI*11*dTime);
+        matSignals.block(12, t, 3, 1) = vecOriE * std::cos(2*M_PI*11*dTime);
+    }
+
+    MatrixXd matGain(m_iNumChannels, 15);
+    matGain << m_matLeadField.middleCols(3*m_iSourceA, 3), m_matLeadField.middleCols(3*m_iSourceB, 3),
+               m_matLeadField.middleCols(3*m_iSourceC, 3), m_matLeadField.middleCols(3*m_iSourceD, 3),
+               m_matLeadField.middleCols(3*m_iSourceE, 3);
+
+    m_matData = matGain * matSignals;
+    m_matU_B = rangeBasis(m_matData);
+
+    QCOMPARE(static_cast<int>(m_matU_B.cols()), 2);
+}
+
+
+//*************************************************************************************************************
+
+void TestRapMusicPairScan::compareCorrelations()
+{
+    RapMusicPairScan pairScan;
+    pairScan.setSubspace(m_matLeadField, m_matU_B);
+
+    QCOMPARE(pairScan.getNumSources(), m_iNumSources);
+
+    RapMusic::MatrixX6T matPair(m_iNumChannels, 6);
+    double dMaxDiff = 0.0;
+
+    for(int i = 0; i < m_iNumSources; ++i) {
+        for(int j = i; j < m_iNumSources; ++j) {
+            RapMusicSubcorr::getGainMatrixPair(m_matLeadField, matPair, i, j);
+            dMaxDiff = std::max(dMaxDiff, std::abs(pairScan.correlation(i, j) - RapMusicSubcorr::subcorr(matPair, m_matU_B)));
+        }
+    }
+
+    QVERIFY(dMaxDiff < epsilon);
+}
+
+
+//*************************************************************************************************************
+
+void TestRapMusicPairScan::compareRowCorrelations()
+{
+    RapMusicPairScan pairScan;
+    pairScan.setSubspace(m_matLeadField, m_matU_B);
+
+    VectorXd vecCorr;
+    const int vecRows[] = {0, m_iSourceA, m_iSourceA + 1, m_iSourceC};
+
+    for(int r = 0; r < 4; ++r) {
+        pairScan.rowCorrelations(vecRows[r], vecCorr);
+        QCOMPARE(static_cast<int>(vecCorr.size()), m_iNumSources);
+
+        for(int j = 0; j < m_iNumSources; ++j) {
+            QVERIFY(std::abs(vecCorr(j) - pairScan.correlation(vecRows[r], j)) < epsilon);
+        }
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestRapMusicPairScan::compareScanExhaustive()
+{
+    //Without pruning: the best of all correlations equals the best subcorr pair
+    RapMusicPairScan pairScan;
+    pairScan.setSubspace(m_matLeadField, m_matU_B);
+
+    double dBest = -1.0;
+    int iBest1 = -1, iBest2 = -1;
+    for(int i = 0; i < m_iNumSources; ++i) {
+        for(int j = i; j < m_iNumSources; ++j) {
+            double dCorr = pairScan.correlation(i, j);
+            if(dCorr > dBest) {
+                dBest = dCorr;
+                iBest1 = i;
+                iBest2 = j;
+            }
+        }
+    }
+
+    int iIdx1, iIdx2;
+    double dSubcorr = scanSubcorr(m_matLeadField, m_matU_B, iIdx1, iIdx2);
+
+    QCOMPARE(iBest1, iIdx1);
+    QCOMPARE(iBest2, iIdx2);
+    QVERIFY(std::abs(dBest - dSubcorr) < epsilon);
+
+    QCOMPARE(iBest1, m_iSourceA);
+    QCOMPARE(iBest2, m_iSourceB);
+}
+
+
+//*************************************************************************************************************
+
+void TestRapMusicPairScan::compareScanPruned()
+{
+    //With pruning: the scan skips pairs but still finds the best subcorr pair
+    RapMusicPairScan pairScan;
+    pairScan.setSubspace(m_matLeadField, m_matU_B);
+
+    int iScan1, iScan2;
+    qint64 iNumEvaluated = 0;
+    double dScan = pairScan.scan(iScan1, iScan2, &iNumEvaluated);
+
+    int iIdx1, iIdx2;
+    double dSubcorr = scanSubcorr(m_matLeadField, m_matU_B, iIdx1, iIdx2);
+
+    QCOMPARE(iScan1, iIdx1);
+    QCOMPARE(iScan2, iIdx2);
+    QVERIFY(std::abs(dScan - dSubcorr) < epsilon);
+
+    //The correlated pair is found and not its nearly collinear neighbour, and the bound removed at least some pairs
+    QCOMPARE(iScan1, m_iSourceA);
+    QCOMPARE(iScan2, m_iSourceB);
+    QVERIFY(iNumEvaluated < static_cast<qint64>(m_iNumSources) * (m_iNumSources + 1) / 2);
+}
+
+
+//*************************************************************************************************************
+
+void TestRapMusicPairScan::compareScanProjected()
+{
+    //Project out the topography of the found pair like the second RAP-MUSIC iteration, the scan has to agree with
+    //subcorr on the projected gains, including the rank 2 gain of source C
+    VectorXd vecTopo = m_matLeadField.middleCols(3*m_iSourceA, 3) * m_vecOriA + m_matLeadField.middleCols(3*m_iSourceB, 3) * m_vecOriB;
+
+    MatrixXd matQ = vecTopo.normalized();
+    MatrixXd matProj = MatrixXd::Identity(m_iNumChannels, m_iNumChannels) - matQ * matQ.transpose();
+
+    MatrixXd matProjLeadField = matProj * m_matLeadField;
+    MatrixXd matProjU_B = rangeBasis(matProj * m_matU_B);
+
+    RapMusicPairScan pairScan;
+    pairScan.setSubspace(matProjLeadField, matProjU_B);
+
+    RapMusic::MatrixX6T matPair(m_iNumChannels, 6);
+    QCOMPARE(static_cast<int>(matProjU_B.cols()), 1);
+
+    const int vecSources[] = {m_iSourceA, m_iSourceA + 1, m_iSourceB, m_iSourceC, m_iSourceD};
+    for(int s = 0; s < 5; ++s) {
+        for(int j = 0; j < m_iNumSources; ++j) {
+            int i = std::min(vecSources[s], j);
+            int k = std::max(vecSources[s], j);
+            RapMusicSubcorr::getGainMatrixPair(matProjLeadField, matPair, i, k);
+            QVERIFY(std::abs(pairScan.correlation(i, k) - RapMusicSubcorr::subcorr(matPair, matProjU_B)) < epsilon);
+        }
+    }
+
+    int iScan1, iScan2;
+    double dScan = pairScan.scan(iScan1, iScan2);
+
+    int iIdx1, iIdx2;
+    double dSubcorr = scanSubcorr(matProjLeadField, matProjU_B, iIdx1, iIdx2);
+
+    QCOMPARE(iScan1, iIdx1);
+    QCOMPARE(iScan2, iIdx2);
+    QVERIFY(std::abs(dScan - dSubcorr) < epsilon);
+}
+
+
+//*************************************************************************************************************
+
+void TestRapMusicPairScan::compareRapMusic()
+{
+    MNEForwardSolution fwd;
+    fwd.sol->data = m_matLeadField;
+    fwd.sol->nrow = m_iNumChannels;
+    fwd.sol->ncol = 3*m_iNumSources;
+
+    RapMusic rapMusic;
+    QVERIFY(rapMusic.init(fwd, false, 2, 0.5));
+
+    QList< DipolePair<double> > lPairScan;
+    rapMusic.setUsePairScan(true);
+    rapMusic.calculateInverse(m_matData, lPairScan);
+
+    QList< DipolePair<double> > lSubcorr;
+    rapMusic.setUsePairScan(false);
+    rapMusic.calculateInverse(m_matData, lSubcorr);
+
+    QVERIFY(!lPairScan.isEmpty());
+    QCOMPARE(lPairScan.size(), lSubcorr.size());
+
+    for(int i = 0; i < lPairScan.size(); ++i) {
+        QCOMPARE(lPairScan.at(i).m_iIdx1, lSubcorr.at(i).m_iIdx1);
+        QCOMPARE(lPairScan.at(i).m_iIdx2, lSubcorr.at(i).m_iIdx2);
+        QVERIFY(std::abs(lPairScan.at(i).m_vCorrelation - lSubcorr.at(i).m_vCorrelation) < epsilon);
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestRapMusicPairScan::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+
+MatrixXd TestRapMusicPairScan::rangeBasis(const MatrixXd& matA) const
+{
+    JacobiSVD<MatrixXd> svd(matA, ComputeThinU);
+
+    int iRank = 0;
+    while(iRank < svd.singularValues().size() && svd.singularValues()(iRank) > 1e-5 * svd.singularValues()(0)) {
+        ++iRank;
+    }
+
+    return svd.matrixU().leftCols(iRank);
+}
+
+
+//*************************************************************************************************************
+
+double TestRapMusicPairScan::scanSubcorr(const MatrixXd& matLeadField, const MatrixXd& matU_B, int& iIdx1, int& iIdx2) const
+{
+    RapMusic::MatrixX6T matPair(matLeadField.rows(), 6);
+    double dBest = -1.0;
+
+    for(int i = 0; i < matLeadField.cols()/3; ++i) {
+        for(int j = i; j < matLeadField.cols()/3; ++j) {
+            RapMusicSubcorr::getGainMatrixPair(matLeadField, matPair, i, j);
+            double dCorr = RapMusicSubcorr::subcorr(matPair, matU_B);
+            if(dCorr > dBest) {
+                dBest = dCorr;
+                iIdx1 = i;
+                iIdx2 = j;
+            }
+        }
+    }
+
+    return dBest;
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestRapMusicPairScan)
+#include "test_rap_music_pair_scan.moc"
@@ -0,0 +1,331 @@
+//=============================================================================================================
+/**
+* @file     test_rtpsd.cpp
+* @author   Lorenz Esch <Lorenz.Esch@tu-ilmenau.de>;
+* @version  1.0
+* @date     November, 2017
+*
+* @section  LICENSE
+*
+* Copyright (C) 2017, Lorenz Esch. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+* the following conditions are met:
+*     * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+*       following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+*       the following disclaimer in the documentation and/or other materials provided with the distribution.
+*     * Neither the name of MNE-CPP authors nor the names of its contributors may be used
+*       to endorse or promote products derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+* PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+* INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*
+*
+* @brief    Test for the streaming Welch estimator RtPsd
+*
+*/
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// INCLUDES
+//=============================================================================================================
+
+#include <realtime/rtProcessing/rtpsd.h>
+
+#include <random>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// QT INCLUDES
+//=============================================================================================================
+
+#include <QtTest>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// EIGEN INCLUDES
+//=============================================================================================================
+
+#include <Eigen/Core>
+#include <unsupported/Eigen/FFT>
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// USED NAMESPACES
+//=============================================================================================================
+
+using namespace REALTIMELIB;
+using namespace Eigen;
+
+
+//=============================================================================================================
+/**
+* DECLARE CLASS TestRtPsd
+*
+* @brief The TestRtPsd class feeds a sine in white noise block by block and compares RtPsd with a direct Welch estimate
+*
+*/
+class TestRtPsd: public QObject
+{
+    Q_OBJECT
+
+public:
+    TestRtPsd();
+
+private slots:
+    void initTestCase();
+    void comparePeakBin();
+    void compareParseval();
+    void compareNoiseDensity();
+    void compareSlidingToWelch();
+    void compareExponentialToWelch();
+    void compareExponentialConvergence();
+    void cleanupTestCase();
+
+private:
+    //=========================================================================================================
+    /**
+    * Appends the data to the estimator in blocks of varying size, so segments start inside and across blocks.
+    *
+    * @param[in] psd        The estimator.
+    * @param[in] matData    The data to append.
+    */
+    void appendInBlocks(RtPsd& psd, const MatrixXd& matData);
+
+    //=========================================================================================================
+    /**
+    * Computes the one-sided Welch density of a single channel from scratch.
+    *
+    * @param[in] vecData        The data.
+    * @param[in] iFirstSegment  The index of the first segment to average.
+    * @param[in] iNumSegments   The number of segments to average.
+    *
+    * @return the one-sided density.
+    */
+    RowVectorXd welch(const RowVectorXd& vecData, int iFirstSegment, int iNumSegments) const;
+
+    double      epsilon;
+
+    int         m_iSegmentLength;   /**< The segment length. */
+    int         m_iHop;             /**< The hop size, half a segment. */
+    int         m_iPeakBin;         /**< The bin the sine is centered on. */
+    double      m_dSFreq;           /**< The sampling frequency. */
+    double      m_dAmplitude;       /**< The sine amplitude. */
+    double      m_dNoiseStd;        /**< The standard deviation of the white noise. */
+
+    MatrixXd    m_matSignal;        /**< Sine plus white noise, one channel. */
+    MatrixXd    m_matNoise;         /**< White noise only, one channel. */
+};
+
+
+//*************************************************************************************************************
+
+TestRtPsd::TestRtPsd()
+: epsilon(1e-10)
+, m_iSegmentLength(256)
+, m_iHop(128)
+, m_iPeakBin(32)
+, m_dSFreq(1000.0)
+, m_dAmplitude(2.0)
+, m_dNoiseStd(0.5)
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestRtPsd::initTestCase()
+{
+    std::mt19937 generator(42);
+    std::normal_distribution<double> normal(0.0, 1.0);
+
+    const int iNumSamples = 64 * m_iSegmentLength;
+    const double dFreq = m_iPeakBin * m_dSFreq / m_iSegmentLength;
+
+    m_matSignal.resize(1, iNumSamples);
+    m_matNoise.resize(1, iNumSamples);
+
+    for(int i = 0; i < iNumSamples; ++i) {
+        m_matNoise(0, i) = m_dNoiseStd * normal(generator);
+        m_matSignal(0, i) = m_dAmplitude * std::sin(2.0 * M_PI * dFreq * i / m_dSFreq) + m_matNoise(0, i);
+    }
+}
+
+
+//*************************************************************************************************************
+
+void TestRtPsd::comparePeakBin()
+{
+    RtPsd psd(1, m_iSegmentLength, m_dSFreq, -1, RtPsd::SlidingWindowAveraging, 8);
+    appendInBlocks(psd, m_matSignal);
+
+    QVERIFY(psd.getNumAveraged() > 0);
+
+    RowVectorXd vecPsd = psd.getPsd().row(0);
+    RowVectorXd::Index iMax;
+    vecPsd.maxCoeff(&iMax);
+
+    QCOMPARE(static_cast<int>(iMax), m_iPeakBin);
+    QVERIFY(std::abs(psd.getFrequencies()(iMax) - m_iPeakBin * m_dSFreq / m_iSegmentLength) < epsilon);
+}
+
+
+//*************************************************************************************************************
+
+void TestRtPsd::compareParseval()
+{
+    //A single segment: the integrated one-sided density equals the mean power of the windowed segment
+    RtPsd psd(1, m_iSegmentLength, m_dSFreq, -1, RtPsd::SlidingWindowAveraging, 1);
+    QCOMPARE(psd.append(m_matSignal.leftCols(m_iSegmentLength)), 1);
+
+    RowVectorXd vecWindow = RtPsd::hanningWindow(m_iSegmentLength);
+    RowVectorXd vecWindowed = m_matSignal.row(0).head(m_iSegmentLength).cwiseProduct(vecWindow);
+
+    double dPower = vecWindowed.squaredNorm() / vecWindow.squaredNorm();
+    double dIntegral = psd.getPsd().sum() * m_dSFreq / m_iSegmentLength;
+
+    QVERIFY(std::abs(dIntegral - dPower) < epsilon * dPower);
+}
+
+
+//*************************************************************************************************************
+
+void TestRtPsd::compareNoiseDensity()
+{
+    //The density of white noise is 2*sigma^2/fs on all bins but DC and Nyquist
+    RtPsd psd(1, m_iSegmentLength, m_dSFreq, -1, RtPsd::SlidingWindowAveraging, 64);
+    appendInBlocks(psd, m_matNoise);
+
+    RowVectorXd vecPsd = psd.getPsd().row(0);
+    double dMean = vecPsd.segment(1, vecPsd.size() - 2).mean();
+    double dExpected = 2.0 * m_dNoiseStd * m_dNoiseStd / m_dSFreq;
+
+    QVERIFY(std::abs(dMean - dExpected) < 0.05 * dExpected);
+}
+
+
+//*************************************************************************************************************
+
+void TestRtPsd::compareSlidingToWelch()
+{
+    //After the history is full the sliding average is the Welch estimate of the last segments
+    const int iNumAverages = 8;
+    RtPsd psd(1, m_iSegmentLength, m_dSFreq, -1, RtPsd::SlidingWindowAveraging, iNumAverages);
+    appendInBlocks(psd, m_matSignal);
+
+    int iNumSegments = static_cast<int>(m_matSignal.cols() - m_iSegmentLength) / m_iHop + 1;
+    QCOMPARE(psd.getNumAveraged(), iNumSegments);
+
+    RowVectorXd vecWelch = welch(m_matSignal.row(0), iNumSegments - iNumAverages, iNumAverages);
+    RowVectorXd vecPsd = psd.getPsd().row(0);
+
+    QVERIFY((vecPsd - vecWelch).cwiseAbs().maxCoeff() < epsilon * vecWelch.maxCoeff());
+}
+
+
+//*************************************************************************************************************
+
+void TestRtPsd::compareExponentialToWelch()
+{
+    //As long as 1/n exceeds 2/(N+1) the exponential average is the arithmetic mean, i.e., the Welch estimate
+    const int iNumSegments = 10;
+    RtPsd psd(1, m_iSegmentLength, m_dSFreq, -1, RtPsd::ExponentialAveraging, 2 * iNumSegments);
+    appendInBlocks(psd, m_matSignal.leftCols(m_iSegmentLength + (iNumSegments - 1) * m_iHop));
+
+    QCOMPARE(psd.getNumAveraged(), iNumSegments);
+
+    RowVectorXd vecWelch = welch(m_matSignal.row(0), 0, iNumSegments);
+    RowVectorXd vecPsd = psd.getPsd().row(0);
+
+    QVERIFY((vecPsd - vecWelch).cwiseAbs().maxCoeff() < epsilon * vecWelch.maxCoeff());
+}
+
+
+//*************************************************************************************************************
+
+void TestRtPsd::compareExponentialConvergence()
+{
+    //On stationary data the exponential average settles on the Welch estimate of the whole signal
+    RtPsd psd(1, m_iSegmentLength, m_dSFreq, -1, RtPsd::ExponentialAveraging, 32);
+    appendInBlocks(psd, m_matSignal);
+
+    int iNumSegments = static_cast<int>(m_matSignal.cols() - m_iSegmentLength) / m_iHop + 1;
+    RowVectorXd vecWelch = welch(m_matSignal.row(0), 0, iNumSegments);
+    RowVectorXd vecPsd = psd.getPsd().row(0);
+
+    //The sine dominates its bin, the noise floor is compared on average
+    QVERIFY(std::abs(vecPsd(m_iPeakBin) - vecWelch(m_iPeakBin)) < 0.1 * vecWelch(m_iPeakBin));
+
+    double dFloor = vecWelch.segment(m_iPeakBin + 4, 64).mean();
+    QVERIFY(std::abs(vecPsd.segment(m_iPeakBin + 4, 64).mean() - dFloor) < 0.2 * dFloor);
+}
+
+
+//*************************************************************************************************************
+
+void TestRtPsd::cleanupTestCase()
+{
+}
+
+
+//*************************************************************************************************************
+
+void TestRtPsd::appendInBlocks(RtPsd& psd, const MatrixXd& matData)
+{
+    const int vecBlockSizes[] = {1, 17, 100, 255, 256, 257, 3, 64, 511};
+    const int iNumBlockSizes = sizeof(vecBlockSizes) / sizeof(vecBlockSizes[0]);
+
+    int iPos = 0;
+    int iBlock = 0;
+
+    while(iPos < matData.cols()) {
+        int iSize = std::min(vecBlockSizes[iBlock++ % iNumBlockSizes], static_cast<int>(matData.cols()) - iPos);
+        psd.append(matData.middleCols(iPos, iSize));
+        iPos += iSize;
+    }
+}
+
+
+//*************************************************************************************************************
+
+RowVectorXd TestRtPsd::welch(const RowVectorXd& vecData, int iFirstSegment, int iNumSegments) const
+{
+    RowVectorXd vecWindow = RtPsd::hanningWindow(m_iSegmentLength);
+    const int iNumBins = m_iSegmentLength / 2 + 1;
+    const double dScale = 1.0 / (m_dSFreq * vecWindow.squaredNorm());
+
+    Eigen::FFT<double> fft;
+    RowVectorXd vecPsd = RowVectorXd::Zero(iNumBins);
+
+    for(int s = iFirstSegment; s < iFirstSegment + iNumSegments; ++s) {
+        RowVectorXd vecSegment = vecData.segment(s * m_iHop, m_iSegmentLength).cwiseProduct(vecWindow);
+        RowVectorXcd vecSpectrum;
+        fft.fwd(vecSpectrum, vecSegment);
+
+        RowVectorXd vecPeriodogram = vecSpectrum.head(iNumBins).cwiseAbs2() * dScale;
+        vecPeriodogram.segment(1, iNumBins - 2) *= 2.0;
+        vecPsd += vecPeriodogram;
+    }
+
+    return vecPsd / iNumSegments;
+}
+
+
+//*************************************************************************************************************
+//=============================================================================================================
+// MAIN
+//=============================================================================================================
+
+QTEST_APPLESS_MAIN(TestRtPsd)
+#include "test_rtpsd.moc"
@@ -46,11 +46,19 @@ SUBDIRS += \
     test_fiff_cov \
     test_fiff_digitizer \
     test_mne_msh_display_surface_set \
+    test_rtpsd \
+    test_rap_music_pair_scan \
+    test_inverse_operator_builder \
+    test_iir_filter \
+    test_fiff_raw_recorder \
+    test_event_detector \
+    test_fft_service \
 
 !contains(MNECPP_CONFIG, minimalVersion) {
     qtHaveModule(charts) {
         SUBDIRS += \
             test_interpolation \
             test_geometryinfo \
+            test_new_3d \
     }
 }
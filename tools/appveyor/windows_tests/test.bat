@@ -2,7 +2,7 @@
 cd bin
 
 :: Array of tests to run
-set tests=test_fiff_rwr test_dipole_fit test_fiff_mne_types_io test_fiff_cov test_fiff_digitizer test_mne_msh_display_surface_set test_geometryinfo  test_interpolation
+set tests=test_fiff_rwr test_dipole_fit test_fiff_mne_types_io test_fiff_cov test_fiff_digitizer test_mne_msh_display_surface_set test_rtpsd test_rap_music_pair_scan test_inverse_operator_builder test_iir_filter test_fiff_raw_recorder test_event_detector test_fft_service test_geometryinfo  test_interpolation
 
 :: Run tests
 (for %%t in (%tests%) do ( 